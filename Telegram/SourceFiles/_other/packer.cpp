@@ -156,6 +156,8 @@ int main(int argc, char *argv[])
 	QString remove;
 	int version = 0;
 	bool target32 = false;
+	QString deltaPath;
+	int deltaVersion = 0;
 	QFileInfoList files;
 	for (int i = 0; i < argc; ++i) {
 		if (string("-path") == argv[i] && i + 1 < argc) {
@@ -167,6 +169,10 @@ int main(int argc, char *argv[])
 			target32 = (string("mac32") == argv[i + 1]);
 		} else if (string("-version") == argv[i] && i + 1 < argc) {
 			version = QString(argv[i + 1]).toInt();
+		} else if (string("-delta") == argv[i] && i + 2 < argc) {
+			// -delta {previous release dir} {previous release version}
+			deltaPath = QDir(workDir + QString(argv[i + 1])).canonicalPath() + "/";
+			deltaVersion = QString(argv[i + 2]).toInt();
 		} else if (string("-beta") == argv[i]) {
 			BetaChannel = true;
 		} else if (string("-alpha") == argv[i] && i + 1 < argc) {
@@ -194,6 +200,10 @@ int main(int argc, char *argv[])
 #endif
 		return -1;
 	}
+	if (!deltaPath.isEmpty() && (AlphaVersion || deltaVersion <= 1016 || deltaVersion >= version)) {
+		cout << "Bad -delta params, the previous version should be a stable one less than " << version << "\n";
+		return -1;
+	}
 
 	bool hasDirs = true;
 	while (hasDirs) {
@@ -241,6 +251,11 @@ int main(int argc, char *argv[])
 			stream << quint32(version);
 		}
 
+		if (!deltaPath.isEmpty()) {
+			// Delta package: files that didn't change since the previous
+			// version are replaced by a hash of their contents.
+			stream << quint32(0x7FFFFFFE) << quint64(deltaVersion);
+		}
 		stream << quint32(files.size());
 		cout << "Found " << files.size() << " file" << (files.size() == 1 ? "" : "s") << "..\n";
 		for (QFileInfoList::iterator i = files.begin(); i != files.end(); ++i) {
@@ -255,7 +270,15 @@ int main(int argc, char *argv[])
 				return -1;
 			}
 			QByteArray inner = f.readAll();
-			stream << name << quint32(inner.size()) << inner;
+			QFile previous(deltaPath + name);
+			if (!deltaPath.isEmpty() && previous.open(QIODevice::ReadOnly) && previous.readAll() == inner) {
+				QByteArray hash(20, Qt::Uninitialized);
+				hashSha1(inner.constData(), inner.size(), hash.data());
+				stream << name << quint32(0xFFFFFFFF) << hash;
+				cout << "unchanged: " << name.toUtf8().constData() << "\n";
+			} else {
+				stream << name << quint32(inner.size()) << inner;
+			}
 #if defined Q_OS_MAC || defined Q_OS_LINUX
 			stream << (QFileInfo(fullName).isExecutable() ? true : false);
 #endif
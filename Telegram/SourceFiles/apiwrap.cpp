@@ -84,9 +84,13 @@ constexpr auto kSharedMediaLimit = 100;
 constexpr auto kFeedMessagesLimit = 50;
 constexpr auto kReadFeaturedSetsTimeout = crl::time(1000);
 constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
+constexpr auto kFileLoaderMaxThreads = 4;
 constexpr auto kFeedReadTimeout = crl::time(1000);
 constexpr auto kStickersByEmojiInvalidateTimeout = crl::time(60 * 60 * 1000);
 constexpr auto kNotifySettingSaveTimeout = crl::time(1000);
+constexpr auto kFileReferenceMessagesPerRequest = 100;
+constexpr auto kHistoryPreloadLimit = 30;
+constexpr auto kHistoryPreloadRequestsLimit = 3;
 
 using SimpleFileLocationId = Data::SimpleFileLocationId;
 using DocumentFileLocationId = Data::DocumentFileLocationId;
@@ -186,13 +190,19 @@ MTPInputPrivacyKey ApiWrap::Privacy::Input(Key key) {
 ApiWrap::ApiWrap(not_null<AuthSession*> session)
 : _session(session)
 , _messageDataResolveDelayed([=] { resolveMessageDatas(); })
+, _peersResolveDelayed([=] { resolvePeers(); })
 , _webPagesTimer([=] { resolveWebPages(); })
 , _draftsSaveTimer([=] { saveDraftsToCloud(); })
 , _featuredSetsReadTimer([=] { readFeaturedSets(); })
-, _fileLoader(std::make_unique<TaskQueue>(kFileLoaderQueueStopTimeout))
+, _fileLoader(std::make_unique<TaskQueue>(
+	kFileLoaderQueueStopTimeout,
+	std::min(QThread::idealThreadCount(), kFileLoaderMaxThreads)))
 , _feedReadTimer([=] { readFeeds(); })
 , _proxyPromotionTimer([=] { refreshProxyPromotion(); })
-, _updateNotifySettingsTimer([=] { sendNotifySettingsUpdates(); }) {
+, _updateNotifySettingsTimer([=] { sendNotifySettingsUpdates(); })
+, _messageFileReferencesResolveDelayed([=] {
+	resolveMessageFileReferences();
+}) {
 	crl::on_main([=] {
 		_session->uploader().photoReady(
 		) | rpl::start_with_next([=](const Storage::UploadedPhoto &data) {
@@ -869,6 +879,77 @@ void ApiWrap::requestFakeChatListMessage(
 	}).send();
 }
 
+void ApiWrap::preloadHistory(not_null<History*> history) {
+	// Unread chats are opened around the first unread message and
+	// migrated groups need both histories, leave them to HistoryWidget.
+	const auto peer = history->peer;
+	if (!history->isEmpty()
+		|| history->loadedAtBottom()
+		|| history->unreadCount() > 0
+		|| peer->migrateFrom()
+		|| _historyPreloadRequests.contains(history)
+		|| _historyPreloadRequests.size() >= kHistoryPreloadRequestsLimit) {
+		return;
+	}
+
+	_historyPreloadRequests.emplace(history);
+	request(MTPmessages_GetHistory(
+		peer->input,
+		MTP_int(0), // offset_id
+		MTP_int(0), // offset_date
+		MTP_int(0), // add_offset
+		MTP_int(kHistoryPreloadLimit),
+		MTP_int(0), // max_id
+		MTP_int(0), // min_id
+		MTP_int(0) // hash
+	)).done([=](const MTPmessages_Messages &result) {
+		_historyPreloadRequests.erase(history);
+
+		const auto list = [&]() -> const QVector<MTPMessage>* {
+			const auto handleMessages = [&](auto &messages) {
+				_session->data().processUsers(messages.vusers);
+				_session->data().processChats(messages.vchats);
+				return &messages.vmessages.v;
+			};
+			switch (result.type()) {
+			case mtpc_messages_messages:
+				return handleMessages(result.c_messages_messages());
+			case mtpc_messages_messagesSlice:
+				return handleMessages(result.c_messages_messagesSlice());
+			case mtpc_messages_channelMessages: {
+				const auto &messages = result.c_messages_channelMessages();
+				if (const auto channel = peer->asChannel()) {
+					channel->ptsReceived(messages.vpts.v);
+				}
+				return handleMessages(messages);
+			} break;
+			case mtpc_messages_messagesNotModified: {
+				LOG(("API Error: received messages.messagesNotModified! "
+					"(ApiWrap::preloadHistory)"));
+			} break;
+			}
+			return nullptr;
+		}();
+
+		// The history could be opened or get new messages meanwhile,
+		// add the slice only if it still ends with the last message.
+		const auto last = history->lastMessage();
+		if (!list
+			|| list->isEmpty()
+			|| !history->isEmpty()
+			|| history->loadedAtBottom()
+			|| !history->lastMessageKnown()
+			|| !last
+			|| IdFromMessage(list->front()) != last->id) {
+			return;
+		}
+		history->getReadyFor(ShowAtTheEndMsgId);
+		history->addOlderSlice(*list);
+	}).fail([=](const RPCError &error) {
+		_historyPreloadRequests.erase(history);
+	}).send();
+}
+
 void ApiWrap::requestWallPaper(
 		const QString &slug,
 		Fn<void(const Data::WallPaper &)> done,
@@ -1141,38 +1222,86 @@ void ApiWrap::requestPeer(not_null<PeerData*> peer) {
 	if (_fullPeerRequests.contains(peer) || _peerRequests.contains(peer)) {
 		return;
 	}
+	_peerRequests.insert(peer, 0);
+	_peersResolveDelayed.call();
+}
 
-	const auto requestId = [&] {
-		const auto failHandler = [=](const RPCError &error) {
-			_peerRequests.remove(peer);
-		};
-		const auto chatHandler = [=](const MTPmessages_Chats &result) {
-			_peerRequests.remove(peer);
-			const auto &chats = result.match([](const auto &data) {
-				return data.vchats;
-			});
-			_session->data().applyMaximumChatVersions(chats);
-			_session->data().processChats(chats);
-		};
+void ApiWrap::resolvePeers() {
+	QVector<MTPint> chats;
+	QVector<MTPInputChannel> channels;
+	QVector<MTPInputUser> users;
+	for (auto i = _peerRequests.cbegin(); i != _peerRequests.cend(); ++i) {
+		if (i.value() > 0) {
+			continue;
+		}
+		const auto peer = i.key();
 		if (const auto user = peer->asUser()) {
-			return request(MTPusers_GetUsers(
-				MTP_vector<MTPInputUser>(1, user->inputUser)
-			)).done([=](const MTPVector<MTPUser> &result) {
-				_peerRequests.remove(user);
-				_session->data().processUsers(result);
-			}).fail(failHandler).send();
+			users.push_back(user->inputUser);
 		} else if (const auto chat = peer->asChat()) {
-			return request(MTPmessages_GetChats(
-				MTP_vector<MTPint>(1, chat->inputChat)
-			)).done(chatHandler).fail(failHandler).send();
+			chats.push_back(chat->inputChat);
 		} else if (const auto channel = peer->asChannel()) {
-			return request(MTPchannels_GetChannels(
-				MTP_vector<MTPInputChannel>(1, channel->inputChannel)
-			)).done(chatHandler).fail(failHandler).send();
+			channels.push_back(channel->inputChannel);
 		}
-		Unexpected("Peer type in requestPeer.");
-	}();
-	_peerRequests.insert(peer, requestId);
+	}
+	const auto failHandler = [=](
+			const RPCError &error,
+			mtpRequestId requestId) {
+		finalizePeerRequest(requestId);
+	};
+	const auto chatHandler = [=](
+			const MTPmessages_Chats &result,
+			mtpRequestId requestId) {
+		finalizePeerRequest(requestId);
+		const auto &chats = result.match([](const auto &data) {
+			return data.vchats;
+		});
+		_session->data().applyMaximumChatVersions(chats);
+		_session->data().processChats(chats);
+	};
+	// Each request takes the waiting peers of its own type.
+	const auto assign = [&](mtpRequestId requestId, auto check) {
+		for (auto i = _peerRequests.begin(); i != _peerRequests.end(); ++i) {
+			if (!i.value() && check(i.key())) {
+				i.value() = requestId;
+			}
+		}
+	};
+	if (!users.isEmpty()) {
+		assign(request(MTPusers_GetUsers(
+			MTP_vector<MTPInputUser>(users)
+		)).done([=](
+				const MTPVector<MTPUser> &result,
+				mtpRequestId requestId) {
+			finalizePeerRequest(requestId);
+			_session->data().processUsers(result);
+		}).fail(failHandler).send(), [](PeerData *peer) {
+			return peer->isUser();
+		});
+	}
+	if (!chats.isEmpty()) {
+		assign(request(MTPmessages_GetChats(
+			MTP_vector<MTPint>(chats)
+		)).done(chatHandler).fail(failHandler).send(), [](PeerData *peer) {
+			return peer->isChat();
+		});
+	}
+	if (!channels.isEmpty()) {
+		assign(request(MTPchannels_GetChannels(
+			MTP_vector<MTPInputChannel>(channels)
+		)).done(chatHandler).fail(failHandler).send(), [](PeerData *peer) {
+			return peer->isChannel();
+		});
+	}
+}
+
+void ApiWrap::finalizePeerRequest(mtpRequestId requestId) {
+	for (auto i = _peerRequests.begin(); i != _peerRequests.end();) {
+		if (i.value() == requestId) {
+			i = _peerRequests.erase(i);
+		} else {
+			++i;
+		}
+	}
 }
 
 void ApiWrap::migrateChat(
@@ -1325,48 +1454,11 @@ void ApiWrap::markMediaRead(not_null<HistoryItem*> item) {
 }
 
 void ApiWrap::requestPeers(const QList<PeerData*> &peers) {
-	QVector<MTPint> chats;
-	QVector<MTPInputChannel> channels;
-	QVector<MTPInputUser> users;
-	chats.reserve(peers.size());
-	channels.reserve(peers.size());
-	users.reserve(peers.size());
 	for (const auto peer : peers) {
-		if (!peer
-			|| _fullPeerRequests.contains(peer)
-			|| _peerRequests.contains(peer)) {
-			continue;
-		}
-		if (const auto user = peer->asUser()) {
-			users.push_back(user->inputUser);
-		} else if (const auto chat = peer->asChat()) {
-			chats.push_back(chat->inputChat);
-		} else if (const auto channel = peer->asChannel()) {
-			channels.push_back(channel->inputChannel);
+		if (peer) {
+			requestPeer(peer);
 		}
 	}
-	const auto handleChats = [=](const MTPmessages_Chats &result) {
-		_session->data().processChats(result.match([](const auto &data) {
-			return data.vchats;
-		}));
-	};
-	if (!chats.isEmpty()) {
-		request(MTPmessages_GetChats(
-			MTP_vector<MTPint>(chats)
-		)).done(handleChats).send();
-	}
-	if (!channels.isEmpty()) {
-		request(MTPchannels_GetChannels(
-			MTP_vector<MTPInputChannel>(channels)
-		)).done(handleChats).send();
-	}
-	if (!users.isEmpty()) {
-		request(MTPusers_GetUsers(
-			MTP_vector<MTPInputUser>(users)
-		)).done([=](const MTPVector<MTPUser> &result) {
-			_session->data().processUsers(result);
-		}).send();
-	}
 }
 
 void ApiWrap::requestLastParticipants(not_null<ChannelData*> channel) {
@@ -2409,7 +2501,10 @@ void ApiWrap::deleteHistory(not_null<PeerData*> peer, bool justClear, bool revok
 		const auto offset = applyAffectedHistory(peer, result);
 		if (offset > 0) {
 			deleteHistory(peer, justClear, revoke);
-		} else if (!justClear && cReportSpamStatuses().contains(peer->id)) {
+			return;
+		}
+		Local::readReportSpamStatuses();
+		if (!justClear && cReportSpamStatuses().contains(peer->id)) {
 			cRefReportSpamStatuses().remove(peer->id);
 			Local::writeReportSpamStatuses();
 		}
@@ -2844,36 +2939,97 @@ void ApiWrap::requestFileReference(
 	_fileReferenceHandlers.emplace(origin, std::move(handlers));
 
 	request(std::move(data)).done([=](const auto &result) {
-		const auto parsed = Data::GetFileReferences(result);
-		for (const auto &p : parsed.data) {
-			// Unpack here the parsed pair by hand to workaround a GCC bug.
-			// See https://gcc.gnu.org/bugzilla/show_bug.cgi?id=87122
-			const auto &origin = p.first;
-			const auto &reference = p.second;
-			const auto documentId = base::get_if<DocumentFileLocationId>(
-				&origin);
-			if (documentId) {
-				_session->data().document(
-					*documentId
-				)->refreshFileReference(reference);
+		fileReferencesDone({ origin }, Data::GetFileReferences(result));
+	}).fail([=](const RPCError &error) {
+		fileReferencesDone({ origin }, Data::UpdatedFileReferences());
+	}).send();
+}
+
+void ApiWrap::requestMessageFileReference(
+		Data::FileOriginMessage origin,
+		FileReferencesHandler &&handler) {
+	const auto i = _fileReferenceHandlers.find(origin);
+	if (i != end(_fileReferenceHandlers)) {
+		i->second.push_back(std::move(handler));
+		return;
+	}
+	auto handlers = std::vector<FileReferencesHandler>();
+	handlers.push_back(std::move(handler));
+	_fileReferenceHandlers.emplace(origin, std::move(handlers));
+
+	const auto channel = origin.channel
+		? _session->data().channel(origin.channel).get()
+		: nullptr;
+	_messageFileReferenceRequests[channel].push_back(origin.msg);
+	_messageFileReferencesResolveDelayed.call();
+}
+
+void ApiWrap::resolveMessageFileReferences() {
+	// Scrolling through an old history finds many expired files at once,
+	// so their messages are requested together in a single query.
+	auto requests = base::take(_messageFileReferenceRequests);
+	for (const auto &[channel, ids] : requests) {
+		for (auto from = begin(ids); from != end(ids);) {
+			const auto till = from + std::min(
+				int(end(ids) - from),
+				kFileReferenceMessagesPerRequest);
+			auto inputs = QVector<MTPInputMessage>();
+			auto origins = std::vector<Data::FileOrigin>();
+			inputs.reserve(till - from);
+			origins.reserve(till - from);
+			for (auto i = from; i != till; ++i) {
+				inputs.push_back(MTP_inputMessageID(MTP_int(*i)));
+				origins.push_back(Data::FileOriginMessage(
+					channel ? channel->bareId() : 0,
+					*i));
+			}
+			from = till;
+
+			const auto done = [=](const MTPmessages_Messages &result) {
+				fileReferencesDone(origins, Data::GetFileReferences(result));
+			};
+			const auto fail = [=](const RPCError &error) {
+				fileReferencesDone(origins, Data::UpdatedFileReferences());
+			};
+			if (channel) {
+				request(MTPchannels_GetMessages(
+					channel->inputChannel,
+					MTP_vector<MTPInputMessage>(inputs)
+				)).done(done).fail(fail).send();
+			} else {
+				request(MTPmessages_GetMessages(
+					MTP_vector<MTPInputMessage>(inputs)
+				)).done(done).fail(fail).send();
 			}
 		}
-		const auto i = _fileReferenceHandlers.find(origin);
-		Assert(i != end(_fileReferenceHandlers));
-		auto handlers = std::move(i->second);
-		_fileReferenceHandlers.erase(i);
-		for (auto &handler : handlers) {
-			handler(parsed);
+	}
+}
+
+void ApiWrap::fileReferencesDone(
+		const std::vector<Data::FileOrigin> &origins,
+		const Data::UpdatedFileReferences &parsed) {
+	for (const auto &p : parsed.data) {
+		// Unpack here the parsed pair by hand to workaround a GCC bug.
+		// See https://gcc.gnu.org/bugzilla/show_bug.cgi?id=87122
+		const auto &origin = p.first;
+		const auto &reference = p.second;
+		const auto documentId = base::get_if<DocumentFileLocationId>(
+			&origin);
+		if (documentId) {
+			_session->data().document(
+				*documentId
+			)->refreshFileReference(reference);
 		}
-	}).fail([=](const RPCError &error) {
+	}
+	for (const auto &origin : origins) {
 		const auto i = _fileReferenceHandlers.find(origin);
 		Assert(i != end(_fileReferenceHandlers));
 		auto handlers = std::move(i->second);
 		_fileReferenceHandlers.erase(i);
 		for (auto &handler : handlers) {
-			handler(Data::UpdatedFileReferences());
+			handler(parsed);
 		}
-	}).send();
+	}
 }
 
 void ApiWrap::refreshFileReference(
@@ -2911,19 +3067,8 @@ void ApiWrap::refreshFileReference(
 		handler(Data::UpdatedFileReferences());
 	};
 	origin.data.match([&](Data::FileOriginMessage data) {
-		if (const auto item = App::histItemById(data)) {
-			if (const auto channel = item->history()->peer->asChannel()) {
-				request(MTPchannels_GetMessages(
-					channel->inputChannel,
-					MTP_vector<MTPInputMessage>(
-						1,
-						MTP_inputMessageID(MTP_int(item->id)))));
-			} else {
-				request(MTPmessages_GetMessages(
-					MTP_vector<MTPInputMessage>(
-						1,
-						MTP_inputMessageID(MTP_int(item->id)))));
-			}
+		if (App::histItemById(data)) {
+			requestMessageFileReference(data, std::move(handler));
 		} else {
 			fail();
 		}
@@ -3921,6 +4066,7 @@ void ApiWrap::sharedMediaDone(
 		messageId,
 		slice,
 		result);
+	Local::WriteSharedMediaCount(peer->id, type, parsed.fullCount);
 	_session->storage().add(Storage::SharedMediaAddSlice(
 		peer->id,
 		type,
@@ -5191,6 +5337,45 @@ FileLoadTo ApiWrap::fileLoadTaskOptions(const SendOptions &options) const {
 		options.replyTo);
 }
 
+void ApiWrap::rememberSentDocument(
+		const QByteArray &contentHash,
+		not_null<DocumentData*> document) {
+	Expects(!contentHash.isEmpty());
+
+	_sentDocuments[contentHash] = document;
+}
+
+bool ApiWrap::sendExistingDocumentByHash(
+		const QByteArray &contentHash,
+		TextWithEntities caption,
+		const SendOptions &options) {
+	if (contentHash.isEmpty()) {
+		return false;
+	}
+	const auto i = _sentDocuments.find(contentHash);
+	if (i == end(_sentDocuments)) {
+		return false;
+	}
+	const auto document = i->second;
+	if (!document->hasRemoteLocation()) {
+		// Still uploading or the upload was cancelled.
+		return false;
+	}
+
+	// The file reference can be refreshed only from a sent message.
+	const auto item = _session->data().findDocumentItem(document);
+	if (!item) {
+		_sentDocuments.erase(i);
+		return false;
+	}
+	sendExistingDocument(
+		document,
+		Data::FileOriginMessage(item->fullId()),
+		std::move(caption),
+		options);
+	return true;
+}
+
 void ApiWrap::requestSupportContact(FnMut<void(const MTPUser &)> callback) {
 	_supportContactCallbacks.push_back(std::move(callback));
 	if (_supportContactCallbacks.size() > 1) {
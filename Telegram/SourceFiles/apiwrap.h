@@ -91,6 +91,10 @@ public:
 	//void changeDialogUnreadMark(not_null<Data::Feed*> feed, bool unread); // #feed
 	void requestFakeChatListMessage(not_null<History*> history);
 
+	// Loads and builds the last slice of a not yet loaded history, so
+	// that it can be shown right away when it is opened.
+	void preloadHistory(not_null<History*> history);
+
 	void requestWallPaper(
 		const QString &slug,
 		Fn<void(const Data::WallPaper &)> done,
@@ -360,6 +364,16 @@ public:
 		TextWithEntities caption,
 		const SendOptions &options);
 
+	// Documents sent from local files are remembered by content hash,
+	// so that sending the same file again doesn't upload it.
+	void rememberSentDocument(
+		const QByteArray &contentHash,
+		not_null<DocumentData*> document);
+	bool sendExistingDocumentByHash(
+		const QByteArray &contentHash,
+		TextWithEntities caption,
+		const SendOptions &options);
+
 	void requestSupportContact(FnMut<void(const MTPUser&)> callback);
 
 	void uploadPeerPhoto(not_null<PeerData*> peer, QImage &&image);
@@ -437,6 +451,9 @@ private:
 
 	void saveDraftsToCloud();
 
+	void resolvePeers();
+	void finalizePeerRequest(mtpRequestId requestId);
+
 	void resolveMessageDatas();
 	void gotMessageDatas(ChannelData *channel, const MTPmessages_Messages &result, mtpRequestId requestId);
 	void finalizeMessageDataRequest(
@@ -597,6 +614,13 @@ private:
 		Data::FileOrigin origin,
 		FileReferencesHandler &&handler,
 		Request &&data);
+	void requestMessageFileReference(
+		Data::FileOriginMessage origin,
+		FileReferencesHandler &&handler);
+	void resolveMessageFileReferences();
+	void fileReferencesDone(
+		const std::vector<Data::FileOrigin> &origins,
+		const Data::UpdatedFileReferences &parsed);
 
 	void photoUploadReady(const FullMsgId &msgId, const MTPInputFile &file);
 
@@ -623,7 +647,10 @@ private:
 
 	using PeerRequests = QMap<PeerData*, mtpRequestId>;
 	PeerRequests _fullPeerRequests;
+
+	// Peers waiting for the batch have zero request ids here.
 	PeerRequests _peerRequests;
+	SingleQueuedInvokation _peersResolveDelayed;
 
 	PeerRequests _participantsRequests;
 	PeerRequests _botsRequests;
@@ -693,6 +720,8 @@ private:
 		not_null<History*>,
 		std::vector<Fn<void()>>> _dialogRequestsPending;
 	base::flat_set<not_null<History*>> _fakeChatListRequests;
+	base::flat_set<not_null<History*>> _historyPreloadRequests;
+	base::flat_map<QByteArray, not_null<DocumentData*>> _sentDocuments;
 
 	base::flat_map<not_null<History*>, mtpRequestId> _unreadMentionsRequests;
 
@@ -754,6 +783,10 @@ private:
 	std::map<
 		Data::FileOrigin,
 		std::vector<FileReferencesHandler>> _fileReferenceHandlers;
+	base::flat_map<
+		ChannelData*,
+		std::vector<MsgId>> _messageFileReferenceRequests;
+	SingleQueuedInvokation _messageFileReferencesResolveDelayed;
 
 	mtpRequestId _deepLinkInfoRequestId = 0;
 
@@ -39,6 +39,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "numbers.h"
 #include "observer_peer.h"
 #include "auth_session.h"
+#include "base/chunked_flat_map.h"
 #include "styles/style_overview.h"
 #include "styles/style_mediaview.h"
 #include "styles/style_chat_helpers.h"
@@ -56,7 +57,7 @@ namespace {
 	using DependentItems = QMap<HistoryItem*, DependentItemsSet>;
 	DependentItems dependentItems;
 
-	using MsgsData = QHash<MsgId, HistoryItem*>;
+	using MsgsData = base::chunked_flat_map<MsgId, HistoryItem*>;
 	MsgsData msgsData;
 	using ChannelMsgsData = QMap<ChannelId, MsgsData>;
 	ChannelMsgsData channelMsgsData;
@@ -361,8 +362,7 @@ namespace App {
 
 		auto historiesToCheck = base::flat_set<not_null<History*>>();
 		for (const auto msgId : msgsIds) {
-			auto j = data->constFind(msgId.v);
-			if (j != data->cend()) {
+			if (const auto j = data->find(msgId.v)) {
 				const auto history = (*j)->history();
 				(*j)->destroy();
 				if (!history->chatListMessageKnown()) {
@@ -426,8 +426,8 @@ namespace App {
 		const auto data = fetchMsgsData(channelId, false);
 		if (!data) return nullptr;
 
-		const auto i = data->constFind(itemId);
-		return (i != data->cend()) ? i.value() : nullptr;
+		const auto i = data->find(itemId);
+		return i ? *i : nullptr;
 	}
 
 	HistoryItem *histItemById(const ChannelData *channel, MsgId itemId) {
@@ -436,13 +436,13 @@ namespace App {
 
 	void historyRegItem(not_null<HistoryItem*> item) {
 		const auto data = fetchMsgsData(item->channelId());
-		const auto i = data->constFind(item->id);
-		if (i == data->cend()) {
-			data->insert(item->id, item);
-		} else if (i.value() != item) {
+		const auto i = data->find(item->id);
+		if (!i) {
+			data->insert_or_assign(item->id, item);
+		} else if (*i != item) {
 			LOG(("App Error: trying to historyRegItem() an already registered item"));
-			i.value()->destroy();
-			data->insert(item->id, item);
+			(*i)->destroy();
+			data->insert_or_assign(item->id, item);
 		}
 	}
 
@@ -451,10 +451,8 @@ namespace App {
 		if (!data) return;
 
 		const auto i = data->find(item->id);
-		if (i != data->cend()) {
-			if (i.value() == item) {
-				data->erase(i);
-			}
+		if (i && *i == item) {
+			data->erase(item->id);
 		}
 		const auto j = ::dependentItems.find(item);
 		if (j != ::dependentItems.cend()) {
@@ -485,13 +483,12 @@ namespace App {
 		::dependentItems.clear();
 		const auto oldData = base::take(msgsData);
 		const auto oldChannelData = base::take(channelMsgsData);
-		for (const auto item : oldData) {
+		const auto destroy = [](MsgId, HistoryItem *item) {
 			delete item;
-		}
+		};
+		oldData.for_each(destroy);
 		for (const auto &data : oldChannelData) {
-			for (const auto item : data) {
-				delete item;
-			}
+			data.for_each(destroy);
 		}
 
 		clearMousedItems();
@@ -0,0 +1,184 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal harness for the benchmark test cases: every measured method
+// is warmed up, then timed over several repetitions and reported as
+// percentiles of the time per iteration. All results of a run can be
+// written as JSON with the --json <path> test runner argument, so that
+// CI can compare them with a stored baseline.
+//
+// Benchmark test cases are tagged "[.benchmark]", so they are hidden
+// from the ordinary test runs and are run explicitly with that tag.
+
+namespace base {
+namespace benchmark {
+
+struct Options {
+	int warmup = 3;
+	int repetitions = 30;
+	int64 iterations = 1; // Method calls in one timed repetition.
+	int64 bytes = 0; // Processed by one call, for throughput.
+};
+
+struct Result {
+	std::string name;
+	int repetitions = 0;
+	int64 iterations = 0;
+	int64 bytes = 0;
+
+	// Nanoseconds per one method call.
+	double min = 0.;
+	double p50 = 0.;
+	double p90 = 0.;
+	double p99 = 0.;
+	double max = 0.;
+};
+
+inline std::vector<Result> &Results() {
+	static auto result = std::vector<Result>();
+	return result;
+}
+
+// Keeps the computed value alive so the optimizer can't drop the work.
+template <typename Value>
+inline void Consume(const Value &value) {
+	static volatile auto sink = int64();
+	sink = sink + int64(value);
+}
+
+// For values measured by the caller, like latencies of asynchronous
+// operations, each value is the nanoseconds of one call.
+inline Result Record(
+		const std::string &name,
+		std::vector<double> values,
+		int64 bytes = 0,
+		int64 iterations = 1) {
+	std::sort(begin(values), end(values));
+
+	const auto at = [&](int percent) {
+		return values.empty()
+			? 0.
+			: values[(int64(values.size()) - 1) * percent / 100];
+	};
+	auto result = Result();
+	result.name = name;
+	result.repetitions = int(values.size());
+	result.iterations = iterations;
+	result.bytes = bytes;
+	result.min = at(0);
+	result.p50 = at(50);
+	result.p90 = at(90);
+	result.p99 = at(99);
+	result.max = at(100);
+	Results().push_back(result);
+	return result;
+}
+
+template <typename Duration>
+inline double Nanoseconds(Duration duration) {
+	return double(std::chrono::duration_cast<
+		std::chrono::nanoseconds>(duration).count());
+}
+
+template <typename Method>
+Result Run(const std::string &name, Options options, Method &&method) {
+	using Clock = std::chrono::steady_clock;
+
+	const auto repeat = [&] {
+		for (auto i = int64(0); i != options.iterations; ++i) {
+			method();
+		}
+	};
+	for (auto i = 0; i != options.warmup; ++i) {
+		repeat();
+	}
+	auto values = std::vector<double>();
+	values.reserve(options.repetitions);
+	for (auto i = 0; i != options.repetitions; ++i) {
+		const auto start = Clock::now();
+		repeat();
+		values.push_back(
+			Nanoseconds(Clock::now() - start) / options.iterations);
+	}
+	return Record(
+		name,
+		std::move(values),
+		options.bytes,
+		options.iterations);
+}
+
+// Megabytes per second at the median, zero if bytes are not set.
+inline double Throughput(const Result &result) {
+	return (result.bytes > 0 && result.p50 > 0.)
+		? (result.bytes * 1000. / result.p50)
+		: 0.;
+}
+
+inline std::string Format(const Result &result) {
+	auto stream = std::ostringstream();
+	stream.precision(1);
+	stream << std::fixed << result.name
+		<< ": p50 " << result.p50
+		<< "ns, p90 " << result.p90
+		<< "ns, p99 " << result.p99
+		<< "ns, min " << result.min
+		<< "ns, max " << result.max << "ns";
+	if (const auto throughput = Throughput(result)) {
+		stream << ", " << throughput << " MB/s";
+	}
+	return stream.str();
+}
+
+inline bool WriteJson(const std::string &path) {
+	auto file = std::ofstream(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	const auto escape = [](const std::string &value) {
+		auto result = std::string();
+		result.reserve(value.size());
+		for (const auto ch : value) {
+			if (ch == '"' || ch == '\\') {
+				result.push_back('\\');
+			}
+			result.push_back(ch);
+		}
+		return result;
+	};
+	file << "{\n  \"results\": [";
+	auto first = true;
+	for (const auto &result : Results()) {
+		file << (first ? "\n" : ",\n")
+			<< "    {"
+			<< " \"name\": \"" << escape(result.name) << "\","
+			<< " \"repetitions\": " << result.repetitions << ","
+			<< " \"iterations\": " << result.iterations << ","
+			<< " \"bytes\": " << result.bytes << ","
+			<< " \"min_ns\": " << result.min << ","
+			<< " \"p50_ns\": " << result.p50 << ","
+			<< " \"p90_ns\": " << result.p90 << ","
+			<< " \"p99_ns\": " << result.p99 << ","
+			<< " \"max_ns\": " << result.max << ","
+			<< " \"mb_per_second\": " << Throughput(result)
+			<< " }";
+		first = false;
+	}
+	file << (first ? "]\n}\n" : "\n  ]\n}\n");
+	return file.good();
+}
+
+} // namespace benchmark
+} // namespace base
@@ -0,0 +1,173 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace base {
+
+// Sorted map stored as a sorted list of sorted chunks. A lookup is two
+// binary searches over contiguous memory, an insertion or removal moves
+// at most one chunk, so there is no per-element node like in the hash
+// or tree maps and filling it in any order stays cheap.
+template <typename Key, typename Value, int kChunkSize = 256>
+class chunked_flat_map {
+	static_assert(kChunkSize > 1, "Chunk should fit at least two values.");
+
+public:
+	Value *find(const Key &key);
+	const Value *find(const Key &key) const;
+	bool contains(const Key &key) const {
+		return find(key) != nullptr;
+	}
+
+	// Returns true if a new value was inserted.
+	bool insert_or_assign(const Key &key, Value value);
+	bool erase(const Key &key);
+	void clear() {
+		_chunks.clear();
+		_size = 0;
+	}
+
+	int size() const {
+		return _size;
+	}
+	bool empty() const {
+		return !_size;
+	}
+
+	// Calls method(const Key&, const Value&) in the order of keys.
+	template <typename Method>
+	void for_each(Method &&method) const;
+
+private:
+	using Element = std::pair<Key, Value>;
+	using Chunk = std::vector<Element>;
+
+	static bool less(const Element &a, const Key &b) {
+		return a.first < b;
+	}
+
+	// Last chunk starting not after the key, or the first one.
+	typename std::vector<Chunk>::iterator chunkFor(const Key &key);
+	typename std::vector<Chunk>::const_iterator chunkFor(
+		const Key &key) const;
+
+	std::vector<Chunk> _chunks;
+	int _size = 0;
+
+};
+
+template <typename Key, typename Value, int kChunkSize>
+auto chunked_flat_map<Key, Value, kChunkSize>::chunkFor(const Key &key)
+-> typename std::vector<Chunk>::iterator {
+	auto i = std::upper_bound(
+		begin(_chunks),
+		end(_chunks),
+		key,
+		[](const Key &value, const Chunk &chunk) {
+			return value < chunk.front().first;
+		});
+	return (i == begin(_chunks)) ? i : (i - 1);
+}
+
+template <typename Key, typename Value, int kChunkSize>
+auto chunked_flat_map<Key, Value, kChunkSize>::chunkFor(
+	const Key &key) const
+-> typename std::vector<Chunk>::const_iterator {
+	return const_cast<chunked_flat_map*>(this)->chunkFor(key);
+}
+
+template <typename Key, typename Value, int kChunkSize>
+Value *chunked_flat_map<Key, Value, kChunkSize>::find(const Key &key) {
+	const auto chunk = chunkFor(key);
+	if (chunk == end(_chunks)) {
+		return nullptr;
+	}
+	const auto i = std::lower_bound(
+		begin(*chunk),
+		end(*chunk),
+		key,
+		less);
+	return (i != end(*chunk) && !(key < i->first)) ? &i->second : nullptr;
+}
+
+template <typename Key, typename Value, int kChunkSize>
+const Value *chunked_flat_map<Key, Value, kChunkSize>::find(
+		const Key &key) const {
+	return const_cast<chunked_flat_map*>(this)->find(key);
+}
+
+template <typename Key, typename Value, int kChunkSize>
+bool chunked_flat_map<Key, Value, kChunkSize>::insert_or_assign(
+		const Key &key,
+		Value value) {
+	auto chunk = chunkFor(key);
+	if (chunk == end(_chunks)) {
+		chunk = _chunks.insert(chunk, Chunk());
+	}
+	const auto i = std::lower_bound(
+		begin(*chunk),
+		end(*chunk),
+		key,
+		less);
+	if (i != end(*chunk) && !(key < i->first)) {
+		i->second = std::move(value);
+		return false;
+	}
+	chunk->emplace(i, key, std::move(value));
+	++_size;
+	if (chunk->size() > size_t(kChunkSize)) {
+		const auto middle = begin(*chunk) + (chunk->size() / 2);
+		auto moved = Chunk(
+			std::make_move_iterator(middle),
+			std::make_move_iterator(end(*chunk)));
+		chunk->erase(middle, end(*chunk));
+		_chunks.insert(chunk + 1, std::move(moved));
+	}
+	return true;
+}
+
+template <typename Key, typename Value, int kChunkSize>
+bool chunked_flat_map<Key, Value, kChunkSize>::erase(const Key &key) {
+	const auto chunk = chunkFor(key);
+	if (chunk == end(_chunks)) {
+		return false;
+	}
+	const auto i = std::lower_bound(
+		begin(*chunk),
+		end(*chunk),
+		key,
+		less);
+	if (i == end(*chunk) || (key < i->first)) {
+		return false;
+	}
+	chunk->erase(i);
+	--_size;
+	if (chunk->empty()) {
+		_chunks.erase(chunk);
+	} else if (chunk->size() < size_t(kChunkSize / 4)
+		&& chunk->capacity() > size_t(kChunkSize / 2)) {
+		chunk->shrink_to_fit();
+	}
+	return true;
+}
+
+template <typename Key, typename Value, int kChunkSize>
+template <typename Method>
+void chunked_flat_map<Key, Value, kChunkSize>::for_each(
+		Method &&method) const {
+	for (const auto &chunk : _chunks) {
+		for (const auto &[key, value] : chunk) {
+			method(key, value);
+		}
+	}
+}
+
+} // namespace base
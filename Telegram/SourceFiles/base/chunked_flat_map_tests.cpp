@@ -0,0 +1,108 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/chunked_flat_map.h"
+#include <map>
+#include <random>
+#include <string>
+
+using namespace std;
+
+TEST_CASE("chunked_flat_maps find inserted values", "[chunked_flat_map]") {
+	base::chunked_flat_map<int, string, 4> v;
+	REQUIRE(v.empty());
+	REQUIRE(v.find(1) == nullptr);
+
+	REQUIRE(v.insert_or_assign(5, "b"));
+	REQUIRE(v.insert_or_assign(0, "a"));
+	REQUIRE(v.insert_or_assign(9, "c"));
+	REQUIRE(v.size() == 3);
+	REQUIRE(v.find(0) != nullptr);
+	REQUIRE(*v.find(0) == "a");
+	REQUIRE(*v.find(5) == "b");
+	REQUIRE(*v.find(9) == "c");
+	REQUIRE(v.find(4) == nullptr);
+	REQUIRE(v.find(-1) == nullptr);
+	REQUIRE(v.find(10) == nullptr);
+
+	SECTION("assigning keeps the size") {
+		REQUIRE(!v.insert_or_assign(5, "d"));
+		REQUIRE(v.size() == 3);
+		REQUIRE(*v.find(5) == "d");
+	}
+	SECTION("erasing removes only the given key") {
+		REQUIRE(v.erase(5));
+		REQUIRE(!v.erase(5));
+		REQUIRE(v.size() == 2);
+		REQUIRE(!v.contains(5));
+		REQUIRE(v.contains(0));
+		REQUIRE(v.contains(9));
+	}
+}
+
+TEST_CASE("chunked_flat_maps match std::map", "[chunked_flat_map]") {
+	base::chunked_flat_map<int, int, 8> v;
+	std::map<int, int> check;
+	auto engine = std::mt19937(0x5EED);
+	auto keys = std::uniform_int_distribution<int>(-500, 500);
+	for (auto i = 0; i != 10000; ++i) {
+		const auto key = keys(engine);
+		if (engine() % 3) {
+			const auto inserted = v.insert_or_assign(key, i);
+			REQUIRE(inserted == check.emplace(key, i).second);
+			check[key] = i;
+		} else {
+			REQUIRE(v.erase(key) == (check.erase(key) > 0));
+		}
+		REQUIRE(v.size() == int(check.size()));
+	}
+	for (auto key = -501; key != 502; ++key) {
+		const auto i = check.find(key);
+		const auto value = v.find(key);
+		if (i == check.end()) {
+			REQUIRE(value == nullptr);
+		} else {
+			REQUIRE(value != nullptr);
+			REQUIRE(*value == i->second);
+		}
+	}
+
+	SECTION("for_each enumerates in the order of keys") {
+		auto i = check.begin();
+		v.for_each([&](int key, int value) {
+			REQUIRE(i != check.end());
+			REQUIRE(i->first == key);
+			REQUIRE(i->second == value);
+			++i;
+		});
+		REQUIRE(i == check.end());
+	}
+	SECTION("clear removes everything") {
+		v.clear();
+		REQUIRE(v.empty());
+		REQUIRE(v.find(check.begin()->first) == nullptr);
+	}
+}
+
+TEST_CASE("chunked_flat_maps filled backwards", "[chunked_flat_map]") {
+	base::chunked_flat_map<int, int, 16> v;
+	for (auto key = 1000; key != 0; --key) {
+		v.insert_or_assign(key, -key);
+	}
+	REQUIRE(v.size() == 1000);
+	auto expected = 1;
+	v.for_each([&](int key, int value) {
+		REQUIRE(key == expected);
+		REQUIRE(value == -key);
+		++expected;
+	});
+	for (auto key = 1; key != 1001; ++key) {
+		REQUIRE(v.erase(key));
+	}
+	REQUIRE(v.empty());
+}
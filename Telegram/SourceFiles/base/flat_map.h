@@ -8,6 +8,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include <deque>
 #include <algorithm>
+#include "base/flat_search.h"
 #include "base/optional.h"
 
 namespace base {
@@ -486,6 +487,21 @@ public:
 		return (range.second - range.first);
 	}
 
+	template <
+		typename Iterator,
+		typename = typename std::iterator_traits<Iterator>::iterator_category>
+	void merge(Iterator first, Iterator last) {
+		details::flat_merge_range(impl(), first, last, compare());
+	}
+
+	void merge(const flat_multi_map<Key, Type, Compare> &other) {
+		merge(other.begin(), other.end());
+	}
+
+	void merge(std::initializer_list<pair_type> list) {
+		merge(list.begin(), list.end());
+	}
+
 private:
 	friend class flat_map<Key, Type, Compare>;
 
@@ -558,28 +574,28 @@ private:
 	}
 
 	typename impl_t::iterator getLowerBound(const Key &key) {
-		return std::lower_bound(
+		return details::flat_lower_bound<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
 			compare());
 	}
 	typename impl_t::const_iterator getLowerBound(const Key &key) const {
-		return std::lower_bound(
+		return details::flat_lower_bound<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
 			compare());
 	}
 	typename impl_t::iterator getUpperBound(const Key &key) {
-		return std::upper_bound(
+		return details::flat_upper_bound<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
 			compare());
 	}
 	typename impl_t::const_iterator getUpperBound(const Key &key) const {
-		return std::upper_bound(
+		return details::flat_upper_bound<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
@@ -589,7 +605,7 @@ private:
 		typename impl_t::iterator,
 		typename impl_t::iterator
 	> getEqualRange(const Key &key) {
-		return std::equal_range(
+		return details::flat_equal_range<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
@@ -599,7 +615,7 @@ private:
 		typename impl_t::const_iterator,
 		typename impl_t::const_iterator
 	> getEqualRange(const Key &key) const {
-		return std::equal_range(
+		return details::flat_equal_range<Key, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			key,
@@ -758,6 +774,23 @@ public:
 		return std::move(result);
 	}
 
+	// Keys that are already in the map keep their values.
+	template <
+		typename Iterator,
+		typename = typename std::iterator_traits<Iterator>::iterator_category>
+	void merge(Iterator first, Iterator last) {
+		parent::merge(first, last);
+		finalize();
+	}
+
+	void merge(const flat_map<Key, Type, Compare> &other) {
+		merge(other.begin(), other.end());
+	}
+
+	void merge(std::initializer_list<pair_type> list) {
+		merge(list.begin(), list.end());
+	}
+
 private:
 	void finalize() {
 		this->impl().erase(
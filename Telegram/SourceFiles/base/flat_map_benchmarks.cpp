@@ -0,0 +1,78 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/flat_map.h"
+#include "base/benchmark.h"
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr auto kSmallCount = 64;
+constexpr auto kLargeCount = 16 * 1024;
+
+std::vector<int> RandomKeys(int count) {
+	auto engine = std::mt19937(42);
+	auto result = std::vector<int>(count);
+	for (auto &key : result) {
+		key = int(engine());
+	}
+	return result;
+}
+
+template <typename Map>
+void MeasureMap(const std::string &name, int count) {
+	using namespace base::benchmark;
+
+	const auto keys = RandomKeys(count);
+	auto filled = Map();
+	for (const auto key : keys) {
+		filled.emplace(key, key);
+	}
+	const auto prefix = name + " " + std::to_string(count);
+
+	WARN(Format(Run(prefix + " insert", {}, [&] {
+		auto map = Map();
+		for (const auto key : keys) {
+			map.emplace(key, key);
+		}
+		Consume(map.size());
+	})));
+	WARN(Format(Run(prefix + " find", { 3, 30, 10 }, [&] {
+		auto sum = int64();
+		for (const auto key : keys) {
+			const auto i = filled.find(key);
+			sum += (i != filled.end()) ? i->second : 0;
+		}
+		Consume(sum);
+	})));
+	WARN(Format(Run(prefix + " iterate", { 3, 30, 100 }, [&] {
+		auto sum = int64();
+		for (const auto &pair : filled) {
+			sum += pair.second;
+		}
+		Consume(sum);
+	})));
+	WARN(Format(Run(prefix + " erase", {}, [&] {
+		auto map = filled;
+		for (const auto key : keys) {
+			map.erase(key);
+		}
+		Consume(map.size());
+	})));
+}
+
+} // namespace
+
+TEST_CASE("flat_map benchmark", "[.benchmark]") {
+	for (const auto count : { kSmallCount, kLargeCount }) {
+		MeasureMap<base::flat_map<int, int>>("flat_map", count);
+		MeasureMap<std::map<int, int>>("std::map", count);
+	}
+}
@@ -118,3 +118,30 @@ TEST_CASE("flat_maps structured bindings", "[flat_map]") {
 		}
 	}
 }
+
+TEST_CASE("flat_maps with integral keys", "[flat_map]") {
+	base::flat_map<uint64_t, int> v;
+	for (auto i = 0; i != 100; ++i) {
+		v.emplace(uint64_t(i * 2), i);
+	}
+
+	SECTION("lookup finds every key of any range size") {
+		for (auto i = 0; i != 100; ++i) {
+			const auto found = v.find(uint64_t(i * 2));
+			REQUIRE(found != v.end());
+			REQUIRE(found->second == i);
+			REQUIRE(v.find(uint64_t(i * 2 + 1)) == v.end());
+		}
+	}
+
+	SECTION("merge keeps existing values") {
+		v.merge({ { uint64_t(3), -1 }, { uint64_t(4), -1 }, { uint64_t(3), -2 } });
+		REQUIRE(v.size() == 101);
+		REQUIRE(v.find(uint64_t(3))->second == -1);
+		REQUIRE(v.find(uint64_t(4))->second == 2);
+		auto prev = v.begin();
+		for (auto i = prev + 1; i != v.end(); prev = i, ++i) {
+			REQUIRE(prev->first < i->first);
+		}
+	}
+}
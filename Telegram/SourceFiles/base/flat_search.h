@@ -0,0 +1,157 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+namespace base {
+namespace details {
+
+// Keys that are compared by a single machine instruction, like MsgId,
+// PeerId or uint64, so the comparison result can become a conditional
+// move instead of a hard to predict branch.
+template <typename Key, typename Compare>
+constexpr bool is_branchless_search_v
+	= (std::is_arithmetic_v<Key>
+		|| std::is_enum_v<Key>
+		|| std::is_pointer_v<Key>)
+	&& (std::is_same_v<Compare, std::less<>>
+		|| std::is_same_v<Compare, std::less<Key>>);
+
+// Binary search without a data dependent branch: the range always
+// halves, only the base moves. Works for any sorted random access range.
+template <typename Iterator, typename Value, typename Less>
+inline Iterator branchless_lower_bound(
+		Iterator first,
+		Iterator last,
+		const Value &value,
+		const Less &less) {
+	auto length = last - first;
+	if (!length) {
+		return last;
+	}
+	while (length > 1) {
+		const auto half = length / 2;
+		first += less(first[half - 1], value) ? half : 0;
+		length -= half;
+	}
+	return first + (less(*first, value) ? 1 : 0);
+}
+
+template <typename Iterator, typename Value, typename Less>
+inline Iterator branchless_upper_bound(
+		Iterator first,
+		Iterator last,
+		const Value &value,
+		const Less &less) {
+	auto length = last - first;
+	if (!length) {
+		return last;
+	}
+	while (length > 1) {
+		const auto half = length / 2;
+		first += less(value, first[half - 1]) ? 0 : half;
+		length -= half;
+	}
+	return first + (less(value, *first) ? 0 : 1);
+}
+
+template <
+	typename Key,
+	typename Compare,
+	typename Iterator,
+	typename Value,
+	typename Less>
+inline Iterator flat_lower_bound(
+		Iterator first,
+		Iterator last,
+		const Value &value,
+		const Less &less) {
+	if constexpr (is_branchless_search_v<Key, Compare>
+		&& std::is_same_v<std::decay_t<Value>, Key>) {
+		return branchless_lower_bound(first, last, value, less);
+	} else {
+		return std::lower_bound(first, last, value, less);
+	}
+}
+
+template <
+	typename Key,
+	typename Compare,
+	typename Iterator,
+	typename Value,
+	typename Less>
+inline Iterator flat_upper_bound(
+		Iterator first,
+		Iterator last,
+		const Value &value,
+		const Less &less) {
+	if constexpr (is_branchless_search_v<Key, Compare>
+		&& std::is_same_v<std::decay_t<Value>, Key>) {
+		return branchless_upper_bound(first, last, value, less);
+	} else {
+		return std::upper_bound(first, last, value, less);
+	}
+}
+
+template <
+	typename Key,
+	typename Compare,
+	typename Iterator,
+	typename Value,
+	typename Less>
+inline std::pair<Iterator, Iterator> flat_equal_range(
+		Iterator first,
+		Iterator last,
+		const Value &value,
+		const Less &less) {
+	const auto from = flat_lower_bound<Key, Compare>(
+		first,
+		last,
+		value,
+		less);
+	return {
+		from,
+		flat_upper_bound<Key, Compare>(from, last, value, less)
+	};
+}
+
+// Append [first, last) to a sorted container and merge it in place.
+// Sorting only the new part makes a bulk insert O(n + m * log(m))
+// instead of sorting all the n + m elements again. Both steps are
+// stable, so equal keys keep their order and the first one wins.
+template <typename Container, typename Iterator, typename Less>
+inline void flat_merge_range(
+		Container &elements,
+		Iterator first,
+		Iterator last,
+		const Less &less) {
+	const auto was = elements.size();
+
+	// Range insert may copy-assign, that flat_map pairs don't support.
+	for (; first != last; ++first) {
+		elements.push_back(*first);
+	}
+	const auto middle = std::begin(elements) + was;
+	if (middle == std::end(elements)) {
+		return;
+	}
+	std::stable_sort(middle, std::end(elements), less);
+	if (was > 0 && less(*middle, *(middle - 1))) {
+		std::inplace_merge(
+			std::begin(elements),
+			middle,
+			std::end(elements),
+			less);
+	}
+}
+
+} // namespace details
+} // namespace base
@@ -8,6 +8,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include <deque>
 #include <algorithm>
+#include "base/flat_search.h"
 
 namespace base {
 
@@ -395,8 +396,7 @@ public:
 		typename Iterator,
 		typename = typename std::iterator_traits<Iterator>::iterator_category>
 	void merge(Iterator first, Iterator last) {
-		impl().insert(impl().end(), first, last);
-		std::sort(std::begin(impl()), std::end(impl()), compare());
+		details::flat_merge_range(impl(), first, last, compare());
 	}
 
 	void merge(const flat_multi_set<Type, Compare> &other) {
@@ -485,14 +485,14 @@ private:
 	}
 
 	typename impl_t::iterator getLowerBound(const Type &value) {
-		return std::lower_bound(
+		return details::flat_lower_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
 			compare());
 	}
 	typename impl_t::const_iterator getLowerBound(const Type &value) const {
-		return std::lower_bound(
+		return details::flat_lower_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
@@ -502,7 +502,7 @@ private:
 		typename OtherType,
 		typename = typename Compare::is_transparent>
 	typename impl_t::iterator getLowerBound(const OtherType &value) {
-		return std::lower_bound(
+		return details::flat_lower_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
@@ -512,21 +512,21 @@ private:
 		typename OtherType,
 		typename = typename Compare::is_transparent>
 	typename impl_t::const_iterator getLowerBound(const OtherType &value) const {
-		return std::lower_bound(
+		return details::flat_lower_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
 			compare());
 	}
 	typename impl_t::iterator getUpperBound(const Type &value) {
-		return std::upper_bound(
+		return details::flat_upper_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
 			compare());
 	}
 	typename impl_t::const_iterator getUpperBound(const Type &value) const {
-		return std::upper_bound(
+		return details::flat_upper_bound<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
@@ -536,7 +536,7 @@ private:
 		typename impl_t::iterator,
 		typename impl_t::iterator
 	> getEqualRange(const Type &value) {
-		return std::equal_range(
+		return details::flat_equal_range<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
@@ -546,7 +546,7 @@ private:
 		typename impl_t::const_iterator,
 		typename impl_t::const_iterator
 	> getEqualRange(const Type &value) const {
-		return std::equal_range(
+		return details::flat_equal_range<Type, Compare>(
 			std::begin(impl()),
 			std::end(impl()),
 			value,
@@ -81,3 +81,27 @@ TEST_CASE("flat_sets with custom comparators", "[flat_set]") {
 		checkSorted();
 	}
 }
+
+TEST_CASE("flat_sets merge", "[flat_set]") {
+	base::flat_set<int> v = { 1, 3, 5, 7 };
+
+	SECTION("merge inserts only new items in the right positions") {
+		v.merge({ 6, 0, 3, 8, 6 });
+		REQUIRE(v.size() == 7);
+		auto expected = 0;
+		for (const auto value : v) {
+			if (expected == 2 || expected == 4) {
+				++expected;
+			}
+			REQUIRE(value == expected++);
+		}
+	}
+
+	SECTION("multi set keeps equal items") {
+		base::flat_multi_set<int> u = { 1, 3 };
+		u.merge({ 3, 2, 1 });
+		REQUIRE(u.size() == 5);
+		REQUIRE(u.count(1) == 2);
+		REQUIRE(u.count(3) == 2);
+	}
+}
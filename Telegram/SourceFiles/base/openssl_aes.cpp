@@ -0,0 +1,403 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "base/openssl_aes.h"
+
+#include "base/build_config.h"
+#include "base/assertion.h"
+
+extern "C" {
+#include <openssl/aes.h>
+#include <openssl/modes.h>
+} // extern "C"
+
+#include <cstring>
+
+#ifdef ARCH_CPU_X86_FAMILY
+#define BASE_AES_HARDWARE 1
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#ifdef COMPILER_MSVC
+#include <intrin.h>
+#define BASE_AES_TARGET
+#else // COMPILER_MSVC
+#include <cpuid.h>
+#define BASE_AES_TARGET __attribute__((target("aes,sse2")))
+#endif // COMPILER_MSVC
+#endif // ARCH_CPU_X86_FAMILY
+
+namespace openssl {
+namespace {
+
+static_assert(kAesBlockSize == AES_BLOCK_SIZE);
+
+#ifdef BASE_AES_HARDWARE
+
+constexpr auto kAes256Rounds = 14;
+
+// Independent blocks keep the AES unit pipeline busy in CTR mode.
+constexpr auto kCtrParallelBlocks = 8;
+static_assert(kCtrParallelBlocks == 8, "BASE_AES_EACH must be updated.");
+
+bool DetectHardwareAes() {
+#ifdef COMPILER_MSVC
+	int info[4] = { 0 };
+	__cpuid(info, 1);
+	const auto ecx = uint32(info[2]);
+#else // COMPILER_MSVC
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+#endif // COMPILER_MSVC
+	constexpr auto kAesBit = (1U << 25);
+	return (ecx & kAesBit) != 0;
+}
+
+struct Schedule {
+	__m128i keys[kAes256Rounds + 1];
+};
+
+BASE_AES_TARGET inline __m128i ExpandFirst(__m128i key, __m128i assist) {
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+BASE_AES_TARGET inline __m128i ExpandSecond(__m128i first, __m128i key) {
+	const auto assist = _mm_shuffle_epi32(
+		_mm_aeskeygenassist_si128(first, 0x00),
+		0xAA);
+	auto shifted = _mm_slli_si128(key, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	shifted = _mm_slli_si128(shifted, 4);
+	key = _mm_xor_si128(key, shifted);
+	return _mm_xor_si128(key, assist);
+}
+
+BASE_AES_TARGET void PrepareEncryptSchedule(
+		Schedule &schedule,
+		const void *key) {
+	const auto bytes = static_cast<const uchar*>(key);
+	auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+	auto second = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(bytes + kAesBlockSize));
+	auto k = schedule.keys;
+	k[0] = first;
+	k[1] = second;
+
+	// The round constant must be an immediate, so the loop is unrolled.
+#define BASE_AES_EXPAND(index, rcon) \
+	first = ExpandFirst(first, _mm_aeskeygenassist_si128(second, rcon)); \
+	k[index] = first; \
+	second = ExpandSecond(first, second); \
+	k[index + 1] = second;
+
+	BASE_AES_EXPAND(2, 0x01);
+	BASE_AES_EXPAND(4, 0x02);
+	BASE_AES_EXPAND(6, 0x04);
+	BASE_AES_EXPAND(8, 0x08);
+	BASE_AES_EXPAND(10, 0x10);
+	BASE_AES_EXPAND(12, 0x20);
+
+#undef BASE_AES_EXPAND
+
+	k[14] = ExpandFirst(first, _mm_aeskeygenassist_si128(second, 0x40));
+}
+
+BASE_AES_TARGET void PrepareDecryptSchedule(
+		Schedule &schedule,
+		const void *key) {
+	auto encrypt = Schedule();
+	PrepareEncryptSchedule(encrypt, key);
+	schedule.keys[0] = encrypt.keys[kAes256Rounds];
+	for (auto i = 1; i != kAes256Rounds; ++i) {
+		schedule.keys[i] = _mm_aesimc_si128(encrypt.keys[kAes256Rounds - i]);
+	}
+	schedule.keys[kAes256Rounds] = encrypt.keys[0];
+}
+
+BASE_AES_TARGET inline __m128i EncryptBlock(
+		const Schedule &schedule,
+		__m128i block) {
+	const auto k = schedule.keys;
+	block = _mm_xor_si128(block, k[0]);
+	for (auto i = 1; i != kAes256Rounds; ++i) {
+		block = _mm_aesenc_si128(block, k[i]);
+	}
+	return _mm_aesenclast_si128(block, k[kAes256Rounds]);
+}
+
+BASE_AES_TARGET inline __m128i DecryptBlock(
+		const Schedule &schedule,
+		__m128i block) {
+	const auto k = schedule.keys;
+	block = _mm_xor_si128(block, k[0]);
+	for (auto i = 1; i != kAes256Rounds; ++i) {
+		block = _mm_aesdec_si128(block, k[i]);
+	}
+	return _mm_aesdeclast_si128(block, k[kAes256Rounds]);
+}
+
+BASE_AES_TARGET void HardwareIgeEncrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const void *key,
+		const void *iv) {
+	auto schedule = Schedule();
+	PrepareEncryptSchedule(schedule, key);
+
+	const auto ivBytes = static_cast<const uchar*>(iv);
+	auto previousOut = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(ivBytes));
+	auto previousIn = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(ivBytes + kAesBlockSize));
+	for (auto till = src + len; src != till;) {
+		const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		previousOut = _mm_xor_si128(
+			EncryptBlock(schedule, _mm_xor_si128(in, previousOut)),
+			previousIn);
+		previousIn = in;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), previousOut);
+		src += kAesBlockSize;
+		dst += kAesBlockSize;
+	}
+}
+
+BASE_AES_TARGET void HardwareIgeDecrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const void *key,
+		const void *iv) {
+	auto schedule = Schedule();
+	PrepareDecryptSchedule(schedule, key);
+
+	const auto ivBytes = static_cast<const uchar*>(iv);
+	auto previousIn = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(ivBytes));
+	auto previousOut = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(ivBytes + kAesBlockSize));
+	for (auto till = src + len; src != till;) {
+		const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		previousOut = _mm_xor_si128(
+			DecryptBlock(schedule, _mm_xor_si128(in, previousOut)),
+			previousIn);
+		previousIn = in;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), previousOut);
+		src += kAesBlockSize;
+		dst += kAesBlockSize;
+	}
+}
+
+inline uint32 ReadBigEndian(const uchar *bytes) {
+	return (uint32(bytes[0]) << 24)
+		| (uint32(bytes[1]) << 16)
+		| (uint32(bytes[2]) << 8)
+		| uint32(bytes[3]);
+}
+
+inline int32 ByteSwapped(uint32 value) {
+	return int32((value >> 24)
+		| ((value >> 8) & 0xFF00U)
+		| ((value << 8) & 0xFF0000U)
+		| (value << 24));
+}
+
+// ctr128_f for CRYPTO_ctr128_encrypt_ctr32, only the last 32 bits of the
+// counter are incremented, OpenSSL takes care of the carry.
+BASE_AES_TARGET void HardwareCtr32Blocks(
+		const uchar *in,
+		uchar *out,
+		size_t blocks,
+		const void *key,
+		const uchar ivec[kAesBlockSize]) {
+	const auto &schedule = *static_cast<const Schedule*>(key);
+	const auto k = schedule.keys;
+
+	// Counter blocks are built in registers, the first 12 bytes are fixed.
+	int32 nonce[3];
+	std::memcpy(nonce, ivec, sizeof(nonce));
+	auto counter = ReadBigEndian(ivec + 12);
+	const auto next = [&] {
+		return _mm_set_epi32(
+			ByteSwapped(counter++),
+			nonce[2],
+			nonce[1],
+			nonce[0]);
+	};
+
+	while (blocks >= kCtrParallelBlocks) {
+		// Unrolled by hand, so that the state stays in registers
+		// without relying on the optimizer.
+#define BASE_AES_EACH(action) \
+	action(0); action(1); action(2); action(3); \
+	action(4); action(5); action(6); action(7);
+
+		__m128i state[kCtrParallelBlocks];
+#define BASE_AES_START(i) state[i] = _mm_xor_si128(next(), k[0])
+		BASE_AES_EACH(BASE_AES_START);
+#undef BASE_AES_START
+
+		for (auto round = 1; round != kAes256Rounds; ++round) {
+			const auto roundKey = k[round];
+#define BASE_AES_ROUND(i) state[i] = _mm_aesenc_si128(state[i], roundKey)
+			BASE_AES_EACH(BASE_AES_ROUND);
+#undef BASE_AES_ROUND
+		}
+
+		const auto lastKey = k[kAes256Rounds];
+		const auto from = reinterpret_cast<const __m128i*>(in);
+		const auto till = reinterpret_cast<__m128i*>(out);
+#define BASE_AES_FINISH(i) _mm_storeu_si128(till + i, _mm_xor_si128( \
+	_mm_loadu_si128(from + i), \
+	_mm_aesenclast_si128(state[i], lastKey)))
+		BASE_AES_EACH(BASE_AES_FINISH);
+#undef BASE_AES_FINISH
+
+#undef BASE_AES_EACH
+
+		in += kCtrParallelBlocks * kAesBlockSize;
+		out += kCtrParallelBlocks * kAesBlockSize;
+		blocks -= kCtrParallelBlocks;
+	}
+	for (; blocks != 0; --blocks) {
+		const auto keystream = EncryptBlock(schedule, next());
+		const auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(out),
+			_mm_xor_si128(data, keystream));
+		in += kAesBlockSize;
+		out += kAesBlockSize;
+	}
+}
+
+BASE_AES_TARGET void HardwareCtrEncrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const void *key,
+		uchar ivec[kAesBlockSize],
+		uchar ecount[kAesBlockSize],
+		uint32 *num) {
+	auto schedule = Schedule();
+	PrepareEncryptSchedule(schedule, key);
+	CRYPTO_ctr128_encrypt_ctr32(
+		src,
+		dst,
+		len,
+		&schedule,
+		ivec,
+		ecount,
+		num,
+		HardwareCtr32Blocks);
+}
+
+#endif // BASE_AES_HARDWARE
+
+void SoftwareIgeCrypt(
+		const uchar *src,
+		uchar *dst,
+		size_t len,
+		const void *key,
+		const void *iv,
+		int mode) {
+	uchar ivCopy[2 * kAesBlockSize];
+	std::memcpy(ivCopy, iv, sizeof(ivCopy));
+
+	AES_KEY aes;
+	if (mode == AES_ENCRYPT) {
+		AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
+	} else {
+		AES_set_decrypt_key(static_cast<const uchar*>(key), 256, &aes);
+	}
+	AES_ige_encrypt(src, dst, len, &aes, ivCopy, mode);
+}
+
+} // namespace
+
+bool AesHardwareSupported() {
+#ifdef BASE_AES_HARDWARE
+	static const auto result = DetectHardwareAes();
+	return result;
+#else // BASE_AES_HARDWARE
+	return false;
+#endif // BASE_AES_HARDWARE
+}
+
+void AesIgeEncrypt(
+		const void *src,
+		void *dst,
+		size_t len,
+		const void *key,
+		const void *iv) {
+	Expects((len % kAesBlockSize) == 0);
+
+	const auto from = static_cast<const uchar*>(src);
+	const auto to = static_cast<uchar*>(dst);
+#ifdef BASE_AES_HARDWARE
+	if (AesHardwareSupported()) {
+		return HardwareIgeEncrypt(from, to, len, key, iv);
+	}
+#endif // BASE_AES_HARDWARE
+	SoftwareIgeCrypt(from, to, len, key, iv, AES_ENCRYPT);
+}
+
+void AesIgeDecrypt(
+		const void *src,
+		void *dst,
+		size_t len,
+		const void *key,
+		const void *iv) {
+	Expects((len % kAesBlockSize) == 0);
+
+	const auto from = static_cast<const uchar*>(src);
+	const auto to = static_cast<uchar*>(dst);
+#ifdef BASE_AES_HARDWARE
+	if (AesHardwareSupported()) {
+		return HardwareIgeDecrypt(from, to, len, key, iv);
+	}
+#endif // BASE_AES_HARDWARE
+	SoftwareIgeCrypt(from, to, len, key, iv, AES_DECRYPT);
+}
+
+void AesCtrEncrypt(
+		const void *src,
+		void *dst,
+		size_t len,
+		const void *key,
+		uchar ivec[kAesBlockSize],
+		uchar ecount[kAesBlockSize],
+		uint32 *num) {
+	const auto from = static_cast<const uchar*>(src);
+	const auto to = static_cast<uchar*>(dst);
+#ifdef BASE_AES_HARDWARE
+	if (AesHardwareSupported()) {
+		return HardwareCtrEncrypt(from, to, len, key, ivec, ecount, num);
+	}
+#endif // BASE_AES_HARDWARE
+	AES_KEY aes;
+	AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
+	CRYPTO_ctr128_encrypt(
+		from,
+		to,
+		len,
+		&aes,
+		ivec,
+		ecount,
+		num,
+		(block128_f)AES_encrypt);
+}
+
+} // namespace openssl
@@ -0,0 +1,45 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+
+namespace openssl {
+
+constexpr auto kAesBlockSize = 16;
+constexpr auto kAes256KeySize = 32;
+
+// AES-256 with AES-NI kernels when the CPU has them (checked once at
+// runtime) and the OpenSSL software implementation otherwise.
+bool AesHardwareSupported();
+
+// IGE, the iv is 32 bytes, len must be a multiple of the block size.
+// Works in place, the iv is not updated.
+void AesIgeEncrypt(
+	const void *src,
+	void *dst,
+	size_t len,
+	const void *key,
+	const void *iv);
+void AesIgeDecrypt(
+	const void *src,
+	void *dst,
+	size_t len,
+	const void *key,
+	const void *iv);
+
+// CTR with the same state as CRYPTO_ctr128_encrypt, any len, works in place.
+void AesCtrEncrypt(
+	const void *src,
+	void *dst,
+	size_t len,
+	const void *key,
+	uchar ivec[kAesBlockSize],
+	uchar ecount[kAesBlockSize],
+	uint32 *num);
+
+} // namespace openssl
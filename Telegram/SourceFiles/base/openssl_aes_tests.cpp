@@ -0,0 +1,172 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/openssl_aes.h"
+#include "base/benchmark.h"
+
+extern "C" {
+#include <openssl/aes.h>
+#include <openssl/modes.h>
+} // extern "C"
+
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr auto kBenchmarkSize = 64 * 1024 * 1024;
+constexpr auto kBenchmarkChunk = 128 * 1024;
+
+std::vector<uchar> RandomBytes(size_t size) {
+	static auto engine = std::mt19937(42);
+	auto result = std::vector<uchar>(size);
+	for (auto &byte : result) {
+		byte = uchar(engine() & 0xFF);
+	}
+	return result;
+}
+
+std::vector<uchar> ReferenceIge(
+		const std::vector<uchar> &data,
+		const std::vector<uchar> &key,
+		std::vector<uchar> iv,
+		int mode) {
+	AES_KEY aes;
+	if (mode == AES_ENCRYPT) {
+		AES_set_encrypt_key(key.data(), 256, &aes);
+	} else {
+		AES_set_decrypt_key(key.data(), 256, &aes);
+	}
+	auto result = std::vector<uchar>(data.size());
+	AES_ige_encrypt(
+		data.data(),
+		result.data(),
+		data.size(),
+		&aes,
+		iv.data(),
+		mode);
+	return result;
+}
+
+template <typename Method>
+void MeasureThroughput(const std::string &name, Method method) {
+	using namespace base::benchmark;
+
+	auto buffer = RandomBytes(kBenchmarkChunk);
+	auto options = Options();
+	options.iterations = kBenchmarkSize / kBenchmarkChunk / 30;
+	options.bytes = kBenchmarkChunk;
+	WARN(Format(Run(name, options, [&] {
+		method(buffer.data(), buffer.size());
+	})));
+}
+
+} // namespace
+
+TEST_CASE("aes ige matches openssl", "[openssl_aes]") {
+	const auto key = RandomBytes(openssl::kAes256KeySize);
+	const auto iv = RandomBytes(2 * openssl::kAesBlockSize);
+
+	for (const auto blocks : { 1, 2, 3, 17, 1024 }) {
+		const auto data = RandomBytes(blocks * openssl::kAesBlockSize);
+		const auto encrypted = ReferenceIge(data, key, iv, AES_ENCRYPT);
+
+		auto result = std::vector<uchar>(data.size());
+		openssl::AesIgeEncrypt(
+			data.data(),
+			result.data(),
+			data.size(),
+			key.data(),
+			iv.data());
+		REQUIRE(result == encrypted);
+
+		// In place.
+		openssl::AesIgeDecrypt(
+			result.data(),
+			result.data(),
+			result.size(),
+			key.data(),
+			iv.data());
+		REQUIRE(result == data);
+	}
+}
+
+TEST_CASE("aes ctr matches openssl", "[openssl_aes]") {
+	const auto key = RandomBytes(openssl::kAes256KeySize);
+	const auto data = RandomBytes(4099);
+
+	// The counter low bytes are close to a 32 bit overflow.
+	auto ivecInitial = RandomBytes(openssl::kAesBlockSize);
+	ivecInitial[12] = ivecInitial[13] = ivecInitial[14] = 0xFF;
+	ivecInitial[15] = 0xF0;
+
+	AES_KEY aes;
+	AES_set_encrypt_key(key.data(), 256, &aes);
+	auto expected = std::vector<uchar>(data.size());
+	{
+		auto ivec = ivecInitial;
+		uchar ecount[openssl::kAesBlockSize] = { 0 };
+		unsigned int num = 0;
+		CRYPTO_ctr128_encrypt(
+			data.data(),
+			expected.data(),
+			data.size(),
+			&aes,
+			ivec.data(),
+			ecount,
+			&num,
+			(block128_f)AES_encrypt);
+	}
+
+	// Odd sized pieces check the partial block state.
+	auto result = data;
+	auto ivec = ivecInitial;
+	uchar ecount[openssl::kAesBlockSize] = { 0 };
+	uint32 num = 0;
+	for (auto offset = size_t(0), piece = size_t(1); offset < data.size();) {
+		const auto size = std::min(piece, data.size() - offset);
+		openssl::AesCtrEncrypt(
+			result.data() + offset,
+			result.data() + offset,
+			size,
+			key.data(),
+			ivec.data(),
+			ecount,
+			&num);
+		offset += size;
+		piece = piece * 3 + 1;
+	}
+	REQUIRE(result == expected);
+}
+
+TEST_CASE("aes throughput benchmark", "[.benchmark]") {
+	const auto key = RandomBytes(openssl::kAes256KeySize);
+	const auto iv = RandomBytes(2 * openssl::kAesBlockSize);
+
+	WARN("Hardware AES: "
+		<< (openssl::AesHardwareSupported() ? "yes" : "no"));
+	MeasureThroughput("aes ige encrypt", [&](uchar *data, size_t size) {
+		openssl::AesIgeEncrypt(data, data, size, key.data(), iv.data());
+	});
+	MeasureThroughput("aes ige decrypt", [&](uchar *data, size_t size) {
+		openssl::AesIgeDecrypt(data, data, size, key.data(), iv.data());
+	});
+	MeasureThroughput("aes ctr", [&](uchar *data, size_t size) {
+		auto ivec = std::vector<uchar>(iv.begin(), iv.begin() + 16);
+		uchar ecount[openssl::kAesBlockSize] = { 0 };
+		uint32 num = 0;
+		openssl::AesCtrEncrypt(
+			data,
+			data,
+			size,
+			key.data(),
+			ivec.data(),
+			ecount,
+			&num);
+	});
+}
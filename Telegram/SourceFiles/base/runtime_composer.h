@@ -6,6 +6,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 */
 #pragma once
 
+#include "base/slab_allocator.h"
+
 template <typename Base>
 class RuntimeComposer;
 
@@ -144,7 +146,7 @@ public:
 		if (mask) {
 			auto meta = GetRuntimeComposerMetadata(mask);
 
-			auto data = operator new(meta->size);
+			auto data = base::details::slab_allocate(meta->size);
 			Assert(data != nullptr);
 
 			_data = data;
@@ -184,7 +186,7 @@ public:
 					RuntimeComponentWraps[i].Destruct(_dataptrunsafe(offset));
 				}
 			}
-			operator delete(_data);
+			base::details::slab_deallocate(_data, meta->size);
 		}
 	}
 
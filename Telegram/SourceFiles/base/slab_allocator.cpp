@@ -0,0 +1,189 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "base/slab_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace base {
+namespace details {
+namespace {
+
+constexpr auto kSlabAlignment = std::size_t(16);
+constexpr auto kSlabMaxBlock = std::size_t(1024);
+constexpr auto kSlabSize = std::size_t(64 * 1024);
+constexpr auto kSlabClasses = kSlabMaxBlock / kSlabAlignment;
+
+struct FreeBlock {
+	FreeBlock *next = nullptr;
+};
+
+struct Slab {
+	char *data = nullptr;
+	FreeBlock *free = nullptr;
+	std::size_t used = 0;
+};
+
+// One empty slab is kept for all the size classes, so that a class
+// which goes empty and back doesn't return to the heap each time.
+char *Spare = nullptr;
+
+char *TakeSlab() {
+	if (const auto result = std::exchange(Spare, nullptr)) {
+		return result;
+	}
+	return static_cast<char*>(::operator new(kSlabSize));
+}
+
+void PutSlab(char *slab) {
+	if (Spare) {
+		::operator delete(slab);
+	} else {
+		Spare = slab;
+	}
+}
+
+class SizeClass {
+public:
+	void *allocate(std::size_t blockSize);
+	void deallocate(void *pointer);
+
+	std::size_t slabs() const;
+	std::size_t used() const;
+
+private:
+	Slab &available(std::size_t blockSize);
+	std::vector<Slab>::iterator find(void *pointer);
+
+	// Sorted by address, so that a block finds its slab by binary search.
+	std::vector<Slab> _slabs;
+	std::size_t _available = 0;
+	std::size_t _used = 0;
+
+};
+
+void *SizeClass::allocate(std::size_t blockSize) {
+	auto &slab = available(blockSize);
+	const auto result = slab.free;
+	slab.free = result->next;
+	++slab.used;
+	++_used;
+	return result;
+}
+
+void SizeClass::deallocate(void *pointer) {
+	const auto i = find(pointer);
+	const auto block = static_cast<FreeBlock*>(pointer);
+	block->next = i->free;
+	i->free = block;
+	--_used;
+	if (!--i->used) {
+		PutSlab(i->data);
+		_slabs.erase(i);
+		_available = 0;
+	} else {
+		_available = std::size_t(i - begin(_slabs));
+	}
+}
+
+std::size_t SizeClass::slabs() const {
+	return _slabs.size();
+}
+
+std::size_t SizeClass::used() const {
+	return _used;
+}
+
+Slab &SizeClass::available(std::size_t blockSize) {
+	if (_available < _slabs.size() && _slabs[_available].free) {
+		return _slabs[_available];
+	}
+	for (auto i = begin(_slabs); i != end(_slabs); ++i) {
+		if (i->free) {
+			_available = std::size_t(i - begin(_slabs));
+			return *i;
+		}
+	}
+	auto slab = Slab();
+	slab.data = TakeSlab();
+
+	// Keep the free list in address order, it is allocated sequentially.
+	for (auto i = kSlabSize / blockSize; i != 0;) {
+		const auto block = reinterpret_cast<FreeBlock*>(
+			slab.data + (--i) * blockSize);
+		block->next = slab.free;
+		slab.free = block;
+	}
+	const auto i = std::upper_bound(
+		begin(_slabs),
+		end(_slabs),
+		slab.data,
+		[](char *data, const Slab &slab) {
+			return std::less<>()(data, slab.data);
+		});
+	_available = std::size_t(i - begin(_slabs));
+	return *_slabs.insert(i, slab);
+}
+
+std::vector<Slab>::iterator SizeClass::find(void *pointer) {
+	const auto data = static_cast<char*>(pointer);
+	const auto i = std::upper_bound(
+		begin(_slabs),
+		end(_slabs),
+		data,
+		[](char *data, const Slab &slab) {
+			return std::less<>()(data, slab.data);
+		});
+	return i - 1;
+}
+
+// Leaked, so that objects destroyed at exit still find their class.
+std::array<SizeClass, kSlabClasses> &Classes() {
+	static const auto result = new std::array<SizeClass, kSlabClasses>();
+	return *result;
+}
+
+std::size_t ClassIndex(std::size_t size) {
+	return (size + kSlabAlignment - 1) / kSlabAlignment - 1;
+}
+
+} // namespace
+
+void *slab_allocate(std::size_t size) {
+	if (!size || size > kSlabMaxBlock) {
+		return ::operator new(size);
+	}
+	const auto index = ClassIndex(size);
+	return Classes()[index].allocate((index + 1) * kSlabAlignment);
+}
+
+void slab_deallocate(void *pointer, std::size_t size) {
+	if (!pointer) {
+		return;
+	} else if (!size || size > kSlabMaxBlock) {
+		::operator delete(pointer);
+		return;
+	}
+	Classes()[ClassIndex(size)].deallocate(pointer);
+}
+
+} // namespace details
+
+slab_stats current_slab_stats() {
+	auto result = slab_stats();
+	for (const auto &sizeClass : details::Classes()) {
+		result.slabs += sizeClass.slabs();
+		result.blocks += sizeClass.used();
+	}
+	return result;
+}
+
+} // namespace base
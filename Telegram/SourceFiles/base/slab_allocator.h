@@ -0,0 +1,42 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include <cstddef>
+
+namespace base {
+namespace details {
+
+void *slab_allocate(std::size_t size);
+void slab_deallocate(void *pointer, std::size_t size);
+
+} // namespace details
+
+// Blocks up to 1 KB are carved from 64 KB slabs with a free list for each
+// 16 bytes size class. Each slab is released as soon as all its blocks
+// are freed, one empty slab is kept for reuse. Main thread only, not
+// thread-safe.
+class slab_allocated {
+public:
+	static void *operator new(std::size_t size) {
+		return details::slab_allocate(size);
+	}
+
+	// Classes with virtual destructors receive the complete object size.
+	static void operator delete(void *pointer, std::size_t size) {
+		details::slab_deallocate(pointer, size);
+	}
+
+};
+
+struct slab_stats {
+	std::size_t slabs = 0;
+	std::size_t blocks = 0;
+};
+slab_stats current_slab_stats();
+
+} // namespace base
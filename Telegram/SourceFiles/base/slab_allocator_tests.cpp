@@ -0,0 +1,95 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "base/slab_allocator.h"
+#include <memory>
+#include <vector>
+
+namespace {
+
+int Destroyed = 0;
+
+struct Base : base::slab_allocated {
+	virtual ~Base() {
+		++Destroyed;
+	}
+	int value = 0;
+};
+
+struct Derived : Base {
+	char payload[200] = { 0 };
+};
+
+struct Large : base::slab_allocated {
+	char payload[4096] = { 0 };
+};
+
+} // namespace
+
+TEST_CASE("slab allocated objects", "[slab_allocator]") {
+	Destroyed = 0;
+	REQUIRE(base::current_slab_stats().blocks == 0);
+
+	SECTION("blocks are reused and slabs released with the last block") {
+		auto first = std::make_unique<Base>();
+		REQUIRE(base::current_slab_stats().slabs == 1);
+		first = nullptr;
+		REQUIRE(base::current_slab_stats().slabs == 0);
+
+		auto objects = std::vector<std::unique_ptr<Base>>();
+		for (auto i = 0; i != 1000; ++i) {
+			objects.push_back(std::make_unique<Base>());
+			objects.back()->value = i;
+		}
+		REQUIRE(base::current_slab_stats().blocks == 1000);
+		REQUIRE(base::current_slab_stats().slabs > 0);
+		for (auto i = 0; i != 1000; ++i) {
+			REQUIRE(objects[i]->value == i);
+		}
+		const auto freed = objects[10].get();
+		objects.erase(begin(objects) + 10);
+		auto another = std::make_unique<Base>();
+		REQUIRE(another.get() == freed);
+		objects.clear();
+		another = nullptr;
+		REQUIRE(base::current_slab_stats().blocks == 0);
+		REQUIRE(base::current_slab_stats().slabs == 0);
+		REQUIRE(Destroyed == 1002);
+	}
+	SECTION("derived objects are freed to their own size class") {
+		auto objects = std::vector<std::unique_ptr<Base>>();
+		objects.push_back(std::make_unique<Base>());
+		objects.push_back(std::make_unique<Derived>());
+		REQUIRE(base::current_slab_stats().slabs == 2);
+		objects.clear();
+		REQUIRE(base::current_slab_stats().slabs == 0);
+		REQUIRE(Destroyed == 2);
+	}
+	SECTION("empty slabs are released while others are in use") {
+		auto objects = std::vector<std::unique_ptr<Base>>();
+		for (auto i = 0; i != 1000; ++i) {
+			objects.push_back(std::make_unique<Derived>());
+		}
+		REQUIRE(base::current_slab_stats().slabs > 2);
+
+		// Only the slab of the surviving item stays allocated.
+		objects.erase(begin(objects), end(objects) - 1);
+		REQUIRE(base::current_slab_stats().blocks == 1);
+		REQUIRE(base::current_slab_stats().slabs == 1);
+
+		objects.push_back(std::make_unique<Derived>());
+		REQUIRE(base::current_slab_stats().slabs == 1);
+		objects.clear();
+		REQUIRE(base::current_slab_stats().slabs == 0);
+		REQUIRE(Destroyed == 1001);
+	}
+	SECTION("large objects go to the heap") {
+		auto large = std::make_unique<Large>();
+		REQUIRE(base::current_slab_stats().blocks == 0);
+	}
+}
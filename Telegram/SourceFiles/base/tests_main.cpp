@@ -7,7 +7,9 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
 #include "reporters/catch_reporter_compact.hpp"
+#include "base/benchmark.h"
 #include <QFile>
+#include <vector>
 
 int (*TestForkedMethod)()/* = nullptr*/;
 
@@ -82,22 +84,36 @@ namespace Catch {
 
 int main(int argc, const char *argv[]) {
 	auto touchFile = QString();
+	auto jsonFile = QString();
+	auto arguments = std::vector<const char*>();
 	for (auto i = 0; i != argc; ++i) {
 		if (argv[i] == QString("--touch") && i + 1 != argc) {
 			touchFile = QFile::decodeName(argv[++i]);
+		} else if (argv[i] == QString("--json") && i + 1 != argc) {
+			jsonFile = QFile::decodeName(argv[++i]);
 		} else if (argv[i] == QString("--forked") && TestForkedMethod) {
 			return TestForkedMethod();
+		} else if (i > 0) {
+			// Test names or tags, like "[.benchmark]".
+			arguments.push_back(argv[i]);
 		}
 	}
-	const char *catch_argv[] = {
+	auto catch_argv = std::vector<const char*>{
 		argv[0],
 		touchFile.isEmpty() ? "-b" : "-r",
 		touchFile.isEmpty() ? "-b" : "minimal" };
-	constexpr auto catch_argc = sizeof(catch_argv) / sizeof(catch_argv[0]);
-	auto result = Catch::Session().run(catch_argc, catch_argv);
+	catch_argv.insert(end(catch_argv), begin(arguments), end(arguments));
+	const auto catch_argc = int(catch_argv.size());
+	auto result = Catch::Session().run(catch_argc, catch_argv.data());
+	if (!jsonFile.isEmpty()) {
+		const auto path = QFile::encodeName(jsonFile).toStdString();
+		if (!base::benchmark::WriteJson(path)) {
+			std::cout << "Could not write " << path << std::endl;
+			result = 1;
+		}
+	}
 	if (result == 0 && !touchFile.isEmpty()) {
 		QFile(touchFile).open(QIODevice::WriteOnly);
 	}
 	return (result < 0xff ? result : 0xff);
 }
-
@@ -11,13 +11,146 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 namespace base {
 namespace {
 
+// Coarse timers longer than that are coalesced in TimerWheel.
+constexpr auto kCoalesceMinTimeout = crl::time(1000);
+
+// Marks a timer scheduled in TimerWheel instead of QObject::startTimer.
+constexpr auto kCoalescedTimerId = -1;
+
 QObject *TimersAdjuster() {
 	static QObject adjuster;
 	return &adjuster;
 }
 
+// Deadlines are rounded up to a grid that gets coarser for longer
+// timeouts, so timers started at close moments fire together.
+crl::time CoalescedDeadline(crl::time now, crl::time timeout) {
+	const auto granularity = (timeout < 10 * 1000)
+		? crl::time(100)
+		: (timeout < 60 * 1000)
+		? crl::time(500)
+		: crl::time(1000);
+	const auto deadline = now + timeout;
+	return ((deadline + granularity - 1) / granularity) * granularity;
+}
+
 } // namespace
 
+namespace details {
+
+// All coarse timers of a thread share a single system timer, which is
+// started for the nearest deadline only.
+class TimerWheel final : public QObject {
+public:
+	TimerWheel();
+	~TimerWheel();
+
+	static not_null<TimerWheel*> Instance();
+
+	void add(not_null<Timer*> timer, crl::time bucket);
+	void remove(not_null<Timer*> timer, crl::time bucket);
+
+protected:
+	void timerEvent(QTimerEvent *e) override;
+
+private:
+	void rearm(bool force = false);
+
+	base::flat_map<crl::time, std::vector<not_null<Timer*>>> _buckets;
+	crl::time _armedFor = 0;
+	int _timerId = 0;
+
+};
+
+TimerWheel::TimerWheel() {
+	connect(
+		TimersAdjuster(),
+		&QObject::destroyed,
+		this,
+		[this] { rearm(true); },
+		Qt::QueuedConnection);
+}
+
+TimerWheel::~TimerWheel() {
+	for (const auto &[bucket, timers] : _buckets) {
+		for (const auto timer : timers) {
+			timer->_timerId = 0;
+			timer->_wheel = nullptr;
+		}
+	}
+}
+
+not_null<TimerWheel*> TimerWheel::Instance() {
+	thread_local const auto result = std::make_unique<TimerWheel>();
+	return result.get();
+}
+
+void TimerWheel::add(not_null<Timer*> timer, crl::time bucket) {
+	_buckets[bucket].push_back(timer);
+	rearm();
+}
+
+void TimerWheel::remove(not_null<Timer*> timer, crl::time bucket) {
+	const auto i = _buckets.find(bucket);
+	if (i == _buckets.end()) {
+		return;
+	}
+	auto &timers = i->second;
+	timers.erase(
+		std::remove(timers.begin(), timers.end(), timer),
+		timers.end());
+	if (timers.empty()) {
+		_buckets.erase(i);
+		rearm();
+	}
+}
+
+void TimerWheel::rearm(bool force) {
+	if (_buckets.empty()) {
+		if (_timerId) {
+			killTimer(base::take(_timerId));
+		}
+		return;
+	}
+	const auto bucket = _buckets.front().first;
+	if (_timerId && _armedFor == bucket && !force) {
+		return;
+	} else if (_timerId) {
+		killTimer(base::take(_timerId));
+	}
+	const auto now = crl::now();
+	const auto timeout = std::max(bucket - now, crl::time(0));
+	_armedFor = bucket;
+	_timerId = startTimer(
+		static_cast<int>(std::min(
+			timeout,
+			crl::time(std::numeric_limits<int>::max()))),
+		Qt::PreciseTimer);
+}
+
+void TimerWheel::timerEvent(QTimerEvent *e) {
+	killTimer(base::take(_timerId));
+
+	// Take timers one by one, because each callback may cancel,
+	// restart or destroy other timers of the same bucket.
+	const auto now = crl::now();
+	while (!_buckets.empty() && _buckets.front().first <= now) {
+		const auto i = _buckets.begin();
+		auto &timers = i->second;
+		const auto timer = timers.back();
+		timers.pop_back();
+		if (timers.empty()) {
+			_buckets.erase(i);
+		}
+		timer->_timerId = 0;
+		timer->_wheel = nullptr;
+		timer->coalescedTimeout();
+	}
+	rearm();
+}
+
+} // namespace details
+
 Timer::Timer(
 	not_null<QThread*> thread,
 	Fn<void()> callback)
@@ -39,6 +172,10 @@ Timer::Timer(Fn<void()> callback)
 		Qt::QueuedConnection);
 }
 
+Timer::~Timer() {
+	cancel();
+}
+
 void Timer::start(crl::time timeout, Qt::TimerType type, Repeat repeat) {
 	cancel();
 
@@ -46,6 +183,15 @@ void Timer::start(crl::time timeout, Qt::TimerType type, Repeat repeat) {
 	setRepeat(repeat);
 	_adjusted = false;
 	setTimeout(timeout);
+	if (_type != Qt::PreciseTimer && _timeout > kCoalesceMinTimeout) {
+		const auto now = crl::now();
+		_next = now + _timeout;
+		_bucket = CoalescedDeadline(now, _timeout);
+		_timerId = kCoalescedTimerId;
+		_wheel = details::TimerWheel::Instance();
+		_wheel->add(this, _bucket);
+		return;
+	}
 	_timerId = startTimer(_timeout, _type);
 	if (_timerId) {
 		_next = crl::now() + _timeout;
@@ -55,7 +201,10 @@ void Timer::start(crl::time timeout, Qt::TimerType type, Repeat repeat) {
 }
 
 void Timer::cancel() {
-	if (isActive()) {
+	if (_timerId == kCoalescedTimerId) {
+		_timerId = 0;
+		base::take(_wheel)->remove(this, _bucket);
+	} else if (isActive()) {
 		killTimer(base::take(_timerId));
 	}
 }
@@ -78,6 +227,10 @@ void Timer::Adjust() {
 }
 
 void Timer::adjust() {
+	if (_timerId == kCoalescedTimerId) {
+		// TimerWheel restarts its own system timer.
+		return;
+	}
 	auto remaining = remainingTime();
 	if (remaining >= 0) {
 		cancel();
@@ -112,6 +265,18 @@ void Timer::timerEvent(QTimerEvent *e) {
 	}
 }
 
+void Timer::coalescedTimeout() {
+	Expects(_timerId == 0);
+
+	if (repeat() == Repeat::Interval) {
+		start(_timeout, _type, repeat());
+	}
+
+	if (_callback) {
+		_callback();
+	}
+}
+
 int DelayedCallTimer::call(
 		crl::time timeout,
 		FnMut<void()> callback,
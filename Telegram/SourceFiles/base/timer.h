@@ -12,6 +12,9 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "base/flat_map.h"
 
 namespace base {
+namespace details {
+class TimerWheel;
+} // namespace details
 
 class Timer final : private QObject {
 public:
@@ -19,6 +22,7 @@ public:
 		not_null<QThread*> thread,
 		Fn<void()> callback = nullptr);
 	explicit Timer(Fn<void()> callback = nullptr);
+	~Timer();
 
 	static Qt::TimerType DefaultType(crl::time timeout) {
 		constexpr auto kThreshold = crl::time(1000);
@@ -58,12 +62,15 @@ protected:
 	void timerEvent(QTimerEvent *e) override;
 
 private:
+	friend class details::TimerWheel;
+
 	enum class Repeat : unsigned {
 		Interval   = 0,
 		SingleShot = 1,
 	};
 	void start(crl::time timeout, Qt::TimerType type, Repeat repeat);
 	void adjust();
+	void coalescedTimeout();
 
 	void setTimeout(crl::time timeout);
 	int timeout() const;
@@ -77,6 +84,11 @@ private:
 
 	Fn<void()> _callback;
 	crl::time _next = 0;
+
+	// Coarse timers share one system timer per thread, see TimerWheel.
+	details::TimerWheel *_wheel = nullptr;
+	crl::time _bucket = 0;
+
 	int _timeout = 0;
 	int _timerId = 0;
 
@@ -8,6 +8,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include <atomic>
 #include <memory>
+#include <new>
+#include <utility>
 
 namespace base {
 
@@ -15,14 +17,85 @@ class has_weak_ptr;
 
 namespace details {
 
+// Trackers are recycled through a small per thread pool, so taking the
+// first weak pointer of an object doesn't hit the heap in steady state.
+// A tracker freed on another thread just goes to that thread's pool.
+class alive_tracker_pool {
+public:
+	static constexpr auto kMaxCached = 256;
+
+	~alive_tracker_pool() {
+		finished() = true;
+		while (_first) {
+			::operator delete(std::exchange(_first, _first->next));
+		}
+	}
+
+	static void *take(std::size_t size) {
+		if (!finished()) {
+			auto &pool = instance();
+			if (const auto result = pool._first) {
+				pool._first = result->next;
+				--pool._count;
+				return result;
+			}
+		}
+		return ::operator new(size);
+	}
+	static void put(void *pointer) {
+		if (!finished()) {
+			auto &pool = instance();
+			if (pool._count < kMaxCached) {
+				pool._first = new (pointer) node{ pool._first };
+				++pool._count;
+				return;
+			}
+		}
+		::operator delete(pointer);
+	}
+	static int cached() {
+		return finished() ? 0 : instance()._count;
+	}
+
+private:
+	struct node {
+		node *next = nullptr;
+	};
+
+	static alive_tracker_pool &instance() {
+		static thread_local alive_tracker_pool result;
+		return result;
+	}
+
+	// Trivially destructible, so it is still valid while the other
+	// thread_local and static objects are destroyed on thread exit.
+	static bool &finished() {
+		static thread_local bool result = false;
+		return result;
+	}
+
+	node *_first = nullptr;
+	int _count = 0;
+
+};
+
 struct alive_tracker {
 	explicit alive_tracker(const has_weak_ptr *value) : value(value) {
 	}
 
+	static void *operator new(std::size_t size) {
+		return alive_tracker_pool::take(size);
+	}
+	static void operator delete(void *pointer) {
+		alive_tracker_pool::put(pointer);
+	}
+
 	std::atomic<int> counter = 1;
 	std::atomic<const has_weak_ptr*> value;
 };
 
+static_assert(sizeof(alive_tracker) >= sizeof(void*));
+
 inline alive_tracker *check_and_increment(alive_tracker *tracker) noexcept {
 	if (tracker) {
 		++tracker->counter;
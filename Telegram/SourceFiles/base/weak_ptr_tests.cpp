@@ -0,0 +1,113 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include <gsl/gsl>
+#include "base/weak_ptr.h"
+#include "base/benchmark.h"
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr auto kBenchmarkObjects = 1000;
+constexpr auto kBenchmarkCallbacks = 100;
+
+struct Guarded : base::has_weak_ptr {
+	int value = 0;
+};
+
+using Pool = base::details::alive_tracker_pool;
+
+} // namespace
+
+TEST_CASE("weak pointers", "[weak_ptr]") {
+	SECTION("weak pointers expire with the object") {
+		auto object = std::make_unique<Guarded>();
+		object->value = 42;
+		const auto weak = base::make_weak(object.get());
+		const auto copy = weak;
+		REQUIRE(weak.get() == object.get());
+		REQUIRE(copy->value == 42);
+		object = nullptr;
+		REQUIRE(weak == nullptr);
+		REQUIRE(copy == nullptr);
+	}
+
+	SECTION("invalidate_weak_ptrs expires existing pointers only") {
+		auto object = Guarded();
+		const auto weak = base::make_weak(&object);
+		invalidate_weak_ptrs(&object);
+		REQUIRE(weak == nullptr);
+		const auto another = base::make_weak(&object);
+		REQUIRE(another.get() == &object);
+	}
+
+	SECTION("trackers are reused") {
+		{
+			auto object = Guarded();
+			const auto weak = base::make_weak(&object);
+		}
+		const auto cached = Pool::cached();
+		REQUIRE(cached > 0);
+		auto object = Guarded();
+		const auto weak = base::make_weak(&object);
+		REQUIRE(Pool::cached() == cached - 1);
+	}
+
+	SECTION("trackers can be released on another thread") {
+		auto object = std::make_unique<Guarded>();
+		auto weak = base::make_weak(object.get());
+		object = nullptr;
+		auto expired = false;
+		std::thread([&expired, weak = std::move(weak)]() mutable {
+			expired = (weak == nullptr);
+			weak = nullptr;
+		}).join();
+		REQUIRE(expired);
+	}
+}
+
+TEST_CASE("guarded callbacks benchmark", "[.benchmark]") {
+	using namespace base::benchmark;
+
+	auto objects = std::vector<std::unique_ptr<Guarded>>();
+	auto callbacks = std::vector<std::function<void()>>();
+	objects.reserve(kBenchmarkObjects);
+	callbacks.reserve(kBenchmarkObjects * kBenchmarkCallbacks);
+
+	auto called = 0;
+	auto options = Options();
+	options.warmup = 1;
+	options.repetitions = 10;
+	const auto name = "guarded callbacks create and call";
+	const auto result = Run(name, options, [&] {
+		for (auto i = 0; i != kBenchmarkObjects; ++i) {
+			objects.push_back(std::make_unique<Guarded>());
+			const auto raw = objects.back().get();
+			for (auto j = 0; j != kBenchmarkCallbacks; ++j) {
+				callbacks.push_back([&called, weak = base::make_weak(raw)] {
+					if (const auto strong = weak.get()) {
+						++strong->value;
+						++called;
+					}
+				});
+			}
+		}
+		for (const auto &callback : callbacks) {
+			callback();
+		}
+		callbacks.clear();
+		objects.clear();
+	});
+
+	const auto rounds = options.warmup + options.repetitions;
+	REQUIRE(called == rounds * kBenchmarkObjects * kBenchmarkCallbacks);
+	WARN(Format(result));
+}
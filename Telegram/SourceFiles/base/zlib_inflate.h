@@ -0,0 +1,94 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/bytes.h"
+#include "zlib.h"
+
+namespace zlib {
+namespace details {
+
+// Deflate can't compress better than that.
+constexpr auto kMaxGzipRatio = 1032;
+
+} // namespace details
+
+// Unpacked size from the gzip trailer (modulo 2^32), zero if unknown.
+inline uint32 GzipUnpackedSize(bytes::const_span packed) {
+	if (packed.size() < 18) {
+		return 0;
+	}
+	const auto trailer = packed.data() + packed.size() - 4;
+	return uint32(uchar(trailer[0]))
+		| (uint32(uchar(trailer[1])) << 8)
+		| (uint32(uchar(trailer[2])) << 16)
+		| (uint32(uchar(trailer[3])) << 24);
+}
+
+// Inflates a gzip stream straight into the result buffer of any
+// QVector-like type. The buffer is resized once to fit the size from
+// the gzip trailer and grows only if the trailer lies, so there is no
+// intermediate buffer and no reallocation for well-formed data.
+//
+// Returns Z_STREAM_END on success or a zlib error code, Z_DATA_ERROR
+// also when the stream is truncated or the unpacked size is not
+// a multiple of the buffer element size.
+template <typename Buffer>
+int Ungzip(bytes::const_span packed, Buffer &result) {
+	using Element = std::decay_t<decltype(result[0])>;
+	constexpr auto kElementSize = int64(sizeof(Element));
+
+	const auto trailerSize = int64(GzipUnpackedSize(packed));
+	const auto packedSize = int64(packed.size());
+	const auto guess = (trailerSize > 0
+		&& trailerSize <= packedSize * details::kMaxGzipRatio)
+		? trailerSize
+		: (packedSize * 4);
+
+	auto stream = z_stream();
+	auto code = inflateInit2(&stream, 16 + MAX_WBITS);
+	if (code != Z_OK) {
+		return code;
+	}
+	stream.avail_in = uInt(packed.size());
+	stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<bytes::type*>(packed.data()));
+
+	// One extra element lets us see the stream end without growing.
+	auto capacity = (guess + kElementSize - 1) / kElementSize + 1;
+	auto written = int64(0);
+	result.resize(capacity);
+	while (true) {
+		const auto available = capacity * kElementSize - written;
+		stream.next_out = reinterpret_cast<Bytef*>(result.data()) + written;
+		stream.avail_out = uInt(available);
+		code = inflate(&stream, Z_NO_FLUSH);
+		written += available - int64(stream.avail_out);
+		if (code == Z_STREAM_END) {
+			break;
+		} else if (code == Z_BUF_ERROR && stream.avail_out > 0) {
+			code = Z_DATA_ERROR;
+		}
+		if (code != Z_OK && code != Z_BUF_ERROR) {
+			inflateEnd(&stream);
+			result.clear();
+			return code;
+		} else if (!stream.avail_out) {
+			capacity *= 2;
+			result.resize(capacity);
+		}
+	}
+	inflateEnd(&stream);
+	if (written % kElementSize) {
+		result.clear();
+		return Z_DATA_ERROR;
+	}
+	result.resize(written / kElementSize);
+	return Z_STREAM_END;
+}
+
+} // namespace zlib
@@ -1,10 +1,5 @@
 #include "abstractremotefile.h"
-#include "bettergramservice.h"
-
-#include <QTimer>
-#include <QtNetwork/QNetworkAccessManager>
-#include <QtNetwork/QNetworkRequest>
-#include <QtNetwork/QNetworkReply>
+#include "remotefilecache.h"
 
 namespace Bettergram {
 
@@ -43,7 +38,13 @@ void AbstractRemoteFile::setLink(const QUrl &link)
 		_link = link;
 
 		stopDownloadLaterTimer();
-		download();
+
+		if (_isDownloadOnDemand) {
+			resetData();
+		} else {
+			download();
+		}
+
 		emit linkChanged();
 	}
 }
@@ -63,6 +64,16 @@ bool AbstractRemoteFile::isNeedToDownload() const
 	return customIsNeedToDownload();
 }
 
+bool AbstractRemoteFile::isDownloadOnDemand() const
+{
+	return _isDownloadOnDemand;
+}
+
+void AbstractRemoteFile::setIsDownloadOnDemand(bool isDownloadOnDemand)
+{
+	_isDownloadOnDemand = isDownloadOnDemand;
+}
+
 void AbstractRemoteFile::downloadIfNeeded()
 {
 	if (isNeedToDownload()) {
@@ -73,10 +84,10 @@ void AbstractRemoteFile::downloadIfNeeded()
 void AbstractRemoteFile::forceDownload()
 {
 	stopDownloadLaterTimer();
-	download();
+	download(false);
 }
 
-void AbstractRemoteFile::download()
+void AbstractRemoteFile::download(bool isUseCache)
 {
 	if (!_link.isValid()) {
 		resetData();
@@ -93,30 +104,37 @@ void AbstractRemoteFile::download()
 
 	_isDownloading = true;
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
-	QNetworkRequest request;
-	request.setUrl(_link);
+	const QUrl link = _link;
+	const RemoteFileCache::CachePolicy cachePolicy = !isUseDiskCache()
+			? RemoteFileCache::CachePolicy::None
+			: isUseCache
+			  ? RemoteFileCache::CachePolicy::Use
+			  : RemoteFileCache::CachePolicy::Refresh;
 
-	QNetworkReply *reply = networkManager->get(request);
-
-	connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+	RemoteFileCache::instance()->get(link, cachePolicy, this,
+									 [this, link](const RemoteFileCache::Result &result) {
 		_isDownloading = false;
 
-		if(reply->error() == QNetworkReply::NoError) {
+		if (link != _link) {
+			// The link is changed while we were downloading the previous one
+			download();
+			return;
+		}
+
+		if (result.error == QNetworkReply::NoError) {
 			_failedCount = 0;
-			dataDownloaded(reply->readAll());
-			_lastDownloadTime = QDateTime::currentDateTime();
+			dataDownloaded(result.data);
+			_lastDownloadTime = result.downloadTime;
 			emit downloaded();
 		} else {
 			LOG(("Can not download file at %1. %2 (%3)")
 				.arg(_link.toString())
-				.arg(reply->errorString())
-				.arg(reply->error()));
+				.arg(result.errorString)
+				.arg(result.error));
 
 			// If the file does not exist on the server then
 			// there is no any reason to try download it soon
-			if (reply->error() == QNetworkReply::ContentNotFoundError) {
+			if (result.error == QNetworkReply::ContentNotFoundError) {
 				_failedCount = 10000;
 			} else {
 				_failedCount++;
@@ -125,36 +143,6 @@ void AbstractRemoteFile::download()
 			downloadLater();
 		}
 	});
-
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
-		reply->deleteLater();
-		networkManager->deleteLater();
-	});
-
-	connect(this, &AbstractRemoteFile::destroyed, networkManager, [networkManager, reply] {
-		reply->deleteLater();
-		networkManager->deleteLater();
-	});
-
-	QTimer::singleShot(BettergramService::networkTimeout(), Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply, this] {
-		_isDownloading = false;
-		_failedCount++;
-
-		reply->deleteLater();
-		networkManager->deleteLater();
-
-		LOG(("Can not download file at %1 due timeout")
-			.arg(_link.toString()));
-
-		downloadLater();
-	});
-
-	connect(reply, &QNetworkReply::sslErrors, this, [](QList<QSslError> errors) {
-		for(const QSslError &error : errors) {
-			LOG(("%1").arg(error.errorString()));
-		}
-	});
 }
 
 void AbstractRemoteFile::timerEvent(QTimerEvent *timerEvent)
@@ -192,4 +180,9 @@ bool AbstractRemoteFile::checkLink(const QUrl &link)
 	return true;
 }
 
+bool AbstractRemoteFile::isUseDiskCache() const
+{
+	return true;
+}
+
 } // namespace Bettergrams
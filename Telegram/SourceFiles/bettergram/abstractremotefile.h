@@ -25,6 +25,11 @@ public:
 
 	bool isNeedToDownload() const;
 
+	/// If it is true then the file is not downloaded when the link is set,
+	/// the owner calls downloadIfNeeded() when the file is really needed
+	bool isDownloadOnDemand() const;
+	void setIsDownloadOnDemand(bool isDownloadOnDemand);
+
 	void downloadIfNeeded();
 	void forceDownload();
 
@@ -41,7 +46,12 @@ protected:
 
 	virtual bool checkLink(const QUrl &link);
 
-	void download();
+	/// Return false if downloaded data should not be stored at the disk cache
+	virtual bool isUseDiskCache() const;
+
+	/// Get the file from the disk cache if it exists there and isUseCache is true,
+	/// otherwise download it from the link
+	void download(bool isUseCache = true);
 	void stopDownloadLaterTimer();
 
 	void timerEvent(QTimerEvent *timerEvent) override;
@@ -51,6 +61,7 @@ private:
 	QDateTime _lastDownloadTime;
 	int _failedCount = 0;
 	bool _isDownloading = false;
+	bool _isDownloadOnDemand = false;
 	int _downloadLaterTimerId = 0;
 
 	void downloadLater();
@@ -104,6 +104,21 @@ QPixmap BaseArticlePreviewItem::image() const
 	return _image.image();
 }
 
+void BaseArticlePreviewItem::preloadImage()
+{
+	_image.downloadIfNeeded();
+}
+
+void BaseArticlePreviewItem::setIsImageDownloadOnDemand(bool isDownloadOnDemand)
+{
+	_image.setIsDownloadOnDemand(isDownloadOnDemand);
+}
+
+const QUrl &BaseArticlePreviewItem::imageLink() const
+{
+	return _image.link();
+}
+
 void BaseArticlePreviewItem::setImageLink(const QUrl &url)
 {
 	_image.setLink(url);
@@ -181,18 +196,23 @@ void BaseArticlePreviewItem::load(QSettings &settings)
 	setIsRead(settings.value("isRead").toBool());
 }
 
-void BaseArticlePreviewItem::save(QSettings &settings)
+void BaseArticlePreviewItem::load(QDataStream &stream)
 {
-	settings.setValue("title", title());
-	settings.setValue("description", description());
+	QDateTime publishDate;
+	QUrl imageLink;
+	bool isRead = false;
 
-	// We have to save QUrl as QString due bug on macOS
-	settings.setValue("link", link().toString());
+	stream >> _title >> _description >> _link >> publishDate >> imageLink >> isRead;
 
-	settings.setValue("publishDate", publishDate());
-	settings.setValue("imageLink", _image.link().toString());
+	setPublishDate(publishDate);
+	_image.setLink(imageLink);
 
-	settings.setValue("isRead", isRead());
+	setIsRead(isRead);
+}
+
+void BaseArticlePreviewItem::save(QDataStream &stream) const
+{
+	stream << _title << _description << _link << _publishDate << _image.link() << _isRead;
 }
 
 } // namespace Bettergram
@@ -41,6 +41,10 @@ public:
 
 	virtual QPixmap image() const;
 
+	/// Start downloading the image if it is not downloaded yet.
+	/// Views call it for visible and nearly visible items only.
+	virtual void preloadImage();
+
 	/// Return true if user marks this news as read
 	bool isRead() const;
 	void markAsRead();
@@ -61,15 +65,20 @@ protected:
 	void setDescription(const QString &description);
 	void setLink(const QUrl &link);
 	void setPublishDate(const QDateTime &publishDate);
+	const QUrl &imageLink() const;
 	void setImageLink(const QUrl &url);
 
+	/// Do not download the image until preloadImage() is called
+	void setIsImageDownloadOnDemand(bool isDownloadOnDemand);
+
 	bool isImageLinkValid() const;
 
 	bool equalsToBaseItem(const QSharedPointer<BaseArticlePreviewItem> &item);
 	void updateBaseItem(const QSharedPointer<BaseArticlePreviewItem> &item);
 
 	void load(QSettings &settings);
-	void save(QSettings &settings);
+	void load(QDataStream &stream);
+	void save(QDataStream &stream) const;
 
 private:
 	QString _title;
@@ -6,11 +6,14 @@
 #include "resourcegrouplist.h"
 #include "pinnednewslist.h"
 #include "aditem.h"
+#include "refreshscheduler.h"
+#include "networkmetrics.h"
 
 #include <auth_session.h>
 #include <mainwidget.h>
 #include <settings.h>
 #include <core/update_checker.h>
+#include <core/startup_trace.h>
 #include <core/click_handler_types.h>
 #include <lang/lang_keys.h>
 #include <platform/platform_specific.h>
@@ -19,7 +22,6 @@
 
 #include <QCoreApplication>
 #include <QTimer>
-#include <QTimerEvent>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QtNetwork/QNetworkAccessManager>
@@ -55,6 +57,9 @@ const int BettergramService::_updateVideoChannelListPeriod = 2 * 60 * 60 * 1000;
 // We display deprecated API messages no more than once per 2 hours
 const int BettergramService::_deprecatedApiMessagePeriod = 2 * 60 * 60 * 1000;
 
+// We fetch no more than 4 RSS and Video feeds at the same time
+const int BettergramService::_maxParallelFeedsFetching = 4;
+
 BettergramService *BettergramService::init()
 {
 	return instance();
@@ -63,6 +68,7 @@ BettergramService *BettergramService::init()
 BettergramService *BettergramService::instance()
 {
 	if (!_instance) {
+		const auto trace = Core::StartupTrace::Scope("BettergramService::init");
 		new BettergramService(nullptr);
 	}
 
@@ -74,6 +80,13 @@ int BettergramService::networkTimeout()
 	return _networkTimeout;
 }
 
+QNetworkAccessManager *BettergramService::networkManager()
+{
+	static const auto result = new QNetworkAccessManager(QCoreApplication::instance());
+
+	return result;
+}
+
 const QString &BettergramService::defaultLastUpdateString()
 {
 	return _defaultLastUpdateString;
@@ -119,26 +132,22 @@ void BettergramService::sendStatUrl(UrlSource urlSource, const QUrl &targetUrl)
 
 	QUrl url(QStringLiteral("https://api.bettergram.io/v1/links_stat?").arg(urlQuery.toString()));
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
 
 	//	connect(reply, &QNetworkReply::finished, this, [] {
 	//		// Do nothing here
 	//	});
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout * 2, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout * 2, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not send link stat"));
 	});
@@ -182,10 +191,15 @@ Bettergram::BettergramService::BettergramService(QObject *parent) :
 	_videoChannelList(new RssChannelList(RssChannelList::NewsType::Videos, this)),
 	_resourceGroupList(new ResourceGroupList(this)),
 	_pinnedNewsList(new PinnedNewsList(this)),
-	_currentAd(new AdItem(this))
+	_currentAd(new AdItem(this)),
+	_refreshScheduler(new RefreshScheduler(this)),
+	_networkMetrics(new NetworkMetrics(this))
 {
 	_instance = this;
 
+	_networkMetrics->setIsEnabled(QSettings(bettergramSettingsPath(), QSettings::IniFormat)
+								  .value("isNetworkMetricsEnabled").toBool());
+
 	getIsPaid();
 	getNextAd(true);
 
@@ -244,20 +258,30 @@ Bettergram::BettergramService::BettergramService(QObject *parent) :
 
 	getCryptoPriceNames();
 
-	_updateCryptoPriceNamesTimerId = startTimer(_updateCryptoPriceNamesPeriod, Qt::VeryCoarseTimer);
-	_saveCryptoPricesTimerId = startTimer(_saveCryptoPricesPeriod, Qt::VeryCoarseTimer);
+	// All periodic jobs share the same scheduler, so they wake the application up together
+	_refreshScheduler->add(_updateCryptoPriceNamesPeriod, RefreshScheduler::Activity::SlowWhenInactive,
+						   this, [this] { getCryptoPriceNames(); });
+
+	_refreshScheduler->add(_saveCryptoPricesPeriod, RefreshScheduler::Activity::Always,
+						   this, [this] { _cryptoPriceList->save(); });
 
-	_updateRssChannelListTimerId = startTimer(_updateRssChannelListPeriod, Qt::VeryCoarseTimer);
-	_updateVideoChannelListTimerId = startTimer(_updateVideoChannelListPeriod, Qt::VeryCoarseTimer);
+	_refreshScheduler->add(_updateRssChannelListPeriod, RefreshScheduler::Activity::SlowWhenInactive,
+						   this, [this] { getRssChannelList(); });
 
-	_everyDayTimerId = startTimer(24 * 60 * 60 * 1000, Qt::VeryCoarseTimer);
+	_refreshScheduler->add(_updateVideoChannelListPeriod, RefreshScheduler::Activity::SlowWhenInactive,
+						   this, [this] { getVideoChannelList(); });
 
-	connect(qApp, &QCoreApplication::aboutToQuit, this, [this] { _cryptoPriceList->save(); });
+	_refreshScheduler->add(24 * 60 * 60 * 1000, RefreshScheduler::Activity::Always,
+						   this, [this] { everyDayActions(); });
+
+	// The application is about to quit, so we can not write the file out of the main thread
+	connect(qApp, &QCoreApplication::aboutToQuit, this, [this] { _cryptoPriceList->save(false); });
 
 	QTimer::singleShot(_checkForFirstUpdatesDelay, Qt::VeryCoarseTimer,
 					   this, [] { checkForNewUpdates(); });
 
-	_checkForUpdatesTimerId = startTimer(_checkForUpdatesPeriod, Qt::VeryCoarseTimer);
+	_refreshScheduler->add(_checkForUpdatesPeriod, RefreshScheduler::Activity::Always,
+						   this, [] { checkForNewUpdates(); });
 
 	Platform::RegisterCustomScheme();
 
@@ -377,6 +401,23 @@ AdItem *BettergramService::currentAd() const
 	return _currentAd;
 }
 
+RefreshScheduler *BettergramService::refreshScheduler() const
+{
+	return _refreshScheduler;
+}
+
+NetworkMetrics *BettergramService::networkMetrics() const
+{
+	return _networkMetrics;
+}
+
+void BettergramService::setIsNetworkMetricsEnabled(bool isEnabled)
+{
+	_networkMetrics->setIsEnabled(isEnabled);
+
+	QSettings(bettergramSettingsPath(), QSettings::IniFormat).setValue("isNetworkMetricsEnabled", isEnabled);
+}
+
 bool BettergramService::isWindowActive() const
 {
 	return _isWindowActive;
@@ -386,6 +427,7 @@ void BettergramService::setIsWindowActive(bool isWindowActive)
 {
 	if (_isWindowActive != isWindowActive) {
 		_isWindowActive = isWindowActive;
+		_refreshScheduler->setIsActive(_isWindowActive);
 
 		if (_isWindowActiveHandler) {
 			_isWindowActiveHandler();
@@ -433,6 +475,11 @@ QString BettergramService::settingsPath(const QString &name) const
 	return settingsDirPath() + name + QStringLiteral(".ini");
 }
 
+QString BettergramService::dataPath(const QString &name) const
+{
+	return settingsDirPath() + name + QStringLiteral(".dat");
+}
+
 QString BettergramService::bettergramSettingsPath() const
 {
 	return settingsPath(QStringLiteral("bettergram"));
@@ -448,6 +495,11 @@ QString BettergramService::pricesCacheSettingsPath() const
 	return pricesCacheDirPath() + QStringLiteral("prices.ini");
 }
 
+QString BettergramService::pricesCacheDataPath() const
+{
+	return pricesCacheDirPath() + QStringLiteral("prices.dat");
+}
+
 void BettergramService::getIsPaid()
 {
 	//TODO: bettergram: ask server and get know if the instance is paid or not and the current billing plan.
@@ -458,25 +510,22 @@ void BettergramService::getCryptoPriceNames()
 {
 	QUrl url(QStringLiteral("https://%1.livecoinwatch.com/currencies").arg(_pricesUrlPrefix));
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::CryptoPriceNames);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetCryptoPriceNamesFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get crypto price names due timeout"));
 	});
@@ -563,18 +612,22 @@ void BettergramService::searchCryptoPriceNames()
 		return;
 	}
 
+	// We ask the server only if we do not know all crypto price names yet
+	if (_cryptoPriceList->searchLocally()) {
+		return;
+	}
+
 	const QString searchText = _cryptoPriceList->searchText();
 
 	const QUrl url(QStringLiteral("https://%1.livecoinwatch.com/currencies?search=%2&type=coin")
 				   .arg(_pricesUrlPrefix)
 				   .arg(searchText));
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::CryptoPriceSearch);
 
 	connect(reply, &QNetworkReply::finished, this, [this, url, searchText, reply] {
 		if (isApiDeprecated(reply)) {
@@ -584,7 +637,9 @@ void BettergramService::searchCryptoPriceNames()
 		if(reply->error() == QNetworkReply::NoError) {
 			// We parse the response only if the search text is the same
 			if (_cryptoPriceList->searchText() == searchText) {
-				_cryptoPriceList->parseSearchNames(reply->readAll());
+				_networkMetrics->measureParsing(NetworkMetrics::Endpoint::CryptoPriceSearch, [this, reply] {
+					_cryptoPriceList->parseSearchNames(reply->readAll());
+				});
 			}
 		} else {
 			LOG(("Can not search crypto price values. Search text: '%1'. %2 (%3)")
@@ -594,15 +649,13 @@ void BettergramService::searchCryptoPriceNames()
 		}
 	});
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply, searchText]() {
+	connect(reply, &QNetworkReply::finished, [reply, searchText]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply, searchText] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply, searchText] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not search crypto price values due timeout. Search text: '%1'").arg(searchText));
 	});
@@ -617,12 +670,11 @@ void BettergramService::getCryptoPriceValues(const QUrl &url)
 		return;
 	}
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::CryptoPriceValues);
 
 	connect(reply, &QNetworkReply::finished, this, [this, url, reply] {
 		if (isApiDeprecated(reply)) {
@@ -630,7 +682,9 @@ void BettergramService::getCryptoPriceValues(const QUrl &url)
 		}
 
 		if(reply->error() == QNetworkReply::NoError) {
-			_cryptoPriceList->parseValues(reply->readAll(), url);
+			_networkMetrics->measureParsing(NetworkMetrics::Endpoint::CryptoPriceValues, [this, reply, url] {
+				_cryptoPriceList->parseValues(reply->readAll(), url);
+			});
 
 			if (_cryptoPriceList->mayFetchStats()) {
 				getCryptoPriceStats();
@@ -642,15 +696,13 @@ void BettergramService::getCryptoPriceValues(const QUrl &url)
 		}
 	});
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get crypto price values due timeout"));
 	});
@@ -661,12 +713,11 @@ void BettergramService::getCryptoPriceValues(const QUrl &url)
 
 void BettergramService::getCryptoPriceStats()
 {
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(QStringLiteral("https://%1.livecoinwatch.com/stats").arg(_pricesUrlPrefix));
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::CryptoPriceStats);
 
 	connect(reply, &QNetworkReply::finished, this, [this, reply] {
 		if (isApiDeprecated(reply)) {
@@ -674,7 +725,9 @@ void BettergramService::getCryptoPriceStats()
 		}
 
 		if(reply->error() == QNetworkReply::NoError) {
-			_cryptoPriceList->parseStats(reply->readAll());
+			_networkMetrics->measureParsing(NetworkMetrics::Endpoint::CryptoPriceStats, [this, reply] {
+				_cryptoPriceList->parseStats(reply->readAll());
+			});
 		} else {
 			LOG(("Can not get crypto price stats. %1 (%2)")
 				.arg(reply->errorString())
@@ -682,15 +735,13 @@ void BettergramService::getCryptoPriceStats()
 		}
 	});
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get crypto price stats due timeout"));
 	});
@@ -703,35 +754,78 @@ void BettergramService::getRssFeedsContent()
 {
 	for (const QSharedPointer<RssChannel> &channel : *_rssChannelList) {
 		if (channel->isMayFetchNewData()) {
-			getRssFeeds(_rssChannelList, channel);
+			queueRssFeeds(_rssChannelList, channel);
 		}
 	}
+
+	getQueuedRssFeeds();
 }
 
 void BettergramService::getVideoFeedsContent()
 {
 	for (const QSharedPointer<RssChannel> &channel : *_videoChannelList) {
 		if (channel->isMayFetchNewData()) {
-			getRssFeeds(_videoChannelList, channel);
+			queueRssFeeds(_videoChannelList, channel);
 		}
 	}
+
+	getQueuedRssFeeds();
 }
 
-void BettergramService::getRssFeeds(RssChannelList *rssChannelList,
-									const QSharedPointer<RssChannel> &channel)
+void BettergramService::queueRssFeeds(RssChannelList *rssChannelList,
+									  const QSharedPointer<RssChannel> &channel)
 {
+	// We mark the channel as fetching right now,
+	// so the channel list does not parse feeds until all queued channels are fetched
 	channel->startFetching();
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
+	_feedsFetchingQueue.push_back(qMakePair(rssChannelList, channel));
+}
+
+void BettergramService::getQueuedRssFeeds()
+{
+	while (_feedsFetchingCount < _maxParallelFeedsFetching && !_feedsFetchingQueue.isEmpty()) {
+		const QPair<RssChannelList*, QSharedPointer<RssChannel>> item = _feedsFetchingQueue.takeFirst();
 
+		_feedsFetchingCount++;
+		getRssFeeds(item.first, item.second);
+	}
+}
+
+void BettergramService::getRssFeeds(RssChannelList *rssChannelList,
+									const QSharedPointer<RssChannel> &channel)
+{
 	QNetworkRequest request;
 	request.setUrl(channel->feedLink());
 
-	QNetworkReply *reply = networkManager->get(request);
+	// Conditional GET, the server responds with 304 (Not Modified) if the feed is not changed
+	if (!channel->etag().isEmpty()) {
+		request.setRawHeader("If-None-Match", channel->etag());
+	}
 
-	connect(reply, &QNetworkReply::finished, this, [rssChannelList, reply, channel] {
-		if(reply->error() == QNetworkReply::NoError) {
-			channel->fetchingSucceed(reply->readAll());
+	if (!channel->lastModified().isEmpty()) {
+		request.setRawHeader("If-Modified-Since", channel->lastModified());
+	}
+
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, rssChannelList == _videoChannelList
+						   ? NetworkMetrics::Endpoint::VideoFeeds
+						   : NetworkMetrics::Endpoint::RssFeeds);
+
+	connect(reply, &QNetworkReply::finished, this, [this, rssChannelList, reply, channel] {
+		const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+		if (reply->error() == QNetworkReply::NoError && statusCode == 304) {
+			channel->fetchingNotModified();
+		} else if(reply->error() == QNetworkReply::NoError) {
+			_networkMetrics->measureParsing(rssChannelList == _videoChannelList
+											? NetworkMetrics::Endpoint::VideoFeeds
+											: NetworkMetrics::Endpoint::RssFeeds,
+											[reply, channel] {
+				channel->fetchingSucceed(reply->readAll(),
+										 reply->rawHeader("ETag"),
+										 reply->rawHeader("Last-Modified"));
+			});
 		} else {
 			LOG(("Can not get RSS feeds from the channel %1. %2 (%3)")
 				.arg(channel->feedLink().toString())
@@ -742,22 +836,22 @@ void BettergramService::getRssFeeds(RssChannelList *rssChannelList,
 		}
 
 		rssChannelList->parseFeeds();
-	});
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
-		reply->deleteLater();
-		networkManager->deleteLater();
+		_feedsFetchingCount--;
+		getQueuedRssFeeds();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply, channel] {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
+	});
 
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply, channel] {
 		LOG(("Can not get RSS feeds from the channel %1 due timeout")
 			.arg(channel->feedLink().toString()));
 
-		channel->fetchingFailed();
+		// Aborted reply emits finished() signal, so the channel is marked as failed there
+		reply->abort();
 	});
 
 	connect(reply, &QNetworkReply::sslErrors, this, [channel] (QList<QSslError> errors) {
@@ -774,25 +868,22 @@ void BettergramService::getRssChannelList()
 {
 	QUrl url("https://api.bettergram.io/v1/news");
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::RssChannelList);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetRssChannelListFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get RSS channel list due timeout"));
 	});
@@ -804,25 +895,22 @@ void BettergramService::getVideoChannelList()
 {
 	QUrl url("https://api.bettergram.io/v1/videos");
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::VideoChannelList);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetVideoChannelListFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get video channel list due timeout"));
 	});
@@ -834,25 +922,31 @@ void BettergramService::getResourceGroupList()
 {
 	QUrl url("https://api.bettergram.io/v1/resources");
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	// Conditional GET, the server responds with 304 (Not Modified) if the list is not changed
+	if (!_resourceGroupList->etag().isEmpty()) {
+		request.setRawHeader("If-None-Match", _resourceGroupList->etag());
+	}
+
+	if (!_resourceGroupList->lastModified().isEmpty()) {
+		request.setRawHeader("If-Modified-Since", _resourceGroupList->lastModified());
+	}
+
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::ResourceGroupList);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetResourceGroupListFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get resource group list due timeout"));
 	});
@@ -864,25 +958,31 @@ void BettergramService::getPinnedNewsList()
 {
 	QUrl url("https://api.bettergram.io/v1/pinned_news");
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	// Conditional GET, the server responds with 304 (Not Modified) if the list is not changed
+	if (!_pinnedNewsList->etag().isEmpty()) {
+		request.setRawHeader("If-None-Match", _pinnedNewsList->etag());
+	}
+
+	if (!_pinnedNewsList->lastModified().isEmpty()) {
+		request.setRawHeader("If-Modified-Since", _pinnedNewsList->lastModified());
+	}
+
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::PinnedNewsList);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetPinnedNewsListFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		LOG(("Can not get pinned news list due timeout"));
 	});
@@ -899,7 +999,9 @@ void BettergramService::onGetCryptoPriceNamesFinished()
 	}
 
 	if(reply->error() == QNetworkReply::NoError) {
-		_cryptoPriceList->parseNames(reply->readAll());
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::CryptoPriceNames, [this, reply] {
+			_cryptoPriceList->parseNames(reply->readAll());
+		});
 	} else {
 		LOG(("Can not get crypto price names. %1 (%2)")
 			.arg(reply->errorString())
@@ -922,8 +1024,16 @@ void BettergramService::onGetResourceGroupListFinished()
 		return;
 	}
 
-	if(reply->error() == QNetworkReply::NoError) {
-		_resourceGroupList->parse(reply->readAll());
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	if (reply->error() == QNetworkReply::NoError && statusCode == 304) {
+		_resourceGroupList->fetchingNotModified();
+	} else if(reply->error() == QNetworkReply::NoError) {
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::ResourceGroupList, [this, reply] {
+			_resourceGroupList->fetchingSucceed(reply->readAll(),
+												reply->rawHeader("ETag"),
+												reply->rawHeader("Last-Modified"));
+		});
 	} else {
 		LOG(("Can not get resource group list. %1 (%2)")
 			.arg(reply->errorString())
@@ -939,8 +1049,16 @@ void BettergramService::onGetPinnedNewsListFinished()
 		return;
 	}
 
-	if(reply->error() == QNetworkReply::NoError) {
-		_pinnedNewsList->parse(reply->readAll());
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	if (reply->error() == QNetworkReply::NoError && statusCode == 304) {
+		_pinnedNewsList->fetchingNotModified();
+	} else if(reply->error() == QNetworkReply::NoError) {
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::PinnedNewsList, [this, reply] {
+			_pinnedNewsList->fetchingSucceed(reply->readAll(),
+											 reply->rawHeader("ETag"),
+											 reply->rawHeader("Last-Modified"));
+		});
 	} else {
 		LOG(("Can not get pinned news list. %1 (%2)")
 			.arg(reply->errorString())
@@ -957,7 +1075,9 @@ void BettergramService::onGetRssChannelListFinished()
 	}
 
 	if(reply->error() == QNetworkReply::NoError) {
-		_rssChannelList->parseChannelList(reply->readAll());
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::RssChannelList, [this, reply] {
+			_rssChannelList->parseChannelList(reply->readAll());
+		});
 		getRssFeedsContent();
 	} else {
 		LOG(("Can not get rss channel list. %1 (%2)")
@@ -975,7 +1095,9 @@ void BettergramService::onGetVideoChannelListFinished()
 	}
 
 	if(reply->error() == QNetworkReply::NoError) {
-		_videoChannelList->parseChannelList(reply->readAll());
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::VideoChannelList, [this, reply] {
+			_videoChannelList->parseChannelList(reply->readAll());
+		});
 		getVideoFeedsContent();
 	} else {
 		LOG(("Can not get video channel list. %1 (%2)")
@@ -998,30 +1120,26 @@ void BettergramService::getNextAd(bool reset)
 		url += _currentAd->id();
 	}
 
-	QNetworkAccessManager *networkManager = new QNetworkAccessManager();
-
 	QNetworkRequest request;
 	request.setUrl(url);
 
-	QNetworkReply *reply = networkManager->get(request);
+	QNetworkReply *reply = networkManager()->get(request);
+	_networkMetrics->track(reply, NetworkMetrics::Endpoint::Ads);
 
 	connect(reply, &QNetworkReply::finished,
 			this, &BettergramService::onGetNextAdFinished);
 
-	connect(reply, &QNetworkReply::finished, [networkManager, reply]() {
+	connect(reply, &QNetworkReply::finished, [reply]() {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	connect(this, &BettergramService::destroyed, networkManager, [networkManager, reply] {
+	connect(this, &BettergramService::destroyed, reply, [reply] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 	});
 
-	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, networkManager,
-					   [networkManager, reply, this] {
+	QTimer::singleShot(_networkTimeout, Qt::VeryCoarseTimer, reply,
+					   [reply, this] {
 		reply->deleteLater();
-		networkManager->deleteLater();
 
 		getNextAdLater();
 	});
@@ -1129,7 +1247,13 @@ void BettergramService::onGetNextAdFinished()
 	}
 
 	if(reply->error() == QNetworkReply::NoError) {
-		if (parseNextAd(reply->readAll())) {
+		bool isParsed = false;
+
+		_networkMetrics->measureParsing(NetworkMetrics::Endpoint::Ads, [this, reply, &isParsed] {
+			isParsed = parseNextAd(reply->readAll());
+		});
+
+		if (isParsed) {
 			getNextAdLater();
 		} else {
 			// Try to get new ad without previous ad id
@@ -1235,21 +1359,4 @@ void BettergramService::everyDayActions()
 	getResourceGroupList();
 }
 
-void BettergramService::timerEvent(QTimerEvent *timerEvent)
-{
-	if (timerEvent->timerId() == _checkForUpdatesTimerId) {
-		checkForNewUpdates();
-	} else if (timerEvent->timerId() == _updateCryptoPriceNamesTimerId) {
-		getCryptoPriceNames();
-	} else if (timerEvent->timerId() == _saveCryptoPricesTimerId) {
-		_cryptoPriceList->save();
-	} else if (timerEvent->timerId() == _updateRssChannelListTimerId) {
-		getRssChannelList();
-	} else if (timerEvent->timerId() == _updateVideoChannelListTimerId) {
-		getVideoChannelList();
-	} else if (timerEvent->timerId() == _everyDayTimerId) {
-		everyDayActions();
-	}
-}
-
 } // namespace Bettergrams
@@ -7,6 +7,8 @@
 
 #include <functional>
 
+class QNetworkAccessManager;
+
 namespace Bettergram {
 
 class CryptoPriceList;
@@ -15,6 +17,8 @@ class RssChannel;
 class ResourceGroupList;
 class PinnedNewsList;
 class AdItem;
+class RefreshScheduler;
+class NetworkMetrics;
 
 /**
  * @brief The BettergramService class contains Bettergram specific classes and settings
@@ -43,6 +47,12 @@ public:
 
 	static int networkTimeout();
 
+	/**
+	 * @brief Network manager shared by all Bettergram requests of the main thread,
+	 * so the connections to the same host are kept alive and reused between requests
+	 */
+	static QNetworkAccessManager *networkManager();
+
 	static const QString &defaultLastUpdateString();
 	static QString generateLastUpdateString(const QDateTime &dateTime, bool isShowSeconds);
 
@@ -60,6 +70,11 @@ public:
 	ResourceGroupList *resourceGroupList() const;
 	PinnedNewsList *pinnedNewsList() const;
 	AdItem *currentAd() const;
+	RefreshScheduler *refreshScheduler() const;
+	NetworkMetrics *networkMetrics() const;
+
+	/// Network metrics are collected only if the user enables them
+	void setIsNetworkMetricsEnabled(bool isEnabled);
 
 	bool isWindowActive() const;
 	void setIsWindowActive(bool isWindowActive);
@@ -74,9 +89,13 @@ public:
 	QString resourcesCachePath() const;
 	QString settingsPath(const QString &name) const;
 
+	/// Path of a binary file that we use instead of settings files for big lists
+	QString dataPath(const QString &name) const;
+
 	QString bettergramSettingsPath() const;
 	QString pricesSettingsPath() const;
 	QString pricesCacheSettingsPath() const;
+	QString pricesCacheDataPath() const;
 
 	/// Port settings files from the first Bettergram version.
 	/// At the first version of the Bettergram we save settings at the QSettings() instance,
@@ -108,7 +127,6 @@ signals:
 	void needToToggleBettergramTabs();
 
 protected:
-	void timerEvent(QTimerEvent *timerEvent) override;
 
 private:
 	static BettergramService *_instance;
@@ -138,6 +156,9 @@ private:
 	/// We display deprecated API messages no more than once per 2 hours
 	static const int _deprecatedApiMessagePeriod;
 
+	/// We fetch no more than 4 RSS and Video feeds at the same time
+	static const int _maxParallelFeedsFetching;
+
 	bool _isSettingsPorted = false;
 	bool _isPaid = false;
 	BillingPlan _billingPlan = BillingPlan::Unknown;
@@ -148,18 +169,17 @@ private:
 	ResourceGroupList *_resourceGroupList = nullptr;
 	PinnedNewsList *_pinnedNewsList = nullptr;
 	AdItem *_currentAd = nullptr;
-	int _checkForUpdatesTimerId = 0;
-	int _updateCryptoPriceNamesTimerId = 0;
-	int _saveCryptoPricesTimerId = 0;
-	int _updateRssChannelListTimerId = 0;
-	int _updateVideoChannelListTimerId = 0;
-	int _everyDayTimerId = 0;
+	RefreshScheduler *_refreshScheduler = nullptr;
+	NetworkMetrics *_networkMetrics = nullptr;
 	bool _isWindowActive = true;
 	std::function<void()> _isWindowActiveHandler = nullptr;
 
 	QDateTime _lastTimeOfShowingDeprecatedApiMessage = QDateTime();
 	bool _isDeprecatedApiMessageShown = false;
 
+	QList<QPair<RssChannelList*, QSharedPointer<RssChannel>>> _feedsFetchingQueue;
+	int _feedsFetchingCount = 0;
+
 	static void checkForNewUpdates();
 	static void sendStatUrl(UrlSource urlSource, const QUrl &targetUrl);
 	static QString convertUrlSourceToString(UrlSource urlSource);
@@ -203,6 +223,12 @@ private:
 	/// Download and parse all Video feeds
 	void getVideoFeedsContent();
 
+	/// Mark the channel as fetching and add it to the queue of feeds that should be downloaded
+	void queueRssFeeds(RssChannelList *rssChannelList, const QSharedPointer<RssChannel> &channel);
+
+	/// Start downloading queued feeds while there are no more than _maxParallelFeedsFetching of them
+	void getQueuedRssFeeds();
+
 	void getRssFeeds(RssChannelList *rssChannelList, const QSharedPointer<RssChannel> &channel);
 
 	/// Check response for 410 (Gone) HTTP status.
@@ -75,6 +75,7 @@ CryptoPrice::CryptoPrice(const CryptoPrice &price) :
 	_changeFor24HoursString(price._changeFor24HoursString),
 	_minuteDirection(price._minuteDirection),
 	_dayDirection(price._dayDirection),
+	_priceHistory(price._priceHistory),
 	_isFavorite(price._isFavorite)
 {
 	connect(_icon.data(), &RemoteImage::imageChanged, this, &CryptoPrice::iconChanged);
@@ -92,6 +93,9 @@ CryptoPrice &CryptoPrice::operator=(const CryptoPrice &price)
 	setMinuteDirection(price._minuteDirection);
 	setIsFavorite(price._isFavorite, false);
 
+	_priceHistory = price._priceHistory;
+	emit priceHistoryChanged();
+
 	return *this;
 }
 
@@ -275,6 +279,17 @@ void CryptoPrice::setDayDirection(Direction dayDirection)
 	}
 }
 
+const CryptoPriceHistory &CryptoPrice::priceHistory() const
+{
+	return _priceHistory;
+}
+
+void CryptoPrice::addPriceToHistory(double price)
+{
+	_priceHistory.add(price, QDateTime::currentMSecsSinceEpoch() / 1000);
+	emit priceHistoryChanged();
+}
+
 bool CryptoPrice::isFavorite() const
 {
 	return _isFavorite;
@@ -320,11 +335,17 @@ void CryptoPrice::loadIsFavorite()
 
 	settings.beginGroup(QStringLiteral("favorites"));
 
-	setIsFavorite(settings.value(nameAndShortName(), false).toBool());
+	loadIsFavorite(settings);
 
 	settings.endGroup();
 }
 
+void CryptoPrice::loadIsFavorite(const QSettings &favorites)
+{
+	// The value is read from settings, so we do not need to write it back
+	setIsFavorite(favorites.value(nameAndShortName(), false).toBool(), false);
+}
+
 bool CryptoPrice::isEmpty() const
 {
 	return !_url.isValid() || !_icon->link().isValid() || _name.isEmpty() || _shortName.isEmpty();
@@ -360,28 +381,15 @@ void CryptoPrice::forceDownloadIcon()
 	_icon->forceDownload();
 }
 
-void CryptoPrice::save(QSettings &settings) const
+void CryptoPrice::save(QDataStream &stream) const
 {
-	settings.setValue("link", url().toString());
-	settings.setValue("iconLink", iconUrl().toString());
-	settings.setValue("iconLastDownloadTime", _icon->lastDownloadTime());
-	settings.setValue("name", name());
-	settings.setValue("code", shortName());
-	settings.setValue("rank", rank());
-
-	if (currentPrice()) {
-		settings.setValue("price", *currentPrice());
-	} else {
-		settings.remove("price");
-	}
+	stream << _url << iconUrl() << _icon->lastDownloadTime() << _name << _shortName << qint32(_rank);
 
-	if (changeFor24Hours()) {
-		settings.setValue("changeForDay", *changeFor24Hours());
-	} else {
-		settings.remove("changeForDay");
-	}
+	stream << bool(_currentPrice) << _currentPrice.value_or(0.0);
+	stream << bool(_changeFor24Hours) << _changeFor24Hours.value_or(0.0);
+	stream << qint32(_minuteDirection);
 
-	settings.setValue("minuteDirection", static_cast<int>(minuteDirection()));
+	_priceHistory.save(stream);
 
 	saveIcon();
 }
@@ -404,6 +412,10 @@ void CryptoPrice::saveIcon() const
 		return;
 	}
 
+	if (_savedIconDownloadTime.isValid() && _savedIconDownloadTime == _icon->lastDownloadTime()) {
+		return;
+	}
+
 	if (!QDir().mkpath(BettergramService::instance()->pricesIconsCacheDirPath())) {
 		LOG(("Unable to create directories at the path %1")
 			.arg(BettergramService::instance()->pricesIconsCacheDirPath()));
@@ -416,7 +428,10 @@ void CryptoPrice::saveIcon() const
 			.arg(_name)
 			.arg(_shortName)
 			.arg(fileName));
+		return;
 	}
+
+	_savedIconDownloadTime = _icon->lastDownloadTime();
 }
 
 QSharedPointer<CryptoPrice> CryptoPrice::load(const QSettings &settings)
@@ -490,6 +505,62 @@ QSharedPointer<CryptoPrice> CryptoPrice::load(const QSettings &settings)
 	return cryptoPrice;
 }
 
+QSharedPointer<CryptoPrice> CryptoPrice::load(QDataStream &stream, bool hasPriceHistory)
+{
+	QUrl url;
+	QUrl iconUrl;
+	QDateTime iconLastDownloadTime;
+	QString name;
+	QString shortName;
+	qint32 rank = 0;
+	bool hasPrice = false;
+	double price = 0.0;
+	bool hasChangeFor24Hours = false;
+	double changeFor24Hours = 0.0;
+	qint32 minuteDirection = 0;
+
+	stream >> url >> iconUrl >> iconLastDownloadTime >> name >> shortName >> rank
+		   >> hasPrice >> price >> hasChangeFor24Hours >> changeFor24Hours >> minuteDirection;
+
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("Unable to read crypto price"));
+		return QSharedPointer<CryptoPrice>(nullptr);
+	}
+
+	if (name.isEmpty() || shortName.isEmpty() || url.isEmpty() || iconUrl.isEmpty()) {
+		LOG(("Crypto price %1 (%2) is empty").arg(name).arg(shortName));
+		return QSharedPointer<CryptoPrice>(nullptr);
+	}
+
+	switch (minuteDirection) {
+	case(static_cast<int>(Direction::Up)):
+	case(static_cast<int>(Direction::Down)):
+		break;
+	default:
+		minuteDirection = static_cast<int>(Direction::None);
+	}
+
+	QSharedPointer<CryptoPrice> cryptoPrice(
+				new CryptoPrice(url,
+								iconUrl,
+								name,
+								shortName,
+								rank,
+								hasPrice ? std::make_optional(price) : std::nullopt,
+								hasChangeFor24Hours ? std::make_optional(changeFor24Hours) : std::nullopt,
+								static_cast<Direction>(minuteDirection),
+								false));
+
+	if (hasPriceHistory && !cryptoPrice->_priceHistory.load(stream)) {
+		LOG(("Unable to read price history of crypto price %1 (%2)").arg(name).arg(shortName));
+		return QSharedPointer<CryptoPrice>(nullptr);
+	}
+
+	cryptoPrice->loadIcon(iconLastDownloadTime);
+
+	return cryptoPrice;
+}
+
 void CryptoPrice::loadIcon(const QDateTime &lastDownloadTime)
 {
 	if (_name.isEmpty() && _shortName.isEmpty()) {
@@ -524,6 +595,8 @@ void CryptoPrice::loadIcon(const QDateTime &lastDownloadTime)
 
 	_icon->setImage(icon);
 	_icon->setLastDownloadTime(lastDownloadTime);
+
+	_savedIconDownloadTime = lastDownloadTime;
 }
 
 CryptoPrice::Direction CryptoPrice::countDirection(const std::optional<double> &value)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "cryptopricehistory.h"
+
 #include <QObject>
 
 namespace Bettergram {
@@ -23,6 +25,7 @@ public:
 	};
 
 	static QSharedPointer<CryptoPrice> load(const QSettings &settings);
+	static QSharedPointer<CryptoPrice> load(QDataStream &stream, bool hasPriceHistory);
 	static Direction countDirection(const std::optional<double> &value);
 
 	explicit CryptoPrice(const QUrl &url,
@@ -67,10 +70,18 @@ public:
 
 	Direction dayDirection() const;
 
+	const CryptoPriceHistory &priceHistory() const;
+
+	/// We call it only for values received from the server, not for copied ones
+	void addPriceToHistory(double price);
+
 	bool isFavorite() const;
 	void toggleIsFavorite();
 	void loadIsFavorite();
 
+	/// Load favorite state from already opened settings, we use it to open settings only once
+	void loadIsFavorite(const QSettings &favorites);
+
 	bool isEmpty() const;
 
 	void updateData(const CryptoPrice &price);
@@ -79,7 +90,7 @@ public:
 	void downloadIconIfNeeded();
 	void forceDownloadIcon();
 
-	void save(QSettings &settings) const;
+	void save(QDataStream &stream) const;
 
 public slots:
 
@@ -95,6 +106,8 @@ signals:
 
 	void isFavoriteChanged();
 
+	void priceHistoryChanged();
+
 	/// We emit this signal only when external class calls toggleIsFavorite() method
 	void isFavoriteToggled();
 
@@ -130,8 +143,15 @@ private:
 	Direction _minuteDirection = Direction::None;
 	Direction _dayDirection = Direction::None;
 
+	/// Prices for the latest 24 hours, we draw them as a sparkline
+	CryptoPriceHistory _priceHistory;
+
 	bool _isFavorite = false;
 
+	/// Download time of the icon that is saved to the icons cache directory,
+	/// we do not encode and write the same icon again at each save
+	mutable QDateTime _savedIconDownloadTime;
+
 	void setUrl(const QUrl &url);
 	void setIcon(const QSharedPointer<RemoteImage> &icon);
 	void setIconUrl(const QUrl &iconUrl);
@@ -0,0 +1,123 @@
+#include "cryptopricehistory.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+
+namespace Bettergram {
+
+const qint64 CryptoPriceHistory::_samplingIntervalInSeconds = 15 * 60;
+
+bool CryptoPriceHistory::isEmpty() const
+{
+	return _size == 0;
+}
+
+int CryptoPriceHistory::size() const
+{
+	return _size;
+}
+
+float CryptoPriceHistory::at(int index) const
+{
+	return _values[(_first + index) % capacity];
+}
+
+float CryptoPriceHistory::min() const
+{
+	float result = _size ? at(0) : 0.0f;
+
+	for (int i = 1; i < _size; ++i) {
+		result = std::min(result, at(i));
+	}
+
+	return result;
+}
+
+float CryptoPriceHistory::max() const
+{
+	float result = _size ? at(0) : 0.0f;
+
+	for (int i = 1; i < _size; ++i) {
+		result = std::max(result, at(i));
+	}
+
+	return result;
+}
+
+int CryptoPriceHistory::version() const
+{
+	return _version;
+}
+
+void CryptoPriceHistory::add(double price, qint64 time)
+{
+	if (_size && time - _lastSampleTime >= capacity * _samplingIntervalInSeconds) {
+		// The gap is longer than the whole buffer, old values make no sense anymore
+		clear();
+	}
+
+	if (_size && time - _lastSampleTime < _samplingIntervalInSeconds) {
+		// We keep only the latest value for the current interval
+		_values[(_first + _size - 1) % capacity] = float(price);
+	} else {
+		if (_size < capacity) {
+			_values[(_first + _size) % capacity] = float(price);
+			_size++;
+		} else {
+			_values[_first] = float(price);
+			_first = (_first + 1) % capacity;
+		}
+
+		_lastSampleTime = time;
+	}
+
+	_version++;
+}
+
+void CryptoPriceHistory::clear()
+{
+	_first = 0;
+	_size = 0;
+	_lastSampleTime = 0;
+	_version++;
+}
+
+void CryptoPriceHistory::save(QDataStream &stream) const
+{
+	stream << qint64(_lastSampleTime) << qint32(_size);
+
+	for (int i = 0; i < _size; ++i) {
+		stream << at(i);
+	}
+}
+
+bool CryptoPriceHistory::load(QDataStream &stream)
+{
+	qint64 lastSampleTime = 0;
+	qint32 size = 0;
+
+	stream >> lastSampleTime >> size;
+
+	if (stream.status() != QDataStream::Ok || size < 0 || size > capacity) {
+		return false;
+	}
+
+	clear();
+
+	for (qint32 i = 0; i < size; ++i) {
+		stream >> _values[i];
+	}
+
+	if (stream.status() != QDataStream::Ok) {
+		clear();
+		return false;
+	}
+
+	_size = size;
+	_lastSampleTime = lastSampleTime;
+
+	return true;
+}
+
+} // namespace Bettergram
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+class QDataStream;
+
+namespace Bettergram {
+
+/**
+ * @brief The CryptoPriceHistory class keeps the latest prices of one cryptocurrency
+ * in a fixed-capacity ring buffer, one value per sampling interval.
+ * It is filled only from the values we already poll, so it does not need any extra requests.
+ */
+class CryptoPriceHistory {
+public:
+	/// 96 values with 15 minutes interval cover the latest 24 hours
+	static constexpr int capacity = 96;
+
+	static const qint64 _samplingIntervalInSeconds;
+
+	bool isEmpty() const;
+	int size() const;
+
+	/// Values are indexed from the oldest one to the newest one
+	float at(int index) const;
+
+	float min() const;
+	float max() const;
+
+	/// It is changed after each update, so painters can check if their cache is outdated
+	int version() const;
+
+	void add(double price, qint64 time);
+	void clear();
+
+	void save(QDataStream &stream) const;
+	bool load(QDataStream &stream);
+
+private:
+	std::array<float, capacity> _values = { { 0.0f } };
+	int _first = 0;
+	int _size = 0;
+	qint64 _lastSampleTime = 0;
+	int _version = 0;
+};
+
+} // namespace Bettergram
@@ -4,14 +4,23 @@
 #include <bettergram/bettergramservice.h>
 #include <logs.h>
 
+#include <QDataStream>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSaveFile>
 
 namespace Bettergram {
 
 const int CryptoPriceList::_defaultFreq = 60;
 const int CryptoPriceList::_minimumSearchText = 2;
 
+// "BGPC", Bettergram prices cache
+const quint32 CryptoPriceList::_dataMagic = 0x42475043;
+const qint32 CryptoPriceList::_dataVersion = 2;
+
+QMutex CryptoPriceList::_saveMutex;
+std::atomic<int> CryptoPriceList::_lastSaveId = 0;
+
 const QString &CryptoPriceList::getSortString(SortOrder sortOrder)
 {
 	static const QString rank = QStringLiteral("rank");
@@ -223,6 +232,8 @@ void CryptoPriceList::addPrivate(const QSharedPointer<CryptoPrice> &price)
 			this, &CryptoPriceList::onIsFavoriteToggled);
 
 	_list.push_back(price);
+	_listIndex.insert(indexKey(price->name(), price->shortName()), price);
+	_isSearchIndexDirty = true;
 }
 
 QSharedPointer<CryptoPrice> CryptoPriceList::at(int index) const
@@ -404,6 +415,26 @@ void CryptoPriceList::parseNames(const QByteArray &byteArray)
 		return;
 	}
 
+	// The full list of names is big, so it is parsed out of the main thread
+	const int parseId = ++_namesParseId;
+
+	crl::async([=] {
+		const crl::time started = crl::now();
+		std::optional<QList<ParsedName>> names = parseNamesData(byteArray);
+
+		DEBUG_LOG(("Crypto price names parsed in %1 ms").arg(crl::now() - started));
+
+		crl::on_main(this, [=, names = std::move(names)] {
+			if (parseId == _namesParseId && names) {
+				applyNames(*names);
+			}
+		});
+	});
+}
+
+std::optional<QList<CryptoPriceList::ParsedName>> CryptoPriceList::parseNamesData(
+		const QByteArray &byteArray)
+{
 	QJsonParseError parseError;
 	QJsonDocument doc = QJsonDocument::fromJson(byteArray, &parseError);
 
@@ -412,14 +443,14 @@ void CryptoPriceList::parseNames(const QByteArray &byteArray)
 			.arg(parseError.errorString())
 			.arg(parseError.error)
 			.arg(QString::fromUtf8(byteArray)));
-		return;
+		return std::nullopt;
 	}
 
 	QJsonObject json = doc.object();
 
 	if (json.isEmpty()) {
 		LOG(("Can not get crypto price names. Response is emtpy or wrong"));
-		return;
+		return std::nullopt;
 	}
 
 	bool success = json.value("success").toBool();
@@ -427,7 +458,7 @@ void CryptoPriceList::parseNames(const QByteArray &byteArray)
 	if (!success) {
 		QString errorMessage = json.value("message").toString("Unknown error");
 		LOG(("Can not get crypto price names. %1").arg(errorMessage));
-		return;
+		return std::nullopt;
 	}
 
 	QString coinsUrlBase = json.value("coinsUrlBase").toString();
@@ -439,11 +470,10 @@ void CryptoPriceList::parseNames(const QByteArray &byteArray)
 
 	if (priceListJson.isEmpty()) {
 		LOG(("Can not get crypto price names. The 'data' list is empty"));
-		return;
+		return std::nullopt;
 	}
 
-	QList<CryptoPrice> priceList;
-	bool isAdded = false;
+	QList<ParsedName> result;
 
 	for (QJsonValue jsonValue : priceListJson) {
 		QJsonObject priceJson = jsonValue.toObject();
@@ -490,17 +520,26 @@ void CryptoPriceList::parseNames(const QByteArray &byteArray)
 			iconUrl = coinsIconBase + iconUrl;
 		}
 
-		CryptoPrice cryptoPrice(url, iconUrl, name, shortName, false);
+		result.push_back({ QUrl(url), QUrl(iconUrl), name, shortName });
+	}
 
-		priceList.push_back(cryptoPrice);
+	return result;
+}
 
-		isAdded = true;
+void CryptoPriceList::applyNames(const QList<ParsedName> &names)
+{
+	QList<CryptoPrice> priceList;
+
+	for (const ParsedName &name : names) {
+		CryptoPrice cryptoPrice(name.url, name.iconUrl, name.name, name.shortName, false);
+
+		priceList.push_back(cryptoPrice);
 	}
 
 	mergeCryptoPriceList(priceList);
 	updateFavoriteList();
 
-	if (!_list.isEmpty() && isAdded) {
+	if (!_list.isEmpty() && !names.isEmpty()) {
 		setAreNamesFetched(true);
 	}
 
@@ -638,9 +677,133 @@ void CryptoPriceList::parseSearchNames(const QByteArray &byteArray)
 	}
 }
 
+QString CryptoPriceList::searchIndexKey(const CryptoPrice &price)
+{
+	// Search text is trimmed, so it never matches across the separator
+	return price.shortName().toLower() + QLatin1Char('\n') + price.name().toLower();
+}
+
+void CryptoPriceList::updateSearchIndex()
+{
+	if (!_isSearchIndexDirty) {
+		return;
+	}
+
+	_isSearchIndexDirty = false;
+
+	_searchIndexKeys.clear();
+	_searchIndexTrigrams.clear();
+	_searchIndexKeys.reserve(_list.size());
+
+	for (int i = 0; i < _list.size(); ++i) {
+		const QString key = searchIndexKey(*_list.at(i));
+
+		for (int j = 0; j + 3 <= key.size(); ++j) {
+			QVector<int> &positions = _searchIndexTrigrams[key.mid(j, 3)];
+
+			if (positions.isEmpty() || positions.back() != i) {
+				positions.push_back(i);
+			}
+		}
+
+		_searchIndexKeys.push_back(key);
+	}
+}
+
+bool CryptoPriceList::searchLocally()
+{
+	// We know all prices after their names are fetched, otherwise the server may know more
+	if (!isSearching() || !_areNamesFetched) {
+		return false;
+	}
+
+	updateSearchIndex();
+
+	const QString text = _searchText.toLower();
+
+	// Only keys that contain the rarest three characters of the text may contain the whole text
+	const QVector<int> *candidates = nullptr;
+	bool isNothingFound = false;
+
+	for (int j = 0; j + 3 <= text.size(); ++j) {
+		const auto it = _searchIndexTrigrams.constFind(text.mid(j, 3));
+
+		if (it == _searchIndexTrigrams.constEnd()) {
+			isNothingFound = true;
+			break;
+		}
+
+		if (!candidates || it->size() < candidates->size()) {
+			candidates = &*it;
+		}
+	}
+
+	// Exact short names go first, then prefixes of short names and names, then other matches
+	QList<QPair<int, int>> found;
+
+	const auto check = [&](int index) {
+		const QString &key = _searchIndexKeys.at(index);
+		const int position = key.indexOf(text);
+
+		if (position < 0) {
+			return;
+		}
+
+		const int separator = key.indexOf(QLatin1Char('\n'));
+		int match = 3;
+
+		if (position == 0) {
+			match = (text.size() == separator) ? 0 : 1;
+		} else if (position == separator + 1) {
+			match = 2;
+		}
+
+		found.push_back(qMakePair(match, index));
+	};
+
+	if (candidates) {
+		for (int index : *candidates) {
+			check(index);
+		}
+	} else if (!isNothingFound) {
+		for (int index = 0; index < _searchIndexKeys.size(); ++index) {
+			check(index);
+		}
+	}
+
+	std::stable_sort(found.begin(), found.end(), [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+		if (a.first != b.first) {
+			return a.first < b.first;
+		}
+
+		// Prices without rank go after ranked ones
+		const int rankA = _list.at(a.second)->rank();
+		const int rankB = _list.at(b.second)->rank();
+
+		return (rankA > 0 && rankB > 0) ? (rankA < rankB) : (rankA > rankB);
+	});
+
+	_searchList.clear();
+
+	for (const QPair<int, int> &item : found) {
+		_searchList.push_back(_list.at(item.second));
+	}
+
+	_isSearchInProgress = false;
+
+	if (_searchList.isEmpty()) {
+		searchResultsAreEmpty();
+	} else {
+		emit searchNamesUpdated();
+	}
+
+	return true;
+}
+
 void CryptoPriceList::searchResultsAreEmpty()
 {
 	_isSearchInProgress = false;
+	forgetLastValues();
 	emit valuesUpdated(QUrl(), QList<QSharedPointer<CryptoPrice>>());
 }
 
@@ -651,6 +814,12 @@ void CryptoPriceList::parseValues(const QByteArray &byteArray, const QUrl &url)
 		return;
 	}
 
+	if (url == _lastValuesUrl && byteArray == _lastValuesResponse) {
+		setLastUpdate(QDateTime::currentDateTime());
+		emit valuesUpdated(url, _lastValuesPrices);
+		return;
+	}
+
 	QJsonParseError parseError;
 	QJsonDocument doc = QJsonDocument::fromJson(byteArray, &parseError);
 
@@ -691,10 +860,21 @@ void CryptoPriceList::parseValues(const QByteArray &byteArray, const QUrl &url)
 		price->downloadIconIfNeeded();
 	}
 
+	_lastValuesUrl = url;
+	_lastValuesResponse = byteArray;
+	_lastValuesPrices = prices;
+
 	setLastUpdate(QDateTime::currentDateTime());
 	emit valuesUpdated(url, prices);
 }
 
+void CryptoPriceList::forgetLastValues()
+{
+	_lastValuesUrl = QUrl();
+	_lastValuesResponse = QByteArray();
+	_lastValuesPrices.clear();
+}
+
 void CryptoPriceList::parseStats(const QByteArray &byteArray)
 {
 	if (byteArray.isEmpty()) {
@@ -747,6 +927,7 @@ void CryptoPriceList::parseStats(const QByteArray &byteArray)
 
 void CryptoPriceList::emptyValues()
 {
+	forgetLastValues();
 	emit valuesUpdated(QUrl(), QList<QSharedPointer<CryptoPrice>>());
 }
 
@@ -811,6 +992,11 @@ QList<QSharedPointer<CryptoPrice>> CryptoPriceList::parsePriceListValues(const Q
 
 		price->setRank(rank);
 		price->setCurrentPrice(currentPrice);
+
+		if (currentPrice) {
+			price->addPriceToHistory(*currentPrice);
+		}
+
 		price->setChangeFor24Hours(changeFor24Hours);
 		price->setMinuteDirection(CryptoPrice::countDirection(changeForMinute));
 
@@ -828,48 +1014,140 @@ QList<QSharedPointer<CryptoPrice>> CryptoPriceList::parsePriceListValues(const Q
 	return prices;
 }
 
-void CryptoPriceList::save() const
+void CryptoPriceList::save(bool isAsync) const
 {
-	QSettings settings(BettergramService::instance()->pricesCacheSettingsPath(), QSettings::IniFormat);
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
 
-	settings.beginGroup("metadata");
+	stream << _dataMagic << _dataVersion;
+	stream << bool(_marketCap) << _marketCap.value_or(0.0);
+	stream << bool(_btcDominance) << _btcDominance.value_or(0.0);
+	stream << _lastUpdate << _isShowOnlyFavorites << qint32(_freq);
+	stream << qint32(_list.size());
 
-	if (marketCap()) {
-		settings.setValue("marketCap", *marketCap());
-	} else {
-		settings.remove("marketCap");
+	for (const QSharedPointer<CryptoPrice> &price : _list) {
+		price->save(stream);
 	}
 
-	if (btcDominance()) {
-		settings.setValue("btcDominance", *btcDominance());
+	// The service is main thread only, so the paths are got here
+	const QString path = BettergramService::instance()->pricesCacheDataPath();
+	const QString oldPath = BettergramService::instance()->pricesCacheSettingsPath();
+	const int saveId = ++_lastSaveId;
+
+	if (isAsync) {
+		crl::async([=] {
+			writeData(path, oldPath, data, saveId);
+		});
 	} else {
-		settings.remove("btcDominance");
+		writeData(path, oldPath, data, saveId);
 	}
+}
 
-	settings.setValue("lastUpdate", lastUpdate());
-	settings.setValue("isShowOnlyFavorites", isShowOnlyFavorites());
+void CryptoPriceList::writeData(const QString &path,
+								const QString &oldPath,
+								const QByteArray &data,
+								int saveId)
+{
+	QMutexLocker lock(&_saveMutex);
 
-	if (freq() == _defaultFreq) {
-		settings.remove("freq");
-	} else {
-		settings.setValue("freq", freq());
+	if (saveId != _lastSaveId) {
+		// There is a newer save, so this data is outdated already
+		return;
 	}
 
-	settings.endGroup();
+	QDir().mkpath(QFileInfo(path).absolutePath());
 
-	settings.beginGroup("prices");
-	settings.beginWriteArray("prices", _list.size());
+	QSaveFile file(path);
 
-	for (int i = 0; i < _list.size(); ++i) {
-		settings.setArrayIndex(i);
-		_list.at(i)->save(settings);
+	if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+		LOG(("Unable to save crypto prices to %1. %2").arg(path).arg(file.errorString()));
+		return;
 	}
 
-	settings.endArray();
-	settings.endGroup();
+	// The binary cache file replaces the old settings file, so we do not need it anymore
+	QFile::remove(oldPath);
 }
 
 void CryptoPriceList::load()
+{
+	if (!loadData()) {
+		loadSettings();
+	}
+
+	updateFavoriteList();
+}
+
+bool CryptoPriceList::loadData()
+{
+	QFile file(BettergramService::instance()->pricesCacheDataPath());
+
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	// We map the file instead of reading it, the stream reads values right from the mapping
+	uchar *mapped = file.map(0, file.size());
+	const QByteArray data = mapped
+			? QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), int(file.size()))
+			: file.readAll();
+
+	QDataStream stream(data);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	quint32 magic = 0;
+	qint32 version = 0;
+
+	stream >> magic >> version;
+
+	// The first version does not contain price history, so we still can read it
+	if (magic != _dataMagic || version < 1 || version > _dataVersion) {
+		LOG(("Unable to load crypto prices, unknown cache file version %1").arg(version));
+		return false;
+	}
+
+	bool hasMarketCap = false;
+	double marketCap = 0.0;
+	bool hasBtcDominance = false;
+	double btcDominance = 0.0;
+	QDateTime lastUpdate;
+	bool isShowOnlyFavorites = false;
+	qint32 freq = 0;
+	qint32 size = 0;
+
+	stream >> hasMarketCap >> marketCap >> hasBtcDominance >> btcDominance
+		   >> lastUpdate >> isShowOnlyFavorites >> freq >> size;
+
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("Unable to load crypto prices, cache file is corrupted"));
+		return false;
+	}
+
+	setMarketCap(hasMarketCap ? std::make_optional(marketCap) : std::nullopt);
+	setBtcDominance(hasBtcDominance ? std::make_optional(btcDominance) : std::nullopt);
+	setFreq(qAbs(freq));
+	setLastUpdate(lastUpdate);
+	setIsShowOnlyFavorites(isShowOnlyFavorites);
+
+	// Favorites are stored at the settings file, so we open it only once for all prices
+	QSettings favorites(BettergramService::instance()->pricesSettingsPath(), QSettings::IniFormat);
+	favorites.beginGroup(QStringLiteral("favorites"));
+
+	for (qint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i) {
+		QSharedPointer<CryptoPrice> price = CryptoPrice::load(stream, version >= 2);
+
+		if (price) {
+			price->loadIsFavorite(favorites);
+			addPrivate(price);
+		}
+	}
+
+	favorites.endGroup();
+
+	return true;
+}
+
+void CryptoPriceList::loadSettings()
 {
 	QSettings settings(BettergramService::instance()->pricesCacheSettingsPath(), QSettings::IniFormat);
 
@@ -908,8 +1186,6 @@ void CryptoPriceList::load()
 
 	settings.endArray();
 	settings.endGroup();
-
-	updateFavoriteList();
 }
 
 void CryptoPriceList::mergeCryptoPriceList(const QList<CryptoPrice> &priceList)
@@ -921,6 +1197,8 @@ void CryptoPriceList::mergeCryptoPriceList(const QList<CryptoPrice> &priceList)
 		if (containsName(priceList, price->name(), price->shortName())) {
 			++it;
 		} else {
+			_listIndex.remove(indexKey(price->name(), price->shortName()));
+			_isSearchIndexDirty = true;
 			it = _list.erase(it);
 		}
 	}
@@ -951,15 +1229,14 @@ QSharedPointer<CryptoPrice> CryptoPriceList::find(const CryptoPrice *pricePointe
 	return QSharedPointer<CryptoPrice>(nullptr);
 }
 
-QSharedPointer<CryptoPrice> CryptoPriceList::findByName(const QString &name, const QString &shortName)
+QString CryptoPriceList::indexKey(const QString &name, const QString &shortName)
 {
-	for (const QSharedPointer<CryptoPrice> &price : _list) {
-		if (price->name() == name && price->shortName() == shortName) {
-			return price;
-		}
-	}
+	return shortName + QChar('\n') + name;
+}
 
-	return QSharedPointer<CryptoPrice>(nullptr);
+QSharedPointer<CryptoPrice> CryptoPriceList::findByName(const QString &name, const QString &shortName)
+{
+	return _listIndex.value(indexKey(name, shortName));
 }
 
 QSharedPointer<CryptoPrice> CryptoPriceList::findByShortName(const QString &shortName)
@@ -1180,7 +1457,7 @@ void CryptoPriceList::addTestData(const QUrl &url,
 								  double changeFor24Hours,
 								  CryptoPrice::Direction minuteDirection)
 {
-	_list.push_back(QSharedPointer<CryptoPrice>(new CryptoPrice(url,
+	addPrivate(QSharedPointer<CryptoPrice>(new CryptoPrice(url,
 												   iconUrl,
 												   name,
 												   shortName,
@@ -1220,6 +1497,8 @@ void CryptoPriceList::onIsFavoriteToggled()
 void CryptoPriceList::clear()
 {
 	_list.clear();
+	_listIndex.clear();
+	_isSearchIndexDirty = true;
 }
 
 } // namespace Bettergrams
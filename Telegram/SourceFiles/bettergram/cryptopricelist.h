@@ -3,6 +3,10 @@
 #include "cryptoprice.h"
 
 #include <QObject>
+#include <QHash>
+#include <QMutex>
+
+#include <atomic>
 
 namespace Bettergram {
 
@@ -77,11 +81,16 @@ public:
 
 	void parseNames(const QByteArray &byteArray);
 	void parseSearchNames(const QByteArray &byteArray);
+
+	/// Search the current search text at names and short names of all known prices.
+	/// Return true if the result is complete, so there is no need to ask the server.
+	bool searchLocally();
 	void parseValues(const QByteArray &byteArray, const QUrl &url);
 	void parseStats(const QByteArray &byteArray);
 	void emptyValues();
 
-	void save() const;
+	/// Save the prices cache, the file is written out of the main thread if isAsync is true
+	void save(bool isAsync = true) const;
 	void load();
 
 	void createTestData();
@@ -109,13 +118,38 @@ private:
 	static const int _defaultFreq;
 	static const int _minimumSearchText;
 
+	/// Header of the binary prices cache file, we change the version when the format is changed
+	static const quint32 _dataMagic;
+	static const qint32 _dataVersion;
+
+	/// The cache file may be written out of the main thread, so only the latest save is written
+	static QMutex _saveMutex;
+	static std::atomic<int> _lastSaveId;
+
 	QList<QSharedPointer<CryptoPrice>> _list;
+
+	/// The same prices as in `_list` by their names, see indexKey()
+	QHash<QString, QSharedPointer<CryptoPrice>> _listIndex;
 	QList<QSharedPointer<CryptoPrice>> _searchList;
 	QList<QSharedPointer<CryptoPrice>> _favoriteList;
 
+	/// Lower case short name and name of each price in `_list`, see searchIndexKey().
+	/// The search index is rebuilt only before a search after `_list` is changed.
+	QStringList _searchIndexKeys;
+
+	/// Positions in `_searchIndexKeys` of the keys that contain each three characters
+	QHash<QString, QVector<int>> _searchIndexTrigrams;
+	bool _isSearchIndexDirty = true;
+
 	/// `total` property from the last response
 	int _lastListValuesTotalCount = 0;
 
+	/// The last values response and its parsed prices,
+	/// a poll that returns the same data is not parsed again
+	QUrl _lastValuesUrl;
+	QByteArray _lastValuesResponse;
+	QList<QSharedPointer<CryptoPrice>> _lastValuesPrices;
+
 	std::optional<double> _marketCap = std::nullopt;
 	QString _marketCapString;
 
@@ -137,6 +171,9 @@ private:
 
 	bool _areNamesFetched = false;
 
+	/// Only the result of the last names response is applied
+	int _namesParseId = 0;
+
 	static const QString &getSortString(SortOrder sortOrder);
 	static const QString &getOrderString(SortOrder sortOrder);
 
@@ -193,15 +230,43 @@ private:
 	void updateFavoriteList();
 
 	void searchResultsAreEmpty();
+	void forgetLastValues();
 
 	void addPrivate(const QSharedPointer<CryptoPrice> &price);
 
 	QSharedPointer<CryptoPrice> find(const CryptoPrice *pricePointer);
+	static QString indexKey(const QString &name, const QString &shortName);
+	static QString searchIndexKey(const CryptoPrice &price);
+
+	void updateSearchIndex();
 	QSharedPointer<CryptoPrice> findByName(const QString &name, const QString &shortName);
 	QSharedPointer<CryptoPrice> findByShortName(const QString &shortName);
 
 	QList<QSharedPointer<CryptoPrice>> parsePriceListValues(const QJsonArray &priceListJson);
 
+	/// Fields of one crypto price from the names response,
+	/// plain values so the response can be parsed out of the main thread
+	struct ParsedName {
+		QUrl url;
+		QUrl iconUrl;
+		QString name;
+		QString shortName;
+	};
+
+	static std::optional<QList<ParsedName>> parseNamesData(const QByteArray &byteArray);
+	void applyNames(const QList<ParsedName> &names);
+
+	static void writeData(const QString &path,
+						  const QString &oldPath,
+						  const QByteArray &data,
+						  int saveId);
+
+	/// Return false if there is no binary cache file or it is broken
+	bool loadData();
+
+	/// Load prices from the old settings file, we used it before the binary cache file
+	void loadSettings();
+
 	void mergeCryptoPriceList(const QList<CryptoPrice> &priceList);
 
 	void clear();
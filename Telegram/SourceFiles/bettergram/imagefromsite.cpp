@@ -1,102 +1,260 @@
 #include "imagefromsite.h"
+#include "bettergramservice.h"
+
+#include <logs.h>
 
-#include <QUrl>
 #include <QRegExp>
+#include <QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QNetworkReply>
 
 namespace Bettergram {
 
 const int ImageFromSite::DEFAULT_WIDTH = 550;
 const int ImageFromSite::DEFAULT_HEIGHT = 310;
 
+// Thumbnail tags are at the page head and the first images of the page are enough for us
+const int ImageFromSite::_maxSiteContentSize = 256 * 1024;
+
 ImageFromSite::ImageFromSite(QObject *parent) :
-	QObject(parent),
-	_siteContent(nullptr),
-	_image(nullptr)
+	QObject(parent)
 {
-	connect(&_siteContent, &RemoteTempData::downloaded,
-			this, &ImageFromSite::onSiteContentDownloaded);
-
-	connect(&_image, &RemoteImage::imageChanged,
-			this, &ImageFromSite::imageChanged);
 }
 
 ImageFromSite::ImageFromSite(const QUrl &link, QObject *parent) :
-	QObject(parent),
-	_siteContent(link, nullptr),
-	_image(nullptr)
-{
-	connect(&_siteContent, &RemoteTempData::downloaded,
-			this, &ImageFromSite::onSiteContentDownloaded);
-
-	connect(&_image, &RemoteImage::imageChanged,
-			this, &ImageFromSite::imageChanged);
-}
-
-ImageFromSite::ImageFromSite(int scaledWidth, int scaledHeight, QObject *parent) :
-	QObject(parent),
-	_siteContent(nullptr),
-	_image(scaledWidth, scaledHeight, nullptr)
+	QObject(parent)
 {
-	connect(&_siteContent, &RemoteTempData::downloaded,
-			this, &ImageFromSite::onSiteContentDownloaded);
-
-	connect(&_image, &RemoteImage::imageChanged,
-			this, &ImageFromSite::imageChanged);
+	setLink(link);
 }
 
 const QUrl &ImageFromSite::link() const
 {
-	return _siteContent.link();
+	return _link;
 }
 
-void Bettergram::ImageFromSite::setLink(const QUrl &link)
+void ImageFromSite::setLink(const QUrl &link)
 {
-	_siteContent.setLink(link);
+	if (_link != link) {
+		_link = link;
+		download();
+	}
 }
 
-int Bettergram::ImageFromSite::scaledWidth() const
+void ImageFromSite::download()
 {
-	return _image.scaledWidth();
-}
+	stopDownloading();
 
-void Bettergram::ImageFromSite::setScaledWidth(int scaledWidth)
-{
-	_image.setScaledWidth(scaledWidth);
-}
+	if (!_link.isValid()) {
+		return;
+	}
 
-int Bettergram::ImageFromSite::scaledHeight() const
-{
-	return _image.scaledHeight();
+	QNetworkRequest request;
+	request.setUrl(_link);
+
+	// Servers that do not support ranges send the whole page, so we abort it at onSiteContentReadyRead()
+	request.setRawHeader("Range", "bytes=0-" + QByteArray::number(_maxSiteContentSize - 1));
+
+	QNetworkReply *reply = BettergramService::networkManager()->get(request);
+	_reply = reply;
+
+	connect(reply, &QNetworkReply::readyRead, this, [this, reply] {
+		onSiteContentReadyRead(reply);
+	});
+
+	connect(reply, &QNetworkReply::finished, this, [this, reply] {
+		onSiteContentFinished(reply);
+	});
+
+	QTimer::singleShot(BettergramService::networkTimeout(), Qt::VeryCoarseTimer, reply, [reply] {
+		// Aborted reply emits finished() signal, so we parse the downloaded part there
+		reply->abort();
+	});
 }
 
-void Bettergram::ImageFromSite::setScaledHeight(int scaledHeight)
+void ImageFromSite::stopDownloading()
 {
-	_image.setScaledHeight(scaledHeight);
+	_siteContent.clear();
+
+	if (!_reply) {
+		return;
+	}
+
+	QNetworkReply *reply = _reply;
+	_reply = nullptr;
+
+	disconnect(reply, nullptr, this, nullptr);
+	reply->abort();
+	reply->deleteLater();
 }
 
-void Bettergram::ImageFromSite::setScaledSize(int scaledWidth, int scaledHeight)
+void ImageFromSite::onSiteContentReadyRead(QNetworkReply *reply)
 {
-	_image.setScaledSize(scaledWidth, scaledHeight);
+	if (reply != _reply) {
+		return;
+	}
+
+	_siteContent += reply->read(_maxSiteContentSize - _siteContent.size());
+
+	int headEndIndex = _siteContent.indexOf("</head>");
+
+	if (headEndIndex == -1) {
+		headEndIndex = _siteContent.indexOf("</HEAD>");
+	}
+
+	if (headEndIndex != -1) {
+		const QUrl imageLink = getImageInMetaTags(QString::fromUtf8(_siteContent.left(headEndIndex)));
+
+		if (imageLink.isValid()) {
+			stopDownloading();
+			setImageLink(imageLink);
+			return;
+		}
+	}
+
+	if (_siteContent.size() >= _maxSiteContentSize) {
+		const QString source = QString::fromUtf8(_siteContent);
+
+		stopDownloading();
+		setImageLink(getLargestImage(source));
+	}
 }
 
-const QUrl &ImageFromSite::imageLink() const
+void ImageFromSite::onSiteContentFinished(QNetworkReply *reply)
 {
-	return _image.link();
+	if (reply != _reply) {
+		return;
+	}
+
+	if (reply->error() != QNetworkReply::NoError) {
+		LOG(("Can not download site content at %1. %2 (%3)")
+			.arg(_link.toString())
+			.arg(reply->errorString())
+			.arg(reply->error()));
+	}
+
+	_siteContent += reply->read(_maxSiteContentSize - _siteContent.size());
+
+	const QString source = QString::fromUtf8(_siteContent);
+
+	stopDownloading();
+	setImageLink(getLargestImage(source));
 }
 
 void ImageFromSite::setImageLink(const QUrl &imageLink)
 {
-	_image.setLink(imageLink);
+	if (imageLink.isValid()) {
+		emit imageLinkFound(imageLink);
+	} else {
+		emit imageLinkNotFound();
+	}
 }
 
-const QPixmap &ImageFromSite::image() const
+QUrl ImageFromSite::getImageInMetaTags(const QString &source)
 {
-	return _image.image();
+	const QString startMetaTag = QStringLiteral("<meta");
+	const QString endMetaTag = QStringLiteral(">");
+
+	const QStringList imageProperties = {
+		QStringLiteral("og:image"),
+		QStringLiteral("og:image:url"),
+		QStringLiteral("og:image:secure_url"),
+		QStringLiteral("twitter:image"),
+		QStringLiteral("twitter:image:src")
+	};
+
+	int startIndex = 0;
+
+	while (true) {
+		int startMetaTagIndex = source.indexOf(startMetaTag, startIndex, Qt::CaseInsensitive);
+
+		if (startMetaTagIndex == -1) {
+			break;
+		}
+
+		startMetaTagIndex += startMetaTag.size();
+
+		int endMetaTagIndex = source.indexOf(endMetaTag, startMetaTagIndex);
+
+		if (endMetaTagIndex == -1) {
+			break;
+		}
+
+		startIndex = endMetaTagIndex;
+
+		const QStringRef metaTag = source.midRef(startMetaTagIndex, endMetaTagIndex - startMetaTagIndex);
+
+		QStringRef property = parseQuotedAttribute(metaTag, QStringLiteral("property"));
+
+		if (property.isEmpty()) {
+			property = parseQuotedAttribute(metaTag, QStringLiteral("name"));
+		}
+
+		if (!imageProperties.contains(property.toString().trimmed(), Qt::CaseInsensitive)) {
+			continue;
+		}
+
+		const QString content = parseQuotedAttribute(metaTag, QStringLiteral("content")).toString().trimmed();
+
+		if (!content.isEmpty()) {
+			const QUrl imageLink = _link.resolved(QUrl(content));
+
+			if (imageLink.isValid()) {
+				return imageLink;
+			}
+		}
+	}
+
+	return QUrl();
 }
 
-bool ImageFromSite::isNull() const
+QUrl ImageFromSite::getLargestImage(const QString &source)
 {
-	return _image.isNull();
+	// Here we should find all images with sizes and find the largest one
+
+	const QUrl imageLinkInMetaTags = getImageInMetaTags(source);
+
+	if (imageLinkInMetaTags.isValid()) {
+		return imageLinkInMetaTags;
+	}
+
+	int maxWidthInImageTags = 0;
+	int maxHeightInImageTags = 0;
+	int positionInImageTags = 0;
+
+	QStringRef imageLinkInImageTags = getLargestImageInImageTags(source,
+																 maxWidthInImageTags,
+																 maxHeightInImageTags,
+																 positionInImageTags);
+
+	int maxWidthInFileNames = 0;
+	int maxHeightInFileNames = 0;
+	int positionInFileNames = 0;
+
+	QString imageLinkInFileName = getLargestImageInFileNames(source,
+															 maxWidthInFileNames,
+															 maxHeightInFileNames,
+															 positionInFileNames);
+
+	QUrl imageUrl;
+
+	if (maxHeightInImageTags >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH
+			&& maxHeightInFileNames >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH) {
+		if (positionInImageTags <= positionInFileNames) {
+			imageUrl = imageLinkInImageTags.toString();
+		} else {
+			imageUrl = imageLinkInFileName;
+		}
+	} else if (maxHeightInFileNames > maxHeightInImageTags) {
+		imageUrl = imageLinkInFileName;
+	} else if (maxHeightInFileNames == maxHeightInImageTags
+			   && maxWidthInFileNames > maxWidthInImageTags) {
+		imageUrl = imageLinkInFileName;
+	} else {
+		imageUrl = imageLinkInImageTags.toString();
+	}
+
+	return imageUrl.isEmpty() ? QUrl() : _link.resolved(imageUrl);
 }
 
 int ImageFromSite::parseIntAttribute(const QStringRef &source,
@@ -141,6 +299,56 @@ QStringRef ImageFromSite::parseStringAttribute(const QStringRef &source,
 	return QStringRef();
 }
 
+QStringRef ImageFromSite::parseQuotedAttribute(const QStringRef &source, const QString &name)
+{
+	int startIndex = 0;
+
+	while (true) {
+		int nameIndex = source.indexOf(name, startIndex, Qt::CaseInsensitive);
+
+		if (nameIndex == -1) {
+			return QStringRef();
+		}
+
+		startIndex = nameIndex + name.size();
+
+		// Skip matches inside other attribute names, like "content" in "data-content"
+		if (nameIndex > 0 && !source.at(nameIndex - 1).isSpace()) {
+			continue;
+		}
+
+		int index = startIndex;
+
+		while (index < source.size() && source.at(index).isSpace()) {
+			index++;
+		}
+
+		if (index >= source.size() || source.at(index) != '=') {
+			continue;
+		}
+
+		index++;
+
+		while (index < source.size() && source.at(index).isSpace()) {
+			index++;
+		}
+
+		if (index >= source.size() || (source.at(index) != '"' && source.at(index) != '\'')) {
+			continue;
+		}
+
+		const QChar quote = source.at(index);
+		const int valueIndex = index + 1;
+		const int endValueIndex = source.indexOf(quote, valueIndex);
+
+		if (endValueIndex == -1) {
+			return QStringRef();
+		}
+
+		return source.mid(valueIndex, endValueIndex - valueIndex);
+	}
+}
+
 QStringRef ImageFromSite::getLargestImageInImageTags(const QString &source,
 													 int &maxWidth,
 													 int &maxHeight,
@@ -275,51 +483,4 @@ QString ImageFromSite::getLargestImageInFileNames(const QString &source,
 	return imageLink;
 }
 
-void Bettergram::ImageFromSite::onSiteContentDownloaded(QByteArray data)
-{
-	// Here we should find all images with sizes and find the largest one
-
-	const QString source = QString::fromUtf8(data);
-
-	int maxWidthInImageTags = 0;
-	int maxHeightInImageTags = 0;
-	int positionInImageTags = 0;
-
-	QStringRef imageLinkInImageTags = getLargestImageInImageTags(source,
-																 maxWidthInImageTags,
-																 maxHeightInImageTags,
-																 positionInImageTags);
-
-	int maxWidthInFileNames = 0;
-	int maxHeightInFileNames = 0;
-	int positionInFileNames = 0;
-
-	QString imageLinkInFileName = getLargestImageInFileNames(source,
-															 maxWidthInFileNames,
-															 maxHeightInFileNames,
-															 positionInFileNames);
-
-	QUrl imageUrl;
-
-	if (maxHeightInImageTags >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH
-			&& maxHeightInFileNames >= DEFAULT_HEIGHT && maxWidthInFileNames >= DEFAULT_WIDTH) {
-		if (positionInImageTags <= positionInFileNames) {
-			imageUrl = imageLinkInImageTags.toString();
-		} else {
-			imageUrl = imageLinkInFileName;
-		}
-	} else if (maxHeightInFileNames > maxHeightInImageTags) {
-		imageUrl = imageLinkInFileName;
-	} else if (maxHeightInFileNames == maxHeightInImageTags
-			   && maxWidthInFileNames > maxWidthInImageTags) {
-		imageUrl = imageLinkInFileName;
-	} else {
-		imageUrl = imageLinkInImageTags.toString();
-	}
-
-	if (imageUrl.isValid()) {
-		_image.setLink(imageUrl);
-	}
-}
-
-} // namespace Bettergrams
+} // namespace Bettergram
@@ -1,13 +1,18 @@
 #pragma once
 
-#include "remotetempdata.h"
-#include "remoteimage.h"
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+class QNetworkReply;
 
 namespace Bettergram {
 
 /**
- * @brief The ImageFromSite class is used to download the biggest image from a site.
+ * @brief The ImageFromSite class is used to find link to the biggest image of a site.
  * We use this class to fetch RSS thumbnail if all other ways are broken.
+ * It downloads only the beginning of the site page and stops as soon as
+ * it finds OpenGraph or Twitter image tags at the page head.
  */
 class ImageFromSite : public QObject {
 	Q_OBJECT
@@ -15,30 +20,17 @@ class ImageFromSite : public QObject {
 public:
 	explicit ImageFromSite(QObject *parent);
 	explicit ImageFromSite(const QUrl &link, QObject *parent);
-	explicit ImageFromSite(int scaledWidth, int scaledHeight, QObject *parent);
 
 	const QUrl &link() const;
 	void setLink(const QUrl &link);
 
-	int scaledWidth() const;
-	void setScaledWidth(int scaledWidth);
-
-	int scaledHeight() const;
-	void setScaledHeight(int scaledHeight);
-
-	void setScaledSize(int scaledWidth, int scaledHeight);
-
-	const QUrl &imageLink() const;
-	void setImageLink(const QUrl &imageLink);
-
-	const QPixmap &image() const;
-
-	bool isNull() const;
-
 public slots:
 
 signals:
-	void imageChanged();
+	void imageLinkFound(QUrl imageLink);
+
+	/// The site does not have images or we can not download it
+	void imageLinkNotFound();
 
 protected:
 
@@ -47,8 +39,26 @@ private:
 	static const int DEFAULT_WIDTH;
 	static const int DEFAULT_HEIGHT;
 
-	RemoteTempData _siteContent;
-	RemoteImage _image;
+	/// We do not download more than this size of a site page
+	static const int _maxSiteContentSize;
+
+	QUrl _link;
+	QByteArray _siteContent;
+	QPointer<QNetworkReply> _reply;
+
+	void download();
+	void stopDownloading();
+
+	void onSiteContentReadyRead(QNetworkReply *reply);
+	void onSiteContentFinished(QNetworkReply *reply);
+
+	/// Return image link from <meta property="og:image" content="..."> like tags
+	QUrl getImageInMetaTags(const QString &source);
+
+	/// Return image link from <img src="..."> tags and image file names
+	QUrl getLargestImage(const QString &source);
+
+	void setImageLink(const QUrl &imageLink);
 
 	int parseIntAttribute(const QStringRef &source,
 						  const QString &startAttribute,
@@ -58,6 +68,9 @@ private:
 									const QString &startAttribute,
 									const QString &endAttribute);
 
+	/// Return value of the attribute enclosed in single or double quotes
+	QStringRef parseQuotedAttribute(const QStringRef &source, const QString &name);
+
 	QStringRef getLargestImageInImageTags(const QString &source,
 										  int &maxWidth,
 										  int &maxHeight,
@@ -67,9 +80,6 @@ private:
 									   int &maxWidth,
 									   int &maxHeight,
 									   int &position);
-
-private slots:
-	void onSiteContentDownloaded(QByteArray data);
 };
 
 } // namespace Bettergram
@@ -0,0 +1,281 @@
+#include "networkmetrics.h"
+
+#include <QStringList>
+#include <QtNetwork/QNetworkReply>
+
+namespace Bettergram {
+
+// We roll the aggregates every hour
+const crl::time NetworkMetrics::_windowDuration = 60 * 60 * 1000;
+
+int NetworkMetrics::Counters::requests() const
+{
+	int result = 0;
+
+	for (const int count : results) {
+		result += count;
+	}
+
+	return result;
+}
+
+NetworkMetrics::NetworkMetrics(QObject *parent) :
+	QObject(parent)
+{
+}
+
+bool NetworkMetrics::isEnabled() const
+{
+	return _isEnabled;
+}
+
+void NetworkMetrics::setIsEnabled(bool isEnabled)
+{
+	if (_isEnabled == isEnabled) {
+		return;
+	}
+
+	_isEnabled = isEnabled;
+
+	clear();
+}
+
+void NetworkMetrics::track(QNetworkReply *reply, Endpoint endpoint)
+{
+	if (!_isEnabled || !reply) {
+		return;
+	}
+
+	_pending.insert(reply, { endpoint, crl::now() });
+
+	connect(reply, &QNetworkReply::finished, this, [this, reply] {
+		onReplyFinished(reply);
+	});
+
+	connect(reply, &QObject::destroyed, this, [this, reply] {
+		onReplyDestroyed(reply);
+	});
+}
+
+void NetworkMetrics::measureParsing(Endpoint endpoint, const std::function<void()> &method)
+{
+	if (!_isEnabled) {
+		method();
+		return;
+	}
+
+	const crl::time started = crl::now();
+
+	method();
+
+	counters(endpoint).parsing.add(crl::now() - started);
+}
+
+void NetworkMetrics::addCacheHit(Endpoint endpoint)
+{
+	if (!_isEnabled) {
+		return;
+	}
+
+	counters(endpoint).results[static_cast<size_t>(Result::CacheHit)]++;
+}
+
+QString NetworkMetrics::summary() const
+{
+	if (!_isEnabled) {
+		return QStringLiteral("Bettergram network metrics are disabled.");
+	}
+
+	QStringList result;
+
+	result.append(QStringLiteral("Current hour, collected for %1s, %2 requests in flight:")
+				  .arg((crl::now() - _currentStartedAt) / 1000)
+				  .arg(_pending.size()));
+
+	result.append(formatCountersList(_current));
+
+	result.append(QString());
+	result.append(QStringLiteral("Previous hour:"));
+	result.append(formatCountersList(_previous));
+
+	return result.join('\n');
+}
+
+void NetworkMetrics::clear()
+{
+	_pending.clear();
+	_current = CountersList();
+	_previous = CountersList();
+	_currentStartedAt = crl::now();
+}
+
+QString NetworkMetrics::endpointName(Endpoint endpoint)
+{
+	switch (endpoint) {
+	case Endpoint::CryptoPriceNames:
+		return QStringLiteral("Price names");
+	case Endpoint::CryptoPriceSearch:
+		return QStringLiteral("Price search");
+	case Endpoint::CryptoPriceValues:
+		return QStringLiteral("Price values");
+	case Endpoint::CryptoPriceStats:
+		return QStringLiteral("Price stats");
+	case Endpoint::RssChannelList:
+		return QStringLiteral("News channels");
+	case Endpoint::VideoChannelList:
+		return QStringLiteral("Video channels");
+	case Endpoint::RssFeeds:
+		return QStringLiteral("News feeds");
+	case Endpoint::VideoFeeds:
+		return QStringLiteral("Video feeds");
+	case Endpoint::ResourceGroupList:
+		return QStringLiteral("Resources");
+	case Endpoint::PinnedNewsList:
+		return QStringLiteral("Pinned news");
+	case Endpoint::Ads:
+		return QStringLiteral("Ads");
+	case Endpoint::RemoteFiles:
+		return QStringLiteral("Images");
+	case Endpoint::Count:
+		break;
+	}
+
+	return QStringLiteral("Unknown");
+}
+
+QString NetworkMetrics::resultName(Result result)
+{
+	switch (result) {
+	case Result::Success:
+		return QStringLiteral("ok");
+	case Result::CacheHit:
+		return QStringLiteral("cached");
+	case Result::Timeout:
+		return QStringLiteral("timeout");
+	case Result::NetworkError:
+		return QStringLiteral("network errors");
+	case Result::HttpError:
+		return QStringLiteral("http errors");
+	case Result::Count:
+		break;
+	}
+
+	return QStringLiteral("unknown");
+}
+
+QString NetworkMetrics::formatCounters(const Counters &counters)
+{
+	QStringList results;
+
+	for (size_t i = 0; i < counters.results.size(); i++) {
+		results.append(QStringLiteral("%1 %2")
+					   .arg(resultName(static_cast<Result>(i)))
+					   .arg(counters.results[i]));
+	}
+
+	return QStringLiteral("%1, received %2 KB, latency %3, parsing %4")
+			.arg(results.join(QStringLiteral(", ")))
+			.arg(counters.bytesReceived / 1024)
+			.arg(counters.latency.toString())
+			.arg(counters.parsing.toString());
+}
+
+QString NetworkMetrics::formatCountersList(const CountersList &countersList)
+{
+	QStringList result;
+
+	for (size_t i = 0; i < countersList.size(); i++) {
+		const Counters &counters = countersList[i];
+
+		if (counters.requests() > 0 || counters.parsing.count() > 0) {
+			result.append(QStringLiteral("%1: %2")
+						  .arg(endpointName(static_cast<Endpoint>(i)))
+						  .arg(formatCounters(counters)));
+		}
+	}
+
+	if (result.isEmpty()) {
+		return QStringLiteral("No requests");
+	}
+
+	return result.join('\n');
+}
+
+NetworkMetrics::Result NetworkMetrics::getResult(const QNetworkReply *reply)
+{
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+	switch (reply->error()) {
+	case QNetworkReply::NoError:
+		return statusCode == 304 ? Result::CacheHit : Result::Success;
+
+	// We abort replies only due timeout
+	case QNetworkReply::OperationCanceledError:
+	case QNetworkReply::TimeoutError:
+		return Result::Timeout;
+
+	default:
+		return statusCode > 0 ? Result::HttpError : Result::NetworkError;
+	}
+}
+
+NetworkMetrics::Counters &NetworkMetrics::counters(Endpoint endpoint)
+{
+	rotateIfNeeded();
+
+	return _current[static_cast<size_t>(endpoint)];
+}
+
+void NetworkMetrics::rotateIfNeeded()
+{
+	const crl::time now = crl::now();
+
+	if (now - _currentStartedAt < _windowDuration) {
+		return;
+	}
+
+	// If nothing is collected during the last hour the previous aggregates are outdated as well
+	_previous = (now - _currentStartedAt < 2 * _windowDuration) ? _current : CountersList();
+	_current = CountersList();
+	_currentStartedAt = now;
+}
+
+void NetworkMetrics::onReplyFinished(QNetworkReply *reply)
+{
+	const auto it = _pending.find(reply);
+
+	if (it == _pending.end()) {
+		return;
+	}
+
+	const Pending pending = it.value();
+	_pending.erase(it);
+
+	Counters &endpointCounters = counters(pending.endpoint);
+
+	const Result result = getResult(reply);
+	endpointCounters.results[static_cast<size_t>(result)]++;
+
+	if (result != Result::Timeout) {
+		endpointCounters.latency.add(crl::now() - pending.started);
+	}
+
+	endpointCounters.bytesReceived += reply->bytesAvailable();
+}
+
+void NetworkMetrics::onReplyDestroyed(QNetworkReply *reply)
+{
+	// Some requests delete the reply due timeout without aborting it, so it is not finished
+	const auto it = _pending.find(reply);
+
+	if (it == _pending.end()) {
+		return;
+	}
+
+	const Endpoint endpoint = it.value().endpoint;
+	_pending.erase(it);
+
+	counters(endpoint).results[static_cast<size_t>(Result::Timeout)]++;
+}
+
+} // namespace Bettergram
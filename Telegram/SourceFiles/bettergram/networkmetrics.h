@@ -0,0 +1,114 @@
+#pragma once
+
+#include <mtproto/network_stats.h>
+
+#include <QObject>
+#include <QHash>
+
+#include <array>
+#include <functional>
+
+class QNetworkReply;
+
+namespace Bettergram {
+
+/**
+ * @brief The NetworkMetrics class collects latency, payload size, parse time,
+ * cache hits and errors of Bettergram requests for each endpoint.
+ * It is disabled by default and does nothing until the user enables it.
+ * Aggregates are rolled every hour, so we keep the current and the previous hour only.
+ */
+class NetworkMetrics : public QObject {
+	Q_OBJECT
+
+public:
+	enum class Endpoint {
+		CryptoPriceNames,
+		CryptoPriceSearch,
+		CryptoPriceValues,
+		CryptoPriceStats,
+		RssChannelList,
+		VideoChannelList,
+		RssFeeds,
+		VideoFeeds,
+		ResourceGroupList,
+		PinnedNewsList,
+		Ads,
+		RemoteFiles,
+
+		Count
+	};
+
+	enum class Result {
+		Success,
+
+		/// The server responds with 304 (Not Modified) or the file is taken from the disk cache
+		CacheHit,
+
+		Timeout,
+		NetworkError,
+		HttpError,
+
+		Count
+	};
+
+	struct Counters {
+		MTP::LatencyHistogram latency;
+		MTP::LatencyHistogram parsing;
+		qint64 bytesReceived = 0;
+		std::array<int, static_cast<size_t>(Result::Count)> results = { { 0 } };
+
+		int requests() const;
+	};
+
+	explicit NetworkMetrics(QObject *parent);
+
+	bool isEnabled() const;
+	void setIsEnabled(bool isEnabled);
+
+	/// Measure the reply from now till it is finished or destroyed.
+	/// It should be called before connecting to finished() signal of the reply,
+	/// so we can get the payload size before the reply is read.
+	void track(QNetworkReply *reply, Endpoint endpoint);
+
+	/// Call the method and add its duration to the parse time of the endpoint
+	void measureParsing(Endpoint endpoint, const std::function<void()> &method);
+
+	/// The result is got without any network request, for example from the disk cache
+	void addCacheHit(Endpoint endpoint);
+
+	QString summary() const;
+	void clear();
+
+private:
+	using CountersList = std::array<Counters, static_cast<size_t>(Endpoint::Count)>;
+
+	struct Pending {
+		Endpoint endpoint = Endpoint::Count;
+		crl::time started = 0;
+	};
+
+	/// Aggregates of the current window become the previous ones after this time
+	static const crl::time _windowDuration;
+
+	bool _isEnabled = false;
+	QHash<QNetworkReply*, Pending> _pending;
+	CountersList _current;
+	CountersList _previous;
+	crl::time _currentStartedAt = 0;
+
+	static QString endpointName(Endpoint endpoint);
+	static QString resultName(Result result);
+	static QString formatCounters(const Counters &counters);
+	static QString formatCountersList(const CountersList &countersList);
+
+	static Result getResult(const QNetworkReply *reply);
+
+	Counters &counters(Endpoint endpoint);
+	void rotateIfNeeded();
+
+	void onReplyFinished(QNetworkReply *reply);
+	void onReplyDestroyed(QNetworkReply *reply);
+};
+
+} // namespace Bettergram
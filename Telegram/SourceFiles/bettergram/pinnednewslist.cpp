@@ -42,6 +42,34 @@ QList<QSharedPointer<PinnedNewsItem>> PinnedNewsList::videos() const
 	return _videos;
 }
 
+const QByteArray &PinnedNewsList::etag() const
+{
+	return _etag;
+}
+
+const QByteArray &PinnedNewsList::lastModified() const
+{
+	return _lastModified;
+}
+
+void PinnedNewsList::fetchingSucceed(const QByteArray &source,
+									 const QByteArray &etag,
+									 const QByteArray &lastModified)
+{
+	parse(source);
+
+	// We use these values in the next request only if the list is successfully parsed
+	if (_lastSourceHash == QCryptographicHash::hash(source, QCryptographicHash::Sha256)) {
+		_etag = etag;
+		_lastModified = lastModified;
+	}
+}
+
+void PinnedNewsList::fetchingNotModified()
+{
+	_lastUpdate = QDateTime::currentDateTime();
+}
+
 bool PinnedNewsList::parse(const QByteArray &byteArray)
 {
 	// Update only if it has been changed
@@ -99,6 +127,7 @@ bool PinnedNewsList::parse(const QJsonObject &json)
 	if (json.contains("news")) {
 		parseItemList(json.value("news").toArray(),
 					  _news,
+					  _newsBySource,
 					  st::newsPanImageWidth,
 					  st::newsPanImageHeight);
 	}
@@ -106,6 +135,7 @@ bool PinnedNewsList::parse(const QJsonObject &json)
 	if (json.contains("videos")) {
 		parseItemList(json.value("videos").toArray(),
 					  _videos,
+					  _videosBySource,
 					  st::videosPanImageWidth,
 					  st::videosPanImageHeight);
 	}
@@ -118,9 +148,13 @@ bool PinnedNewsList::parse(const QJsonObject &json)
 
 bool PinnedNewsList::parseItemList(const QJsonArray &jsonArray,
 									   QList<QSharedPointer<PinnedNewsItem>> &list,
+									   QHash<QByteArray, QSharedPointer<PinnedNewsItem>> &itemsBySource,
 									   int iconWidth,
 									   int iconHeight)
 {
+	QHash<QByteArray, QSharedPointer<PinnedNewsItem>> existedItems;
+	existedItems.swap(itemsBySource);
+
 	list.clear();
 
 	for (const QJsonValue jsonValue : jsonArray) {
@@ -131,6 +165,16 @@ bool PinnedNewsList::parseItemList(const QJsonArray &jsonArray,
 
 		QJsonObject json = jsonValue.toObject();
 
+		// Keys of json objects are sorted, so the same item always has the same source
+		const QByteArray source = QJsonDocument(json).toJson(QJsonDocument::Compact);
+		const QSharedPointer<PinnedNewsItem> existedItem = existedItems.take(source);
+
+		if (existedItem) {
+			list.push_back(existedItem);
+			itemsBySource.insert(source, existedItem);
+			continue;
+		}
+
 		const QString title = json.value("title").toString();
 		const QString description = json.value("description").toString();
 
@@ -160,6 +204,7 @@ bool PinnedNewsList::parseItemList(const QJsonArray &jsonArray,
 		connect(item.data(), &PinnedNewsItem::imageChanged, this, &PinnedNewsList::imageChanged);
 
 		list.push_back(item);
+		itemsBySource.insert(source, item);
 	}
 
 	return true;
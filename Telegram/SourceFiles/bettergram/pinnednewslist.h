@@ -23,6 +23,17 @@ public:
 
 	bool parse(const QByteArray &byteArray);
 
+	/// Values of ETag and Last-Modified headers of the last fetched list
+	const QByteArray &etag() const;
+	const QByteArray &lastModified() const;
+
+	void fetchingSucceed(const QByteArray &source,
+						 const QByteArray &etag,
+						 const QByteArray &lastModified);
+
+	/// The server responds that the list is not changed since the last fetching
+	void fetchingNotModified();
+
 signals:
 	void freqChanged();
 	void imageChanged();
@@ -37,14 +48,21 @@ private:
 	QList<QSharedPointer<PinnedNewsItem>> _news;
 	QList<QSharedPointer<PinnedNewsItem>> _videos;
 
+	/// Source json of the items, we keep items those are not changed in order to not download their images again
+	QHash<QByteArray, QSharedPointer<PinnedNewsItem>> _newsBySource;
+	QHash<QByteArray, QSharedPointer<PinnedNewsItem>> _videosBySource;
+
 	/// Frequency of updates in seconds
 	int _freq;
 	QDateTime _lastUpdate;
 	QByteArray _lastSourceHash;
+	QByteArray _etag;
+	QByteArray _lastModified;
 
 	bool parse(const QJsonObject &json);
 	bool parseItemList(const QJsonArray &jsonArray,
 					   QList<QSharedPointer<PinnedNewsItem>> &list,
+					   QHash<QByteArray, QSharedPointer<PinnedNewsItem>> &itemsBySource,
 					   int iconWidth,
 					   int iconHeight);
 };
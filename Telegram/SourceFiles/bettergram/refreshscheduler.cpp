@@ -0,0 +1,167 @@
+#include "refreshscheduler.h"
+
+namespace Bettergram {
+
+// Jobs that are due within 1 minute are called together with the due ones
+const int RefreshScheduler::_groupingWindow = 60 * 1000;
+
+// We call SlowWhenInactive jobs 4 times less often while the window is inactive
+const int RefreshScheduler::_inactivePeriodFactor = 4;
+
+// We delay each job run up to 5% of its period
+const int RefreshScheduler::_jitterDivider = 20;
+
+RefreshScheduler::RefreshScheduler(QObject *parent) :
+	QObject(parent)
+{
+	_timer.setSingleShot(true);
+	_timer.setTimerType(Qt::VeryCoarseTimer);
+
+	connect(&_timer, &QTimer::timeout, this, &RefreshScheduler::onTimeout);
+}
+
+int RefreshScheduler::add(int period, Activity activity, QObject *context, std::function<void()> callback)
+{
+	Job job;
+	job.period = qMax(period, 1000);
+	job.activity = activity;
+	job.context = context;
+	job.callback = std::move(callback);
+	job.nextTime = countNextTime(job, crl::now());
+
+	const int id = ++_lastId;
+	_jobs.insert(id, std::move(job));
+
+	updateTimer();
+
+	return id;
+}
+
+void RefreshScheduler::remove(int id)
+{
+	if (_jobs.remove(id)) {
+		updateTimer();
+	}
+}
+
+bool RefreshScheduler::isActive() const
+{
+	return _isActive;
+}
+
+void RefreshScheduler::setIsActive(bool isActive)
+{
+	if (_isActive == isActive) {
+		return;
+	}
+
+	_isActive = isActive;
+
+	rescheduleSlowJobs();
+}
+
+bool RefreshScheduler::isIdle() const
+{
+	return _isIdle;
+}
+
+void RefreshScheduler::setIsIdle(bool isIdle)
+{
+	if (_isIdle == isIdle) {
+		return;
+	}
+
+	_isIdle = isIdle;
+
+	rescheduleSlowJobs();
+}
+
+void RefreshScheduler::rescheduleSlowJobs()
+{
+	const crl::time now = crl::now();
+	const bool isSlow = !_isActive || _isIdle;
+
+	for (Job &job : _jobs) {
+		if (job.activity == Activity::SlowWhenInactive) {
+			// The window is active again or idle mode is over, so we call jobs that are late for the normal period
+			job.nextTime = isSlow
+					? countNextTime(job, now)
+					: qMin(job.nextTime, now + job.period / _jitterDivider);
+		}
+	}
+
+	updateTimer();
+}
+
+crl::time RefreshScheduler::countNextTime(const Job &job, crl::time now) const
+{
+	crl::time period = job.period;
+
+	if (job.activity == Activity::SlowWhenInactive) {
+		if (_isIdle) {
+			return std::numeric_limits<crl::time>::max();
+		} else if (!_isActive) {
+			period *= _inactivePeriodFactor;
+		}
+	}
+
+	const int jitter = int(period / _jitterDivider);
+
+	return now + period + (jitter > 0 ? qrand() % jitter : 0);
+}
+
+void RefreshScheduler::updateTimer()
+{
+	if (_jobs.isEmpty()) {
+		_timer.stop();
+		return;
+	}
+
+	crl::time nextTime = std::numeric_limits<crl::time>::max();
+
+	for (const Job &job : _jobs) {
+		nextTime = qMin(nextTime, job.nextTime);
+	}
+
+	if (nextTime == std::numeric_limits<crl::time>::max()) {
+		_timer.stop();
+		return;
+	}
+
+	_timer.start(int(qMax(nextTime - crl::now(), crl::time(0))));
+}
+
+void RefreshScheduler::onTimeout()
+{
+	const crl::time now = crl::now();
+
+	// Callbacks may add or remove jobs, so we collect due ones first
+	QList<int> dueIds;
+
+	for (auto it = _jobs.begin(); it != _jobs.end();) {
+		if (!it->context) {
+			it = _jobs.erase(it);
+			continue;
+		}
+
+		if (it->nextTime <= now + _groupingWindow) {
+			dueIds.push_back(it.key());
+			it->nextTime = countNextTime(*it, now);
+		}
+
+		++it;
+	}
+
+	for (int id : dueIds) {
+		const auto it = _jobs.constFind(id);
+
+		if (it != _jobs.constEnd() && it->context) {
+			const std::function<void()> callback = it->callback;
+			callback();
+		}
+	}
+
+	updateTimer();
+}
+
+} // namespace Bettergram
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
+
+namespace Bettergram {
+
+/**
+ * @brief The RefreshScheduler class calls periodic refresh jobs of Bettergram.
+ * It uses only one timer for all jobs and calls jobs that are due soon together with the due ones,
+ * so the application wakes up less often. Jobs are called less often while the window is inactive
+ * and SlowWhenInactive jobs are paused while the application is in idle mode.
+ */
+class RefreshScheduler : public QObject {
+	Q_OBJECT
+
+public:
+	enum class Activity {
+		/// The job is called with the same period even if the window is inactive
+		Always,
+
+		/// The period of the job is multiplied by _inactivePeriodFactor while the window is inactive,
+		/// the job is not called at all in idle mode
+		SlowWhenInactive
+	};
+
+	explicit RefreshScheduler(QObject *parent);
+
+	/// Call the callback every period milliseconds until the job is removed or the context is destroyed.
+	/// Return id of the job, it is never 0.
+	int add(int period, Activity activity, QObject *context, std::function<void()> callback);
+	void remove(int id);
+
+	bool isActive() const;
+	void setIsActive(bool isActive);
+
+	bool isIdle() const;
+	void setIsIdle(bool isIdle);
+
+private:
+	struct Job {
+		int period = 0;
+		Activity activity = Activity::Always;
+		QPointer<QObject> context;
+		std::function<void()> callback;
+		crl::time nextTime = 0;
+	};
+
+	/// Jobs that are due within this time are called together with the due ones
+	static const int _groupingWindow;
+
+	/// Period of SlowWhenInactive jobs is multiplied by this value while the window is inactive
+	static const int _inactivePeriodFactor;
+
+	/// Random delay up to this part of the period is added to each job run,
+	/// so jobs of many clients do not hit our servers at the same time
+	static const int _jitterDivider;
+
+	QTimer _timer;
+	QMap<int, Job> _jobs;
+	int _lastId = 0;
+	bool _isActive = true;
+	bool _isIdle = false;
+
+	crl::time countNextTime(const Job &job, crl::time now) const;
+	void rescheduleSlowJobs();
+	void updateTimer();
+
+private slots:
+	void onTimeout();
+};
+
+} // namespace Bettergram
@@ -0,0 +1,184 @@
+#include "remotefilecache.h"
+#include "bettergramservice.h"
+#include "networkmetrics.h"
+
+#include <logs.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QSaveFile>
+#include <QTimer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+
+namespace Bettergram {
+
+// We remove cached files that are not downloaded again for 30 days
+const qint64 RemoteFileCache::_maxFileAgeInSeconds = 30 * 24 * 60 * 60;
+
+RemoteFileCache *RemoteFileCache::instance()
+{
+	static const auto result = new RemoteFileCache(QCoreApplication::instance());
+	return result;
+}
+
+RemoteFileCache::RemoteFileCache(QObject *parent) :
+	QObject(parent)
+{
+	const QString dirPath = cacheDirPath();
+
+	crl::async([=] {
+		removeOldFiles(dirPath);
+	});
+}
+
+QString RemoteFileCache::cacheDirPath()
+{
+	return BettergramService::instance()->cacheDirPath() + QStringLiteral("files/");
+}
+
+QString RemoteFileCache::filePath(const QUrl &link)
+{
+	const QByteArray hash = QCryptographicHash::hash(link.toEncoded(), QCryptographicHash::Sha1);
+
+	return cacheDirPath() + QString::fromLatin1(hash.toHex());
+}
+
+void RemoteFileCache::removeOldFiles(const QString &dirPath)
+{
+	const QDateTime now = QDateTime::currentDateTime();
+	const QFileInfoList files = QDir(dirPath).entryInfoList(QDir::Files);
+
+	for (const QFileInfo &file : files) {
+		if (file.lastModified().secsTo(now) > _maxFileAgeInSeconds) {
+			QFile::remove(file.absoluteFilePath());
+		}
+	}
+}
+
+void RemoteFileCache::get(const QUrl &link, CachePolicy cachePolicy, QObject *context, Callback callback)
+{
+	Request &request = _requests[link];
+	request.waiters.push_back({ context, std::move(callback) });
+
+	if (request.waiters.size() > 1) {
+		// The file is already requested, so we just wait for it,
+		// but a cached copy is not enough for Refresh and None callers
+		if (request.isReadingFile && cachePolicy != CachePolicy::Use) {
+			request.isDownloadNeeded = true;
+		}
+		return;
+	}
+
+	switch (cachePolicy) {
+	case CachePolicy::Use:
+		request.isReadingFile = true;
+		readFile(link);
+		break;
+	case CachePolicy::Refresh:
+		download(link, true);
+		break;
+	case CachePolicy::None:
+		download(link, false);
+		break;
+	}
+}
+
+void RemoteFileCache::readFile(const QUrl &link)
+{
+	const QString path = filePath(link);
+
+	crl::async([=] {
+		Result result;
+		QFile file(path);
+
+		if (file.open(QIODevice::ReadOnly)) {
+			result.data = file.readAll();
+			result.downloadTime = QFileInfo(file).lastModified();
+		}
+
+		crl::on_main(this, [=] {
+			const auto i = _requests.find(link);
+			if (i == _requests.end()) {
+				return;
+			}
+			i->isReadingFile = false;
+
+			if (result.data.isEmpty() || i->isDownloadNeeded) {
+				download(link, true);
+			} else {
+				BettergramService::instance()->networkMetrics()->addCacheHit(NetworkMetrics::Endpoint::RemoteFiles);
+				finish(link, result);
+			}
+		});
+	});
+}
+
+void RemoteFileCache::download(const QUrl &link, bool isStore)
+{
+	QNetworkRequest request;
+	request.setUrl(link);
+
+	QNetworkReply *reply = BettergramService::networkManager()->get(request);
+	BettergramService::instance()->networkMetrics()->track(reply, NetworkMetrics::Endpoint::RemoteFiles);
+
+	connect(reply, &QNetworkReply::finished, this, [this, reply, link, isStore]() {
+		reply->deleteLater();
+
+		Result result;
+		result.error = reply->error();
+
+		if (result.error == QNetworkReply::NoError) {
+			result.data = reply->readAll();
+			result.downloadTime = QDateTime::currentDateTime();
+
+			if (isStore && !result.data.isEmpty()) {
+				const QString dirPath = cacheDirPath();
+				const QString path = filePath(link);
+				const QByteArray data = result.data;
+
+				crl::async([=] {
+					QDir().mkpath(dirPath);
+
+					QSaveFile file(path);
+
+					if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+						LOG(("Unable to save file %1 to the cache. %2").arg(path).arg(file.errorString()));
+					}
+				});
+			}
+		} else {
+			result.errorString = reply->errorString();
+		}
+
+		finish(link, result);
+	});
+
+	QTimer::singleShot(BettergramService::networkTimeout(), Qt::VeryCoarseTimer, reply,
+					   [reply, link] {
+		LOG(("Can not download file at %1 due timeout")
+			.arg(link.toString()));
+
+		// Aborted reply emits finished() signal, so all waiting files get the error there
+		reply->abort();
+	});
+
+	connect(reply, &QNetworkReply::sslErrors, this, [](QList<QSslError> errors) {
+		for(const QSslError &error : errors) {
+			LOG(("%1").arg(error.errorString()));
+		}
+	});
+}
+
+void RemoteFileCache::finish(const QUrl &link, const Result &result)
+{
+	const QList<Waiter> waiters = _requests.take(link).waiters;
+
+	for (const Waiter &waiter : waiters) {
+		if (waiter.context) {
+			waiter.callback(result);
+		}
+	}
+}
+
+} // namespace Bettergrams
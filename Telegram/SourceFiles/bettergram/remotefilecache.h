@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QtNetwork/QNetworkReply>
+
+namespace Bettergram {
+
+/**
+ * @brief The RemoteFileCache class is used by AbstractRemoteFile to get remote files.
+ * It keeps downloaded files at the disk cache and sends only one request for the same link
+ * even if many remote files are waiting for it.
+ */
+class RemoteFileCache : public QObject {
+	Q_OBJECT
+
+public:
+	struct Result {
+		QByteArray data;
+		QDateTime downloadTime;
+		QNetworkReply::NetworkError error = QNetworkReply::NoError;
+		QString errorString;
+	};
+
+	enum class CachePolicy {
+		/// Get the file from the disk cache and store it there after downloading
+		Use,
+
+		/// Download the file again and store it at the disk cache
+		Refresh,
+
+		/// Do not use the disk cache at all
+		None
+	};
+
+	typedef std::function<void(const Result &result)> Callback;
+
+	static RemoteFileCache *instance();
+
+	/// Get the file from the disk cache or download it if it is not cached yet.
+	/// The callback is not called if the context is destroyed before the file is got.
+	void get(const QUrl &link, CachePolicy cachePolicy, QObject *context, Callback callback);
+
+public slots:
+
+signals:
+
+protected:
+
+private:
+	struct Waiter {
+		QPointer<QObject> context;
+		Callback callback;
+	};
+
+	struct Request {
+		QList<Waiter> waiters;
+
+		/// The file is being read from the disk cache
+		bool isReadingFile = false;
+
+		/// A Refresh or None caller joined while the file was being read,
+		/// so the cached data is not enough and the file is downloaded after all
+		bool isDownloadNeeded = false;
+	};
+
+	/// We remove cached files that are not downloaded again for 30 days
+	static const qint64 _maxFileAgeInSeconds;
+
+	QHash<QUrl, Request> _requests;
+
+	explicit RemoteFileCache(QObject *parent);
+
+	static QString cacheDirPath();
+	static QString filePath(const QUrl &link);
+	static void removeOldFiles(const QString &dirPath);
+
+	void readFile(const QUrl &link);
+	void download(const QUrl &link, bool isStore);
+	void finish(const QUrl &link, const Result &result);
+};
+
+} // namespace Bettergram
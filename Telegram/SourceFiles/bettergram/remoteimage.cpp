@@ -1,5 +1,7 @@
 #include "remoteimage.h"
 
+#include <QPixmapCache>
+
 namespace Bettergram {
 
 RemoteImage::RemoteImage(QObject *parent) :
@@ -102,8 +104,17 @@ void RemoteImage::dataDownloaded(const QByteArray &data)
 		return;
 	}
 
+	// The same images are shown by many items, so we keep their scaled variants in memory
+	const QString key = link().toString()
+			+ QStringLiteral("@%1x%2:%3").arg(_scaledWidth).arg(_scaledHeight).arg(qHash(data));
+
 	QPixmap image;
 
+	if (QPixmapCache::find(key, &image)) {
+		setImage(image);
+		return;
+	}
+
 	if (!image.loadFromData(data)) {
 		LOG(("Can not get image from %1. Can not convert response to image.")
 			.arg(link().toString()));
@@ -113,6 +124,8 @@ void RemoteImage::dataDownloaded(const QByteArray &data)
 	}
 
 	setImage(image);
+
+	QPixmapCache::insert(key, _image);
 }
 
 void RemoteImage::setImage(const QPixmap &image)
@@ -25,4 +25,9 @@ void RemoteTempData::resetData()
 {
 }
 
+bool RemoteTempData::isUseDiskCache() const
+{
+	return false;
+}
+
 } // namespace Bettergrams
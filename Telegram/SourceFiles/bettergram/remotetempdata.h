@@ -26,6 +26,9 @@ protected:
 	void dataDownloaded(const QByteArray &data) override;
 	void resetData() override;
 
+	/// Site pages change often and we do not need them after the parsing
+	bool isUseDiskCache() const override;
+
 private:
 };
 
@@ -58,19 +58,35 @@ void ResourceGroup::parse(const QJsonObject &json)
 
 	_title = json.value("title").toString();
 
+	// Items with the same links are updated in place, so their icons are not downloaded again
+	QHash<QString, QSharedPointer<ResourceItem>> existedItems;
+
+	for (const QSharedPointer<ResourceItem> &item : _list) {
+		existedItems.insert(item->link().toString(), item);
+	}
+
+	QList<QSharedPointer<ResourceItem>> list;
+
 	for (const QJsonValue &value : json.value("items").toArray()) {
 		if (!value.isObject()) {
 			LOG(("Unable to get json object for resource item"));
 			continue;
 		}
 
-		QSharedPointer<ResourceItem> item(new ResourceItem());
+		const QJsonObject itemJson = value.toObject();
+		QSharedPointer<ResourceItem> item = existedItems.take(itemJson.value("url").toString());
 
-		connect(item.data(), &ResourceItem::iconChanged, this, &ResourceGroup::iconChanged);
+		if (!item) {
+			item = QSharedPointer<ResourceItem>(new ResourceItem());
 
-		item->parse(value.toObject());
-		_list.push_back(item);
+			connect(item.data(), &ResourceItem::iconChanged, this, &ResourceGroup::iconChanged);
+		}
+
+		item->parse(itemJson);
+		list.push_back(item);
 	}
+
+	_list = list;
 }
 
 } // namespace Bettergrams
@@ -82,6 +82,34 @@ int ResourceGroupList::count() const
 	return _list.count();
 }
 
+const QByteArray &ResourceGroupList::etag() const
+{
+	return _etag;
+}
+
+const QByteArray &ResourceGroupList::lastModified() const
+{
+	return _lastModified;
+}
+
+void ResourceGroupList::fetchingSucceed(const QByteArray &source,
+										const QByteArray &etag,
+										const QByteArray &lastModified)
+{
+	parse(source);
+
+	// We use these values in the next request only if the list is successfully parsed
+	if (_lastSourceHash == QCryptographicHash::hash(source, QCryptographicHash::Sha256)) {
+		_etag = etag;
+		_lastModified = lastModified;
+	}
+}
+
+void ResourceGroupList::fetchingNotModified()
+{
+	setLastUpdate(QDateTime::currentDateTime());
+}
+
 bool ResourceGroupList::parseFile(const QString &filePath)
 {
 	QFile file(filePath);
@@ -156,7 +184,14 @@ bool ResourceGroupList::parse(const QJsonObject &json)
 		groupsJson = json.value("groups").toArray();
 	}
 
-	_list.clear();
+	// We keep existed groups and items in order to not download their icons again
+	QHash<QString, QSharedPointer<ResourceGroup>> existedGroups;
+
+	for (const QSharedPointer<ResourceGroup> &group : _list) {
+		existedGroups.insert(group->title(), group);
+	}
+
+	QList<QSharedPointer<ResourceGroup>> list;
 
 	for (const QJsonValue value : groupsJson) {
 		if (!value.isObject()) {
@@ -164,14 +199,21 @@ bool ResourceGroupList::parse(const QJsonObject &json)
 			continue;
 		}
 
-		QSharedPointer<ResourceGroup> group(new ResourceGroup());
+		const QJsonObject groupJson = value.toObject();
+		QSharedPointer<ResourceGroup> group = existedGroups.take(groupJson.value("title").toString());
 
-		connect(group.data(), &ResourceGroup::iconChanged, this, &ResourceGroupList::iconChanged);
+		if (!group) {
+			group = QSharedPointer<ResourceGroup>(new ResourceGroup());
 
-		group->parse(value.toObject());
-		_list.push_back(group);
+			connect(group.data(), &ResourceGroup::iconChanged, this, &ResourceGroupList::iconChanged);
+		}
+
+		group->parse(groupJson);
+		list.push_back(group);
 	}
 
+	_list = list;
+
 	setLastUpdate(QDateTime::currentDateTime());
 	emit updated();
 
@@ -36,6 +36,17 @@ public:
 	bool parseFile(const QString &filePath);
 	bool parse(const QByteArray &byteArray);
 
+	/// Values of ETag and Last-Modified headers of the last fetched list
+	const QByteArray &etag() const;
+	const QByteArray &lastModified() const;
+
+	void fetchingSucceed(const QByteArray &source,
+						 const QByteArray &etag,
+						 const QByteArray &lastModified);
+
+	/// The server responds that the list is not changed since the last fetching
+	void fetchingNotModified();
+
 public slots:
 
 signals:
@@ -61,6 +72,8 @@ private:
 	QString _lastUpdateString;
 
 	QByteArray _lastSourceHash;
+	QByteArray _etag;
+	QByteArray _lastModified;
 
 	void setLastUpdate(const QDateTime &lastUpdate);
 
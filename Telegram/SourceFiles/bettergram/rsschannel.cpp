@@ -5,10 +5,46 @@
 
 #include <QDateTime>
 #include <QCryptographicHash>
+#include <QSet>
 #include <QXmlStreamReader>
 
 namespace Bettergram {
 
+struct RssChannel::ParsedFeed {
+	QUrl feedLink;
+
+	/// Links of items that the channel already has, we do not build such items again
+	QSet<QUrl> knownLinks;
+
+	QString title;
+	QUrl link;
+	QString description;
+	QUrl iconLink;
+	QString language;
+	QString copyright;
+	QString editorEmail;
+	QString webMasterEmail;
+	QDateTime publishDate;
+	QDateTime lastBuildDate;
+	QString skipHours;
+	QString skipDays;
+	QStringList categoryList;
+	int ttl = 0;
+
+	QList<RssItemData> items;
+
+	/// Known items that still exist at the feed
+	QSet<QUrl> existingLinks;
+
+	bool isError = false;
+};
+
+// We wait 5 minutes after the first failed fetch
+const int RssChannel::_minFetchingBackoff = 5 * 60 * 1000;
+
+// We wait no more than 12 hours between failed fetches
+const int RssChannel::_maxFetchingBackoff = 12 * 60 * 60 * 1000;
+
 void RssChannel::sort(QList<QSharedPointer<RssItem>> &items)
 {
 	std::sort(items.begin(), items.end(), &RssChannel::compare);
@@ -129,6 +165,26 @@ void RssChannel::setFeedLink(const QUrl &feedLink)
 	_feedLink = feedLink;
 }
 
+const QByteArray &RssChannel::etag() const
+{
+	return _etag;
+}
+
+const QByteArray &RssChannel::lastModified() const
+{
+	return _lastModified;
+}
+
+int RssChannel::ttl() const
+{
+	return _ttl;
+}
+
+void RssChannel::setTtl(int ttl)
+{
+	_ttl = qMax(ttl, 0);
+}
+
 bool RssChannel::isFetching() const
 {
 	return _isFetching;
@@ -149,7 +205,12 @@ void RssChannel::setIsFailed(bool isFailed)
 	_isFailed = isFailed;
 }
 
-QByteArray RssChannel::countSourceHash(const QByteArray &source) const
+bool RssChannel::isParsing() const
+{
+	return _isParsing;
+}
+
+QByteArray RssChannel::countSourceHash(const QByteArray &source)
 {
 	return QCryptographicHash::hash(source, QCryptographicHash::Sha256);
 }
@@ -211,7 +272,11 @@ int RssChannel::countUnread() const
 
 bool RssChannel::isMayFetchNewData() const
 {
-	return !_isFetching;
+	if (_isFetching || _isParsing) {
+		return false;
+	}
+
+	return !_nextFetchTime.isValid() || QDateTime::currentDateTime() >= _nextFetchTime;
 }
 
 void RssChannel::markAsRead()
@@ -232,13 +297,32 @@ void RssChannel::startFetching()
 	setIsFetching(true);
 }
 
-void RssChannel::fetchingSucceed(const QByteArray &source)
+void RssChannel::fetchingSucceed(const QByteArray &source,
+								 const QByteArray &etag,
+								 const QByteArray &lastModified)
 {
 	// Update source only if it has been changed
 	if (countSourceHash(source) != _lastSourceHash) {
 		_source = source;
 	}
 
+	_etag = etag;
+	_lastModified = lastModified;
+
+	fetchingNotModified();
+}
+
+void RssChannel::fetchingNotModified()
+{
+	_failedCount = 0;
+
+	// The feed asks us do not fetch it again until its ttl is expired
+	if (_ttl > 0) {
+		_nextFetchTime = QDateTime::currentDateTime().addSecs(_ttl * 60);
+	} else {
+		_nextFetchTime = QDateTime();
+	}
+
 	setIsFetching(false);
 	setIsFailed(false);
 }
@@ -247,6 +331,17 @@ void RssChannel::fetchingFailed()
 {
 	LOG(("Fetching failed for %1").arg(_feedLink.toString()));
 	_source.clear();
+
+	// Exponential backoff: 5 minutes, 10 minutes, 20 minutes and so on
+	qint64 backoff = _minFetchingBackoff;
+
+	for (int i = 0; i < _failedCount && backoff < _maxFetchingBackoff; i++) {
+		backoff *= 2;
+	}
+
+	_failedCount++;
+	_nextFetchTime = QDateTime::currentDateTime().addMSecs(qMin(backoff, qint64(_maxFetchingBackoff)));
+
 	setIsFetching(false);
 	setIsFailed(true);
 }
@@ -270,14 +365,121 @@ bool RssChannel::parse()
 		return false;
 	}
 
-	_categoryList.clear();
+	const QByteArray source = base::take(_source);
+	const int parseId = ++_parseId;
+
+	ParsedFeed feed;
+	feed.feedLink = _feedLink;
+
+	for (const QSharedPointer<RssItem> &item : _list) {
+		feed.knownLinks.insert(item->link());
+	}
+
+	_isParsing = true;
+
+	// Large feeds contain hundreds of items, so we do not parse them at the main thread
+	crl::async([=, feed = std::move(feed)]() mutable {
+		const crl::time started = crl::now();
+		parseSource(source, feed);
+
+		DEBUG_LOG(("RSS feed %1 parsed in %2 ms, new items: %3")
+				  .arg(feed.feedLink.toString())
+				  .arg(crl::now() - started)
+				  .arg(feed.items.size()));
+
+		const QByteArray sourceHash = countSourceHash(source);
+
+		crl::on_main(this, [=, feed = std::move(feed)] {
+			if (parseId != _parseId) {
+				return;
+			}
+
+			applyParsedFeed(feed);
+
+			_lastSourceHash = sourceHash;
+			_isParsing = false;
+
+			emit parsed(true);
+		});
+	});
+
+	return true;
+}
+
+void RssChannel::applyParsedFeed(const ParsedFeed &feed)
+{
+	if (!feed.title.isEmpty()) {
+		setTitle(feed.title);
+	}
+
+	if (feed.link.isValid()) {
+		setLink(feed.link);
+	}
+
+	if (!feed.description.isEmpty()) {
+		setDescription(feed.description);
+	}
+
+	if (feed.iconLink.isValid()) {
+		setIconLink(feed.iconLink);
+	}
+
+	if (!feed.language.isEmpty()) {
+		setLanguage(feed.language);
+	}
+
+	if (!feed.copyright.isEmpty()) {
+		setCopyright(feed.copyright);
+	}
+
+	if (!feed.editorEmail.isEmpty()) {
+		setEditorEmail(feed.editorEmail);
+	}
+
+	if (!feed.webMasterEmail.isEmpty()) {
+		setWebMasterEmail(feed.webMasterEmail);
+	}
+
+	if (feed.publishDate.isValid()) {
+		setPublishDate(feed.publishDate);
+	}
+
+	if (feed.lastBuildDate.isValid()) {
+		setLastBuildDate(feed.lastBuildDate);
+	}
+
+	if (!feed.skipHours.isEmpty()) {
+		setSkipHours(feed.skipHours);
+	}
+
+	if (!feed.skipDays.isEmpty()) {
+		setSkipDays(feed.skipDays);
+	}
+
+	setCategoryList(feed.categoryList);
+	setTtl(feed.ttl);
 
 	for (QSharedPointer<RssItem> &item : _list) {
-		item->setIsExistAtLastFeeds(false);
+		item->setIsExistAtLastFeeds(feed.existingLinks.contains(item->link()));
+	}
+
+	for (const RssItemData &data : feed.items) {
+		merge(QSharedPointer<RssItem>(new RssItem(data, this)));
+	}
+
+	if (feed.isError) {
+		LOG(("Unable to parse RSS feed from %1").arg(_feedLink.toString()));
+	} else {
+		removeOldItems();
 	}
 
+	sort(_list);
+}
+
+void RssChannel::parseSource(const QByteArray &source, ParsedFeed &feed)
+{
 	QXmlStreamReader xml;
-	xml.addData(_source);
+	xml.addData(source);
 
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
@@ -288,9 +490,9 @@ bool RssChannel::parse()
 		QStringRef xmlName = xml.name();
 
 		if (xmlName == QLatin1String("rss")) {
-			parseRss(xml);
+			parseRss(xml, feed);
 		} else if (xmlName == QLatin1String("feed")) {
-			parseAtomFeed(xml);
+			parseAtomFeed(xml, feed);
 		} else {
 			xml.skipCurrentElement();
 		}
@@ -300,22 +502,15 @@ bool RssChannel::parse()
 	// so we ignore PrematureEndOfDocumentError
 	if (xml.hasError() && xml.error() != QXmlStreamReader::PrematureEndOfDocumentError) {
 		LOG(("Unable to parse RSS feed from %1. %2 (%3)")
-			.arg(_feedLink.toString())
+			.arg(feed.feedLink.toString())
 			.arg(xml.errorString())
 			.arg(xml.error()));
-	} else {
-		removeOldItems();
-	}
-
-	_lastSourceHash = countSourceHash(_source);
-	_source.clear();
-
-	sort(_list);
 
-	return true;
+		feed.isError = true;
+	}
 }
 
-void RssChannel::parseRss(QXmlStreamReader &xml)
+void RssChannel::parseRss(QXmlStreamReader &xml, ParsedFeed &feed)
 {
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
@@ -324,14 +519,14 @@ void RssChannel::parseRss(QXmlStreamReader &xml)
 		}
 
 		if (xml.name() == QLatin1String("channel")) {
-			parseChannel(xml);
+			parseChannel(xml, feed);
 		} else {
 			xml.skipCurrentElement();
 		}
 	}
 }
 
-void RssChannel::parseAtomFeed(QXmlStreamReader &xml)
+void RssChannel::parseAtomFeed(QXmlStreamReader &xml, ParsedFeed &feed)
 {
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
@@ -342,22 +537,22 @@ void RssChannel::parseAtomFeed(QXmlStreamReader &xml)
 		QStringRef xmlName = xml.name();
 
 		if (xmlName == QLatin1String("entry")) {
-			parseAtomEntry(xml);
+			parseAtomEntry(xml, feed);
 		} else if (xmlName == QLatin1String("title")) {
-			setTitle(xml.readElementText());
+			feed.title = xml.readElementText();
 		} else if (xmlName == QLatin1String("link")) {
-			setLink(QUrl(xml.attributes().value("href").toString()));
+			feed.link = QUrl(xml.attributes().value("href").toString());
 			xml.skipCurrentElement();
 		} else if (xmlName == QLatin1String("subtitle")) {
-			setDescription(xml.readElementText());
+			feed.description = xml.readElementText();
 		} else if (xmlName == QLatin1String("icon")) {
-			setIconLink(QUrl(xml.readElementText()));
+			feed.iconLink = QUrl(xml.readElementText());
 		} else if (xmlName == QLatin1String("rights")) {
-			setCopyright(xml.readElementText());
+			feed.copyright = xml.readElementText();
 		} else if (xmlName == QLatin1String("updated")) {
-			setLastBuildDate(QDateTime::fromString(xml.readElementText(), Qt::ISODate));
+			feed.lastBuildDate = QDateTime::fromString(xml.readElementText(), Qt::ISODate);
 		} else if (xmlName == QLatin1String("category")) {
-			_categoryList.push_back(xml.attributes().value("term").toString());
+			feed.categoryList.push_back(xml.attributes().value("term").toString());
 			xml.skipCurrentElement();
 		} else {
 			xml.skipCurrentElement();
@@ -365,7 +560,7 @@ void RssChannel::parseAtomFeed(QXmlStreamReader &xml)
 	}
 }
 
-void RssChannel::parseChannel(QXmlStreamReader &xml)
+void RssChannel::parseChannel(QXmlStreamReader &xml, ParsedFeed &feed)
 {
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
@@ -376,41 +571,43 @@ void RssChannel::parseChannel(QXmlStreamReader &xml)
 		QStringRef xmlName = xml.name();
 
 		if (xmlName == QLatin1String("item")) {
-			parseItem(xml);
+			parseItem(xml, feed);
 		} else if (xmlName == QLatin1String("title")) {
-			setTitle(xml.readElementText());
+			feed.title = xml.readElementText();
 		} else if (xmlName == QLatin1String("link")) {
-			setLink(QUrl(xml.readElementText()));
+			feed.link = QUrl(xml.readElementText());
 		} else if (xmlName == QLatin1String("description")) {
-			setDescription(xml.readElementText());
+			feed.description = xml.readElementText();
 		} else if (xmlName == QLatin1String("image")) {
-			parseChannelImage(xml);
+			parseChannelImage(xml, feed);
 		} else if (xmlName == QLatin1String("language")) {
-			setLanguage(xml.readElementText());
+			feed.language = xml.readElementText();
 		} else if (xmlName == QLatin1String("copyright")) {
-			setCopyright(xml.readElementText());
+			feed.copyright = xml.readElementText();
 		} else if (xmlName == QLatin1String("managingEditor")) {
-			setEditorEmail(xml.readElementText());
+			feed.editorEmail = xml.readElementText();
 		} else if (xmlName == QLatin1String("webmaster")) {
-			setWebMasterEmail(xml.readElementText());
+			feed.webMasterEmail = xml.readElementText();
 		} else if (xmlName == QLatin1String("pubDate")) {
 			// Please note that this property may not exist
-			setPublishDate(QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date));
+			feed.publishDate = QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date);
 		} else if (xmlName == QLatin1String("lastBuildDate")) {
-			setLastBuildDate(QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date));
+			feed.lastBuildDate = QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date);
 		} else if (xmlName == QLatin1String("skipHours")) {
-			setSkipHours(xml.readElementText());
+			feed.skipHours = xml.readElementText();
 		} else if (xmlName == QLatin1String("skipDays")) {
-			setSkipDays(xml.readElementText());
+			feed.skipDays = xml.readElementText();
 		} else if (xmlName == QLatin1String("category")) {
-			_categoryList.push_back(xml.readElementText());
+			feed.categoryList.push_back(xml.readElementText());
+		} else if (xmlName == QLatin1String("ttl")) {
+			feed.ttl = xml.readElementText().toInt();
 		} else {
 			xml.skipCurrentElement();
 		}
 	}
 }
 
-void RssChannel::parseChannelImage(QXmlStreamReader &xml)
+void RssChannel::parseChannelImage(QXmlStreamReader &xml, ParsedFeed &feed)
 {
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
@@ -419,41 +616,47 @@ void RssChannel::parseChannelImage(QXmlStreamReader &xml)
 		}
 
 		if (xml.name() == QLatin1String("url")) {
-			setIconLink(xml.readElementText());
+			feed.iconLink = QUrl(xml.readElementText());
 		} else {
 			xml.skipCurrentElement();
 		}
 	}
 }
 
-void RssChannel::parseItem(QXmlStreamReader &xml)
+void RssChannel::parseItem(QXmlStreamReader &xml, ParsedFeed &feed)
 {
-	QSharedPointer<RssItem> item(new RssItem(this));
-	item->parse(xml);
+	RssItemData data;
+	RssItem::parse(xml, data);
 
-	if (xml.hasError()) {
-		LOG(("Unable to parse RSS feed item from %1. %2 (%3)")
-			.arg(_feedLink.toString())
-			.arg(xml.errorString())
-			.arg(xml.error()));
-	} else {
-		merge(item);
-	}
+	addParsedItem(xml, feed, std::move(data));
 }
 
-void RssChannel::parseAtomEntry(QXmlStreamReader &xml)
+void RssChannel::parseAtomEntry(QXmlStreamReader &xml, ParsedFeed &feed)
 {
-	QSharedPointer<RssItem> item(new RssItem(this));
-	item->parseAtom(xml);
+	RssItemData data;
+	RssItem::parseAtom(xml, data);
+
+	addParsedItem(xml, feed, std::move(data));
+}
 
+void RssChannel::addParsedItem(QXmlStreamReader &xml, ParsedFeed &feed, RssItemData &&data)
+{
 	if (xml.hasError()) {
-		LOG(("Unable to parse Atom feed entry from %1. %2 (%3)")
-			.arg(_feedLink.toString())
+		LOG(("Unable to parse RSS feed item from %1. %2 (%3)")
+			.arg(feed.feedLink.toString())
 			.arg(xml.errorString())
 			.arg(xml.error()));
-	} else {
-		merge(item);
+		return;
+	}
+
+	// We do not build items that we already have, only remember that they still exist
+	if (feed.knownLinks.contains(data.link)) {
+		feed.existingLinks.insert(data.link);
+		return;
 	}
+
+	RssItem::prepareData(data);
+	feed.items.push_back(std::move(data));
 }
 
 void RssChannel::load(QSettings &settings)
@@ -473,6 +676,10 @@ void RssChannel::load(QSettings &settings)
 	setSkipHours(settings.value("skipHours").toString());
 	setSkipDays(settings.value("skipDays").toString());
 	setCategoryList(settings.value("categoryList").toStringList());
+	setTtl(settings.value("ttl").toInt());
+
+	_etag = settings.value("etag").toByteArray();
+	_lastModified = settings.value("lastModified").toByteArray();
 
 	int size = settings.beginReadArray("items");
 
@@ -487,35 +694,45 @@ void RssChannel::load(QSettings &settings)
 	settings.endArray();
 }
 
-void RssChannel::save(QSettings &settings)
+void RssChannel::load(QDataStream &stream)
 {
-	// We have to save QUrl as QString due bug on macOS
-	settings.setValue("feedLink", feedLink().toString());
-	settings.setValue("iconLink", iconLink().toString());
-	settings.setValue("link", link().toString());
+	QUrl iconLink;
+	QUrl link;
+	QString title;
+	QString description;
+	qint32 ttl = 0;
+	qint32 size = 0;
 
-	settings.setValue("title", title());
-	settings.setValue("description", description());
-	settings.setValue("language", language());
-	settings.setValue("copyright", copyright());
-	settings.setValue("editorEmail", editorEmail());
-	settings.setValue("webMasterEmail", webMasterEmail());
-	settings.setValue("publishDate", publishDate());
-	settings.setValue("lastBuildDate", lastBuildDate());
-	settings.setValue("skipHours", skipHours());
-	settings.setValue("skipDays", skipDays());
-	settings.setValue("categoryList", categoryList());
+	stream >> _feedLink >> iconLink >> link >> title >> description
+		   >> _language >> _copyright >> _editorEmail >> _webMasterEmail
+		   >> _publishDate >> _lastBuildDate >> _skipHours >> _skipDays
+		   >> _categoryList >> ttl >> _etag >> _lastModified >> size;
 
-	settings.beginWriteArray("items", _list.size());
+	setIconLink(iconLink);
+	setLink(link);
+	setTitle(title);
+	setDescription(description);
+	setTtl(ttl);
 
-	for (int i = 0; i < _list.size(); i++) {
-		const QSharedPointer<RssItem> &item = _list.at(i);
+	for (qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++) {
+		QSharedPointer<RssItem> item(new RssItem(this));
 
-		settings.setArrayIndex(i);
-		item->save(settings);
+		item->load(stream);
+		add(item);
 	}
+}
 
-	settings.endArray();
+void RssChannel::save(QDataStream &stream) const
+{
+	stream << _feedLink << iconLink() << link() << title() << description()
+		   << _language << _copyright << _editorEmail << _webMasterEmail
+		   << _publishDate << _lastBuildDate << _skipHours << _skipDays
+		   << _categoryList << qint32(_ttl) << _etag << _lastModified
+		   << qint32(_list.size());
+
+	for (const QSharedPointer<RssItem> &item : _list) {
+		item->save(stream);
+	}
 }
 
 QSharedPointer<RssItem> RssChannel::find(const QSharedPointer<RssItem> &item)
@@ -552,6 +769,7 @@ void RssChannel::add(const QSharedPointer<RssItem> &item)
 
 	connect(item.data(), &RssItem::isReadChanged, this, &RssChannel::isReadChanged);
 	connect(item.data(), &RssItem::imageChanged, this, &RssChannel::iconChanged);
+	connect(item.data(), &RssItem::imageLinkResolved, this, &RssChannel::imageLinkResolved);
 
 	item->setIsExistAtLastFeeds(true);
 
@@ -7,6 +7,7 @@ class QXmlStreamReader;
 namespace Bettergram {
 
 class RssItem;
+struct RssItemData;
 
 /**
  * @brief The RssChannel class contains information from a RSS channel.
@@ -53,8 +54,19 @@ public:
 	const QUrl &feedLink() const;
 	void setFeedLink(const QUrl &link);
 
+	/// ETag header value of the last fetched feed, used for conditional requests
+	const QByteArray &etag() const;
+
+	/// Last-Modified header value of the last fetched feed, used for conditional requests
+	const QByteArray &lastModified() const;
+
+	/// Time to live of the feed in minutes, 0 if the feed does not have it
+	int ttl() const;
+	void setTtl(int ttl);
+
 	bool isFetching() const;
 	bool isFailed() const;
+	bool isParsing() const;
 
 	const_iterator begin() const;
 	const_iterator end() const;
@@ -67,19 +79,28 @@ public:
 	int count() const;
 	int countUnread() const;
 
+	/// Returns false while the channel is fetching, before the feed ttl is expired
+	/// and while we are waiting after failed fetches
 	bool isMayFetchNewData() const;
 
 	void markAsRead() override;
 
 	void startFetching();
-	void fetchingSucceed(const QByteArray &source);
+	void fetchingSucceed(const QByteArray &source,
+						 const QByteArray &etag,
+						 const QByteArray &lastModified);
+
+	/// Server responded with 304 (Not Modified) to our conditional request
+	void fetchingNotModified();
 	void fetchingFailed();
 
-	/// Parse fetched source xml data and return true only when the data is changed
+	/// Start parsing fetched source xml data out of the main thread.
+	/// Return false if there is nothing to parse, otherwise parsed() signal is emitted later.
 	bool parse();
 
 	void load(QSettings &settings);
-	void save(QSettings &settings);
+	void load(QDataStream &stream);
+	void save(QDataStream &stream) const;
 
 public slots:
 
@@ -87,9 +108,21 @@ signals:
 	void isReadChanged();
 	void updated();
 
+	/// Some item image link is found at its site content
+	void imageLinkResolved();
+
+	/// Parsing started by parse() is finished, isChanged is true only when the data is changed
+	void parsed(bool isChanged);
+
 protected:
 
 private:
+	/// Delay before the next fetch after the first failed one
+	static const int _minFetchingBackoff;
+
+	/// The delay is doubled after each failed fetch but it is not greater than this value
+	static const int _maxFetchingBackoff;
+
 	QString _language;
 	QString _copyright;
 	QString _editorEmail;
@@ -105,11 +138,18 @@ private:
 	QString _skipDays;
 
 	QUrl _feedLink;
+	QByteArray _etag;
+	QByteArray _lastModified;
+	int _ttl = 0;
 
 	QByteArray _source;
 	QByteArray _lastSourceHash;
 	bool _isFetching = false;
 	bool _isFailed = false;
+	bool _isParsing = false;
+	int _parseId = 0;
+	int _failedCount = 0;
+	QDateTime _nextFetchTime;
 
 	QList<QSharedPointer<RssItem>> _list;
 
@@ -118,16 +158,23 @@ private:
 	void setIsFetching(bool isFetching);
 	void setIsFailed(bool isFailed);
 
-	QByteArray countSourceHash(const QByteArray &source) const;
+	static QByteArray countSourceHash(const QByteArray &source);
 
 	void removeOldItems();
 
-	void parseRss(QXmlStreamReader &xml);
-	void parseAtomFeed(QXmlStreamReader &xml);
-	void parseChannel(QXmlStreamReader &xml);
-	void parseChannelImage(QXmlStreamReader &xml);
-	void parseItem(QXmlStreamReader &xml);
-	void parseAtomEntry(QXmlStreamReader &xml);
+	/// Data of the channel and its new items parsed out of the main thread
+	struct ParsedFeed;
+
+	static void parseSource(const QByteArray &source, ParsedFeed &feed);
+	static void parseRss(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void parseAtomFeed(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void parseChannel(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void parseChannelImage(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void parseItem(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void parseAtomEntry(QXmlStreamReader &xml, ParsedFeed &feed);
+	static void addParsedItem(QXmlStreamReader &xml, ParsedFeed &feed, RssItemData &&data);
+
+	void applyParsedFeed(const ParsedFeed &feed);
 
 	QSharedPointer<RssItem> find(const QSharedPointer<RssItem> &item);
 	void merge(const QSharedPointer<RssItem> &item);
@@ -6,12 +6,22 @@
 #include <logs.h>
 
 #include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QTimer>
 #include <QJsonDocument>
 
 namespace Bettergram {
 
 const int RssChannelList::_defaultFreq = 60;
 
+// "BGFD", Bettergram feeds data
+const quint32 RssChannelList::_dataMagic = 0x42474644;
+const qint32 RssChannelList::_dataVersion = 1;
+
+const int RssChannelList::_imageLinksSaveDelay = 10 * 1000;
+
 QString RssChannelList::getName(NewsType newsType)
 {
 	switch(newsType) {
@@ -186,6 +196,8 @@ void RssChannelList::add(QSharedPointer<RssChannel> &channel)
 {
 	connect(channel.data(), &RssChannel::iconChanged, this, &RssChannelList::iconChanged);
 	connect(channel.data(), &RssChannel::isReadChanged, this, &RssChannelList::onIsReadChanged);
+	connect(channel.data(), &RssChannel::parsed, this, &RssChannelList::onChannelParsed);
+	connect(channel.data(), &RssChannel::imageLinkResolved, this, &RssChannelList::onImageLinkResolved);
 
 	_list.push_back(channel);
 }
@@ -235,26 +247,40 @@ void RssChannelList::parseFeeds()
 		}
 	}
 
-	bool isChanged = false;
 	bool isAtLeastOneUpdated = false;
 
 	for (const QSharedPointer<RssChannel> &channel : _list) {
 		if (!channel->isFailed()) {
 			isAtLeastOneUpdated = true;
 
-			if (channel->parse()) {
-				isChanged = true;
-			}
+			// Channels are parsed out of the main thread and we get results at onChannelParsed()
+			channel->parse();
 		}
 	}
 
+	if (isAtLeastOneUpdated) {
+		setLastUpdate(QDateTime::currentDateTime());
+	}
+}
+
+void RssChannelList::onChannelParsed(bool isChanged)
+{
 	if (isChanged) {
-		save();
-		emit updated();
+		_isFeedsChanged = true;
 	}
 
-	if (isAtLeastOneUpdated) {
-		setLastUpdate(QDateTime::currentDateTime());
+	for (const QSharedPointer<RssChannel> &channel : _list) {
+		if (channel->isParsing()) {
+			return;
+		}
+	}
+
+	// We save and update the list only once when all channels are parsed
+	if (_isFeedsChanged) {
+		_isFeedsChanged = false;
+
+		save();
+		emit updated();
 	}
 }
 
@@ -318,26 +344,75 @@ void RssChannelList::parseChannelList(const QJsonObject &json)
 
 void RssChannelList::save()
 {
-	QSettings settings(BettergramService::instance()->settingsPath(_name), QSettings::IniFormat);
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_1);
 
-	settings.beginGroup(_name);
+	stream << _dataMagic << _dataVersion << _lastUpdate << qint32(_freq) << qint32(_list.size());
 
-	settings.setValue("lastUpdate", _lastUpdate);
-	settings.setValue("frequency", _freq);
-	settings.beginWriteArray("channels", _list.size());
+	for (const QSharedPointer<RssChannel> &channel : _list) {
+		channel->save(stream);
+	}
 
-	for (int i = 0; i < _list.size(); i++) {
-		const QSharedPointer<RssChannel> &channel = _list.at(i);
+	const QString path = BettergramService::instance()->dataPath(_name);
+	QDir().mkpath(QFileInfo(path).absolutePath());
 
-		settings.setArrayIndex(i);
-		channel->save(settings);
+	QSaveFile file(path);
+
+	if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+		LOG(("Unable to save %1 to %2. %3").arg(_name).arg(path).arg(file.errorString()));
+		return;
 	}
 
-	settings.endArray();
-	settings.endGroup();
+	// The data file replaces the old settings file, so we do not need it anymore
+	QFile::remove(BettergramService::instance()->settingsPath(_name));
 }
 
 void RssChannelList::load()
+{
+	QFile file(BettergramService::instance()->dataPath(_name));
+
+	if (!file.open(QIODevice::ReadOnly)) {
+		loadSettings();
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	quint32 magic = 0;
+	qint32 version = 0;
+
+	stream >> magic >> version;
+
+	if (magic != _dataMagic || version != _dataVersion) {
+		LOG(("Unable to load %1, unknown data file version %2").arg(_name).arg(version));
+		return;
+	}
+
+	QDateTime lastUpdate;
+	qint32 freq = _defaultFreq;
+	qint32 size = 0;
+
+	stream >> lastUpdate >> freq >> size;
+
+	setLastUpdate(lastUpdate);
+	setFreq(freq);
+
+	for (qint32 i = 0; i < size && stream.status() == QDataStream::Ok; i++) {
+		QSharedPointer<RssChannel> channel(new RssChannel(_imageWidth, _imageHeight));
+
+		channel->load(stream);
+
+		add(channel);
+	}
+
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("Unable to load %1, data file is corrupted").arg(_name));
+	}
+}
+
+void RssChannelList::loadSettings()
 {
 	QSettings settings(BettergramService::instance()->settingsPath(_name), QSettings::IniFormat);
 
@@ -366,4 +441,19 @@ void RssChannelList::onIsReadChanged()
 	save();
 }
 
+void RssChannelList::onImageLinkResolved()
+{
+	// Many images are resolved while the user scrolls the news, so we save them together
+	if (_isSaveScheduled) {
+		return;
+	}
+
+	_isSaveScheduled = true;
+
+	QTimer::singleShot(_imageLinksSaveDelay, Qt::VeryCoarseTimer, this, [this] {
+		_isSaveScheduled = false;
+		save();
+	});
+}
+
 } // namespace Bettergrams
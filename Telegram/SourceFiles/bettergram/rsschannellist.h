@@ -74,6 +74,13 @@ private:
 	/// Default frequency of updates in seconds
 	static const int _defaultFreq;
 
+	/// Header of the binary data file, we change the version when the format is changed
+	static const quint32 _dataMagic;
+	static const qint32 _dataVersion;
+
+	/// Delay of saving image links those are found at sites, in milliseconds
+	static const int _imageLinksSaveDelay;
+
 	QList<QSharedPointer<RssChannel>> _list;
 
 	const NewsType _newsType;
@@ -91,6 +98,11 @@ private:
 	QString _lastUpdateString;
 	QByteArray _lastSourceHash;
 
+	/// True if at least one channel is changed since the last save
+	bool _isFeedsChanged = false;
+
+	bool _isSaveScheduled = false;
+
 	static QString getName(NewsType newsType);
 
 	void setLastUpdate(const QDateTime &lastUpdate);
@@ -100,8 +112,13 @@ private:
 
 	void save();
 
+	/// Load the list from the old settings file, we used it before the binary data file
+	void loadSettings();
+
 private slots:
 	void onIsReadChanged();
+	void onChannelParsed(bool isChanged);
+	void onImageLinkResolved();
 };
 
 } // namespace Bettergram
@@ -18,6 +18,9 @@ RssItem::RssItem(RssChannel *channel) :
 		throw std::invalid_argument("RSS Channel is null");
 	}
 
+	// Feeds may have thousands of items, so we download images of visible items only
+	setIsImageDownloadOnDemand(true);
+
 	connect(_channel, &RssChannel::destroyed, this, &RssItem::onChannelDestroyed);
 }
 
@@ -46,9 +49,30 @@ RssItem::RssItem(const QString &guid,
 		throw std::invalid_argument("RSS Channel is null");
 	}
 
+	// Feeds may have thousands of items, so we download images of visible items only
+	setIsImageDownloadOnDemand(true);
+
 	connect(_channel, &RssChannel::destroyed, this, &RssItem::onChannelDestroyed);
 }
 
+RssItem::RssItem(const RssItemData &data, RssChannel *channel) :
+	RssItem(data.guid,
+			data.title,
+			data.description,
+			data.author,
+			data.categoryList,
+			data.link,
+			data.commentsLink,
+			data.publishDate,
+			channel)
+{
+	if (data.imageLink.isValid()) {
+		setImageLink(data.imageLink);
+	} else {
+		_siteLink = data.link;
+	}
+}
+
 const QString &RssItem::guid() const
 {
 	return _guid;
@@ -75,10 +99,6 @@ QPixmap RssItem::image() const
 		return BaseArticlePreviewItem::image();
 	}
 
-	if (_imageFromSite && !_imageFromSite->isNull()) {
-		return _imageFromSite->image();
-	}
-
 	if (!_channel) {
 		LOG(("RSS Channel is null"));
 		return QPixmap();
@@ -87,14 +107,24 @@ QPixmap RssItem::image() const
 	return _channel->icon();
 }
 
+void RssItem::preloadImage()
+{
+	if (isImageLinkValid()) {
+		BaseArticlePreviewItem::preloadImage();
+	} else if (!_imageFromSite && _siteLink.isValid()) {
+		// It is the first time when the image is needed, so we start to look for it at the site
+		createImageFromSite();
+	}
+}
+
 bool RssItem::isOld(const QDateTime &now) const
 {
 	return now.msecsTo(publishDate()) < -_maxLastHoursInMs;
 }
 
-void RssItem::tryToGetImageLink(const QString &text)
+void RssItem::tryToGetImageLink(const QString &text, QUrl &imageLink)
 {
-	if (isImageLinkValid()) {
+	if (imageLink.isValid()) {
 		return;
 	}
 
@@ -128,7 +158,7 @@ void RssItem::tryToGetImageLink(const QString &text)
 	QUrl url(urlString);
 
 	if (url.isValid()) {
-		setImageLink(url);
+		imageLink = url;
 	}
 }
 
@@ -159,6 +189,11 @@ bool RssItem::equalsTo(const QSharedPointer<RssItem> &item)
 
 void RssItem::update(const QSharedPointer<RssItem> &item)
 {
+	// The feed still does not have image for this item, so we keep the one found at the site
+	const QUrl imageLinkFromSite = (!item->isImageLinkValid() && item->link() == link())
+			? imageLink()
+			: QUrl();
+
 	updateBaseItem(item);
 
 	_guid = item->_guid;
@@ -166,12 +201,14 @@ void RssItem::update(const QSharedPointer<RssItem> &item)
 	_categoryList = item->_categoryList;
 	_commentsLink = item->_commentsLink;
 
-	if (_imageFromSite && item->_imageFromSite) {
-		_imageFromSite->setLink(item->_imageFromSite->link());
-	} else if (!_imageFromSite && item->_imageFromSite) {
-		createImageFromSite();
+	if (imageLinkFromSite.isValid()) {
+		setImageLink(imageLinkFromSite);
+	} else if (item->_siteLink.isValid()) {
+		_siteLink = item->_siteLink;
 
-		_imageFromSite->setLink(item->_imageFromSite->link());
+		if (_imageFromSite) {
+			_imageFromSite->setLink(_siteLink);
+		}
 	}
 
 	_isExistAtLastFeeds = true;
@@ -179,15 +216,16 @@ void RssItem::update(const QSharedPointer<RssItem> &item)
 	// We do not change _isRead field in this method
 }
 
-void RssItem::parse(QXmlStreamReader &xml)
+void RssItem::parse(QXmlStreamReader &xml, RssItemData &data)
 {
-	_categoryList.clear();
+	data.isAtom = false;
+	data.categoryList.clear();
 
 	while (xml.readNextStartElement()) {
 		if (!xml.prefix().isEmpty()) {
 			if (xml.name() == QLatin1String("encoded")
 					&& xml.namespaceUri() == "http://purl.org/rss/1.0/modules/content/") {
-				tryToGetImageLink(xml.readElementText());
+				data.content = xml.readElementText();
 				continue;
 			}
 
@@ -198,35 +236,27 @@ void RssItem::parse(QXmlStreamReader &xml)
 		QStringRef xmlName = xml.name();
 
 		if (xmlName == QLatin1String("guid")) {
-			_guid = xml.readElementText();
+			data.guid = xml.readElementText();
 		} else if (xmlName == QLatin1String("title")) {
-			const QString elementText = xml.readElementText();
-
-			tryToGetImageLink(elementText);
-
-			setTitle(removeHtmlTags(elementText));
+			data.title = xml.readElementText();
 		} else if (xmlName == QLatin1String("description")) {
-			const QString elementText = xml.readElementText();
-
-			tryToGetImageLink(elementText);
-
-			setDescription(removeHtmlTags(elementText));
+			data.description = xml.readElementText();
 		} else if (xmlName == QLatin1String("author")) {
-			_author = xml.readElementText();
+			data.author = xml.readElementText();
 		} else if (xmlName == QLatin1String("category")) {
-			_categoryList.push_back(xml.readElementText());
+			data.categoryList.push_back(xml.readElementText());
 		} else if (xmlName == QLatin1String("link")) {
-			setLink(xml.readElementText());
+			data.link = xml.readElementText();
 		} else if (xmlName == QLatin1String("comments")) {
-			_commentsLink = xml.readElementText();
+			data.commentsLink = xml.readElementText();
 		} else if (xmlName == QLatin1String("pubDate")) {
-			setPublishDate(QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date));
+			data.publishDate = QDateTime::fromString(xml.readElementText(), Qt::RFC2822Date);
 		} else if (xmlName == QLatin1String("enclosure")) {
 			QUrl url = QUrl(xml.attributes().value("url").toString());
 
 			if (url.isValid()) {
 				if (xml.attributes().value("type").contains("image")) {
-					setImageLink(url);
+					data.imageLink = url;
 				}
 			}
 			xml.skipCurrentElement();
@@ -234,16 +264,12 @@ void RssItem::parse(QXmlStreamReader &xml)
 			xml.skipCurrentElement();
 		}
 	}
-
-	if (!isImageLinkValid()) {
-		createImageFromSite();
-		_imageFromSite->setLink(link());
-	}
 }
 
-void RssItem::parseAtom(QXmlStreamReader &xml)
+void RssItem::parseAtom(QXmlStreamReader &xml, RssItemData &data)
 {
-	_categoryList.clear();
+	data.isAtom = true;
+	data.categoryList.clear();
 
 	while (xml.readNextStartElement()) {
 		QStringRef xmlName = xml.name();
@@ -251,44 +277,37 @@ void RssItem::parseAtom(QXmlStreamReader &xml)
 
 		if (xmlNamespace.isEmpty() || xmlNamespace == "http://www.w3.org/2005/Atom") {
 			if (xmlName == QLatin1String("id")) {
-				_guid = xml.readElementText();
+				data.guid = xml.readElementText();
 			} else if (xmlName == QLatin1String("title")) {
-				setTitle(removeHtmlTags(xml.readElementText()));
+				data.title = xml.readElementText();
 			} else if (xmlName == QLatin1String("category")) {
-				_categoryList.push_back(xml.attributes().value("term").toString());
+				data.categoryList.push_back(xml.attributes().value("term").toString());
 				xml.skipCurrentElement();
 			} else if (xmlName == QLatin1String("link")) {
-				setLink(QUrl(xml.attributes().value("href").toString()));
+				data.link = QUrl(xml.attributes().value("href").toString());
 				xml.skipCurrentElement();
-			} else if (xmlName == QLatin1String("category")) {
-				_categoryList.push_back(xml.attributes().value("term").toString());
 			} else if (xmlName == QLatin1String("published")) {
-				if (publishDate().isValid()) {
+				if (data.publishDate.isValid()) {
 					xml.skipCurrentElement();
 				} else {
-					setPublishDate(QDateTime::fromString(xml.readElementText(), Qt::ISODate));
+					data.publishDate = QDateTime::fromString(xml.readElementText(), Qt::ISODate);
 				}
 			} else if (xmlName == QLatin1String("updated")) {
-				setPublishDate(QDateTime::fromString(xml.readElementText(), Qt::ISODate));
+				data.publishDate = QDateTime::fromString(xml.readElementText(), Qt::ISODate);
 			} else {
 				xml.skipCurrentElement();
 			}
 		} else if (xmlNamespace  == "http://search.yahoo.com/mrss/") {
 			if (xmlName == QLatin1String("group")) {
-				parseAtomMediaGroup(xml);
+				parseAtomMediaGroup(xml, data);
 			}
 		} else {
 			xml.skipCurrentElement();
 		}
 	}
-
-	if (!isImageLinkValid()) {
-		createImageFromSite();
-		_imageFromSite->setLink(link());
-	}
 }
 
-void RssItem::parseAtomMediaGroup(QXmlStreamReader &xml)
+void RssItem::parseAtomMediaGroup(QXmlStreamReader &xml, RssItemData &data)
 {
 	while (xml.readNextStartElement()) {
 		QStringRef xmlName = xml.name();
@@ -300,9 +319,9 @@ void RssItem::parseAtomMediaGroup(QXmlStreamReader &xml)
 		}
 
 		if (xmlName == QLatin1String("description")) {
-			setDescription(xml.readElementText());
+			data.description = xml.readElementText();
 		} else if (xmlName == QLatin1String("thumbnail")) {
-			setImageLink(QUrl(xml.attributes().value("url").toString()));
+			data.imageLink = QUrl(xml.attributes().value("url").toString());
 			xml.skipCurrentElement();
 		} else {
 			xml.skipCurrentElement();
@@ -310,6 +329,23 @@ void RssItem::parseAtomMediaGroup(QXmlStreamReader &xml)
 	}
 }
 
+void RssItem::prepareData(RssItemData &data)
+{
+	if (data.isAtom) {
+		// Media description of Atom entries is a plain text already
+		data.title = removeHtmlTags(data.title);
+		return;
+	}
+
+	tryToGetImageLink(data.title, data.imageLink);
+	tryToGetImageLink(data.description, data.imageLink);
+	tryToGetImageLink(data.content, data.imageLink);
+
+	data.title = removeHtmlTags(data.title);
+	data.description = removeHtmlTags(data.description);
+	data.content.clear();
+}
+
 void RssItem::load(QSettings &settings)
 {
 	BaseArticlePreviewItem::load(settings);
@@ -321,21 +357,26 @@ void RssItem::load(QSettings &settings)
 	_commentsLink = settings.value("commentsLink").toUrl();
 
 	if (!isImageLinkValid() && link().isValid()) {
-		createImageFromSite();
-
-		_imageFromSite->setLink(link());
+		_siteLink = link();
 	}
 }
 
-void RssItem::save(QSettings &settings)
+void RssItem::load(QDataStream &stream)
 {
-	BaseArticlePreviewItem::save(settings);
+	BaseArticlePreviewItem::load(stream);
 
-	settings.setValue("guid", guid());
-	settings.setValue("author", author());
-	settings.setValue("categoryList", categoryList());
+	stream >> _guid >> _author >> _categoryList >> _commentsLink;
 
-	settings.setValue("commentsLink", commentsLink().toString());
+	if (!isImageLinkValid() && link().isValid()) {
+		_siteLink = link();
+	}
+}
+
+void RssItem::save(QDataStream &stream) const
+{
+	BaseArticlePreviewItem::save(stream);
+
+	stream << _guid << _author << _categoryList << _commentsLink;
 }
 
 QString RssItem::removeHtmlTags(const QString &text)
@@ -356,9 +397,41 @@ void RssItem::createImageFromSite()
 		return;
 	}
 
-	_imageFromSite = new ImageFromSite(_channel->iconWidth(), _channel->iconHeight(), this);
+	_imageFromSite = new ImageFromSite(this);
+
+	connect(_imageFromSite, &ImageFromSite::imageLinkFound, this, &RssItem::onImageLinkFound);
+	connect(_imageFromSite, &ImageFromSite::imageLinkNotFound, this, &RssItem::onImageLinkNotFound);
+
+	_imageFromSite->setLink(_siteLink);
+}
+
+void RssItem::deleteImageFromSite()
+{
+	if (_imageFromSite) {
+		_imageFromSite->deleteLater();
+		_imageFromSite = nullptr;
+	}
+}
+
+void RssItem::onImageLinkFound(QUrl imageLink)
+{
+	deleteImageFromSite();
+
+	_siteLink = QUrl();
+	setImageLink(imageLink);
+
+	// The image is requested already, so we do not wait for the next preloadImage() call
+	BaseArticlePreviewItem::preloadImage();
+
+	emit imageLinkResolved();
+}
+
+void RssItem::onImageLinkNotFound()
+{
+	deleteImageFromSite();
 
-	connect(_imageFromSite, &ImageFromSite::imageChanged, this, &RssItem::imageChanged);
+	// We do not try this site again until the next application start
+	_siteLink = QUrl();
 }
 
 void RssItem::onChannelDestroyed()
@@ -11,6 +11,26 @@ namespace Bettergram {
 class RssChannel;
 class ImageFromSite;
 
+/**
+ * @brief The RssItemData struct contains data of a RSS item parsed out of the main thread.
+ * Title and description contain raw html until RssItem::prepareData() is called.
+ */
+struct RssItemData {
+	QString guid;
+	QString title;
+	QString description;
+	QString author;
+	QStringList categoryList;
+	QUrl link;
+	QUrl commentsLink;
+	QUrl imageLink;
+	QDateTime publishDate;
+
+	/// Raw <content:encoded> text, we use it only to find the item image
+	QString content;
+	bool isAtom = false;
+};
+
 /**
  * @brief The RssItem class contains information from a RSS item.
  */
@@ -30,11 +50,14 @@ public:
 					 const QDateTime &publishDate,
 					 RssChannel *channel);
 
+	explicit RssItem(const RssItemData &data, RssChannel *channel);
+
 	const QString &guid() const;
 	const QString &author() const;
 	const QStringList &categoryList() const;
 	const QUrl &commentsLink() const;
 	QPixmap image() const override;
+	void preloadImage() override;
 
 	bool isOld(const QDateTime &now = QDateTime::currentDateTime()) const;
 
@@ -46,15 +69,23 @@ public:
 	bool equalsTo(const QSharedPointer<RssItem> &item);
 	void update(const QSharedPointer<RssItem> &item);
 
-	void parse(QXmlStreamReader &xml);
-	void parseAtom(QXmlStreamReader &xml);
+	/// These methods are thread safe, they only read raw values from xml
+	static void parse(QXmlStreamReader &xml, RssItemData &data);
+	static void parseAtom(QXmlStreamReader &xml, RssItemData &data);
+
+	/// Remove html tags and find the image link. It is the most expensive part of parsing,
+	/// so we call it only for items that are not known by the channel yet
+	static void prepareData(RssItemData &data);
 
 	void load(QSettings &settings);
-	void save(QSettings &settings);
+	void load(QDataStream &stream);
+	void save(QDataStream &stream) const;
 
 public slots:
 
 signals:
+	/// The item image link is found at the site content, so the item should be saved
+	void imageLinkResolved();
 
 protected:
 
@@ -73,22 +104,28 @@ private:
 	/// We try to get _imageLink from <enclosure url="link-to-image" type="image/..."/>,
 	/// or from <description>Text <img src="link-to-image"></description>,
 	/// or from <title>Text <img src="link-to-image"></title> tags,
-	/// or try to get the largest image from the site content
+	/// or try to get the largest image from the site content.
+	/// The site content is downloaded only when the item image is preloaded at the first time,
+	/// that is when the item is nearly visible, and the found link is stored as the item image link.
 	ImageFromSite *_imageFromSite = nullptr;
+	QUrl _siteLink;
 
 	/// True if this item exists at the last feeds from sites.
 	bool _isExistAtLastFeeds = true;
 
 	static QString removeHtmlTags(const QString &text);
 
-	void tryToGetImageLink(const QString &text);
+	static void tryToGetImageLink(const QString &text, QUrl &imageLink);
 
-	void parseAtomMediaGroup(QXmlStreamReader &xml);
+	static void parseAtomMediaGroup(QXmlStreamReader &xml, RssItemData &data);
 
 	void createImageFromSite();
+	void deleteImageFromSite();
 
 private slots:
 	void onChannelDestroyed();
+	void onImageLinkFound(QUrl imageLink);
+	void onImageLinkNotFound();
 };
 
 } // namespace Bettergram
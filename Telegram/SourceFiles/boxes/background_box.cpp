@@ -71,7 +71,7 @@ protected:
 private:
 	struct Paper {
 		Data::WallPaper data;
-		mutable QPixmap thumbnail;
+		QPixmap thumbnail;
 	};
 	struct Selected {
 		int index = 0;
@@ -103,10 +103,12 @@ private:
 		Painter &p,
 		const Paper &paper,
 		int column,
-		int row) const;
-	void validatePaperThumbnail(const Paper &paper) const;
+		int row);
+	void validatePaperThumbnail(const Paper &paper);
+	void paperThumbnailPrepared(WallPaperId id, QImage &&image);
 
 	std::vector<Paper> _papers;
+	base::flat_set<WallPaperId> _preparingThumbnails;
 
 	Selection _over;
 	Selection _overDown;
@@ -272,8 +274,7 @@ void BackgroundBox::Inner::paintEvent(QPaintEvent *e) {
 	}
 }
 
-void BackgroundBox::Inner::validatePaperThumbnail(
-		const Paper &paper) const {
+void BackgroundBox::Inner::validatePaperThumbnail(const Paper &paper) {
 	Expects(paper.data.thumbnail() != nullptr);
 
 	const auto thumbnail = paper.data.thumbnail();
@@ -283,26 +284,52 @@ void BackgroundBox::Inner::validatePaperThumbnail(
 		thumbnail->load(paper.data.fileOrigin());
 		return;
 	}
-	auto original = thumbnail->original();
-	if (paper.data.isPattern()) {
-		const auto color = *paper.data.backgroundColor();
-		original = Data::PreparePatternImage(
-			std::move(original),
-			color,
-			Data::PatternColor(color),
-			paper.data.patternIntensity());
+	const auto id = paper.data.id();
+	if (!_preparingThumbnails.emplace(id).second) {
+		return;
+	}
+
+	// Only painted papers get here, so we decode just the visible range.
+	const auto pattern = paper.data.isPattern()
+		? paper.data.backgroundColor()
+		: std::nullopt;
+	const auto intensity = paper.data.patternIntensity();
+	const auto size = st::backgroundSize;
+	crl::async([=, original = thumbnail->original()]() mutable {
+		if (pattern) {
+			original = Data::PreparePatternImage(
+				std::move(original),
+				*pattern,
+				Data::PatternColor(*pattern),
+				intensity);
+		}
+		auto prepared = TakeMiddleSample(original, size);
+		crl::on_main(this, [=, prepared = std::move(prepared)]() mutable {
+			paperThumbnailPrepared(id, std::move(prepared));
+		});
+	});
+}
+
+void BackgroundBox::Inner::paperThumbnailPrepared(
+		WallPaperId id,
+		QImage &&image) {
+	_preparingThumbnails.remove(id);
+	const auto i = ranges::find(_papers, id, [](const Paper &paper) {
+		return paper.data.id();
+	});
+	if (i == end(_papers) || !i->thumbnail.isNull()) {
+		return;
 	}
-	paper.thumbnail = App::pixmapFromImageInPlace(TakeMiddleSample(
-		original,
-		st::backgroundSize));
-	paper.thumbnail.setDevicePixelRatio(cRetinaFactor());
+	i->thumbnail = App::pixmapFromImageInPlace(std::move(image));
+	i->thumbnail.setDevicePixelRatio(cRetinaFactor());
+	repaintPaper(i - begin(_papers));
 }
 
 void BackgroundBox::Inner::paintPaper(
 		Painter &p,
 		const Paper &paper,
 		int column,
-		int row) const {
+		int row) {
 	const auto x = st::backgroundPadding + column * (st::backgroundSize.width() + st::backgroundPadding);
 	const auto y = st::backgroundPadding + row * (st::backgroundSize.height() + st::backgroundPadding);
 	validatePaperThumbnail(paper);
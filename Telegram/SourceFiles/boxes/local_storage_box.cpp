@@ -340,6 +340,9 @@ void LocalStorageBox::update(
 			updateRow(entry.second, &full);
 		}
 	}
+	if (_hotLabel) {
+		updateHotLabel();
+	}
 }
 
 auto LocalStorageBox::summary() const -> Database::TaggedSummary {
@@ -519,6 +522,17 @@ void LocalStorageBox::updateMediaLabel() {
 	_mediaLabel->setText(lng_local_storage_media_limit(lt_size, text));
 }
 
+void LocalStorageBox::updateHotLabel() {
+	Expects(_hotLabel != nullptr);
+
+	const auto hits = _stats.hot.hits + _statsBig.hot.hits;
+	const auto total = hits + _stats.hot.misses + _statsBig.hot.misses;
+	const auto percent = total ? (hits * 100 / total) : 0;
+	_hotLabel->setText(lng_local_storage_memory_hits(
+		lt_percent,
+		QString::number(percent)));
+}
+
 void LocalStorageBox::setupLimits(not_null<Ui::VerticalLayout*> container) {
 	const auto shadow = container->add(
 		object_ptr<Ui::PlainShadow>(container),
@@ -561,6 +575,11 @@ void LocalStorageBox::setupLimits(not_null<Ui::VerticalLayout*> container) {
 			label->setText(lng_local_storage_time_limit(lt_limit, text));
 			limitsChanged();
 		});
+
+	_hotLabel = container->add(
+		object_ptr<Ui::LabelSimple>(container, st::localStorageLimitLabel),
+		st::localStorageLimitLabelMargin);
+	updateHotLabel();
 }
 
 void LocalStorageBox::limitsChanged() {
@@ -57,6 +57,7 @@ private:
 	void updateTotalLimit();
 	void updateTotalLabel();
 	void updateMediaLabel();
+	void updateHotLabel();
 	void limitsChanged();
 	void save();
 
@@ -89,6 +90,7 @@ private:
 	Ui::LabelSimple *_totalLabel = nullptr;
 	Ui::MediaSlider *_mediaSlider = nullptr;
 	Ui::LabelSimple *_mediaLabel = nullptr;
+	Ui::LabelSimple *_hotLabel = nullptr;
 
 	int64 _totalSizeLimit = 0;
 	int64 _mediaSizeLimit = 0;
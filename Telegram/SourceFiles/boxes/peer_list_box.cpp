@@ -29,6 +29,13 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_session.h"
 #include "window/themes/window_theme.h"
 
+namespace {
+
+// Rows keep their texts until there are that many initialized ones.
+constexpr auto kHeavyRowsLimit = 512;
+
+} // namespace
+
 auto PaintUserpicCallback(
 	not_null<PeerData*> peer,
 	bool respectSavedMessagesChat)
@@ -544,6 +551,17 @@ void PeerListRow::lazyInitialize(const style::PeerListItem &st) {
 	refreshStatus();
 }
 
+void PeerListRow::clearHeavyPart() {
+	if (!_initialized) {
+		return;
+	}
+	_initialized = false;
+	_name.clear();
+	if (_statusType != StatusType::Custom) {
+		_status.clear();
+	}
+}
+
 void PeerListRow::createCheckbox(Fn<void()> updateCallback) {
 	_checkbox = std::make_unique<Ui::RoundImageCheckbox>(
 		st::contactsPhotoCheckbox,
@@ -566,6 +584,10 @@ PeerListContent::PeerListContent(
 , _st(st)
 , _controller(controller)
 , _rowHeight(_st.item.height) {
+	// paintEvent() fills the whole clip, so the scroll area is able
+	// to blit the already painted rows and repaint only the new strip.
+	setAttribute(Qt::WA_OpaquePaintEvent);
+
 	subscribe(Auth().downloaderTaskFinished(), [this] { update(); });
 
 	using UpdateFlag = Notify::PeerUpdate::Flag;
@@ -582,7 +604,10 @@ PeerListContent::PeerListContent(
 			invalidatePixmapsCache();
 		}
 	});
-	_repaintByStatus.setCallback([this] { update(); });
+	Auth().data().onlineTextRefreshes(
+	) | rpl::start_with_next([=] {
+		update();
+	}, lifetime());
 }
 
 void PeerListContent::appendRow(std::unique_ptr<PeerListRow> row) {
@@ -770,6 +795,7 @@ void PeerListContent::clearAllContent() {
 	_rowsByPeer.clear();
 	_filterResults.clear();
 	_searchIndex.clear();
+	_heavyRows.clear();
 	_rows.clear();
 	_searchRows.clear();
 	_searchQuery
@@ -896,8 +922,7 @@ void PeerListContent::paintEvent(QPaintEvent *e) {
 	auto clip = e->rect();
 	p.fillRect(clip, _st.item.button.textBg);
 
-	auto repaintByStatusAfter = _repaintByStatus.remainingTime();
-	auto repaintAfterMin = repaintByStatusAfter;
+	auto repaintAfterMin = crl::time(-1);
 
 	auto rowsTopCached = rowsTop();
 	auto ms = crl::now();
@@ -919,9 +944,8 @@ void PeerListContent::paintEvent(QPaintEvent *e) {
 			p.translate(0, _rowHeight);
 		}
 	}
-	if (repaintAfterMin != repaintByStatusAfter) {
-		Assert(repaintAfterMin >= 0);
-		_repaintByStatus.callOnce(repaintAfterMin);
+	if (repaintAfterMin >= 0) {
+		Auth().data().scheduleOnlineTextRefresh(ms + repaintAfterMin);
 	}
 }
 
@@ -1076,7 +1100,10 @@ crl::time PeerListContent::paintRow(Painter &p, crl::time ms, RowIndex index) {
 	auto row = getRow(index);
 	Assert(row != nullptr);
 
-	row->lazyInitialize(_st.item);
+	if (!row->isInitialized()) {
+		row->lazyInitialize(_st.item);
+		_heavyRows.emplace(row->id());
+	}
 
 	auto refreshStatusAt = row->refreshStatusTime();
 	if (refreshStatusAt >= 0 && ms >= refreshStatusAt) {
@@ -1268,7 +1295,8 @@ void PeerListContent::loadProfilePhotos() {
 			if (to > rowsCount) to = rowsCount;
 
 			for (auto index = from; index != to; ++index) {
-				getRow(RowIndex(index))->peer()->loadUserpic();
+				getRow(RowIndex(index))->peer()->prepareUserpic(
+					_st.item.photoSize);
 			}
 		}
 	}
@@ -1410,6 +1438,34 @@ void PeerListContent::visibleTopBottomUpdated(
 	_visibleBottom = visibleBottom;
 	loadProfilePhotos();
 	checkScrollForPreload();
+	clearHeavyRows();
+}
+
+void PeerListContent::clearHeavyRows() {
+	if (_heavyRows.size() < kHeavyRowsLimit
+		|| _visibleTop >= _visibleBottom
+		|| _rowHeight <= 0) {
+		return;
+	}
+
+	// Keep the rows of the visible screen and one screen around it.
+	const auto visibleHeight = _visibleBottom - _visibleTop;
+	const auto rowsCount = shownRowsCount();
+	const auto top = _visibleTop - rowsTop() - visibleHeight;
+	const auto bottom = _visibleBottom - rowsTop() + visibleHeight;
+	const auto from = std::max(top / _rowHeight, 0);
+	const auto till = std::min(bottom / _rowHeight + 1, rowsCount);
+	auto keep = base::flat_set<PeerListRowId>();
+	for (auto index = from; index < till; ++index) {
+		keep.emplace(getRow(RowIndex(index))->id());
+	}
+	for (const auto id : base::take(_heavyRows)) {
+		if (keep.contains(id)) {
+			_heavyRows.emplace(id);
+		} else if (const auto row = findRow(id)) {
+			row->clearHeavyPart();
+		}
+	}
 }
 
 void PeerListContent::setSelected(Selected selected) {
@@ -175,6 +175,13 @@ public:
 	}
 
 	virtual void lazyInitialize(const style::PeerListItem &st);
+	bool isInitialized() const {
+		return _initialized;
+	}
+
+	// Drop the name and status texts, lazyInitialize() prepares them again.
+	void clearHeavyPart();
+
 	virtual void paintStatusText(
 		Painter &p,
 		const style::PeerListItem &st,
@@ -184,11 +191,6 @@ public:
 		int outerWidth,
 		bool selected);
 
-protected:
-	bool isInitialized() const {
-		return _initialized;
-	}
-
 private:
 	void createCheckbox(Fn<void()> updateCallback);
 	void setCheckedInternal(bool checked, SetStyle style);
@@ -552,6 +554,7 @@ private:
 	void selectByMouse(QPoint globalPosition);
 	void loadProfilePhotos();
 	void checkScrollForPreload();
+	void clearHeavyRows();
 
 	void updateRow(not_null<PeerListRow*> row, RowIndex hint);
 	void updateRow(RowIndex row);
@@ -620,7 +623,7 @@ private:
 	object_ptr<Ui::FlatLabel> _searchLoading = { nullptr };
 
 	std::vector<std::unique_ptr<PeerListRow>> _searchRows;
-	base::Timer _repaintByStatus;
+	base::flat_set<PeerListRowId> _heavyRows;
 	base::unique_qptr<Ui::PopupMenu> _contextMenu;
 
 };
@@ -137,6 +137,8 @@ public:
 private:
 	QRect countRealGeometry() const;
 	QRect countCurrentGeometry(float64 progress) const;
+	void preparePhoto();
+	void prepareFileThumb();
 	void prepareCache(QSize size, int shrink);
 	void drawSimpleFrame(Painter &p, QRect to, QSize size) const;
 
@@ -148,6 +150,7 @@ private:
 	QImage _albumCache;
 	QPoint _albumPosition;
 	RectParts _albumCorners = RectPart::None;
+	QSize _photoSize;
 	QPixmap _photo;
 	QPixmap _fileThumb;
 	QString _name;
@@ -172,35 +175,15 @@ AlbumThumb::AlbumThumb(
 
 	moveToLayout(layout);
 
-	using Option = Images::Option;
-	const auto previewWidth = _fullPreview.width();
-	const auto previewHeight = _fullPreview.height();
-	const auto imageWidth = std::max(
-		previewWidth / cIntRetinaFactor(),
-		st::minPhotoSize);
-	const auto imageHeight = std::max(
-		previewHeight / cIntRetinaFactor(),
-		st::minPhotoSize);
-	_photo = App::pixmapFromImageInPlace(Images::prepare(
-		_fullPreview,
-		previewWidth,
-		previewHeight,
-		Option::RoundedLarge | Option::RoundedAll,
-		imageWidth,
-		imageHeight));
-
-	const auto idealSize = st::sendMediaFileThumbSize * cIntRetinaFactor();
-	const auto fileThumbSize = (previewWidth > previewHeight)
-		? QSize(previewWidth * idealSize / previewHeight, idealSize)
-		: QSize(idealSize, previewHeight * idealSize / previewWidth);
-	_fileThumb = App::pixmapFromImageInPlace(Images::prepare(
-		_fullPreview,
-		fileThumbSize.width(),
-		fileThumbSize.height(),
-		Option::RoundedSmall | Option::RoundedAll,
-		st::sendMediaFileThumbSize,
-		st::sendMediaFileThumbSize
-	));
+	// Photo and file thumbnails are prepared only when the box is
+	// switched to the corresponding sending way and they are painted.
+	_photoSize = QSize(
+		std::max(
+			_fullPreview.width() / cIntRetinaFactor(),
+			st::minPhotoSize),
+		std::max(
+			_fullPreview.height() / cIntRetinaFactor(),
+			st::minPhotoSize));
 
 	const auto availableFileWidth = st::sendMediaPreviewSize
 		- st::sendMediaFileThumbSkip
@@ -281,7 +264,42 @@ void AlbumThumb::moveToLayout(const Ui::GroupMediaLayout &layout) {
 }
 
 int AlbumThumb::photoHeight() const {
-	return _photo.height() / cIntRetinaFactor();
+	return _photoSize.height();
+}
+
+void AlbumThumb::preparePhoto() {
+	if (!_photo.isNull()) {
+		return;
+	}
+	using Option = Images::Option;
+	_photo = App::pixmapFromImageInPlace(Images::prepare(
+		_fullPreview,
+		_fullPreview.width(),
+		_fullPreview.height(),
+		Option::RoundedLarge | Option::RoundedAll,
+		_photoSize.width(),
+		_photoSize.height()));
+}
+
+void AlbumThumb::prepareFileThumb() {
+	if (!_fileThumb.isNull()) {
+		return;
+	}
+	using Option = Images::Option;
+	const auto previewWidth = _fullPreview.width();
+	const auto previewHeight = _fullPreview.height();
+	const auto idealSize = st::sendMediaFileThumbSize * cIntRetinaFactor();
+	const auto fileThumbSize = (previewWidth > previewHeight)
+		? QSize(previewWidth * idealSize / previewHeight, idealSize)
+		: QSize(idealSize, previewHeight * idealSize / previewWidth);
+	_fileThumb = App::pixmapFromImageInPlace(Images::prepare(
+		_fullPreview,
+		fileThumbSize.width(),
+		fileThumbSize.height(),
+		Option::RoundedSmall | Option::RoundedAll,
+		st::sendMediaFileThumbSize,
+		st::sendMediaFileThumbSize
+	));
 }
 
 void AlbumThumb::paintInAlbum(
@@ -471,7 +489,9 @@ void AlbumThumb::drawSimpleFrame(Painter &p, QRect to, QSize size) const {
 }
 
 void AlbumThumb::paintPhoto(Painter &p, int left, int top, int outerWidth) {
-	const auto width = _photo.width() / cIntRetinaFactor();
+	preparePhoto();
+
+	const auto width = _photoSize.width();
 	p.drawPixmapLeft(
 		left + (st::sendMediaPreviewSize - width) / 2,
 		top,
@@ -480,6 +500,8 @@ void AlbumThumb::paintPhoto(Painter &p, int left, int top, int outerWidth) {
 }
 
 void AlbumThumb::paintFile(Painter &p, int left, int top, int outerWidth) {
+	prepareFileThumb();
+
 	const auto textLeft = left
 		+ st::sendMediaFileThumbSize
 		+ st::sendMediaFileThumbSkip;
@@ -36,6 +36,7 @@ namespace {
 constexpr auto kArchivedLimitFirstRequest = 10;
 constexpr auto kArchivedLimitPerPage = 30;
 constexpr auto kHandleMegagroupSetAddressChangeTimeout = crl::time(1000);
+constexpr auto kInstallRequestCanWait = crl::time(100);
 
 } // namespace
 
@@ -495,14 +496,22 @@ void StickersBox::installSet(uint64 setId) {
 	}
 	if (!(it->flags & MTPDstickerSet::Flag::f_installed_date)
 		|| (it->flags & MTPDstickerSet::Flag::f_archived)) {
+		// Several quick installs go in one container.
 		MTP::send(
 			MTPmessages_InstallStickerSet(
 				Stickers::inputSetId(*it),
 				MTP_boolFalse()),
 			rpcDone(&StickersBox::installDone),
-			rpcFail(&StickersBox::installFail, setId));
+			rpcFail(&StickersBox::installFail, setId),
+			0,
+			kInstallRequestCanWait);
 
-		Stickers::InstallLocally(setId);
+		// If we save changes on close, local storage is written once there.
+		const auto writeOnClose = _installed.widget() && !_megagroupSet;
+		Stickers::InstallLocally(setId, !writeOnClose);
+		if (writeOnClose) {
+			_localInstalled = true;
+		}
 	}
 }
 
@@ -599,9 +608,13 @@ void StickersBox::saveChanges() {
 	// Make sure that our changes in other tabs are applied in the Installed tab.
 	rebuildList(&_installed);
 
-	if (_someArchivedLoaded) {
+	const auto localInstalled = base::take(_localInstalled);
+	if (_someArchivedLoaded || localInstalled) {
 		Local::writeArchivedStickers();
 	}
+	if (localInstalled) {
+		Local::writeFeaturedStickers();
+	}
 	if (AuthSession::Exists()) {
 		Auth().api().saveStickerSets(_installed.widget()->getOrder(), _installed.widget()->getRemovedSets());
 	}
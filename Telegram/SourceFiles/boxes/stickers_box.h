@@ -128,6 +128,7 @@ private:
 
 	Stickers::Order _localOrder;
 	Stickers::Order _localRemoved;
+	bool _localInstalled = false;
 
 };
 
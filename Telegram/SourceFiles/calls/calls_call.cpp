@@ -38,6 +38,7 @@ namespace {
 constexpr auto kMinLayer = 65;
 constexpr auto kHangupTimeoutMs = 5000;
 constexpr auto kSha256Size = 32;
+constexpr auto kStatisticsSampleTimeout = crl::time(1000);
 
 void AppendEndpoint(
 		std::vector<tgvoip::Endpoint> &list,
@@ -129,6 +130,7 @@ Call::Call(
 , _user(user)
 , _type(type) {
 	_discardByTimeoutTimer.setCallback([this] { hangup(); });
+	_statisticsTimer.setCallback([this] { sampleStatistics(); });
 
 	if (_type == Type::Outgoing) {
 		setState(State::Requesting);
@@ -695,6 +697,44 @@ void Call::setSignalBarCount(int count) {
 	}
 }
 
+void Call::sampleStatistics() {
+	if (!_controller || !_startTime) {
+		return;
+	}
+	auto traffic = tgvoip::VoIPController::TrafficStats();
+	_controller->GetStats(&traffic);
+
+	const auto now = crl::now();
+	const auto sent = uint64(traffic.bytesSentWifi + traffic.bytesSentMobile);
+	const auto received = uint64(
+		traffic.bytesRecvdWifi + traffic.bytesRecvdMobile);
+	const auto elapsed = now - _statisticsSampleTime;
+	if (elapsed > 0) {
+		const auto perSecond = [&](uint64 was, uint64 value) {
+			return (value > was)
+				? int64((value - was) * 1000 / elapsed)
+				: int64(0);
+		};
+		_statistics.sentPerSecond = perSecond(_statistics.bytesSent, sent);
+		_statistics.receivedPerSecond = perSecond(
+			_statistics.bytesReceived,
+			received);
+		accumulate_max(
+			_statistics.maxSentPerSecond,
+			_statistics.sentPerSecond);
+		accumulate_max(
+			_statistics.maxReceivedPerSecond,
+			_statistics.receivedPerSecond);
+	}
+	_statistics.bytesSent = sent;
+	_statistics.bytesReceived = received;
+	_statistics.duration = now - _startTime;
+	_statistics.signalBarCount = _signalBarCount;
+	++_statistics.samplesCount;
+	_statisticsSampleTime = now;
+	_statisticsUpdated.notify();
+}
+
 template <typename T>
 bool Call::checkCallCommonFields(const T &call) {
 	auto checkFailed = [this] {
@@ -765,6 +805,8 @@ void Call::setState(State state) {
 		switch (_state) {
 		case State::Established:
 			_startTime = crl::now();
+			_statisticsSampleTime = _startTime;
+			_statisticsTimer.callEach(kStatisticsSampleTimeout);
 			break;
 		case State::ExchangingKeys:
 			_delegate->playSound(Delegate::Sound::Connecting);
@@ -895,7 +937,19 @@ void Call::handleControllerError(int error) {
 }
 
 void Call::destroyController() {
+	_statisticsTimer.cancel();
 	if (_controller) {
+		if (_statistics.samplesCount > 0) {
+			sampleStatistics();
+			DEBUG_LOG(("Call Info: Statistics, duration: %1 ms, "
+				"sent: %2 bytes (max %3 B/s), "
+				"received: %4 bytes (max %5 B/s)."
+				).arg(_statistics.duration
+				).arg(_statistics.bytesSent
+				).arg(_statistics.maxSentPerSecond
+				).arg(_statistics.bytesReceived
+				).arg(_statistics.maxReceivedPerSecond));
+		}
 		DEBUG_LOG(("Call Info: Destroying call controller.."));
 		_controller.reset();
 		DEBUG_LOG(("Call Info: Call controller destroyed."));
@@ -121,6 +121,24 @@ public:
 
 	QString getDebugLog() const;
 
+	struct Statistics {
+		crl::time duration = 0;
+		int signalBarCount = kSignalBarStarting;
+		uint64 bytesSent = 0;
+		uint64 bytesReceived = 0;
+		int64 sentPerSecond = 0;
+		int64 receivedPerSecond = 0;
+		int64 maxSentPerSecond = 0;
+		int64 maxReceivedPerSecond = 0;
+		int samplesCount = 0;
+	};
+	const Statistics &statistics() const {
+		return _statistics;
+	}
+	base::Observable<void> &statisticsUpdated() {
+		return _statisticsUpdated;
+	}
+
 	void setCurrentAudioDevice(bool input, std::string deviceID);
 	void setAudioVolume(bool input, float level);
 	void setAudioDuckingEnabled(bool enabled);
@@ -178,6 +196,7 @@ private:
 	void setStateQueued(State state);
 	void setFailedQueued(int error);
 	void setSignalBarCount(int count);
+	void sampleStatistics();
 	void destroyController();
 
 	not_null<Delegate*> _delegate;
@@ -192,6 +211,10 @@ private:
 	crl::time _startTime = 0;
 	base::DelayedCallTimer _finishByTimeoutTimer;
 	base::Timer _discardByTimeoutTimer;
+	base::Timer _statisticsTimer;
+	Statistics _statistics;
+	crl::time _statisticsSampleTime = 0;
+	base::Observable<void> _statisticsUpdated;
 
 	bool _mute = false;
 	base::Observable<bool> _muteChanged;
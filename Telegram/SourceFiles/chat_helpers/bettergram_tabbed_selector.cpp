@@ -25,6 +25,12 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "apiwrap.h"
 
 namespace ChatHelpers {
+namespace {
+
+// Startup requests should be finished by this time.
+constexpr auto kWarmUpDelay = 15 * crl::time(1000);
+
+} // namespace
 
 BettergramTabbedSelector::Tab::Tab(BettergramSelectorTab type, object_ptr<TabbedSelector::Inner> widget)
 	: _type(type)
@@ -119,6 +125,17 @@ BettergramTabbedSelector::BettergramTabbedSelector(
 	//setAttribute(Qt::WA_AcceptTouchEvents);
 	setAttribute(Qt::WA_OpaquePaintEvent, false);
 	showAll();
+
+	_warmUpTimer.setCallback([=] { warmUp(); });
+	_warmUpTimer.callOnce(kWarmUpDelay, Qt::VeryCoarseTimer);
+}
+
+void BettergramTabbedSelector::warmUp() {
+	// The last opened tab is the one that will be shown first,
+	// so we fetch its data before a user opens it.
+	if (!_wasShown && !isVisible()) {
+		currentTab()->widget()->warmUp();
+	}
 }
 
 BettergramTabbedSelector::Tab BettergramTabbedSelector::createTab(BettergramSelectorTab type, not_null<Window::Controller*> controller) {
@@ -364,6 +381,8 @@ void BettergramTabbedSelector::beforeHiding() {
 }
 
 void BettergramTabbedSelector::afterShown() {
+	_wasShown = true;
+	_warmUpTimer.cancel();
 	if (!_a_slide.animating()) {
 		showAll();
 		currentTab()->widget()->afterShown();
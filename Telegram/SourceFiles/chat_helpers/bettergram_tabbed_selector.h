@@ -14,6 +14,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "tabbed_selector.h"
+#include "base/timer.h"
 
 namespace ChatHelpers {
 
@@ -141,6 +142,7 @@ private:
 
 	void setWidgetToScrollArea();
 	void createTabsSlider();
+	void warmUp();
 	void switchTab();
 	not_null<Tab*> getTab(BettergramSelectorTab type) {
 		return &_tabs[static_cast<int>(type)];
@@ -169,6 +171,8 @@ private:
 	object_ptr<Ui::FlatLabel> _restrictedLabel = { nullptr };
 	std::array<Tab, Tab::kCount> _tabs;
 	BettergramSelectorTab _currentTabType = BettergramSelectorTab::Prices;
+	base::Timer _warmUpTimer;
+	bool _wasShown = false;
 
 	Fn<void(BettergramSelectorTab)> _afterShownCallback;
 	Fn<void(BettergramSelectorTab)> _beforeHidingCallback;
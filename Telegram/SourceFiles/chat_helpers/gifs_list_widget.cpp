@@ -756,6 +756,10 @@ void GifsListWidget::inlineItemRepaint(const InlineBots::Layout::ItemBase *layou
 	}
 }
 
+bool GifsListWidget::inlineItemsScrolling() {
+	return (_lastScrolled + 100 > crl::now());
+}
+
 bool GifsListWidget::inlineItemVisible(const InlineBots::Layout::ItemBase *layout) {
 	auto position = layout->position();
 	if (position < 0 || !isVisible()) {
@@ -2,6 +2,8 @@
 
 #include "list_row.h"
 
+#include <algorithm>
+
 namespace ChatHelpers {
 
 /**
@@ -70,32 +72,31 @@ public:
 
 	bool contains(int y) const
 	{
-		if (y >= top() && y <= bottom()) {
-			//TODO: bettergram: we can optimize this by using dichotomy for example
-			for (const Row &row : _list) {
-				if (row.contains(y)) {
-					return true;
-				}
-			}
-		}
-
-		return false;
+		return findRowIndex(y) != -1;
 	}
 
 	int findRowIndex(int y) const
 	{
-		if (y >= top() && y <= bottom()) {
-			//TODO: bettergram: we can optimize this by using dichotomy for example
-			for (int i = 0; i < _list.count(); i++) {
-				if (_list.at(i).contains(y)) {
-					return i;
-				}
-			}
+		const int index = findFirstRowIndex(y);
+
+		if (index < _list.count() && _list.at(index).contains(y)) {
+			return index;
 		}
 
 		return -1;
 	}
 
+	/// Return index of the first row that ends at y or below it, or count() if there is no such row.
+	/// Rows are sorted by their tops, so we use binary search here
+	int findFirstRowIndex(int y) const
+	{
+		const auto it = std::lower_bound(_list.cbegin(), _list.cend(), y, [](const Row &row, int y) {
+			return row.bottom() < y;
+		});
+
+		return static_cast<int>(it - _list.cbegin());
+	}
+
 	const_iterator begin() const
 	{
 		return _list.cbegin();
@@ -3,13 +3,13 @@
 #include "bettergram_numeric_page_indicator_widget.h"
 
 #include <bettergram/bettergramservice.h>
+#include <bettergram/refreshscheduler.h>
 #include <bettergram/cryptopricelist.h>
 #include <bettergram/cryptoprice.h>
 
 #include <ui/widgets/buttons.h>
 #include <ui/widgets/labels.h>
 #include <ui/widgets/input_fields.h>
-#include <ui/text/text_helper.h>
 #include <lang/lang_keys.h>
 #include <styles/style_window.h>
 #include <styles/style_dialogs.h>
@@ -164,29 +164,56 @@ PricesListWidget::PricesListWidget(QWidget* parent, not_null<Window::Controller*
 	onIsShowOnlyFavoritesChanged();
 }
 
-void PricesListWidget::getCryptoPriceValues()
+void PricesListWidget::getCryptoPriceValues(bool isPrefetchNextPage)
+{
+	const int offset = startRowIndexInCurrentPage();
+
+	_urlForFetchingCurrentPage = requestCryptoPriceValues(offset);
+
+	// We do not prefetch at every update of the current page in order to not double requests to servers
+	if (!isPrefetchNextPage) {
+		return;
+	}
+
+	const int nextPage = _pageIndicator->currentPage() + 1;
+	const int nextOffset = offset + _numberOfRowsInOnePage;
+
+	if (nextPage >= _pageIndicator->pagesCount()
+			|| nextOffset >= BettergramService::instance()->cryptoPriceList()->count()) {
+		return;
+	}
+
+	if (_prefetchedPage != nextPage) {
+		_prefetchedPage = nextPage;
+		_pricesAtPrefetchedPage.clear();
+	}
+
+	_urlForPrefetchingNextPage = requestCryptoPriceValues(nextOffset);
+}
+
+void PricesListWidget::resetPrefetchedPage()
+{
+	_urlForPrefetchingNextPage = QUrl();
+	_prefetchedPage = -1;
+	_pricesAtPrefetchedPage.clear();
+}
+
+QUrl PricesListWidget::requestCryptoPriceValues(int offset)
 {
 	BettergramService *const service = BettergramService::instance();
 	CryptoPriceList *const priceList = service->cryptoPriceList();
 
 	if (priceList->isSearching()) {
-		_urlForFetchingCurrentPage =
-				service->getSearchCryptoPriceValues(startRowIndexInCurrentPage(),
-													_numberOfRowsInOnePage);
-		return;
+		return service->getSearchCryptoPriceValues(offset, _numberOfRowsInOnePage);
 	}
 
 	if (priceList->isShowOnlyFavorites()) {
-		_urlForFetchingCurrentPage =
-				service->getCryptoPriceValues(startRowIndexInCurrentPage(),
-											  _numberOfRowsInOnePage,
-											  priceList->getFavoritesShortNames());
-
-		return;
+		return service->getCryptoPriceValues(offset,
+											 _numberOfRowsInOnePage,
+											 priceList->getFavoritesShortNames());
 	}
 
-	_urlForFetchingCurrentPage =
-			service->getCryptoPriceValues(startRowIndexInCurrentPage(), _numberOfRowsInOnePage);
+	return service->getCryptoPriceValues(offset, _numberOfRowsInOnePage);
 }
 
 void PricesListWidget::searchCryptoPriceNames()
@@ -223,7 +250,7 @@ object_ptr<TabbedSelector::InnerFooter> PricesListWidget::createFooter()
 void PricesListWidget::afterShown()
 {
 	startPriceListTimer();
-	getCryptoPriceValues();
+	getCryptoPriceValues(true);
 }
 
 void PricesListWidget::beforeHiding()
@@ -231,11 +258,18 @@ void PricesListWidget::beforeHiding()
 	stopPriceListTimer();
 }
 
+void PricesListWidget::warmUp()
+{
+	// Fetched values are shown at once when the tab is opened
+	// and their icons are downloaded and decoded by CryptoPriceList
+	if (_pricesAtCurrentPage.isEmpty()) {
+		getCryptoPriceValues(true);
+	}
+}
+
 void PricesListWidget::timerEvent(QTimerEvent *event)
 {
-	if (event->timerId() == _timerId) {
-		getCryptoPriceValues();
-	} else if (event->timerId() == _searchTimerId) {
+	if (event->timerId() == _searchTimerId) {
 		stopSearchPriceListTimer();
 		searchCryptoPriceNames();
 	}
@@ -244,20 +278,17 @@ void PricesListWidget::timerEvent(QTimerEvent *event)
 void PricesListWidget::startPriceListTimer()
 {
 	if (!_timerId) {
-		_timerId = startTimer(BettergramService::instance()->cryptoPriceList()->freq() * 1000,
-							  Qt::VeryCoarseTimer);
-
-		if (!_timerId) {
-			LOG(("Can not start timer for %1 ms")
-				.arg(BettergramService::instance()->cryptoPriceList()->freq()));
-		}
+		_timerId = BettergramService::instance()->refreshScheduler()->add(
+					BettergramService::instance()->cryptoPriceList()->freq() * 1000,
+					RefreshScheduler::Activity::SlowWhenInactive,
+					this, [this] { getCryptoPriceValues(); });
 	}
 }
 
 void PricesListWidget::stopPriceListTimer()
 {
 	if (_timerId) {
-		killTimer(_timerId);
+		BettergramService::instance()->refreshScheduler()->remove(_timerId);
 		_timerId = 0;
 	}
 }
@@ -267,7 +298,10 @@ void PricesListWidget::startSearchPriceListTimer()
 	stopSearchPriceListTimer();
 
 	if (!_searchTimerId) {
-		const int timeout = 500;
+		// Search is local when all names are fetched, so we wait only to not request values too often
+		const int timeout = BettergramService::instance()->cryptoPriceList()->areNamesFetched()
+				? 150
+				: 500;
 
 		_searchTimerId = startTimer(timeout);
 
@@ -288,15 +322,19 @@ void PricesListWidget::stopSearchPriceListTimer()
 void PricesListWidget::setSelectedRow(int selectedRow)
 {
 	if (_selectedRow != selectedRow) {
+		// Only the previous and the new selected rows are changed
+		if (_selectedRow >= 0) {
+			update(getRowRectangle(_selectedRow));
+		}
+
 		_selectedRow = selectedRow;
 
 		if (_selectedRow >= 0) {
 			setCursor(style::cur_pointer);
+			update(getRowRectangle(_selectedRow));
 		} else {
 			setCursor(style::cur_default);
 		}
-
-		update();
 	}
 }
 
@@ -305,6 +343,8 @@ void PricesListWidget::setNumberOfRowsInOnePage(int numberOfRowsInOnePage)
 	if (_numberOfRowsInOnePage != numberOfRowsInOnePage) {
 		_numberOfRowsInOnePage = numberOfRowsInOnePage;
 
+		resetPrefetchedPage();
+
 		getCryptoPriceValues();
 		update();
 	}
@@ -367,6 +407,89 @@ QRect PricesListWidget::getRowRectangle(int row) const
 				 st::pricesPanTableRowHeight);
 }
 
+QRect PricesListWidget::getCellRectangle(int row, const TableColumnHeaderWidget *column) const
+{
+	return QRect(column->x(),
+				 getRowTop(row),
+				 column->width(),
+				 st::pricesPanTableRowHeight);
+}
+
+const QString &PricesListWidget::getElidedName(const QString &name,
+											   const QFontMetrics &fontMetrics,
+											   int width)
+{
+	// Eliding is the most expensive part of row painting, and names are changed only with width
+	if (_elidedNamesWidth != width || _elidedNames.size() > 1000) {
+		_elidedNamesWidth = width;
+		_elidedNames.clear();
+	}
+
+	auto it = _elidedNames.find(name);
+
+	if (it == _elidedNames.end()) {
+		it = _elidedNames.insert(name, fontMetrics.elidedText(name, Qt::ElideRight, width));
+	}
+
+	return *it;
+}
+
+const QPixmap &PricesListWidget::getSparkline(const CryptoPrice &price)
+{
+	const CryptoPriceHistory &history = price.priceHistory();
+
+	if (_sparklines.size() > 1000) {
+		_sparklines.clear();
+	}
+
+	Sparkline &sparkline = _sparklines[price.name()];
+
+	if (sparkline.version == history.version()) {
+		return sparkline.pixmap;
+	}
+
+	sparkline.version = history.version();
+	sparkline.pixmap = QPixmap();
+
+	if (history.size() < 2) {
+		return sparkline.pixmap;
+	}
+
+	const int width = st::pricesPanTableSparklineWidth;
+	const int height = st::pricesPanTableSparklineHeight;
+	const float min = history.min();
+	const float range = history.max() - min;
+
+	QPolygonF points;
+	points.reserve(history.size());
+
+	for (int i = 0; i < history.size(); ++i) {
+		const qreal x = (width - 1) * qreal(i) / (history.size() - 1);
+		const qreal y = (range > 0.0f)
+				? (height - 1) * (1.0 - (history.at(i) - min) / range)
+				: (height - 1) / 2.0;
+
+		points.push_back(QPointF(x + 0.5, y + 0.5));
+	}
+
+	QImage image(QSize(width, height) * cIntRetinaFactor(), QImage::Format_ARGB32_Premultiplied);
+	image.setDevicePixelRatio(cRetinaFactor());
+	image.fill(Qt::transparent);
+	{
+		Painter painter(&image);
+		PainterHighQualityEnabler hq(painter);
+
+		const bool isUp = (history.at(history.size() - 1) >= history.at(0));
+
+		painter.setPen(QPen(isUp ? st::pricesPanTableUpFg : st::pricesPanTableDownFg, st::lineWidth));
+		painter.drawPolyline(points);
+	}
+
+	sparkline.pixmap = App::pixmapFromImageInPlace(std::move(image));
+
+	return sparkline.pixmap;
+}
+
 void PricesListWidget::countSelectedRow(const QPoint &point)
 {
 	if (_selectedRow == -1) {
@@ -535,6 +658,14 @@ void PricesListWidget::paintEvent(QPaintEvent *event) {
 			+ st::pricesPanTableImageSize
 			+ st::pricesPanTablePadding;
 
+	int columnCoinSparklineLeft = _coinHeader->x()
+			+ _coinHeader->width()
+			- _coinHeader->contentsMargins().right()
+			- st::pricesPanTableSparklineWidth;
+
+	// Names are elided before the sparkline
+	columnCoinWidth -= st::pricesPanTableSparklineWidth + st::pricesPanTablePadding;
+
 	int favoriteButtonHovered = -1;
 
 	// Draw rows
@@ -555,97 +686,108 @@ void PricesListWidget::paintEvent(QPaintEvent *event) {
 
 	painter.setFont(st::semiboldFont);
 
-	for (int i = 0; i < _pricesAtCurrentPage.count(); ++i) {
+	for (int i = 0; i < _pricesAtCurrentPage.count(); ++i, top += st::pricesPanTableRowHeight) {
 		const QSharedPointer<CryptoPrice> &price = _pricesAtCurrentPage.at(i);
 
-		const style::icon *favoriteIcon = nullptr;
+		// We paint only cells those are changed, see repaintPriceCell()
 
-		if (i == favoriteButtonHovered) {
-			if (price->isFavorite()) {
-				favoriteIcon = &st::pricesPanFavoriteEnabledIconOver;
-			} else {
-				favoriteIcon = &st::pricesPanFavoriteDisabledIconOver;
-			}
-		} else {
-			if (price->isFavorite()) {
-				favoriteIcon = &st::pricesPanFavoriteEnabledIcon;
+		if (r.intersects(getCellRectangle(i, _coinHeader))) {
+			const style::icon *favoriteIcon = nullptr;
+
+			if (i == favoriteButtonHovered) {
+				if (price->isFavorite()) {
+					favoriteIcon = &st::pricesPanFavoriteEnabledIconOver;
+				} else {
+					favoriteIcon = &st::pricesPanFavoriteDisabledIconOver;
+				}
 			} else {
-				favoriteIcon = &st::pricesPanFavoriteDisabledIcon;
+				if (price->isFavorite()) {
+					favoriteIcon = &st::pricesPanFavoriteEnabledIcon;
+				} else {
+					favoriteIcon = &st::pricesPanFavoriteDisabledIcon;
+				}
 			}
-		}
 
-		QRect favoriteRect(columnCoinLeft,
-						   top + (st::pricesPanTableRowHeight - st::pricesPanTableFavoriteImageSize) / 2,
-						   st::pricesPanTableFavoriteImageSize,
-						   st::pricesPanTableFavoriteImageSize);
+			QRect favoriteRect(columnCoinLeft,
+							   top + (st::pricesPanTableRowHeight - st::pricesPanTableFavoriteImageSize) / 2,
+							   st::pricesPanTableFavoriteImageSize,
+							   st::pricesPanTableFavoriteImageSize);
 
-		favoriteIcon->paintInCenter(painter, favoriteRect);
+			favoriteIcon->paintInCenter(painter, favoriteRect);
 
-		if (!price->icon().isNull()) {
-			QRect targetRect(columnCoinIconLeft,
-							 top + (st::pricesPanTableRowHeight - st::pricesPanTableImageSize) / 2,
-							 st::pricesPanTableImageSize,
-							 st::pricesPanTableImageSize);
+			if (!price->icon().isNull()) {
+				QRect targetRect(columnCoinIconLeft,
+								 top + (st::pricesPanTableRowHeight - st::pricesPanTableImageSize) / 2,
+								 st::pricesPanTableImageSize,
+								 st::pricesPanTableImageSize);
 
-			painter.drawPixmap(targetRect, price->icon());
-		}
+				painter.drawPixmap(targetRect, price->icon());
+			}
 
-		painter.setPen(st::pricesPanTableCryptoNameFg);
+			painter.setPen(st::pricesPanTableCryptoNameFg);
 
-		QRect nameRect(columnCoinTextLeft,
-					   top,
-					   columnCoinWidth,
-					   st::pricesPanTableRowHeight / 2);
+			painter.drawText(columnCoinTextLeft,
+							 top,
+							 columnCoinWidth,
+							 st::pricesPanTableRowHeight / 2,
+							 Qt::AlignLeft | Qt::AlignBottom,
+							 getElidedName(price->name(), painter.fontMetrics(), columnCoinWidth));
 
-		TextHelper::drawElidedText(painter,
-								   nameRect,
-								   price->name(),
-								   Qt::AlignLeft | Qt::AlignBottom);
+			painter.setPen(st::pricesPanTableCryptoShortNameFg);
 
-		painter.setPen(st::pricesPanTableCryptoShortNameFg);
+			painter.drawText(columnCoinTextLeft,
+							 top + st::pricesPanTableRowHeight / 2,
+							 columnCoinWidth,
+							 st::pricesPanTableRowHeight / 2,
+							 Qt::AlignLeft | Qt::AlignTop,
+							 price->shortName());
 
-		painter.drawText(columnCoinTextLeft,
-						 top + st::pricesPanTableRowHeight / 2,
-						 columnCoinWidth,
-						 st::pricesPanTableRowHeight / 2,
-						 Qt::AlignLeft | Qt::AlignTop,
-						 price->shortName());
+			const QPixmap &sparkline = getSparkline(*price);
 
-		switch (price->minuteDirection()) {
-		case(CryptoPrice::Direction::Up): {
-			painter.setPen(st::pricesPanTableUpFg);
-			break;
-		}
-		case(CryptoPrice::Direction::Down): {
-			painter.setPen(st::pricesPanTableDownFg);
-			break;
-		}
-		default: {
-			painter.setPen(st::pricesPanTableNoneFg);
-		}
+			if (!sparkline.isNull()) {
+				painter.drawPixmap(columnCoinSparklineLeft,
+								   top + (st::pricesPanTableRowHeight - st::pricesPanTableSparklineHeight) / 2,
+								   sparkline);
+			}
 		}
 
-		painter.drawText(columnPriceLeft, top, columnPriceWidth, st::pricesPanTableRowHeight,
-						 Qt::AlignRight | Qt::AlignVCenter, price->currentPriceString());
+		if (r.intersects(getCellRectangle(i, _priceHeader))) {
+			switch (price->minuteDirection()) {
+			case(CryptoPrice::Direction::Up): {
+				painter.setPen(st::pricesPanTableUpFg);
+				break;
+			}
+			case(CryptoPrice::Direction::Down): {
+				painter.setPen(st::pricesPanTableDownFg);
+				break;
+			}
+			default: {
+				painter.setPen(st::pricesPanTableNoneFg);
+			}
+			}
 
-		switch (price->dayDirection()) {
-		case(CryptoPrice::Direction::Up): {
-			painter.setPen(st::pricesPanTableUpFg);
-			break;
-		}
-		case(CryptoPrice::Direction::Down): {
-			painter.setPen(st::pricesPanTableDownFg);
-			break;
-		}
-		default: {
-			painter.setPen(st::pricesPanTableNoneFg);
-		}
+			painter.drawText(columnPriceLeft, top, columnPriceWidth, st::pricesPanTableRowHeight,
+							 Qt::AlignRight | Qt::AlignVCenter, price->currentPriceString());
 		}
 
-		painter.drawText(column24hLeft, top, column24hWidth, st::pricesPanTableRowHeight,
-						 Qt::AlignRight | Qt::AlignVCenter, price->changeFor24HoursString());
+		if (r.intersects(getCellRectangle(i, _24hHeader))) {
+			switch (price->dayDirection()) {
+			case(CryptoPrice::Direction::Up): {
+				painter.setPen(st::pricesPanTableUpFg);
+				break;
+			}
+			case(CryptoPrice::Direction::Down): {
+				painter.setPen(st::pricesPanTableDownFg);
+				break;
+			}
+			default: {
+				painter.setPen(st::pricesPanTableNoneFg);
+			}
+			}
 
-		top += st::pricesPanTableRowHeight;
+			painter.drawText(column24hLeft, top, column24hWidth, st::pricesPanTableRowHeight,
+							 Qt::AlignRight | Qt::AlignVCenter, price->changeFor24HoursString());
+		}
 	}
 }
 
@@ -905,16 +1047,67 @@ void PricesListWidget::onCryptoPriceValuesUpdated(const QUrl &url,
 {
 	CryptoPriceList *const priceList = BettergramService::instance()->cryptoPriceList();
 
+	bool changed = url.isEmpty();
+
 	if (_urlForFetchingCurrentPage == url) {
-		_pricesAtCurrentPage = prices;
+		changed = setPricesAtCurrentPage(prices) || changed;
+	} else if (_urlForPrefetchingNextPage == url && !url.isEmpty()) {
+		_pricesAtPrefetchedPage = prices;
+		return;
 	} else if (priceList->isSearching() && priceList->searchList().isEmpty()) {
-		_pricesAtCurrentPage = QList<QSharedPointer<CryptoPrice>>();
+		changed = setPricesAtCurrentPage(QList<QSharedPointer<CryptoPrice>>()) || changed;
 	}
 
 	updatePagesCount();
 	updateLastUpdateLabel();
 	updateListIsEmptyLabel();
-	update();
+
+	// If the same prices are still shown their changed rows
+	// are already repainted by repaintPriceRow()
+	if (changed) {
+		update();
+	}
+}
+
+bool PricesListWidget::setPricesAtCurrentPage(const QList<QSharedPointer<CryptoPrice>> &prices)
+{
+	if (_pricesAtCurrentPage == prices) {
+		return false;
+	}
+
+	for (const QSharedPointer<CryptoPrice> &price : _pricesAtCurrentPage) {
+		disconnect(price.data(), nullptr, this, nullptr);
+	}
+
+	_pricesAtCurrentPage = prices;
+
+	for (const QSharedPointer<CryptoPrice> &price : _pricesAtCurrentPage) {
+		const CryptoPrice *const raw = price.data();
+
+		const auto repaintCoin = [this, raw] { repaintPriceCell(raw, _coinHeader); };
+		const auto repaintPrice = [this, raw] { repaintPriceCell(raw, _priceHeader); };
+		const auto repaint24h = [this, raw] { repaintPriceCell(raw, _24hHeader); };
+
+		connect(raw, &CryptoPrice::iconChanged, this, repaintCoin);
+		connect(raw, &CryptoPrice::isFavoriteChanged, this, repaintCoin);
+		connect(raw, &CryptoPrice::priceHistoryChanged, this, repaintCoin);
+		connect(raw, &CryptoPrice::currentPriceChanged, this, repaintPrice);
+		connect(raw, &CryptoPrice::minuteDirectionChanged, this, repaintPrice);
+		connect(raw, &CryptoPrice::changeFor24HoursChanged, this, repaint24h);
+		connect(raw, &CryptoPrice::dayDirectionChanged, this, repaint24h);
+	}
+
+	return true;
+}
+
+void PricesListWidget::repaintPriceCell(const CryptoPrice *price, const TableColumnHeaderWidget *column)
+{
+	for (int row = 0; row < _pricesAtCurrentPage.count(); row++) {
+		if (_pricesAtCurrentPage.at(row).data() == price) {
+			update(getCellRectangle(row, column));
+			return;
+		}
+	}
 }
 
 void PricesListWidget::onCryptoPriceStatsUpdated()
@@ -925,13 +1118,19 @@ void PricesListWidget::onCryptoPriceStatsUpdated()
 
 void PricesListWidget::onCryptoPriceSortOrderChanged()
 {
+	resetPrefetchedPage();
 	getCryptoPriceValues();
 	update();
 }
 
 void PricesListWidget::onCurrentPageChanged()
 {
-	getCryptoPriceValues();
+	// Show the prefetched values until the fresh ones are fetched
+	if (_pageIndicator->currentPage() == _prefetchedPage && !_pricesAtPrefetchedPage.isEmpty()) {
+		setPricesAtCurrentPage(_pricesAtPrefetchedPage);
+	}
+
+	getCryptoPriceValues(true);
 	update();
 }
 
@@ -942,6 +1141,7 @@ void PricesListWidget::onSearchTextChanged()
 	CryptoPriceList *const priceList = BettergramService::instance()->cryptoPriceList();
 
 	priceList->setSearchText(_searchTextEdit->getLastText());
+	resetPrefetchedPage();
 
 	if (priceList->isSearching()) {
 		// We start timer here instead of just call searchCryptoPriceValues()
@@ -1002,6 +1202,7 @@ void PricesListWidget::onFavoriteButtonClicked()
 
 void PricesListWidget::onIsShowOnlyFavoritesChanged()
 {
+	resetPrefetchedPage();
 	updateFavoriteButton();
 	updatePagesCount();
 	getCryptoPriceValues();
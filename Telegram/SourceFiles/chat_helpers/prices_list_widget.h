@@ -40,6 +40,7 @@ public:
 
 	void afterShown() override;
 	void beforeHiding() override;
+	void warmUp() override;
 
 public slots:
 
@@ -78,6 +79,24 @@ private:
 	QUrl _urlForFetchingCurrentPage;
 	QList<QSharedPointer<Bettergram::CryptoPrice>> _pricesAtCurrentPage;
 
+	/// We fetch values of the next page when the current page is changed,
+	/// so we can show them immediately when a user goes to the next page
+	QUrl _urlForPrefetchingNextPage;
+	int _prefetchedPage = -1;
+	QList<QSharedPointer<Bettergram::CryptoPrice>> _pricesAtPrefetchedPage;
+
+	/// Elided crypto price names for the current width of the coin column
+	QHash<QString, QString> _elidedNames;
+	int _elidedNamesWidth = 0;
+
+	struct Sparkline {
+		QPixmap pixmap;
+		int version = -1;
+	};
+
+	/// Rasterized price histories by crypto price names, we redraw one only when its history is changed
+	QHash<QString, Sparkline> _sparklines;
+
 	Ui::FlatLabel *_lastUpdateLabel = nullptr;
 	Ui::IconButton *_siteName = nullptr;
 	Ui::FlatLabel *_marketCap = nullptr;
@@ -94,7 +113,11 @@ private:
 	TableColumnHeaderWidget *_24hHeader = nullptr;
 	Footer *_footer = nullptr;
 
-	void getCryptoPriceValues();
+	void getCryptoPriceValues(bool isPrefetchNextPage = false);
+	QUrl requestCryptoPriceValues(int offset);
+
+	/// Forget the prefetched page when the pages contain other prices
+	void resetPrefetchedPage();
 	void searchCryptoPriceNames();
 
 	int startRowIndexInCurrentPage() const;
@@ -112,10 +135,17 @@ private:
 	QRect getTableHeaderRectangle() const;
 	QRect getTableContentRectangle() const;
 	QRect getRowRectangle(int row) const;
+	QRect getCellRectangle(int row, const TableColumnHeaderWidget *column) const;
+
+	const QString &getElidedName(const QString &name, const QFontMetrics &fontMetrics, int width);
+	const QPixmap &getSparkline(const Bettergram::CryptoPrice &price);
 
 	void countSelectedRow(const QPoint &point);
 	bool isInFavoritesColumn(const QPoint &point);
 
+	bool setPricesAtCurrentPage(const QList<QSharedPointer<Bettergram::CryptoPrice>> &prices);
+	void repaintPriceCell(const Bettergram::CryptoPrice *price, const TableColumnHeaderWidget *column);
+
 	void updateControlsGeometry();
 	void updatePagesCount();
 	void updateLastUpdateLabel();
@@ -1,6 +1,7 @@
 #include "resources_widget.h"
 
 #include <bettergram/bettergramservice.h>
+#include <bettergram/refreshscheduler.h>
 #include <bettergram/resourcegrouplist.h>
 #include <bettergram/resourcegroup.h>
 #include <bettergram/resourceitem.h>
@@ -115,30 +116,20 @@ void ResourcesWidget::beforeHiding()
 	stopResourcesTimer();
 }
 
-void ResourcesWidget::timerEvent(QTimerEvent *event)
-{
-	if (event->timerId() == _timerId) {
-		BettergramService::instance()->getResourceGroupList();
-	}
-}
-
 void ResourcesWidget::startResourcesTimer()
 {
 	if (!_timerId) {
-		_timerId = startTimer(BettergramService::instance()->resourceGroupList()->freq() * 1000,
-							  Qt::VeryCoarseTimer);
-
-		if (!_timerId) {
-			LOG(("Can not start timer for %1 ms")
-				.arg(BettergramService::instance()->resourceGroupList()->freq()));
-		}
+		_timerId = BettergramService::instance()->refreshScheduler()->add(
+					BettergramService::instance()->resourceGroupList()->freq() * 1000,
+					RefreshScheduler::Activity::SlowWhenInactive,
+					this, [] { BettergramService::instance()->getResourceGroupList(); });
 	}
 }
 
 void ResourcesWidget::stopResourcesTimer()
 {
 	if (_timerId) {
-		killTimer(_timerId);
+		BettergramService::instance()->refreshScheduler()->remove(_timerId);
 		_timerId = 0;
 	}
 }
@@ -297,15 +288,11 @@ void ResourcesWidget::paintEvent(QPaintEvent *event) {
 	const int textRight = width();
 	const int textWidth = textRight - textLeft;
 
-	// Draw rows
+	// Draw only visible rows
 
-	for (int i = 0; i < _rows.count(); i++) {
+	for (int i = _rows.findFirstRowIndex(r.top()); i < _rows.count(); i++) {
 		const ListRow<Row> &row = _rows.at(i);
 
-		if (row.bottom() < r.top()) {
-			continue;
-		}
-
 		if (row.top() > r.bottom()) {
 			break;
 		}
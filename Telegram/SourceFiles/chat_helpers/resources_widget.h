@@ -50,7 +50,6 @@ protected:
 
 	void paintEvent(QPaintEvent *event) override;
 	void resizeEvent(QResizeEvent *e) override;
-	void timerEvent(QTimerEvent *event) override;
 
 private:
 	class Footer;
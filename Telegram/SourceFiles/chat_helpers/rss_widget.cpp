@@ -1,6 +1,7 @@
 #include "rss_widget.h"
 
 #include <bettergram/bettergramservice.h>
+#include <bettergram/refreshscheduler.h>
 #include <bettergram/rsschannellist.h>
 #include <bettergram/rsschannel.h>
 #include <bettergram/rssitem.h>
@@ -271,35 +272,36 @@ void RssWidget::afterShown()
 	BettergramService::instance()->getPinnedNewsList();
 }
 
-void RssWidget::beforeHiding()
+void RssWidget::warmUp()
 {
-	stopRssTimer();
-	stopPinnedNewsTimer();
+	_isWarmedUp = true;
+
+	// Images of the first screen are preloaded when the feeds are parsed, see updateRows()
+	_rssChannelList->update();
+
+	preloadImages();
 }
 
-void RssWidget::timerEvent(QTimerEvent *event)
+void RssWidget::beforeHiding()
 {
-	if (event->timerId() == _timerId) {
-		_rssChannelList->update();
-	}
+	stopRssTimer();
+	stopPinnedNewsTimer();
 }
 
 void RssWidget::startRssTimer()
 {
 	if (!_timerId) {
-		_timerId = startTimer(_rssChannelList->freq() * 1000, Qt::VeryCoarseTimer);
-
-		if (!_timerId) {
-			LOG(("Can not start timer for %1 ms")
-				.arg(_rssChannelList->freq()));
-		}
+		_timerId = BettergramService::instance()->refreshScheduler()->add(
+					_rssChannelList->freq() * 1000,
+					RefreshScheduler::Activity::SlowWhenInactive,
+					this, [this] { _rssChannelList->update(); });
 	}
 }
 
 void RssWidget::stopRssTimer()
 {
 	if (_timerId) {
-		killTimer(_timerId);
+		BettergramService::instance()->refreshScheduler()->remove(_timerId);
 		_timerId = 0;
 	}
 }
@@ -307,20 +309,17 @@ void RssWidget::stopRssTimer()
 void RssWidget::startPinnedNewsTimer()
 {
 	if (!_pinnedNewsTimerId) {
-		_pinnedNewsTimerId = startTimer(BettergramService::instance()->pinnedNewsList()->freq() * 1000,
-										Qt::VeryCoarseTimer);
-
-		if (!_pinnedNewsTimerId) {
-			LOG(("Can not start timer for %1 ms")
-				.arg(BettergramService::instance()->pinnedNewsList()->freq()));
-		}
+		_pinnedNewsTimerId = BettergramService::instance()->refreshScheduler()->add(
+					BettergramService::instance()->pinnedNewsList()->freq() * 1000,
+					RefreshScheduler::Activity::SlowWhenInactive,
+					this, [] { BettergramService::instance()->getPinnedNewsList(); });
 	}
 }
 
 void RssWidget::stopPinnedNewsTimer()
 {
 	if (_pinnedNewsTimerId) {
-		killTimer(_pinnedNewsTimerId);
+		BettergramService::instance()->refreshScheduler()->remove(_pinnedNewsTimerId);
 		_pinnedNewsTimerId = 0;
 	}
 }
@@ -534,15 +533,11 @@ void RssWidget::paintEvent(QPaintEvent *event) {
 
 	const int channelTextLeft = _isShowChannelIcons ? textLeft : iconLeft;
 
-	// Draw rows
+	// Draw only visible rows
 
-	for (int i = 0; i < _rows.count(); i++) {
+	for (int i = _rows.findFirstRowIndex(r.top()); i < _rows.count(); i++) {
 		const ListRow<Row> &row = _rows.at(i);
 
-		if (row.bottom() < r.top()) {
-			continue;
-		}
-
 		if (row.top() > r.bottom()) {
 			break;
 		}
@@ -674,6 +669,13 @@ void RssWidget::paintEvent(QPaintEvent *event) {
 	}
 }
 
+void RssWidget::visibleTopBottomUpdated(int visibleTop, int visibleBottom)
+{
+	TabbedSelector::Inner::visibleTopBottomUpdated(visibleTop, visibleBottom);
+
+	preloadImages();
+}
+
 void RssWidget::resizeEvent(QResizeEvent *e)
 {
 	updateControlsGeometry();
@@ -827,9 +829,42 @@ void RssWidget::updateRows()
 
 	addPinnedNews();
 
+	preloadImages();
 	update();
 }
 
+// We start downloading images of visible rows and rows those are one screen above and below them
+void RssWidget::preloadImages()
+{
+	int visibleTop = getVisibleTop();
+	int visibleBottom = getVisibleBottom();
+
+	if (visibleBottom <= visibleTop) {
+		// The widget has not been shown yet, so we preload the first screen after the warm up only
+		if (!_isWarmedUp) {
+			return;
+		}
+
+		visibleTop = 0;
+		visibleBottom = minimalHeight();
+	}
+
+	const int visibleHeight = visibleBottom - visibleTop;
+	const int preloadBottom = visibleBottom + visibleHeight;
+
+	for (int i = _rows.findFirstRowIndex(visibleTop - visibleHeight); i < _rows.count(); i++) {
+		const ListRow<Row> &row = _rows.at(i);
+
+		if (row.top() > preloadBottom) {
+			break;
+		}
+
+		if (row.userData().isItem()) {
+			row.userData().item()->preloadImage();
+		}
+	}
+}
+
 void RssWidget::createPinnedNewsGroupItem()
 {
 	_pinnedNewsGroupItem = QSharedPointer<BaseArticleGroupPreviewItem>(
@@ -35,11 +35,13 @@ public:
 	RssWidget(QWidget* parent, not_null<Window::Controller*> controller);
 
 	void refreshRecent() override;
+	void preloadImages() override;
 	void clearSelection() override;
 	object_ptr<TabbedSelector::InnerFooter> createFooter() override;
 
 	void afterShown() override;
 	void beforeHiding() override;
+	void warmUp() override;
 
 protected:
 	RssWidget(QWidget* parent,
@@ -82,7 +84,8 @@ protected:
 
 	void paintEvent(QPaintEvent *event) override;
 	void resizeEvent(QResizeEvent *e) override;
-	void timerEvent(QTimerEvent *event) override;
+
+	void visibleTopBottomUpdated(int visibleTop, int visibleBottom) override;
 
 private:
 	class Footer;
@@ -177,6 +180,7 @@ private:
 	int _pressedRow = -1;
 	bool _isSortBySite = false;
 	bool _isShowRead = true;
+	bool _isWarmedUp = false;
 
 	Ui::FlatLabel *_lastUpdateLabel = nullptr;
 	Ui::FlatLabel *_sortModeLabel = nullptr;
@@ -107,7 +107,7 @@ bool ApplyArchivedResultFake() {
 	return true;
 }
 
-void InstallLocally(uint64 setId) {
+void InstallLocally(uint64 setId, bool writeLocal) {
 	auto &sets = Auth().data().stickerSetsRef();
 	auto it = sets.find(setId);
 	if (it == sets.end()) {
@@ -139,15 +139,19 @@ void InstallLocally(uint64 setId) {
 			sets.erase(custom);
 		}
 	}
-	Local::writeInstalledStickers();
-	if (changedFlags & MTPDstickerSet_ClientFlag::f_unread) {
+	if (writeLocal) {
+		Local::writeInstalledStickers();
+	}
+	if (writeLocal && (changedFlags & MTPDstickerSet_ClientFlag::f_unread)) {
 		Local::writeFeaturedStickers();
 	}
 	if (changedFlags & MTPDstickerSet::Flag::f_archived) {
 		auto index = Auth().data().archivedStickerSetsOrderRef().indexOf(setId);
 		if (index >= 0) {
 			Auth().data().archivedStickerSetsOrderRef().removeAt(index);
-			Local::writeArchivedStickers();
+			if (writeLocal) {
+				Local::writeArchivedStickers();
+			}
 		}
 	}
 	Auth().data().notifyStickersUpdated();
@@ -69,7 +69,10 @@ inline MTPInputStickerSet inputSetId(const Set &set) {
 
 void ApplyArchivedResult(const MTPDmessages_stickerSetInstallResultArchive &d);
 bool ApplyArchivedResultFake(); // For testing.
-void InstallLocally(uint64 setId);
+
+// Pass writeLocal = false when the caller writes local storage itself
+// once it has applied a bunch of changes.
+void InstallLocally(uint64 setId, bool writeLocal = true);
 void UndoInstallLocally(uint64 setId);
 bool IsFaved(not_null<const DocumentData*> document);
 void SetFaved(not_null<DocumentData*> document, bool faved);
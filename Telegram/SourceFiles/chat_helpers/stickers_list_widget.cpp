@@ -751,9 +751,50 @@ void StickersListWidget::visibleTopBottomUpdated(
 	if (_section == Section::Featured) {
 		readVisibleSets();
 	}
+	preloadVisibleStickers();
 	validateSelectedIcon(ValidateIconAnimations::Full);
 }
 
+void StickersListWidget::preloadVisibleStickers() {
+	// Start loading one screen above and below the visible range, so the
+	// thumbnails are decoded on the cache threads before they are shown.
+	const auto visibleTop = getVisibleTop();
+	const auto visibleBottom = getVisibleBottom();
+	const auto screen = visibleBottom - visibleTop;
+	const auto from = visibleTop - screen;
+	const auto till = visibleBottom + screen;
+	const auto &sets = shownSets();
+	enumerateSections([&](const SectionInfo &info) {
+		if (info.rowsBottom <= from) {
+			return true;
+		} else if (info.rowsTop >= till || !info.rowsCount) {
+			return (info.rowsTop < till);
+		}
+		const auto &set = sets[info.section];
+		const auto height = set.externalLayout
+			? (info.rowsBottom - info.rowsTop)
+			: _singleSize.height();
+		const auto rowFrom = floorclamp(
+			from - info.rowsTop,
+			height,
+			0,
+			info.rowsCount);
+		const auto rowTill = ceilclamp(
+			till - info.rowsTop,
+			height,
+			0,
+			info.rowsCount);
+		const auto indexTill = std::min(rowTill * _columnCount, info.count);
+		for (auto i = rowFrom * _columnCount; i < indexTill; ++i) {
+			const auto document = set.pack[i];
+			if (document->sticker()) {
+				document->checkStickerSmall();
+			}
+		}
+		return true;
+	});
+}
+
 void StickersListWidget::readVisibleSets() {
 	auto itemsVisibleTop = getVisibleTop();
 	auto itemsVisibleBottom = getVisibleBottom();
@@ -1028,9 +1069,9 @@ void StickersListWidget::fillLocalSearchRows(const QString &query) {
 	};
 
 	const auto &sets = Auth().data().stickerSets();
-	for (const auto &[setId, titleWords] : _searchIndex) {
-		if (allSearchWordsInTitle(titleWords)) {
-			if (const auto it = sets.find(setId); it != sets.end()) {
+	for (const auto &entry : _searchIndex) {
+		if (allSearchWordsInTitle(entry.words)) {
+			if (const auto it = sets.find(entry.setId); it != sets.end()) {
 				addSearchRow(&*it);
 			}
 		}
@@ -1771,14 +1812,28 @@ void StickersListWidget::refreshSearchSets() {
 }
 
 void StickersListWidget::refreshSearchIndex() {
-	_searchIndex.clear();
+	// Preparing the search words is the expensive part, reuse them
+	// for the sets with unchanged titles.
+	auto previous = base::take(_searchIndex);
+	ranges::sort(previous, ranges::less(), &SearchIndexEntry::setId);
+
+	_searchIndex.reserve(_mySets.size());
 	for (const auto &set : _mySets) {
 		if (set.flags & MTPDstickerSet_ClientFlag::f_special) {
 			continue;
 		}
-		const auto string = set.title + ' ' + set.shortName;
-		const auto list = TextUtilities::PrepareSearchWords(string);
-		_searchIndex.emplace_back(set.id, list);
+		auto text = set.title + ' ' + set.shortName;
+		const auto i = ranges::lower_bound(
+			previous,
+			set.id,
+			ranges::less(),
+			&SearchIndexEntry::setId);
+		if (i != end(previous) && i->setId == set.id && i->text == text) {
+			_searchIndex.push_back(std::move(*i));
+			continue;
+		}
+		auto words = TextUtilities::PrepareSearchWords(text);
+		_searchIndex.push_back({ set.id, std::move(text), std::move(words) });
 	}
 }
 
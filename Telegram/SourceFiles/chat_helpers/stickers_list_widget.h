@@ -153,6 +153,12 @@ private:
 		int count = 0;
 	};
 
+	struct SearchIndexEntry {
+		uint64 setId = 0;
+		QString text;
+		QStringList words;
+	};
+
 	template <typename Callback>
 	bool enumerateSections(Callback callback) const;
 	SectionInfo sectionInfo(int section) const;
@@ -167,6 +173,7 @@ private:
 		const MTPInputStickerSet &input);
 	void refreshSearchSets();
 	void refreshSearchIndex();
+	void preloadVisibleStickers();
 
 	bool setHasTitle(const Set &set) const;
 	bool stickerHasDeleteButton(const Set &set, int index) const;
@@ -281,7 +288,7 @@ private:
 	bool _previewShown = false;
 
 	std::map<QString, std::vector<uint64>> _searchCache;
-	std::vector<std::pair<uint64, QStringList>> _searchIndex;
+	std::vector<SearchIndexEntry> _searchIndex;
 	base::Timer _searchRequestTimer;
 	QString _searchQuery, _searchNextQuery;
 	mtpRequestId _searchRequestId = 0;
@@ -223,6 +223,10 @@ public:
 	virtual void refreshRecent() = 0;
 	virtual void preloadImages() {
 	}
+
+	// Called once the app is idle, before the widget was ever shown.
+	virtual void warmUp() {
+	}
 	void hideFinished();
 	void panelHideFinished();
 	virtual void clearSelection() = 0;
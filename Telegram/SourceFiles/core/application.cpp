@@ -17,6 +17,10 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/sandbox.h"
 #include "core/local_url_handlers.h"
 #include "core/launcher.h"
+#include "core/startup_trace.h"
+#include "core/media_active_cache.h"
+#include "bettergram/bettergramservice.h"
+#include "bettergram/refreshscheduler.h"
 #include "storage/localstorage.h"
 #include "platform/platform_specific.h"
 #include "mainwindow.h"
@@ -60,6 +64,8 @@ namespace Core {
 namespace {
 
 constexpr auto kQuitPreventTimeoutMs = 1500;
+constexpr auto kIdleModeTimeout = 10 * 60 * crl::time(1000);
+constexpr auto kIdleModeCheckPeriod = 60 * crl::time(1000);
 
 } // namespace
 
@@ -84,7 +90,8 @@ Application::Application(not_null<Launcher*> launcher)
 , _langpack(std::make_unique<Lang::Instance>())
 , _audio(std::make_unique<Media::Audio::Instance>())
 , _logo(Window::LoadLogo())
-, _logoNoMargin(Window::LoadLogoNoMargin()) {
+, _logoNoMargin(Window::LoadLogoNoMargin())
+, _idleModeTimer([=] { checkIdleMode(); }) {
 	Expects(!_logo.isNull());
 	Expects(!_logoNoMargin.isNull());
 	Expects(Instance == nullptr);
@@ -93,6 +100,8 @@ Application::Application(not_null<Launcher*> launcher)
 }
 
 void Application::run() {
+	const auto trace = StartupTrace::Scope("Application::run");
+
 	Fonts::Start();
 
 	ThirdParty::start();
@@ -114,10 +123,16 @@ void Application::run() {
 	_translator = std::make_unique<Lang::Translator>();
 	QCoreApplication::instance()->installTranslator(_translator.get());
 
-	style::startManager();
+	{
+		const auto trace = StartupTrace::Scope("style::startManager");
+		style::startManager();
+	}
 	anim::startManager();
 	Ui::InitTextOptions();
-	Ui::Emoji::Init();
+	{
+		const auto trace = StartupTrace::Scope("Ui::Emoji::Init");
+		Ui::Emoji::Init();
+	}
 	Media::Player::start(_audio.get());
 
 	DEBUG_LOG(("Application Info: inited..."));
@@ -132,8 +147,10 @@ void Application::run() {
 	// Create mime database, so it won't be slow later.
 	QMimeDatabase().mimeTypeForName(qsl("text/plain"));
 
+	auto windowTrace = StartupTrace::Scope("MainWindow::init");
 	_window = std::make_unique<MainWindow>();
 	_window->init();
+	windowTrace.finish();
 
 	auto currentGeometry = _window->geometry();
 	_mediaView = std::make_unique<Media::View::OverlayWidget>();
@@ -145,13 +162,16 @@ void Application::run() {
 		&QGuiApplication::applicationStateChanged,
 		this,
 		&Application::stateChanged);
+	_idleModeTimer.callEach(kIdleModeCheckPeriod);
 
 	DEBUG_LOG(("Application Info: window created..."));
 
 	startShortcuts();
 	App::initMedia();
 
+	auto readMapTrace = StartupTrace::Scope("Local::readMap");
 	Local::ReadMapState state = Local::readMap(QByteArray());
+	readMapTrace.finish();
 	if (state == Local::ReadMapPassNeeded) {
 		Global::SetLocalPasscode(true);
 		Global::RefLocalPasscodeChanged().notify();
@@ -452,10 +472,12 @@ void Application::startMtp() {
 	auto config = base::take(_private->mtpConfig);
 	config.deviceModel = _launcher->deviceModel();
 	config.systemVersion = _launcher->systemVersion();
+	auto trace = StartupTrace::Scope("MTP::Instance");
 	_mtproto = std::make_unique<MTP::Instance>(
 		_dcOptions.get(),
 		MTP::Instance::Mode::Normal,
 		std::move(config));
+	trace.finish();
 	_mtproto->setUserPhone(cLoggedPhoneNumber());
 	_private->mtpConfig.mainDcId = _mtproto->mainDcId();
 
@@ -591,7 +613,9 @@ void Application::resetAuthorizationKeys() {
 void Application::startLocalStorage() {
 	_dcOptions = std::make_unique<MTP::DcOptions>();
 	_dcOptions->constructFromBuiltIn();
+	auto trace = StartupTrace::Scope("Local::start");
 	Local::start();
+	trace.finish();
 	subscribe(_dcOptions->changed(), [this](const MTP::DcOptions::Ids &ids) {
 		Local::writeSettings();
 		if (auto instance = mtp()) {
@@ -657,6 +681,7 @@ void Application::stateChanged(Qt::ApplicationState state) {
 }
 
 void Application::handleAppActivated() {
+	leaveIdleMode();
 	checkLocalTime();
 	if (_window) {
 		_window->updateIsActive(Global::OnlineFocusTimeout());
@@ -667,9 +692,51 @@ void Application::handleAppDeactivated() {
 	if (_window) {
 		_window->updateIsActive(Global::OfflineBlurTimeout());
 	}
+	_deactivatedAt = crl::now();
 	Ui::Tooltip::Hide();
 }
 
+void Application::checkIdleMode() {
+	const auto active = (QGuiApplication::applicationState()
+		== Qt::ApplicationActive);
+	const auto since = active ? lastNonIdleTime() : _deactivatedAt;
+	if (crl::now() - since >= kIdleModeTimeout) {
+		enterIdleMode();
+	} else if (active) {
+		leaveIdleMode();
+	}
+}
+
+void Application::enterIdleMode() {
+	if (_idleMode) {
+		return;
+	}
+	_idleMode = true;
+	DEBUG_LOG(("Application Info: Entering idle mode."));
+
+	// Download and upload sessions are stopped by their own timers once
+	// they have nothing to do and clip readers pause the animations that
+	// are not painted, so we only shrink caches and pause background polls.
+	TrimMediaActiveCaches();
+	Bettergram::BettergramService::instance()->refreshScheduler()->setIsIdle(
+		true);
+}
+
+void Application::leaveIdleMode() {
+	if (!_idleMode) {
+		return;
+	}
+	_idleMode = false;
+	DEBUG_LOG(("Application Info: Leaving idle mode."));
+
+	Bettergram::BettergramService::instance()->refreshScheduler()->setIsIdle(
+		false);
+}
+
+bool Application::idleMode() const {
+	return _idleMode;
+}
+
 void Application::call_handleUnreadCounterUpdate() {
 	Global::RefUnreadCounterUpdate().notify(true);
 }
@@ -856,6 +923,7 @@ bool Application::passcodeLocked() const {
 
 void Application::updateNonIdle() {
 	_lastNonIdleTime = crl::now();
+	leaveIdleMode();
 }
 
 crl::time Application::lastNonIdleTime() const {
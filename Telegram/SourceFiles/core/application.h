@@ -195,6 +195,7 @@ public:
 
 	[[nodiscard]] crl::time lastNonIdleTime() const;
 	void updateNonIdle();
+	[[nodiscard]] bool idleMode() const;
 
 	void registerLeaveSubscription(QWidget *widget);
 	void unregisterLeaveSubscription(QWidget *widget);
@@ -241,6 +242,9 @@ private:
 	void startShortcuts();
 
 	void stateChanged(Qt::ApplicationState state);
+	void checkIdleMode();
+	void enterIdleMode();
+	void leaveIdleMode();
 
 	friend void App::quit();
 	static void QuitAttempt();
@@ -285,6 +289,9 @@ private:
 	std::unique_ptr<Window::TermsLock> _termsLock;
 
 	base::DelayedCallTimer _callDelayedTimer;
+	base::Timer _idleModeTimer;
+	crl::time _deactivatedAt = 0;
+	bool _idleMode = false;
 
 	struct LeaveSubscription {
 		LeaveSubscription(
@@ -61,6 +61,43 @@ using AnnotationRefs = std::map<std::string, const QString*>;
 Annotations ProcessAnnotations;
 AnnotationRefs ProcessAnnotationRefs;
 
+constexpr auto kTraceRingSize = 256;
+constexpr auto kTraceHangDuration = crl::time(1000);
+
+struct TraceEntry {
+	const char *name = nullptr;
+	int type = 0;
+	crl::time started = 0;
+	crl::time duration = 0;
+};
+
+std::array<TraceEntry, kTraceRingSize> TraceRing;
+int TraceRingNext = 0;
+int TraceRingCount = 0;
+
+template <typename Callback>
+void EnumerateTraceRing(Callback &&callback) {
+	const auto from = TraceRingNext + kTraceRingSize - TraceRingCount;
+	for (auto i = 0; i != TraceRingCount; ++i) {
+		callback(TraceRing[(from + i) % kTraceRingSize]);
+	}
+}
+
+void LogTraceRing(crl::time now) {
+	auto lines = QStringList();
+	EnumerateTraceRing([&](const TraceEntry &entry) {
+		lines.push_back(QString("-%1 ms: %2 (type %3) for %4 ms"
+		).arg(now - entry.started
+		).arg(entry.name
+		).arg(entry.type
+		).arg(entry.duration));
+	});
+	LOG(("Hang detected, slow main thread events:
+%1"
+		).arg(lines.join('
+')));
+}
+
 #ifndef TDESKTOP_DISABLE_CRASH_REPORTS
 
 QString ReportPath;
@@ -198,6 +235,18 @@ void SignalHandler(int signum) {
 		}
 		psWriteDump();
 		dump() << "\n";
+
+		if (TraceRingCount > 0) {
+			const auto now = crl::now();
+			dump() << "Slow main thread events:\n";
+			EnumerateTraceRing([&](const TraceEntry &entry) {
+				dump()
+					<< "-" << int(now - entry.started) << " ms: "
+					<< entry.name << " (type " << entry.type << ") for "
+					<< int(entry.duration) << " ms\n";
+			});
+			dump() << "\n";
+		}
 	}
 	if (name) {
 		dump() << "Caught signal " << signum << " (" << name << ") in thread " << uint64(thread) << "\n";
@@ -549,6 +598,20 @@ void SetAnnotationRef(const std::string &key, const QString *valuePtr) {
 	}
 }
 
+void TraceSlowEvent(
+		const char *name,
+		int type,
+		crl::time started,
+		crl::time duration) {
+	TraceRing[TraceRingNext] = { name, type, started, duration };
+	TraceRingNext = (TraceRingNext + 1) % kTraceRingSize;
+	TraceRingCount = std::min(TraceRingCount + 1, kTraceRingSize);
+
+	if (duration >= kTraceHangDuration) {
+		LogTraceRing(started + duration);
+	}
+}
+
 #ifndef TDESKTOP_DISABLE_CRASH_REPORTS
 
 dump::~dump() {
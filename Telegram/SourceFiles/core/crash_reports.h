@@ -50,6 +50,16 @@ inline void ClearAnnotationRef(const std::string &key) {
 	SetAnnotationRef(key, nullptr);
 }
 
+// Main thread only. Remembers a slow event loop iteration in a
+// preallocated ring that is written to the crash report, events that
+// took longer than a second also dump the ring to the log right away.
+// The name must be a string literal.
+void TraceSlowEvent(
+	const char *name,
+	int type,
+	crl::time started,
+	crl::time duration);
+
 void StartCatching(not_null<Core::Launcher*> launcher);
 void FinishCatching();
 
@@ -12,6 +12,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/main_queue_processor.h"
 #include "core/update_checker.h"
 #include "core/sandbox.h"
+#include "core/startup_trace.h"
 #include "base/concurrent_timer.h"
 
 namespace Core {
@@ -197,7 +198,8 @@ Launcher::Launcher(
 : _argc(argc)
 , _argv(argv)
 , _deviceModel(deviceModel)
-, _systemVersion(systemVersion) {
+, _systemVersion(systemVersion)
+, _launchedAt(crl::now()) {
 }
 
 void Launcher::init() {
@@ -225,10 +227,14 @@ int Launcher::exec() {
 		return psCleanup();
 	}
 
+	auto trace = StartupTrace::Scope("Logs and Platform start");
+
 	// both are finished in Sandbox::closeApplication
 	Logs::start(this); // must be started before Platform is started
 	Platform::start(); // must be started before Sandbox is created
 
+	trace.finish();
+
 	auto result = executeApplication();
 
 	DEBUG_LOG(("Bettergram finished, result: %1").arg(result));
@@ -243,6 +249,7 @@ int Launcher::exec() {
 		launchUpdater(UpdaterLaunch::JustRelaunch);
 	}
 
+	StartupTrace::Finish();
 	CrashReports::Finish();
 	Platform::finish();
 	Logs::finish();
@@ -365,6 +372,10 @@ uint64 Launcher::installationTag() const {
 	return InstallationTag;
 }
 
+crl::time Launcher::launchedAt() const {
+	return _launchedAt;
+}
+
 void Launcher::processArguments() {
 		enum class KeyFormat {
 		NoValues,
@@ -385,6 +396,7 @@ void Launcher::processArguments() {
 		{ "-startintray"    , KeyFormat::NoValues },
 		{ "-sendpath"       , KeyFormat::AllLeftValues },
 		{ "-workdir"        , KeyFormat::OneValue },
+		{ "-starttrace"     , KeyFormat::OneValue },
 		{ "--"              , KeyFormat::OneValue },
 	};
 	auto parseResult = QMap<QByteArray, QStringList>();
@@ -435,6 +447,11 @@ void Launcher::processArguments() {
 		}
 	}
 	gStartUrl = parseResult.value("--", {}).join(QString());
+
+	const auto tracePath = parseResult.value("-starttrace", {}).join(QString());
+	if (!tracePath.isEmpty()) {
+		StartupTrace::Start(tracePath);
+	}
 }
 
 int Launcher::executeApplication() {
@@ -27,6 +27,9 @@ public:
 	QString systemVersion() const;
 	uint64 installationTag() const;
 
+	// For the cold start timings in the log.
+	crl::time launchedAt() const;
+
 	bool checkPortableVersionFolder();
 	void workingFolderReady();
 	void writeDebugModeSetting();
@@ -67,6 +70,7 @@ private:
 	const QString _systemVersion;
 
 	bool _customWorkingDir = false;
+	const crl::time _launchedAt = 0;
 
 };
 
@@ -0,0 +1,34 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "core/media_active_cache.h"
+
+namespace Core {
+namespace {
+
+std::vector<MediaActiveCacheBase*> &Caches() {
+	static auto Instance = std::vector<MediaActiveCacheBase*>();
+	return Instance;
+}
+
+} // namespace
+
+MediaActiveCacheBase::MediaActiveCacheBase() {
+	Caches().push_back(this);
+}
+
+MediaActiveCacheBase::~MediaActiveCacheBase() {
+	auto &caches = Caches();
+	caches.erase(ranges::remove(caches, this), end(caches));
+}
+
+void TrimMediaActiveCaches() {
+	for (const auto cache : Caches()) {
+		cache->trim();
+	}
+}
+
+} // namespace Core
@@ -10,8 +10,25 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 namespace Core {
 
+class MediaActiveCacheBase {
+public:
+	MediaActiveCacheBase();
+	MediaActiveCacheBase(const MediaActiveCacheBase &other) = delete;
+	MediaActiveCacheBase &operator=(
+		const MediaActiveCacheBase &other) = delete;
+
+	virtual void trim() = 0;
+
+	virtual ~MediaActiveCacheBase();
+
+};
+
+// Unloads least recently used media from all the caches, for example
+// when the application stays in background for a long time.
+void TrimMediaActiveCaches();
+
 template <typename Type>
-class MediaActiveCache {
+class MediaActiveCache final : public MediaActiveCacheBase {
 public:
 	template <typename Unload>
 	MediaActiveCache(int64 limit, Unload &&unload);
@@ -23,10 +40,14 @@ public:
 	void increment(int64 amount);
 	void decrement(int64 amount);
 
+	void trim() override;
+
 private:
-	template <typename Unload>
-	void check(Unload &&unload);
+	static constexpr auto kTrimmedPart = 4;
 
+	void check(int64 limit);
+
+	Fn<void(Type*)> _unload;
 	base::last_used_cache<Type*> _cache;
 	SingleQueuedInvokation _delayed;
 	int64 _usage = 0;
@@ -37,7 +58,8 @@ private:
 template <typename Type>
 template <typename Unload>
 MediaActiveCache<Type>::MediaActiveCache(int64 limit, Unload &&unload)
-: _delayed([=] { check(unload); })
+: _unload(std::forward<Unload>(unload))
+, _delayed([=] { check(_limit); })
 , _limit(limit) {
 }
 
@@ -68,15 +90,19 @@ void MediaActiveCache<Type>::decrement(int64 amount) {
 }
 
 template <typename Type>
-template <typename Unload>
-void MediaActiveCache<Type>::check(Unload &&unload) {
-	while (_usage > _limit) {
+void MediaActiveCache<Type>::trim() {
+	check(_limit / kTrimmedPart);
+}
+
+template <typename Type>
+void MediaActiveCache<Type>::check(int64 limit) {
+	while (_usage > limit) {
 		if (const auto entry = _cache.take_lowest()) {
-			unload(entry);
+			_unload(entry);
 		} else {
 			break;
 		}
 	}
 }
 
-} // namespace Images
+} // namespace Core
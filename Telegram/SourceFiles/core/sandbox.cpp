@@ -17,6 +17,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/launcher.h"
 #include "core/local_url_handlers.h"
 #include "core/update_checker.h"
+#include "core/startup_trace.h"
+#include "core/stall_watchdog.h"
 #include "base/timer.h"
 #include "base/concurrent_timer.h"
 #include "base/qthelp_url.h"
@@ -28,6 +30,7 @@ namespace Core {
 namespace {
 
 constexpr auto kEmptyPidForCommandResponse = 0ULL;
+constexpr auto kSlowEventDuration = crl::time(50);
 
 using ErrorSignal = void(QLocalSocket::*)(QLocalSocket::LocalSocketError);
 const auto QLocalSocket_error = ErrorSignal(&QLocalSocket::error);
@@ -82,6 +85,10 @@ Sandbox::Sandbox(
 }
 
 int Sandbox::start() {
+	auto trace = StartupTrace::Scope("Sandbox::start");
+
+	_stallWatchdog = std::make_unique<StallWatchdog>();
+
 	if (!Core::UpdaterDisabled()) {
 		_updateChecker = std::make_unique<Core::UpdateChecker>();
 	}
@@ -134,6 +141,7 @@ int Sandbox::start() {
 		_localSocket.connectToServer(_localServerName);
 	}
 
+	trace.finish();
 	return exec();
 }
 
@@ -144,9 +152,12 @@ void Sandbox::launchApplication() {
 		} else if (_application) {
 			return;
 		}
+		StartupTrace::Mark("Sandbox::launchApplication");
 		setupScreenScale();
 
+		auto trace = StartupTrace::Scope("Application::Application");
 		_application = std::make_unique<Application>(_launcher);
+		trace.finish();
 
 		// Ideally this should go to constructor.
 		// But we want to catch all native events and Application installs
@@ -490,6 +501,9 @@ void Sandbox::registerEnterFromEventLoop() {
 	if (_eventNestingLevel > _loopNestingLevel) {
 		_previousLoopNestingLevels.push_back(_loopNestingLevel);
 		_loopNestingLevel = _eventNestingLevel;
+		if (_stallWatchdog) {
+			_stallWatchdog->nestedLoopEntered();
+		}
 	}
 }
 
@@ -498,8 +512,35 @@ bool Sandbox::notify(QObject *receiver, QEvent *e) {
 		return QApplication::notify(receiver, e);
 	}
 
+	const auto loopNestingLevel = _loopNestingLevel;
+	const auto outermost = (_eventNestingLevel == loopNestingLevel);
 	const auto wrap = createEventNestingLevel();
 	const auto type = e->type();
+	const auto watchdog = _stallWatchdog.get();
+	const auto dispatched = watchdog
+		? watchdog->enter(
+			receiver->metaObject()->className(),
+			int(type),
+			outermost)
+		: StallWatchdog::Dispatched();
+	const auto started = outermost ? crl::now() : crl::time(0);
+	const auto trace = gsl::finally([&] {
+		if (watchdog) {
+			watchdog->leave(dispatched, outermost);
+		}
+		if (!outermost || _loopNestingLevel != loopNestingLevel) {
+			// Nested event loops (menus, dialogs) are not slow events.
+			return;
+		}
+		const auto duration = crl::now() - started;
+		if (duration >= kSlowEventDuration) {
+			CrashReports::TraceSlowEvent(
+				(type == QEvent::UpdateRequest) ? "paint" : "event",
+				int(type),
+				started,
+				duration);
+		}
+	});
 	if (type == QEvent::UpdateRequest) {
 		_widgetUpdateRequests.fire({});
 		// Profiling.
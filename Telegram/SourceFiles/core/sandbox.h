@@ -11,6 +11,7 @@ namespace Core {
 class Launcher;
 class UpdateChecker;
 class Application;
+class StallWatchdog;
 
 class Sandbox final
 	: public QApplication
@@ -92,6 +93,7 @@ private:
 	int _loopNestingLevel = 0;
 	std::vector<int> _previousLoopNestingLevels;
 	std::vector<PostponedCall> _postponedCalls;
+	std::unique_ptr<StallWatchdog> _stallWatchdog;
 
 	QPointer<QWidget> _windowForDelayedActivation;
 	bool _delayedActivationsPaused = false;
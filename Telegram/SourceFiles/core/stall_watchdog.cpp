@@ -0,0 +1,118 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "core/stall_watchdog.h"
+
+namespace Core {
+namespace {
+
+constexpr auto kCheckTimeout = crl::time(250);
+constexpr auto kStallTimeout = crl::time(1000);
+constexpr auto kReportHotspots = 5;
+
+} // namespace
+
+StallWatchdog::StallWatchdog() : _thread([=] { run(); }) {
+}
+
+StallWatchdog::~StallWatchdog() {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_finished = true;
+	}
+	_variable.notify_one();
+	_thread.join();
+}
+
+auto StallWatchdog::enter(
+		const char *receiver,
+		int type,
+		bool outermost) -> Dispatched {
+	const auto result = Dispatched{
+		_receiver.load(std::memory_order_relaxed),
+		_type.load(std::memory_order_relaxed)
+	};
+	_receiver.store(receiver, std::memory_order_relaxed);
+	_type.store(type, std::memory_order_relaxed);
+	if (outermost) {
+		_started.store(crl::now(), std::memory_order_release);
+	}
+	return result;
+}
+
+void StallWatchdog::leave(Dispatched previous, bool outermost) {
+	if (outermost) {
+		_started.store(0, std::memory_order_release);
+	}
+	_receiver.store(previous.receiver, std::memory_order_relaxed);
+	_type.store(previous.type, std::memory_order_relaxed);
+}
+
+void StallWatchdog::nestedLoopEntered() {
+	_started.store(0, std::memory_order_release);
+}
+
+void StallWatchdog::run() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_finished) {
+		_variable.wait_for(lock, std::chrono::milliseconds(kCheckTimeout));
+		if (_finished) {
+			break;
+		}
+		const auto started = _started.load(std::memory_order_acquire);
+		const auto now = crl::now();
+		if (started && now - started >= kStallTimeout) {
+			sample(started, now);
+		} else if (_stallStarted) {
+			report();
+		}
+	}
+}
+
+void StallWatchdog::sample(crl::time started, crl::time now) {
+	if (_stallStarted && _stallStarted != started) {
+		report();
+	}
+	if (!_stallStarted) {
+		_stallStarted = started;
+		LOG(("Stall: main thread is busy for %1 ms, receiver '%2', type %3."
+			).arg(now - started
+			).arg(_receiver.load(std::memory_order_relaxed)
+			).arg(_type.load(std::memory_order_relaxed)));
+	}
+	_stallDuration = now - started;
+	++_samples[{
+		_receiver.load(std::memory_order_relaxed),
+		_type.load(std::memory_order_relaxed)
+	}];
+}
+
+void StallWatchdog::report() {
+	auto hotspots = std::vector<std::pair<int, std::pair<const char*, int>>>();
+	hotspots.reserve(_samples.size());
+	for (const auto &[key, count] : _samples) {
+		hotspots.emplace_back(count, key);
+	}
+	ranges::sort(hotspots, std::greater<>());
+	if (hotspots.size() > kReportHotspots) {
+		hotspots.resize(kReportHotspots);
+	}
+	auto lines = QStringList();
+	for (const auto &[count, key] : hotspots) {
+		lines.push_back(QString("%1 samples: '%2', type %3"
+		).arg(count
+		).arg(key.first ? key.first : "(none)"
+		).arg(key.second));
+	}
+	LOG(("Stall: main thread was busy for at least %1 ms, hotspots:\n%2"
+		).arg(_stallDuration
+		).arg(lines.join('\n')));
+
+	_stallStarted = _stallDuration = 0;
+	_samples.clear();
+}
+
+} // namespace Core
@@ -0,0 +1,66 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Core {
+
+// Watches the main thread from a separate thread. When one outermost
+// event is dispatched for too long it samples the innermost receiver
+// being notified and logs the aggregated samples once the stall ends.
+class StallWatchdog final {
+public:
+	struct Dispatched {
+		const char *receiver = nullptr;
+		int type = 0;
+	};
+
+	StallWatchdog();
+	StallWatchdog(const StallWatchdog &other) = delete;
+	StallWatchdog &operator=(const StallWatchdog &other) = delete;
+	~StallWatchdog();
+
+	// Main thread only, leave() gets the value returned from enter().
+	// The receiver must be a string with static storage duration,
+	// like QMetaObject::className(). Only the events dispatched right
+	// from the event loop (outermost) are timed.
+	[[nodiscard]] Dispatched enter(
+		const char *receiver,
+		int type,
+		bool outermost);
+	void leave(Dispatched previous, bool outermost);
+
+	// A nested event loop is spinning, the event that started it
+	// is not a stall.
+	void nestedLoopEntered();
+
+private:
+	void run();
+	void sample(crl::time started, crl::time now);
+	void report();
+
+	std::atomic<crl::time> _started = { 0 };
+	std::atomic<const char*> _receiver = { nullptr };
+	std::atomic<int> _type = { 0 };
+
+	// Accessed only from the watchdog thread.
+	crl::time _stallStarted = 0;
+	crl::time _stallDuration = 0;
+	std::map<std::pair<const char*, int>, int> _samples;
+
+	std::mutex _mutex;
+	std::condition_variable _variable;
+	bool _finished = false;
+	std::thread _thread;
+
+};
+
+} // namespace Core
@@ -0,0 +1,148 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "core/startup_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace Core {
+namespace StartupTrace {
+namespace {
+
+struct Event {
+	const char *name = nullptr;
+	char phase = 0;
+	int64 started = 0;
+	int64 duration = 0;
+	quint64 thread = 0;
+};
+
+std::atomic<bool> TraceEnabled = { false };
+std::mutex TraceMutex;
+std::vector<Event> TraceEvents;
+QString TracePath;
+int64 TraceStarted = 0;
+
+int64 NowMicroseconds() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+quint64 CurrentThread() {
+	return quint64(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+void Push(Event &&event) {
+	std::lock_guard<std::mutex> lock(TraceMutex);
+	TraceEvents.push_back(std::move(event));
+}
+
+QByteArray Serialize(const std::vector<Event> &events) {
+	auto result = QByteArray();
+	result.reserve(int(events.size()) * 128 + 64);
+	result.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	auto first = true;
+	for (const auto &event : events) {
+		if (!first) {
+			result.append(",\n");
+		}
+		first = false;
+		result.append("{\"name\":\"").append(event.name);
+		result.append("\",\"cat\":\"startup\",\"ph\":\"");
+		result.append(event.phase);
+		result.append("\",\"ts\":").append(QByteArray::number(event.started));
+		if (event.phase == 'X') {
+			result.append(",\"dur\":");
+			result.append(QByteArray::number(event.duration));
+		} else {
+			result.append(",\"s\":\"g\"");
+		}
+		result.append(",\"pid\":1,\"tid\":");
+		result.append(QByteArray::number(event.thread)).append('}');
+	}
+	result.append("\n]}\n");
+	return result;
+}
+
+} // namespace
+
+void Start(const QString &path) {
+	Expects(!TraceEnabled);
+
+	TracePath = path;
+	TraceStarted = NowMicroseconds();
+	TraceEnabled = true;
+}
+
+bool Enabled() {
+	return TraceEnabled;
+}
+
+void Mark(const char *name) {
+	if (!TraceEnabled) {
+		return;
+	}
+	Push({ name, 'i', NowMicroseconds(), 0, CurrentThread() });
+}
+
+void Finish() {
+	if (!TraceEnabled.exchange(false)) {
+		return;
+	}
+	const auto now = NowMicroseconds();
+	auto events = [&] {
+		std::lock_guard<std::mutex> lock(TraceMutex);
+		return base::take(TraceEvents);
+	}();
+	events.insert(begin(events), Event{
+		"Launcher::exec",
+		'X',
+		TraceStarted,
+		now - TraceStarted,
+		CurrentThread() });
+
+	QFile f(TracePath);
+	if (!f.open(QIODevice::WriteOnly)) {
+		LOG(("Startup Trace Error: could not open '%1' for writing."
+			).arg(TracePath));
+		return;
+	}
+	f.write(Serialize(events));
+	LOG(("Startup Trace: %1 events written to '%2'."
+		).arg(events.size()
+		).arg(TracePath));
+}
+
+Scope::Scope(const char *name)
+: _name(name)
+, _started(TraceEnabled ? NowMicroseconds() : 0) {
+}
+
+Scope::~Scope() {
+	finish();
+}
+
+void Scope::finish() {
+	if (!_started) {
+		return;
+	}
+	const auto started = base::take(_started);
+	if (!TraceEnabled) {
+		return;
+	}
+	Push({
+		_name,
+		'X',
+		started,
+		NowMicroseconds() - started,
+		CurrentThread() });
+}
+
+} // namespace StartupTrace
+} // namespace Core
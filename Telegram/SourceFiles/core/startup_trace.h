@@ -0,0 +1,41 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Core {
+namespace StartupTrace {
+
+// Enabled by the -starttrace <path> command line argument. Collects the
+// startup timeline and writes it as Chrome trace JSON (chrome://tracing).
+void Start(const QString &path);
+bool Enabled();
+
+// Instant event, the name must be a string literal.
+void Mark(const char *name);
+
+// Writes the collected events and stops tracing, only the first call
+// after Start() does anything.
+void Finish();
+
+// Measures the time till finish() or destruction as a complete event.
+class Scope final {
+public:
+	explicit Scope(const char *name);
+	Scope(const Scope &other) = delete;
+	Scope &operator=(const Scope &other) = delete;
+	~Scope();
+
+	void finish();
+
+private:
+	const char *_name = nullptr;
+	int64 _started = 0;
+
+};
+
+} // namespace StartupTrace
+} // namespace Core
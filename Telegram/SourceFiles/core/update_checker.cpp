@@ -47,6 +47,14 @@ namespace {
 constexpr auto kUpdaterTimeout = 10 * crl::time(1000);
 constexpr auto kMaxResponseSize = 1024 * 1024;
 
+// Delta packages have this instead of files count, followed by the
+// version they're made for, and the files count after it.
+constexpr auto kDeltaPackageMarker = quint32(0x7FFFFFFE);
+
+// Files that are the same as in the installed version have this
+// instead of size and SHA1 hash of the contents instead of data.
+constexpr auto kDeltaUnchangedFile = quint32(0xFFFFFFFF);
+
 #ifdef TDESKTOP_DISABLE_AUTOUPDATE
 bool UpdaterIsDisabled = true;
 #else // TDESKTOP_DISABLE_AUTOUPDATE
@@ -107,7 +115,7 @@ struct Implementation {
 
 class HttpChecker : public Checker {
 public:
-	HttpChecker(bool testing);
+	HttpChecker(bool testing, bool allowDelta);
 
 	void start() override;
 
@@ -126,6 +134,7 @@ private:
 		bool isAvailableAlpha,
 		QString url) const;
 
+	bool _allowDelta = false;
 	std::unique_ptr<QNetworkAccessManager> _manager;
 	QNetworkReply *_reply = nullptr;
 
@@ -248,7 +257,7 @@ QString ExtractFilename(const QString &url) {
 	return QString();
 }
 
-bool UnpackUpdate(const QString &filepath) {
+bool UnpackUpdate(const QString &filepath, bool *delta) {
 	QFile input(filepath);
 	QByteArray packed;
 	if (!input.open(QIODevice::ReadOnly)) {
@@ -402,6 +411,23 @@ bool UnpackUpdate(const QString &filepath) {
 			LOG(("Update Error: cant read files count from downloaded stream, status: %1").arg(stream.status()));
 			return false;
 		}
+		if (filesCount == kDeltaPackageMarker) {
+			*delta = true;
+
+			quint64 deltaVersion = 0;
+			stream >> deltaVersion >> filesCount;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("Update Error: cant read delta header from downloaded stream, status: %1").arg(stream.status()));
+				return false;
+			}
+			const auto myVersion = cAlphaVersion()
+				? cAlphaVersion()
+				: quint64(AppVersion);
+			if (deltaVersion != myVersion) {
+				LOG(("Update Error: delta update is for version %1, mine is %2").arg(deltaVersion).arg(myVersion));
+				return false;
+			}
+		}
 		if (!filesCount) {
 			LOG(("Update Error: update is empty!"));
 			return false;
@@ -420,6 +446,23 @@ bool UnpackUpdate(const QString &filepath) {
 				LOG(("Update Error: cant read file from downloaded stream, status: %1").arg(stream.status()));
 				return false;
 			}
+			if (*delta && fileSize == kDeltaUnchangedFile) {
+				QFile installed(cExeDir() + relativeName);
+				if (!installed.open(QIODevice::ReadOnly)) {
+					LOG(("Update Error: cant read installed file '%1' for delta update").arg(installed.fileName()));
+					return false;
+				}
+				const auto contents = installed.readAll();
+				uchar contentsSha1[20];
+				hashSha1(contents.constData(), contents.size(), contentsSha1);
+				if (fileInnerData.size() != sizeof(contentsSha1)
+					|| memcmp(fileInnerData.constData(), contentsSha1, sizeof(contentsSha1))) {
+					LOG(("Update Error: installed file '%1' is not the one delta update expects").arg(installed.fileName()));
+					return false;
+				}
+				fileInnerData = contents;
+				fileSize = quint32(contents.size());
+			}
 			if (fileSize != quint32(fileInnerData.size())) {
 				LOG(("Update Error: bad file size %1 not matching data size %2").arg(fileSize).arg(fileInnerData.size()));
 				return false;
@@ -618,7 +661,9 @@ rpl::lifetime &Checker::lifetime() {
 	return _lifetime;
 }
 
-HttpChecker::HttpChecker(bool testing) : Checker(testing) {
+HttpChecker::HttpChecker(bool testing, bool allowDelta)
+: Checker(testing)
+, _allowDelta(allowDelta) {
 }
 
 void HttpChecker::start() {
@@ -725,6 +770,23 @@ std::optional<QString> HttpChecker::parseResponse(
 			return false;
 		}
 		bestLink = (*link).toString();
+
+		// "delta": { "from": 1004005, "link": "..." } for an update
+		// package that contains only the files changed since "from".
+		const auto delta = map.constFind("delta");
+		if (_allowDelta
+			&& !isAlpha
+			&& !cAlphaVersion()
+			&& delta != map.constEnd()
+			&& (*delta).isObject()) {
+			const auto object = (*delta).toObject();
+			const auto from = object.value("from").toDouble();
+			const auto deltaLink = object.value("link");
+			if (uint64(std::round(from)) == uint64(AppVersion)
+				&& deltaLink.isString()) {
+				bestLink = deltaLink.toString();
+			}
+		}
 		return true;
 	};
 	const auto result = ParseCommonMap(response, testing(), accumulate);
@@ -1068,7 +1130,7 @@ private:
 	void checkerFail(not_null<Implementation*> which);
 
 	void finalize(QString filepath);
-	void unpackDone(bool ready);
+	void unpackDone(bool ready, bool delta);
 	void handleChecking();
 	void handleProgress();
 	void handleLatest();
@@ -1077,6 +1139,7 @@ private:
 	void scheduleNext();
 
 	bool _testing = false;
+	bool _deltaFailed = false;
 	Action _action = Action::Waiting;
 	base::Timer _timer;
 	base::Timer _retryTimer;
@@ -1242,7 +1305,7 @@ void Updater::start(bool forceWait) {
 	if (sendRequest) {
 		startImplementation(
 			&_httpImplementation,
-			std::make_unique<HttpChecker>(_testing));
+			std::make_unique<HttpChecker>(_testing, !_deltaFailed));
 
 #if MTP_UPDATES
 		startImplementation(
@@ -1406,16 +1469,26 @@ void Updater::finalize(QString filepath) {
 	_activeLoader = nullptr;
 	_action = Action::Unpacking;
 	crl::async([=] {
-		const auto ready = UnpackUpdate(filepath);
+		auto delta = false;
+		const auto ready = UnpackUpdate(filepath, &delta);
 		crl::on_main([=] {
-			GetUpdaterInstance()->unpackDone(ready);
+			GetUpdaterInstance()->unpackDone(ready, delta);
 		});
 	});
 }
 
-void Updater::unpackDone(bool ready) {
+void Updater::unpackDone(bool ready, bool delta) {
 	if (ready) {
 		_ready.fire({});
+	} else if (delta && !_deltaFailed) {
+		// Installed files differ from the ones the delta was made for,
+		// try the full package right away.
+		LOG(("Update Info: delta update failed, loading the full package."));
+		ClearAll();
+		_deltaFailed = true;
+		stop();
+		cSetLastUpdateCheck(0);
+		start(false);
 	} else {
 		ClearAll();
 		_failed.fire({});
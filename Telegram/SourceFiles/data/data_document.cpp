@@ -29,6 +29,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/application.h"
 #include "media/streaming/media_streaming_loader_mtproto.h"
 #include "media/streaming/media_streaming_loader_local.h"
+#include "auth_session.h"
 
 namespace {
 
@@ -973,8 +974,35 @@ void DocumentData::setLocation(const FileLocation &loc) {
 	}
 }
 
+void DocumentData::validateLocationAsync() const {
+	if (_location.isEmpty() || _locationValidatedPath == _location.fname) {
+		return;
+	}
+	_locationValidatedPath = _location.fname;
+
+	// Cached lookups happen while painting, so the file system is
+	// touched only in the background and the result is applied later.
+	crl::async([=, location = _location] {
+		if (location.check()) {
+			return;
+		}
+		crl::on_main(&_owner->session(), [=] {
+			const auto that = const_cast<DocumentData*>(this);
+			if (that->_location.fname != location.fname) {
+				return;
+			}
+			that->_location = FileLocation();
+			that->_locationValidatedPath = QString();
+			_owner->notifyDocumentLayoutChanged(this);
+		});
+	});
+}
+
 QString DocumentData::filepath(FilePathResolve resolve) const {
 	bool check = (resolve != FilePathResolve::Cached);
+	if (!check) {
+		validateLocationAsync();
+	}
 	QString result = (check && _location.name().isEmpty()) ? QString() : location(check).name();
 	bool saveFromData = result.isEmpty() && !data().isEmpty();
 	if (saveFromData) {
@@ -1184,7 +1212,13 @@ bool DocumentData::inappPlaybackFailed() const {
 auto DocumentData::createStreamingLoader(Data::FileOrigin origin) const
 -> std::unique_ptr<Media::Streaming::Loader> {
 	const auto &location = this->location(true);
-	if (!data().isEmpty()) {
+
+	// Long songs and podcasts are read from the file incrementally,
+	// so that the in-memory copy is not pinned while they're playing.
+	const auto preferFile = isAudioFile()
+		&& (size > Storage::kMaxVoiceInMemory)
+		&& !location.isEmpty();
+	if (!data().isEmpty() && !preferFile) {
 		return Media::Streaming::MakeBytesLoader(data());
 	} else if (!location.isEmpty() && location.accessEnable()) {
 		auto result = Media::Streaming::MakeFileLoader(location.name());
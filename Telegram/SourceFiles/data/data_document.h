@@ -252,6 +252,7 @@ private:
 	void setMaybeSupportsStreaming(bool supports);
 
 	void destroyLoader(mtpFileLoader *newValue = nullptr) const;
+	void validateLocationAsync() const;
 
 	[[nodiscard]] bool thumbnailEnoughForSticker() const;
 
@@ -272,6 +273,7 @@ private:
 	not_null<Data::Session*> _owner;
 
 	FileLocation _location;
+	mutable QString _locationValidatedPath;
 	QByteArray _data;
 	std::unique_ptr<DocumentAdditionalData> _additional;
 	int32 _duration = -1;
@@ -10,6 +10,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_document.h"
 #include "data/data_file_origin.h"
 #include "media/clip/media_clip_reader.h"
+#include "ui/image/image_prepare.h"
 #include "auth_session.h"
 
 namespace Data {
@@ -38,6 +39,7 @@ QImage Prepare(
 	if (!reader.canRead() || !validateSize(reader.size())) {
 		return QImage();
 	}
+	Images::ScaleOnDecode(reader, QSize(kWallPaperSize, kWallPaperSize));
 	auto result = reader.read();
 	if (!result.width() || !result.height()) {
 		return QImage();
@@ -106,13 +106,18 @@ HistoryItemsList::const_iterator Groups::findPositionForItem(
 	if (!IsServerMsgId(itemId)) {
 		return last;
 	}
-	for (auto result = begin(group); result != last; ++result) {
-		const auto alreadyId = (*result)->id;
-		if (IsServerMsgId(alreadyId) && alreadyId > itemId) {
-			return result;
-		}
-	}
-	return last;
+
+	// Server ids go first in ascending order, local ids are at the end.
+	return ranges::upper_bound(
+		group,
+		itemId,
+		std::less<>(),
+		[](not_null<HistoryItem*> already) {
+			const auto alreadyId = already->id;
+			return IsServerMsgId(alreadyId)
+				? alreadyId
+				: std::numeric_limits<MsgId>::max();
+		});
 }
 
 const Group *Groups::find(not_null<HistoryItem*> item) const {
@@ -130,7 +135,31 @@ const Group *Groups::find(not_null<HistoryItem*> item) const {
 	return nullptr;
 }
 
+void Groups::startBatch() {
+	++_batchLevel;
+}
+
+void Groups::finishBatch() {
+	Expects(_batchLevel > 0);
+
+	if (--_batchLevel > 0) {
+		return;
+	}
+	for (const auto groupId : base::take(_batchRefresh)) {
+		const auto i = _groups.find(groupId);
+		if (i != end(_groups)) {
+			for (const auto item : i->second.items) {
+				_data->requestItemViewRefresh(item);
+			}
+		}
+	}
+}
+
 void Groups::refreshViews(const HistoryItemsList &items) {
+	if (_batchLevel > 0 && !items.empty()) {
+		_batchRefresh.emplace(items.front()->groupId());
+		return;
+	}
 	for (const auto item : items) {
 		_data->requestItemViewRefresh(item);
 	}
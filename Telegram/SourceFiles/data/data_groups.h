@@ -28,6 +28,11 @@ public:
 
 	const Group *find(not_null<HistoryItem*> item) const;
 
+	// While a slice of messages is created the views of each changed
+	// group are refreshed once, when the batch is finished.
+	void startBatch();
+	void finishBatch();
+
 private:
 	HistoryItemsList::const_iterator findPositionForItem(
 		const HistoryItemsList &group,
@@ -36,7 +41,9 @@ private:
 
 	not_null<Session*> _data;
 	std::map<MessageGroupId, Group> _groups;
-	std::map<MessageGroupId, MessageGroupId> _alias;
+
+	int _batchLevel = 0;
+	base::flat_set<MessageGroupId> _batchRefresh;
 
 };
 
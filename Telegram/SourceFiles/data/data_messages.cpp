@@ -7,6 +7,33 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_feed_messages.h"
 
 namespace Data {
+namespace {
+
+// Returns the count of positions removed. Erasing them one by one would
+// shift the rest of the set each time and be quadratic for long feeds.
+int RemoveFromChannel(
+		base::flat_set<MessagePosition> &positions,
+		ChannelId channelId) {
+	const auto fromChannel = [&](const MessagePosition &position) {
+		return (position.fullId.channel == channelId);
+	};
+	const auto was = int(positions.size());
+	const auto removed = int(ranges::count_if(positions, fromChannel));
+	if (!removed) {
+		return 0;
+	}
+	auto kept = std::vector<MessagePosition>();
+	kept.reserve(was - removed);
+	for (const auto &position : positions) {
+		if (!fromChannel(position)) {
+			kept.push_back(position);
+		}
+	}
+	positions = base::flat_set<MessagePosition>(kept.begin(), kept.end());
+	return removed;
+}
+
+} // namespace
 
 MessagesList::Slice::Slice(
 	base::flat_set<MessagePosition> &&messages,
@@ -149,15 +176,7 @@ void MessagesList::removeAll(ChannelId channelId) {
 	auto removed = 0;
 	for (auto i = begin(_slices); i != end(_slices); ++i) {
 		_slices.modify(i, [&](Slice &slice) {
-			auto &messages = slice.messages;
-			for (auto j = begin(messages); j != end(messages);) {
-				if (j->fullId.channel == channelId) {
-					j = messages.erase(j);
-					++removed;
-				} else {
-					++j;
-				}
-			}
+			removed += RemoveFromChannel(slice.messages, channelId);
 		});
 	}
 	if (removed && _count) {
@@ -216,8 +235,9 @@ MessagesResult MessagesList::queryFromSlice(
 	auto haveEqualOrAfter = int(end(slice.messages) - position);
 	auto before = qMin(haveBefore, query.limitBefore);
 	auto equalOrAfter = qMin(haveEqualOrAfter, query.limitAfter + 1);
-	auto ids = std::vector<MessagePosition>(position - before, position + equalOrAfter);
-	result.messageIds.merge(ids.begin(), ids.end());
+	result.messageIds = base::flat_set<MessagePosition>(
+		position - before,
+		position + equalOrAfter);
 	if (slice.range.from == MinMessagePosition) {
 		result.skippedBefore = haveBefore - before;
 	}
@@ -321,15 +341,9 @@ bool MessagesSliceBuilder::removeAll() {
 }
 
 bool MessagesSliceBuilder::removeFromChannel(ChannelId channelId) {
-	for (auto i = _ids.begin(); i != _ids.end();) {
-		if ((*i).fullId.channel == channelId) {
-			i = _ids.erase(i);
-			if (_fullCount) {
-				--*_fullCount;
-			}
-		} else {
-			++i;
-		}
+	const auto removed = RemoveFromChannel(_ids, channelId);
+	if (_fullCount) {
+		*_fullCount -= removed;
 	}
 	_skippedBefore = _skippedAfter = std::nullopt;
 	checkInsufficient();
@@ -241,6 +241,12 @@ void PeerData::loadUserpic(bool loadFirst, bool prior) {
 	_userpic->load(userpicOrigin(), loadFirst, prior);
 }
 
+void PeerData::prepareUserpic(int size) const {
+	if (const auto userpic = currentUserpic()) {
+		userpic->pixCircled(userpicOrigin(), size, size);
+	}
+}
+
 bool PeerData::userpicLoaded() const {
 	return _userpic->loaded();
 }
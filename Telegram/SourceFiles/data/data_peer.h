@@ -231,6 +231,10 @@ public:
 		int y,
 		int size) const;
 	void loadUserpic(bool loadFirst = false, bool prior = true);
+
+	// Loads the userpic and, if it is loaded already, prepares the circle
+	// of the given size, so that rows about to be shown paint instantly.
+	void prepareUserpic(int size) const;
 	[[nodiscard]] bool userpicLoaded() const;
 	[[nodiscard]] bool useEmptyUserpic() const;
 	[[nodiscard]] StorageKey userpicUniqueKey() const;
@@ -150,6 +150,10 @@ Session::Session(not_null<AuthSession*> session)
 	Local::cacheBigFileSettings()))
 , _selfDestructTimer([=] { checkSelfDestructItems(); })
 , _a_sendActions(animation(this, &Session::step_typings))
+, _onlineTextRefreshTimer([=] {
+	_onlineTextRefreshAt = 0;
+	_onlineTextRefreshes.fire({});
+})
 , _groups(this)
 , _unmuteByFinishedTimer([=] { unmuteByFinished(); }) {
 	_cache->open(Local::cacheKey());
@@ -1028,7 +1032,19 @@ rpl::producer<not_null<const HistoryItem*>> Session::itemRepaintRequest() const
 }
 
 void Session::requestViewRepaint(not_null<const ViewElement*> view) {
-	_viewRepaintRequest.fire_copy(view);
+	// Many downloads update their progress in one event loop iteration,
+	// repaint each view once after all of them.
+	const auto invoke = _viewRepaintsQueued.empty();
+	_viewRepaintsQueued.emplace(view);
+	if (invoke) {
+		crl::on_main(_session, [=] { sendViewRepaints(); });
+	}
+}
+
+void Session::sendViewRepaints() {
+	for (const auto view : base::take(_viewRepaintsQueued)) {
+		_viewRepaintRequest.fire_copy(view);
+	}
 }
 
 rpl::producer<not_null<const ViewElement*>> Session::viewRepaintRequest() const {
@@ -1201,6 +1217,29 @@ rpl::producer<> Session::savedGifsUpdated() const {
 	return _savedGifsUpdated.events();
 }
 
+void Session::ensureStickersRead() const {
+	if (_stickersRead) {
+		return;
+	}
+	// The readers use the accessors themselves, mark it before reading.
+	_stickersRead = true;
+
+	const auto ms = crl::now();
+	Local::readInstalledStickers();
+	Local::readFeaturedStickers();
+	Local::readRecentStickers();
+	Local::readFavedStickers();
+	LOG(("Stickers read time: %1").arg(crl::now() - ms));
+}
+
+void Session::ensureSavedGifsRead() const {
+	if (_savedGifsRead) {
+		return;
+	}
+	_savedGifsRead = true;
+	Local::readSavedGifs();
+}
+
 void Session::userIsContactUpdated(not_null<UserData*> user) {
 	const auto i = _contactViews.find(peerToUser(user->id));
 	if (i != _contactViews.end()) {
@@ -1479,6 +1518,19 @@ void Session::updateSendActionAnimation(
 	_sendActionAnimationUpdate.fire(std::move(update));
 }
 
+void Session::scheduleOnlineTextRefresh(crl::time when) {
+	if (_onlineTextRefreshAt && _onlineTextRefreshAt <= when) {
+		return;
+	}
+	_onlineTextRefreshAt = when;
+	_onlineTextRefreshTimer.callOnce(
+		std::max(when - crl::now(), crl::time(0)));
+}
+
+rpl::producer<> Session::onlineTextRefreshes() const {
+	return _onlineTextRefreshes.events();
+}
+
 int Session::unreadBadge() const {
 	return computeUnreadBadge(
 		_unreadFull,
@@ -1836,6 +1888,7 @@ void Session::photoApplyFields(
 	const auto thumbnail = image(ThumbnailLevels);
 	const auto large = image(LargeLevels);
 	if (thumbnailSmall && thumbnail && large) {
+		MTP::prepareDownloadDc(large->location().dc());
 		photoApplyFields(
 			photo,
 			data.vaccess_hash.v,
@@ -2095,6 +2148,7 @@ void Session::documentApplyFields(
 	document->setattributes(attributes);
 	if (dc != 0 && access != 0) {
 		document->setRemoteLocation(dc, access, fileReference);
+		MTP::prepareDownloadDc(dc);
 	}
 	document->date = date;
 	document->setMimeString(mime);
@@ -2694,6 +2748,19 @@ HistoryItem *Session::findWebPageItem(not_null<WebPageData*> page) const {
 	return nullptr;
 }
 
+HistoryItem *Session::findDocumentItem(
+		not_null<DocumentData*> document) const {
+	const auto i = _documentItems.find(document);
+	if (i != _documentItems.end()) {
+		for (const auto item : i->second) {
+			if (IsServerMsgId(item->id)) {
+				return item;
+			}
+		}
+	}
+	return nullptr;
+}
+
 QString Session::findContactPhone(not_null<UserData*> contact) const {
 	const auto result = contact->phone();
 	return result.isEmpty()
@@ -2773,6 +2840,7 @@ void Session::registerItemView(not_null<ViewElement*> view) {
 }
 
 void Session::unregisterItemView(not_null<ViewElement*> view) {
+	_viewRepaintsQueued.remove(view);
 	const auto i = _views.find(view->data());
 	if (i != end(_views)) {
 		auto &list = i->second;
@@ -238,30 +238,38 @@ public:
 		_lastSavedGifsUpdate = update;
 	}
 	int featuredStickerSetsUnreadCount() const {
+		ensureStickersRead();
 		return _featuredStickerSetsUnreadCount.current();
 	}
 	void setFeaturedStickerSetsUnreadCount(int count) {
 		_featuredStickerSetsUnreadCount = count;
 	}
 	[[nodiscard]] rpl::producer<int> featuredStickerSetsUnreadCountValue() const {
+		ensureStickersRead();
 		return _featuredStickerSetsUnreadCount.value();
 	}
 	const Stickers::Sets &stickerSets() const {
+		ensureStickersRead();
 		return _stickerSets;
 	}
 	Stickers::Sets &stickerSetsRef() {
+		ensureStickersRead();
 		return _stickerSets;
 	}
 	const Stickers::Order &stickerSetsOrder() const {
+		ensureStickersRead();
 		return _stickerSetsOrder;
 	}
 	Stickers::Order &stickerSetsOrderRef() {
+		ensureStickersRead();
 		return _stickerSetsOrder;
 	}
 	const Stickers::Order &featuredStickerSetsOrder() const {
+		ensureStickersRead();
 		return _featuredStickerSetsOrder;
 	}
 	Stickers::Order &featuredStickerSetsOrderRef() {
+		ensureStickersRead();
 		return _featuredStickerSetsOrder;
 	}
 	const Stickers::Order &archivedStickerSetsOrder() const {
@@ -271,9 +279,11 @@ public:
 		return _archivedStickerSetsOrder;
 	}
 	const Stickers::SavedGifs &savedGifs() const {
+		ensureSavedGifsRead();
 		return _savedGifs;
 	}
 	Stickers::SavedGifs &savedGifsRef() {
+		ensureSavedGifsRead();
 		return _savedGifs;
 	}
 
@@ -323,6 +333,12 @@ public:
 		-> rpl::producer<SendActionAnimationUpdate>;
 	void updateSendActionAnimation(SendActionAnimationUpdate &&update);
 
+	// One timer for all the shown "last seen" texts: each widget asks
+	// to be refreshed when its text changes and all of them get notified
+	// at the nearest of those times, then they schedule their next one.
+	void scheduleOnlineTextRefresh(crl::time when);
+	[[nodiscard]] rpl::producer<> onlineTextRefreshes() const;
+
 	int unreadBadge() const;
 	bool unreadBadgeMuted() const;
 	int unreadBadgeIgnoreOne(History *history) const;
@@ -485,6 +501,7 @@ public:
 		not_null<::Media::Clip::Reader*> reader);
 
 	HistoryItem *findWebPageItem(not_null<WebPageData*> page) const;
+	HistoryItem *findDocumentItem(not_null<DocumentData*> document) const;
 	QString findContactPhone(not_null<UserData*> contact) const;
 	QString findContactPhone(UserId contactId) const;
 
@@ -559,6 +576,7 @@ private:
 	void setupChannelLeavingViewer();
 
 	void checkSelfDestructItems();
+	void sendViewRepaints();
 	int computeUnreadBadge(
 		int full,
 		int muted,
@@ -642,6 +660,8 @@ private:
 		PhotoData *photo,
 		DocumentData *document);
 
+	void ensureStickersRead() const;
+	void ensureSavedGifsRead() const;
 	bool stickersUpdateNeeded(crl::time lastUpdate, crl::time now) const {
 		constexpr auto kStickersUpdateTimeout = crl::time(3600'000);
 		return (lastUpdate == 0)
@@ -693,6 +713,7 @@ private:
 	rpl::event_stream<not_null<const ViewElement*>> _viewLayoutChanges;
 	rpl::event_stream<not_null<const HistoryItem*>> _itemRepaintRequest;
 	rpl::event_stream<not_null<const ViewElement*>> _viewRepaintRequest;
+	base::flat_set<not_null<const ViewElement*>> _viewRepaintsQueued;
 	rpl::event_stream<not_null<const HistoryItem*>> _itemResizeRequest;
 	rpl::event_stream<not_null<ViewElement*>> _viewResizeRequest;
 	rpl::event_stream<not_null<HistoryItem*>> _itemViewRefreshRequest;
@@ -722,6 +743,11 @@ private:
 	Stickers::Order _archivedStickerSetsOrder;
 	Stickers::SavedGifs _savedGifs;
 
+	// Sticker sets and saved gifs are read from the local storage
+	// only when something asks for them, not at the startup.
+	mutable bool _stickersRead = false;
+	mutable bool _savedGifsRead = false;
+
 	int _unreadFull = 0;
 	int _unreadMuted = 0;
 	int _unreadEntriesFull = 0;
@@ -734,6 +760,10 @@ private:
 	base::flat_map<not_null<History*>, crl::time> _sendActions;
 	BasicAnimation _a_sendActions;
 
+	base::Timer _onlineTextRefreshTimer;
+	crl::time _onlineTextRefreshAt = 0;
+	rpl::event_stream<> _onlineTextRefreshes;
+
 	std::unordered_map<
 		PhotoId,
 		std::unique_ptr<PhotoData>> _photos;
@@ -67,10 +67,12 @@ void UserData::setContactStatus(ContactStatus status) {
 				Notify::PeerUpdate::Flag::UserIsContact);
 		}
 	}
-	if (_contactStatus == ContactStatus::Contact
-		&& cReportSpamStatuses().value(id, dbiprsHidden) != dbiprsHidden) {
-		cRefReportSpamStatuses().insert(id, dbiprsHidden);
-		Local::writeReportSpamStatuses();
+	if (_contactStatus == ContactStatus::Contact) {
+		Local::readReportSpamStatuses();
+		if (cReportSpamStatuses().value(id, dbiprsHidden) != dbiprsHidden) {
+			cRefReportSpamStatuses().insert(id, dbiprsHidden);
+			Local::writeReportSpamStatuses();
+		}
 	}
 }
 
@@ -44,8 +44,7 @@ uint64 PinnedDialogPos(int pinnedIndex) {
 } // namespace
 
 Entry::Entry(const Key &key, uint64 id)
-: lastItemTextCache(st::dialogsTextWidthMin)
-, _key(key) {
+: _key(key) {
 	loadIsFavorite(id);
 	loadPinnedIndex(id);
 }
@@ -128,9 +128,6 @@ public:
 
 	virtual ~Entry() = default;
 
-	mutable const HistoryItem *textCachedFor = nullptr; // cache
-	mutable Text lastItemTextCache;
-
 private:
 	virtual TimeId adjustChatListTimeId() const;
 	virtual void changedInChatListHook(Dialogs::Mode list, bool added);
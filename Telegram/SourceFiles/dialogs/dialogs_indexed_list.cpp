@@ -32,7 +32,10 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 			}
 			result.emplace(ch, j->second->addToEnd(key));
 		}
-		performFilter();
+		if (_pFiltered && passesFilter(key)) {
+			key.entry()->setRowInCurrentTab(_pFiltered->addToEnd(key));
+		}
+		++_revision;
 	}
 	return result;
 }
@@ -52,7 +55,10 @@ Row *IndexedList::addByName(Key key) {
 		}
 		j->second->addByName(key);
 	}
-	performFilter();
+	if (_pFiltered && passesFilter(key)) {
+		key.entry()->setRowInCurrentTab(_pFiltered->addByName(key));
+	}
+	++_revision;
 	return result;
 }
 
@@ -60,11 +66,16 @@ void IndexedList::adjustByPos(const RowsByLetter &links) {
 	for (const auto [ch, row] : links) {
 		if (ch == QChar(0)) {
 			_list.adjustByPos(row);
-			performFilter();
+			if (_pFiltered) {
+				if (const auto filtered = _pFiltered->getRow(row->key())) {
+					_pFiltered->adjustByPos(filtered);
+				}
+			}
+			++_revision;
 		} else {
 			if (auto it = _index.find(ch); it != _index.cend()) {
 				it->second->adjustByPos(row);
-				performFilter();
+				++_revision;
 			}
 		}
 	}
@@ -77,7 +88,10 @@ void IndexedList::moveToTop(Key key) {
 				it->second->moveToTop(key);
 			}
 		}
-		performFilter();
+		if (_pFiltered) {
+			_pFiltered->moveToTop(key);
+		}
+		++_revision;
 	}
 }
 
@@ -107,7 +121,7 @@ void IndexedList::peerNameChanged(
 		} else {
 			adjustNames(Dialogs::Mode::All, history, oldLetters);
 		}
-		performFilter();
+		++_revision;
 	}
 }
 
@@ -119,7 +133,7 @@ void IndexedList::peerNameChanged(
 
 	if (const auto history = peer->owner().historyLoaded(peer)) {
 		adjustNames(list, history, oldLetters);
-		performFilter();
+		++_revision;
 	}
 }
 
@@ -129,6 +143,10 @@ void IndexedList::adjustByName(
 	const auto mainRow = _list.adjustByName(key);
 	if (!mainRow) return;
 
+	if (_pFiltered) {
+		_pFiltered->adjustByName(key);
+	}
+
 	auto toRemove = oldLetters;
 	auto toAdd = base::flat_set<QChar>();
 	for (const auto ch : key.entry()->chatListFirstLetters()) {
@@ -207,7 +225,11 @@ void IndexedList::del(Key key, Row *replacedBy) {
 				it->second->del(key, replacedBy);
 			}
 		}
-		performFilter();
+		if (_pFiltered && _pFiltered->contains(key)) {
+			key.entry()->setRowInCurrentTab(nullptr);
+			_pFiltered->del(key);
+		}
+		++_revision;
 	}
 }
 
@@ -240,6 +262,8 @@ void IndexedList::setFilterTypes(EntryTypes types)
 
 void IndexedList::performFilter()
 {
+	++_revision;
+
 	emit performFilterStarted();
 
 	if(_filterTypes == EntryType::All)
@@ -250,7 +274,7 @@ void IndexedList::performFilter()
 				(*it)->key().entry()->setRowInCurrentTab(nullptr);
 			}
 
-			_pFiltered.release();
+			_pFiltered = nullptr;
 		}
 
 		emit performFilterFinished();
@@ -261,7 +285,7 @@ void IndexedList::performFilter()
 
 	for(auto it = _list.cbegin(); it != _list.cend(); ++it)
 	{
-		if (((*it)->entry()->getEntryType() & _filterTypes) != EntryType::None) {
+		if (passesFilter((*it)->key())) {
 			Row *row = _pFiltered->addToEnd((*it)->key());
 			(*it)->key().entry()->setRowInCurrentTab(row);
 		}
@@ -270,6 +294,11 @@ void IndexedList::performFilter()
 	emit performFilterFinished();
 }
 
+bool IndexedList::passesFilter(Key key) const
+{
+	return (key.entry()->getEntryType() & _filterTypes) != EntryType::None;
+}
+
 void IndexedList::countUnreadMessages(int *countInFavorite, int *countInGroup, int *countInOneOnOne, int *countInAnnouncement) const
 {
 	int inFavorite = 0;
@@ -353,6 +382,7 @@ const List& IndexedList::current() const
 
 void IndexedList::clear() {
 	_index.clear();
+	++_revision;
 }
 
 bool IndexedList::isFilteredByType() const
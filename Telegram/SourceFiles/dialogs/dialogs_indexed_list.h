@@ -58,6 +58,11 @@ public:
 
 	bool isFilteredByType() const;
 
+	// Changes on any addition, removal, reorder or rename.
+	int revision() const {
+		return _revision;
+	}
+
 	~IndexedList();
 
 	// Part of List interface is duplicated here for all() list.
@@ -84,6 +89,8 @@ public:
 	void setFilterTypes(EntryTypes types);
 	const EntryTypes& getFilterTypes() const { return _filterTypes; }
 
+	// Rebuilds the list for the current tab. The mutators above keep
+	// it up to date, so this is needed only when entry types change.
 	void performFilter();
 
 	void countUnreadMessages(int *countInFavorite, int *countInGroup, int *countInOneOnOne, int *countInAnnouncement) const;
@@ -104,6 +111,7 @@ private:
 
 	List& current();
 	const List& current() const;
+	bool passesFilter(Key key) const;
 
 	void markAsRead(Row *row);
 
@@ -112,6 +120,7 @@ private:
 	std::unique_ptr<List> _pFiltered;
 	base::flat_map<QChar, std::unique_ptr<List>> _index;
 	Dialogs::EntryTypes	_filterTypes = Dialogs::EntryType::All;
+	int _revision = 0;
 
 };
 
@@ -12,6 +12,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "history/feed/history_feed_section.h"
 #include "history/history.h"
 #include "history/history_item.h"
+#include "history/view/history_view_element.h"
 #include "core/shortcuts.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
@@ -44,6 +45,38 @@ namespace {
 
 constexpr auto kHashtagResultsLimit = 5;
 constexpr auto kStartReorderThreshold = 30;
+constexpr auto kLocalSearchResultsLimit = 100;
+constexpr auto kPreloadSelectedTimeout = crl::time(300);
+
+template <typename Words>
+bool MatchesSearchWords(const Words &nameWords, const QStringList &words) {
+	for (const auto &word : words) {
+		const auto found = ranges::find_if(nameWords, [&](const QString &name) {
+			return name.startsWith(word);
+		});
+		if (found == nameWords.end()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Each word of the old query is a prefix of some new word, so every
+// chat matching the new query is already in the old results.
+bool RefinesSearchWords(const QStringList &now, const QStringList &was) {
+	if (was.isEmpty()) {
+		return false;
+	}
+	for (const auto &word : was) {
+		const auto found = ranges::find_if(now, [&](const QString &other) {
+			return other.startsWith(word);
+		});
+		if (found == now.end()) {
+			return false;
+		}
+	}
+	return true;
+}
 
 } // namespace
 
@@ -73,7 +106,8 @@ DialogsInner::DialogsInner(QWidget *parent, not_null<Window::Controller*> contro
 , _a_pinnedShifting(animation(this, &DialogsInner::step_pinnedShifting))
 , _addContactLnk(this, lang(lng_add_contact_button))
 , _cancelSearchInChat(this, st::dialogsCancelSearchInPeer)
-, _cancelSearchFromUser(this, st::dialogsCancelSearchInPeer) {
+, _cancelSearchFromUser(this, st::dialogsCancelSearchInPeer)
+, _preloadSelectedTimer([=] { preloadSelectedHistory(); }) {
 
 #ifdef OS_MAC_OLD
 	// Qt 5.3.2 build is working with glitches otherwise.
@@ -102,11 +136,11 @@ DialogsInner::DialogsInner(QWidget *parent, not_null<Window::Controller*> contro
 	Auth().data().itemRepaintRequest(
 	) | rpl::start_with_next([=](auto item) {
 		const auto history = item->history();
-		if (history->textCachedFor == item) {
+		if (history->chatListMessage() == item) {
 			history->updateChatListEntry();
 		}
 		if (const auto feed = history->peer->feed()) {
-			if (feed->textCachedFor == item) {
+			if (feed->chatListMessage() == item) {
 				feed->updateChatListEntry();
 			}
 		}
@@ -266,6 +300,12 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 	const auto activeEntry = _controller->activeChatEntryCurrent();
 	auto fullWidth = getFullWidth();
 	auto ms = crl::now();
+
+	// Updates of distant rows, like the old and the new selected one,
+	// come in a single region, don't repaint all the rows between them.
+	const auto rowInRegion = [&](int top, int height) {
+		return region.intersects(QRect(r.x(), top, r.width(), height));
+	};
 	if (_state == State::Default) {
 		if (_a_pinnedShifting.animating()) {
 			_a_pinnedShifting.step(ms, false);
@@ -326,6 +366,11 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 			auto i = list.cfind(dialogsClip.top(), st::dialogsRowHeight);
 			if (i != list.cend()) {
 				auto lastPaintedPos = (*i)->pos();
+				const auto rowsTop = _dialogsImportant
+					? st::dialogsImportantBarHeight
+					: 0;
+				const auto shifting = reorderingPinned
+					|| _a_pinnedShifting.animating();
 
 				// If we're reordering pinned chats we need to fill this area background first.
 				if (reorderingPinned) {
@@ -340,8 +385,12 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 					}
 
 					// Skip currently dragged chat to paint it above others after.
-					if (lastPaintedPos != promoted + _aboveIndex
-						|| _aboveIndex < 0) {
+					if ((lastPaintedPos != promoted + _aboveIndex
+						|| _aboveIndex < 0)
+						&& (shifting
+							|| rowInRegion(
+								rowsTop + lastPaintedPos * st::dialogsRowHeight,
+								st::dialogsRowHeight))) {
 						paintDialog(row);
 					}
 
@@ -423,6 +472,12 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 			p.translate(0, from * st::dialogsRowHeight);
 			if (from < _filterResults.size()) {
 				for (; from < to; ++from) {
+					if (!rowInRegion(
+							skip + from * st::dialogsRowHeight,
+							st::dialogsRowHeight)) {
+						p.translate(0, st::dialogsRowHeight);
+						continue;
+					}
 					const auto row = _filterResults[from];
 					const auto key = row->key();
 					const auto active = (activeEntry.key == key)
@@ -788,6 +843,11 @@ void DialogsInner::selectByMouse(QPoint globalPosition) {
 			_importantSwitchSelected = importantSwitchSelected;
 			updateSelectedRow();
 			setCursor((_selected || _importantSwitchSelected) ? style::cur_pointer : style::cur_default);
+			if (_selected) {
+				_preloadSelectedTimer.callOnce(kPreloadSelectedTimeout);
+			} else {
+				_preloadSelectedTimer.cancel();
+			}
 		}
 	} else if (_state == State::Filtered) {
 		auto wasSelected = isSelected();
@@ -1315,13 +1375,37 @@ void DialogsInner::createDialog(Dialogs::Key key) {
 		emit dialogMoved(from, to);
 	}
 
-	if (creating) {
+	if (_batchLevel > 0) {
+		if (creating) {
+			_batchRefresh = true;
+		} else if (_state == State::Default && from != to) {
+			_batchRepaint = true;
+		}
+	} else if (creating) {
 		refresh();
 	} else if (_state == State::Default && from != to) {
 		update(0, qMin(from, to), getFullWidth(), qAbs(from - to) + st::dialogsRowHeight);
 	}
 }
 
+void DialogsInner::startBatch() {
+	++_batchLevel;
+}
+
+void DialogsInner::finishBatch() {
+	Expects(_batchLevel > 0);
+
+	if (--_batchLevel > 0) {
+		return;
+	}
+	if (base::take(_batchRefresh)) {
+		_batchRepaint = false;
+		refresh();
+	} else if (base::take(_batchRepaint)) {
+		update();
+	}
+}
+
 void DialogsInner::removeDialog(Dialogs::Key key) {
 	if (key == _menuRow.key && _menu) {
 		InvokeQueued(this, [=] { _menu = nullptr; });
@@ -1570,8 +1654,19 @@ void DialogsInner::dragLeft() {
 	clearSelection();
 }
 
+void DialogsInner::preloadSelectedHistory() {
+	if (!_selected) {
+		return;
+	} else if (const auto history = _selected->history()) {
+		if (history != _controller->activeChatCurrent().history()) {
+			Auth().api().preloadHistory(history);
+		}
+	}
+}
+
 void DialogsInner::clearSelection() {
 	_mouseSelection = false;
+	_preloadSelectedTimer.cancel();
 	_lastMousePosition = std::nullopt;
 	if (_importantSwitchSelected
 		|| _selected
@@ -1698,82 +1793,69 @@ void DialogsInner::applyFilterUpdate(QString newFilter, bool force) {
 		if (_filter.isEmpty() && !_searchFromUser) {
 			clearFilter();
 		} else {
-			QStringList::const_iterator fb = words.cbegin(), fe = words.cend(), fi;
+			const auto revisions = std::make_pair(
+				_dialogs->revision(),
+				_contactsNoDialogs->revision());
+			const auto narrow = !force
+				&& (_state == State::Filtered)
+				&& !_searchInChat
+				&& (_filterRevisions == revisions)
+				&& RefinesSearchWords(words, _filterWords);
 
 			_state = State::Filtered;
 			_waitingForSearch = true;
-			_filterResults.clear();
 			_filterResultsGlobal.clear();
-			if (!_searchInChat && !words.isEmpty()) {
-				const Dialogs::List *toFilter = nullptr;
-				if (!_dialogs->isEmpty()) {
-					for (fi = fb; fi != fe; ++fi) {
-						auto found = _dialogs->filtered(fi->at(0));
-						if (found->isEmpty()) {
-							toFilter = nullptr;
-							break;
-						}
-						if (!toFilter || toFilter->size() > found->size()) {
-							toFilter = found;
-						}
+			if (narrow) {
+				_filterResults.erase(
+					ranges::remove_if(_filterResults, [&](Dialogs::Row *row) {
+						return !MatchesSearchWords(
+							row->entry()->chatListNameWords(),
+							words);
+					}),
+					_filterResults.end());
+			} else {
+				_filterResults.clear();
+			}
+			if (!narrow && !_searchInChat && !words.isEmpty()) {
+				const auto smallest = [&](
+						not_null<Dialogs::IndexedList*> list)
+				-> const Dialogs::List* {
+					if (list->isEmpty()) {
+						return nullptr;
 					}
-				}
-				const Dialogs::List *toFilterContacts = nullptr;
-				if (!_contactsNoDialogs->isEmpty()) {
-					for (fi = fb; fi != fe; ++fi) {
-						auto found = _contactsNoDialogs->filtered(fi->at(0));
+					const Dialogs::List *result = nullptr;
+					for (const auto &word : words) {
+						const auto found = list->filtered(word.at(0));
 						if (found->isEmpty()) {
-							toFilterContacts = nullptr;
-							break;
+							return nullptr;
 						}
-						if (!toFilterContacts || toFilterContacts->size() > found->size()) {
-							toFilterContacts = found;
+						if (!result || result->size() > found->size()) {
+							result = found;
 						}
 					}
-				}
+					return result;
+				};
+				const auto toFilter = smallest(_dialogs.get());
+				const auto toFilterContacts = smallest(
+					_contactsNoDialogs.get());
 				_filterResults.reserve((toFilter ? toFilter->size() : 0)
 					+ (toFilterContacts ? toFilterContacts->size() : 0));
-				if (toFilter) {
-					for (const auto row : *toFilter) {
-						const auto &nameWords = row->entry()->chatListNameWords();
-						auto nb = nameWords.cbegin(), ne = nameWords.cend(), ni = nb;
-						for (fi = fb; fi != fe; ++fi) {
-							auto filterWord = *fi;
-							for (ni = nb; ni != ne; ++ni) {
-								if (ni->startsWith(filterWord)) {
-									break;
-								}
-							}
-							if (ni == ne) {
-								break;
-							}
-						}
-						if (fi == fe) {
-							_filterResults.push_back(row);
-						}
+				const auto add = [&](const Dialogs::List *list) {
+					if (!list) {
+						return;
 					}
-				}
-				if (toFilterContacts) {
-					for (const auto row : *toFilterContacts) {
+					for (const auto row : *list) {
 						const auto &nameWords = row->entry()->chatListNameWords();
-						auto nb = nameWords.cbegin(), ne = nameWords.cend(), ni = nb;
-						for (fi = fb; fi != fe; ++fi) {
-							auto filterWord = *fi;
-							for (ni = nb; ni != ne; ++ni) {
-								if (ni->startsWith(filterWord)) {
-									break;
-								}
-							}
-							if (ni == ne) {
-								break;
-							}
-						}
-						if (fi == fe) {
+						if (MatchesSearchWords(nameWords, words)) {
 							_filterResults.push_back(row);
 						}
 					}
-				}
+				};
+				add(toFilter);
+				add(toFilterContacts);
 			}
+			_filterWords = _searchInChat ? QStringList() : words;
+			_filterRevisions = revisions;
 			refresh(true);
 		}
 		clearMouseSelection(true);
@@ -2056,6 +2138,49 @@ bool DialogsInner::searchReceived(
 	return lastDateFound != 0;
 }
 
+void DialogsInner::localSearchReceived(
+		const QString &query,
+		UserData *from) {
+	const auto history = _searchInChat.history();
+	if (!history) {
+		return;
+	}
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	if (words.isEmpty() && !from) {
+		return;
+	}
+	clearSearchResults(false);
+
+	// Only the loaded part of the history is searched, newest first.
+	for (const auto &block : ranges::view::reverse(history->blocks)) {
+		for (const auto &view : ranges::view::reverse(block->messages)) {
+			const auto item = view->data();
+			if (item->serviceMsg() || (from && item->from().get() != from)) {
+				continue;
+			} else if (!words.isEmpty()
+				&& !MatchesSearchWords(
+					TextUtilities::PrepareSearchWords(
+						item->originalText().text),
+					words)) {
+				continue;
+			}
+			_searchResults.push_back(
+				std::make_unique<Dialogs::FakeRow>(_searchInChat, item));
+			if (int(_searchResults.size()) >= kLocalSearchResultsLimit) {
+				break;
+			}
+		}
+		if (int(_searchResults.size()) >= kLocalSearchResultsLimit) {
+			break;
+		}
+	}
+	_searchedCount = _searchResults.size();
+	if (!_searchResults.empty()) {
+		_waitingForSearch = false;
+	}
+	refresh();
+}
+
 void DialogsInner::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -2331,6 +2456,7 @@ void DialogsInner::clearFilter() {
 		_lastSearchPeer = 0;
 		_lastSearchId = _lastSearchMigratedId = 0;
 		_filter = QString();
+		_filterWords = QStringList();
 		refresh(true);
 	}
 }
@@ -2497,7 +2623,11 @@ void DialogsInner::loadPeerPhotos() {
 				if (((*i)->pos() * st::dialogsRowHeight) >= yTo) {
 					break;
 				}
-				(*i)->entry()->loadUserpic();
+				if (const auto history = (*i)->history()) {
+					history->peer->prepareUserpic(st::dialogsPhotoSize);
+				} else {
+					(*i)->entry()->loadUserpic();
+				}
 			}
 			yFrom = 0;
 		} else {
@@ -2512,7 +2642,12 @@ void DialogsInner::loadPeerPhotos() {
 			if (to > _filterResults.size()) to = _filterResults.size();
 
 			for (; from < to; ++from) {
-				_filterResults[from]->entry()->loadUserpic();
+				const auto row = _filterResults[from];
+				if (const auto history = row->history()) {
+					history->peer->prepareUserpic(st::dialogsPhotoSize);
+				} else {
+					row->entry()->loadUserpic();
+				}
 			}
 		}
 
@@ -2523,7 +2658,8 @@ void DialogsInner::loadPeerPhotos() {
 			if (to > _peerSearchResults.size()) to = _peerSearchResults.size();
 
 			for (; from < to; ++from) {
-				_peerSearchResults[from]->peer->loadUserpic();
+				_peerSearchResults[from]->peer->prepareUserpic(
+					st::dialogsPhotoSize);
 			}
 		}
 		from = (yFrom > filteredOffset() + ((_peerSearchResults.empty() ? 0 : st::searchedBarHeight) + st::searchedBarHeight) ? ((yFrom - filteredOffset() - (_peerSearchResults.empty() ? 0 : st::searchedBarHeight) - st::searchedBarHeight) / int32(st::dialogsRowHeight)) : 0) - _filterResults.size() - _peerSearchResults.size();
@@ -10,6 +10,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "dialogs/dialogs_key.h"
 #include "data/data_messages.h"
 #include "base/flags.h"
+#include "base/timer.h"
 
 namespace Dialogs {
 class Row;
@@ -40,6 +41,10 @@ public:
 		const QVector<MTPMessage> &result,
 		DialogsSearchRequestType type,
 		int fullCount);
+
+	// Shows the loaded messages of the chat being searched in until the
+	// server results replace them.
+	void localSearchReceived(const QString &query, UserData *from);
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -53,6 +58,11 @@ public:
 
 	void createDialog(Dialogs::Key key);
 	void removeDialog(Dialogs::Key key);
+
+	// While a slice of updates is applied the list is resized and
+	// repainted once, when the batch is finished.
+	void startBatch();
+	void finishBatch();
 	void repaintDialogRow(Dialogs::Mode list, not_null<Dialogs::Row*> row);
 	void repaintDialogRow(Dialogs::RowDescriptor row);
 
@@ -291,6 +301,7 @@ private:
 	void savePinnedOrder();
 	void step_pinnedShifting(crl::time ms, bool timer);
 	void handleChatMigration(not_null<ChatData*> chat);
+	void preloadSelectedHistory();
 
 	not_null<Window::Controller*> _controller;
 
@@ -309,10 +320,15 @@ private:
 	bool _importantSwitchPressed = false;
 	Dialogs::Row *_selected = nullptr;
 	Dialogs::Row *_pressed = nullptr;
+	base::Timer _preloadSelectedTimer;
 	Dialogs::Key _selectedKey;
 	Dialogs::Key _pressedKey;
 
 	Dialogs::Row *_dragging = nullptr;
+
+	int _batchLevel = 0;
+	bool _batchRefresh = false;
+	bool _batchRepaint = false;
 	Dialogs::Key _draggingKey;
 	int _draggingIndex = -1;
 	int _aboveIndex = -1;
@@ -339,6 +355,8 @@ private:
 	bool _hashtagDeletePressed = false;
 
 	std::vector<Dialogs::Row*> _filterResults;
+	QStringList _filterWords;
+	std::pair<int, int> _filterRevisions;
 	base::flat_map<
 		not_null<PeerData*>,
 		std::unique_ptr<Dialogs::Row>> _filterResultsGlobal;
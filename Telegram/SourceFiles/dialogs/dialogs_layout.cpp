@@ -443,6 +443,17 @@ void paintRow(
 	}
 }
 
+// Badges with the same text and style are painted by many rows.
+constexpr auto kCachedUnreadBadgesLimit = 256;
+
+using CachedUnreadBadgeKey = std::tuple<
+	QString,
+	int, // index in UnreadBadgeStyleData::bg
+	int, // size
+	int, // padding
+	int, // textTop
+	style::internal::FontData*>;
+
 struct UnreadBadgeSizeData {
 	QImage circle;
 	QPixmap left[6], right[6];
@@ -458,6 +469,7 @@ public:
 		st::dialogsUnreadBgMutedOver,
 		st::dialogsUnreadBgMutedActive
 	};
+	base::flat_map<CachedUnreadBadgeKey, QPixmap> counts;
 };
 Data::GlobalStructurePointer<UnreadBadgeStyleData> unreadBadgeStyle;
 
@@ -571,12 +583,41 @@ void paintUnreadCount(
 		*outUnreadWidth = unreadRectWidth;
 	}
 
-	paintUnreadBadge(p, QRect(unreadRectLeft, unreadRectTop, unreadRectWidth, unreadRectHeight), st);
-
-	auto textTop = st.textTop ? st.textTop : (unreadRectHeight - st.font->height) / 2;
-	p.setFont(st.font);
-	p.setPen(st.active ? st::dialogsUnreadFgActive : (st.selected ? st::dialogsUnreadFgOver : st::dialogsUnreadFg));
-	p.drawText(unreadRectLeft + (unreadRectWidth - unreadWidth) / 2, unreadRectTop + textTop + st.font->ascent, text);
+	unreadBadgeStyle.createIfNull();
+	auto &counts = unreadBadgeStyle->counts;
+	const auto index = (st.muted ? 0x03 : 0x00)
+		+ (st.active ? 0x02 : (st.selected ? 0x01 : 0x00));
+	const auto key = CachedUnreadBadgeKey(
+		text,
+		index,
+		st.size,
+		st.padding,
+		st.textTop,
+		st.font.v());
+	auto i = counts.find(key);
+	if (i == end(counts)) {
+		if (counts.size() >= kCachedUnreadBadgesLimit) {
+			counts.clear();
+		}
+		auto image = QImage(
+			QSize(unreadRectWidth, unreadRectHeight) * cIntRetinaFactor(),
+			QImage::Format_ARGB32_Premultiplied);
+		image.setDevicePixelRatio(cRetinaFactor());
+		image.fill(Qt::transparent);
+		{
+			Painter q(&image);
+			paintUnreadBadge(q, QRect(0, 0, unreadRectWidth, unreadRectHeight), st);
+
+			auto textTop = st.textTop ? st.textTop : (unreadRectHeight - st.font->height) / 2;
+			q.setFont(st.font);
+			q.setPen(st.active ? st::dialogsUnreadFgActive : (st.selected ? st::dialogsUnreadFgOver : st::dialogsUnreadFg));
+			q.drawText((unreadRectWidth - unreadWidth) / 2, textTop + st.font->ascent, text);
+		}
+		i = counts.emplace(
+			key,
+			App::pixmapFromImageInPlace(std::move(image))).first;
+	}
+	p.drawPixmap(unreadRectLeft, unreadRectTop, i->second);
 }
 
 void RowPainter::paint(
@@ -691,9 +732,7 @@ void RowPainter::paint(
 				itemRect,
 				active,
 				selected,
-				HistoryItem::DrawInDialog::Normal,
-				entry->textCachedFor,
-				entry->lastItemTextCache);
+				HistoryItem::DrawInDialog::Normal);
 		}
 	};
 	const auto paintCounterCallback = [&] {
@@ -819,9 +858,7 @@ void RowPainter::paint(
 			itemRect,
 			active,
 			selected,
-			drawInDialogWay,
-			row->_cacheFor,
-			row->_cache);
+			drawInDialogWay);
 	};
 	const auto paintCounterCallback = [&] {
 		PaintNarrowCounter(
@@ -903,6 +940,7 @@ void paintImportantSwitch(Painter &p, Mode current, int fullWidth, bool selected
 
 void clearUnreadBadgesCache() {
 	if (unreadBadgeStyle) {
+		unreadBadgeStyle->counts.clear();
 		for (auto &data : unreadBadgeStyle->sizes) {
 			for (auto &left : data.left) {
 				left = QPixmap();
@@ -118,7 +118,7 @@ private:
 	SortMode _sortMode;
 	int _count = 0;
 
-	std::map<Key, not_null<Row*>> _rowByKey;
+	base::flat_map<Key, not_null<Row*>> _rowByKey;
 
 	mutable Row *_current; // cache
 
@@ -45,8 +45,7 @@ uint64 Row::sortKey() const {
 
 FakeRow::FakeRow(Key searchInChat, not_null<HistoryItem*> item)
 : _searchInChat(searchInChat)
-, _item(item)
-, _cache(st::dialogsTextWidthMin) {
+, _item(item) {
 }
 
 } // namespace Dialogs
\ No newline at end of file
@@ -94,8 +94,6 @@ private:
 
 	Key _searchInChat;
 	not_null<HistoryItem*> _item;
-	mutable const HistoryItem *_cacheFor = nullptr;
-	mutable Text _cache;
 
 };
 
@@ -25,6 +25,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "auth_session.h"
 #include "apiwrap.h"
 #include "core/application.h"
+#include "core/launcher.h"
+#include "core/startup_trace.h"
 #include "boxes/peer_list_box.h"
 #include "boxes/peers/edit_participants_box.h"
 #include "window/window_controller.h"
@@ -160,7 +162,8 @@ DialogsWidget::DialogsWidget(QWidget *parent, not_null<Window::Controller*> cont
 , _cancelSearch(this, st::dialogsCancelSearch)
 , _lockUnlock(this, st::dialogsLock)
 , _scroll(this, st::dialogsScroll)
-, _chatTabs(this) {
+, _chatTabs(this)
+, _chatTabsUnreadUpdate([=] { updateChatTabsUnreadCounts(); }) {
 
 	_inner = _scroll->setOwnedWidget(object_ptr<DialogsInner>(this, controller, parent));
 	connect(_inner, SIGNAL(draggingScrollDelta(int)), this, SLOT(onDraggingScrollDelta(int)));
@@ -472,6 +475,11 @@ void DialogsWidget::performFilter()
 }
 
 void DialogsWidget::unreadCountChanged()
+{
+	_chatTabsUnreadUpdate.call();
+}
+
+void DialogsWidget::updateChatTabsUnreadCounts()
 {
 	int countInFavorite = 0;
 	int countInGroup = 0;
@@ -514,6 +522,14 @@ void DialogsWidget::dialogsReceived(
 
 	applyReceivedDialogs(*dialogsList, *messagesList);
 
+	if (!_firstDialogsReceived) {
+		_firstDialogsReceived = true;
+		LOG(("Cold start: first dialogs list in %1ms."
+			).arg(crl::now() - Core::App().launcher()->launchedAt()));
+		Core::StartupTrace::Mark("DialogsWidget::firstDialogsReceived");
+		Core::StartupTrace::Finish();
+	}
+
 	_dialogsRequestId = 0;
 	loadDialogs();
 
@@ -703,6 +719,7 @@ bool DialogsWidget::onSearchMessages(bool searchCache) {
 		_searchFull = _searchFullMigrated = false;
 		MTP::cancel(base::take(_searchRequest));
 		if (const auto peer = _searchInChat.peer()) {
+			_inner->localSearchReceived(_searchQuery, _searchQueryFrom);
 			const auto flags = _searchQueryFrom
 				? MTP_flags(MTPmessages_Search::Flag::f_from_id)
 				: MTP_flags(0);
@@ -1499,6 +1516,11 @@ void DialogsWidget::keyPressEvent(QKeyEvent *e) {
 void DialogsWidget::paintEvent(QPaintEvent *e) {
 	if (App::wnd() && App::wnd()->contentOverlapped(this, e)) return;
 
+	if (!_firstPaintTraced) {
+		_firstPaintTraced = true;
+		Core::StartupTrace::Mark("DialogsWidget::firstPaint");
+	}
+
 	Painter p(this);
 	QRect r(e->rect());
 	if (r != rect()) {
@@ -1559,6 +1581,14 @@ void DialogsWidget::removeDialog(Dialogs::Key key) {
 	_inner->removeDialog(key);
 }
 
+void DialogsWidget::startDialogsBatch() {
+	_inner->startBatch();
+}
+
+void DialogsWidget::finishDialogsBatch() {
+	_inner->finishBatch();
+}
+
 Dialogs::IndexedList *DialogsWidget::contactsList() {
 	return _inner->contactsList();
 }
@@ -61,6 +61,8 @@ public:
 	void loadPinnedDialogs();
 	void createDialog(Dialogs::Key key);
 	void removeDialog(Dialogs::Key key);
+	void startDialogsBatch();
+	void finishDialogsBatch();
 	void repaintDialogRow(Dialogs::Mode list, not_null<Dialogs::Row*> row);
 	void repaintDialogRow(Dialogs::RowDescriptor row);
 
@@ -133,6 +135,7 @@ protected:
 	void paintEvent(QPaintEvent *e) override;
 
 private:
+	void updateChatTabsUnreadCounts();
 	void animationCallback();
 	void dialogsReceived(
 		const MTPmessages_Dialogs &result,
@@ -192,6 +195,8 @@ private:
 	mtpRequestId _dialogsRequestId = 0;
 	mtpRequestId _pinnedDialogsRequestId = 0;
 	bool _pinnedDialogsReceived = false;
+	bool _firstDialogsReceived = false;
+	bool _firstPaintTraced = false;
 
 	object_ptr<Ui::IconButton> _forwardCancel = { nullptr };
 	object_ptr<Ui::IconButton> _mainMenuToggle;
@@ -203,6 +208,10 @@ private:
 	object_ptr<Ui::ScrollArea> _scroll;
 	object_ptr<Dialogs::ChatTabs> _chatTabs;
 	bool _chatTabsVisible = true;
+
+	// Unread counts change with each incoming message, the tabs are
+	// recounted once after all the queued changes.
+	SingleQueuedInvokation _chatTabsUnreadUpdate;
 	QPointer<DialogsInner> _inner;
 	class BottomButton;
 	object_ptr<BottomButton> _updateTelegram = { nullptr };
@@ -10,9 +10,11 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_result.h"
 #include "export/output/export_output_file.h"
+#include "export/output/export_output_abstract.h"
 #include "mtproto/rpc_sender.h"
 #include "base/value_ordering.h"
 #include "base/bytes.h"
+#include <QtCore/QFileInfo>
 #include <set>
 #include <deque>
 
@@ -21,8 +23,7 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
-constexpr auto kFileRequestsCount = 2;
-constexpr auto kFileNextRequestDelay = crl::time(20);
+constexpr auto kFileRequestsCount = 4;
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
@@ -95,13 +96,42 @@ public:
 
 	LoadedFileCache(int limit);
 
-	void save(const Location &location, const QString &relativePath);
-	std::optional<QString> find(const Location &location) const;
+	// Loaded files are written to the journal in the export folder,
+	// so an interrupted export reuses them when started there again.
+	void openJournal(const QString &folder);
+	void removeJournal();
+
+	void save(
+		const Location &location,
+		const QString &relativePath,
+		int size);
+
+	// Found files are kept in the cache longer, so the ones repeated
+	// in many messages (like stickers) are not evicted by the others.
+	std::optional<QString> find(const Location &location);
 
 private:
+	void loadJournal();
+	void writeJournal(
+		const LocationKey &key,
+		const QString &relativePath,
+		int size);
+
+	struct Entry {
+		QString relativePath;
+		int lastUse = 0;
+	};
+
+	void use(const LocationKey &key, Entry &entry);
+
 	int _limit = 0;
-	std::map<LocationKey, QString> _map;
-	std::deque<LocationKey> _list;
+	int _lastUse = 0;
+	std::map<LocationKey, Entry> _map;
+	std::deque<std::pair<LocationKey, int>> _list;
+
+	QString _folder;
+	std::optional<QFile> _journal;
+	std::map<LocationKey, QString> _journaled;
 
 };
 
@@ -161,6 +191,7 @@ struct ApiWrap::FileProcess {
 	struct Request {
 		int offset = 0;
 		QByteArray bytes;
+		mtpRequestId id = 0;
 	};
 	std::deque<Request> requests;
 };
@@ -207,6 +238,13 @@ struct ApiWrap::ChatProcess {
 
 	Data::ParseMediaContext context;
 	std::optional<Data::MessagesSlice> slice;
+
+	// Next slice is requested while the files of the current one load.
+	std::optional<Data::MessagesSlice> nextSlice;
+	bool requesting = false;
+	bool stopped = false;
+
+	// The last slice of the last split is already requested.
 	bool lastSlice = false;
 	int fileIndex = 0;
 };
@@ -292,30 +330,117 @@ ApiWrap::LoadedFileCache::LoadedFileCache(int limit) : _limit(limit) {
 	Expects(limit >= 0);
 }
 
+void ApiWrap::LoadedFileCache::openJournal(const QString &folder) {
+	_folder = folder;
+	_journaled.clear();
+	loadJournal();
+
+	_journal.emplace(Output::JournalPath(folder));
+	if (!_journal->open(QIODevice::Append)) {
+		LOG(("Export Error: Could not open journal '%1'."
+			).arg(_journal->fileName()));
+		_journal.reset();
+	}
+}
+
+void ApiWrap::LoadedFileCache::loadJournal() {
+	auto file = QFile(Output::JournalPath(_folder));
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+
+	// Each line is "<type> <id> <size> <relative path>".
+	while (!file.atEnd()) {
+		const auto line = file.readLine().trimmed();
+		const auto parts = line.split(' ');
+		if (parts.size() < 4) {
+			continue;
+		}
+		const auto key = LocationKey{
+			parts[0].toULongLong(),
+			parts[1].toULongLong() };
+		const auto size = parts[2].toInt();
+		const auto prefix = parts[0].size()
+			+ parts[1].size()
+			+ parts[2].size()
+			+ 3;
+		const auto relativePath = QString::fromUtf8(line.mid(prefix));
+
+		// The file could be removed or changed after it was loaded.
+		const auto info = QFileInfo(_folder + relativePath);
+		if (info.exists() && info.size() == size) {
+			_journaled[key] = relativePath;
+		}
+	}
+}
+
+void ApiWrap::LoadedFileCache::writeJournal(
+		const LocationKey &key,
+		const QString &relativePath,
+		int size) {
+	if (!_journal) {
+		return;
+	}
+	const auto line = QByteArray::number(key.type)
+		+ ' ' + QByteArray::number(key.id)
+		+ ' ' + QByteArray::number(size)
+		+ ' ' + relativePath.toUtf8()
+		+ '\n';
+	if (_journal->write(line) != line.size() || !_journal->flush()) {
+		LOG(("Export Error: Could not write journal '%1'."
+			).arg(_journal->fileName()));
+		_journal.reset();
+	}
+}
+
+void ApiWrap::LoadedFileCache::removeJournal() {
+	_journal.reset();
+	_journaled.clear();
+	if (!_folder.isEmpty()) {
+		QFile::remove(Output::JournalPath(_folder));
+	}
+}
+
 void ApiWrap::LoadedFileCache::save(
 		const Location &location,
-		const QString &relativePath) {
+		const QString &relativePath,
+		int size) {
 	if (!location) {
 		return;
 	}
 	const auto key = ComputeLocationKey(location);
-	_map[key] = relativePath;
-	_list.push_back(key);
-	if (_list.size() > _limit) {
-		const auto key = _list.front();
+	writeJournal(key, relativePath, size);
+	auto &entry = _map[key];
+	entry.relativePath = relativePath;
+	use(key, entry);
+}
+
+void ApiWrap::LoadedFileCache::use(const LocationKey &key, Entry &entry) {
+	entry.lastUse = ++_lastUse;
+	_list.emplace_back(key, entry.lastUse);
+
+	// Older uses of the same entries stay in the list until they're popped.
+	while (_map.size() > _limit || _list.size() > 2 * _limit) {
+		const auto [oldKey, oldUse] = _list.front();
 		_list.pop_front();
-		_map.erase(key);
+		const auto i = _map.find(oldKey);
+		if (i != end(_map) && i->second.lastUse == oldUse) {
+			_map.erase(i);
+		}
 	}
 }
 
 std::optional<QString> ApiWrap::LoadedFileCache::find(
-		const Location &location) const {
+		const Location &location) {
 	if (!location) {
 		return std::nullopt;
 	}
 	const auto key = ComputeLocationKey(location);
 	if (const auto i = _map.find(key); i != end(_map)) {
-		return i->second;
+		use(key, i->second);
+		return i->second.relativePath;
+	} else if (const auto j = _journaled.find(key); j != end(_journaled)) {
+		return j->second;
 	}
 	return std::nullopt;
 }
@@ -398,6 +523,7 @@ void ApiWrap::startExport(
 
 	_settings = std::make_unique<Settings>(settings);
 	_stats = stats;
+	_fileCache->openJournal(_settings->path);
 	_startProcess = std::make_unique<StartProcess>();
 	_startProcess->done = std::move(done);
 
@@ -995,6 +1121,8 @@ void ApiWrap::messagesCountLoaded(int localSplitIndex, int count) {
 void ApiWrap::finishExport(FnMut<void()> done) {
 	const auto guard = gsl::finally([&] { _takeoutId = std::nullopt; });
 
+	_fileCache->removeJournal();
+
 	mainRequest(MTPaccount_FinishTakeoutSession(
 		MTP_flags(MTPaccount_FinishTakeoutSession::Flag::f_success)
 	)).done(std::move(done)).send();
@@ -1009,6 +1137,12 @@ void ApiWrap::cancelExportFast() {
 	}
 }
 
+int ApiWrap::requestsInFlight() const {
+	const auto files = _fileProcess ? int(_fileProcess->requests.size()) : 0;
+	const auto slices = (_chatProcess && _chatProcess->requesting) ? 1 : 0;
+	return files + slices;
+}
+
 void ApiWrap::requestSinglePeerDialog() {
 	const auto isChannelType = [](Data::DialogInfo::Type type) {
 		using Type = Data::DialogInfo::Type;
@@ -1238,13 +1372,16 @@ void ApiWrap::appendChatsSlice(
 
 void ApiWrap::requestMessagesSlice() {
 	Expects(_chatProcess != nullptr);
+	Expects(!_chatProcess->requesting);
+	Expects(!_chatProcess->lastSlice);
 
 	const auto count = _chatProcess->info.messagesCountPerSplit[
 		_chatProcess->localSplitIndex];
 	if (!count) {
-		loadMessagesFiles({});
+		messagesSliceLoaded({}, true);
 		return;
 	}
+	_chatProcess->requesting = true;
 	requestChatMessages(
 		_chatProcess->info.splits[_chatProcess->localSplitIndex],
 		_chatProcess->largestIdPlusOne,
@@ -1253,18 +1390,18 @@ void ApiWrap::requestMessagesSlice() {
 		[=](const MTPmessages_Messages &result) {
 		Expects(_chatProcess != nullptr);
 
+		_chatProcess->requesting = false;
 		result.match([&](const MTPDmessages_messagesNotModified &data) {
 			error("Unexpected messagesNotModified received.");
 		}, [&](const auto &data) {
-			if constexpr (MTPDmessages_messages::Is<decltype(data)>()) {
-				_chatProcess->lastSlice = true;
-			}
-			loadMessagesFiles(Data::ParseMessagesSlice(
+			constexpr auto last = MTPDmessages_messages::Is<
+				decltype(data)>();
+			messagesSliceLoaded(Data::ParseMessagesSlice(
 				_chatProcess->context,
 				data.vmessages,
 				data.vusers,
 				data.vchats,
-				_chatProcess->info.relativePath));
+				_chatProcess->info.relativePath), last);
 		});
 	});
 }
@@ -1333,16 +1470,44 @@ void ApiWrap::requestChatMessages(
 	}
 }
 
-void ApiWrap::loadMessagesFiles(Data::MessagesSlice &&slice) {
+void ApiWrap::messagesSliceLoaded(Data::MessagesSlice &&slice, bool last) {
 	Expects(_chatProcess != nullptr);
-	Expects(!_chatProcess->slice.has_value());
+	Expects(!_chatProcess->nextSlice.has_value());
 
+	if (_chatProcess->stopped) {
+		return;
+	}
 	if (slice.list.empty()) {
-		_chatProcess->lastSlice = true;
+		last = true;
+	} else {
+		_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
 	}
+	if (last) {
+		if (++_chatProcess->localSplitIndex
+			< _chatProcess->info.splits.size()) {
+			_chatProcess->largestIdPlusOne = 1;
+		} else {
+			_chatProcess->lastSlice = true;
+		}
+	}
+	if (_chatProcess->slice) {
+		// Files of the previous slice are still loading.
+		_chatProcess->nextSlice = std::move(slice);
+		return;
+	}
+	loadMessagesFiles(std::move(slice));
+}
+
+void ApiWrap::loadMessagesFiles(Data::MessagesSlice &&slice) {
+	Expects(_chatProcess != nullptr);
+	Expects(!_chatProcess->slice.has_value());
+
 	_chatProcess->slice = std::move(slice);
 	_chatProcess->fileIndex = 0;
 
+	if (!_chatProcess->lastSlice && !_chatProcess->requesting) {
+		requestMessagesSlice();
+	}
 	loadNextMessageFile();
 }
 
@@ -1389,20 +1554,16 @@ void ApiWrap::finishMessagesSlice() {
 
 	auto slice = *base::take(_chatProcess->slice);
 	if (!slice.list.empty()) {
-		_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
 		if (!_chatProcess->handleSlice(std::move(slice))) {
+			_chatProcess->stopped = true;
 			return;
 		}
 	}
-	if (_chatProcess->lastSlice
-		&& (++_chatProcess->localSplitIndex
-			< _chatProcess->info.splits.size())) {
-		_chatProcess->lastSlice = false;
-		_chatProcess->largestIdPlusOne = 1;
-	}
-	if (!_chatProcess->lastSlice) {
-		requestMessagesSlice();
-	} else {
+	if (_chatProcess->nextSlice) {
+		loadMessagesFiles(*base::take(_chatProcess->nextSlice));
+	} else if (!_chatProcess->requesting) {
+		Assert(_chatProcess->lastSlice);
+
 		finishMessages();
 	}
 }
@@ -1458,6 +1619,7 @@ void ApiWrap::loadMessageThumbDone(const QString &relativePath) {
 void ApiWrap::finishMessages() {
 	Expects(_chatProcess != nullptr);
 	Expects(!_chatProcess->slice.has_value());
+	Expects(!_chatProcess->nextSlice.has_value());
 
 	const auto process = base::take(_chatProcess);
 	process->done();
@@ -1523,12 +1685,18 @@ bool ApiWrap::writePreloadedFile(Data::File &file) {
 
 	if (const auto path = _fileCache->find(file.location)) {
 		file.relativePath = *path;
+		if (_stats) {
+			_stats->incrementSavedBytes(file.size);
+		}
 		return true;
 	} else if (!file.content.isEmpty()) {
 		const auto process = prepareFileProcess(file);
 		if (const auto result = process->file.writeBlock(file.content)) {
 			file.relativePath = process->relativePath;
-			_fileCache->save(file.location, file.relativePath);
+			_fileCache->save(
+				file.location,
+				file.relativePath,
+				process->file.size());
 		} else {
 			ioError(result);
 		}
@@ -1579,33 +1747,24 @@ auto ApiWrap::prepareFileProcess(const Data::File &file) const
 }
 
 void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
-		return;
-	}
+	while (_fileProcess
+		&& _fileProcess->requests.size() < kFileRequestsCount
+		&& (_fileProcess->size <= 0
+			|| _fileProcess->offset < _fileProcess->size)) {
+		const auto offset = _fileProcess->offset;
+		_fileProcess->requests.push_back({ offset });
+		_fileProcess->requests.back().id = fileRequest(
+			_fileProcess->location,
+			_fileProcess->offset
+		).done([=](const MTPupload_File &result) {
+			filePartDone(offset, result);
+		}).send();
+		_fileProcess->offset += kFileChunkSize;
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	fileRequest(
-		_fileProcess->location,
-		_fileProcess->offset
-	).done([=](const MTPupload_File &result) {
-		filePartDone(offset, result);
-	}).send();
-	_fileProcess->offset += kFileChunkSize;
-
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
+		// Without the size we don't know where the file ends.
+		if (_fileProcess->size <= 0) {
+			break;
+		}
 	}
 }
 
@@ -1665,7 +1824,10 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 
 	auto process = base::take(_fileProcess);
 	const auto relativePath = process->relativePath;
-	_fileCache->save(process->location, relativePath);
+	_fileCache->save(
+		process->location,
+		relativePath,
+		process->file.size());
 	process->done(process->relativePath);
 }
 
@@ -1675,7 +1837,12 @@ void ApiWrap::filePartUnavailable() {
 
 	LOG(("Export Error: File unavailable."));
 
-	base::take(_fileProcess)->done(QString());
+	// Other parts of this file may be still requested.
+	auto process = base::take(_fileProcess);
+	for (const auto &request : process->requests) {
+		_mtp.request(request.id).cancel();
+	}
+	process->done(QString());
 }
 
 void ApiWrap::error(RPCError &&error) {
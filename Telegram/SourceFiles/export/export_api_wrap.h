@@ -83,6 +83,9 @@ public:
 	void finishExport(FnMut<void()> done);
 	void cancelExportFast();
 
+	// File parts and message slices that are requested right now.
+	int requestsInFlight() const;
+
 	~ApiWrap();
 
 private:
@@ -149,6 +152,7 @@ private:
 		int addOffset,
 		int limit,
 		FnMut<void(MTPmessages_Messages&&)> done);
+	void messagesSliceLoaded(Data::MessagesSlice &&slice, bool last);
 	void loadMessagesFiles(Data::MessagesSlice &&slice);
 	void loadNextMessageFile();
 	bool loadMessageFileProgress(FileProgress value);
@@ -17,6 +17,8 @@ namespace Export {
 namespace {
 
 const auto kNullStateCallback = [](ProcessingState&) {};
+constexpr auto kThroughputWindow = crl::time(5000);
+constexpr auto kThroughputMinDuration = crl::time(1000);
 
 Settings NormalizeSettings(const Settings &settings) {
 	if (!settings.onlySinglePeer()) {
@@ -95,6 +97,8 @@ private:
 		int index,
 		const DownloadProgress &progress) const;
 
+	void fillThroughputState(ProcessingState &result) const;
+
 	int substepsInStep(Step step) const;
 
 	ApiWrap _api;
@@ -110,6 +114,16 @@ private:
 	int _userpicsWritten = 0;
 	int _userpicsCount = 0;
 
+	// Messages and userpics written since the export has started.
+	int _itemsWritten = 0;
+
+	struct ThroughputSample {
+		crl::time time = 0;
+		int64 bytes = 0;
+		int items = 0;
+	};
+	mutable std::deque<ThroughputSample> _throughput;
+
 	// rpl::variable<State> fails to compile in MSVC :(
 	State _state;
 	rpl::event_stream<State> _stateChanges;
@@ -385,6 +399,7 @@ void ControllerObject::exportUserpics() {
 			return false;
 		}
 		_userpicsWritten += slice.list.size();
+		_itemsWritten += slice.list.size();
 		setState(stateUserpics(DownloadProgress()));
 		return true;
 	}, [=] {
@@ -456,6 +471,7 @@ void ControllerObject::exportNextDialog() {
 				return false;
 			}
 			_messagesWritten += result.list.size();
+			_itemsWritten += result.list.size();
 			setState(stateDialogs(DownloadProgress()));
 			return true;
 		}, [=] {
@@ -479,10 +495,12 @@ ProcessingState ControllerObject::prepareState(
 	if (step != _lastProcessingStep) {
 		_substepsPassed += substepsInStep(_lastProcessingStep);
 		_lastProcessingStep = step;
+		_throughput.clear();
 	}
 
 	auto result = ProcessingState();
 	callback(result);
+	fillThroughputState(result);
 	result.step = step;
 	result.substepsPassed = _substepsPassed;
 	result.substepsNow = substepsInStep(_lastProcessingStep);
@@ -571,6 +589,41 @@ void ControllerObject::fillMessagesState(
 	result.bytesCount = progress.total;
 }
 
+void ControllerObject::fillThroughputState(ProcessingState &result) const {
+	const auto now = crl::now();
+	const auto bytes = _stats.bytesCount();
+	if (_throughput.empty() || _throughput.back().time != now) {
+		_throughput.push_back({ now, bytes, _itemsWritten });
+	}
+	while (_throughput.size() > 1
+		&& _throughput[1].time <= now - kThroughputWindow) {
+		_throughput.pop_front();
+	}
+	result.requestsInFlight = _api.requestsInFlight();
+
+	const auto &first = _throughput.front();
+	const auto duration = now - first.time;
+	if (duration < kThroughputMinDuration) {
+		return;
+	}
+	result.bytesPerSecond = (bytes - first.bytes) * 1000 / duration;
+	result.itemsPerSecond = int((_itemsWritten - first.items)
+		* crl::time(1000)
+		/ duration);
+	if (result.itemsPerSecond <= 0) {
+		return;
+	}
+	const auto left = (result.step == Step::Dialogs)
+		? (result.itemCount - result.itemIndex)
+		: (result.step == Step::Userpics)
+		? (result.entityCount - result.entityIndex)
+		: 0;
+	if (left > 0) {
+		result.secondsLeft = (left + result.itemsPerSecond - 1)
+			/ result.itemsPerSecond;
+	}
+}
+
 int ControllerObject::substepsInStep(Step step) const {
 	Expects(_substepsInStep.size() > static_cast<int>(step));
 
@@ -581,7 +634,8 @@ void ControllerObject::setFinishedState() {
 	setState(FinishedState{
 		_writer->mainFilePath(),
 		_stats.filesCount(),
-		_stats.bytesCount() });
+		_stats.bytesCount(),
+		_stats.savedBytesCount() });
 }
 
 Controller::Controller(const MTPInputPeer &peer) : _wrapped(peer) {
@@ -70,6 +70,11 @@ struct ProcessingState {
 	QString bytesName;
 	int bytesLoaded = 0;
 	int bytesCount = 0;
+
+	int64 bytesPerSecond = 0;
+	int itemsPerSecond = 0;
+	int requestsInFlight = 0;
+	int secondsLeft = 0;
 };
 
 struct ApiErrorState {
@@ -87,6 +92,7 @@ struct FinishedState {
 	QString path;
 	int filesCount = 0;
 	int64 bytesCount = 0;
+	int64 savedBytesCount = 0;
 };
 
 using State = base::optional_variant<
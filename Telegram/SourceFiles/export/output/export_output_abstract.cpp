@@ -17,6 +17,36 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 namespace Export {
 namespace Output {
+namespace {
+
+constexpr auto kJournalFileName = ".export_journal";
+
+// Returns the folder of the latest unfinished export, if there is one.
+QString FindUnfinishedExport(
+		const QFileInfoList &list,
+		const QString &prefix) {
+	auto result = QString();
+	auto modified = QDateTime();
+	for (const auto &info : list) {
+		if (!info.isDir() || !info.fileName().startsWith(prefix)) {
+			continue;
+		}
+		const auto folder = info.absoluteFilePath() + '/';
+		const auto journal = QFileInfo(JournalPath(folder));
+		if (journal.exists()
+			&& (result.isEmpty() || journal.lastModified() > modified)) {
+			result = folder;
+			modified = journal.lastModified();
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+QString JournalPath(const QString &folder) {
+	return folder + kJournalFileName;
+}
 
 QString NormalizePath(const Settings &settings) {
 	QDir folder(settings.path);
@@ -29,11 +59,19 @@ QString NormalizePath(const Settings &settings) {
 	const auto list = folder.entryInfoList(mode);
 	if (list.isEmpty() && !settings.forceSubPath) {
 		return result;
+	} else if (QFile::exists(JournalPath(result))) {
+		// Continue the export that was interrupted in this folder.
+		return result;
+	}
+	const auto prefix = QString(settings.onlySinglePeer()
+		? "ChatExport_"
+		: "DataExport_");
+	const auto unfinished = FindUnfinishedExport(list, prefix);
+	if (!unfinished.isEmpty()) {
+		return unfinished;
 	}
 	const auto date = QDate::currentDate();
-	const auto base = QString(settings.onlySinglePeer()
-		? "ChatExport_%1_%2_%3"
-		: "DataExport_%1_%2_%3"
+	const auto base = QString(prefix + "%1_%2_%3"
 	).arg(date.day(), 2, 10, QChar('0')
 	).arg(date.month(), 2, 10, QChar('0')
 	).arg(date.year());
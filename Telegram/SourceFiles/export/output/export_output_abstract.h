@@ -28,6 +28,9 @@ namespace Output {
 
 QString NormalizePath(const Settings &settings);
 
+// Files loaded by an unfinished export are listed there.
+QString JournalPath(const QString &folder);
+
 struct Result;
 class Stats;
 
@@ -376,6 +376,37 @@ struct UserpicData {
 	QByteArray lastName;
 };
 
+// Stickers and userpics are shown by many messages in many chats,
+// their files are the same, so each thumb is resized and saved once.
+class ThumbsCache {
+public:
+	std::pair<QString, QSize> write(
+		const QString &basePath,
+		const QString &largePath,
+		const QByteArray &kind,
+		FnMut<std::pair<QString, QSize>()> generate);
+
+private:
+	using Key = std::tuple<QString, QString, QByteArray>;
+	std::map<Key, std::pair<QString, QSize>> _thumbs;
+
+};
+
+std::pair<QString, QSize> ThumbsCache::write(
+		const QString &basePath,
+		const QString &largePath,
+		const QByteArray &kind,
+		FnMut<std::pair<QString, QSize>()> generate) {
+	if (largePath.isEmpty()) {
+		return {};
+	}
+	const auto key = Key{ basePath, largePath, kind };
+	if (const auto i = _thumbs.find(key); i != end(_thumbs)) {
+		return i->second;
+	}
+	return _thumbs.emplace(key, generate()).first->second;
+}
+
 class PeersMap {
 public:
 	using PeerId = Data::PeerId;
@@ -519,7 +550,11 @@ struct HtmlWriter::MessageInfo {
 
 class HtmlWriter::Wrap {
 public:
-	Wrap(const QString &path, const QString &base, Stats *stats);
+	Wrap(
+		const QString &path,
+		const QString &base,
+		not_null<ThumbsCache*> thumbs,
+		Stats *stats);
 
 	[[nodiscard]] bool empty() const;
 
@@ -625,6 +660,7 @@ private:
 	[[nodiscard]] QByteArray pushPoll(const Data::Poll &data);
 
 	File _file;
+	not_null<ThumbsCache*> _thumbs;
 	QByteArray _composedStart;
 	bool _closed = false;
 	QByteArray _base;
@@ -670,23 +706,30 @@ QByteArray ComposeName(const UserpicData &data, const QByteArray &empty) {
 }
 
 QString WriteUserpicThumb(
+		not_null<details::ThumbsCache*> thumbs,
 		const QString &basePath,
 		const QString &largePath,
 		const UserpicData &userpic,
 		const QString &postfix = "_thumb") {
-	return Data::WriteImageThumb(
-		basePath,
-		largePath,
-		userpic.pixelSize * 2,
-		userpic.pixelSize * 2,
-		postfix);
+	const auto kind = postfix.toUtf8()
+		+ Data::NumberToString(userpic.pixelSize);
+	return thumbs->write(basePath, largePath, kind, [&] {
+		return std::make_pair(Data::WriteImageThumb(
+			basePath,
+			largePath,
+			userpic.pixelSize * 2,
+			userpic.pixelSize * 2,
+			postfix), QSize());
+	}).first;
 }
 
 HtmlWriter::Wrap::Wrap(
 	const QString &path,
 	const QString &base,
+	not_null<ThumbsCache*> thumbs,
 	Stats *stats)
-: _file(path, stats) {
+: _file(path, stats)
+, _thumbs(thumbs) {
 	Expects(base.endsWith('/'));
 	Expects(path.startsWith(base));
 
@@ -936,6 +979,7 @@ QByteArray HtmlWriter::Wrap::pushServiceMessage(
 		userpic.pixelSize = kServiceMessagePhotoSize;
 		userpic.largeLink = photo->image.file.relativePath;
 		userpic.imageLink = WriteUserpicThumb(
+			_thumbs,
 			basePath,
 			userpic.largeLink,
 			userpic);
@@ -1322,16 +1366,22 @@ QByteArray HtmlWriter::Wrap::pushStickerMedia(
 		const QString &basePath) {
 	using namespace Data;
 
-	const auto [thumb, size] = WriteImageThumb(
+	const auto [thumb, size] = _thumbs->write(
 		basePath,
 		data.file.relativePath,
-		CalculateThumbSize(
-			kStickerMaxWidth,
-			kStickerMaxHeight,
-			kStickerMinWidth,
-			kStickerMinHeight),
-		"PNG",
-		-1);
+		"sticker",
+		[&] {
+			return WriteImageThumb(
+				basePath,
+				data.file.relativePath,
+				CalculateThumbSize(
+					kStickerMaxWidth,
+					kStickerMaxHeight,
+					kStickerMinWidth,
+					kStickerMinHeight),
+				"PNG",
+				-1);
+		});
 	if (thumb.isEmpty()) {
 		auto generic = MediaData();
 		generic.title = "Sticker";
@@ -1489,14 +1539,20 @@ QByteArray HtmlWriter::Wrap::pushPhotoMedia(
 		const QString &basePath) {
 	using namespace Data;
 
-	const auto [thumb, size] = WriteImageThumb(
+	const auto [thumb, size] = _thumbs->write(
 		basePath,
 		data.image.file.relativePath,
-		CalculateThumbSize(
-			kPhotoMaxWidth,
-			kPhotoMaxHeight,
-			kPhotoMinWidth,
-			kPhotoMinHeight));
+		"photo",
+		[&] {
+			return WriteImageThumb(
+				basePath,
+				data.image.file.relativePath,
+				CalculateThumbSize(
+					kPhotoMaxWidth,
+					kPhotoMaxHeight,
+					kPhotoMinWidth,
+					kPhotoMinHeight));
+		});
 	if (thumb.isEmpty()) {
 		auto generic = MediaData();
 		generic.title = "Photo";
@@ -1821,7 +1877,9 @@ HtmlWriter::Wrap::~Wrap() {
 	(void)close();
 }
 
-HtmlWriter::HtmlWriter() = default;
+HtmlWriter::HtmlWriter()
+: _thumbs(std::make_unique<ThumbsCache>()) {
+}
 
 Result HtmlWriter::start(
 		const Settings &settings,
@@ -1929,6 +1987,7 @@ Result HtmlWriter::writePreparedPersonal(
 		? QString()
 		: userpicsFilePath();
 	userpic.imageLink = WriteUserpicThumb(
+		_thumbs.get(),
 		_settings.path,
 		userpicPath,
 		userpic,
@@ -2029,7 +2088,11 @@ Result HtmlWriter::writeUserpicsSlice(const Data::UserpicsSlice &data) {
 			Unexpected("Skip reason while writing photo path.");
 		}();
 		const auto &path = userpic.image.file.relativePath;
-		data.imageLink = WriteUserpicThumb(_settings.path, path, data);
+		data.imageLink = WriteUserpicThumb(
+			_thumbs.get(),
+			_settings.path,
+			path,
+			data);
 		data.firstName = path.toUtf8();
 		block.append(_userpics->pushListEntry(
 			data,
@@ -2721,6 +2784,7 @@ std::unique_ptr<HtmlWriter::Wrap> HtmlWriter::fileWithRelativePath(
 	return std::make_unique<Wrap>(
 		pathWithRelativePath(path),
 		_settings.path,
+		_thumbs.get(),
 		_stats);
 }
 
@@ -36,6 +36,7 @@ private:
 struct UserpicData;
 class PeersMap;
 struct MediaData;
+class ThumbsCache;
 
 } // namespace details
 
@@ -80,6 +81,7 @@ private:
 	using Context = details::HtmlContext;
 	using UserpicData = details::UserpicData;
 	using MediaData = details::MediaData;
+	using ThumbsCache = details::ThumbsCache;
 	class Wrap;
 	struct MessageInfo;
 	enum class DialogsMode {
@@ -134,6 +136,7 @@ private:
 	Settings _settings;
 	Environment _environment;
 	Stats *_stats = nullptr;
+	std::unique_ptr<ThumbsCache> _thumbs;
 
 	struct SavedSection;
 	std::vector<SavedSection> _savedSections;
@@ -16,21 +16,70 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonValue>
 
+#if defined ARCH_CPU_X86_64 || defined __SSE2__ || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define TDESKTOP_EXPORT_JSON_SSE2
+#include <emmintrin.h>
+#endif // ARCH_CPU_X86_64 || __SSE2__ || _M_IX86_FP >= 2
+
 namespace Export {
 namespace Output {
 namespace {
 
 using Context = details::JsonContext;
 
+inline bool IsSpecialChar(char ch) {
+	return (ch >= 0 && ch < 32)
+		|| (ch == '"')
+		|| (ch == '\\')
+		|| (ch == char(0xE2)); // Start of line and paragraph separators.
+}
+
+// Returns the first char that may need escaping, or till.
+const char *SkipPlainChars(const char *from, const char *till) {
+#ifdef TDESKTOP_EXPORT_JSON_SSE2
+	const auto low = _mm_set1_epi8(31);
+	const auto quote = _mm_set1_epi8('"');
+	const auto backslash = _mm_set1_epi8('\\');
+	const auto separator = _mm_set1_epi8(char(0xE2));
+	while (till - from >= 16) {
+		const auto bytes = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(from));
+		const auto special = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(_mm_max_epu8(bytes, low), low),
+				_mm_cmpeq_epi8(bytes, quote)),
+			_mm_or_si128(
+				_mm_cmpeq_epi8(bytes, backslash),
+				_mm_cmpeq_epi8(bytes, separator)));
+		if (_mm_movemask_epi8(special)) {
+			break;
+		}
+		from += 16;
+	}
+#endif // TDESKTOP_EXPORT_JSON_SSE2
+	while (from != till && !IsSpecialChar(*from)) {
+		++from;
+	}
+	return from;
+}
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
 	auto result = QByteArray();
-	result.reserve(2 + size * 4);
+	result.reserve(2 + size);
 	result.append('"');
 	for (auto p = begin; p != end; ++p) {
+		// Most of the text doesn't need escaping, copy it in bulk.
+		const auto plain = SkipPlainChars(p, end);
+		result.append(p, plain - p);
+		if (plain == end) {
+			break;
+		}
+		p = plain;
+
 		const auto ch = *p;
 		if (ch == '\n') {
 			result.append("\\n", 2);
@@ -55,8 +104,10 @@ QByteArray SerializeString(const QByteArray &value) {
 			&& *(p + 1) == char(0x80)) {
 			if (*(p + 2) == char(0xA8)) { // Line separator.
 				result.append("\\u2028", 6);
+				p += 2;
 			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
 				result.append("\\u2029", 6);
+				p += 2;
 			} else {
 				result.append(ch);
 			}
@@ -98,8 +149,16 @@ QByteArray SerializeObject(
 	const auto guard = gsl::finally([&] { context.nesting.pop_back(); });
 	const auto next = '\n' + Indentation(context);
 
+	auto size = 2 + indent.size() + 1;
+	for (const auto &[key, value] : values) {
+		if (!value.isEmpty()) {
+			size += 1 + next.size() + key.size() + 4 + value.size();
+		}
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('{');
 	for (const auto &[key, value] : values) {
 		if (value.isEmpty()) {
@@ -123,8 +182,14 @@ QByteArray SerializeArray(
 	const auto indent = Indentation(context.nesting.size());
 	const auto next = '\n' + Indentation(context.nesting.size() + 1);
 
+	auto size = 2 + indent.size() + 1;
+	for (const auto &value : values) {
+		size += 1 + next.size() + value.size();
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('[');
 	for (const auto &value : values) {
 		if (first) {
@@ -11,7 +11,8 @@ namespace Output {
 
 Stats::Stats(const Stats &other)
 : _files(other._files.load())
-, _bytes(other._bytes.load()) {
+, _bytes(other._bytes.load())
+, _savedBytes(other._savedBytes.load()) {
 }
 
 void Stats::incrementFiles() {
@@ -22,6 +23,10 @@ void Stats::incrementBytes(int count) {
 	_bytes += count;
 }
 
+void Stats::incrementSavedBytes(int count) {
+	_savedBytes += count;
+}
+
 int Stats::filesCount() const {
 	return _files;
 }
@@ -30,5 +35,9 @@ int64 Stats::bytesCount() const {
 	return _bytes;
 }
 
+int64 Stats::savedBytesCount() const {
+	return _savedBytes;
+}
+
 } // namespace Output
 } // namespace Export
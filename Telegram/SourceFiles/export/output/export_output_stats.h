@@ -19,12 +19,17 @@ public:
 	void incrementFiles();
 	void incrementBytes(int count);
 
+	// Files already written for other messages are not loaded again.
+	void incrementSavedBytes(int count);
+
 	int filesCount() const;
 	int64 bytesCount() const;
+	int64 savedBytesCount() const;
 
 private:
 	std::atomic<int> _files;
 	std::atomic<int64> _bytes;
+	std::atomic<int64> _savedBytes;
 
 };
 
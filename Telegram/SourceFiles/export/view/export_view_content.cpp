@@ -11,6 +11,33 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 namespace Export {
 namespace View {
+namespace {
+
+void pushThroughput(const ProcessingState &state, Content &content) {
+	if (!state.bytesPerSecond && !state.itemsPerSecond) {
+		content.rows.push_back(Content::Row());
+		return;
+	}
+	const auto label = lng_export_state_speed(
+		lt_size,
+		formatSizeText(state.bytesPerSecond),
+		lt_count,
+		QString::number(state.itemsPerSecond));
+	auto info = (state.requestsInFlight > 0)
+		? lng_export_state_requests(
+			lt_count,
+			QString::number(state.requestsInFlight))
+		: QString();
+	if (state.secondsLeft > 0) {
+		const auto left = lng_export_state_left(
+			lt_duration,
+			formatDurationWords(state.secondsLeft));
+		info = info.isEmpty() ? left : (info + ", " + left);
+	}
+	content.rows.push_back({ "speed", label, info, 0. });
+}
+
+} // namespace
 
 const QString Content::kDoneId = "done";
 
@@ -116,6 +143,7 @@ Content ContentFromState(const ProcessingState &state) {
 	while (result.rows.size() < 3) {
 		result.rows.push_back(Content::Row());
 	}
+	pushThroughput(state, result);
 	return result;
 }
 
@@ -136,6 +164,15 @@ Content ContentFromState(const FinishedState &state) {
 		lng_export_total_size(lt_size, formatSizeText(state.bytesCount)),
 		QString(),
 		1. });
+	if (state.savedBytesCount > 0) {
+		result.rows.push_back({
+			Content::kDoneId,
+			lng_export_saved_size(
+				lt_size,
+				formatSizeText(state.savedBytesCount)),
+			QString(),
+			1. });
+	}
 	return result;
 }
 
@@ -371,8 +371,8 @@ void InnerWidget::applyFilter(FilterValue &&value) {
 
 void InnerWidget::applySearch(const QString &query) {
 	auto clearQuery = query.trimmed();
-	if (_searchQuery != query) {
-		_searchQuery = query;
+	if (_searchQuery != clearQuery) {
+		_searchQuery = clearQuery;
 		clearAndRequestLog();
 	}
 }
@@ -57,6 +57,7 @@ constexpr auto kStatusShowClientsideChooseContact = 6000;
 constexpr auto kStatusShowClientsidePlayGame = 10000;
 constexpr auto kSetMyActionForMs = 10000;
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kExactLayoutBlocksAround = 4;
 constexpr auto kSkipCloudDraftsFor = TimeId(3);
 
 } // namespace
@@ -544,12 +545,14 @@ std::vector<not_null<HistoryItem*>> History::createItems(
 		const QVector<MTPMessage> &data) {
 	auto result = std::vector<not_null<HistoryItem*>>();
 	result.reserve(data.size());
+	owner().groups().startBatch();
 	for (auto i = data.cend(), e = data.cbegin(); i != e;) {
 		const auto detachExistingItem = true;
 		if (const auto item = createItem(*--i, detachExistingItem)) {
 			result.push_back(item);
 		}
 	}
+	owner().groups().finishBatch();
 	return result;
 }
 
@@ -2585,14 +2588,52 @@ void History::resizeToWidth(int newWidth) {
 	_flags &= ~(Flag::f_has_pending_resized_items);
 
 	_width = newWidth;
+	const auto lazy = resizeAllItems
+		&& (int(blocks.size()) > 2 * kExactLayoutBlocksAround + 1);
 	int y = 0;
 	for (const auto &block : blocks) {
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, resizeAllItems);
+		const auto estimate = !exactLayoutNear(block->indexInHistory())
+			&& (lazy || block->heightsEstimated());
+		if (estimate) {
+			// Only the items without any layout yet are resized here.
+			block->setHeightsEstimated(true);
+			y += block->resizeGetHeight(newWidth, false);
+		} else {
+			const auto resizeBlockItems = resizeAllItems
+				|| block->heightsEstimated();
+			block->setHeightsEstimated(false);
+			y += block->resizeGetHeight(newWidth, resizeBlockItems);
+		}
 	}
 	_height = y;
 }
 
+int History::exactLayoutAnchor() const {
+	return (scrollTopItem && scrollTopItem->block())
+		? scrollTopItem->block()->indexInHistory()
+		: (int(blocks.size()) - 1);
+}
+
+bool History::exactLayoutNear(int blockIndex) const {
+	return std::abs(blockIndex - exactLayoutAnchor())
+		<= kExactLayoutBlocksAround;
+}
+
+bool History::hasEstimatedHeightsNearScrollTop() const {
+	const auto anchor = exactLayoutAnchor();
+	const auto from = std::max(anchor - kExactLayoutBlocksAround, 0);
+	const auto till = std::min(
+		anchor + kExactLayoutBlocksAround + 1,
+		int(blocks.size()));
+	for (auto i = from; i < till; ++i) {
+		if (blocks[i]->heightsEstimated()) {
+			return true;
+		}
+	}
+	return false;
+}
+
 PeerId History::peerId() const {
 	return peer->id;
 }
@@ -201,8 +201,12 @@ public:
 	MsgId msgIdForRead() const;
 	HistoryItem *lastSentMessage() const;
 
+	// With many loaded blocks a width change lays out exactly only the
+	// blocks around the scroll position, others keep their old heights
+	// until they get close to it.
 	void resizeToWidth(int newWidth);
 	int height() const;
+	bool hasEstimatedHeightsNearScrollTop() const;
 
 	void itemRemoved(not_null<HistoryItem*> item);
 	void itemVanished(not_null<HistoryItem*> item);
@@ -364,6 +368,9 @@ private:
 	// helper method for countScrollState(int top)
 	void countScrollTopItem(int top);
 
+	int exactLayoutAnchor() const;
+	bool exactLayoutNear(int blockIndex) const;
+
 	HistoryItem *addNewToLastBlock(const MTPMessage &msg, NewMessageType type);
 
 	// this method just removes a block from the blocks list
@@ -520,6 +527,12 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, bool resizeAllItems);
+	bool heightsEstimated() const {
+		return _heightsEstimated;
+	}
+	void setHeightsEstimated(bool estimated) {
+		_heightsEstimated = estimated;
+	}
 	int y() const {
 		return _y;
 	}
@@ -564,5 +577,6 @@ protected:
 	int _y = 0;
 	int _height = 0;
 	int _indexInHistory = -1;
+	bool _heightsEstimated = false;
 
 };
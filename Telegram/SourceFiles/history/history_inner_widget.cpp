@@ -1895,7 +1895,14 @@ TextWithEntities HistoryInner::getSelectedText() const {
 	const auto timeFormat = qsl(", [dd.MM.yy hh:mm]\n");
 	auto groups = base::flat_set<not_null<const Data::Group*>>();
 	auto fullSize = 0;
-	auto texts = base::flat_map<Data::MessagePosition, TextWithEntities>();
+	auto entitiesCount = 0;
+
+	// Collect unsorted and sort once, inserting into a flat_map in the
+	// selection order was quadratic for thousands of selected messages.
+	auto texts = std::vector<std::pair<
+		Data::MessagePosition,
+		TextWithEntities>>();
+	texts.reserve(selected.size());
 
 	const auto wrapItem = [&](
 			not_null<HistoryItem*> item,
@@ -1907,8 +1914,9 @@ TextWithEntities HistoryInner::getSelectedText() const {
 			+ unwrapped.text.size();
 		part.text.reserve(size);
 		part.text.append(item->author()->name).append(time);
+		entitiesCount += unwrapped.entities.size();
 		TextUtilities::Append(part, std::move(unwrapped));
-		texts.emplace(item->position(), part);
+		texts.emplace_back(item->position(), std::move(part));
 		fullSize += size;
 	};
 	const auto addItem = [&](not_null<HistoryItem*> item) {
@@ -1936,9 +1944,14 @@ TextWithEntities HistoryInner::getSelectedText() const {
 		}
 	}
 
+	ranges::sort(texts, std::less<>(), [](const auto &pair) {
+		return pair.first;
+	});
+
 	auto result = TextWithEntities();
 	auto sep = qsl("\n\n");
 	result.text.reserve(fullSize + (texts.size() - 1) * sep.size());
+	result.entities.reserve(entitiesCount);
 	for (auto i = texts.begin(), e = texts.end(); i != e;) {
 		TextUtilities::Append(result, std::move(i->second));
 		if (++i != e) {
@@ -2122,6 +2135,18 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 			}
 		}
 	}
+
+	// Blocks with estimated heights came close, lay them out exactly
+	// keeping the new scroll top item in place.
+	const auto validateHeights = [&](History *history) {
+		if (history && history->hasEstimatedHeightsNearScrollTop()) {
+			history->setHasPendingResizedItems();
+			_widget->update();
+		}
+	};
+	validateHeights(_history);
+	validateHeights(_migrated);
+
 	if (scrolledUp) {
 		_scrollDateCheck.call();
 	} else {
@@ -149,6 +149,13 @@ MediaCheckResult CheckMessageMedia(const MTPMessageMedia &media) {
 
 } // namespace
 
+struct HistoryItem::ChatListText {
+	Text text = { st::dialogsTextWidthMin };
+	DrawInDialog way = DrawInDialog::Normal;
+	PeerData *sender = nullptr;
+	int senderNameVersion = 0;
+};
+
 void HistoryItem::HistoryItem::Destroyer::operator()(HistoryItem *value) {
 	if (value) {
 		value->destroy();
@@ -217,23 +224,22 @@ ReplyKeyboard *HistoryItem::inlineReplyKeyboard() {
 }
 
 void HistoryItem::invalidateChatListEntry() {
+	invalidateChatListText();
 	if (const auto main = App::main()) {
 		// #TODO feeds search results
 		main->repaintDialogRow({ history(), fullId() });
 	}
-
-	// invalidate cache for drawInDialog
-	if (history()->textCachedFor == this) {
-		history()->textCachedFor = nullptr;
-	}
 	if (const auto feed = history()->peer->feed()) {
-		if (feed->textCachedFor == this) {
-			feed->textCachedFor = nullptr;
+		if (feed->chatListMessage() == this) {
 			feed->updateChatListEntry();
 		}
 	}
 }
 
+void HistoryItem::invalidateChatListText() {
+	_chatListText = nullptr;
+}
+
 void HistoryItem::finishEditionToEmpty() {
 	finishEdition(-1);
 	_history->itemVanished(this);
@@ -724,17 +730,7 @@ QString HistoryItem::inDialogsText(DrawInDialog way) const {
 		return QString();
 	};
 	const auto plainText = getText();
-	const auto sender = [&]() -> PeerData* {
-		if (isPost() || isEmpty() || (way == DrawInDialog::WithoutSender)) {
-			return nullptr;
-		} else if (!_history->peer->isUser() || out()) {
-			return author();
-		} else if (_history->peer->isSelf() && !Has<HistoryMessageForwarded>()) {
-			return senderOriginal();
-		}
-		return nullptr;
-	}();
-	if (sender) {
+	if (const auto sender = inDialogsSender(way)) {
 		auto fromText = sender->isSelf() ? lang(lng_from_you) : sender->shortName();
 		auto fromWrapped = textcmdLink(1, lng_dialogs_text_from_wrapped(lt_from, TextUtilities::Clean(fromText)));
 		return lng_dialogs_text_with_from(lt_from_part, fromWrapped, lt_message, plainText);
@@ -742,23 +738,45 @@ QString HistoryItem::inDialogsText(DrawInDialog way) const {
 	return plainText;
 }
 
+PeerData *HistoryItem::inDialogsSender(DrawInDialog way) const {
+	if (isPost() || isEmpty() || (way == DrawInDialog::WithoutSender)) {
+		return nullptr;
+	} else if (!_history->peer->isUser() || out()) {
+		return author();
+	} else if (_history->peer->isSelf() && !Has<HistoryMessageForwarded>()) {
+		return senderOriginal();
+	}
+	return nullptr;
+}
+
 void HistoryItem::drawInDialog(
 		Painter &p,
 		const QRect &r,
 		bool active,
 		bool selected,
-		DrawInDialog way,
-		const HistoryItem *&cacheFor,
-		Text &cache) const {
-	if (cacheFor != this) {
-		cacheFor = this;
-		cache.setText(st::dialogsTextStyle, inDialogsText(way), Ui::DialogTextOptions());
+		DrawInDialog way) const {
+	const auto sender = inDialogsSender(way);
+	const auto senderNameVersion = sender ? sender->nameVersion : 0;
+	if (!_chatListText
+		|| _chatListText->way != way
+		|| _chatListText->sender != sender
+		|| _chatListText->senderNameVersion != senderNameVersion) {
+		if (!_chatListText) {
+			_chatListText = std::make_unique<ChatListText>();
+		}
+		_chatListText->way = way;
+		_chatListText->sender = sender;
+		_chatListText->senderNameVersion = senderNameVersion;
+		_chatListText->text.setText(
+			st::dialogsTextStyle,
+			inDialogsText(way),
+			Ui::DialogTextOptions());
 	}
 	if (r.width()) {
 		p.setTextPalette(active ? st::dialogsTextPaletteActive : (selected ? st::dialogsTextPaletteOver : st::dialogsTextPalette));
 		p.setFont(st::dialogsTextFont);
 		p.setPen(active ? st::dialogsTextFgActive : (selected ? st::dialogsTextFgOver : st::dialogsTextFg));
-		cache.drawElided(p, r.left(), r.top(), r.width(), r.height() / st::dialogsTextFont->height);
+		_chatListText->text.drawElided(p, r.left(), r.top(), r.width(), r.height() / st::dialogsTextFont->height);
 		p.restoreTextPalette();
 	}
 }
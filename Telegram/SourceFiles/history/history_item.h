@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "base/runtime_composer.h"
+#include "base/slab_allocator.h"
 #include "base/flags.h"
 #include "base/value_ordering.h"
 
@@ -55,7 +56,9 @@ class ElementDelegate;
 
 struct HiddenSenderInfo;
 
-class HistoryItem : public RuntimeComposer<HistoryItem> {
+class HistoryItem
+	: public RuntimeComposer<HistoryItem>
+	, public base::slab_allocated {
 public:
 	static not_null<HistoryItem*> Create(
 		not_null<History*> history,
@@ -209,9 +212,7 @@ public:
 		const QRect &r,
 		bool active,
 		bool selected,
-		DrawInDialog way,
-		const HistoryItem *&cacheFor,
-		Text &cache) const;
+		DrawInDialog way) const;
 
 	bool emptyText() const {
 		return _text.isEmpty();
@@ -302,6 +303,7 @@ protected:
 	HistoryMessageReplyMarkup *inlineReplyMarkup();
 	ReplyKeyboard *inlineReplyKeyboard();
 	void invalidateChatListEntry();
+	void invalidateChatListText();
 
 	void setGroupId(MessageGroupId groupId);
 
@@ -312,8 +314,15 @@ protected:
 	std::unique_ptr<Data::Media> _media;
 
 private:
+	struct ChatListText;
+
+	PeerData *inDialogsSender(DrawInDialog way) const;
+
 	TimeId _date = 0;
 
+	// Shared by the chat list, search results and notifications.
+	mutable std::unique_ptr<ChatListText> _chatListText;
+
 	HistoryView::Element *_mainView = nullptr;
 	friend class HistoryView::Element;
 
@@ -16,6 +16,16 @@ namespace {
 
 constexpr auto kCoordPrecision = 8;
 constexpr auto kMaxHttpRedirects = 5;
+constexpr auto kMapTilePixels = 256;
+constexpr auto kQuantizeStepsInPixel = 4;
+
+// Points closer than a fraction of a map pixel at the requested zoom
+// render the same image, so they share one cache key and one request.
+float64 QuantizeCoord(float64 value, int zoom) {
+	const auto pixels = float64(kMapTilePixels << zoom);
+	const auto step = 360. / (pixels * kQuantizeStepsInPixel);
+	return std::round(value / step) * step;
+}
 
 GeoPointLocation ComputeLocation(const LocationCoords &coords) {
 	const auto scale = 1 + (cScale() * cIntRetinaFactor()) / 200;
@@ -24,8 +34,8 @@ GeoPointLocation ComputeLocation(const LocationCoords &coords) {
 	const auto h = st::locationSize.height() / scale;
 
 	auto result = GeoPointLocation();
-	result.lat = coords.lat();
-	result.lon = coords.lon();
+	result.lat = QuantizeCoord(coords.lat(), zoom);
+	result.lon = QuantizeCoord(coords.lon(), zoom);
 	result.access = coords.accessHash();
 	result.width = w;
 	result.height = h;
@@ -744,6 +744,7 @@ void HistoryMessage::refreshMedia(const MTPMessageMedia *media) {
 	if (media) {
 		setMedia(*media);
 	}
+	invalidateChatListText();
 }
 
 void HistoryMessage::refreshSentMedia(const MTPMessageMedia *media) {
@@ -1022,6 +1023,7 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 		}
 		_textWidth = -1;
 		_textHeight = 0;
+		invalidateChatListText();
 	}
 }
 
@@ -1033,6 +1035,7 @@ void HistoryMessage::setEmptyText() {
 
 	_textWidth = -1;
 	_textHeight = 0;
+	invalidateChatListText();
 }
 
 void HistoryMessage::setReplyMarkup(const MTPReplyMarkup *markup) {
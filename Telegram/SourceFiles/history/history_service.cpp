@@ -574,6 +574,7 @@ void HistoryService::setServiceText(const PreparedText &prepared) {
 	}
 	_textWidth = -1;
 	_textHeight = 0;
+	invalidateChatListText();
 }
 
 void HistoryService::markMediaAsReadHook() {
@@ -718,19 +719,7 @@ void HistoryService::updateDependentText() {
 
 	setServiceText(text);
 	history()->owner().requestItemResize(this);
-	if (history()->textCachedFor == this) {
-		history()->textCachedFor = nullptr;
-	}
-	if (const auto feed = history()->peer->feed()) {
-		if (feed->textCachedFor == this) {
-			feed->textCachedFor = nullptr;
-			feed->updateChatListEntry();
-		}
-	}
-	if (const auto main = App::main()) {
-		// #TODO feeds search results
-		main->repaintDialogRow({ history(), fullId() });
-	}
+	invalidateChatListEntry();
 	App::historyUpdateDependent(this);
 }
 
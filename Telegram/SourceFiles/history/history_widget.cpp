@@ -108,6 +108,7 @@ constexpr auto kCancelTypingActionTimeout = crl::time(5000);
 constexpr auto kSaveDraftTimeout = 1000;
 constexpr auto kSaveDraftAnywayTimeout = 5000;
 constexpr auto kSaveCloudDraftIdleTimeout = 14000;
+constexpr auto kPreviewEmptyCacheTimeout = 10 * 60 * crl::time(1000);
 
 ApiWrap::RequestMessageDataCallback replyEditMessageDataCallback() {
 	return [](ChannelData *channel, MsgId msgId) {
@@ -1612,7 +1613,6 @@ void HistoryWidget::showHistory(
 	_replyEditMsg = nullptr;
 	_editMsgId = _replyToId = 0;
 	_previewData = nullptr;
-	_previewCache.clear();
 	_fieldBarCancel->hide();
 
 	_membersDropdownShowTimer.stop();
@@ -1818,6 +1818,7 @@ bool HistoryWidget::contentOverlapped(const QRect &globalRect) {
 }
 
 void HistoryWidget::updateReportSpamStatus() {
+	Local::readReportSpamStatuses();
 	if (!_peer
 		|| (_peer->id == Auth().userPeerId())
 		|| _peer->isServiceUser()
@@ -4297,6 +4298,9 @@ void HistoryWidget::subscribeToUploader() {
 
 void HistoryWidget::sendFileConfirmed(
 		const std::shared_ptr<FileLoadResult> &file) {
+	if (sendFileWithoutUpload(file)) {
+		return;
+	}
 	const auto channelId = peerToChannel(file->to.peer);
 	const auto lastKeyboardUsed = lastForceReplyReplied(FullMsgId(
 		channelId,
@@ -4415,6 +4419,15 @@ void HistoryWidget::sendFileConfirmed(
 				MTP_string(messagePostAuthor),
 				MTP_long(groupId)),
 			NewMessageUnread);
+		if (!file->contentHash.isEmpty()) {
+			const auto item = App::histItemById(newId);
+			const auto media = item ? item->media() : nullptr;
+			if (const auto document = media ? media->document() : nullptr) {
+				Auth().api().rememberSentDocument(
+					file->contentHash,
+					document);
+			}
+		}
 	} else if (file->type == SendMediaType::Audio) {
 		if (!peer->isChannel() || peer->isMegagroup()) {
 			flags |= MTPDmessage::Flag::f_media_unread;
@@ -4454,6 +4467,42 @@ void HistoryWidget::sendFileConfirmed(
 	App::main()->dialogsToUp();
 }
 
+bool HistoryWidget::sendFileWithoutUpload(
+		const std::shared_ptr<FileLoadResult> &file) {
+	if (file->type != SendMediaType::File || file->contentHash.isEmpty()) {
+		return false;
+	}
+	const auto history = Auth().data().history(file->to.peer);
+
+	auto options = ApiWrap::SendOptions(history);
+	options.clearDraft = false;
+	options.replyTo = file->to.replyTo;
+	options.generateLocal = true;
+
+	auto caption = TextWithEntities{
+		file->caption.text,
+		ConvertTextTagsToEntities(file->caption.tags)
+	};
+	const auto prepareFlags = Ui::ItemTextOptions(
+		history,
+		Auth().user()).flags;
+	TextUtilities::PrepareForSending(caption, prepareFlags);
+	TextUtilities::Trim(caption);
+
+	if (!Auth().api().sendExistingDocumentByHash(
+			file->contentHash,
+			std::move(caption),
+			options)) {
+		return false;
+	}
+	Auth().data().sendHistoryChangeNotifications();
+	if (_peer && file->to.peer == _peer->id) {
+		App::main()->historyToDown(_history);
+	}
+	App::main()->dialogsToUp();
+	return true;
+}
+
 void HistoryWidget::photoUploaded(
 		const FullMsgId &newId,
 		bool silent,
@@ -4548,6 +4597,7 @@ void HistoryWidget::reportSpamDone(PeerData *peer, const MTPBool &result, mtpReq
 	if (req == _reportSpamRequest) {
 		_reportSpamRequest = 0;
 	}
+	Local::readReportSpamStatuses();
 	cRefReportSpamStatuses().insert(peer->id, dbiprsReportSent);
 	Local::writeReportSpamStatuses();
 	if (_peer == peer) {
@@ -4569,6 +4619,7 @@ bool HistoryWidget::reportSpamFail(const RPCError &error, mtpRequestId req) {
 
 void HistoryWidget::onReportSpamHide() {
 	if (_peer) {
+		Local::readReportSpamStatuses();
 		cRefReportSpamStatuses().insert(_peer->id, dbiprsHidden);
 		Local::writeReportSpamStatuses();
 
@@ -5976,16 +6027,23 @@ void HistoryWidget::checkPreview() {
 				previewCancel();
 			}
 		} else {
-			const auto i = _previewCache.constFind(_previewLinks);
-			if (i == _previewCache.cend()) {
+			auto i = _previewCache.find(_previewLinks);
+			if (i != _previewCache.end()
+				&& !i->second.id
+				&& (crl::now() - i->second.received
+					>= kPreviewEmptyCacheTimeout)) {
+				_previewCache.erase(i);
+				i = _previewCache.end();
+			}
+			if (i == _previewCache.end()) {
 				_previewRequest = MTP::send(
 					MTPmessages_GetWebPagePreview(
 						MTP_flags(0),
 						MTP_string(_previewLinks),
 						MTPnullEntities),
 					rpcDone(&HistoryWidget::gotPreview, _previewLinks));
-			} else if (i.value()) {
-				_previewData = Auth().data().webpage(i.value());
+			} else if (i->second.id) {
+				_previewData = Auth().data().webpage(i->second.id);
 				updatePreview();
 			} else {
 				if (_previewData && _previewData->pendingTill >= 0) previewCancel();
@@ -6015,7 +6073,7 @@ void HistoryWidget::gotPreview(QString links, const MTPMessageMedia &result, mtp
 	if (result.type() == mtpc_messageMediaWebPage) {
 		const auto &data = result.c_messageMediaWebPage().vwebpage;
 		const auto page = Auth().data().processWebpage(data);
-		_previewCache.insert(links, page->id);
+		_previewCache[links] = { page->id, crl::now() };
 		if (page->pendingTill > 0 && page->pendingTill <= unixtime()) {
 			page->pendingTill = -1;
 		}
@@ -6027,7 +6085,7 @@ void HistoryWidget::gotPreview(QString links, const MTPMessageMedia &result, mtp
 		}
 		Auth().data().sendWebPageGamePollNotifications();
 	} else if (result.type() == mtpc_messageMediaEmpty) {
-		_previewCache.insert(links, 0);
+		_previewCache[links] = { WebPageId(0), crl::now() };
 		if (links == _previewLinks && !_previewCancelled) {
 			_previewData = nullptr;
 			updatePreview();
@@ -163,6 +163,7 @@ public:
 	bool confirmSendingFiles(const QStringList &files);
 	bool confirmSendingFiles(not_null<const QMimeData*> data);
 	void sendFileConfirmed(const std::shared_ptr<FileLoadResult> &file);
+	bool sendFileWithoutUpload(const std::shared_ptr<FileLoadResult> &file);
 
 	void updateControlsVisibility();
 	void updateControlsGeometry();
@@ -586,8 +587,11 @@ private:
 	QStringList _parsedLinks;
 	QString _previewLinks;
 	WebPageData *_previewData = nullptr;
-	typedef QMap<QString, WebPageId> PreviewCache;
-	PreviewCache _previewCache;
+	struct PreviewCacheEntry {
+		WebPageId id = 0;
+		crl::time received = 0;
+	};
+	base::flat_map<QString, PreviewCacheEntry> _previewCache;
 	mtpRequestId _previewRequest = 0;
 	Text _previewTitle;
 	Text _previewDescription;
@@ -103,7 +103,8 @@ struct DateBadge : public RuntimeComponent<DateBadge, Element> {
 class Element
 	: public Object
 	, public RuntimeComposer<Element>
-	, public ClickHandlerHost {
+	, public ClickHandlerHost
+	, public base::slab_allocated {
 public:
 	Element(
 		not_null<ElementDelegate*> delegate,
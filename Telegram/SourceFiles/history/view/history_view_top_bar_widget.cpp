@@ -56,8 +56,7 @@ TopBarWidget::TopBarWidget(
 , _search(this, st::topBarSearch)
 , _infoToggle(this, st::topBarInfo)
 , _menuToggle(this, st::topBarMenuToggle)
-, _titlePeerText(st::windowMinWidth / 3)
-, _onlineUpdater([this] { updateOnlineDisplay(); }) {
+, _titlePeerText(st::windowMinWidth / 3) {
 	subscribe(Lang::Current().updated(), [this] { refreshLang(); });
 	setAttribute(Qt::WA_OpaquePaintEvent);
 
@@ -107,6 +106,11 @@ TopBarWidget::TopBarWidget(
 		}
 	}, lifetime());
 
+	Auth().data().onlineTextRefreshes(
+	) | rpl::start_with_next([=] {
+		updateOnlineDisplay();
+	}, lifetime());
+
 	using UpdateFlag = Notify::PeerUpdate::Flag;
 	auto flags = UpdateFlag::UserHasCalls
 		| UpdateFlag::UserOnlineChanged
@@ -834,7 +838,7 @@ void TopBarWidget::updateOnlineDisplayTimer() {
 }
 
 void TopBarWidget::updateOnlineDisplayIn(crl::time timeout) {
-	_onlineUpdater.callOnce(timeout);
+	Auth().data().scheduleOnlineTextRefresh(crl::now() + timeout);
 }
 
 TopBarWidget::~TopBarWidget() = default;
@@ -143,7 +143,6 @@ private:
 	std::unique_ptr<Ui::InfiniteRadialAnimation> _connecting;
 
 	int _unreadCounterSubscription = 0;
-	base::Timer _onlineUpdater;
 
 	rpl::event_stream<> _forwardSelection;
 	rpl::event_stream<> _deleteSelection;
@@ -64,6 +64,7 @@ struct ListWidget::Context {
 	not_null<SelectedMap*> selected;
 	not_null<SelectedMap*> dragSelected;
 	DragSelectAction dragSelectAction;
+	not_null<base::flat_set<not_null<BaseLayout*>>*> heavyLayouts;
 };
 
 class ListWidget::Section {
@@ -398,6 +399,7 @@ void ListWidget::Section::paint(
 				clip.translated(-rect.topLeft()),
 				itemSelection(item, context),
 				&localContext);
+			context.heavyLayouts->emplace(item);
 			p.translate(-rect.topLeft());
 		}
 	}
@@ -608,6 +610,7 @@ void ListWidget::restart() {
 
 	_overLayout = nullptr;
 	_sections.clear();
+	_heavyLayouts.clear();
 	_layouts.clear();
 
 	_universalAroundId = kDefaultAroundId;
@@ -636,6 +639,9 @@ void ListWidget::itemRemoved(not_null<const HistoryItem*> item) {
 			_overLayout = nullptr;
 		}
 
+		if (const auto layout = getExistingLayout(universalId)) {
+			_heavyLayouts.remove(layout);
+		}
 		_layouts.erase(universalId);
 		_dragSelected.remove(universalId);
 
@@ -1016,6 +1022,29 @@ void ListWidget::visibleTopBottomUpdated(
 	_visibleBottom = visibleBottom;
 
 	checkMoveToOtherViewer();
+	clearHeavyItems();
+}
+
+void ListWidget::clearHeavyItems() {
+	const auto visibleHeight = _visibleBottom - _visibleTop;
+	if (visibleHeight <= 0) {
+		return;
+	}
+	const auto above = _visibleTop - visibleHeight;
+	const auto below = _visibleBottom + visibleHeight;
+	for (auto i = _heavyLayouts.begin(); i != _heavyLayouts.end();) {
+		const auto layout = i->get();
+		const auto found = findItemDetails(layout);
+		const auto far = !found
+			|| (found->geometry.y() + found->geometry.height() <= above)
+			|| (found->geometry.y() >= below);
+		if (far) {
+			layout->clearHeavyPart();
+			i = _heavyLayouts.erase(i);
+		} else {
+			++i;
+		}
+	}
 }
 
 void ListWidget::checkMoveToOtherViewer() {
@@ -1129,7 +1158,8 @@ void ListWidget::paintEvent(QPaintEvent *e) {
 		Layout::PaintContext(ms, hasSelectedItems()),
 		&_selected,
 		&_dragSelected,
-		_dragSelectAction
+		_dragSelectAction,
+		&_heavyLayouts
 	};
 	for (auto it = fromSectionIt; it != tillSectionIt; ++it) {
 		auto top = it->top();
@@ -2084,6 +2114,7 @@ void ListWidget::clearStaleLayouts() {
 			if (i->second.item.get() == _overLayout) {
 				_overLayout = nullptr;
 			}
+			_heavyLayouts.remove(i->second.item.get());
 			i = _layouts.erase(i);
 		} else {
 			++i;
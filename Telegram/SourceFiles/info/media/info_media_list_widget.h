@@ -262,6 +262,7 @@ private:
 	void switchToWordSelection();
 	void validateTrippleClickStartTime();
 	void checkMoveToOtherViewer();
+	void clearHeavyItems();
 
 	void setActionBoxWeak(QPointer<Ui::RpWidget> box);
 
@@ -277,6 +278,7 @@ private:
 	SparseIdsMergedSlice _slice;
 
 	std::map<UniversalMsgId, CachedItem> _layouts;
+	base::flat_set<not_null<BaseLayout*>> _heavyLayouts;
 	std::vector<Section> _sections;
 
 	int _visibleTop = 0;
@@ -12,6 +12,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_peer_values.h"
 #include "data/data_channel.h"
 #include "data/data_chat.h"
+#include "data/data_session.h"
 #include "info/profile/info_profile_values.h"
 #include "info/info_controller.h"
 #include "info/info_memento.h"
@@ -230,10 +231,14 @@ Cover::Cover(
 	this,
 	_peer->isMegagroup()
 		? st::infoProfileMegagroupStatusLabel
-		: st::infoProfileStatusLabel)
-, _refreshStatusTimer([this] { refreshStatusText(); }) {
+		: st::infoProfileStatusLabel) {
 	_peer->updateFull();
 
+	_peer->owner().onlineTextRefreshes(
+	) | rpl::start_with_next([=] {
+		refreshStatusText();
+	}, lifetime());
+
 	_name->setSelectable(true);
 	_name->setContextCopyText(lang(lng_profile_copy_fullname));
 
@@ -347,7 +352,8 @@ void Cover::refreshStatusText() {
 			const auto showOnline = Data::OnlineTextActive(user, currentTime);
 			const auto updateIn = Data::OnlineChangeTimeout(user, currentTime);
 			if (showOnline) {
-				_refreshStatusTimer.callOnce(updateIn);
+				_peer->owner().scheduleOnlineTextRefresh(
+					crl::now() + updateIn);
 			}
 			return showOnline
 				? textcmdLink(1, result)
@@ -89,7 +89,6 @@ private:
 	object_ptr<Ui::RpWidget> _verifiedCheck = { nullptr };
 	object_ptr<Ui::FlatLabel> _status = { nullptr };
 	//object_ptr<CoverDropArea> _dropArea = { nullptr };
-	base::Timer _refreshStatusTimer;
 
 	rpl::event_stream<Section> _showSection;
 
@@ -21,6 +21,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_chat.h"
 #include "data/data_user.h"
 #include "data/data_session.h"
+#include "storage/localstorage.h"
 
 #include "boxes/peers/edit_peer_permissions_box.h"
 
@@ -287,7 +288,14 @@ rpl::producer<int> SharedMediaCountValue(
 	) | rpl::map([](const SparseIdsMergedSlice &slice) {
 		return slice.fullCount();
 	}) | rpl::filter_optional();
-	return rpl::single(0) | rpl::then(std::move(updated));
+	const auto cached = Local::ReadSharedMediaCount(peer->id, type);
+	const auto cachedMigrated = migrated
+		? Local::ReadSharedMediaCount(migrated->id, type)
+		: std::make_optional(0);
+	const auto initial = (cached && cachedMigrated)
+		? (*cached + *cachedMigrated)
+		: 0;
+	return rpl::single(initial) | rpl::then(std::move(updated));
 }
 
 rpl::producer<int> CommonGroupsCountValue(not_null<UserData*> user) {
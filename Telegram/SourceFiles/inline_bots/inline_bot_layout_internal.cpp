@@ -137,7 +137,9 @@ void Gif::paint(Painter &p, const QRect &clip, const PaintContext *context) cons
 	document->automaticLoad(fileOrigin(), nullptr);
 
 	bool loaded = document->loaded(), loading = document->loading(), displayLoading = document->displayLoading();
-	if (loaded && !_gif && !_gif.isBad()) {
+	if (loaded && !_gif && !_gif.isBad() && context()->inlineItemsScrolling()) {
+		context()->inlineItemRepaint(this);
+	} else if (loaded && !_gif && !_gif.isBad()) {
 		auto that = const_cast<Gif*>(this);
 		that->_gif = Media::Clip::MakeReader(document, FullMsgId(), [that](Media::Clip::Notification notification) {
 			that->clipCallback(notification);
@@ -1239,7 +1241,9 @@ void Game::paint(Painter &p, const QRect &clip, const PaintContext *context) con
 		document->automaticLoad(fileOrigin(), nullptr);
 
 		bool loaded = document->loaded(), loading = document->loading(), displayLoading = document->displayLoading();
-		if (loaded && !_gif && !_gif.isBad()) {
+		if (loaded && !_gif && !_gif.isBad() && context()->inlineItemsScrolling()) {
+			context()->inlineItemRepaint(this);
+		} else if (loaded && !_gif && !_gif.isBad()) {
 			auto that = const_cast<Game*>(this);
 			that->_gif = Media::Clip::MakeReader(document, FullMsgId(), [that](Media::Clip::Notification notification) {
 				that->clipCallback(notification);
@@ -37,6 +37,10 @@ public:
 	virtual void inlineItemLayoutChanged(const ItemBase *layout) = 0;
 	virtual bool inlineItemVisible(const ItemBase *item) = 0;
 	virtual void inlineItemRepaint(const ItemBase *item) = 0;
+
+	// New animations are not started while scrolling, the repaint
+	// requested by inlineItemRepaint() after the scrolling starts them.
+	virtual bool inlineItemsScrolling() = 0;
 	virtual Data::FileOrigin inlineItemFileOrigin() = 0;
 };
 
@@ -577,6 +577,10 @@ void Inner::inlineItemRepaint(const ItemBase *layout) {
 	}
 }
 
+bool Inner::inlineItemsScrolling() {
+	return (_lastScrolled + 100 > crl::now());
+}
+
 bool Inner::inlineItemVisible(const ItemBase *layout) {
 	int32 position = layout->position();
 	if (position < 0 || !isVisible()) {
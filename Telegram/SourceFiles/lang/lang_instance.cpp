@@ -296,6 +296,7 @@ void Instance::reset(const Language &data) {
 	_customFileContent = QByteArray();
 	_version = 0;
 	_nonDefaultValues.clear();
+	_pendingValues.clear();
 	for (auto i = 0, count = int(_values.size()); i != count; ++i) {
 		_values[i] = GetOriginalValue(LangKey(i));
 	}
@@ -560,7 +561,7 @@ void Instance::fillFromSerialized(
 			continue;
 		}
 
-		applyValue(key, nonDefaultStrings[i + 1]);
+		applyValueLazy(key, nonDefaultStrings[i + 1]);
 	}
 	updatePluralRules();
 }
@@ -764,13 +765,55 @@ void Instance::applyValue(const QByteArray &key, const QByteArray &value) {
 	ParseKeyValue(key, value, [&](LangKey key, QString &&value) {
 		_nonDefaultSet[key] = 1;
 		if (!_derived) {
+			clearPendingValue(key);
 			_values[key] = std::move(value);
 		} else if (!_derived->_nonDefaultSet[key]) {
+			_derived->clearPendingValue(key);
 			_derived->_values[key] = std::move(value);
 		}
 	});
 }
 
+void Instance::applyValueLazy(
+		const QByteArray &key,
+		const QByteArray &value) {
+	_nonDefaultValues[key] = value;
+	const auto index = GetKeyIndex(QLatin1String(key));
+	if (index == kLangKeysCount) {
+		if (!key.startsWith("cloud_")) {
+			DEBUG_LOG(("Lang Warning: Unknown key '%1'"
+				).arg(QString::fromLatin1(key)));
+		}
+		return;
+	}
+	_nonDefaultSet[index] = 1;
+	const auto target = _derived ? _derived : this;
+	if (_derived && _derived->_nonDefaultSet[index]) {
+		return;
+	}
+	if (target->_pendingValues.empty()) {
+		target->_pendingValues.resize(kLangKeysCount);
+	}
+	target->_pendingValues[index] = PendingValue{ key, value };
+}
+
+void Instance::resolvePendingValue(LangKey key) const {
+	Expects(_pendingValues[key].has_value());
+
+	const auto pending = base::take(_pendingValues[key]);
+	ParseKeyValue(pending->key, pending->value, [&](
+			LangKey key,
+			QString &&value) {
+		_values[key] = std::move(value);
+	});
+}
+
+void Instance::clearPendingValue(LangKey key) {
+	if (!_pendingValues.empty()) {
+		_pendingValues[key] = std::nullopt;
+	}
+}
+
 void Instance::updatePluralRules() {
 	if (_pluralId.isEmpty()) {
 		_pluralId = isCustom()
@@ -789,6 +832,7 @@ void Instance::resetValue(const QByteArray &key) {
 	if (keyIndex != kLangKeysCount) {
 		_nonDefaultSet[keyIndex] = 0;
 		if (!_derived) {
+			clearPendingValue(keyIndex);
 			const auto base = _base
 				? _base->getNonDefaultValue(key)
 				: QString();
@@ -796,6 +840,7 @@ void Instance::resetValue(const QByteArray &key) {
 				? base
 				: GetOriginalValue(keyIndex);
 		} else if (!_derived->_nonDefaultSet[keyIndex]) {
+			_derived->clearPendingValue(keyIndex);
 			_derived->_values[keyIndex] = GetOriginalValue(keyIndex);
 		}
 	}
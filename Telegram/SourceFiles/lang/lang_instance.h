@@ -105,6 +105,9 @@ public:
 	QString getValue(LangKey key) const {
 		Expects(key >= 0 && key < _values.size());
 
+		if (!_pendingValues.empty() && _pendingValues[key]) {
+			resolvePendingValue(key);
+		}
 		return _values[key];
 	}
 	QString getNonDefaultValue(const QByteArray &key) const;
@@ -121,10 +124,18 @@ public:
 	}
 
 private:
+	struct PendingValue {
+		QByteArray key;
+		QByteArray value;
+	};
+
 	void setBaseId(const QString &baseId, const QString &pluralId);
 
 	void applyDifferenceToMe(const MTPDlangPackDifference &difference);
 	void applyValue(const QByteArray &key, const QByteArray &value);
+	void applyValueLazy(const QByteArray &key, const QByteArray &value);
+	void resolvePendingValue(LangKey key) const;
+	void clearPendingValue(LangKey key);
 	void resetValue(const QByteArray &key);
 	void reset(const Language &language);
 	void fillFromCustomContent(
@@ -152,8 +163,12 @@ private:
 
 	mutable QString _systemLanguage;
 
-	std::vector<QString> _values;
+	mutable std::vector<QString> _values;
 	std::vector<uchar> _nonDefaultSet;
+
+	// Values read from the local cache are parsed on first access,
+	// most of them are never displayed in a session.
+	mutable std::vector<std::optional<PendingValue>> _pendingValues;
 	std::map<QByteArray, QByteArray> _nonDefaultValues;
 
 	std::unique_ptr<Instance> _base;
@@ -11,6 +11,10 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/crash_reports.h"
 #include "core/launcher.h"
 
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
 enum LogDataType {
 	LogDataMain,
 	LogDataDebug,
@@ -62,6 +66,17 @@ public:
 		}
 	}
 
+	~LogsDataFields() {
+		{
+			std::unique_lock<std::mutex> lock(_debugMutex);
+			_debugFinishing = true;
+		}
+		_debugCondition.notify_one();
+		if (_debugThread.joinable()) {
+			_debugThread.join();
+		}
+	}
+
 	bool openMain() {
 		return reopen(LogDataMain, 0, qsl("start"));
 	}
@@ -92,10 +107,11 @@ public:
 	}
 
 	void write(LogDataType type, const QString &msg) {
-		QMutexLocker lock(_logsMutex(type));
 		if (type != LogDataMain) {
-			reopenDebug();
+			queueDebug(type, msg);
+			return;
 		}
+		QMutexLocker lock(_logsMutex(type));
 		const auto file = files[type].get();
 		if (!file || !file->isOpen()) {
 			return;
@@ -105,10 +121,74 @@ public:
 	}
 
 private:
+	using DebugQueue = std::vector<std::pair<LogDataType, QString>>;
+
 	std::unique_ptr<QFile> files[LogDataCount];
 
 	int32 part = -1;
 
+	// Debug, tcp and mtp logs are written by a separate thread, so that
+	// the connection threads only append a line to the queue.
+	std::mutex _debugMutex;
+	std::condition_variable _debugCondition;
+	DebugQueue _debugQueue;
+	bool _debugFinishing = false;
+	std::thread _debugThread;
+
+	void queueDebug(LogDataType type, const QString &msg) {
+		std::unique_lock<std::mutex> lock(_debugMutex);
+		if (_debugFinishing) {
+			return;
+		} else if (!_debugThread.joinable()) {
+			_debugThread = std::thread([this] { writeDebugLoop(); });
+		}
+		const auto wake = _debugQueue.empty();
+		_debugQueue.emplace_back(type, msg);
+		lock.unlock();
+
+		if (wake) {
+			_debugCondition.notify_one();
+		}
+	}
+
+	void writeDebugLoop() {
+		auto queue = DebugQueue();
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(_debugMutex);
+				_debugCondition.wait(lock, [&] {
+					return _debugFinishing || !_debugQueue.empty();
+				});
+				if (_debugQueue.empty()) {
+					return;
+				}
+				std::swap(queue, _debugQueue);
+			}
+			writeDebugBatch(queue);
+			queue.clear();
+		}
+	}
+
+	void writeDebugBatch(const DebugQueue &queue) {
+		reopenDebug();
+
+		QByteArray batches[LogDataCount];
+		for (const auto &[type, msg] : queue) {
+			batches[type].append(msg.toUtf8());
+		}
+		for (int32 i = 0; i < LogDataCount; ++i) {
+			const auto file = files[i].get();
+			if (i == LogDataMain
+				|| batches[i].isEmpty()
+				|| !file
+				|| !file->isOpen()) {
+				continue;
+			}
+			file->write(batches[i]);
+			file->flush();
+		}
+	}
+
 	bool reopen(LogDataType type, int32 dayIndex, const QString &postfix) {
 		if (files[type] && files[type]->isOpen()) {
 			if (type == LogDataMain) {
@@ -82,6 +82,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/update_checker.h"
 #include "core/shortcuts.h"
 #include "core/application.h"
+#include "core/launcher.h"
 #include "calls/calls_instance.h"
 #include "calls/calls_top_bar.h"
 #include "export/export_settings.h"
@@ -101,6 +102,9 @@ namespace {
 
 constexpr auto kChannelGetDifferenceLimit = 100;
 
+// How many getChannelDifference requests can be sent at the same time.
+constexpr auto kChannelGetDifferenceParallel = std::size_t(8);
+
 // 1s wait after show channel history before sending getChannelDifference.
 constexpr auto kWaitForChannelGetDifference = crl::time(1000);
 
@@ -933,43 +937,64 @@ bool MainWidget::sendMessageFail(const RPCError &error) {
 void MainWidget::cacheBackground() {
 	if (Window::Theme::Background()->colorForFill()) {
 		return;
-	} else if (Window::Theme::Background()->tile()) {
-		auto &bg = Window::Theme::Background()->pixmapForTiled();
-
-		auto result = QImage(_willCacheFor.width() * cIntRetinaFactor(), _willCacheFor.height() * cIntRetinaFactor(), QImage::Format_RGB32);
-        result.setDevicePixelRatio(cRetinaFactor());
-		{
-			QPainter p(&result);
-			auto left = 0;
-			auto top = 0;
-			auto right = _willCacheFor.width();
-			auto bottom = _willCacheFor.height();
-			auto w = bg.width() / cRetinaFactor();
-			auto h = bg.height() / cRetinaFactor();
-			auto sx = 0;
-			auto sy = 0;
-			auto cx = qCeil(_willCacheFor.width() / w);
-			auto cy = qCeil(_willCacheFor.height() / h);
-			for (int i = sx; i < cx; ++i) {
-				for (int j = sy; j < cy; ++j) {
-					p.drawPixmap(QPointF(i * w, j * h), bg);
+	}
+	const auto tile = Window::Theme::Background()->tile();
+	const auto rect = _willCacheFor;
+	const auto generation = _cacheBackgroundGeneration;
+	auto image = (tile
+		? Window::Theme::Background()->pixmapForTiled()
+		: Window::Theme::Background()->pixmap()).toImage();
+
+	// Scaling the full size wallpaper is slow, do it off the main thread.
+	crl::async([=, image = std::move(image)] {
+		auto x = 0;
+		auto y = 0;
+		auto result = QImage();
+		if (tile) {
+			result = QImage(
+				rect.width() * cIntRetinaFactor(),
+				rect.height() * cIntRetinaFactor(),
+				QImage::Format_RGB32);
+			result.setDevicePixelRatio(cRetinaFactor());
+			{
+				QPainter p(&result);
+				const auto w = image.width() / cRetinaFactor();
+				const auto h = image.height() / cRetinaFactor();
+				const auto cx = qCeil(rect.width() / w);
+				const auto cy = qCeil(rect.height() / h);
+				for (auto i = 0; i < cx; ++i) {
+					for (auto j = 0; j < cy; ++j) {
+						p.drawImage(QPointF(i * w, j * h), image);
+					}
 				}
 			}
-		}
-		_cachedX = 0;
-		_cachedY = 0;
-		_cachedBackground = App::pixmapFromImageInPlace(std::move(result));
-	} else {
-		auto &bg = Window::Theme::Background()->pixmap();
-
-		QRect to, from;
-		Window::Theme::ComputeBackgroundRects(_willCacheFor, bg.size(), to, from);
-		_cachedX = to.x();
-		_cachedY = to.y();
-		_cachedBackground = App::pixmapFromImageInPlace(bg.toImage().copy(from).scaled(to.width() * cIntRetinaFactor(), to.height() * cIntRetinaFactor(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-		_cachedBackground.setDevicePixelRatio(cRetinaFactor());
-	}
-	_cachedFor = _willCacheFor;
+		} else {
+			QRect to, from;
+			Window::Theme::ComputeBackgroundRects(
+				rect,
+				image.size(),
+				to,
+				from);
+			x = to.x();
+			y = to.y();
+			result = image.copy(from).scaled(
+				to.width() * cIntRetinaFactor(),
+				to.height() * cIntRetinaFactor(),
+				Qt::IgnoreAspectRatio,
+				Qt::SmoothTransformation);
+		}
+		crl::on_main(this, [=, result = std::move(result)]() mutable {
+			if (generation != _cacheBackgroundGeneration) {
+				return;
+			}
+			_cachedX = x;
+			_cachedY = y;
+			_cachedBackground = App::pixmapFromImageInPlace(
+				std::move(result));
+			_cachedBackground.setDevicePixelRatio(cRetinaFactor());
+			_cachedFor = rect;
+		});
+	});
 }
 
 Dialogs::IndexedList *MainWidget::contactsList() {
@@ -1348,6 +1373,7 @@ bool MainWidget::isIdle() const {
 
 void MainWidget::clearCachedBackground() {
 	_cachedBackground = QPixmap();
+	++_cacheBackgroundGeneration;
 	_cacheBackgroundTimer.cancel();
 	update();
 }
@@ -2907,6 +2933,7 @@ void MainWidget::gotChannelDifference(
 		ChannelData *channel,
 		const MTPupdates_ChannelDifference &diff) {
 	_channelFailDifferenceTimeout.remove(channel);
+	finishChannelDifferenceRequest(channel);
 
 	int32 timeout = 0;
 	bool isFinal = true;
@@ -2970,6 +2997,7 @@ void MainWidget::gotChannelDifference(
 			? (timeout * crl::time(1000))
 			: kWaitForChannelGetDifference);
 	}
+	sendQueuedChannelDifferenceRequests();
 }
 
 void MainWidget::feedChannelDifference(
@@ -2978,13 +3006,17 @@ void MainWidget::feedChannelDifference(
 	session().data().processChats(data.vchats);
 
 	_handlingChannelDifference = true;
+	startUpdatesBatch();
 	feedMessageIds(data.vother_updates);
 	App::feedMsgs(data.vnew_messages, NewMessageUnread);
 	feedUpdateVector(data.vother_updates, true);
+	finishUpdatesBatch();
 	_handlingChannelDifference = false;
 }
 
 bool MainWidget::failChannelDifference(ChannelData *channel, const RPCError &error) {
+	finishChannelDifferenceRequest(channel);
+	sendQueuedChannelDifferenceRequests();
 	if (MTP::isDefaultHandledError(error)) return false;
 
 	LOG(("RPC Error in getChannelDifference: %1 %2: %3").arg(error.code()).arg(error.type()).arg(error.description()));
@@ -3125,9 +3157,21 @@ void MainWidget::feedDifference(
 	session().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
+	startUpdatesBatch();
 	feedMessageIds(other);
 	App::feedMsgs(msgs, NewMessageUnread);
 	feedUpdateVector(other, true);
+	finishUpdatesBatch();
+}
+
+void MainWidget::startUpdatesBatch() {
+	session().data().groups().startBatch();
+	_dialogs->startDialogsBatch();
+}
+
+void MainWidget::finishUpdatesBatch() {
+	_dialogs->finishDialogsBatch();
+	session().data().groups().finishBatch();
 }
 
 bool MainWidget::failDifference(const RPCError &error) {
@@ -3229,7 +3273,20 @@ void MainWidget::getChannelDifference(ChannelData *channel, ChannelDifferenceReq
 		_channelGetDifferenceTimeAfterFail.remove(channel);
 	}
 
+	const auto active = (_controller->activeChatCurrent().peer() == channel);
+	if (!active
+		&& _channelDifferenceRequests.size() >= kChannelGetDifferenceParallel) {
+		queueChannelDifferenceRequest(channel, from);
+		return;
+	}
+	sendChannelDifferenceRequest(channel, from);
+}
+
+void MainWidget::sendChannelDifferenceRequest(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from) {
 	channel->ptsSetRequesting(true);
+	_channelDifferenceRequests.emplace(channel);
 
 	auto filter = MTP_channelMessagesFilterEmpty();
 	auto flags = MTPupdates_GetChannelDifference::Flag::f_force | 0;
@@ -3245,8 +3302,43 @@ void MainWidget::getChannelDifference(ChannelData *channel, ChannelDifferenceReq
 			filter,
 			MTP_int(channel->pts()),
 			MTP_int(kChannelGetDifferenceLimit)),
-		rpcDone(&MainWidget::gotChannelDifference, channel),
-		rpcFail(&MainWidget::failChannelDifference, channel));
+		rpcDone(&MainWidget::gotChannelDifference, channel.get()),
+		rpcFail(&MainWidget::failChannelDifference, channel.get()));
+}
+
+void MainWidget::queueChannelDifferenceRequest(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from) {
+	const auto i = ranges::find(
+		_channelDifferenceQueue,
+		channel,
+		[](const auto &pair) { return pair.first; });
+	if (i != end(_channelDifferenceQueue)) {
+		return;
+	}
+	const auto history = session().data().historyLoaded(channel->id);
+	if (history && history->isPinnedDialog()) {
+		_channelDifferenceQueue.emplace_front(channel, from);
+	} else {
+		_channelDifferenceQueue.emplace_back(channel, from);
+	}
+}
+
+void MainWidget::finishChannelDifferenceRequest(
+		not_null<ChannelData*> channel) {
+	_channelDifferenceRequests.remove(channel);
+}
+
+void MainWidget::sendQueuedChannelDifferenceRequests() {
+	while (!_channelDifferenceQueue.empty()
+		&& _channelDifferenceRequests.size()
+			< kChannelGetDifferenceParallel) {
+		const auto [channel, from] = _channelDifferenceQueue.front();
+		_channelDifferenceQueue.pop_front();
+		if (channel->ptsInited() && !channel->ptsRequesting()) {
+			sendChannelDifferenceRequest(channel, from);
+		}
+	}
 }
 
 void MainWidget::sendPing() {
@@ -3266,11 +3358,6 @@ void MainWidget::start() {
 	update();
 
 	_started = true;
-	Local::readInstalledStickers();
-	Local::readFeaturedStickers();
-	Local::readRecentStickers();
-	Local::readFavedStickers();
-	Local::readSavedGifs();
 	if (const auto availableAt = Local::ReadExportSettings().availableAt) {
 		session().data().suggestStartExport(availableAt);
 	}
@@ -3278,6 +3365,9 @@ void MainWidget::start() {
 	_history->start();
 
 	Core::App().checkStartUrl();
+
+	LOG(("Cold start: main widget started in %1ms."
+		).arg(crl::now() - Core::App().launcher()->launchedAt()));
 }
 
 bool MainWidget::started() {
@@ -3767,7 +3857,9 @@ void MainWidget::feedUpdates(const MTPUpdates &updates, uint64 randomId) {
 
 		session().data().processUsers(d.vusers);
 		session().data().processChats(d.vchats);
+		startUpdatesBatch();
 		feedUpdateVector(d.vupdates);
+		finishUpdatesBatch();
 
 		updSetState(0, d.vdate.v, updQts, d.vseq.v);
 	} break;
@@ -3787,7 +3879,9 @@ void MainWidget::feedUpdates(const MTPUpdates &updates, uint64 randomId) {
 
 		session().data().processUsers(d.vusers);
 		session().data().processChats(d.vchats);
+		startUpdatesBatch();
 		feedUpdateVector(d.vupdates);
+		finishUpdatesBatch();
 
 		updSetState(0, d.vdate.v, updQts, d.vseq.v);
 	} break;
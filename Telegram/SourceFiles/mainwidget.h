@@ -163,7 +163,6 @@ public:
 	bool onSendSticker(DocumentData *sticker);
 
 	void destroyData();
-	void updateOnlineDisplayIn(int32 msecs);
 
 	bool isActive() const;
 	bool doWeReadServerHistory() const;
@@ -389,8 +388,20 @@ private:
 	void saveSectionInStack();
 
 	void getChannelDifference(ChannelData *channel, ChannelDifferenceRequest from = ChannelDifferenceRequest::Unknown);
+	void sendChannelDifferenceRequest(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from);
+	void queueChannelDifferenceRequest(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from);
+	void finishChannelDifferenceRequest(not_null<ChannelData*> channel);
+	void sendQueuedChannelDifferenceRequests();
 	void gotDifference(const MTPupdates_Difference &diff);
 	bool failDifference(const RPCError &e);
+	// Each slice of updates re-sorts and repaints the chats list and
+	// refreshes the changed album views only once, after it is applied.
+	void startUpdatesBatch();
+	void finishUpdatesBatch();
 	void feedDifference(const MTPVector<MTPUser> &users, const MTPVector<MTPChat> &chats, const MTPVector<MTPMessage> &msgs, const MTPVector<MTPUpdate> &other);
 	void gotState(const MTPupdates_State &state);
 	void updSetState(int32 pts, int32 date, int32 qts, int32 seq);
@@ -524,6 +535,13 @@ private:
 
 	int32 _failDifferenceTimeout = 1; // growing timeout for getDifference calls, if it fails
 	QMap<ChannelData*, int32> _channelFailDifferenceTimeout; // growing timeout for getChannelDifference calls, if it fails
+
+	// Only a few getChannelDifference requests are sent at once, the
+	// rest wait here with the pinned chats going first.
+	base::flat_set<not_null<ChannelData*>> _channelDifferenceRequests;
+	std::deque<std::pair<
+		not_null<ChannelData*>,
+		ChannelDifferenceRequest>> _channelDifferenceQueue;
 	base::Timer _failDifferenceTimer;
 
 	crl::time _lastUpdateTime = 0;
@@ -533,6 +551,7 @@ private:
 	QRect _cachedFor, _willCacheFor;
 	int _cachedX = 0;
 	int _cachedY = 0;
+	int _cacheBackgroundGeneration = 0;
 	base::Timer _cacheBackgroundTimer;
 
 	PhotoData *_deletingPhoto = nullptr;
@@ -15,6 +15,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_file_origin.h"
 #include "platform/platform_audio.h"
 #include "core/application.h"
+#include "base/build_config.h"
 #include "facades.h"
 
 #include <AL/al.h>
@@ -23,6 +24,14 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include <numeric>
 
+#if defined ARCH_CPU_X86_64 || defined __SSE2__ || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define TDESKTOP_AUDIO_PEAKS_SSE2
+#include <emmintrin.h>
+#elif defined __ARM_NEON // ARCH_CPU_X86_64 || __SSE2__ || _M_IX86_FP >= 2
+#define TDESKTOP_AUDIO_PEAKS_NEON
+#include <arm_neon.h>
+#endif // ARCH_CPU_X86_64 || __SSE2__ || _M_IX86_FP >= 2
+
 Q_DECLARE_METATYPE(AudioMsgId);
 Q_DECLARE_METATYPE(VoiceWaveform);
 
@@ -57,6 +66,9 @@ namespace {
 
 Player::Mixer *MixerInstance = nullptr;
 
+// Thread: Any. Must be locked: AudioMutex.
+bool PlaybackEvents = false;
+
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
 struct PlaybackSpeedData {
 	ALuint uiEffectSlot = 0;
@@ -126,6 +138,7 @@ void EnumerateCaptureDevices() {
 
 // Thread: Any. Must be locked: AudioMutex.
 void DestroyPlaybackDevice() {
+	PlaybackEvents = false;
 	if (AudioContext) {
 		alcMakeContextCurrent(nullptr);
 		alcDestroyContext(AudioContext);
@@ -138,6 +151,52 @@ void DestroyPlaybackDevice() {
 	}
 }
 
+#ifdef AL_SOFT_events
+// Thread: OpenAL event thread.
+void AL_APIENTRY PlaybackEventCallback(
+		ALenum eventType,
+		ALuint object,
+		ALuint param,
+		ALsizei length,
+		const ALchar *message,
+		void *userParam) {
+	// The callback can't take AudioMutex, it is held while the
+	// events are disabled with the context destruction.
+	crl::on_main([] {
+		if (!App::quitting()) {
+			if (const auto mixer = Player::mixer()) {
+				emit mixer->faderOnTimer();
+			}
+		}
+	});
+}
+#endif // AL_SOFT_events
+
+// Thread: Any. Must be locked: AudioMutex.
+void EnablePlaybackEvents() {
+	PlaybackEvents = false;
+#ifdef AL_SOFT_events
+	if (!alIsExtensionPresent("AL_SOFT_events")) {
+		return;
+	}
+	const auto callback = reinterpret_cast<LPALEVENTCALLBACKSOFT>(
+		alGetProcAddress("alEventCallbackSOFT"));
+	const auto control = reinterpret_cast<LPALEVENTCONTROLSOFT>(
+		alGetProcAddress("alEventControlSOFT"));
+	if (!callback || !control) {
+		return;
+	}
+	const ALenum types[] = {
+		AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT,
+		AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT,
+	};
+	callback(PlaybackEventCallback, nullptr);
+	control(base::array_size(types), types, AL_TRUE);
+	PlaybackEvents = true;
+	LOG(("Audio Info: using OpenAL playback events."));
+#endif // AL_SOFT_events
+}
+
 // Thread: Any. Must be locked: AudioMutex.
 bool CreatePlaybackDevice() {
 	if (AudioDevice) return true;
@@ -166,6 +225,8 @@ bool CreatePlaybackDevice() {
 	alListener3f(AL_VELOCITY, 0.f, 0.f, 0.f);
 	alListenerfv(AL_ORIENTATION, v);
 
+	EnablePlaybackEvents();
+
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
 	// playback speed related init
 	// generate an effect slot and an effect
@@ -227,8 +288,11 @@ void Start(not_null<Instance*> instance) {
 	auto loglevel = getenv("ALSOFT_LOGLEVEL");
 	LOG(("OpenAL Logging Level: %1").arg(loglevel ? loglevel : "(not set)"));
 
-	EnumeratePlaybackDevices();
-	EnumerateCaptureDevices();
+	// The device lists are only logged, don't wait for the backends.
+	crl::async([] {
+		EnumeratePlaybackDevices();
+		EnumerateCaptureDevices();
+	});
 
 	MixerInstance = new Player::Mixer(instance);
 
@@ -310,6 +374,55 @@ bool SupportsSpeedControl() {
 #endif // TDESKTOP_DISABLE_OPENAL_EFFECTS
 }
 
+uint16 PeakOfSamples(gsl::span<const uchar> samples) {
+	auto result = uint16(0);
+	for (const auto sample : samples) {
+		accumulate_max(result, ReadOneSample(sample));
+	}
+	return result;
+}
+
+uint16 PeakOfSamples(gsl::span<const int16> samples) {
+	constexpr auto kStep = 8;
+
+	auto result = uint16(0);
+	auto from = samples.data();
+	const auto till = from + samples.size();
+#if defined TDESKTOP_AUDIO_PEAKS_SSE2
+	if (till - from >= kStep) {
+		// Saturated absolute values, so -32768 gives 32767.
+		const auto zero = _mm_setzero_si128();
+		auto peak = zero;
+		for (; till - from >= kStep; from += kStep) {
+			const auto value = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(from));
+			peak = _mm_max_epi16(
+				peak,
+				_mm_max_epi16(value, _mm_subs_epi16(zero, value)));
+		}
+		peak = _mm_max_epi16(peak, _mm_srli_si128(peak, 8));
+		peak = _mm_max_epi16(peak, _mm_srli_si128(peak, 4));
+		peak = _mm_max_epi16(peak, _mm_srli_si128(peak, 2));
+		result = uint16(_mm_cvtsi128_si32(peak) & 0xFFFF);
+	}
+#elif defined TDESKTOP_AUDIO_PEAKS_NEON // TDESKTOP_AUDIO_PEAKS_SSE2
+	if (till - from >= kStep) {
+		auto peak = vdupq_n_s16(0);
+		for (; till - from >= kStep; from += kStep) {
+			peak = vmaxq_s16(peak, vqabsq_s16(vld1q_s16(from)));
+		}
+		auto half = vmax_s16(vget_low_s16(peak), vget_high_s16(peak));
+		half = vpmax_s16(half, half);
+		half = vpmax_s16(half, half);
+		result = uint16(vget_lane_s16(half, 0));
+	}
+#endif // TDESKTOP_AUDIO_PEAKS_SSE2 || TDESKTOP_AUDIO_PEAKS_NEON
+	for (; from != till; ++from) {
+		accumulate_max(result, ReadOneSample(*from));
+	}
+	return result;
+}
+
 } // namespace Audio
 
 namespace Player {
@@ -319,6 +432,7 @@ constexpr auto kVolumeRound = 10000;
 constexpr auto kPreloadSamples = 2LL * kDefaultFrequency; // preload next part if less than 2 seconds remains
 constexpr auto kFadeDuration = crl::time(500);
 constexpr auto kCheckPlaybackPositionTimeout = crl::time(100); // 100ms per check audio position
+constexpr auto kCheckPlaybackEventsTimeout = crl::time(200); // buffers and stops are notified by OpenAL
 constexpr auto kCheckPlaybackPositionDelta = 2400LL; // update position called each 2400 samples
 constexpr auto kCheckFadingTimeout = crl::time(7); // 7ms
 
@@ -351,7 +465,7 @@ void Mixer::Track::createStream(AudioMsgId::Type type) {
 	alSource3f(stream.source, AL_VELOCITY, 0, 0, 0);
 	alSourcei(stream.source, AL_LOOPING, 0);
 	alSourcei(stream.source, AL_DIRECT_CHANNELS_SOFT, 1);
-	alGenBuffers(3, stream.buffers);
+	alGenBuffers(kMaxBuffersCount, stream.buffers);
 	if (type == AudioMsgId::Type::Voice) {
 		mixer()->updatePlaybackSpeed(this);
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
@@ -390,11 +504,11 @@ void Mixer::Track::applySourceSpeedEffect() {
 
 void Mixer::Track::destroyStream() {
 	if (isStreamCreated()) {
-		alDeleteBuffers(3, stream.buffers);
+		alDeleteBuffers(kMaxBuffersCount, stream.buffers);
 		alDeleteSources(1, &stream.source);
 	}
 	stream.source = 0;
-	for (auto i = 0; i != 3; ++i) {
+	for (auto i = 0; i != kMaxBuffersCount; ++i) {
 		stream.buffers[i] = 0;
 	}
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
@@ -427,7 +541,7 @@ void Mixer::Track::reattach(AudioMsgId::Type type) {
 	}
 
 	createStream(type);
-	for (auto i = 0; i != kBuffersCount; ++i) {
+	for (auto i = 0; i != kMaxBuffersCount; ++i) {
 		if (!samplesCount[i]) {
 			break;
 		}
@@ -470,10 +584,12 @@ void Mixer::Track::clear() {
 
 	format = 0;
 	frequency = kDefaultFrequency;
-	for (int i = 0; i != kBuffersCount; ++i) {
+	for (int i = 0; i != kMaxBuffersCount; ++i) {
 		samplesCount[i] = 0;
 		bufferSamples[i] = QByteArray();
 	}
+	buffersCount = kBuffersCount;
+	underrun = false;
 
 	setExternalData(nullptr);
 	lastUpdateWhen = 0;
@@ -490,10 +606,11 @@ void Mixer::Track::started() {
 
 	format = 0;
 	frequency = kDefaultFrequency;
-	for (auto i = 0; i != kBuffersCount; ++i) {
+	for (auto i = 0; i != kMaxBuffersCount; ++i) {
 		samplesCount[i] = 0;
 		bufferSamples[i] = QByteArray();
 	}
+	underrun = false;
 }
 
 bool Mixer::Track::isStreamCreated() const {
@@ -508,7 +625,7 @@ void Mixer::Track::ensureStreamCreated(AudioMsgId::Type type) {
 
 int Mixer::Track::getNotQueuedBufferIndex() {
 	// See if there are no free buffers right now.
-	while (samplesCount[kBuffersCount - 1] != 0) {
+	while (samplesCount[buffersCount - 1] != 0) {
 		// Try to unqueue some buffer.
 		ALint processed = 0;
 		alGetSourcei(stream.source, AL_BUFFERS_PROCESSED, &processed);
@@ -522,19 +639,19 @@ int Mixer::Track::getNotQueuedBufferIndex() {
 
 		// Find it in the list and clear it.
 		bool found = false;
-		for (auto i = 0; i != kBuffersCount; ++i) {
+		for (auto i = 0; i != buffersCount; ++i) {
 			if (stream.buffers[i] == buffer) {
 				auto samplesInBuffer = samplesCount[i];
 				bufferedPosition += samplesInBuffer;
 				bufferedLength -= samplesInBuffer;
-				for (auto j = i + 1; j != kBuffersCount; ++j) {
+				for (auto j = i + 1; j != buffersCount; ++j) {
 					samplesCount[j - 1] = samplesCount[j];
 					stream.buffers[j - 1] = stream.buffers[j];
 					bufferSamples[j - 1] = bufferSamples[j];
 				}
-				samplesCount[kBuffersCount - 1] = 0;
-				stream.buffers[kBuffersCount - 1] = buffer;
-				bufferSamples[kBuffersCount - 1] = QByteArray();
+				samplesCount[buffersCount - 1] = 0;
+				stream.buffers[buffersCount - 1] = buffer;
+				bufferSamples[buffersCount - 1] = QByteArray();
 				found = true;
 				break;
 			}
@@ -545,7 +662,7 @@ int Mixer::Track::getNotQueuedBufferIndex() {
 		}
 	}
 
-	for (auto i = 0; i != kBuffersCount; ++i) {
+	for (auto i = 0; i != buffersCount; ++i) {
 		if (!samplesCount[i]) {
 			return i;
 		}
@@ -553,6 +670,22 @@ int Mixer::Track::getNotQueuedBufferIndex() {
 	return -1;
 }
 
+void Mixer::Track::checkUnderrun(bool stopped) {
+	if (!stopped) {
+		underrun = false;
+		return;
+	} else if (underrun || state.id.externalPlayId()) {
+		// Streamed tracks wait for the network, not for the decoder.
+		return;
+	}
+	underrun = true;
+	if (buffersCount < kMaxBuffersCount) {
+		++buffersCount;
+		LOG(("Audio Info: playback underrun, using %1 buffers."
+			).arg(buffersCount));
+	}
+}
+
 void Mixer::Track::setExternalData(
 		std::unique_ptr<ExternalSoundData> data) {
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
@@ -1370,11 +1503,13 @@ void Fader::onTimer() {
 	auto hasFading = (_suppressAll || _suppressSongAnim);
 	auto hasPlaying = false;
 
-	auto updatePlayback = [this, &hasPlaying, &hasFading](AudioMsgId::Type type, int index, float64 volumeMultiplier, bool suppressGainChanged) {
+	auto hasPlayingVideo = false;
+
+	auto updatePlayback = [this, &hasFading](bool &playing, AudioMsgId::Type type, int index, float64 volumeMultiplier, bool suppressGainChanged) {
 		auto track = mixer()->trackForType(type, index);
 		if (IsStopped(track->state.state) || track->state.state == State::Paused || !track->isStreamCreated()) return;
 
-		auto emitSignals = updateOnePlayback(track, hasPlaying, hasFading, volumeMultiplier, suppressGainChanged);
+		auto emitSignals = updateOnePlayback(track, playing, hasFading, volumeMultiplier, suppressGainChanged);
 		if (emitSignals & EmitError) emit error(track->state.id);
 		if (emitSignals & EmitStopped) emit audioStopped(track->state.id);
 		if (emitSignals & EmitPositionUpdated) emit playPositionUpdated(track->state.id);
@@ -1383,21 +1518,27 @@ void Fader::onTimer() {
 	auto suppressGainForMusic = ComputeVolume(AudioMsgId::Type::Song);
 	auto suppressGainForMusicChanged = volumeChangedSong || _volumeChangedSong;
 	for (auto i = 0; i != kTogetherLimit; ++i) {
-		updatePlayback(AudioMsgId::Type::Voice, i, VolumeMultiplierAll, volumeChangedAll);
-		updatePlayback(AudioMsgId::Type::Song, i, suppressGainForMusic, suppressGainForMusicChanged);
+		updatePlayback(hasPlaying, AudioMsgId::Type::Voice, i, VolumeMultiplierAll, volumeChangedAll);
+		updatePlayback(hasPlaying, AudioMsgId::Type::Song, i, suppressGainForMusic, suppressGainForMusicChanged);
 	}
 	auto suppressGainForVideo = ComputeVolume(AudioMsgId::Type::Video);
 	auto suppressGainForVideoChanged = volumeChangedAll || _volumeChangedVideo;
-	updatePlayback(AudioMsgId::Type::Video, 0, suppressGainForVideo, suppressGainForVideoChanged);
+	updatePlayback(hasPlayingVideo, AudioMsgId::Type::Video, 0, suppressGainForVideo, suppressGainForVideoChanged);
 
 	_volumeChangedSong = _volumeChangedVideo = false;
 
 	if (hasFading) {
 		_timer.start(kCheckFadingTimeout);
 		Audio::StopDetachIfNotUsedSafe();
-	} else if (hasPlaying) {
+	} else if (hasPlayingVideo) {
+		// Video frames are synchronized by the audio position.
 		_timer.start(kCheckPlaybackPositionTimeout);
 		Audio::StopDetachIfNotUsedSafe();
+	} else if (hasPlaying) {
+		_timer.start(Audio::PlaybackEvents
+			? kCheckPlaybackEventsTimeout
+			: kCheckPlaybackPositionTimeout);
+		Audio::StopDetachIfNotUsedSafe();
 	} else {
 		Audio::ScheduleDetachIfNotUsedSafe();
 	}
@@ -1439,6 +1580,9 @@ int32 Fader::updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasF
 
 	auto playing = (track->state.state == State::Playing);
 	auto fading = IsFading(track->state.state);
+	track->checkUnderrun((alState == AL_STOPPED)
+		&& track->loading
+		&& (playing || fading));
 	if (alState != AL_PLAYING && !track->loading) {
 		if (fading || playing) {
 			fading = false;
@@ -1504,7 +1648,10 @@ int32 Fader::updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasF
 	}
 	if (playing || track->state.state == State::Starting || track->state.state == State::Resuming) {
 		if (!track->loaded && !track->loading) {
-			auto needPreload = (track->state.position + kPreloadSamples > track->bufferedPosition + track->bufferedLength);
+			const auto preloadSamples = kPreloadSamples
+				* track->buffersCount
+				/ Mixer::Track::kBuffersCount;
+			auto needPreload = (track->state.position + preloadSamples > track->bufferedPosition + track->bufferedLength);
 			if (needPreload) {
 				track->loading = true;
 				emitSignals |= EmitNeedToPreload;
@@ -1758,13 +1905,25 @@ public:
 
 		auto fmt = format();
 		auto peak = uint16(0);
-		auto callback = [&](uint16 sample) {
-			accumulate_max(peak, sample);
-			sumbytes += Media::Player::kWaveformSamplesCount;
-			if (sumbytes >= countbytes) {
-				sumbytes -= countbytes;
-				peaks.push_back(peak);
-				peak = 0;
+
+		// Each sample adds kWaveformSamplesCount to sumbytes and a peak
+		// is pushed once it reaches countbytes, so find the samples till
+		// the next peak and take their maximum at once.
+		const auto feed = [&](auto samples) {
+			constexpr auto kStep = int64(Media::Player::kWaveformSamplesCount);
+			while (!samples.empty()) {
+				const auto left = (countbytes - sumbytes + kStep - 1) / kStep;
+				const auto count = std::min(int64(samples.size()), left);
+				accumulate_max(
+					peak,
+					Media::Audio::PeakOfSamples(samples.subspan(0, count)));
+				sumbytes += count * kStep;
+				if (sumbytes >= countbytes) {
+					sumbytes -= countbytes;
+					peaks.push_back(peak);
+					peak = 0;
+				}
+				samples = samples.subspan(count);
 			}
 		};
 		while (processed < countbytes) {
@@ -1781,9 +1940,9 @@ public:
 
 			auto sampleBytes = bytes::make_span(buffer);
 			if (fmt == AL_FORMAT_MONO8 || fmt == AL_FORMAT_STEREO8) {
-				Media::Audio::IterateSamples<uchar>(sampleBytes, callback);
+				feed(Media::Audio::SamplesSpan<uchar>(sampleBytes));
 			} else if (fmt == AL_FORMAT_MONO16 || fmt == AL_FORMAT_STEREO16) {
-				Media::Audio::IterateSamples<int16>(sampleBytes, callback);
+				feed(Media::Audio::SamplesSpan<int16>(sampleBytes));
 			}
 			processed += sampleSize() * samples;
 		}
@@ -198,7 +198,9 @@ private:
 
 	class Track {
 	public:
+		// More buffers are queued after underruns, up to kMaxBuffersCount.
 		static constexpr int kBuffersCount = 3;
+		static constexpr int kMaxBuffersCount = 6;
 
 		// Thread: Any. Must be locked: AudioMutex.
 		void reattach(AudioMsgId::Type type);
@@ -211,6 +213,7 @@ private:
 		void ensureStreamCreated(AudioMsgId::Type type);
 
 		int getNotQueuedBufferIndex();
+		void checkUnderrun(bool stopped);
 
 		void setExternalData(std::unique_ptr<ExternalSoundData> data);
 #ifndef TDESKTOP_DISABLE_OPENAL_EFFECTS
@@ -231,12 +234,14 @@ private:
 
 		int32 format = 0;
 		int32 frequency = kDefaultFrequency;
-		int samplesCount[kBuffersCount] = { 0 };
-		QByteArray bufferSamples[kBuffersCount];
+		int samplesCount[kMaxBuffersCount] = { 0 };
+		QByteArray bufferSamples[kMaxBuffersCount];
+		int buffersCount = kBuffersCount;
+		bool underrun = false;
 
 		struct Stream {
 			uint32 source = 0;
-			uint32 buffers[kBuffersCount] = { 0 };
+			uint32 buffers[kMaxBuffersCount] = { 0 };
 		};
 		Stream stream;
 		std::unique_ptr<ExternalSoundData> externalData;
@@ -384,15 +389,23 @@ TG_FORCE_INLINE uint16 ReadOneSample(int16 data) {
 	return qAbs(data);
 }
 
-template <typename SampleType, typename Callback>
-void IterateSamples(bytes::const_span bytes, Callback &&callback) {
+template <typename SampleType>
+gsl::span<const SampleType> SamplesSpan(bytes::const_span bytes) {
 	auto samplesPointer = reinterpret_cast<const SampleType*>(bytes.data());
 	auto samplesCount = bytes.size() / sizeof(SampleType);
-	auto samplesData = gsl::make_span(samplesPointer, samplesCount);
-	for (auto sampleData : samplesData) {
+	return gsl::make_span(samplesPointer, samplesCount);
+}
+
+template <typename SampleType, typename Callback>
+void IterateSamples(bytes::const_span bytes, Callback &&callback) {
+	for (auto sampleData : SamplesSpan<SampleType>(bytes)) {
 		callback(ReadOneSample(sampleData));
 	}
 }
 
+// Maximum of ReadOneSample() values, vectorized where possible.
+uint16 PeakOfSamples(gsl::span<const uchar> samples);
+uint16 PeakOfSamples(gsl::span<const int16> samples);
+
 } // namespace Audio
 } // namespace Media
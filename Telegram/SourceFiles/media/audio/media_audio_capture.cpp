@@ -93,6 +93,7 @@ struct Instance::Inner::Private {
 	AVCodec *codec = nullptr;
 	AVCodecContext *codecContext = nullptr;
 	bool opened = false;
+	std::atomic<bool> failed = { false };
 
 	int srcSamples = 0;
 	int dstSamples = 0;
@@ -190,6 +191,7 @@ void Instance::Inner::onStart() {
 		emit error();
 		return;
 	}
+	d->failed = false;
 
 	// Create encoding context
 
@@ -324,6 +326,7 @@ void Instance::Inner::onStart() {
 	_timer.start(50);
 	_captured.clear();
 	_captured.reserve(kCaptureBufferSlice);
+	_queuedSamples = 0;
 	DEBUG_LOG(("Audio Capture: started!"));
 }
 
@@ -335,6 +338,7 @@ void Instance::Inner::onStop(bool needResult) {
 		alcCaptureStop(d->device);
 		onTimeout(); // get last data
 	}
+	waitEncoded();
 
 	// Write what is left
 	if (!_captured.isEmpty()) {
@@ -361,7 +365,7 @@ void Instance::Inner::onStop(bool needResult) {
 
 			int32 framesize = d->srcSamples * d->codecContext->channels * sizeof(short), encoded = 0;
 			while (_captured.size() >= encoded + framesize) {
-				processFrame(encoded, framesize);
+				processFrame(_captured, encoded, framesize);
 				encoded += framesize;
 			}
 			writeFrame(nullptr); // drain the codec
@@ -377,6 +381,7 @@ void Instance::Inner::onStop(bool needResult) {
 	}
 	DEBUG_LOG(("Audio Capture: stopping (need result: %1), size: %2, samples: %3").arg(Logs::b(needResult)).arg(d->data.size()).arg(d->fullSamples));
 	_captured = QByteArray();
+	_queuedSamples = 0;
 
 	// Finish stream
 	if (d->device) {
@@ -470,13 +475,20 @@ void Instance::Inner::onStop(bool needResult) {
 		d->waveformPeak = 0;
 		d->waveform.clear();
 	}
-	if (needResult) emit done(result, waveform, samples);
+	if (d->failed) {
+		emit error();
+	} else if (needResult) {
+		emit done(result, waveform, samples);
+	}
 }
 
 void Instance::Inner::onTimeout() {
 	if (!d->device) {
 		_timer.stop();
 		return;
+	} else if (d->failed) {
+		onStop(false);
+		return;
 	}
 	ALint samples;
 	alcGetIntegerv(d->device, ALC_CAPTURE_SAMPLES, sizeof(samples), &samples);
@@ -503,7 +515,7 @@ void Instance::Inner::onTimeout() {
 		// Count new recording level and update view
 		auto skipSamples = kCaptureSkipDuration * kCaptureFrequency / 1000;
 		auto fadeSamples = kCaptureFadeInDuration * kCaptureFrequency / 1000;
-		auto levelindex = d->fullSamples + static_cast<int>(s / sizeof(short));
+		auto levelindex = _queuedSamples + static_cast<int>(s / sizeof(short));
 		for (auto ptr = (const short*)(_captured.constData() + s), end = (const short*)(_captured.constData() + news); ptr < end; ++ptr, ++levelindex) {
 			if (levelindex > skipSamples) {
 				uint16 value = qAbs(*ptr);
@@ -515,21 +527,25 @@ void Instance::Inner::onTimeout() {
 				}
 			}
 		}
-		qint32 samplesFull = d->fullSamples + _captured.size() / sizeof(short), samplesSinceUpdate = samplesFull - d->lastUpdate;
+		qint32 samplesFull = _queuedSamples + _captured.size() / sizeof(short), samplesSinceUpdate = samplesFull - d->lastUpdate;
 		if (samplesSinceUpdate > AudioVoiceMsgUpdateView * kCaptureFrequency / 1000) {
 			emit updated(d->levelMax, samplesFull);
 			d->lastUpdate = samplesFull;
 			d->levelMax = 0;
 		}
-		// Write frames
+		// Pass frames to the encoder, so that capture is never delayed by it.
 		int32 framesize = d->srcSamples * d->codecContext->channels * sizeof(short), encoded = 0;
 		while (uint32(_captured.size()) >= encoded + framesize + fadeSamples * sizeof(short)) {
-			processFrame(encoded, framesize);
 			encoded += framesize;
 		}
 
 		// Collapse the buffer
 		if (encoded > 0) {
+			_queuedSamples += encoded / sizeof(short);
+			_encoder.async([=, frames = _captured.left(encoded)]() mutable {
+				encodeFrames(frames, framesize);
+			});
+
 			int32 goodSize = _captured.size() - encoded;
 			memmove(_captured.data(), _captured.constData() + encoded, goodSize);
 			_captured.resize(goodSize);
@@ -539,13 +555,30 @@ void Instance::Inner::onTimeout() {
 	}
 }
 
-void Instance::Inner::processFrame(int32 offset, int32 framesize) {
+void Instance::Inner::waitEncoded() {
+	auto semaphore = crl::semaphore();
+	_encoder.async([&] {
+		semaphore.release();
+	});
+	semaphore.acquire();
+}
+
+void Instance::Inner::encodeFrames(QByteArray &frames, int32 framesize) {
+	for (auto offset = 0; offset + framesize <= frames.size(); offset += framesize) {
+		processFrame(frames, offset, framesize);
+	}
+}
+
+void Instance::Inner::processFrame(QByteArray &frames, int32 offset, int32 framesize) {
+	if (d->failed) {
+		return;
+	}
+
 	// Prepare audio frame
 
 	if (framesize % sizeof(short)) { // in the middle of a sample
 		LOG(("Audio Error: Bad framesize in writeFrame() for capture, framesize %1, %2").arg(framesize));
-		onStop(false);
-		emit error();
+		d->failed = true;
 		return;
 	}
 	auto samplesCnt = static_cast<int>(framesize / sizeof(short));
@@ -553,7 +586,7 @@ void Instance::Inner::processFrame(int32 offset, int32 framesize) {
 	int res = 0;
 	char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
 
-	auto srcSamplesDataChannel = (short*)(_captured.data() + offset);
+	auto srcSamplesDataChannel = (short*)(frames.data() + offset);
 	auto srcSamplesData = &srcSamplesDataChannel;
 
 	//	memcpy(d->srcSamplesData[0], _captured.constData() + offset, framesize);
@@ -592,8 +625,7 @@ void Instance::Inner::processFrame(int32 offset, int32 framesize) {
 		av_freep(&d->dstSamplesData[0]);
 		if ((res = av_samples_alloc(d->dstSamplesData, 0, d->codecContext->channels, d->dstSamples, d->codecContext->sample_fmt, 1)) < 0) {
 			LOG(("Audio Error: Unable to av_samples_alloc for capture, error %1, %2").arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-			onStop(false);
-			emit error();
+			d->failed = true;
 			return;
 		}
 		d->dstSamplesSize = av_samples_get_buffer_size(0, d->codecContext->channels, d->maxDstSamples, d->codecContext->sample_fmt, 0);
@@ -601,8 +633,7 @@ void Instance::Inner::processFrame(int32 offset, int32 framesize) {
 
 	if ((res = swr_convert(d->swrContext, d->dstSamplesData, d->dstSamples, (const uint8_t **)srcSamplesData, d->srcSamples)) < 0) {
 		LOG(("Audio Error: Unable to swr_convert for capture, error %1, %2").arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-		onStop(false);
-		emit error();
+		d->failed = true;
 		return;
 	}
 
@@ -632,30 +663,26 @@ void Instance::Inner::writeFrame(AVFrame *frame) {
 		if (packetsWritten < 0) {
 			if (frame && packetsWritten == AVERROR_EOF) {
 				LOG(("Audio Error: EOF in packets received when EAGAIN was got in avcodec_send_frame()"));
-				onStop(false);
-				emit error();
+				d->failed = true;
 			}
 			return;
 		} else if (!packetsWritten) {
 			LOG(("Audio Error: No packets received when EAGAIN was got in avcodec_send_frame()"));
-			onStop(false);
-			emit error();
+			d->failed = true;
 			return;
 		}
 		res = avcodec_send_frame(d->codecContext, frame);
 	}
 	if (res < 0) {
 		LOG(("Audio Error: Unable to avcodec_send_frame for capture, error %1, %2").arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-		onStop(false);
-		emit error();
+		d->failed = true;
 		return;
 	}
 
 	if (!frame) { // drain
 		if ((res = writePackets()) != AVERROR_EOF) {
 			LOG(("Audio Error: not EOF in packets received when draining the codec, result %1").arg(res));
-			onStop(false);
-			emit error();
+			d->failed = true;
 		}
 	}
 }
@@ -677,8 +704,7 @@ int Instance::Inner::writePackets() {
 				return res;
 			}
 			LOG(("Audio Error: Unable to avcodec_receive_packet for capture, error %1, %2").arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-			onStop(false);
-			emit error();
+			d->failed = true;
 			return res;
 		}
 
@@ -686,8 +712,7 @@ int Instance::Inner::writePackets() {
 		pkt.stream_index = d->stream->index;
 		if ((res = av_interleaved_write_frame(d->fmtContext, &pkt)) < 0) {
 			LOG(("Audio Error: Unable to av_interleaved_write_frame for capture, error %1, %2").arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-			onStop(false);
-			emit error();
+			d->failed = true;
 			return -1;
 		}
 
@@ -67,7 +67,9 @@ public slots:
 	void onTimeout();
 
 private:
-	void processFrame(int32 offset, int32 framesize);
+	// Encoding stage, runs on _encoder, except the last frames in onStop().
+	void encodeFrames(QByteArray &frames, int32 framesize);
+	void processFrame(QByteArray &frames, int32 offset, int32 framesize);
 
 	void writeFrame(AVFrame *frame);
 
@@ -75,11 +77,17 @@ private:
 	// Returns number of packets written or -1 on error
 	int writePackets();
 
+	void waitEncoded();
+
 	struct Private;
 	Private *d;
 	QTimer _timer;
 	QByteArray _captured;
 
+	// Samples passed to the encoder, d->fullSamples may still lag behind.
+	int _queuedSamples = 0;
+	crl::queue _encoder;
+
 };
 
 } // namespace Capture
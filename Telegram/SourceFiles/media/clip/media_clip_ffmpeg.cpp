@@ -16,30 +16,6 @@ namespace internal {
 namespace {
 
 constexpr int kSkipInvalidDataPackets = 10;
-constexpr int kAlignImageBy = 16;
-
-void alignedImageBufferCleanupHandler(void *data) {
-	auto buffer = static_cast<uchar*>(data);
-	delete[] buffer;
-}
-
-// Create a QImage of desired size where all the data is aligned to 16 bytes.
-QImage createAlignedImage(QSize size) {
-	auto width = size.width();
-	auto height = size.height();
-	auto widthalign = kAlignImageBy / 4;
-	auto neededwidth = width + ((width % widthalign) ? (widthalign - (width % widthalign)) : 0);
-	auto bytesperline = neededwidth * 4;
-	auto buffer = new uchar[bytesperline * height + kAlignImageBy];
-	auto cleanupdata = static_cast<void*>(buffer);
-	auto bufferval = reinterpret_cast<uintptr_t>(buffer);
-	auto alignedbuffer = buffer + ((bufferval % kAlignImageBy) ? (kAlignImageBy - (bufferval % kAlignImageBy)) : 0);
-	return QImage(alignedbuffer, width, height, bytesperline, QImage::Format_ARGB32_Premultiplied, alignedImageBufferCleanupHandler, cleanupdata);
-}
-
-bool isAlignedImage(const QImage &image) {
-	return !(reinterpret_cast<uintptr_t>(image.constBits()) % kAlignImageBy) && !(image.bytesPerLine() % kAlignImageBy);
-}
 
 } // namespace
 
@@ -229,8 +205,8 @@ bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const Q
 	if (!size.isEmpty() && rotationSwapWidthHeight()) {
 		toSize.transpose();
 	}
-	if (to.isNull() || to.size() != toSize || !to.isDetached() || !isAlignedImage(to)) {
-		to = createAlignedImage(toSize);
+	if (!Streaming::GoodStorageForFrame(to, toSize)) {
+		to = Streaming::CreateFrameStorage(toSize);
 	}
 	hasAlpha = (_frame->format == AV_PIX_FMT_BGRA || (_frame->format == -1 && _codecContext->pix_fmt == AV_PIX_FMT_BGRA));
 	if (_frame->width == toSize.width() && _frame->height == toSize.height() && hasAlpha) {
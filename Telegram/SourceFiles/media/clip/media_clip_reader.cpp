@@ -20,13 +20,81 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include <atomic>
+
 namespace Media {
 namespace Clip {
 namespace {
 
+constexpr auto kAutoplayBudgetWindow = crl::time(1000);
+constexpr auto kAutoplayPixelsPerWindow = 1920 * 1080 * 60;
+constexpr auto kAutoplaySmallArea = 360 * 360;
+constexpr auto kAutoplayPostponeDelay = crl::time(20);
+
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+// Decoded pixels of all autoplaying GIFs and round videos in all the
+// clip threads are limited per second. When the budget is spent frames
+// are postponed, so animations slow down instead of pegging every core.
+// Off screen readers back off first, then the large ones.
+enum class AutoplayPriority {
+	Low,
+	Normal,
+	High,
+};
+
+std::atomic<crl::time> AutoplayWindowStart = { 0 };
+std::atomic<int> AutoplayUsed = { 0 };
+std::atomic<int> AutoplayDecoded = { 0 };
+std::atomic<int> AutoplayPostponed = { 0 };
+std::atomic<int> AutoplayLastDecoded = { 0 };
+std::atomic<int> AutoplayLastPostponed = { 0 };
+
+int AutoplayLimit(AutoplayPriority priority) {
+	switch (priority) {
+	case AutoplayPriority::Low: return kAutoplayPixelsPerWindow / 2;
+	case AutoplayPriority::Normal: return kAutoplayPixelsPerWindow / 4 * 3;
+	case AutoplayPriority::High: return kAutoplayPixelsPerWindow;
+	}
+	Unexpected("Priority in AutoplayLimit.");
+}
+
+void RotateAutoplayWindow(crl::time now) {
+	auto start = AutoplayWindowStart.load();
+	if (now - start < kAutoplayBudgetWindow
+		|| !AutoplayWindowStart.compare_exchange_strong(start, now)) {
+		return;
+	}
+	AutoplayUsed = 0;
+	const auto decoded = AutoplayDecoded.exchange(0);
+	const auto postponed = AutoplayPostponed.exchange(0);
+	AutoplayLastDecoded = decoded;
+	AutoplayLastPostponed = postponed;
+	if (postponed > 0) {
+		DEBUG_LOG(("Clip Info: autoplay budget postponed %1 frames, "
+			"decoded %2 frames."
+			).arg(postponed
+			).arg(decoded));
+	}
+}
+
+bool TakeAutoplayBudget(int cost, AutoplayPriority priority, crl::time now) {
+	RotateAutoplayWindow(now);
+
+	const auto limit = AutoplayLimit(priority);
+	auto used = AutoplayUsed.load();
+	do {
+		// Allow a single frame larger than the whole budget.
+		if (used > 0 && used + cost > limit) {
+			++AutoplayPostponed;
+			return false;
+		}
+	} while (!AutoplayUsed.compare_exchange_weak(used, used + cost));
+	++AutoplayDecoded;
+	return true;
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -432,11 +500,33 @@ public:
 		}
 
 		if (!_autoPausedGif && !_videoPausedAtMs && ms >= _nextFrameWhen) {
+			if (_mode == Reader::Mode::Gif
+				&& !TakeAutoplayBudget(
+					_width * _height,
+					autoplayPriority(),
+					ms)) {
+				postpone(kAutoplayPostponeDelay);
+				return ProcessResult::Wait;
+			}
 			return ProcessResult::Repaint;
 		}
 		return ProcessResult::Wait;
 	}
 
+	AutoplayPriority autoplayPriority() const {
+		if (!_displayed) {
+			return AutoplayPriority::Low;
+		}
+		return (_width * _height <= kAutoplaySmallArea)
+			? AutoplayPriority::High
+			: AutoplayPriority::Normal;
+	}
+
+	void postpone(crl::time delay) {
+		_animationStarted += delay;
+		_nextFrameWhen += delay;
+	}
+
 	ProcessResult finishProcess(crl::time ms) {
 		auto frameMs = _seekPositionMs + ms - _animationStarted;
 		auto readResult = _implementation->readFramesTill(frameMs, ms);
@@ -514,9 +604,7 @@ public:
 	void resumeVideo(crl::time ms) {
 		if (!_videoPausedAtMs) return; // Not paused.
 
-		auto delta = ms - _videoPausedAtMs;
-		_animationStarted += delta;
-		_nextFrameWhen += delta;
+		postpone(ms - _videoPausedAtMs);
 
 		_videoPausedAtMs = 0;
 		if (_hasAudio) {
@@ -590,6 +678,7 @@ private:
 	crl::time _nextFramePositionMs = 0;
 
 	bool _autoPausedGif = false;
+	bool _displayed = true;
 	bool _started = false;
 	crl::time _videoPausedAtMs = 0;
 
@@ -689,6 +778,7 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 		int32 ishowing, iprevious;
 		auto showing = it.key()->frameToShow(&ishowing), previous = it.key()->frameToWriteNext(false, &iprevious);
 		Assert(previous != nullptr && showing != nullptr && ishowing >= 0 && iprevious >= 0);
+		reader->_displayed = (showing->displayed.loadAcquire() > 0);
 		if (reader->_frames[ishowing].when > 0 && showing->displayed.loadAcquire() <= 0) { // current frame was not shown
 			if (reader->_frames[ishowing].when + WaitBeforeGifPause < ms || (reader->_frames[iprevious].when && previous->displayed.loadAcquire() <= 0)) {
 				reader->_autoPausedGif = true;
@@ -903,6 +993,13 @@ FileMediaInformation::Video PrepareForSending(const QString &fname, const QByteA
 	return result;
 }
 
+AutoplayStats LastAutoplayStats() {
+	auto result = AutoplayStats();
+	result.decoded = AutoplayLastDecoded.load();
+	result.postponed = AutoplayLastPostponed.load();
+	return result;
+}
+
 void Finish() {
 	if (!threads.isEmpty()) {
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
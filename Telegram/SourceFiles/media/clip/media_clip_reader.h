@@ -238,6 +238,14 @@ private:
 
 FileMediaInformation::Video PrepareForSending(const QString &fname, const QByteArray &data);
 
+// Frames of the autoplaying animations in the last second, postponed
+// ones were delayed because the decoding budget was spent.
+struct AutoplayStats {
+	int decoded = 0;
+	int postponed = 0;
+};
+AutoplayStats LastAutoplayStats();
+
 void Finish();
 
 } // namespace Clip
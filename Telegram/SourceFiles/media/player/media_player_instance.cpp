@@ -35,6 +35,9 @@ constexpr auto kIdsLimit = 32;
 // Preload next messages if we went further from current than that.
 constexpr auto kIdsPreloadAfter = 28;
 
+// Download that many next voice and round messages while playing.
+constexpr auto kPreloadNextFilesCount = 3;
+
 } // namespace
 
 void start(not_null<Audio::Instance*> instance) {
@@ -183,9 +186,37 @@ void Instance::playlistUpdated(not_null<Data*> data) {
 	} else {
 		data->playlistIndex = std::nullopt;
 	}
+	preloadNextInPlaylist(data);
 	data->playlistChanges.fire({});
 }
 
+void Instance::preloadNextInPlaylist(not_null<Data*> data) {
+	// Autonext plays the following voice or round message right away,
+	// have them in the cache so that it starts without a pause.
+	if (data->type != AudioMsgId::Type::Voice || !data->playlistIndex) {
+		return;
+	}
+	for (auto i = 1; i <= kPreloadNextFilesCount; ++i) {
+		const auto item = itemByIndex(data, *data->playlistIndex + i);
+		const auto media = item ? item->media() : nullptr;
+		const auto document = media ? media->document() : nullptr;
+		if (!document
+			|| !(document->isVoiceMessage() || document->isVideoMessage())
+			|| !document->saveToCache()
+			|| document->status != FileReady
+			|| document->loaded()
+			|| document->loading()
+			|| document->cancelled()) {
+			continue;
+		}
+		document->save(
+			item->fullId(),
+			QString(),
+			LoadFromCloudOrLocal,
+			true);
+	}
+}
+
 bool Instance::validPlaylist(not_null<Data*> data) {
 	if (const auto key = playlistKey(data)) {
 		if (!data->playlistSlice) {
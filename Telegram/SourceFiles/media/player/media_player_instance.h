@@ -186,6 +186,7 @@ private:
 	bool validPlaylist(not_null<Data*> data);
 	void validatePlaylist(not_null<Data*> data);
 	void playlistUpdated(not_null<Data*> data);
+	void preloadNextInPlaylist(not_null<Data*> data);
 	bool moveInPlaylist(not_null<Data*> data, int delta, bool autonext);
 	HistoryItem *itemByIndex(not_null<Data*> data, int index);
 
@@ -101,6 +101,22 @@ struct Update {
 		Finished> data;
 };
 
+// Collected during the whole player lifetime, including seeks.
+struct Statistics {
+	crl::time startLatency = kTimeUnknown;
+	int waitingCount = 0;
+	crl::time waitingDuration = 0;
+	int64 fileSize = 0;
+	int64 streamPerSecond = 0;
+	int64 loadPerSecond = 0;
+	int64 loadedBytes = 0;
+	int slicesFromCache = 0;
+	int slicesNotInCache = 0;
+	int framesDecoded = 0;
+	int framesDropped = 0;
+	int64 decodeMicroseconds = 0;
+};
+
 enum class Error {
 	OpenFailed,
 	LoadFailed,
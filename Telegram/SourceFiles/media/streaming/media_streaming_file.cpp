@@ -131,7 +131,7 @@ Stream File::Context::initStream(
 		}
 	}
 
-	result.codec = MakeCodecPointer(info);
+	result.codec = MakeCodecPointer(info, (type == AVMEDIA_TYPE_VIDEO));
 	if (!result.codec) {
 		return result;
 	}
@@ -361,6 +361,10 @@ bool File::isRemoteLoader() const {
 	return _reader.isRemoteLoader();
 }
 
+void File::fillStatistics(Statistics &statistics) const {
+	_reader.fillStatistics(statistics);
+}
+
 File::~File() {
 	stop();
 }
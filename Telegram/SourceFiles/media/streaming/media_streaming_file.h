@@ -37,6 +37,9 @@ public:
 
 	[[nodiscard]] bool isRemoteLoader() const;
 
+	// Thread-safe.
+	void fillStatistics(Statistics &statistics) const;
+
 	~File();
 
 private:
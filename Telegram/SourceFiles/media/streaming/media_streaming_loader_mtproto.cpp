@@ -7,13 +7,17 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "media/streaming/media_streaming_loader_mtproto.h"
 
 #include "apiwrap.h"
+#include "auth_session.h"
+#include "storage/file_download.h"
 #include "storage/cache/storage_cache_types.h"
 
 namespace Media {
 namespace Streaming {
 namespace {
 
-constexpr auto kMaxConcurrentRequests = 2;
+// The window follows the one the downloader adapted for this dc.
+constexpr auto kMinConcurrentRequests = 2;
+constexpr auto kMaxConcurrentRequests = 16;
 constexpr auto kDocumentBaseCacheTag = 0x0000000000010000ULL;
 constexpr auto kDocumentBaseCacheMask = 0x000000000000FF00ULL;
 
@@ -29,7 +33,22 @@ LoaderMtproto::LoaderMtproto(
 , _dcId(dcId)
 , _location(location)
 , _size(size)
-, _origin(origin) {
+, _origin(origin)
+, _downloader(&Auth().downloader()) {
+	_downloader->documentPartsLoaded(
+	) | rpl::start_with_next([=](const Storage::DocumentPartLoaded &part) {
+		if (part.documentId == documentId()) {
+			partLoadedElsewhere(part.offset, part.bytes);
+		}
+	}, _lifetime);
+}
+
+uint64 LoaderMtproto::documentId() const {
+	return _location.match([&](const MTPDinputDocumentFileLocation &data) {
+		return data.vid.v;
+	}, [](auto &&) -> uint64 {
+		Unexpected("Not implemented file location type.");
+	});
 }
 
 std::optional<Storage::Cache::Key> LoaderMtproto::baseCacheKey() const {
@@ -63,18 +82,20 @@ void LoaderMtproto::load(int offset) {
 
 void LoaderMtproto::stop() {
 	crl::on_main(this, [=] {
-		ranges::for_each(
-			base::take(_requests),
-			_sender.requestCanceller(),
-			&base::flat_map<int, mtpRequestId>::value_type::second);
+		const auto requests = base::take(_requests);
+		for (const auto &request : requests | ranges::view::values) {
+			_sender.request(request.id).cancel();
+			finishRequest(request);
+		}
 		_requested.clear();
 	});
 }
 
 void LoaderMtproto::cancel(int offset) {
 	crl::on_main(this, [=] {
-		if (const auto requestId = _requests.take(offset)) {
-			_sender.request(*requestId).cancel();
+		if (const auto request = _requests.take(offset)) {
+			_sender.request(request->id).cancel();
+			finishRequest(*request);
 			sendNext();
 		} else {
 			_requested.remove(offset);
@@ -88,8 +109,22 @@ void LoaderMtproto::increasePriority() {
 	});
 }
 
+int LoaderMtproto::maxConcurrentRequests() const {
+	return snap(
+		int(_downloader->inFlightLimit(_dcId) / kPartSize),
+		kMinConcurrentRequests,
+		kMaxConcurrentRequests);
+}
+
+void LoaderMtproto::finishRequest(const Request &request) {
+	_downloader->requestedAmountIncrement(
+		_dcId,
+		request.dcIndex,
+		-kPartSize);
+}
+
 void LoaderMtproto::sendNext() {
-	if (_requests.size() >= kMaxConcurrentRequests) {
+	if (int(_requests.size()) >= maxConcurrentRequests()) {
 		return;
 	}
 	const auto offset = _requested.take().value_or(-1);
@@ -97,7 +132,7 @@ void LoaderMtproto::sendNext() {
 		return;
 	}
 
-	static auto DcIndex = 0;
+	const auto dcIndex = _downloader->chooseDcIndexForRequest(_dcId);
 	const auto reference = locationFileReference();
 	const auto id = _sender.request(MTPupload_GetFile(
 		_location,
@@ -108,16 +143,23 @@ void LoaderMtproto::sendNext() {
 	}).fail([=](const RPCError &error) {
 		requestFailed(offset, error, reference);
 	}).toDC(
-		MTP::downloadDcId(_dcId, (++DcIndex) % MTP::kDownloadSessionsCount)
+		MTP::downloadDcId(_dcId, dcIndex)
 	).send();
-	_requests.emplace(offset, id);
+	_requests.emplace(offset, Request{ id, dcIndex, crl::now() });
+	_downloader->requestedAmountIncrement(_dcId, dcIndex, kPartSize);
 
 	sendNext();
 }
 
 void LoaderMtproto::requestDone(int offset, const MTPupload_File &result) {
 	result.match([&](const MTPDupload_file &data) {
-		_requests.erase(offset);
+		if (const auto request = _requests.take(offset)) {
+			finishRequest(*request);
+			_downloader->partLoaded(
+				_dcId,
+				data.vbytes.v.size(),
+				request->sent);
+		}
 		sendNext();
 		_parts.fire({ offset, data.vbytes.v });
 	}, [&](const MTPDupload_fileCdnRedirect &data) {
@@ -168,10 +210,12 @@ void LoaderMtproto::requestFailed(
 					MTP_long(location.vaccess_hash.v),
 					MTP_bytes(reference));
 			}
-			if (!_requests.take(offset)) {
+			const auto request = _requests.take(offset);
+			if (!request) {
 				// Request with such offset was already cancelled.
 				return;
 			}
+			finishRequest(*request);
 			_requested.add(offset);
 			sendNext();
 		}, [](auto &&) {
@@ -181,6 +225,34 @@ void LoaderMtproto::requestFailed(
 	_api->refreshFileReference(_origin, crl::guard(this, callback));
 }
 
+void LoaderMtproto::partLoadedElsewhere(
+		int offset,
+		bytes::const_span bytes) {
+	// Full downloads use larger parts, aligned to our part size.
+	const auto till = offset + int(bytes.size());
+	auto from = ((offset + kPartSize - 1) / kPartSize) * kPartSize;
+	for (; from < till; from += kPartSize) {
+		const auto length = std::min(kPartSize, till - from);
+		if (length != kPartSize && from + length != _size) {
+			break;
+		}
+		if (const auto request = _requests.take(from)) {
+			_sender.request(request->id).cancel();
+			finishRequest(*request);
+		} else if (!_requested.remove(from)) {
+			continue;
+		}
+		const auto part = bytes.subspan(from - offset, length);
+		_parts.fire({
+			from,
+			QByteArray(
+				reinterpret_cast<const char*>(part.data()),
+				part.size())
+		});
+	}
+	sendNext();
+}
+
 QByteArray LoaderMtproto::locationFileReference() const {
 	return _location.match([&](const MTPDinputDocumentFileLocation &data) {
 		return data.vfile_reference.v;
@@ -193,7 +265,11 @@ rpl::producer<LoadedPart> LoaderMtproto::parts() const {
 	return _parts.events();
 }
 
-LoaderMtproto::~LoaderMtproto() = default;
+LoaderMtproto::~LoaderMtproto() {
+	for (const auto &request : _requests | ranges::view::values) {
+		finishRequest(request);
+	}
+}
 
 } // namespace Streaming
 } // namespace Media
@@ -12,6 +12,10 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 class ApiWrap;
 
+namespace Storage {
+class Downloader;
+} // namespace Storage
+
 namespace Media {
 namespace Streaming {
 
@@ -39,7 +43,17 @@ public:
 	~LoaderMtproto();
 
 private:
+	struct Request {
+		mtpRequestId id = 0;
+		int dcIndex = 0;
+		crl::time sent = 0;
+	};
+
+	[[nodiscard]] uint64 documentId() const;
+	[[nodiscard]] int maxConcurrentRequests() const;
 	void sendNext();
+	void finishRequest(const Request &request);
+	void partLoadedElsewhere(int offset, bytes::const_span bytes);
 
 	void requestDone(int offset, const MTPupload_File &result);
 	void requestFailed(
@@ -64,12 +78,14 @@ private:
 
 	const int _size = 0;
 	const Data::FileOrigin _origin;
+	const not_null<Storage::Downloader*> _downloader;
 
 	MTP::Sender _sender;
 
 	PriorityQueue _requested;
-	base::flat_map<int, mtpRequestId> _requests;
+	base::flat_map<int, Request> _requests;
 	rpl::event_stream<LoadedPart> _parts;
+	rpl::lifetime _lifetime;
 
 };
 
@@ -10,6 +10,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "media/streaming/media_streaming_loader.h"
 #include "media/streaming/media_streaming_audio_track.h"
 #include "media/streaming/media_streaming_video_track.h"
+#include "media/streaming/media_streaming_utility.h"
 #include "media/audio/media_audio.h" // for SupportsSpeedControl()
 #include "data/data_document.h" // for DocumentData::duration()
 #include "core/sandbox.h" // for widgetUpdateRequests() producer
@@ -80,6 +81,7 @@ Player::Player(
 	not_null<Data::Session*> owner,
 	std::unique_ptr<Loader> loader)
 : _file(std::make_unique<File>(owner, std::move(loader)))
+, _seekPreviews(std::make_shared<SeekPreviews>())
 , _remoteLoader(_file->isRemoteLoader())
 , _renderFrameTimer([=] { checkNextFrameRender(); }) {
 }
@@ -262,6 +264,7 @@ bool Player::fileReady(Stream &&video, Stream &&audio) {
 			_options,
 			std::move(video),
 			_audioId,
+			_seekPreviews,
 			ready,
 			error);
 	} else if (video.index >= 0) {
@@ -473,6 +476,7 @@ void Player::play(const PlaybackOptions &options) {
 		_options.speed = 1.;
 	}
 	_stage = Stage::Initializing;
+	_playRequestedTime = crl::now();
 	_file->start(delegate(), _options.position);
 }
 
@@ -608,15 +612,27 @@ bool Player::receivedTillEnd() const {
 void Player::checkResumeFromWaitingForData() {
 	if (_pausedByWaitingForData && bothReceivedEnough(kBufferFor)) {
 		_pausedByWaitingForData = false;
+		finishWaitingStatistics();
 		updatePausedState();
 		_updates.fire({ WaitingForData{ false } });
 	}
 }
 
+void Player::finishWaitingStatistics() {
+	if (_waitingStartedTime != kTimeUnknown) {
+		_statistics.waitingDuration += crl::now() - _waitingStartedTime;
+		_waitingStartedTime = kTimeUnknown;
+	}
+}
+
 void Player::start() {
 	Expects(_stage == Stage::Ready);
 
 	_stage = Stage::Started;
+	if (_playRequestedTime != kTimeUnknown) {
+		_statistics.startLatency = crl::now() - _playRequestedTime;
+		_playRequestedTime = kTimeUnknown;
+	}
 	const auto guard = base::make_weak(&_sessionGuard);
 
 	rpl::merge(
@@ -626,6 +642,8 @@ void Player::start() {
 		return !bothReceivedEnough(kBufferFor);
 	}) | rpl::start_with_next([=] {
 		_pausedByWaitingForData = true;
+		++_statistics.waitingCount;
+		_waitingStartedTime = crl::now();
 		updatePausedState();
 		_updates.fire({ WaitingForData{ true } });
 	}, _sessionLifetime);
@@ -684,6 +702,10 @@ void Player::stop() {
 	_file->stop();
 	_sessionLifetime = rpl::lifetime();
 	_stage = Stage::Uninitialized;
+	finishWaitingStatistics();
+	if (_video) {
+		_video->fillStatistics(_statistics);
+	}
 	_audio = nullptr;
 	_video = nullptr;
 	invalidate_weak_ptrs(&_sessionGuard);
@@ -762,6 +784,10 @@ QImage Player::frame(const FrameRequest &request) const {
 	return _video->frame(request);
 }
 
+SeekPreviews::Preview Player::seekPreview(crl::time position) const {
+	return _seekPreviews->find(position);
+}
+
 Media::Player::TrackState Player::prepareLegacyState() const {
 	using namespace Media::Player;
 
@@ -803,6 +829,22 @@ Media::Player::TrackState Player::prepareLegacyState() const {
 	return result;
 }
 
+Statistics Player::statistics() const {
+	auto result = _statistics;
+	_file->fillStatistics(result);
+	if (_video) {
+		_video->fillStatistics(result);
+	}
+	if (_waitingStartedTime != kTimeUnknown) {
+		result.waitingDuration += crl::now() - _waitingStartedTime;
+	}
+	const auto duration = computeTotalDuration();
+	if (duration > 0 && duration != kDurationUnavailable) {
+		result.streamPerSecond = result.fileSize * 1000 / duration;
+	}
+	return result;
+}
+
 crl::time Player::getCurrentReceivedTill(crl::time duration) const {
 	const auto forTrack = [&](const TrackState &state) {
 		return (state.duration > 0 && state.receivedTill == state.duration)
@@ -831,6 +873,11 @@ Player::~Player() {
 	// So instead of maintaining it in the class definition as well we
 	// simply call stop() here, after that the destruction is trivial.
 	stop();
+
+	if (_statistics.startLatency != kTimeUnknown) {
+		DEBUG_LOG(("Streaming Info: %1"
+			).arg(StatisticsText(statistics(), ", ")));
+	}
 }
 
 } // namespace Streaming
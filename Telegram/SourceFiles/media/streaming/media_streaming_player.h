@@ -8,6 +8,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include "media/streaming/media_streaming_common.h"
 #include "media/streaming/media_streaming_file_delegate.h"
+#include "media/streaming/media_streaming_seek_previews.h"
 #include "base/weak_ptr.h"
 #include "base/timer.h"
 
@@ -58,9 +59,14 @@ public:
 	[[nodiscard]] rpl::producer<Update, Error> updates() const;
 
 	[[nodiscard]] QImage frame(const FrameRequest &request) const;
+
+	// Keyframe near the position that was already shown in this player.
+	[[nodiscard]] SeekPreviews::Preview seekPreview(
+		crl::time position) const;
 	//[[nodiscard]] int videoRotation() const;
 
 	[[nodiscard]] Media::Player::TrackState prepareLegacyState() const;
+	[[nodiscard]] Statistics statistics() const;
 
 	[[nodiscard]] rpl::lifetime &lifetime();
 
@@ -106,6 +112,7 @@ private:
 	[[nodiscard]] bool bothReceivedEnough(crl::time amount) const;
 	[[nodiscard]] bool receivedTillEnd() const;
 	void checkResumeFromWaitingForData();
+	void finishWaitingStatistics();
 	[[nodiscard]] crl::time getCurrentReceivedTill(crl::time duration) const;
 	void savePreviousReceivedTill(
 		const PlaybackOptions &options,
@@ -140,6 +147,9 @@ private:
 
 	const std::unique_ptr<File> _file;
 
+	// Kept between play() calls, filled by the video track queue.
+	const std::shared_ptr<SeekPreviews> _seekPreviews;
+
 	// Immutable while File is active after it is ready.
 	AudioMsgId _audioId;
 	std::unique_ptr<AudioTrack> _audio;
@@ -175,6 +185,11 @@ private:
 	base::Timer _renderFrameTimer;
 	rpl::event_stream<Update, Error> _updates;
 
+	// Counters of the already stopped tracks are accumulated here.
+	Statistics _statistics;
+	crl::time _playRequestedTime = kTimeUnknown;
+	crl::time _waitingStartedTime = kTimeUnknown;
+
 	crl::time _totalDuration = kTimeUnknown;
 	crl::time _loopingShift = 0;
 	crl::time _previousReceivedTill = kTimeUnknown;
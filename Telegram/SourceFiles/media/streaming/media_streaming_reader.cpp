@@ -27,8 +27,12 @@ constexpr auto kSlicesInMemory = 2;
 // put the whole first slice of the file in the header cache entry.
 //constexpr auto kMaxOutsideHeaderPartsForOptimizedMode = 8;
 
-// 1 MB of parts are requested from cloud ahead of reading demand.
-constexpr auto kPreloadPartsAhead = 8;
+// From 1 MB to half a slice of parts are requested from cloud ahead of
+// reading demand, enough for a few seconds of the stream to be read.
+constexpr auto kMinPreloadPartsAhead = 8;
+constexpr auto kMaxPreloadPartsAhead = kPartsInSlice / 2;
+constexpr auto kPreloadSecondsAhead = 4;
+constexpr auto kPreloadMeasureInterval = crl::time(1000);
 
 bool IsContiguousSerialization(int serializedSize, int maxSliceSize) {
 	return !(serializedSize % kPartSize) || (serializedSize == maxSliceSize);
@@ -201,14 +205,14 @@ void Reader::Slice::addPart(int offset, QByteArray bytes) {
 	}
 }
 
-auto Reader::Slice::prepareFill(int from, int till) -> PrepareFillResult {
+auto Reader::Slice::prepareFill(int from, int till, int preloadParts)
+-> PrepareFillResult {
 	auto result = PrepareFillResult();
 
 	result.ready = false;
 	const auto fromOffset = (from / kPartSize) * kPartSize;
 	const auto tillPart = (till + kPartSize - 1) / kPartSize;
-	const auto preloadTillOffset = (tillPart + kPreloadPartsAhead)
-		* kPartSize;
+	const auto preloadTillOffset = (tillPart + preloadParts) * kPartSize;
 
 	const auto after = ranges::upper_bound(
 		parts,
@@ -416,7 +420,8 @@ void Reader::Slices::processPart(
 	_data[index].addPart(offset - index * kInSlice, std::move(bytes));
 }
 
-auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
+auto Reader::Slices::fill(int offset, bytes::span buffer, int preloadParts)
+-> FillResult {
 	Expects(!buffer.empty());
 	Expects(offset >= 0 && offset < _size);
 	Expects(offset + buffer.size() <= _size);
@@ -430,7 +435,7 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 		Assert(_header.flags & Flag::LoadingFromCache);
 		return {};
 	} else if (isFullInHeader()) {
-		return fillFromHeader(offset, buffer);
+		return fillFromHeader(offset, buffer, preloadParts);
 	}
 
 	auto result = FillResult();
@@ -470,9 +475,15 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 	const auto firstTill = std::min(kInSlice, till - fromSlice * kInSlice);
 	const auto secondFrom = 0;
 	const auto secondTill = till - (fromSlice + 1) * kInSlice;
-	const auto first = _data[fromSlice].prepareFill(firstFrom, firstTill);
+	const auto first = _data[fromSlice].prepareFill(
+		firstFrom,
+		firstTill,
+		preloadParts);
 	const auto second = (fromSlice + 1 < tillSlice)
-		? _data[fromSlice + 1].prepareFill(secondFrom, secondTill)
+		? _data[fromSlice + 1].prepareFill(
+			secondFrom,
+			secondTill,
+			preloadParts)
 		: Slice::PrepareFillResult();
 	handlePrepareResult(fromSlice, first);
 	if (fromSlice + 1 < tillSlice) {
@@ -504,13 +515,16 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 	return result;
 }
 
-auto Reader::Slices::fillFromHeader(int offset, bytes::span buffer)
+auto Reader::Slices::fillFromHeader(
+		int offset,
+		bytes::span buffer,
+		int preloadParts)
 -> FillResult {
 	auto result = FillResult();
 	const auto from = offset;
 	const auto till = int(offset + buffer.size());
 
-	const auto prepared = _header.prepareFill(from, till);
+	const auto prepared = _header.prepareFill(from, till, preloadParts);
 	for (const auto full : prepared.offsetsFromLoader.values()) {
 		if (full < _size) {
 			result.offsetsFromLoader.add(full);
@@ -699,6 +713,14 @@ bool Reader::isRemoteLoader() const {
 	return _loader->baseCacheKey().has_value();
 }
 
+void Reader::fillStatistics(Statistics &statistics) const {
+	statistics.fileSize = size();
+	statistics.slicesFromCache += _slicesFromCache.load();
+	statistics.slicesNotInCache += _slicesNotInCache.load();
+	statistics.loadedBytes += _loadedBytes.load();
+	statistics.loadPerSecond = _loadPerSecond.load();
+}
+
 std::shared_ptr<Reader::CacheHelper> Reader::InitCacheHelper(
 		std::optional<Storage::Cache::Key> baseKey) {
 	if (!baseKey) {
@@ -717,7 +739,7 @@ void Reader::readFromCache(int sliceNumber) {
 	}
 	const auto key = _cacheHelper->key(sliceNumber);
 	const auto weak = std::weak_ptr<CacheHelper>(_cacheHelper);
-	_owner->cacheBigFile().get(key, [=](QByteArray &&result) {
+	const auto done = [=](QByteArray &&result) {
 		if (const auto strong = weak.lock()) {
 			QMutexLocker lock(&strong->mutex);
 			strong->results.emplace(sliceNumber, std::move(result));
@@ -726,7 +748,13 @@ void Reader::readFromCache(int sliceNumber) {
 				waiting->release();
 			}
 		}
-	});
+	};
+	auto &cache = _owner->cacheBigFile();
+	if (!cache.mayContain(key)) {
+		done(QByteArray());
+		return;
+	}
+	cache.get(key, done);
 }
 
 void Reader::putToCache(SerializedSlice &&slice) {
@@ -787,6 +815,7 @@ bool Reader::fill(
 	do {
 		if (fillFromSlices(offset, buffer)) {
 			clearWaiting();
+			countRead(offset, buffer.size());
 			return true;
 		}
 		startWaiting();
@@ -798,7 +827,7 @@ bool Reader::fill(
 bool Reader::fillFromSlices(int offset, bytes::span buffer) {
 	using namespace rpl::mappers;
 
-	auto result = _slices.fill(offset, buffer);
+	auto result = _slices.fill(offset, buffer, _prefetch.parts);
 	if (!result.filled && _slices.headerWontBeFilled()) {
 		_failed = Error::NotStreamable;
 		return false;
@@ -855,6 +884,7 @@ bool Reader::processCacheResults() {
 	lock.unlock();
 
 	for (const auto &[sliceNumber, result] : loaded) {
+		++(result.isEmpty() ? _slicesNotInCache : _slicesFromCache);
 		_slices.processCacheResult(sliceNumber, bytes::make_span(result));
 	}
 	return !loaded.empty();
@@ -878,6 +908,7 @@ bool Reader::processLoadedParts() {
 		} else if (!_loadingOffsets.remove(part.offset)) {
 			continue;
 		}
+		countLoaded(part.bytes.size());
 		_slices.processPart(
 			part.offset,
 			std::move(part.bytes));
@@ -885,6 +916,60 @@ bool Reader::processLoadedParts() {
 	return !loaded.empty();
 }
 
+void Reader::countRead(int offset, int size) {
+	const auto now = crl::now();
+	auto &prefetch = _prefetch;
+	if (offset != prefetch.readTill) {
+		// A seek, the reading speed before it says nothing.
+		prefetch.readStart = now;
+		prefetch.readBytes = 0;
+	}
+	prefetch.readTill = offset + size;
+	prefetch.readBytes += size;
+	if (now - prefetch.readStart >= kPreloadMeasureInterval) {
+		prefetch.readPerSecond = prefetch.readBytes
+			* 1000
+			/ (now - prefetch.readStart);
+		prefetch.readStart = now;
+		prefetch.readBytes = 0;
+		updatePreloadParts();
+	}
+}
+
+void Reader::countLoaded(int size) {
+	const auto now = crl::now();
+	auto &prefetch = _prefetch;
+	if (!prefetch.loadStart) {
+		prefetch.loadStart = now;
+	}
+	prefetch.loadBytes += size;
+	_loadedBytes += size;
+	if (now - prefetch.loadStart >= kPreloadMeasureInterval) {
+		prefetch.loadPerSecond = prefetch.loadBytes
+			* 1000
+			/ (now - prefetch.loadStart);
+		_loadPerSecond = prefetch.loadPerSecond;
+		prefetch.loadStart = now;
+		prefetch.loadBytes = 0;
+		updatePreloadParts();
+	}
+}
+
+void Reader::updatePreloadParts() {
+	auto &prefetch = _prefetch;
+	const auto ahead = prefetch.readPerSecond * kPreloadSecondsAhead;
+	auto parts = int((ahead + kPartSize - 1) / kPartSize);
+	if (prefetch.loadPerSecond > 0
+		&& prefetch.loadPerSecond < prefetch.readPerSecond * 3 / 2) {
+		// The network barely keeps up with the stream, buffer more.
+		parts *= 2;
+	}
+	prefetch.parts = std::clamp(
+		parts,
+		kMinPreloadPartsAhead,
+		kMaxPreloadPartsAhead);
+}
+
 void Reader::loadAtOffset(int offset) {
 	if (_loadingOffsets.add(offset)) {
 		_loader->load(offset);
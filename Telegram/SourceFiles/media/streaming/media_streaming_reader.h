@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "media/streaming/media_streaming_loader.h"
+#include "media/streaming/media_streaming_common.h"
 #include "base/bytes.h"
 
 namespace Storage {
@@ -43,6 +44,9 @@ public:
 
 	[[nodiscard]] bool isRemoteLoader() const;
 
+	// Thread-safe.
+	void fillStatistics(Statistics &statistics) const;
+
 	~Reader();
 
 private:
@@ -50,6 +54,18 @@ private:
 
 	struct CacheHelper;
 
+	// Read-ahead sized by the stream reading and the loading speeds.
+	struct Prefetch {
+		int parts = 8; // kMinPreloadPartsAhead
+		int readTill = -1;
+		int readBytes = 0;
+		crl::time readStart = 0;
+		int64 readPerSecond = 0;
+		int loadBytes = 0;
+		crl::time loadStart = 0;
+		int64 loadPerSecond = 0;
+	};
+
 	template <int Size>
 	class StackIntVector {
 	public:
@@ -97,7 +113,7 @@ private:
 			bytes::const_span data,
 			int maxSize);
 		void addPart(int offset, QByteArray bytes);
-		PrepareFillResult prepareFill(int from, int till);
+		PrepareFillResult prepareFill(int from, int till, int preloadParts);
 
 		// Get up to kLoadFromRemoteMax not loaded parts in from-till range.
 		StackIntVector<kLoadFromRemoteMax> offsetsFromLoader(
@@ -122,7 +138,10 @@ private:
 		void processCacheResult(int sliceNumber, bytes::const_span result);
 		void processPart(int offset, QByteArray &&bytes);
 
-		[[nodiscard]] FillResult fill(int offset, bytes::span buffer);
+		[[nodiscard]] FillResult fill(
+			int offset,
+			bytes::span buffer,
+			int preloadParts);
 		[[nodiscard]] SerializedSlice unloadToCache();
 
 	private:
@@ -146,7 +165,8 @@ private:
 		[[nodiscard]] bool computeIsGoodHeader() const;
 		[[nodiscard]] FillResult fillFromHeader(
 			int offset,
-			bytes::span buffer);
+			bytes::span buffer,
+			int preloadParts);
 
 		std::vector<Slice> _data;
 		Slice _header;
@@ -167,6 +187,9 @@ private:
 	bool processLoadedParts();
 
 	bool fillFromSlices(int offset, bytes::span buffer);
+	void countRead(int offset, int size);
+	void countLoaded(int size);
+	void updatePreloadParts();
 
 	void finalizeCache();
 
@@ -183,7 +206,15 @@ private:
 	PriorityQueue _loadingOffsets;
 
 	Slices _slices;
+	Prefetch _prefetch;
 	std::optional<Error> _failed;
+
+	// Written from the File thread, read in fillStatistics().
+	std::atomic<int> _slicesFromCache = 0;
+	std::atomic<int> _slicesNotInCache = 0;
+	std::atomic<int64> _loadedBytes = 0;
+	std::atomic<int64> _loadPerSecond = 0;
+
 	rpl::lifetime _lifetime;
 
 };
@@ -0,0 +1,73 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "media/streaming/media_streaming_seek_previews.h"
+
+namespace Media {
+namespace Streaming {
+namespace {
+
+constexpr auto kPreviewWidth = 160;
+constexpr auto kPreviewsMax = 96;
+constexpr auto kPreviewMinDistance = crl::time(2000);
+constexpr auto kPreviewMaxDistance = crl::time(5000);
+
+} // namespace
+
+bool SeekPreviews::wanted(crl::time position) const {
+	QMutexLocker lock(&_mutex);
+	const auto i = _frames.lower_bound(position);
+	if (i != end(_frames) && i->first - position < kPreviewMinDistance) {
+		return false;
+	} else if (i != begin(_frames)
+		&& position - (i - 1)->first < kPreviewMinDistance) {
+		return false;
+	}
+	return true;
+}
+
+void SeekPreviews::add(crl::time position, const QImage &frame) {
+	if (frame.isNull()) {
+		return;
+	}
+	auto scaled = (frame.width() > kPreviewWidth)
+		? frame.scaledToWidth(kPreviewWidth, Qt::SmoothTransformation)
+		: frame.copy();
+
+	QMutexLocker lock(&_mutex);
+	if (_frames.size() >= kPreviewsMax) {
+		// Drop the preview that is the closest one to its neighbour.
+		auto closest = begin(_frames) + 1;
+		for (auto i = closest + 1; i != end(_frames); ++i) {
+			if (i->first - (i - 1)->first
+				< closest->first - (closest - 1)->first) {
+				closest = i;
+			}
+		}
+		_frames.erase(closest);
+	}
+	_frames.emplace(position, std::move(scaled));
+}
+
+auto SeekPreviews::find(crl::time position) const -> Preview {
+	QMutexLocker lock(&_mutex);
+	if (_frames.empty()) {
+		return Preview();
+	}
+	auto i = _frames.lower_bound(position);
+	if (i == end(_frames)
+		|| (i != begin(_frames)
+			&& position - (i - 1)->first < i->first - position)) {
+		--i;
+	}
+	if (std::abs(i->first - position) > kPreviewMaxDistance) {
+		return Preview();
+	}
+	return { i->first, i->second };
+}
+
+} // namespace Streaming
+} // namespace Media
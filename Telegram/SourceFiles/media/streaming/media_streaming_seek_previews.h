@@ -0,0 +1,39 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "media/streaming/media_streaming_common.h"
+
+#include <QtCore/QMutex>
+
+namespace Media {
+namespace Streaming {
+
+// Small copies of the keyframes that were already decoded for playback.
+// They are shown while the user drags the seek slider.
+class SeekPreviews final {
+public:
+	struct Preview {
+		crl::time position = kTimeUnknown;
+		QImage frame;
+	};
+
+	// Called from the video track queue.
+	[[nodiscard]] bool wanted(crl::time position) const;
+	void add(crl::time position, const QImage &frame);
+
+	// Thread-safe.
+	[[nodiscard]] Preview find(crl::time position) const;
+
+private:
+	mutable QMutex _mutex;
+	base::flat_map<crl::time, QImage> _frames;
+
+};
+
+} // namespace Streaming
+} // namespace Media
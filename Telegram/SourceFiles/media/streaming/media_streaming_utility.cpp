@@ -11,8 +11,14 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 extern "C" {
 #include <libavutil/opt.h>
+#include <libavutil/hwcontext.h>
 } // extern "C"
 
+// Hardware decoding through a device context needs FFmpeg 4.0.
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 0, 0)
+#define TDESKTOP_HARDWARE_DECODING
+#endif // libavcodec >= 58.0.0
+
 namespace Media {
 namespace Streaming {
 namespace {
@@ -22,11 +28,169 @@ constexpr auto kAlignImageBy = 16;
 constexpr auto kPixelBytesSize = 4;
 constexpr auto kImageFormat = QImage::Format_ARGB32_Premultiplied;
 constexpr auto kAvioBlockSize = 4096;
+constexpr auto kFramePoolMaxBytes = 64 * 1024 * 1024;
+constexpr auto kFramePoolMaxPerSize = 8;
 constexpr auto kMaxScaleByAspectRatio = 16;
 
+// Smaller videos and animations are cheap to decode in software, while
+// hardware decoder sessions are a limited resource.
+constexpr auto kHardwareDecodingMinArea = 1280 * 720;
+
+#ifdef TDESKTOP_HARDWARE_DECODING
+const auto kHardwareDeviceTypes = {
+#if defined Q_OS_WIN
+	AV_HWDEVICE_TYPE_D3D11VA,
+	AV_HWDEVICE_TYPE_DXVA2,
+#elif defined Q_OS_MAC // Q_OS_WIN
+	AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#else // Q_OS_WIN || Q_OS_MAC
+	AV_HWDEVICE_TYPE_VAAPI,
+#endif // Q_OS_WIN || Q_OS_MAC
+};
+
+AVPixelFormat GetHardwareFormat(
+		AVCodecContext *context,
+		const AVPixelFormat *formats) {
+	const auto wanted = AVPixelFormat(
+		reinterpret_cast<intptr_t>(context->opaque));
+	for (auto format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+		if (*format == wanted) {
+			return wanted;
+		}
+	}
+	// Fall back to software decoding for this stream.
+	return avcodec_default_get_format(context, formats);
+}
+
+bool InitHardwareDecoding(
+		not_null<AVCodecContext*> context,
+		not_null<const AVCodec*> codec) {
+	for (const auto type : kHardwareDeviceTypes) {
+		for (auto i = 0;; ++i) {
+			const auto config = avcodec_get_hw_config(codec, i);
+			if (!config) {
+				break;
+			} else if (config->device_type != type
+				|| !(config->methods
+					& AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)) {
+				continue;
+			}
+			auto device = (AVBufferRef*)nullptr;
+			if (av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0)) {
+				break;
+			}
+			context->hw_device_ctx = device;
+			context->opaque = reinterpret_cast<void*>(
+				intptr_t(config->pix_fmt));
+			context->get_format = GetHardwareFormat;
+			return true;
+		}
+	}
+	return false;
+}
+#endif // TDESKTOP_HARDWARE_DECODING
+
+bool HardwareDecodingWanted(not_null<AVStream*> stream, bool allowed) {
+	const auto parameters = stream->codecpar;
+	return allowed
+		&& (parameters->codec_type == AVMEDIA_TYPE_VIDEO)
+		&& (parameters->width * parameters->height
+			>= kHardwareDecodingMinArea);
+}
+
+AvErrorWrap TransferHardwareFrame(Stream &stream) {
+#ifdef TDESKTOP_HARDWARE_DECODING
+	if (!stream.transferFrame) {
+		stream.transferFrame = MakeFramePointer();
+	}
+	const auto hardware = stream.frame.get();
+	const auto software = stream.transferFrame.get();
+
+	// The only copy from the GPU, the frame is converted to QImage anyway.
+	auto error = AvErrorWrap(av_hwframe_transfer_data(software, hardware, 0));
+	if (error) {
+		LogError(qstr("av_hwframe_transfer_data"), error);
+		return error;
+	}
+	av_frame_copy_props(software, hardware);
+	ClearFrameMemory(hardware);
+	std::swap(stream.frame, stream.transferFrame);
+#endif // TDESKTOP_HARDWARE_DECODING
+	return AvErrorWrap();
+}
+
+// Frame buffers of the recently used sizes, shared by all the players
+// and animations, so that a steady playback doesn't allocate at all.
+// Buffers are returned from any thread when the last QImage dies.
+class FramePool final {
+public:
+	struct Buffer {
+		std::unique_ptr<uchar[]> bytes;
+		int size = 0;
+	};
+
+	[[nodiscard]] Buffer *take(int size);
+	void release(Buffer *buffer);
+
+private:
+	QMutex _mutex;
+	base::flat_map<int, std::vector<std::unique_ptr<Buffer>>> _free;
+	int64 _freeBytes = 0;
+
+};
+
+auto FramePool::take(int size) -> Buffer* {
+	{
+		QMutexLocker lock(&_mutex);
+		const auto i = _free.find(size);
+		if (i != end(_free) && !i->second.empty()) {
+			auto result = std::move(i->second.back());
+			i->second.pop_back();
+			_freeBytes -= size;
+			return result.release();
+		}
+	}
+	auto result = std::make_unique<Buffer>();
+	result->bytes = std::unique_ptr<uchar[]>(new uchar[size]);
+	result->size = size;
+	return result.release();
+}
+
+void FramePool::release(Buffer *buffer) {
+	auto owned = std::unique_ptr<Buffer>(buffer);
+	auto stale = std::vector<std::unique_ptr<Buffer>>();
+
+	QMutexLocker lock(&_mutex);
+	if (_freeBytes + buffer->size > kFramePoolMaxBytes) {
+		// Sizes were changed, drop the buffers nobody asks for any more.
+		for (auto i = begin(_free); i != end(_free);) {
+			if (i->first == buffer->size) {
+				++i;
+				continue;
+			}
+			for (auto &other : i->second) {
+				_freeBytes -= other->size;
+				stale.push_back(std::move(other));
+			}
+			i = _free.erase(i);
+		}
+	}
+	auto &list = _free[buffer->size];
+	if (_freeBytes + buffer->size <= kFramePoolMaxBytes
+		&& int(list.size()) < kFramePoolMaxPerSize) {
+		_freeBytes += buffer->size;
+		list.push_back(std::move(owned));
+	}
+}
+
+[[nodiscard]] FramePool &Pool() {
+	// Never destroyed, frames may outlive all the static objects.
+	static const auto result = new FramePool();
+	return *result;
+}
+
 void AlignedImageBufferCleanupHandler(void* data) {
-	const auto buffer = static_cast<uchar*>(data);
-	delete[] buffer;
+	Pool().release(static_cast<FramePool::Buffer*>(data));
 }
 
 [[nodiscard]] bool IsAlignedImage(const QImage &image) {
@@ -52,6 +216,7 @@ bool GoodStorageForFrame(const QImage &storage, QSize size) {
 }
 
 // Create a QImage of desired size where all the data is properly aligned.
+// The buffer is taken from the pool and returned to it with the image.
 QImage CreateFrameStorage(QSize size) {
 	const auto width = size.width();
 	const auto height = size.height();
@@ -60,8 +225,9 @@ QImage CreateFrameStorage(QSize size) {
 		? (widthAlign - (width % widthAlign))
 		: 0);
 	const auto perLine = neededWidth * kPixelBytesSize;
-	const auto buffer = new uchar[perLine * height + kAlignImageBy];
-	const auto cleanupData = static_cast<void *>(buffer);
+	const auto pooled = Pool().take(perLine * height + kAlignImageBy);
+	const auto buffer = pooled->bytes.get();
+	const auto cleanupData = static_cast<void *>(pooled);
 	const auto address = reinterpret_cast<uintptr_t>(buffer);
 	const auto alignedBuffer = buffer + ((address % kAlignImageBy)
 		? (kAlignImageBy - (address % kAlignImageBy))
@@ -152,7 +318,9 @@ void FormatDeleter::operator()(AVFormatContext *value) {
 	}
 }
 
-CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
+CodecPointer MakeCodecPointer(
+		not_null<AVStream*> stream,
+		bool hardwareAllowed) {
 	auto error = AvErrorWrap();
 
 	auto result = CodecPointer(avcodec_alloc_context3(nullptr));
@@ -173,9 +341,16 @@ CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
 	if (!codec) {
 		LogError(qstr("avcodec_find_decoder"), context->codec_id);
 		return {};
-	} else if ((error = avcodec_open2(context, codec, nullptr))) {
+	}
+	auto hardware = false;
+#ifdef TDESKTOP_HARDWARE_DECODING
+	if (HardwareDecodingWanted(stream, hardwareAllowed)) {
+		hardware = InitHardwareDecoding(context, codec);
+	}
+#endif // TDESKTOP_HARDWARE_DECODING
+	if ((error = avcodec_open2(context, codec, nullptr))) {
 		LogError(qstr("avcodec_open2"), error);
-		return {};
+		return hardware ? MakeCodecPointer(stream, false) : CodecPointer();
 	}
 	return result;
 }
@@ -256,6 +431,39 @@ void LogError(QLatin1String method) {
 	LOG(("Streaming Error: Error in %1.").arg(method));
 }
 
+QString StatisticsText(
+		const Statistics &statistics,
+		const QString &separator) {
+	const auto kb = [](int64 bytes) {
+		return QString::number(bytes / 1024) + " KB";
+	};
+	const auto decodeAverage = statistics.framesDecoded
+		? (statistics.decodeMicroseconds / statistics.framesDecoded)
+		: 0;
+	const auto slicesRead = statistics.slicesFromCache
+		+ statistics.slicesNotInCache;
+	return QStringList({
+		"start: " + ((statistics.startLatency != kTimeUnknown)
+			? QString::number(statistics.startLatency) + " ms"
+			: QString("unknown")),
+		QString("waiting: %1 times, %2 ms"
+		).arg(statistics.waitingCount
+		).arg(statistics.waitingDuration),
+		QString("loading: %1/s, stream: %2/s, loaded: %3 from %4"
+		).arg(kb(statistics.loadPerSecond)
+		).arg(kb(statistics.streamPerSecond)
+		).arg(kb(statistics.loadedBytes)
+		).arg(kb(statistics.fileSize)),
+		QString("cache: %1 of %2 slices"
+		).arg(statistics.slicesFromCache
+		).arg(slicesRead),
+		QString("frames: %1 decoded, %2 dropped, %3 us average decode"
+		).arg(statistics.framesDecoded
+		).arg(statistics.framesDropped
+		).arg(decodeAverage),
+	}).join(separator);
+}
+
 void LogError(QLatin1String method, AvErrorWrap error) {
 	LOG(("Streaming Error: Error in %1 (code: %2, text: %3)."
 		).arg(method
@@ -389,7 +597,9 @@ AvErrorWrap ReadNextFrame(Stream &stream) {
 		error = avcodec_receive_frame(
 			stream.codec.get(),
 			stream.frame.get());
-		if (!error
+		if (!error && stream.frame->hw_frames_ctx) {
+			return TransferHardwareFrame(stream);
+		} else if (!error
 			|| error.code() != AVERROR(EAGAIN)
 			|| stream.queue.empty()) {
 			return error;
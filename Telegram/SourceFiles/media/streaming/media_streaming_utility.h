@@ -139,7 +139,12 @@ struct CodecDeleter {
 	void operator()(AVCodecContext *value);
 };
 using CodecPointer = std::unique_ptr<AVCodecContext, CodecDeleter>;
-[[nodiscard]] CodecPointer MakeCodecPointer(not_null<AVStream*> stream);
+
+// Large videos are decoded in hardware if allowed and available, the
+// frames are transferred to memory in ReadNextFrame.
+[[nodiscard]] CodecPointer MakeCodecPointer(
+	not_null<AVStream*> stream,
+	bool hardwareAllowed = false);
 
 struct FrameDeleter {
 	void operator()(AVFrame *value);
@@ -178,11 +183,16 @@ struct Stream {
 	int rotation = 0;
 	AVRational aspect = kNormalAspect;
 	SwscalePointer swscale;
+	FramePointer transferFrame;
 };
 
 void LogError(QLatin1String method);
 void LogError(QLatin1String method, AvErrorWrap error);
 
+[[nodiscard]] QString StatisticsText(
+	const Statistics &statistics,
+	const QString &separator);
+
 [[nodiscard]] crl::time PtsToTime(int64_t pts, AVRational timeBase);
 // Used for full duration conversion.
 [[nodiscard]] crl::time PtsToTimeCeil(int64_t pts, AVRational timeBase);
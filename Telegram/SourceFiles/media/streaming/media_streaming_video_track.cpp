@@ -6,6 +6,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 */
 #include "media/streaming/media_streaming_video_track.h"
 
+#include "media/streaming/media_streaming_seek_previews.h"
+
 #include "media/audio/media_audio.h"
 #include "base/concurrent_timer.h"
 
@@ -30,6 +32,7 @@ public:
 		not_null<Shared*> shared,
 		Stream &&stream,
 		const AudioMsgId &audioId,
+		std::shared_ptr<SeekPreviews> seekPreviews,
 		FnMut<void(const Information &)> ready,
 		Fn<void(Error)> error);
 
@@ -86,6 +89,7 @@ private:
 
 	Stream _stream;
 	AudioMsgId _audioId;
+	const std::shared_ptr<SeekPreviews> _seekPreviews;
 	bool _readTillEnd = false;
 	FnMut<void(const Information &)> _ready;
 	Fn<void(Error)> _error;
@@ -112,6 +116,7 @@ VideoTrackObject::VideoTrackObject(
 	not_null<Shared*> shared,
 	Stream &&stream,
 	const AudioMsgId &audioId,
+	std::shared_ptr<SeekPreviews> seekPreviews,
 	FnMut<void(const Information &)> ready,
 	Fn<void(Error)> error)
 : _weak(std::move(weak))
@@ -119,6 +124,7 @@ VideoTrackObject::VideoTrackObject(
 , _shared(shared)
 , _stream(std::move(stream))
 , _audioId(audioId)
+, _seekPreviews(std::move(seekPreviews))
 , _ready(std::move(ready))
 , _error(std::move(error))
 , _readFramesTimer(_weak, [=] { readFrames(); }) {
@@ -232,6 +238,7 @@ auto VideoTrackObject::readEnoughFrames(crl::time trackTime)
 				|| !VideoTrack::IsStale(frame, trackTime)) {
 				return std::nullopt;
 			}
+			_shared->countDropped();
 		}
 	}, [&](Shared::PrepareNextCheck delay) -> ReadEnoughState {
 		return delay;
@@ -264,6 +271,7 @@ crl::time VideoTrackObject::computeDuration() const {
 }
 
 auto VideoTrackObject::readFrame(not_null<Frame*> frame) -> FrameResult {
+	const auto decodeStarted = std::chrono::steady_clock::now();
 	if (const auto error = ReadNextFrame(_stream)) {
 		if (error.code() == AVERROR_EOF) {
 			if (!_options.loop) {
@@ -289,6 +297,8 @@ auto VideoTrackObject::readFrame(not_null<Frame*> frame) -> FrameResult {
 		fail(Error::InvalidData);
 		return FrameResult::Error;
 	}
+	_shared->countDecoded(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - decodeStarted).count());
 	std::swap(frame->decoded, _stream.frame);
 	frame->position = position;
 	frame->displayed = kTimeUnknown;
@@ -304,6 +314,9 @@ void VideoTrackObject::presentFrameIfNeeded() {
 		Expects(frame->position != kFinishedPosition);
 
 		frame->request = _request;
+
+		// ConvertFrame() clears the decoded frame data.
+		const auto keyframe = (frame->decoded->key_frame != 0);
 		frame->original = ConvertFrame(
 			_stream,
 			frame->decoded.get(),
@@ -314,6 +327,12 @@ void VideoTrackObject::presentFrameIfNeeded() {
 			fail(Error::InvalidData);
 			return;
 		}
+		if (keyframe
+			&& _seekPreviews
+			&& !_loopingShift
+			&& _seekPreviews->wanted(frame->position)) {
+			_seekPreviews->add(frame->position, frame->original);
+		}
 
 		VideoTrack::PrepareFrameByRequest(frame);
 
@@ -569,6 +588,7 @@ auto VideoTrack::Shared::prepareState(
 		} else if (IsStale(frame, trackTime)) {
 			std::swap(*frame, *next);
 			next->displayed = kDisplaySkipped;
+			countDropped();
 			return next;
 		} else {
 			return PrepareNextCheck(frame->position - trackTime + 1);
@@ -594,6 +614,21 @@ auto VideoTrack::Shared::prepareState(
 	Unexpected("Counter value in VideoTrack::Shared::prepareState.");
 }
 
+void VideoTrack::Shared::countDecoded(int64 microseconds) {
+	++_framesDecoded;
+	_decodeMicroseconds += microseconds;
+}
+
+void VideoTrack::Shared::countDropped() {
+	++_framesDropped;
+}
+
+void VideoTrack::Shared::fillStatistics(Statistics &statistics) const {
+	statistics.framesDecoded += _framesDecoded.load();
+	statistics.framesDropped += _framesDropped.load();
+	statistics.decodeMicroseconds += _decodeMicroseconds.load();
+}
+
 // Sometimes main thread subscribes to check frame requests before
 // the first frame is ready and presented and sometimes after.
 bool VideoTrack::Shared::firstPresentHappened() const {
@@ -726,6 +761,7 @@ VideoTrack::VideoTrack(
 	const PlaybackOptions &options,
 	Stream &&stream,
 	const AudioMsgId &audioId,
+	std::shared_ptr<SeekPreviews> seekPreviews,
 	FnMut<void(const Information &)> ready,
 	Fn<void(Error)> error)
 : _streamIndex(stream.index)
@@ -739,6 +775,7 @@ VideoTrack::VideoTrack(
 	_shared.get(),
 	std::move(stream),
 	audioId,
+	std::move(seekPreviews),
 	std::move(ready),
 	std::move(error)) {
 }
@@ -854,6 +891,10 @@ rpl::producer<> VideoTrack::waitingForData() const {
 	});
 }
 
+void VideoTrack::fillStatistics(Statistics &statistics) const {
+	_shared->fillStatistics(statistics);
+}
+
 VideoTrack::~VideoTrack() {
 	_wrapped.with([shared = std::move(_shared)](Implementation &unwrapped) {
 		unwrapped.interrupt();
@@ -14,6 +14,7 @@ namespace Media {
 namespace Streaming {
 
 class VideoTrackObject;
+class SeekPreviews;
 
 class VideoTrack final {
 public:
@@ -23,6 +24,7 @@ public:
 		const PlaybackOptions &options,
 		Stream &&stream,
 		const AudioMsgId &audioId,
+		std::shared_ptr<SeekPreviews> seekPreviews,
 		FnMut<void(const Information &)> ready,
 		Fn<void(Error)> error);
 
@@ -51,6 +53,9 @@ public:
 	[[nodiscard]] rpl::producer<> checkNextFrame() const;
 	[[nodiscard]] rpl::producer<> waitingForData() const;
 
+	// Thread-safe.
+	void fillStatistics(Statistics &statistics) const;
+
 	// Called from the main thread.
 	~VideoTrack();
 
@@ -103,6 +108,11 @@ private:
 		[[nodiscard]] crl::time nextFrameDisplayTime() const;
 		[[nodiscard]] not_null<Frame*> frameForPaint();
 
+		// Thread-safe.
+		void countDecoded(int64 microseconds);
+		void countDropped();
+		void fillStatistics(Statistics &statistics) const;
+
 	private:
 		[[nodiscard]] not_null<Frame*> getFrame(int index);
 		[[nodiscard]] not_null<const Frame*> getFrame(int index) const;
@@ -114,6 +124,10 @@ private:
 		static constexpr auto kFramesCount = 4;
 		std::array<Frame, kFramesCount> _frames;
 
+		std::atomic<int> _framesDecoded = 0;
+		std::atomic<int> _framesDropped = 0;
+		std::atomic<int64> _decodeMicroseconds = 0;
+
 	};
 
 	static QImage PrepareFrameByRequest(
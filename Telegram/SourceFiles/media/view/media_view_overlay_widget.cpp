@@ -23,6 +23,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "media/view/media_view_group_thumbs.h"
 #include "media/streaming/media_streaming_player.h"
 #include "media/streaming/media_streaming_loader.h"
+#include "media/streaming/media_streaming_utility.h"
 #include "media/player/media_player_instance.h"
 #include "history/history.h"
 #include "history/history_message.h"
@@ -49,8 +50,14 @@ constexpr auto kGoodThumbnailQuality = 87;
 constexpr auto kWaitingFastDuration = crl::time(200);
 constexpr auto kWaitingShowDuration = crl::time(500);
 constexpr auto kWaitingShowDelay = crl::time(500);
+
+// Seek lands on the keyframe shown while dragging if it is close enough.
+constexpr auto kSeekSnapDistance = crl::time(1000);
 constexpr auto kPreloadCount = 4;
 
+// Prepare for display X loaded photos before and after current.
+constexpr auto kPreparePhotosCount = 2;
+
 // Preload X message ids before and after current.
 constexpr auto kIdsLimit = 48;
 
@@ -162,6 +169,7 @@ struct OverlayWidget::Streamed {
 	Animation fading;
 	base::Timer timer;
 	QImage frameForDirectPaint;
+	Streaming::SeekPreviews::Preview seekPreview;
 
 	bool resumeOnCallEnd = false;
 	std::optional<Streaming::Error> lastError;
@@ -208,6 +216,7 @@ OverlayWidget::OverlayWidget()
 			subscribe(Auth().downloaderTaskFinished(), [this] {
 				if (!isHidden()) {
 					updateControls();
+					prepareAdjacentPhotos();
 				}
 			});
 			subscribe(Auth().calls().currentCallChanged(), [this](Calls::Call *call) {
@@ -336,6 +345,9 @@ bool OverlayWidget::videoIsGifv() const {
 QImage OverlayWidget::videoFrame() const {
 	Expects(videoShown());
 
+	if (!_streamed->seekPreview.frame.isNull()) {
+		return _streamed->seekPreview.frame;
+	}
 	auto request = Streaming::FrameRequest();
 	//request.radius = (_doc && _doc->isVideoMessage())
 	//	? ImageRoundRadius::Ellipse
@@ -2291,11 +2303,27 @@ void OverlayWidget::playbackControlsSeekProgress(crl::time position) {
 	if (!_streamed->player.paused() && !_streamed->player.finished()) {
 		playbackControlsPause();
 	}
+	auto preview = _streamed->player.seekPreview(position);
+	if (preview.position != _streamed->seekPreview.position) {
+		_streamed->seekPreview = std::move(preview);
+		if (videoShown()) {
+			update(contentRect());
+		}
+	}
 }
 
 void OverlayWidget::playbackControlsSeekFinished(crl::time position) {
 	_streamingStartPaused = false;
+	const auto &preview = _streamed->seekPreview;
+	if (preview.position != kTimeUnknown
+		&& std::abs(preview.position - position) <= kSeekSnapDistance) {
+		// The preview frame becomes the cover until the seek is done.
+		position = preview.position;
+	} else {
+		_streamed->seekPreview = Streaming::SeekPreviews::Preview();
+	}
 	restartAtSeekPosition(position);
+	_streamed->seekPreview = Streaming::SeekPreviews::Preview();
 }
 
 void OverlayWidget::playbackControlsVolumeChanged(float64 volume) {
@@ -2393,6 +2421,9 @@ void OverlayWidget::validatePhotoImage(Image *image, bool blurred) {
 }
 
 void OverlayWidget::validatePhotoCurrentImage() {
+	if ((_current.isNull() || _blurred) && usePreparedPhoto()) {
+		return;
+	}
 	validatePhotoImage(_photo->large(), false);
 	validatePhotoImage(_photo->thumbnail(), true);
 	validatePhotoImage(_photo->thumbnailSmall(), true);
@@ -2451,6 +2482,9 @@ void OverlayWidget::paintEvent(QPaintEvent *e) {
 		if (rect.intersects(r)) {
 			if (videoShown()) {
 				paintTransformedVideoFrame(p);
+				if (Logs::DebugEnabled()) {
+					paintStreamingStatistics(p);
+				}
 			} else {
 				if ((!_doc || !_doc->getStickerLarge())
 					&& (_current.isNull() || _current.hasAlpha())) {
@@ -2687,6 +2721,25 @@ void OverlayWidget::checkGroupThumbsAnimation() {
 	}
 }
 
+void OverlayWidget::paintStreamingStatistics(Painter &p) {
+	Expects(_streamed != nullptr);
+
+	// The content rect is repainted for each frame, keep the text there.
+	const auto text = Streaming::StatisticsText(
+		_streamed->player.statistics(),
+		"\n");
+	const auto padding = st::mediaviewCaptionPadding;
+	const auto content = contentRect().marginsRemoved(padding);
+	p.setFont(st::mediaviewFont);
+	const auto rect = p.boundingRect(
+		content,
+		Qt::AlignLeft | Qt::AlignTop,
+		text);
+	p.fillRect(rect.marginsAdded(padding), st::mediaviewCaptionBg);
+	p.setPen(st::mediaviewCaptionFg);
+	p.drawText(rect, Qt::AlignLeft | Qt::AlignTop, text);
+}
+
 void OverlayWidget::paintTransformedVideoFrame(Painter &p) {
 	const auto rect = contentRect();
 	const auto image = videoFrameForDirectPaint();
@@ -3163,6 +3216,90 @@ void OverlayWidget::preloadData(int delta) {
 			}
 		}
 	}
+	prepareAdjacentPhotos();
+}
+
+void OverlayWidget::prepareAdjacentPhotos() {
+	if (!_index) {
+		_preparedPhotos.clear();
+		_preparingPhotos.clear();
+		return;
+	}
+	auto adjacent = base::flat_set<not_null<PhotoData*>>();
+	const auto from = *_index - kPreparePhotosCount;
+	const auto till = *_index + kPreparePhotosCount + 1;
+	for (auto index = from; index != till; ++index) {
+		const auto entity = entityByIndex(index);
+		if (const auto photo = base::get_if<not_null<PhotoData*>>(
+				&entity.data)) {
+			adjacent.emplace(*photo);
+		}
+	}
+	for (auto i = begin(_preparingPhotos); i != end(_preparingPhotos);) {
+		if (adjacent.contains(*i)) {
+			++i;
+		} else {
+			i = _preparingPhotos.erase(i);
+		}
+	}
+	for (auto i = begin(_preparedPhotos); i != end(_preparedPhotos);) {
+		if (adjacent.contains(i->first)) {
+			++i;
+		} else {
+			i = _preparedPhotos.erase(i);
+		}
+	}
+
+	for (const auto photo : adjacent) {
+		const auto image = photo->large();
+		if (photo == _photo
+			|| !image->loaded()
+			|| _preparedPhotos.contains(photo)
+			|| _preparingPhotos.contains(photo)) {
+			continue;
+		}
+
+		// Same size that validatePhotoImage() will request for the photo.
+		const auto size = QSize(
+			ConvertScale(photo->width()),
+			ConvertScale(photo->height())) * cIntRetinaFactor();
+		if (size.isEmpty()) {
+			continue;
+		}
+		_preparingPhotos.emplace(photo);
+		crl::async([=, original = image->original()] {
+			auto prepared = Images::prepare(
+				original,
+				size.width(),
+				size.height(),
+				Images::Option::Smooth,
+				-1,
+				-1);
+			crl::on_main(this, [=, prepared = std::move(prepared)]() mutable {
+				if (_preparingPhotos.remove(photo)) {
+					_preparedPhotos.emplace(
+						photo,
+						PreparedPhoto{ size, std::move(prepared) });
+				}
+			});
+		});
+	}
+}
+
+bool OverlayWidget::usePreparedPhoto() {
+	const auto i = _preparedPhotos.find(_photo);
+	if (i == end(_preparedPhotos)) {
+		return false;
+	}
+	const auto size = QSize(_width, _height) * cIntRetinaFactor();
+	const auto use = (i->second.size == size);
+	if (use) {
+		_current = App::pixmapFromImageInPlace(std::move(i->second.image));
+		_current.setDevicePixelRatio(cRetinaFactor());
+		_blurred = false;
+	}
+	_preparedPhotos.erase(i);
+	return use;
 }
 
 void OverlayWidget::mousePressEvent(QMouseEvent *e) {
@@ -3609,6 +3746,8 @@ void OverlayWidget::setVisibleHook(bool visible) {
 		destroyThemePreview();
 		_radial.stop();
 		_current = QPixmap();
+		_preparedPhotos.clear();
+		_preparingPhotos.clear();
 		_themePreview = nullptr;
 		_themeApply.destroyDelayed();
 		_themeCancel.destroyDelayed();
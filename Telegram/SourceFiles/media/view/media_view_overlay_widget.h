@@ -176,6 +176,8 @@ private:
 	void moveToScreen(bool force = false);
 	bool moveToNext(int delta);
 	void preloadData(int delta);
+	void prepareAdjacentPhotos();
+	bool usePreparedPhoto();
 
 	Entity entityForUserPhotos(int index) const;
 	Entity entityForSharedMedia(int index) const;
@@ -309,6 +311,7 @@ private:
 	[[nodiscard]] bool documentContentShown() const;
 	[[nodiscard]] bool documentBubbleShown() const;
 	void paintTransformedVideoFrame(Painter &p);
+	void paintStreamingStatistics(Painter &p);
 	void clearStreaming();
 
 	QBrush _transparentBrush;
@@ -359,6 +362,13 @@ private:
 	QPixmap _current;
 	bool _blurred = true;
 
+	struct PreparedPhoto {
+		QSize size;
+		QImage image;
+	};
+	base::flat_map<not_null<PhotoData*>, PreparedPhoto> _preparedPhotos;
+	base::flat_set<not_null<PhotoData*>> _preparingPhotos;
+
 	std::unique_ptr<Streamed> _streamed;
 
 	const style::icon *_docIcon = nullptr;
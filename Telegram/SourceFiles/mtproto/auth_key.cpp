@@ -6,10 +6,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 */
 #include "mtproto/auth_key.h"
 
-extern "C" {
-#include <openssl/aes.h>
-#include <openssl/modes.h>
-} // extern "C"
+#include "base/openssl_aes.h"
 
 namespace MTP {
 
@@ -72,41 +69,26 @@ void AuthKey::prepareAES(const MTPint128 &msgKey, MTPint256 &aesKey, MTPint256 &
 }
 
 void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
-	uchar aes_key[32], aes_iv[32];
-	memcpy(aes_key, key, 32);
-	memcpy(aes_iv, iv, 32);
-
-	AES_KEY aes;
-	AES_set_encrypt_key(aes_key, 256, &aes);
-	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_ENCRYPT);
+	openssl::AesIgeEncrypt(src, dst, len, key, iv);
 }
 
 void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
-	uchar aes_key[32], aes_iv[32];
-	memcpy(aes_key, key, 32);
-	memcpy(aes_iv, iv, 32);
-
-	AES_KEY aes;
-	AES_set_decrypt_key(aes_key, 256, &aes);
-	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_DECRYPT);
+	openssl::AesIgeDecrypt(src, dst, len, key, iv);
 }
 
 void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
-	AES_KEY aes;
-	AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
-
-	static_assert(CTRState::IvecSize == AES_BLOCK_SIZE, "Wrong size of ctr ivec!");
-	static_assert(CTRState::EcountSize == AES_BLOCK_SIZE, "Wrong size of ctr ecount!");
+	static_assert(CTRState::KeySize == openssl::kAes256KeySize, "Wrong size of ctr key!");
+	static_assert(CTRState::IvecSize == openssl::kAesBlockSize, "Wrong size of ctr ivec!");
+	static_assert(CTRState::EcountSize == openssl::kAesBlockSize, "Wrong size of ctr ecount!");
 
-	CRYPTO_ctr128_encrypt(
-		reinterpret_cast<const uchar*>(data.data()),
-		reinterpret_cast<uchar*>(data.data()),
+	openssl::AesCtrEncrypt(
+		data.data(),
+		data.data(),
 		data.size(),
-		&aes,
+		key,
 		state->ivec,
 		state->ecount,
-		&state->num,
-		(block128_f)AES_encrypt);
+		&state->num);
 }
 
 } // namespace MTP
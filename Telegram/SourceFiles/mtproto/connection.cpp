@@ -11,12 +11,13 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "mtproto/rpc_sender.h"
 #include "mtproto/dc_options.h"
 #include "mtproto/connection_abstract.h"
-#include "zlib.h"
+#include "mtproto/network_stats.h"
 #include "core/application.h"
 #include "core/launcher.h"
 #include "lang/lang_keys.h"
 #include "base/openssl_help.h"
 #include "base/qthelp_url.h"
+#include "base/zlib_inflate.h"
 
 extern "C" {
 #include <openssl/bn.h>
@@ -55,6 +56,10 @@ constexpr auto kRequestConfigTimeout = crl::time(8000);
 // Don't try to handle messages larger than this size.
 constexpr auto kMaxMessageLength = 16 * 1024 * 1024;
 
+// Connections share up to this count of threads, one per core.
+constexpr auto kMinThreadsCount = 2;
+constexpr auto kMaxThreadsCount = 8;
+
 QString LogIdsVector(const QVector<MTPlong> &ids) {
 	if (!ids.size()) return "[]";
 	auto idsStr = QString("[%1").arg(ids.cbegin()->v);
@@ -174,7 +179,25 @@ bool IsPrimeAndGood(bytes::const_span primeBytes, int g) {
 		}
 	}
 
-	return IsPrimeAndGoodCheck(openssl::BigNum(primeBytes), g);
+	// Connections to different dcs check the same primes on their own
+	// threads, remember the checked ones to skip the primality tests.
+	static QMutex CheckedMutex;
+	static auto Checked = base::flat_set<std::pair<bytes::vector, int>>();
+	auto key = std::make_pair(
+		bytes::vector(primeBytes.begin(), primeBytes.end()),
+		g);
+	{
+		QMutexLocker lock(&CheckedMutex);
+		if (Checked.contains(key)) {
+			return true;
+		}
+	}
+	if (!IsPrimeAndGoodCheck(openssl::BigNum(primeBytes), g)) {
+		return false;
+	}
+	QMutexLocker lock(&CheckedMutex);
+	Checked.emplace(std::move(key));
+	return true;
 }
 
 bytes::vector CreateAuthKey(
@@ -285,39 +308,99 @@ bool parsePQ(const QByteArray &pqStr, QByteArray &pStr, QByteArray &qStr) {
 
 } // namespace
 
+ThreadPool::ThreadPool() {
+	const auto count = snap(
+		QThread::idealThreadCount(),
+		kMinThreadsCount,
+		kMaxThreadsCount);
+	_entries.resize(count);
+}
+
+ThreadPool::~ThreadPool() {
+	for (const auto &entry : _entries) {
+		Assert(entry.users == 0);
+		if (entry.thread) {
+			entry.thread->quit();
+		}
+	}
+	for (const auto &entry : _entries) {
+		if (entry.thread) {
+			entry.thread->wait();
+		}
+	}
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::Shared() {
+	static QMutex Mutex;
+	static std::weak_ptr<ThreadPool> Weak;
+
+	QMutexLocker lock(&Mutex);
+	auto result = Weak.lock();
+	if (!result) {
+		result = std::make_shared<ThreadPool>();
+		Weak = result;
+	}
+	return result;
+}
+
+not_null<Thread*> ThreadPool::acquire() {
+	QMutexLocker lock(&_mutex);
+	const auto i = ranges::min_element(_entries, std::less<>(), [](
+			const Entry &entry) {
+		return entry.users;
+	});
+	if (!i->thread) {
+		i->thread = std::make_unique<Thread>();
+		i->thread->start();
+	}
+	++i->users;
+	return i->thread.get();
+}
+
+void ThreadPool::release(not_null<Thread*> thread) {
+	QMutexLocker lock(&_mutex);
+	const auto i = ranges::find(_entries, thread.get(), [](
+			const Entry &entry) {
+		return entry.thread.get();
+	});
+	Assert(i != _entries.end() && i->users > 0);
+	--i->users;
+}
+
 Connection::Connection(not_null<Instance*> instance) : _instance(instance) {
 }
 
 void Connection::start(SessionData *sessionData, ShiftedDcId shiftedDcId) {
 	Expects(_thread == nullptr && _private == nullptr);
 
-	_thread = std::make_unique<Thread>();
+	_threads = ThreadPool::Shared();
+	_thread = _threads->acquire();
 	auto newData = std::make_unique<ConnectionPrivate>(
 		_instance,
-		_thread.get(),
+		_thread,
 		this,
 		sessionData,
 		shiftedDcId);
 
-	// will be deleted in the thread::finished signal
+	// will be deleted in the connection thread after finishAsync()
 	_private = newData.release();
-	_thread->start();
 }
 
 void Connection::kill() {
 	Expects(_private != nullptr && _thread != nullptr);
 
 	_private->stop();
+	_private->finishAsync(&_finished);
 	_private = nullptr;
-	_thread->quit();
 }
 
 void Connection::waitTillFinish() {
 	Expects(_private == nullptr && _thread != nullptr);
 
-	DEBUG_LOG(("Waiting for connectionThread to finish"));
-	_thread->wait();
-	_thread.reset();
+	DEBUG_LOG(("Waiting for connection to finish"));
+	_finished.acquire();
+	_threads->release(base::take(_thread));
+	_threads = nullptr;
 }
 
 int32 Connection::state() const {
@@ -350,13 +433,20 @@ void ConnectionPrivate::appendTestConnection(
 	const auto priority = (qthelp::is_ipv6(ip) ? 0 : 1)
 		+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
 		+ (protocolSecret.empty() ? 0 : 1);
+	const auto endpoint = ip.toStdString();
 	_testConnections.push_back({
 		AbstractConnection::Create(
 			_instance,
 			protocol,
 			thread(),
 			_connectionOptions->proxy),
-		priority
+		priority,
+		endpoint,
+		port,
+		_instance->dcOptions()->endpointRtt(
+			BareDcId(_shiftedDcId),
+			endpoint,
+			port)
 	});
 	auto weak = _testConnections.back().data.get();
 	connect(weak, &AbstractConnection::error, [=](int errorCode) {
@@ -428,8 +518,8 @@ ConnectionPrivate::ConnectionPrivate(
 
 	moveToThread(thread);
 
-	connect(thread, &QThread::started, this, [=] { connectToServer(); });
-	connect(thread, &QThread::finished, this, [=] { finishAndDestroy(); });
+	// The thread is shared and may be already running.
+	InvokeQueued(this, [=] { connectToServer(); });
 	connect(this, SIGNAL(finished(internal::Connection*)), _instance, SLOT(connectionFinished(internal::Connection*)), Qt::QueuedConnection);
 
 	connect(sessionData->owner(), SIGNAL(authKeyCreated()), this, SLOT(updateAuthKey()), Qt::QueuedConnection);
@@ -531,7 +621,7 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 			mtpMsgId id = i.key();
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 						break;
 					}
 					mtpMsgId m = msgid();
@@ -548,17 +638,17 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 			setSeqNumbers.insert(id, i.value());
 		}
 	}
-	for (auto i = toResend.cbegin(), e = toResend.cend(); i != e; ++i) { // collect all non-container requests
-		const auto j = toSend.constFind(i.value());
+	for (const auto &[msgId, requestId] : toResend) { // collect all non-container requests
+		const auto j = toSend.constFind(requestId);
 		if (j == toSend.cend()) continue;
 
 		if (!j.value().isSentContainer()) {
 			if (!*(mtpMsgId*)(j.value()->constData() + 4)) continue;
 
-			mtpMsgId id = i.key();
+			mtpMsgId id = msgId;
 			if (id > newId) {
 				while (true) {
-					if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+					if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 						break;
 					}
 					mtpMsgId m = msgid();
@@ -594,15 +684,15 @@ void ConnectionPrivate::resetSession() { // recreate all msg_id and msg_seqno
 			}
 			const auto k = toResend.find(i.key());
 			if (k != toResend.cend()) {
-				const auto req = k.value();
+				const auto req = k->second;
 				toResend.erase(k);
-				toResend.insert(i.value(), req);
+				toResend[i.value()] = req;
 			}
 			const auto l = wereAcked.find(i.key());
 			if (l != wereAcked.cend()) {
-				const auto req = l.value();
+				const auto req = l->second;
 				wereAcked.erase(l);
-				wereAcked.insert(i.value(), req);
+				wereAcked[i.value()] = req;
 			}
 		}
 		for (auto i = haveSent.cbegin(), e = haveSent.cend(); i != e; ++i) { // replace msgIds in saved containers
@@ -659,7 +749,7 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 			auto &haveSent = sessionData->haveSentMap();
 
 			while (true) {
-				if (toResend.constFind(newId) == toResend.cend() && wereAcked.constFind(newId) == wereAcked.cend() && haveSent.constFind(newId) == haveSent.cend()) {
+				if (!toResend.contains(newId) && !wereAcked.contains(newId) && haveSent.constFind(newId) == haveSent.cend()) {
 					break;
 				}
 				const auto m = msgid();
@@ -670,16 +760,16 @@ mtpMsgId ConnectionPrivate::replaceMsgId(SecureRequest &request, mtpMsgId newId)
 
 			const auto i = toResend.find(oldMsgId);
 			if (i != toResend.cend()) {
-				const auto req = i.value();
+				const auto req = i->second;
 				toResend.erase(i);
-				toResend.insert(newId, req);
+				toResend[newId] = req;
 			}
 
 			const auto j = wereAcked.find(oldMsgId);
 			if (j != wereAcked.cend()) {
-				const auto req = j.value();
+				const auto req = j->second;
 				wereAcked.erase(j);
-				wereAcked.insert(newId, req);
+				wereAcked[newId] = req;
 			}
 
 			const auto k = haveSent.find(oldMsgId);
@@ -925,7 +1015,7 @@ void ConnectionPrivate::tryToSend() {
 					needAnyResponse = true;
 				} else {
 					QWriteLocker locker3(sessionData->wereAckedMutex());
-					sessionData->wereAckedMap().insert(msgId, toSendRequest->requestId);
+					sessionData->wereAckedMap()[msgId] = toSendRequest->requestId;
 				}
 			}
 		} else { // send in container
@@ -1009,7 +1099,7 @@ void ConnectionPrivate::tryToSend() {
 
 						needAnyResponse = true;
 					} else {
-						wereAcked.insert(msgId, req->requestId);
+						wereAcked[msgId] = req->requestId;
 					}
 				}
 				if (!added) {
@@ -1354,6 +1444,13 @@ void ConnectionPrivate::doDisconnect() {
 	restarted = false;
 }
 
+void ConnectionPrivate::finishAsync(not_null<QSemaphore*> finished) {
+	InvokeQueued(this, [=] {
+		finishAndDestroy();
+		finished->release();
+	});
+}
+
 void ConnectionPrivate::finishAndDestroy() {
 	doDisconnect();
 	_finished = true;
@@ -1408,7 +1505,7 @@ void ConnectionPrivate::handleReceived() {
 		constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
 		constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
 		auto intsCount = uint32(intsBuffer.size());
-		auto ints = intsBuffer.constData();
+		auto ints = intsBuffer.data();
 		if ((intsCount < kMinimalIntsCount) || (intsCount > kMaxMessageLength / kIntSize)) {
 			LOG(("TCP Error: bad message received, len %1").arg(intsCount * kIntSize));
 			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(ints, intsCount * kIntSize).str()));
@@ -1421,20 +1518,22 @@ void ConnectionPrivate::handleReceived() {
 
 			return restartOnError();
 		}
+		_instance->stats()->packetReceived(_shiftedDcId, intsCount * kIntSize);
 
 		auto encryptedInts = ints + kExternalHeaderIntsCount;
 		auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
 		auto encryptedBytesCount = encryptedIntsCount * kIntSize;
-		auto decryptedBuffer = QByteArray(encryptedBytesCount, Qt::Uninitialized);
 		auto msgKey = *(MTPint128*)(ints + 2);
 
+		// AES IGE supports in-place decryption, the received buffer
+		// is owned by us here, so we don't allocate another one.
 #ifdef TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt_oldmtp(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, key, msgKey);
+		aesIgeDecrypt_oldmtp(encryptedInts, encryptedInts, encryptedBytesCount, key, msgKey);
 #else // TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, key, msgKey);
+		aesIgeDecrypt(encryptedInts, encryptedInts, encryptedBytesCount, key, msgKey);
 #endif // TDESKTOP_MTPROTO_OLD
 
-		auto decryptedInts = reinterpret_cast<const mtpPrime*>(decryptedBuffer.constData());
+		auto decryptedInts = static_cast<const mtpPrime*>(encryptedInts);
 		auto serverSalt = *(uint64*)&decryptedInts[0];
 		auto session = *(uint64*)&decryptedInts[2];
 		auto msgId = *(uint64*)&decryptedInts[4];
@@ -1552,7 +1651,7 @@ void ConnectionPrivate::handleReceived() {
 		bool needToHandle = false;
 		{
 			QWriteLocker lock(sessionData->receivedIdsMutex());
-			needToHandle = sessionData->receivedIdsSet().registerMsgId(msgId, needAck);
+			needToHandle = registerReceivedMsgId(msgId, needAck);
 		}
 		if (needToHandle) {
 			res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime);
@@ -1659,7 +1758,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 			bool needToHandle = false;
 			{
 				QWriteLocker lock(sessionData->receivedIdsMutex());
-				needToHandle = sessionData->receivedIdsSet().registerMsgId(inMsgId.v, needAck);
+				needToHandle = registerReceivedMsgId(inMsgId.v, needAck);
 			}
 			auto res = HandleResult::Success; // if no need to handle, then succeed
 			if (needToHandle) {
@@ -1842,7 +1941,6 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 
 			QReadLocker locker(sessionData->wereAckedMutex());
 			const auto &wereAcked = sessionData->wereAckedMap();
-			const auto wereAckedEnd = wereAcked.cend();
 
 			for (uint32 i = 0, l = idsCount; i < l; ++i) {
 				char state = 0;
@@ -1857,7 +1955,7 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 						state |= 0x02;
 					} else {
 						state |= 0x04;
-						if (wereAcked.constFind(reqMsgId) != wereAckedEnd) {
+						if (wereAcked.contains(reqMsgId)) {
 							state |= 0x80; // we know, that server knows, that we received request
 						}
 						if (msgIdState == ReceivedMsgIds::State::NeedsAck) { // need ack, so we sent ack
@@ -2185,48 +2283,16 @@ ConnectionPrivate::HandleResult ConnectionPrivate::handleOneReceived(const mtpPr
 }
 
 mtpBuffer ConnectionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) const {
-	MTPstring packed;
-	packed.read(from, end); // read packed string as serialized mtp string type
-	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen, unpackedLen = 0;
-
-	mtpBuffer result; // * 4 because of mtpPrime type
-	result.resize(0);
-	z_stream stream;
-	stream.zalloc = 0;
-	stream.zfree = 0;
-	stream.opaque = 0;
-	stream.avail_in = 0;
-	stream.next_in = 0;
-	int res = inflateInit2(&stream, 16 + MAX_WBITS);
-	if (res != Z_OK) {
-		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
-		return result;
-	}
-	stream.avail_in = packedLen;
-	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
-
-	stream.avail_out = 0;
-	while (!stream.avail_out) {
-		result.resize(result.size() + unpackedChunk);
-		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
-		if (res != Z_OK && res != Z_STREAM_END) {
-			inflateEnd(&stream);
-			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
-			return mtpBuffer();
-		}
-	}
-	if (stream.avail_out & 0x03) {
-		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
-		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
-		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), badSize).str()));
+	// Inflate straight from the received packet into a buffer of the
+	// right size, without copying the packed bytes out first.
+	const auto packed = MTPstring::ReadView(from, end);
+	auto result = mtpBuffer();
+	const auto code = zlib::Ungzip(packed, result);
+	if (code != Z_STREAM_END) {
+		LOG(("RPC Error: could not unpack gziped data, code: %1").arg(code));
+		DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.data(), packed.size()).str()));
 		return mtpBuffer();
-	}
-	result.resize(result.size() - (stream.avail_out >> 2));
-	inflateEnd(&stream);
-	if (!result.size()) {
+	} else if (result.empty()) {
 		LOG(("RPC Error: bad length of unpacked data 0"));
 	}
 	return result;
@@ -2280,7 +2346,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							moveToAcked = !_instance->hasCallbacks(reqId);
 						}
 						if (moveToAcked) {
-							wereAcked.insert(msgId, reqId);
+							wereAcked[msgId] = reqId;
 							haveSent.erase(req);
 						} else {
 							DEBUG_LOG(("Message Info: ignoring ACK for msgId %1 because request %2 requires a response").arg(msgId).arg(reqId));
@@ -2292,7 +2358,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 					auto &toResend = sessionData->toResendMap();
 					const auto reqIt = toResend.find(msgId);
 					if (reqIt != toResend.cend()) {
-						const auto reqId = reqIt.value();
+						const auto reqId = reqIt->second;
 						bool moveToAcked = byResponse;
 						if (!moveToAcked) { // ignore ACK, if we need a response (if we have a handler)
 							moveToAcked = !_instance->hasCallbacks(reqId);
@@ -2302,7 +2368,7 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							auto &toSend = sessionData->toSendMap();
 							const auto req = toSend.find(reqId);
 							if (req != toSend.cend()) {
-								wereAcked.insert(msgId, req.value()->requestId);
+								wereAcked[msgId] = req.value()->requestId;
 								if (req.value()->requestId != reqId) {
 									DEBUG_LOG(("Message Error: for msgId %1 found resent request, requestId %2, contains requestId %3").arg(msgId).arg(reqId).arg(req.value()->requestId));
 								} else {
@@ -2323,17 +2389,17 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 			}
 		}
 
-		uint32 ackedCount = wereAcked.size();
+		const auto ackedCount = int(wereAcked.size());
 		if (ackedCount > kIdsBufferSize) {
 			DEBUG_LOG(("Message Info: removing some old acked sent msgIds %1").arg(ackedCount - kIdsBufferSize));
 			clearedBecauseTooOld.reserve(ackedCount - kIdsBufferSize);
-			while (ackedCount-- > kIdsBufferSize) {
-				auto i = wereAcked.begin();
+			wereAcked.shrink(kIdsBufferSize, [&](
+					mtpMsgId msgId,
+					mtpRequestId requestId) {
 				clearedBecauseTooOld.push_back(RPCCallbackClear(
-					i.value(),
+					requestId,
 					RPCError::TimeoutError));
-				wereAcked.erase(i);
-			}
+			});
 		}
 	}
 
@@ -2430,22 +2496,22 @@ void ConnectionPrivate::onConnected(
 		connection.get(),
 		[](const TestConnection &test) { return test.data.get(); });
 	Assert(i != end(_testConnections));
-	const auto my = i->priority;
-	const auto j = ranges::find_if(
-		_testConnections,
-		[&](const TestConnection &test) { return test.priority > my; });
-	if (j != end(_testConnections)) {
-		DEBUG_LOG(("MTP Info: connection %1 succeed, "
-			"waiting for %2.").arg(i->data->tag()).arg(j->data->tag()));
-		_waitForBetterTimer.callOnce(kWaitForBetterTimeout);
+	rememberRtt(*i);
+	const auto timeout = waitForBetterTimeout(*i);
+	if (timeout > 0) {
+		DEBUG_LOG(("MTP Info: connection %1 succeed in %2ms, "
+			"waiting %3ms for better."
+			).arg(i->data->tag()
+			).arg(i->data->pingTime()
+			).arg(timeout));
+		_waitForBetterTimer.callOnce(timeout);
 	} else {
-		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
+		DEBUG_LOG(("MTP Info: connection %1 succeed, nothing better "
+			"to wait for.").arg(i->data->tag()));
 		_waitForBetterTimer.cancel();
-		_connection = std::move(i->data);
-		_testConnections.clear();
 
 		lockFinished.unlock();
-		updateAuthKey();
+		confirmBestConnection();
 	}
 }
 
@@ -2485,6 +2551,39 @@ void ConnectionPrivate::confirmBestConnection() {
 	updateAuthKey();
 }
 
+void ConnectionPrivate::rememberRtt(const TestConnection &test) {
+	const auto rtt = test.data->pingTime();
+	if (test.ip.empty() || rtt <= 0) {
+		return;
+	}
+	_instance->dcOptions()->setEndpointRtt(
+		BareDcId(_shiftedDcId),
+		test.ip,
+		test.port,
+		rtt);
+}
+
+crl::time ConnectionPrivate::waitForBetterTimeout(
+		const TestConnection &connected) const {
+	// Wait only for the higher priority candidates that may still beat
+	// the measured round trip time. If every one of them has a remembered
+	// round trip time don't wait much longer than they usually take.
+	const auto measured = connected.data->pingTime();
+	auto result = crl::time(0);
+	for (const auto &test : _testConnections) {
+		if (test.priority <= connected.priority
+			|| test.data->isConnected()) {
+			continue;
+		} else if (!test.rememberedRtt) {
+			return kWaitForBetterTimeout;
+		} else if (measured > 0 && test.rememberedRtt >= measured) {
+			continue;
+		}
+		accumulate_max(result, 2 * test.rememberedRtt);
+	}
+	return std::min(result, kWaitForBetterTimeout);
+}
+
 void ConnectionPrivate::removeTestConnection(
 		not_null<AbstractConnection*> connection) {
 	_testConnections.erase(
@@ -3178,6 +3277,10 @@ bool ConnectionPrivate::sendSecureRequest(
 
 	DEBUG_LOG(("MTP Info: sending request, size: %1, num: %2, time: %3").arg(fullSize + 6).arg((*request)[4]).arg((*request)[5]));
 
+	_instance->stats()->packetSent(
+		_shiftedDcId,
+		(prefix + fullSize) * sizeof(mtpPrime));
+
 	_connection->setSentEncrypted();
 	_connection->sendData(std::move(packet));
 
@@ -3188,6 +3291,24 @@ bool ConnectionPrivate::sendSecureRequest(
 	return true;
 }
 
+bool ConnectionPrivate::registerReceivedMsgId(mtpMsgId msgId, bool needAck) {
+	auto &receivedIds = sessionData->receivedIdsSet();
+	using Result = ReceivedMsgIds::Result;
+	switch (receivedIds.registerMsgId(msgId, needAck)) {
+	case Result::Success: return true;
+	case Result::Duplicate:
+		MTP_LOG(_shiftedDcId, ("No need to handle - %1 already is in map"
+			).arg(msgId));
+		return false;
+	case Result::TooOld:
+		MTP_LOG(_shiftedDcId, ("No need to handle - %1 < min = %2"
+			).arg(msgId
+			).arg(receivedIds.min()));
+		return false;
+	}
+	Unexpected("Result in ConnectionPrivate::registerReceivedMsgId.");
+}
+
 mtpRequestId ConnectionPrivate::wasSent(mtpMsgId msgId) const {
 	if (msgId == _pingMsgId) return mtpRequestId(0xFFFFFFFF);
 	{
@@ -3203,14 +3324,14 @@ mtpRequestId ConnectionPrivate::wasSent(mtpMsgId msgId) const {
 	{
 		QReadLocker locker(sessionData->toResendMutex());
 		const auto &toResend = sessionData->toResendMap();
-		const auto i = toResend.constFind(msgId);
-		if (i != toResend.cend()) return i.value();
+		const auto i = toResend.find(msgId);
+		if (i != toResend.end()) return i->second;
 	}
 	{
 		QReadLocker locker(sessionData->wereAckedMutex());
 		const auto &wereAcked = sessionData->wereAckedMap();
-		const auto i = wereAcked.constFind(msgId);
-		if (i != wereAcked.cend()) return i.value();
+		const auto i = wereAcked.find(msgId);
+		if (i != wereAcked.end()) return i->second;
 	}
 	return 0;
 }
@@ -56,6 +56,28 @@ private:
 
 };
 
+// Connections are spread over a few shared threads instead of having
+// a thread each, the pool lives while at least one Connection uses it.
+class ThreadPool {
+public:
+	ThreadPool();
+	~ThreadPool();
+
+	static std::shared_ptr<ThreadPool> Shared();
+
+	not_null<Thread*> acquire();
+	void release(not_null<Thread*> thread);
+
+private:
+	struct Entry {
+		std::unique_ptr<Thread> thread;
+		int users = 0;
+	};
+	std::vector<Entry> _entries;
+	QMutex _mutex;
+
+};
+
 class Connection {
 public:
 	enum ConnectionType {
@@ -78,8 +100,10 @@ public:
 
 private:
 	not_null<Instance*> _instance;
-	std::unique_ptr<QThread> _thread;
+	std::shared_ptr<ThreadPool> _threads;
+	Thread *_thread = nullptr;
 	ConnectionPrivate *_private = nullptr;
+	QSemaphore _finished;
 
 };
 
@@ -97,6 +121,9 @@ public:
 
 	void stop();
 
+	// Finishes in the connection thread and releases the semaphore.
+	void finishAsync(not_null<QSemaphore*> finished);
+
 	int32 getShiftedDcId() const;
 
 	int32 getState() const;
@@ -149,6 +176,9 @@ private:
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
+		std::string ip;
+		int port = 0;
+		crl::time rememberedRtt = 0;
 	};
 	void connectToServer(bool afterConfig = false);
 	void doDisconnect();
@@ -171,6 +201,8 @@ private:
 
 	void destroyAllConnections();
 	void confirmBestConnection();
+	void rememberRtt(const TestConnection &test);
+	crl::time waitForBetterTimeout(const TestConnection &connected) const;
 	void removeTestConnection(not_null<AbstractConnection*> connection);
 	int16 getProtocolDcId() const;
 
@@ -188,6 +220,9 @@ private:
 		QReadLocker &lockFinished);
 	mtpRequestId wasSent(mtpMsgId msgId) const;
 
+	// Must be called with receivedIdsMutex() locked for write.
+	bool registerReceivedMsgId(mtpMsgId msgId, bool needAck);
+
 	enum class HandleResult {
 		Success,
 		Ignored,
@@ -41,15 +41,23 @@ void HttpConnection::sendData(mtpBuffer &&buffer) {
 	request.setHeader(QNetworkRequest::ContentLengthHeader, QVariant(requestSize));
 	request.setHeader(QNetworkRequest::ContentTypeHeader, QVariant(qsl("application/x-www-form-urlencoded")));
 
+	// No HttpPipeliningAllowedAttribute: every request holds an http_wait,
+	// so a request pipelined behind it would wait for the long poll to end.
+	// Qt keeps the connections alive and runs up to six of them in parallel.
 	TCP_LOG(("HTTP Info: sending %1 len request").arg(requestSize));
-	_requests.insert(_manager.post(request, QByteArray((const char*)(&buffer[2]), requestSize)));
+	_requests.emplace(
+		_manager.post(request, QByteArray((const char*)(&buffer[2]), requestSize)),
+		crl::now());
+	++_metrics.requests;
+	_metrics.bytesSent += requestSize;
 }
 
 void HttpConnection::disconnectFromServer() {
 	if (_status == Status::Finished) return;
 	_status = Status::Finished;
 
-	for (const auto request : base::take(_requests)) {
+	logMetrics();
+	for (const auto &[request, sent] : base::take(_requests)) {
 		request->abort();
 		request->deleteLater();
 	}
@@ -156,15 +164,21 @@ void HttpConnection::requestFinished(QNetworkReply *reply) {
 	if (_status == Status::Finished) return;
 
 	reply->deleteLater();
+	const auto i = _requests.find(reply);
+	const auto known = (i != end(_requests));
+	if (known) {
+		_metrics.roundTrip.add(crl::now() - i->second);
+		_requests.erase(i);
+	}
 	if (reply->error() == QNetworkReply::NoError) {
-		_requests.remove(reply);
+		_metrics.bytesReceived += reply->bytesAvailable();
 
 		mtpBuffer data = handleResponse(reply);
 		if (data.size() == 1) {
 			emit error(data[0]);
 		} else if (!data.isEmpty()) {
 			if (_status == Status::Ready) {
-				_receivedQueue.push_back(data);
+				_receivedQueue.push_back(std::move(data));
 				emit receivedData();
 			} else {
 				try {
@@ -191,14 +205,28 @@ void HttpConnection::requestFinished(QNetworkReply *reply) {
 			}
 		}
 	} else {
-		if (!_requests.remove(reply)) {
+		if (!known) {
 			return;
 		}
+		++_metrics.errors;
 
 		emit error(handleError(reply));
 	}
 }
 
+void HttpConnection::logMetrics() const {
+	if (!_metrics.requests) {
+		return;
+	}
+	DEBUG_LOG(("HTTP Info: %1 requests, %2 errors, "
+		"sent %3 bytes, received %4 bytes, round trip %5"
+		).arg(_metrics.requests
+		).arg(_metrics.errors
+		).arg(_metrics.bytesSent
+		).arg(_metrics.bytesReceived
+		).arg(_metrics.roundTrip.toString()));
+}
+
 crl::time HttpConnection::pingTime() const {
 	return isConnected() ? _pingTime : crl::time(0);
 }
@@ -212,7 +240,7 @@ bool HttpConnection::usingHttpWait() {
 }
 
 bool HttpConnection::needHttpWait() {
-	return _requests.isEmpty();
+	return _requests.empty();
 }
 
 int32 HttpConnection::debugState() const {
@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "mtproto/connection_abstract.h"
+#include "mtproto/network_stats.h"
 
 namespace MTP {
 namespace internal {
@@ -39,9 +40,18 @@ public:
 	static qint32 handleError(QNetworkReply *reply); // returnes error code
 
 private:
+	struct Metrics {
+		LatencyHistogram roundTrip;
+		int64 bytesSent = 0;
+		int64 bytesReceived = 0;
+		int requests = 0;
+		int errors = 0;
+	};
+
 	QUrl url() const;
 
 	void requestFinished(QNetworkReply *reply);
+	void logMetrics() const;
 
 	enum class Status {
 		Waiting = 0,
@@ -54,7 +64,9 @@ private:
 	QNetworkAccessManager _manager;
 	QString _address;
 
-	QSet<QNetworkReply*> _requests;
+	// Values are the times the requests were sent.
+	base::flat_map<QNetworkReply*, crl::time> _requests;
+	Metrics _metrics;
 
 	crl::time _pingTime = 0;
 
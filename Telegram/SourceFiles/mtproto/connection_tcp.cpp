@@ -42,6 +42,7 @@ public:
 	static constexpr auto kUnknownSize = -1;
 	static constexpr auto kInvalidSize = -2;
 	virtual int readPacketLength(bytes::const_span bytes) const = 0;
+	virtual int readPacketPrefixLength(bytes::const_span bytes) const = 0;
 	virtual bytes::const_span readPacket(bytes::const_span bytes) const = 0;
 
 	virtual ~Protocol() = default;
@@ -63,6 +64,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketPrefixLength(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -128,13 +130,20 @@ int TcpConnection::Protocol::Version0::readPacketLength(
 	return kInvalidSize;
 }
 
+int TcpConnection::Protocol::Version0::readPacketPrefixLength(
+		bytes::const_span bytes) const {
+	Expects(!bytes.empty());
+
+	return (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+}
+
 bytes::const_span TcpConnection::Protocol::Version0::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+	const auto sizeLength = readPacketPrefixLength(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -175,6 +184,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketPrefixLength(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -213,13 +223,18 @@ int TcpConnection::Protocol::VersionD::readPacketLength(
 		: kInvalidSize;
 }
 
+int TcpConnection::Protocol::VersionD::readPacketPrefixLength(
+		bytes::const_span bytes) const {
+	return 4;
+}
+
 bytes::const_span TcpConnection::Protocol::VersionD::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = 4;
+	const auto sizeLength = readPacketPrefixLength(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -268,35 +283,49 @@ ConnectionPointer TcpConnection::clone(const ProxyData &proxy) {
 }
 
 void TcpConnection::ensureAvailableInBuffer(int amount) {
-	auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-	const auto full = bytes::make_span(buffer).subspan(
-		_offsetBytes);
+	Expects(amount <= _smallBuffer.size());
+
+	const auto full = bytes::make_span(_smallBuffer).subspan(_offsetBytes);
 	if (full.size() >= amount) {
 		return;
 	}
-	const auto read = full.subspan(0, _readBytes);
-	if (amount <= _smallBuffer.size()) {
-		if (_usingLargeBuffer) {
-			bytes::copy(_smallBuffer, read);
-			_usingLargeBuffer = false;
-			_largeBuffer.clear();
-		} else {
-			bytes::move(_smallBuffer, read);
-		}
-	} else if (amount <= _largeBuffer.size()) {
-		Assert(_usingLargeBuffer);
-		bytes::move(_largeBuffer, read);
-	} else {
-		auto enough = bytes::vector(amount);
-		bytes::copy(enough, read);
-		_largeBuffer = std::move(enough);
-		_usingLargeBuffer = true;
-	}
+	bytes::move(_smallBuffer, full.subspan(0, _readBytes));
 	_offsetBytes = 0;
 }
 
+void TcpConnection::startLargePacket(
+		bytes::const_span read,
+		int packetSize) {
+	Expects(_largePacket.empty());
+
+	const auto prefix = _protocol->readPacketPrefixLength(read);
+	Assert(prefix <= read.size() && read.size() < packetSize);
+
+	// VersionD packets may have a random padding of arbitrary length.
+	const auto payload = packetSize - prefix;
+	const auto ints = int((payload + sizeof(mtpPrime) - 1) / sizeof(mtpPrime));
+	_largePacket.resize(ints);
+	_largePacketSize = payload;
+	_largePacketFilled = read.size() - prefix;
+	bytes::copy(bytes::make_span(_largePacket), read.subspan(prefix));
+
+	_offsetBytes = _readBytes = 0;
+}
+
+void TcpConnection::finishLargePacket() {
+	Expects(_largePacketFilled == _largePacketSize);
+
+	TCP_LOG(("TCP Info: large packet received, size = %1"
+		).arg(_largePacketSize));
+
+	auto data = base::take(_largePacket);
+	data.resize(_largePacketSize / sizeof(mtpPrime));
+	_largePacketSize = _largePacketFilled = 0;
+	handlePacket(std::move(data));
+}
+
 void TcpConnection::socketRead() {
-	Expects(_leftBytes > 0 || !_usingLargeBuffer);
+	Expects(_leftBytes > 0 || _largePacket.empty());
 
 	if (_socket.state() != QAbstractSocket::ConnectedState) {
 		LOG(("MTP error: "
@@ -310,14 +339,18 @@ void TcpConnection::socketRead() {
 		_smallBuffer.resize(kSmallBufferSize);
 	}
 	do {
+		const auto readingLarge = !_largePacket.empty();
 		const auto readLimit = (_leftBytes > 0)
 			? _leftBytes
 			: (kSmallBufferSize - _offsetBytes - _readBytes);
 		Assert(readLimit > 0);
 
-		auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-		const auto full = bytes::make_span(buffer).subspan(_offsetBytes);
-		const auto free = full.subspan(_readBytes);
+		const auto full = readingLarge
+			? bytes::make_span(_largePacket)
+			: bytes::make_span(_smallBuffer).subspan(_offsetBytes);
+		const auto free = full.subspan(readingLarge
+			? _largePacketFilled
+			: _readBytes);
 		Assert(free.size() >= readLimit);
 
 		const auto readCount = _socket.read(
@@ -328,14 +361,27 @@ void TcpConnection::socketRead() {
 			aesCtrEncrypt(read, _receiveKey, &_receiveState);
 			TCP_LOG(("TCP Info: read %1 bytes").arg(readCount));
 
+			if (readingLarge) {
+				Assert(readCount <= _leftBytes);
+				_largePacketFilled += readCount;
+				_leftBytes -= readCount;
+				if (!_leftBytes) {
+					finishLargePacket();
+				} else {
+					TCP_LOG(("TCP Info: not enough %1 for large packet! "
+						"read %2"
+						).arg(_leftBytes
+						).arg(_largePacketFilled));
+					emit receivedSome();
+				}
+				continue;
+			}
 			_readBytes += readCount;
 			if (_leftBytes > 0) {
 				Assert(readCount <= _leftBytes);
 				_leftBytes -= readCount;
 				if (!_leftBytes) {
 					socketPacket(full.subspan(0, _readBytes));
-					_usingLargeBuffer = false;
-					_largeBuffer.clear();
 					_offsetBytes = _readBytes = 0;
 				} else {
 					TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
@@ -367,8 +413,13 @@ void TcpConnection::socketRead() {
 					} else {
 						_leftBytes = packetSize - available.size();
 
-						// If the next packet won't fit in the buffer.
-						ensureAvailableInBuffer(packetSize);
+						if (packetSize > _smallBuffer.size()) {
+							// Read the rest directly to the packet buffer.
+							startLargePacket(available, packetSize);
+						} else {
+							// If the next packet won't fit in the buffer.
+							ensureAvailableInBuffer(packetSize);
+						}
 
 						TCP_LOG(("TCP Info: not enough %1 for packet! "
 							"full size %2 read %3"
@@ -620,8 +671,13 @@ crl::time TcpConnection::fullConnectTimeout() const {
 void TcpConnection::socketPacket(bytes::const_span bytes) {
 	if (_status == Status::Finished) return;
 
+	handlePacket(parsePacket(bytes));
+}
+
+void TcpConnection::handlePacket(mtpBuffer &&data) {
+	if (_status == Status::Finished) return;
+
 	// old quickack?..
-	const auto data = parsePacket(bytes);
 	if (data.size() == 1) {
 		if (data[0] != 0) {
 			emit error(data[0]);
@@ -631,7 +687,7 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 	//} else if (data.size() == 2) {
 		// new quickack?..
 	} else if (_status == Status::Ready) {
-		_receivedQueue.push_back(data);
+		_receivedQueue.push_back(std::move(data));
 		emit receivedData();
 	} else if (_status == Status::Waiting) {
 		try {
@@ -51,6 +51,7 @@ private:
 	void writeConnectionStart();
 
 	void socketPacket(bytes::const_span bytes);
+	void handlePacket(mtpBuffer &&data);
 
 	void socketConnected();
 	void socketDisconnected();
@@ -58,6 +59,8 @@ private:
 
 	mtpBuffer parsePacket(bytes::const_span bytes);
 	void ensureAvailableInBuffer(int amount);
+	void startLargePacket(bytes::const_span read, int packetSize);
+	void finishLargePacket();
 	static void handleError(QAbstractSocket::SocketError e, QTcpSocket &sock);
 	static uint32 fourCharsToUInt(char ch1, char ch2, char ch3, char ch4) {
 		char ch[4] = { ch1, ch2, ch3, ch4 };
@@ -73,8 +76,12 @@ private:
 	int _readBytes = 0;
 	int _leftBytes = 0;
 	bytes::vector _smallBuffer;
-	bytes::vector _largeBuffer;
-	bool _usingLargeBuffer = false;
+
+	// Packets that don't fit in _smallBuffer are read directly
+	// into the resulting mtpBuffer, without any intermediate copy.
+	mtpBuffer _largePacket;
+	int _largePacketSize = 0;
+	int _largePacketFilled = 0;
 
 	uchar _sendKey[CTRState::KeySize];
 	CTRState _sendState;
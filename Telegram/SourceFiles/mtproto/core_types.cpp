@@ -6,7 +6,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 */
 #include "mtproto/core_types.h"
 
-#include "zlib.h"
+#include "mtproto/request_buffers_pool.h"
+#include "base/zlib_inflate.h"
 
 namespace MTP {
 namespace {
@@ -35,8 +36,30 @@ uint32 CountPaddingAmountInInts(uint32 requestSize, bool extended) {
 #endif // TDESKTOP_MTPROTO_OLD
 }
 
+#ifdef TDESKTOP_MTPROTO_OLD
+constexpr auto kMaxPaddingInts = 3U;
+#else // TDESKTOP_MTPROTO_OLD
+constexpr auto kMaxPaddingInts = 6U + (0x0FU << 2);
+#endif // TDESKTOP_MTPROTO_OLD
+
+// upload.saveBigFilePart fields around the part bytes fit here.
+constexpr auto kPartRequestFieldsInts = 8U;
+
+internal::RequestBuffersPool &BuffersPool() {
+	// Never freed, request buffers may be released by static objects.
+	static const auto result = new internal::RequestBuffersPool(
+		SecureRequest::kMessageBodyPosition
+		+ kPartRequestFieldsInts
+		+ kMaxPaddingInts);
+	return *result;
+}
+
 } // namespace
 
+SecureRequestData::~SecureRequestData() {
+	BuffersPool().release(std::move(static_cast<mtpBuffer&>(*this)));
+}
+
 SecureRequest::SecureRequest(const details::SecureRequestCreateTag &tag)
 : _data(std::make_shared<SecureRequestData>(tag)) {
 }
@@ -45,7 +68,10 @@ SecureRequest SecureRequest::Prepare(uint32 size, uint32 reserveSize) {
 	const auto finalSize = std::max(size, reserveSize);
 
 	auto result = SecureRequest(details::SecureRequestCreateTag{});
-	result->reserve(kMessageBodyPosition + finalSize);
+
+	// Reserve space for the padding, so that addPadding() won't realloc.
+	static_cast<mtpBuffer&>(*result) = BuffersPool().take(
+		kMessageBodyPosition + finalSize + kMaxPaddingInts);
 	result->resize(kMessageBodyPosition);
 	result->back() = (size << 2);
 	return result;
@@ -189,6 +215,11 @@ uint32 MTPstring::innerLength() const {
 }
 
 void MTPstring::read(const mtpPrime *&from, const mtpPrime *end, mtpTypeId cons) {
+	const auto view = ReadView(from, end, cons);
+	v = QByteArray(reinterpret_cast<const char*>(view.data()), view.size());
+}
+
+bytes::const_span MTPstring::ReadView(const mtpPrime *&from, const mtpPrime *end, mtpTypeId cons) {
 	if (from + 1 > end) throw mtpErrorInsufficient();
 	if (cons != mtpc_string) throw mtpErrorUnexpected(cons, "MTPstring");
 
@@ -205,7 +236,7 @@ void MTPstring::read(const mtpPrime *&from, const mtpPrime *end, mtpTypeId cons)
 	}
 	if (from > end) throw mtpErrorInsufficient();
 
-	v = QByteArray(reinterpret_cast<const char*>(buf), l);
+	return bytes::make_span(buf, l);
 }
 
 void MTPstring::write(mtpBuffer &to) const {
@@ -294,43 +325,12 @@ void mtpTextSerializeCore(MTPStringLogger &to, const mtpPrime *&from, const mtpP
 	} break;
 
 	case mtpc_gzip_packed: {
-		MTPstring packed;
-		packed.read(from, end); // read packed string as serialized mtp string type
-		uint32 packedLen = packed.v.size(), unpackedChunk = packedLen;
-		mtpBuffer result; // * 4 because of mtpPrime type
-		result.resize(0);
-
-		z_stream stream;
-		stream.zalloc = nullptr;
-		stream.zfree = nullptr;
-		stream.opaque = nullptr;
-		stream.avail_in = 0;
-		stream.next_in = nullptr;
-		int res = inflateInit2(&stream, 16 + MAX_WBITS);
-		if (res != Z_OK) {
-			throw Exception(QString("ungzip init, code: %1").arg(res));
-		}
-		stream.avail_in = packedLen;
-		stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
-		stream.avail_out = 0;
-		while (!stream.avail_out) {
-			result.resize(result.size() + unpackedChunk);
-			stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-			stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-			int res = inflate(&stream, Z_NO_FLUSH);
-			if (res != Z_OK && res != Z_STREAM_END) {
-				inflateEnd(&stream);
-				throw Exception(QString("ungzip unpack, code: %1").arg(res));
-			}
-		}
-		if (stream.avail_out & 0x03) {
-			uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
-			throw Exception(QString("ungzip bad length, size: %1").arg(badSize));
-		}
-		result.resize(result.size() - (stream.avail_out >> 2));
-		inflateEnd(&stream);
-
-		if (result.empty()) {
+		const auto packed = MTPstring::ReadView(from, end);
+		auto result = mtpBuffer();
+		const auto code = zlib::Ungzip(packed, result);
+		if (code != Z_STREAM_END) {
+			throw Exception(QString("ungzip unpack, code: %1").arg(code));
+		} else if (result.empty()) {
 			throw Exception("ungzip void data");
 		}
 		const mtpPrime *newFrom = result.constData(), *newEnd = result.constData() + result.size();
@@ -10,6 +10,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include <QtCore/QVector>
 #include <QtCore/QString>
 #include <QtCore/QByteArray>
+#include <crl/crl_time.h>
 #include <rpl/details/callable.h>
 #include "base/basic_types.h"
 #include "base/match_method.h"
@@ -39,11 +40,15 @@ constexpr auto kLogoutDcShift = 0x02;
 constexpr auto kUpdaterDcShift = 0x03;
 constexpr auto kExportDcShift = 0x04;
 constexpr auto kExportMediaDcShift = 0x05;
+constexpr auto kPrepareDcShift = 0x06;
 constexpr auto kMaxMediaDcCount = 0x10;
 constexpr auto kBaseDownloadDcShift = 0x10;
 constexpr auto kBaseUploadDcShift = 0x20;
 constexpr auto kDestroyKeyStartDcShift = 0x100;
 
+// Pass as msCanWait to skip the requests batching window.
+constexpr auto kSendImmediately = crl::time(-1);
+
 constexpr DcId BareDcId(ShiftedDcId shiftedDcId) {
 	return (shiftedDcId % kDcShift);
 }
@@ -346,6 +351,11 @@ class SecureRequestData : public mtpBuffer {
 public:
 	explicit SecureRequestData(const details::SecureRequestCreateTag &) {
 	}
+	SecureRequestData(const SecureRequestData &other) = delete;
+	SecureRequestData &operator=(const SecureRequestData &other) = delete;
+
+	// Returns the buffer storage to the request buffers pool.
+	~SecureRequestData();
 
 	// in toSend: = 0 - must send in container, > 0 - can send without container
 	// in haveSent: = 0 - container with msgIds, > 0 - when was sent
@@ -650,6 +660,9 @@ public:
 		return mtpc_string;
 	}
 	void read(const mtpPrime *&from, const mtpPrime *end, mtpTypeId cons = mtpc_string);
+
+	// Same as read(), but points inside the serialized data without a copy.
+	static bytes::const_span ReadView(const mtpPrime *&from, const mtpPrime *end, mtpTypeId cons = mtpc_string);
 	void write(mtpBuffer &to) const;
 
 	QByteArray v;
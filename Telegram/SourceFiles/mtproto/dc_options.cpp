@@ -11,6 +11,9 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 namespace MTP {
 namespace {
 
+// Don't remember anything slower than the full connection timeout.
+constexpr auto kMaxRememberedRtt = 8 * crl::time(1000);
+
 const char *(PublicRSAKeys[]) = { "\
 -----BEGIN RSA PUBLIC KEY-----\n\
 MIIBCgKCAQEAwVACPi9w23mF3tBkdZz+zwrzKOaaQdr01vAbU4E1pvkfj4sqDsm6\n\
@@ -370,6 +373,19 @@ QByteArray DcOptions::serialize() const {
 		}
 	}
 
+	// Measured round trip times.
+	auto rttsCount = 0;
+	size += sizeof(qint32);
+	for (const auto &[key, rtt] : _rtts) {
+		if (isTemporaryDcId(key.dcId)) {
+			continue;
+		}
+		++rttsCount;
+		// id + port + rtt
+		size += sizeof(qint32) + sizeof(qint32) + sizeof(qint32);
+		size += sizeof(qint32) + key.ip.size();
+	}
+
 	constexpr auto kVersion = 1;
 
 	auto result = QByteArray();
@@ -405,6 +421,19 @@ QByteArray DcOptions::serialize() const {
 				<< Serialize::bytes(key.n)
 				<< Serialize::bytes(key.e);
 		}
+
+		// Measured round trip times.
+		stream << qint32(rttsCount);
+		for (const auto &[key, rtt] : _rtts) {
+			if (isTemporaryDcId(key.dcId)) {
+				continue;
+			}
+			stream << qint32(key.dcId)
+				<< qint32(key.port)
+				<< qint32(rtt)
+				<< qint32(key.ip.size());
+			stream.writeRawData(key.ip.data(), key.ip.size());
+		}
 	}
 	return result;
 }
@@ -428,14 +457,15 @@ void DcOptions::constructFromSerialized(const QByteArray &serialized) {
 		return;
 	}
 
+	// https://stackoverflow.com/questions/1076714/max-length-for-client-ip-address
+	constexpr auto kMaxIpSize = 45;
+
 	WriteLocker lock(this);
 	_data.clear();
+	_rtts.clear();
 	for (auto i = 0; i != count; ++i) {
 		qint32 id = 0, flags = 0, port = 0, ipSize = 0;
 		stream >> id >> flags >> port >> ipSize;
-
-		// https://stackoverflow.com/questions/1076714/max-length-for-client-ip-address
-		constexpr auto kMaxIpSize = 45;
 		if (ipSize <= 0 || ipSize > kMaxIpSize) {
 			LOG(("MTP Error: Bad data inside DcOptions::constructFromSerialized()"));
 			return;
@@ -499,6 +529,34 @@ void DcOptions::constructFromSerialized(const QByteArray &serialized) {
 			}
 		}
 	}
+
+	// Read measured round trip times.
+	if (!stream.atEnd()) {
+		auto count = qint32(0);
+		stream >> count;
+		if (stream.status() != QDataStream::Ok) {
+			LOG(("MTP Error: Bad data for RTTs in DcOptions::constructFromSerialized()"));
+			return;
+		}
+
+		for (auto i = 0; i != count; ++i) {
+			qint32 dcId = 0, port = 0, rtt = 0, ipSize = 0;
+			stream >> dcId >> port >> rtt >> ipSize;
+			if (ipSize <= 0 || ipSize > kMaxIpSize) {
+				LOG(("MTP Error: Bad data for RTTs inside DcOptions::constructFromSerialized()"));
+				return;
+			}
+			auto ip = std::string(ipSize, ' ');
+			stream.readRawData(ip.data(), ipSize);
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("MTP Error: Bad data for RTTs inside DcOptions::constructFromSerialized()"));
+				return;
+			}
+			if (rtt > 0 && rtt <= kMaxRememberedRtt) {
+				_rtts.emplace(EndpointKey{ DcId(dcId), ip, port }, rtt);
+			}
+		}
+	}
 }
 
 DcOptions::Ids DcOptions::configEnumDcIds() const {
@@ -612,10 +670,57 @@ auto DcOptions::lookup(
 		if (throughProxy) {
 			FilterIfHasWithFlag(result, Flag::f_static);
 		}
+		sortByRtt(result);
 	}
 	return result;
 }
 
+void DcOptions::sortByRtt(Variants &variants) const {
+	if (_rtts.empty()) {
+		return;
+	}
+	const auto rtt = [&](const Endpoint &endpoint) {
+		const auto i = _rtts.find({ endpoint.id, endpoint.ip, endpoint.port });
+		return (i != end(_rtts))
+			? i->second
+			: std::numeric_limits<crl::time>::max();
+	};
+	for (auto &byAddress : variants.data) {
+		for (auto &list : byAddress) {
+			ranges::stable_sort(list, std::less<>(), rtt);
+		}
+	}
+}
+
+void DcOptions::setEndpointRtt(
+		DcId dcId,
+		const std::string &ip,
+		int port,
+		crl::time rtt) {
+	if (rtt <= 0 || ip.empty()) {
+		return;
+	}
+	accumulate_min(rtt, kMaxRememberedRtt);
+
+	WriteLocker lock(this);
+	auto &remembered = _rtts[EndpointKey{ dcId, ip, port }];
+
+	// Smooth the measurements, a single slow handshake shouldn't
+	// push the endpoint to the end of the list.
+	remembered = remembered
+		? ((remembered * 3 + rtt) / 4)
+		: rtt;
+}
+
+crl::time DcOptions::endpointRtt(
+		DcId dcId,
+		const std::string &ip,
+		int port) const {
+	ReadLocker lock(this);
+	const auto i = _rtts.find(EndpointKey{ dcId, ip, port });
+	return (i != end(_rtts)) ? i->second : crl::time(0);
+}
+
 void DcOptions::FilterIfHasWithFlag(Variants &variants, Flag flag) {
 	const auto is = [&](const Endpoint &endpoint) {
 		return (endpoint.flags & flag) != 0;
@@ -12,6 +12,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include <string>
 #include <vector>
 #include <map>
+#include <tuple>
 
 namespace MTP {
 
@@ -88,11 +89,33 @@ public:
 	bool hasCDNKeysForDc(DcId dcId) const;
 	bool getDcRSAKey(DcId dcId, const QVector<MTPlong> &fingerprints, internal::RSAPublicKey *result) const;
 
+	// Round trip times measured on connect, lookup() puts the endpoints
+	// with the fastest remembered ones first. Zero means unknown.
+	void setEndpointRtt(
+		DcId dcId,
+		const std::string &ip,
+		int port,
+		crl::time rtt);
+	crl::time endpointRtt(DcId dcId, const std::string &ip, int port) const;
+
 	// Debug feature for now.
 	bool loadFromFile(const QString &path);
 	bool writeToFile(const QString &path) const;
 
 private:
+	struct EndpointKey {
+		DcId dcId = 0;
+		std::string ip;
+		int port = 0;
+
+		friend inline bool operator<(
+				const EndpointKey &a,
+				const EndpointKey &b) {
+			return std::tie(a.dcId, a.port, a.ip)
+				< std::tie(b.dcId, b.port, b.ip);
+		}
+	};
+
 	bool applyOneGuarded(
 		DcId dcId,
 		Flags flags,
@@ -110,6 +133,7 @@ private:
 		const std::map<DcId, std::vector<Endpoint>> &a,
 		const std::map<DcId, std::vector<Endpoint>> &b);
 	static void FilterIfHasWithFlag(Variants &variants, Flag flag);
+	void sortByRtt(Variants &variants) const;
 
 	void processFromList(const QVector<MTPDcOption> &options, bool overwrite);
 	void computeCdnDcIds();
@@ -126,6 +150,7 @@ private:
 	std::set<DcId> _cdnDcIds;
 	std::map<uint64, internal::RSAPublicKey> _publicKeys;
 	std::map<DcId, std::map<uint64, internal::RSAPublicKey>> _cdnPublicKeys;
+	std::map<EndpointKey, crl::time> _rtts;
 	mutable QReadWriteLock _useThroughLockers;
 
 	mutable base::Observable<Ids> _changed;
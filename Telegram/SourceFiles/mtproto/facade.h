@@ -57,6 +57,11 @@ constexpr ShiftedDcId updaterDcId(DcId dcId) {
 	return ShiftDcId(dcId, kUpdaterDcShift);
 }
 
+// send(MTPusers_GetUsers(), MTP::prepareDcId(dc)) - for media dc key creation
+constexpr ShiftedDcId prepareDcId(DcId dcId) {
+	return ShiftDcId(dcId, kPrepareDcShift);
+}
+
 constexpr auto kDownloadSessionsCount = 2;
 constexpr auto kUploadSessionsCount = 2;
 
@@ -215,6 +220,12 @@ inline void stopSession(ShiftedDcId shiftedDcId) {
 	}
 }
 
+inline void prepareDownloadDc(DcId dcId) {
+	if (const auto instance = MainInstance()) {
+		instance->prepareDownloadDc(dcId);
+	}
+}
+
 inline int32 state(mtpRequestId requestId) { // < 0 means waiting for such count of ms
 	return MainInstance()->state(requestId);
 }
@@ -13,6 +13,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "mtproto/special_config_request.h"
 #include "mtproto/connection.h"
 #include "mtproto/sender.h"
+#include "mtproto/network_stats.h"
 #include "mtproto/rsa_public_key.h"
 #include "storage/localstorage.h"
 #include "calls/calls_instance.h"
@@ -32,6 +33,7 @@ namespace {
 
 constexpr auto kConfigBecomesOldIn = 2 * 60 * crl::time(1000);
 constexpr auto kConfigBecomesOldForBlockedIn = 8 * crl::time(1000);
+constexpr auto kDefaultRequestsBatchingWindow = crl::time(5);
 
 } // namespace
 
@@ -52,6 +54,7 @@ public:
 	void addKeysForDestroy(AuthKeysList &&keys);
 
 	not_null<DcOptions*> dcOptions();
+	not_null<NetworkStats*> stats();
 
 	// Thread safe.
 	QString deviceModel() const;
@@ -75,6 +78,7 @@ public:
 	void stopSession(ShiftedDcId shiftedDcId);
 	void reInitConnection(DcId dcId);
 	void logout(RPCDoneHandlerPtr onDone, RPCFailHandlerPtr onFail);
+	void prepareDownloadDc(DcId dcId);
 
 	std::shared_ptr<internal::Dcenter> getDcById(ShiftedDcId shiftedDcId);
 	void unpaused();
@@ -91,6 +95,8 @@ public:
 		crl::time msCanWait,
 		bool needsLayer,
 		mtpRequestId afterRequestId);
+	void setRequestsBatchingWindow(crl::time window);
+	crl::time requestsBatchingWindow() const;
 	void registerRequest(mtpRequestId requestId, ShiftedDcId shiftedDcId);
 	void unregisterRequest(mtpRequestId requestId);
 	void storeRequest(
@@ -152,6 +158,7 @@ private:
 
 	void logoutGuestDcs();
 	bool logoutGuestDone(mtpRequestId requestId);
+	void prepareDownloadDcDone(DcId dcId);
 
 	void requestConfigIfExpired();
 	void configLoadDone(const MTPConfig &result);
@@ -198,6 +205,7 @@ private:
 	mutable QReadWriteLock _keysForWriteLock;
 
 	std::map<ShiftedDcId, mtpRequestId> _logoutGuestRequestIds;
+	base::flat_set<DcId> _preparedDownloadDcs;
 
 	// holds dcWithShift for request to this dc or -dc for request to main dc
 	std::map<mtpRequestId, ShiftedDcId> _requestsByDc;
@@ -213,6 +221,9 @@ private:
 	QReadWriteLock _requestMapLock;
 
 	std::deque<std::pair<mtpRequestId, crl::time>> _delayedRequests;
+	crl::time _requestsBatchingWindow = kDefaultRequestsBatchingWindow;
+
+	NetworkStats _stats;
 
 	std::map<mtpRequestId, int> _requestsDelays;
 
@@ -645,6 +656,43 @@ bool Instance::Private::logoutGuestDone(mtpRequestId requestId) {
 	return false;
 }
 
+void Instance::Private::prepareDownloadDc(DcId dcId) {
+	if (!isNormal()
+		|| !dcId
+		|| dcId == mainDcId()
+		|| !hasAuthorization()
+		|| dcOptions()->dcType(dcId) == DcType::Cdn
+		|| !_preparedDownloadDcs.emplace(dcId).second) {
+		return;
+	}
+	{
+		QReadLocker lock(&_keysForWriteLock);
+		if (_keysForWrite.find(dcId) != _keysForWrite.cend()) {
+			return;
+		}
+	}
+
+	// Any request that needs authorization makes the session create
+	// the key on its connection thread and then import the authorization.
+	// The key is shared by all sessions of this dc, so this one is killed.
+	DEBUG_LOG(("MTP Info: preparing download dc %1").arg(dcId));
+	_instance->send(MTPusers_GetUsers(
+		MTP_vector<MTPInputUser>(1, MTP_inputUserSelf())
+	), rpcDone([=] {
+		prepareDownloadDcDone(dcId);
+	}), rpcFail([=](const RPCError &error) {
+		if (MTP::isDefaultHandledError(error)) {
+			return false;
+		}
+		prepareDownloadDcDone(dcId);
+		return true;
+	}), MTP::prepareDcId(dcId));
+}
+
+void Instance::Private::prepareDownloadDcDone(DcId dcId) {
+	killSession(MTP::prepareDcId(dcId));
+}
+
 std::shared_ptr<internal::Dcenter> Instance::Private::getDcById(ShiftedDcId shiftedDcId) {
 	auto it = _dcenters.find(shiftedDcId);
 	if (it == _dcenters.cend()) {
@@ -718,6 +766,10 @@ not_null<DcOptions*> Instance::Private::dcOptions() {
 	return _dcOptions;
 }
 
+not_null<NetworkStats*> Instance::Private::stats() {
+	return &_stats;
+}
+
 QString Instance::Private::deviceModel() const {
 	return _deviceModel;
 }
@@ -878,6 +930,7 @@ void Instance::Private::checkDelayedRequests() {
 			request = it->second;
 		}
 		const auto session = getSession(qAbs(dcWithShift));
+		_stats.requestRetried(requestId);
 		session->sendPrepared(request);
 	}
 
@@ -910,7 +963,27 @@ void Instance::Private::sendRequest(
 	request->msDate = crl::now(); // > 0 - can send without container
 	request->needsLayer = needsLayer;
 
-	session->sendPrepared(request, msCanWait);
+	const auto canWait = (msCanWait == kSendImmediately)
+		? crl::time(0)
+		: msCanWait
+		? msCanWait
+		: _requestsBatchingWindow;
+	_stats.requestSent(
+		requestId,
+		realShiftedDcId,
+		(*request)[SecureRequest::kMessageBodyPosition],
+		request->size() * sizeof(mtpPrime));
+	session->sendPrepared(request, canWait);
+}
+
+void Instance::Private::setRequestsBatchingWindow(crl::time window) {
+	Expects(window >= 0);
+
+	_requestsBatchingWindow = window;
+}
+
+crl::time Instance::Private::requestsBatchingWindow() const {
+	return _requestsBatchingWindow;
 }
 
 void Instance::Private::registerRequest(
@@ -924,6 +997,7 @@ void Instance::Private::unregisterRequest(mtpRequestId requestId) {
 	DEBUG_LOG(("MTP Info: unregistering request %1.").arg(requestId));
 
 	_requestsDelays.erase(requestId);
+	_stats.requestFinished(requestId);
 
 	{
 		QWriteLocker locker(&_requestMapLock);
@@ -1035,6 +1109,8 @@ void Instance::Private::execCallback(
 		mtpRequestId requestId,
 		const mtpPrime *from,
 		const mtpPrime *end) {
+	_stats.responseReceived(requestId, (end - from) * sizeof(mtpPrime));
+
 	RPCResponseHandler h;
 	{
 		QMutexLocker locker(&_parserMapLock);
@@ -1053,6 +1129,7 @@ void Instance::Private::execCallback(
 				).arg(error.code()
 				).arg(error.type()
 				).arg(error.description()));
+			_stats.errorReceived(requestId, error);
 			if (rpcErrorOccured(requestId, h, error)) {
 				unregisterRequest(requestId);
 			} else {
@@ -1280,6 +1357,7 @@ bool Instance::Private::onErrorDefault(mtpRequestId requestId, const RPCError &e
 			request = it->second;
 		}
 		const auto session = getSession(newdcWithShift);
+		_stats.requestRedirected(requestId, session->getDcWithShift());
 		registerRequest(
 			requestId,
 			(dcWithShift < 0) ? -newdcWithShift : newdcWithShift);
@@ -1638,6 +1716,10 @@ void Instance::reInitConnection(DcId dcId) {
 	_private->reInitConnection(dcId);
 }
 
+void Instance::prepareDownloadDc(DcId dcId) {
+	_private->prepareDownloadDc(dcId);
+}
+
 void Instance::logout(RPCDoneHandlerPtr onDone, RPCFailHandlerPtr onFail) {
 	_private->logout(onDone, onFail);
 }
@@ -1662,6 +1744,10 @@ not_null<DcOptions*> Instance::dcOptions() {
 	return _private->dcOptions();
 }
 
+not_null<NetworkStats*> Instance::stats() {
+	return _private->stats();
+}
+
 QString Instance::deviceModel() const {
 	return _private->deviceModel();
 }
@@ -1761,6 +1847,14 @@ void Instance::sendAnything(ShiftedDcId shiftedDcId, crl::time msCanWait) {
 	session->sendAnything(msCanWait);
 }
 
+void Instance::setRequestsBatchingWindow(crl::time window) {
+	_private->setRequestsBatchingWindow(window);
+}
+
+crl::time Instance::requestsBatchingWindow() const {
+	return _private->requestsBatchingWindow();
+}
+
 Instance::~Instance() {
 	_private->prepareToDestroy();
 }
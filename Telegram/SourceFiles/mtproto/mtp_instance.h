@@ -18,6 +18,7 @@ class Connection;
 } // namespace internal
 
 class DcOptions;
+class NetworkStats;
 class AuthKey;
 using AuthKeyPtr = std::shared_ptr<AuthKey>;
 using AuthKeysList = std::vector<AuthKeyPtr>;
@@ -66,6 +67,9 @@ public:
 
 	not_null<DcOptions*> dcOptions();
 
+	// Thread safe.
+	not_null<NetworkStats*> stats();
+
 	template <typename Request>
 	mtpRequestId send(
 			const Request &request,
@@ -136,6 +140,11 @@ public:
 
 	void sendAnything(ShiftedDcId shiftedDcId = 0, crl::time msCanWait = 0);
 
+	// Requests sent with msCanWait == 0 wait up to this amount of time,
+	// so that a burst of them is packed into a single container.
+	void setRequestsBatchingWindow(crl::time window);
+	crl::time requestsBatchingWindow() const;
+
 	void restart();
 	void restart(ShiftedDcId shiftedDcId);
 	int32 dcstate(ShiftedDcId shiftedDcId = 0);
@@ -148,6 +157,10 @@ public:
 	void reInitConnection(DcId dcId);
 	void logout(RPCDoneHandlerPtr onDone, RPCFailHandlerPtr onFail);
 
+	// Creates the key and imports the authorization for a media dc in
+	// advance, so that the first download from it doesn't wait for them.
+	void prepareDownloadDc(DcId dcId);
+
 	std::shared_ptr<internal::Dcenter> getDcById(ShiftedDcId shiftedDcId);
 	void unpaused();
 
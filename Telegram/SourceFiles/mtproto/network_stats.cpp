@@ -0,0 +1,234 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "mtproto/network_stats.h"
+
+#include "mtproto/rpc_sender.h"
+
+namespace MTP {
+namespace {
+
+constexpr auto kTopMethodsInSummary = 10;
+
+QString FormatBytes(int64 bytes) {
+	if (bytes >= 1024 * 1024) {
+		return QString::number(bytes / (1024. * 1024.), 'f', 1) + " MB";
+	} else if (bytes >= 1024) {
+		return QString::number(bytes / 1024., 'f', 1) + " KB";
+	}
+	return QString::number(bytes) + " B";
+}
+
+QString FormatCounters(const NetworkStats::Counters &counters) {
+	return qsl("requests %1, errors %2, retries %3, flood %4, "
+		"sent %5, received %6, latency %7"
+	).arg(counters.requests
+	).arg(counters.errors
+	).arg(counters.retries
+	).arg(counters.floodWaits
+	).arg(FormatBytes(counters.bytesSent)
+	).arg(FormatBytes(counters.bytesReceived)
+	).arg(counters.latency.toString());
+}
+
+QString FormatMethod(mtpTypeId method) {
+	return qsl("0x%1").arg(method, 8, 16, QChar('0'));
+}
+
+} // namespace
+
+void LatencyHistogram::add(crl::time latency) {
+	latency = std::max(latency, crl::time(0));
+
+	auto index = 0;
+	for (auto limit = kFirstBucketLimit
+		; index + 1 < kBucketsCount && latency > limit
+		; limit *= 2) {
+		++index;
+	}
+	++_buckets[index];
+	++_count;
+	_total += latency;
+	accumulate_max(_maximum, latency);
+}
+
+crl::time LatencyHistogram::average() const {
+	return _count ? (_total / _count) : 0;
+}
+
+crl::time LatencyHistogram::percentile(int percent) const {
+	if (!_count) {
+		return 0;
+	}
+	const auto needed = std::max(
+		(int64(_count) * snap(percent, 0, 100) + 99) / 100,
+		int64(1));
+	auto collected = int64(0);
+	auto limit = kFirstBucketLimit;
+	for (auto index = 0; index + 1 < kBucketsCount; ++index) {
+		collected += _buckets[index];
+		if (collected >= needed) {
+			return std::min(limit, _maximum);
+		}
+		limit *= 2;
+	}
+	return _maximum;
+}
+
+QString LatencyHistogram::toString() const {
+	if (!_count) {
+		return qsl("none");
+	}
+	return qsl("avg %1ms, p50 %2ms, p90 %3ms, p99 %4ms, max %5ms"
+	).arg(average()
+	).arg(percentile(50)
+	).arg(percentile(90)
+	).arg(percentile(99)
+	).arg(_maximum);
+}
+
+void NetworkStats::requestSent(
+		mtpRequestId requestId,
+		ShiftedDcId shiftedDcId,
+		mtpTypeId method,
+		int bytes) {
+	QMutexLocker lock(&_mutex);
+	_pending[requestId] = Pending{ crl::now(), shiftedDcId, method };
+	auto &counters = _byMethod[method];
+	++counters.requests;
+	counters.bytesSent += bytes;
+	++_byDc[shiftedDcId].requests;
+}
+
+void NetworkStats::requestRedirected(
+		mtpRequestId requestId,
+		ShiftedDcId shiftedDcId) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _pending.find(requestId);
+	if (i != _pending.end()) {
+		i->second.shiftedDcId = shiftedDcId;
+		i->second.sent = crl::now();
+	}
+}
+
+void NetworkStats::requestRetried(mtpRequestId requestId) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _pending.find(requestId);
+	if (i != _pending.end()) {
+		++_byDc[i->second.shiftedDcId].retries;
+		++_byMethod[i->second.method].retries;
+		i->second.sent = crl::now();
+	}
+}
+
+void NetworkStats::responseReceived(mtpRequestId requestId, int bytes) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _pending.find(requestId);
+	if (i == _pending.end()) {
+		return;
+	}
+	const auto latency = crl::now() - i->second.sent;
+	_byDc[i->second.shiftedDcId].latency.add(latency);
+
+	auto &counters = _byMethod[i->second.method];
+	counters.latency.add(latency);
+	counters.bytesReceived += bytes;
+}
+
+void NetworkStats::errorReceived(
+		mtpRequestId requestId,
+		const RPCError &error) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _pending.find(requestId);
+	if (i == _pending.end()) {
+		return;
+	}
+	const auto flood = isFloodError(error) ? 1 : 0;
+	auto &dc = _byDc[i->second.shiftedDcId];
+	++dc.errors;
+	dc.floodWaits += flood;
+	auto &method = _byMethod[i->second.method];
+	++method.errors;
+	method.floodWaits += flood;
+}
+
+void NetworkStats::requestFinished(mtpRequestId requestId) {
+	QMutexLocker lock(&_mutex);
+	_pending.remove(requestId);
+}
+
+void NetworkStats::messageResent(ShiftedDcId shiftedDcId) {
+	QMutexLocker lock(&_mutex);
+	++_byDc[shiftedDcId].retries;
+}
+
+void NetworkStats::packetSent(ShiftedDcId shiftedDcId, int bytes) {
+	QMutexLocker lock(&_mutex);
+	_byDc[shiftedDcId].bytesSent += bytes;
+}
+
+void NetworkStats::packetReceived(ShiftedDcId shiftedDcId, int bytes) {
+	QMutexLocker lock(&_mutex);
+	_byDc[shiftedDcId].bytesReceived += bytes;
+}
+
+auto NetworkStats::byDc() const -> base::flat_map<ShiftedDcId, Counters> {
+	QMutexLocker lock(&_mutex);
+	return _byDc;
+}
+
+auto NetworkStats::byMethod() const -> base::flat_map<mtpTypeId, Counters> {
+	QMutexLocker lock(&_mutex);
+	return _byMethod;
+}
+
+QString NetworkStats::summary() const {
+	QMutexLocker lock(&_mutex);
+
+	auto result = QStringList();
+	result.append(qsl("Collected for %1s, %2 requests in flight."
+	).arg((crl::now() - _startedAt) / 1000
+	).arg(_pending.size()));
+	for (const auto &[shiftedDcId, counters] : _byDc) {
+		result.append(qsl("DC %1: %2"
+		).arg(shiftedDcId
+		).arg(FormatCounters(counters)));
+	}
+
+	auto methods = std::vector<std::pair<mtpTypeId, const Counters*>>();
+	methods.reserve(_byMethod.size());
+	for (const auto &[method, counters] : _byMethod) {
+		methods.emplace_back(method, &counters);
+	}
+	ranges::sort(methods, std::greater<>(), [](const auto &pair) {
+		return pair.second->latency.count() * pair.second->latency.average();
+	});
+	if (methods.size() > kTopMethodsInSummary) {
+		methods.resize(kTopMethodsInSummary);
+	}
+	for (const auto &[method, counters] : methods) {
+		result.append(qsl("Method %1: %2"
+		).arg(FormatMethod(method)
+		).arg(FormatCounters(*counters)));
+	}
+	return result.join('\n');
+}
+
+void NetworkStats::dumpToLog() const {
+	const auto text = summary();
+	for (const auto &line : text.split('\n')) {
+		LOG(("MTP Stats: %1").arg(line));
+	}
+}
+
+void NetworkStats::clear() {
+	QMutexLocker lock(&_mutex);
+	_byDc.clear();
+	_byMethod.clear();
+	_startedAt = crl::now();
+}
+
+} // namespace MTP
@@ -0,0 +1,94 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/flat_map.h"
+
+class RPCError;
+
+namespace MTP {
+
+class LatencyHistogram {
+public:
+	// Upper bounds of the buckets are 25ms, 50ms, .., 25.6s and infinity.
+	static constexpr auto kBucketsCount = 12;
+	static constexpr auto kFirstBucketLimit = crl::time(25);
+
+	void add(crl::time latency);
+
+	int count() const {
+		return _count;
+	}
+	crl::time average() const;
+	crl::time maximum() const {
+		return _maximum;
+	}
+
+	// Approximate, takes the upper bound of the bucket.
+	crl::time percentile(int percent) const;
+
+	QString toString() const;
+
+private:
+	std::array<int, kBucketsCount> _buckets = { { 0 } };
+	int _count = 0;
+	crl::time _total = 0;
+	crl::time _maximum = 0;
+
+};
+
+// Thread safe, network events are reported from the connection threads.
+class NetworkStats {
+public:
+	struct Counters {
+		LatencyHistogram latency;
+		int64 bytesSent = 0;
+		int64 bytesReceived = 0;
+		int requests = 0;
+		int errors = 0;
+		int retries = 0;
+		int floodWaits = 0;
+	};
+
+	void requestSent(
+		mtpRequestId requestId,
+		ShiftedDcId shiftedDcId,
+		mtpTypeId method,
+		int bytes);
+	void requestRedirected(mtpRequestId requestId, ShiftedDcId shiftedDcId);
+	void requestRetried(mtpRequestId requestId);
+	void responseReceived(mtpRequestId requestId, int bytes);
+	void errorReceived(mtpRequestId requestId, const RPCError &error);
+	void requestFinished(mtpRequestId requestId);
+
+	void messageResent(ShiftedDcId shiftedDcId);
+	void packetSent(ShiftedDcId shiftedDcId, int bytes);
+	void packetReceived(ShiftedDcId shiftedDcId, int bytes);
+
+	base::flat_map<ShiftedDcId, Counters> byDc() const;
+	base::flat_map<mtpTypeId, Counters> byMethod() const;
+
+	QString summary() const;
+	void dumpToLog() const;
+	void clear();
+
+private:
+	struct Pending {
+		crl::time sent = 0;
+		ShiftedDcId shiftedDcId = 0;
+		mtpTypeId method = 0;
+	};
+
+	mutable QMutex _mutex;
+	base::flat_map<mtpRequestId, Pending> _pending;
+	base::flat_map<ShiftedDcId, Counters> _byDc;
+	base::flat_map<mtpTypeId, Counters> _byMethod;
+	crl::time _startedAt = crl::now();
+
+};
+
+} // namespace MTP
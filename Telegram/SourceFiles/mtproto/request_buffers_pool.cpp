@@ -0,0 +1,80 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "mtproto/request_buffers_pool.h"
+
+namespace MTP {
+namespace internal {
+
+RequestBuffersPool::RequestBuffersPool(uint32 overheadInts)
+: _overheadInts(overheadInts) {
+}
+
+int RequestBuffersPool::classIndex(uint32 ints) const {
+	auto result = 0;
+	while (classSize(result) < ints) {
+		if (++result == kClassesCount) {
+			return -1;
+		}
+	}
+	return result;
+}
+
+uint32 RequestBuffersPool::classSize(int index) const {
+	return (1U << (kMinBodyShift + index)) + _overheadInts;
+}
+
+int RequestBuffersPool::pooledCount(int index) const {
+	QMutexLocker lock(&_mutex);
+	return int(_free[index].size());
+}
+
+int RequestBuffersPool::pooledBytes() const {
+	QMutexLocker lock(&_mutex);
+	return _pooledBytes;
+}
+
+mtpBuffer RequestBuffersPool::take(uint32 ints) {
+	const auto index = classIndex(ints);
+	if (index >= 0) {
+		QMutexLocker lock(&_mutex);
+		auto &list = _free[index];
+		if (!list.empty()) {
+			auto result = std::move(list.back());
+			list.pop_back();
+			_pooledBytes -= result.capacity() * sizeof(mtpPrime);
+			return result;
+		}
+	}
+	auto result = mtpBuffer();
+	result.reserve((index >= 0) ? classSize(index) : ints);
+	return result;
+}
+
+void RequestBuffersPool::release(mtpBuffer &&buffer) {
+	if (!buffer.isDetached()) {
+		return;
+	}
+	const auto capacity = uint32(buffer.capacity());
+	const auto index = classIndex(capacity);
+	if (index < 0 || classSize(index) != capacity) {
+		return;
+	}
+	const auto bytes = int(capacity * sizeof(mtpPrime));
+	buffer.resize(0);
+
+	QMutexLocker lock(&_mutex);
+	auto &list = _free[index];
+	if (list.size() >= kMaxPooledPerClass
+		|| _pooledBytes + bytes > kMaxPooledBytes) {
+		return;
+	}
+	_pooledBytes += bytes;
+	list.push_back(std::move(buffer));
+}
+
+} // namespace internal
+} // namespace MTP
@@ -0,0 +1,55 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+#include <QtCore/QMutex>
+#include <array>
+#include <vector>
+
+namespace MTP {
+namespace internal {
+
+// Requests are serialized mostly on the main thread and destroyed when
+// acknowledged in the connection threads, so buffers are reused through
+// a shared locked pool of size classes.
+//
+// Each class holds a power-of-two body from 256 bytes up to 512 KB (the
+// largest file part) plus a fixed overhead for the message header and
+// padding, so that a full file part request still fits the last class.
+class RequestBuffersPool {
+public:
+	static constexpr auto kMinBodyShift = 6;
+	static constexpr auto kMaxBodyShift = 17;
+	static constexpr auto kClassesCount = kMaxBodyShift - kMinBodyShift + 1;
+	static constexpr auto kMaxPooledBytes = 4 * 1024 * 1024;
+	static constexpr auto kMaxPooledPerClass = 16;
+
+	explicit RequestBuffersPool(uint32 overheadInts);
+
+	mtpBuffer take(uint32 ints);
+	void release(mtpBuffer &&buffer);
+
+	// Smallest class that fits the ints, -1 if none does. Both take()
+	// and release() use it, a released buffer is kept only if its
+	// capacity is exactly the size of its class.
+	int classIndex(uint32 ints) const;
+	uint32 classSize(int index) const;
+	int pooledCount(int index) const;
+	int pooledBytes() const;
+
+private:
+	const uint32 _overheadInts = 0;
+
+	mutable QMutex _mutex;
+	std::array<std::vector<mtpBuffer>, kClassesCount> _free;
+	int _pooledBytes = 0;
+
+};
+
+} // namespace internal
+} // namespace MTP
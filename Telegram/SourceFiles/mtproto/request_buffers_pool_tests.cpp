@@ -0,0 +1,85 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "mtproto/request_buffers_pool.h"
+
+using namespace MTP::internal;
+
+namespace {
+
+// Message header, upload.saveBigFilePart fields and maximum padding.
+constexpr auto kOverheadInts = 8U + 8U + 66U;
+constexpr auto kFilePartInts = 512U * 1024U / sizeof(mtpPrime);
+
+// What SecureRequest::Prepare asks for when sending a 512 KB part.
+constexpr auto kFilePartRequestInts = 8U + 6U + kFilePartInts + 66U;
+
+} // namespace
+
+TEST_CASE("request buffers pool", "[request_buffers_pool]") {
+	auto pool = RequestBuffersPool(kOverheadInts);
+	constexpr auto kLast = RequestBuffersPool::kClassesCount - 1;
+	constexpr auto kPerClass = RequestBuffersPool::kMaxPooledPerClass;
+
+	SECTION("512 KB file part round trip") {
+		REQUIRE(pool.classIndex(kFilePartRequestInts) == kLast);
+
+		auto buffer = pool.take(kFilePartRequestInts);
+		REQUIRE(buffer.capacity() == int(pool.classSize(kLast)));
+		buffer.resize(kFilePartRequestInts);
+		const auto data = buffer.constData();
+
+		pool.release(std::move(buffer));
+		REQUIRE(pool.pooledCount(kLast) == 1);
+		REQUIRE(pool.pooledBytes()
+			== int(pool.classSize(kLast) * sizeof(mtpPrime)));
+
+		const auto again = pool.take(kFilePartRequestInts);
+		REQUIRE(again.constData() == data);
+		REQUIRE(again.isEmpty());
+		REQUIRE(pool.pooledCount(kLast) == 0);
+		REQUIRE(pool.pooledBytes() == 0);
+	}
+
+	SECTION("take and release use the same class") {
+		auto small = pool.take(10);
+		REQUIRE(small.capacity() == int(pool.classSize(0)));
+		pool.release(std::move(small));
+		REQUIRE(pool.pooledCount(0) == 1);
+		REQUIRE(pool.take(pool.classSize(0)).capacity()
+			== int(pool.classSize(0)));
+		REQUIRE(pool.pooledCount(0) == 0);
+	}
+
+	SECTION("unknown sizes are not pooled") {
+		auto huge = pool.take(pool.classSize(kLast) + 1);
+		REQUIRE(huge.capacity() >= int(pool.classSize(kLast) + 1));
+		pool.release(std::move(huge));
+
+		auto odd = mtpBuffer();
+		odd.reserve(int(pool.classSize(1)) + 1);
+		pool.release(std::move(odd));
+
+		REQUIRE(pool.pooledBytes() == 0);
+	}
+
+	SECTION("pooled memory is bounded") {
+		for (auto i = 0; i != kPerClass + 4; ++i) {
+			auto buffer = mtpBuffer();
+			buffer.reserve(int(pool.classSize(0)));
+			pool.release(std::move(buffer));
+		}
+		REQUIRE(pool.pooledCount(0) == kPerClass);
+		for (auto i = 0; i != 16; ++i) {
+			auto buffer = mtpBuffer();
+			buffer.reserve(int(pool.classSize(kLast)));
+			pool.release(std::move(buffer));
+		}
+		REQUIRE(pool.pooledBytes() <= RequestBuffersPool::kMaxPooledBytes);
+	}
+}
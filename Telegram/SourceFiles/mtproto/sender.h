@@ -208,6 +208,10 @@ public:
 			setCanWait(ms);
 			return *this;
 		}
+		[[nodiscard]] SpecificRequestBuilder &immediately() noexcept {
+			setCanWait(kSendImmediately);
+			return *this;
+		}
 		[[nodiscard]] SpecificRequestBuilder &done(FnMut<void(const typename Request::ResponseType &result)> callback) {
 			setDoneHandler(std::make_shared<DoneHandler<typename Request::ResponseType, DonePlainPolicy>>(sender(), std::move(callback)));
 			return *this;
@@ -9,6 +9,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "mtproto/connection.h"
 #include "mtproto/dcenter.h"
 #include "mtproto/auth_key.h"
+#include "mtproto/network_stats.h"
 #include "core/crash_reports.h"
 
 namespace MTP {
@@ -100,14 +101,12 @@ void SessionData::clear(Instance *instance) {
 				clearCallbacks.push_back(requestId);
 			}
 		}
-		for (auto i = _toResend.cbegin(), e = _toResend.cend(); i != e; ++i) {
-			auto requestId = i.value();
+		for (const auto &[msgId, requestId] : _toResend) {
 			if (!_receivedResponses.contains(requestId)) {
 				clearCallbacks.push_back(requestId);
 			}
 		}
-		for (auto i = _wereAcked.cbegin(), e = _wereAcked.cend(); i != e; ++i) {
-			auto requestId = i.value();
+		for (const auto &[msgId, requestId] : _wereAcked) {
 			if (!_receivedResponses.contains(requestId)) {
 				clearCallbacks.push_back(requestId);
 			}
@@ -488,11 +487,12 @@ mtpRequestId Session::resend(quint64 msgId, qint64 msCanWait, bool forceContaine
 		}
 		return 0xFFFFFFFF;
 	} else if (!request.isStateRequest()) {
+		_instance->stats()->messageResent(dcWithShift);
 		request->msDate = forceContainer ? 0 : crl::now();
 		sendPrepared(request, msCanWait, false);
 		{
 			QWriteLocker locker(data.toResendMutex());
-			data.toResendMap().insert(msgId, request->requestId);
+			data.toResendMap()[msgId] = request->requestId;
 		}
 		return request->requestId;
 	} else {
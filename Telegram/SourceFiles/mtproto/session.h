@@ -8,6 +8,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include "base/timer.h"
 #include "mtproto/rpc_sender.h"
+#include "mtproto/session_msg_ids.h"
 
 namespace MTP {
 
@@ -17,84 +18,12 @@ using AuthKeyPtr = std::shared_ptr<AuthKey>;
 
 namespace internal {
 
-// Received msgIds and wereAcked msgIds count stored.
-constexpr auto kIdsBufferSize = 400;
-
 class Dcenter;
 class Connection;
 
 using PreRequestMap = QMap<mtpRequestId, SecureRequest>;
 using RequestMap = QMap<mtpMsgId, SecureRequest>;
 
-class RequestIdsMap : public QMap<mtpMsgId, mtpRequestId> {
-public:
-	using ParentType = QMap<mtpMsgId, mtpRequestId>;
-
-	mtpMsgId min() const {
-		return size() ? cbegin().key() : 0;
-	}
-
-	mtpMsgId max() const {
-		ParentType::const_iterator e(cend());
-		return size() ? (--e).key() : 0;
-	}
-
-};
-
-class ReceivedMsgIds {
-public:
-	bool registerMsgId(mtpMsgId msgId, bool needAck) {
-		auto i = _idsNeedAck.constFind(msgId);
-		if (i == _idsNeedAck.cend()) {
-			if (_idsNeedAck.size() < kIdsBufferSize || msgId > min()) {
-				_idsNeedAck.insert(msgId, needAck);
-				return true;
-			}
-			MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
-		} else {
-			MTP_LOG(-1, ("No need to handle - %1 already is in map").arg(msgId));
-		}
-		return false;
-	}
-
-	mtpMsgId min() const {
-		return _idsNeedAck.isEmpty() ? 0 : _idsNeedAck.cbegin().key();
-	}
-
-	mtpMsgId max() const {
-		auto end = _idsNeedAck.cend();
-		return _idsNeedAck.isEmpty() ? 0 : (--end).key();
-	}
-
-	void shrink() {
-		auto size = _idsNeedAck.size();
-		while (size-- > kIdsBufferSize) {
-			_idsNeedAck.erase(_idsNeedAck.begin());
-		}
-	}
-
-	enum class State {
-		NotFound,
-		NeedsAck,
-		NoAckNeeded,
-	};
-	State lookup(mtpMsgId msgId) const {
-		auto i = _idsNeedAck.constFind(msgId);
-		if (i == _idsNeedAck.cend()) {
-			return State::NotFound;
-		}
-		return i.value() ? State::NeedsAck : State::NoAckNeeded;
-	}
-
-	void clear() {
-		_idsNeedAck.clear();
-	}
-
-private:
-	QMap<mtpMsgId, bool> _idsNeedAck;
-
-};
-
 using SerializedMessage = mtpBuffer;
 
 inline bool ResponseNeedsAck(const SerializedMessage &response) {
@@ -0,0 +1,113 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/basic_types.h"
+#include "base/flat_map.h"
+
+// Same as in mtproto/core_types.h, this header is used without it in tests.
+using mtpRequestId = int32;
+using mtpMsgId = uint64;
+
+namespace MTP {
+namespace internal {
+
+// Received msgIds and wereAcked msgIds count stored.
+constexpr auto kIdsBufferSize = 400;
+
+// Message ids grow with time, so almost all insertions land at the end
+// of the sorted vector and old entries are dropped from the front in one
+// batch, which keeps the bookkeeping allocation-free once warmed up.
+class RequestIdsMap : public base::flat_map<mtpMsgId, mtpRequestId> {
+public:
+	mtpMsgId min() const {
+		return empty() ? 0 : begin()->first;
+	}
+
+	mtpMsgId max() const {
+		return empty() ? 0 : back().first;
+	}
+
+	// Removes the oldest entries so that no more than limit are left,
+	// calling callback(msgId, requestId) for each removed one.
+	template <typename Callback>
+	void shrink(int limit, Callback &&callback) {
+		const auto remove = int(size()) - limit;
+		if (remove <= 0) {
+			return;
+		}
+		const auto from = begin();
+		const auto till = from + remove;
+		for (auto i = from; i != till; ++i) {
+			callback(i->first, i->second);
+		}
+		erase(from, till);
+	}
+
+};
+
+class ReceivedMsgIds {
+public:
+	enum class Result {
+		Success,
+		Duplicate,
+		TooOld,
+	};
+	Result registerMsgId(mtpMsgId msgId, bool needAck) {
+		if (_idsNeedAck.contains(msgId)) {
+			return Result::Duplicate;
+		} else if (_idsNeedAck.size() >= kIdsBufferSize && msgId <= min()) {
+			return Result::TooOld;
+		}
+		_idsNeedAck.emplace(msgId, needAck);
+		return Result::Success;
+	}
+
+	mtpMsgId min() const {
+		return _idsNeedAck.empty() ? 0 : _idsNeedAck.begin()->first;
+	}
+
+	mtpMsgId max() const {
+		return _idsNeedAck.empty() ? 0 : _idsNeedAck.back().first;
+	}
+
+	void shrink() {
+		const auto remove = int(_idsNeedAck.size()) - kIdsBufferSize;
+		if (remove > 0) {
+			const auto from = _idsNeedAck.begin();
+			_idsNeedAck.erase(from, from + remove);
+		}
+	}
+
+	enum class State {
+		NotFound,
+		NeedsAck,
+		NoAckNeeded,
+	};
+	State lookup(mtpMsgId msgId) const {
+		const auto i = _idsNeedAck.find(msgId);
+		if (i == _idsNeedAck.end()) {
+			return State::NotFound;
+		}
+		return i->second ? State::NeedsAck : State::NoAckNeeded;
+	}
+
+	int size() const {
+		return _idsNeedAck.size();
+	}
+
+	void clear() {
+		_idsNeedAck.clear();
+	}
+
+private:
+	base::flat_map<mtpMsgId, bool> _idsNeedAck;
+
+};
+
+} // namespace internal
+} // namespace MTP
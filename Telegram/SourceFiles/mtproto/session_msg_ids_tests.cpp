@@ -0,0 +1,113 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "mtproto/session_msg_ids.h"
+#include "base/benchmark.h"
+
+using namespace MTP::internal;
+
+namespace {
+
+constexpr auto kBenchmarkMessages = 1000000;
+
+// Server msg_ids are time based and a multiple of four.
+mtpMsgId MsgId(int index) {
+	return (mtpMsgId(0x5C000000) << 32) + mtpMsgId(index) * 4 + 1;
+}
+
+} // namespace
+
+TEST_CASE("received msg ids", "[session_msg_ids]") {
+	auto ids = ReceivedMsgIds();
+
+	SECTION("registering and lookup") {
+		REQUIRE(ids.registerMsgId(MsgId(1), true)
+			== ReceivedMsgIds::Result::Success);
+		REQUIRE(ids.registerMsgId(MsgId(2), false)
+			== ReceivedMsgIds::Result::Success);
+		REQUIRE(ids.registerMsgId(MsgId(1), true)
+			== ReceivedMsgIds::Result::Duplicate);
+		REQUIRE(ids.lookup(MsgId(1)) == ReceivedMsgIds::State::NeedsAck);
+		REQUIRE(ids.lookup(MsgId(2)) == ReceivedMsgIds::State::NoAckNeeded);
+		REQUIRE(ids.lookup(MsgId(3)) == ReceivedMsgIds::State::NotFound);
+		REQUIRE(ids.min() == MsgId(1));
+		REQUIRE(ids.max() == MsgId(2));
+	}
+	SECTION("out of order ids are kept sorted") {
+		ids.registerMsgId(MsgId(5), true);
+		ids.registerMsgId(MsgId(3), true);
+		ids.registerMsgId(MsgId(4), true);
+		REQUIRE(ids.min() == MsgId(3));
+		REQUIRE(ids.max() == MsgId(5));
+	}
+	SECTION("window is limited") {
+		for (auto i = 0; i != kIdsBufferSize * 2; ++i) {
+			ids.registerMsgId(MsgId(i + 1), true);
+			ids.shrink();
+		}
+		REQUIRE(ids.size() == kIdsBufferSize);
+		REQUIRE(ids.min() == MsgId(kIdsBufferSize + 1));
+		REQUIRE(ids.registerMsgId(MsgId(1), true)
+			== ReceivedMsgIds::Result::TooOld);
+		REQUIRE(ids.registerMsgId(MsgId(kIdsBufferSize * 2 + 1), true)
+			== ReceivedMsgIds::Result::Success);
+	}
+}
+
+TEST_CASE("request ids map", "[session_msg_ids]") {
+	auto map = RequestIdsMap();
+	for (auto i = 0; i != 10; ++i) {
+		map[MsgId(i)] = mtpRequestId(i + 100);
+	}
+	REQUIRE(map.min() == MsgId(0));
+	REQUIRE(map.max() == MsgId(9));
+
+	auto removed = std::vector<mtpRequestId>();
+	map.shrink(4, [&](mtpMsgId msgId, mtpRequestId requestId) {
+		removed.push_back(requestId);
+	});
+	REQUIRE(map.size() == 4);
+	REQUIRE(map.min() == MsgId(6));
+	REQUIRE(removed == std::vector<mtpRequestId>{ 100, 101, 102, 103, 104, 105 });
+
+	map.shrink(4, [](mtpMsgId msgId, mtpRequestId requestId) {
+		REQUIRE(false);
+	});
+	REQUIRE(map.size() == 4);
+}
+
+TEST_CASE("received msg ids benchmark", "[.benchmark]") {
+	using namespace base::benchmark;
+
+	auto ids = ReceivedMsgIds();
+	auto acked = RequestIdsMap();
+
+	auto index = 0;
+	auto handled = 0;
+	auto options = Options();
+	options.warmup = 1;
+	options.repetitions = 10;
+	options.iterations = kBenchmarkMessages / options.repetitions;
+	const auto name = "received msg id register and ack";
+	const auto result = Run(name, options, [&] {
+		const auto msgId = MsgId(index);
+		if (ids.registerMsgId(msgId, true)
+			== ReceivedMsgIds::Result::Success) {
+			++handled;
+		}
+		ids.shrink();
+		acked[msgId] = mtpRequestId(index);
+		if ((index % 16) == 15) {
+			acked.shrink(kIdsBufferSize, [](mtpMsgId, mtpRequestId) {});
+		}
+		++index;
+	});
+
+	REQUIRE(handled == index);
+	WARN(Format(result));
+}
@@ -23,9 +23,9 @@ struct DnsEntry {
 	crl::time TTL = 0;
 };
 
-constexpr auto kSendNextTimeout = crl::time(1000);
 constexpr auto kMinTimeToLive = 10 * crl::time(1000);
 constexpr auto kMaxTimeToLive = 300 * crl::time(1000);
+constexpr auto kKeepRefreshedTimeout = 600 * crl::time(1000);
 
 constexpr auto kPublicKey = str_const("\
 -----BEGIN RSA PUBLIC KEY-----\n\
@@ -51,6 +51,18 @@ const auto &DnsDomains() {
 	return result;
 }
 
+struct CachedSimpleConfig {
+	QByteArray bytes;
+	TimeId expires = 0;
+};
+
+// Kept for the whole app lifetime, so that each reconnect on a censored
+// network starts from the last good config instead of a fresh lookup.
+CachedSimpleConfig &SimpleConfigCache() {
+	static auto result = CachedSimpleConfig();
+	return result;
+}
+
 bool CheckPhoneByPrefixesRules(const QString &phone, const QString &rules) {
 	const auto check = QString(phone).replace(
 		QRegularExpression("[^0-9]"),
@@ -215,28 +227,27 @@ SpecialConfigRequest::SpecialConfigRequest(
 : _callback(std::move(callback))
 , _phone(phone) {
 	_manager.setProxy(QNetworkProxy::NoProxy);
-	_attempts = {
+
+	const auto &cached = SimpleConfigCache();
+	if (!cached.bytes.isEmpty() && unixtime() < cached.expires) {
+		const auto bytes = cached.bytes;
+		InvokeQueued(this, [=] {
+			handleResponse(bytes, true);
+		});
+	}
+
+	// Race all the sources, the first good response cancels the rest.
+	auto attempts = std::vector<Attempt>{
 		{ Type::App, qsl("software-download.microsoft.com") },
 	};
 	for (const auto &domain : DnsDomains()) {
-		_attempts.push_back({ Type::Dns, domain });
+		attempts.push_back({ Type::Dns, domain });
 	}
 	std::random_device rd;
-	ranges::shuffle(_attempts, std::mt19937(rd()));
-	sendNextRequest();
-}
-
-void SpecialConfigRequest::sendNextRequest() {
-	Expects(!_attempts.empty());
-
-	const auto attempt = _attempts.back();
-	_attempts.pop_back();
-	if (!_attempts.empty()) {
-		App::CallDelayed(kSendNextTimeout, this, [=] {
-			sendNextRequest();
-		});
+	ranges::shuffle(attempts, std::mt19937(rd()));
+	for (const auto &attempt : attempts) {
+		performRequest(attempt);
 	}
-	performRequest(attempt);
 }
 
 void SpecialConfigRequest::performRequest(const Attempt &attempt) {
@@ -372,7 +383,9 @@ bool SpecialConfigRequest::decryptSimpleConfig(const QByteArray &bytes) {
 	return true;
 }
 
-void SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
+void SpecialConfigRequest::handleResponse(
+		const QByteArray &bytes,
+		bool cached) {
 	if (!decryptSimpleConfig(bytes)) {
 		return;
 	}
@@ -387,6 +400,12 @@ void SpecialConfigRequest::handleResponse(const QByteArray &bytes) {
 		LOG(("Config Error: Empty simple config received."));
 		return;
 	}
+	if (!cached) {
+		SimpleConfigCache() = { bytes, config.vexpires.v };
+		for (auto &request : base::take(_requests)) {
+			request.destroy();
+		}
+	}
 	for (auto &rule : config.vrules.v) {
 		Assert(rule.type() == mtpc_accessPointRule);
 		auto &data = rule.c_accessPointRule();
@@ -438,22 +457,38 @@ void DomainResolver::resolve(const QString &domain) {
 }
 
 void DomainResolver::resolve(const AttemptKey &key) {
-	if (_attempts.find(key) != end(_attempts)) {
-		return;
-	} else if (_requests.find(key) != end(_requests)) {
+	_lastTimestamp = crl::now();
+	_requestedAt[key] = _lastTimestamp;
+	if (_requests.find(key) != end(_requests)) {
 		return;
 	}
 	const auto i = _cache.find(key);
-	_lastTimestamp = crl::now();
 	if (i != end(_cache) && i->second.expireAt > _lastTimestamp) {
 		checkExpireAndPushResult(key.domain);
 		return;
 	}
+	sendRequests(key);
+}
+
+void DomainResolver::sendRequests(const AttemptKey &key) {
+	// Race all the hosts, the first good response cancels the rest.
 	auto hosts = DnsDomains();
 	std::random_device rd;
 	ranges::shuffle(hosts, std::mt19937(rd()));
-	_attempts.emplace(key, Attempts{ std::move(hosts) });
-	sendNextRequest(key);
+	for (const auto &host : hosts) {
+		performRequest(key, host);
+	}
+}
+
+void DomainResolver::refresh(const AttemptKey &key) {
+	const auto i = _requestedAt.find(key);
+	if (i == end(_requestedAt)
+		|| i->second + kKeepRefreshedTimeout < crl::now()) {
+		return;
+	} else if (_requests.find(key) != end(_requests)) {
+		return;
+	}
+	sendRequests(key);
 }
 
 void DomainResolver::checkExpireAndPushResult(const QString &domain) {
@@ -472,24 +507,6 @@ void DomainResolver::checkExpireAndPushResult(const QString &domain) {
 	});
 }
 
-void DomainResolver::sendNextRequest(const AttemptKey &key) {
-	auto i = _attempts.find(key);
-	if (i == end(_attempts)) {
-		return;
-	}
-	auto &attempts = i->second;
-	auto &hosts = attempts.hosts;
-	const auto host = hosts.back();
-	hosts.pop_back();
-
-	if (!hosts.empty()) {
-		App::CallDelayed(kSendNextTimeout, &attempts.guard, [=] {
-			sendNextRequest(key);
-		});
-	}
-	performRequest(key, host);
-}
-
 void DomainResolver::performRequest(
 		const AttemptKey &key,
 		const QString &host) {
@@ -522,8 +539,12 @@ void DomainResolver::requestFinished(
 	if (response.empty()) {
 		return;
 	}
-	_requests.erase(key);
-	_attempts.erase(key);
+	if (const auto i = _requests.find(key); i != end(_requests)) {
+		for (auto &request : i->second) {
+			request.destroy();
+		}
+		_requests.erase(i);
+	}
 
 	auto entry = CacheEntry();
 	auto ttl = kMaxTimeToLive;
@@ -537,6 +558,11 @@ void DomainResolver::requestFinished(
 	entry.expireAt = _lastTimestamp + ttl;
 	_cache[key] = std::move(entry);
 
+	// Refresh in background a bit before the entry expires.
+	App::CallDelayed(ttl - ttl / 5, this, [=] {
+		refresh(key);
+	});
+
 	checkExpireAndPushResult(key.domain);
 }
 
@@ -42,11 +42,10 @@ private:
 		QString domain;
 	};
 
-	void sendNextRequest();
 	void performRequest(const Attempt &attempt);
 	void requestFinished(Type type, not_null<QNetworkReply*> reply);
 	QByteArray finalizeRequest(not_null<QNetworkReply*> reply);
-	void handleResponse(const QByteArray &bytes);
+	void handleResponse(const QByteArray &bytes, bool cached = false);
 	bool decryptSimpleConfig(const QByteArray &bytes);
 
 	Fn<void(
@@ -58,7 +57,6 @@ private:
 	MTPhelp_ConfigSimple _simpleConfig;
 
 	QNetworkAccessManager _manager;
-	std::vector<Attempt> _attempts;
 	std::vector<ServiceWebRequest> _requests;
 
 };
@@ -90,15 +88,11 @@ private:
 		QStringList ips;
 		crl::time expireAt = 0;
 
-	};
-	struct Attempts {
-		std::vector<QString> hosts;
-		base::has_weak_ptr guard;
-
 	};
 
 	void resolve(const AttemptKey &key);
-	void sendNextRequest(const AttemptKey &key);
+	void sendRequests(const AttemptKey &key);
+	void refresh(const AttemptKey &key);
 	void performRequest(const AttemptKey &key, const QString &host);
 	void checkExpireAndPushResult(const QString &domain);
 	void requestFinished(
@@ -114,9 +108,9 @@ private:
 		crl::time expireAt)> _callback;
 
 	QNetworkAccessManager _manager;
-	std::map<AttemptKey, Attempts> _attempts;
 	std::map<AttemptKey, std::vector<ServiceWebRequest>> _requests;
 	std::map<AttemptKey, CacheEntry> _cache;
+	std::map<AttemptKey, crl::time> _requestedAt;
 	crl::time _lastTimestamp = 0;
 
 };
@@ -378,6 +378,11 @@ void Photo::setPixFrom(not_null<Image*> image) {
 	_pix = App::pixmapFromImageInPlace(std::move(img));
 }
 
+void Photo::clearHeavyPart() {
+	_pix = QPixmap();
+	_goodLoaded = false;
+}
+
 TextState Photo::getState(
 		QPoint point,
 		StateRequest request) const {
@@ -546,6 +551,10 @@ TextState Video::getState(
 	return {};
 }
 
+void Video::clearHeavyPart() {
+	_pix = QPixmap();
+}
+
 void Video::updateStatusText() {
 	bool showPause = false;
 	int statusSize = 0;
@@ -1236,6 +1245,11 @@ TextState Document::getState(
 	return {};
 }
 
+void Document::clearHeavyPart() {
+	_thumb = QPixmap();
+	_thumbLoaded = false;
+}
+
 const style::RoundCheckbox &Document::checkboxStyle() const {
 	return st::overviewSmallCheck;
 }
@@ -1479,7 +1493,10 @@ void Link::paint(Painter &p, const QRect &clip, TextSelection selection, const P
 			if (_page->photo->thumbnail()->loaded()) {
 				pix = _page->photo->thumbnail()->pixSingle(parent()->fullId(), _pixw, _pixh, st::linksPhotoSize, st::linksPhotoSize, ImageRoundRadius::Small);
 			} else if (_page->photo->loaded()) {
-				pix = _page->photo->large()->pixSingle(parent()->fullId(), _pixw, _pixh, st::linksPhotoSize, st::linksPhotoSize, ImageRoundRadius::Small);
+				pix = _page->photo->large()->pixSingleAsync(parent()->fullId(), _pixw, _pixh, st::linksPhotoSize, st::linksPhotoSize, ImageRoundRadius::Small);
+				if (pix.isNull() && _page->photo->thumbnailSmall()->loaded()) {
+					pix = _page->photo->thumbnailSmall()->pixSingle(parent()->fullId(), _pixw, _pixh, st::linksPhotoSize, st::linksPhotoSize, ImageRoundRadius::Small);
+				}
 			} else if (_page->photo->thumbnailSmall()->loaded()) {
 				pix = _page->photo->thumbnailSmall()->pixSingle(parent()->fullId(), _pixw, _pixh, st::linksPhotoSize, st::linksPhotoSize, ImageRoundRadius::Small);
 			} else if (const auto blurred = _page->photo->thumbnailInline()) {
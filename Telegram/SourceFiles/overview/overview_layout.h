@@ -57,6 +57,10 @@ public:
 	virtual void invalidateCache() {
 	}
 
+	// Drop the prepared thumbnails, they'll be prepared again on paint.
+	virtual void clearHeavyPart() {
+	}
+
 };
 
 class ItemBase : public AbstractItem {
@@ -206,6 +210,8 @@ public:
 		QPoint point,
 		StateRequest request) const override;
 
+	void clearHeavyPart() override;
+
 private:
 	void setPixFrom(not_null<Image*> image);
 
@@ -230,6 +236,8 @@ public:
 		QPoint point,
 		StateRequest request) const override;
 
+	void clearHeavyPart() override;
+
 protected:
 	float64 dataProgress() const override;
 	bool dataFinished() const override;
@@ -301,6 +309,8 @@ public:
 		return _data;
 	}
 
+	void clearHeavyPart() override;
+
 protected:
 	float64 dataProgress() const override;
 	bool dataFinished() const override;
@@ -1739,18 +1739,39 @@ void FormController::loadFile(File &file) {
 
 void FormController::fileLoadDone(FileKey key, const QByteArray &bytes) {
 	if (const auto [value, file] = findFile(key); file != nullptr) {
-		const auto decrypted = DecryptData(
-			bytes::make_span(bytes),
-			file->hash,
-			file->secret);
-		if (decrypted.empty()) {
-			fileLoadFail(key);
-			return;
-		}
+		// Scans are large, decrypt and decode them in the background.
+		crl::async([
+			=,
+			hash = file->hash,
+			secret = file->secret,
+			weak = base::make_weak(this)
+		] {
+			const auto decrypted = DecryptData(
+				bytes::make_span(bytes),
+				hash,
+				secret);
+			auto image = decrypted.empty()
+				? QImage()
+				: ReadImage(decrypted);
+			crl::on_main(weak, [
+				=,
+				failed = decrypted.empty(),
+				image = std::move(image)
+			]() mutable {
+				if (failed) {
+					fileLoadFail(key);
+				} else {
+					fileLoadDecrypted(key, std::move(image));
+				}
+			});
+		});
+	}
+}
+
+void FormController::fileLoadDecrypted(FileKey key, QImage &&image) {
+	if (const auto [value, file] = findFile(key); file != nullptr) {
 		file->downloadOffset = file->size;
-		file->image = App::readImage(QByteArray::fromRawData(
-			reinterpret_cast<const char*>(decrypted.data()),
-			decrypted.size()));
+		file->image = std::move(image);
 		if (const auto fileInEdit = findEditFile(key)) {
 			fileInEdit->fields.image = file->image;
 			fileInEdit->fields.downloadOffset = file->downloadOffset;
@@ -543,11 +543,11 @@ void Manager::doShowNativeNotification(PeerData *peer, MsgId msgId, const QStrin
 	_private->showNotification(peer, msgId, title, subtitle, msg, hideNameAndPhoto, hideReplyButton);
 }
 
-void Manager::doClearAllFast() {
+void Manager::doClearAllNative() {
 	_private->clearAll();
 }
 
-void Manager::doClearFromHistory(History *history) {
+void Manager::doClearFromHistoryNative(History *history) {
 	_private->clearFromHistory(history);
 }
 #endif // !TDESKTOP_DISABLE_GTK_INTEGRATION
@@ -23,8 +23,8 @@ public:
 
 protected:
 	void doShowNativeNotification(PeerData *peer, MsgId msgId, const QString &title, const QString &subtitle, const QString &msg, bool hideNameAndPhoto, bool hideReplyButton) override;
-	void doClearAllFast() override;
-	void doClearFromHistory(History *history) override;
+	void doClearAllNative() override;
+	void doClearFromHistoryNative(History *history) override;
 	void onBeforeNotificationActivated(PeerId peerId, MsgId msgId) override;
 	void onAfterNotificationActivated(PeerId peerId, MsgId msgId) override;
 
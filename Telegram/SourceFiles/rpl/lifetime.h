@@ -7,7 +7,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "base/unique_function.h"
-#include <deque>
+#include <vector>
+#include <utility>
 
 namespace rpl {
 namespace details {
@@ -48,7 +49,10 @@ public:
 	~lifetime() { destroy(); }
 
 private:
-	std::deque<base::unique_function<void()>> _callbacks;
+	// Callbacks are stored in reverse order of their calling, so that
+	// add() is a cheap push_back(). Unlike std::deque an empty
+	// std::vector doesn't allocate, and most lifetimes hold one callback.
+	std::vector<base::unique_function<void()>> _callbacks;
 
 };
 
@@ -69,20 +73,25 @@ inline lifetime::lifetime(Destroy &&destroy) {
 
 template <typename Destroy, typename>
 inline void lifetime::add(Destroy &&destroy) {
-	_callbacks.push_front(destroy);
+	_callbacks.emplace_back(std::forward<Destroy>(destroy));
 }
 
 inline void lifetime::add(lifetime &&other) {
 	auto callbacks = details::take(other._callbacks);
+	if (_callbacks.empty()) {
+		_callbacks = std::move(callbacks);
+		return;
+	}
 	_callbacks.insert(
-		_callbacks.begin(),
+		_callbacks.end(),
 		std::make_move_iterator(callbacks.begin()),
 		std::make_move_iterator(callbacks.end()));
 }
 
 inline void lifetime::destroy() {
-	for (auto &callback : details::take(_callbacks)) {
-		callback();
+	auto callbacks = details::take(_callbacks);
+	for (auto i = callbacks.rbegin(), e = callbacks.rend(); i != e; ++i) {
+		(*i)();
 	}
 }
 
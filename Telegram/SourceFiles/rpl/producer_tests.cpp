@@ -104,6 +104,21 @@ TEST_CASE("basic producer tests", "[rpl::producer]") {
 		REQUIRE(*lifetimeEndCount == 2);
 	}
 
+	SECTION("lifetime destroy order test") {
+		auto order = std::make_shared<std::vector<int>>();
+		{
+			auto outer = lifetime([=] { order->push_back(1); });
+			outer.add([=] { order->push_back(2); });
+
+			auto inner = lifetime([=] { order->push_back(3); });
+			inner.add([=] { order->push_back(4); });
+			outer.add(std::move(inner));
+
+			outer.add([=] { order->push_back(5); });
+		}
+		REQUIRE(*order == std::vector<int>{ 5, 4, 3, 2, 1 });
+	}
+
 	SECTION("nested producers test") {
 		auto sum = std::make_shared<int>(0);
 		auto lifetimeEndCount = std::make_shared<int>(0);
@@ -0,0 +1,88 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include <rpl/rpl.h>
+#include "base/benchmark.h"
+
+namespace {
+
+constexpr auto kFiresCount = 1000;
+constexpr auto kSubscribersCount = 100;
+
+} // namespace
+
+TEST_CASE("rpl benchmark", "[.benchmark]") {
+	using namespace base::benchmark;
+
+	SECTION("event_stream fire to many subscribers") {
+		auto stream = rpl::event_stream<int>();
+		auto lifetime = rpl::lifetime();
+		auto sum = int64();
+		for (auto i = 0; i != kSubscribersCount; ++i) {
+			stream.events(
+			) | rpl::start_with_next([&](int value) {
+				sum += value;
+			}, lifetime);
+		}
+		WARN(Format(Run("rpl fire to subscribers", {}, [&] {
+			for (auto i = 0; i != kFiresCount; ++i) {
+				stream.fire_copy(i);
+			}
+			Consume(sum);
+		})));
+	}
+
+	SECTION("operator chain") {
+		auto stream = rpl::event_stream<int>();
+		auto lifetime = rpl::lifetime();
+		auto sum = int64();
+		stream.events(
+		) | rpl::filter([](int value) {
+			return (value % 2) == 0;
+		}) | rpl::map([](int value) {
+			return value * 3;
+		}) | rpl::distinct_until_changed(
+		) | rpl::start_with_next([&](int value) {
+			sum += value;
+		}, lifetime);
+		WARN(Format(Run("rpl operator chain", {}, [&] {
+			for (auto i = 0; i != kFiresCount; ++i) {
+				stream.fire_copy(i);
+			}
+			Consume(sum);
+		})));
+	}
+
+	SECTION("subscribe and unsubscribe") {
+		auto stream = rpl::event_stream<int>();
+		WARN(Format(Run("rpl subscribe", {}, [&] {
+			auto lifetime = rpl::lifetime();
+			for (auto i = 0; i != kSubscribersCount; ++i) {
+				stream.events(
+				) | rpl::start_with_next([](int) {
+				}, lifetime);
+			}
+		})));
+	}
+
+	SECTION("variable changes") {
+		auto variable = rpl::variable<int>(0);
+		auto lifetime = rpl::lifetime();
+		auto sum = int64();
+		variable.changes(
+		) | rpl::start_with_next([&](int value) {
+			sum += value;
+		}, lifetime);
+		WARN(Format(Run("rpl variable changes", {}, [&] {
+			for (auto i = 0; i != kFiresCount; ++i) {
+				variable = i + 1;
+			}
+			Consume(sum);
+		})));
+	}
+}
@@ -17,11 +17,14 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "core/application.h"
 #include "mtproto/mtp_instance.h"
 #include "mtproto/dc_options.h"
+#include "mtproto/network_stats.h"
 #include "core/file_utilities.h"
 #include "core/update_checker.h"
 #include "window/themes/window_theme.h"
 #include "window/themes/window_theme_editor.h"
 #include "media/audio/media_audio_track.h"
+#include "bettergram/bettergramservice.h"
+#include "bettergram/networkmetrics.h"
 
 namespace Settings {
 
@@ -113,6 +116,30 @@ auto GenerateCodes() {
 			}
 		});
 	});
+	codes.emplace(qsl("netstats"), [] {
+		if (const auto mtp = Core::App().mtp()) {
+			const auto stats = mtp->stats();
+			stats->dumpToLog();
+			Ui::show(Box<InformBox>(stats->summary()));
+		}
+	});
+	codes.emplace(qsl("bettergrammetrics"), [] {
+		const auto service = Bettergram::BettergramService::instance();
+		const auto enabled = service->networkMetrics()->isEnabled();
+		auto text = enabled
+			? qsl("Do you want to disable Bettergram network metrics?")
+			: qsl("Do you want to enable Bettergram network metrics?\n\n"
+				"Latency, size and errors of prices, news and ads requests "
+				"will be collected on this computer.");
+		Ui::show(Box<ConfirmBox>(text, [=] {
+			service->setIsNetworkMetricsEnabled(!enabled);
+			Ui::hideLayer();
+		}));
+	});
+	codes.emplace(qsl("bettergramstats"), [] {
+		const auto metrics = Bettergram::BettergramService::instance()->networkMetrics();
+		Ui::show(Box<InformBox>(metrics->summary()));
+	});
 	codes.emplace(qsl("registertg"), [] {
 		Platform::RegisterCustomScheme();
 		Ui::Toast::Show("Forced custom scheme register.");
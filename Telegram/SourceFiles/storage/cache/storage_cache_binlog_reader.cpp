@@ -29,6 +29,10 @@ bool BinlogWrapper::failed() const {
 	return _failed;
 }
 
+int64 BinlogWrapper::offset() const {
+	return _binlog.offset() - _part.size();
+}
+
 std::optional<BasicHeader> BinlogWrapper::ReadHeader(
 		File &binlog,
 		const Settings &settings) {
@@ -103,6 +107,7 @@ void BinlogWrapper::finish(size_type rollback) {
 	}
 	rollback += _part.size();
 	_binlog.seek(_binlog.offset() - rollback);
+	_part = bytes::span();
 }
 
 } // namespace details
@@ -25,6 +25,9 @@ public:
 	bool finished() const;
 	bool failed() const;
 
+	// Binlog offset right after the last record handed out.
+	int64 offset() const;
+
 	static std::optional<BasicHeader> ReadHeader(
 		File &binlog,
 		const Settings &settings);
@@ -8,11 +8,25 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include "storage/cache/storage_cache_database_object.h"
 #include "storage/cache/storage_cache_binlog_reader.h"
+#include "base/concurrent_timer.h"
 #include <unordered_set>
 
 namespace Storage {
 namespace Cache {
 namespace details {
+namespace {
+
+// Written after each chunk, so an interrupted compaction can continue
+// from the binlog offset where it stopped instead of starting over.
+struct Progress {
+	int64 till = 0;
+	int64 offset = 0;
+	int64 compactSize = 0;
+	int64 reserved = 0;
+};
+static_assert(GoodForEncryption<Progress>);
+
+} // namespace
 
 class CompactorObject {
 public:
@@ -32,14 +46,23 @@ private:
 	using Raw = DatabaseObject::Raw;
 	using RawSpan = gsl::span<const Raw>;
 	static QString CompactFilename();
+	static QString ProgressFilename();
+	static Info ResumedInfo(Info info, const std::optional<Progress> &progress);
 
 	void start();
 	QString binlogPath() const;
 	QString compactPath() const;
+	QString progressPath() const;
+	std::optional<Progress> readProgress(const Info &info) const;
+	bool writeProgress();
 	bool openBinlog();
 	bool readHeader();
 	bool openCompact();
+	bool resumeCompact();
+	bool readCompactKeys();
 	void parseChunk();
+	void parseChunkThrottled();
+	void reportProgress();
 	void fail();
 	void done(int64 till);
 	void finish();
@@ -69,11 +92,15 @@ private:
 	Settings _settings;
 	EncryptionKey _key;
 	BasicHeader _header;
+	std::optional<Progress> _progress;
 	Info _info;
 	File _binlog;
 	File _compact;
 	BinlogWrapper _wrapper;
 	size_type _partSize = 0;
+	base::ConcurrentTimer _nextChunkTimer;
+	crl::time _startedAt = 0;
+	int64 _startedFrom = 0;
 	std::unordered_set<Key> _written;
 	base::variant<
 		std::vector<MultiStore::Part>,
@@ -95,9 +122,11 @@ CompactorObject::CompactorObject(
 , _base(base)
 , _settings(settings)
 , _key(std::move(key))
-, _info(info)
+, _progress(readProgress(info))
+, _info(ResumedInfo(info, _progress))
 , _wrapper(_binlog, _settings, _info.till)
-, _partSize(_settings.maxBundledRecords) { // Perhaps a better estimate?
+, _partSize(_settings.maxBundledRecords) // Perhaps a better estimate?
+, _nextChunkTimer(_weak, [=] { parseChunk(); }) {
 	Expects(_settings.compactChunkSize > 0);
 
 	_written.reserve(_info.keysCount);
@@ -113,14 +142,25 @@ void CompactorObject::initList() {
 }
 
 void CompactorObject::start() {
-	if (!openBinlog() || !readHeader() || !openCompact()) {
+	if (!openBinlog() || !readHeader()) {
 		fail();
+		return;
+	} else if (!_progress || !resumeCompact()) {
+		_progress = std::nullopt;
+		_written.clear();
+		if (!openCompact()) {
+			fail();
+			return;
+		}
 	}
 	if (_settings.trackEstimatedTime) {
 		initList<MultiStoreWithTime>();
 	} else {
 		initList<MultiStore>();
 	}
+	_startedAt = crl::now();
+	_startedFrom = _binlog.offset();
+	reportProgress();
 	parseChunk();
 }
 
@@ -128,6 +168,20 @@ QString CompactorObject::CompactFilename() {
 	return QStringLiteral("binlog-temp");
 }
 
+QString CompactorObject::ProgressFilename() {
+	return QStringLiteral("binlog-temp-progress");
+}
+
+auto CompactorObject::ResumedInfo(
+	Info info,
+	const std::optional<Progress> &progress
+) -> Info {
+	if (progress) {
+		info.till = progress->till;
+	}
+	return info;
+}
+
 QString CompactorObject::binlogPath() const {
 	return _base + DatabaseObject::BinlogFilename();
 }
@@ -136,6 +190,45 @@ QString CompactorObject::compactPath() const {
 	return _base + CompactFilename();
 }
 
+QString CompactorObject::progressPath() const {
+	return _base + ProgressFilename();
+}
+
+std::optional<Progress> CompactorObject::readProgress(
+		const Info &info) const {
+	File file;
+	const auto result = file.open(progressPath(), File::Mode::Read, _key);
+	if (result != File::Result::Success) {
+		return std::nullopt;
+	}
+	auto progress = Progress();
+	if (file.read(bytes::object_as_span(&progress)) != sizeof(progress)) {
+		return std::nullopt;
+	} else if (progress.till > info.till
+		|| progress.offset < int64(sizeof(BasicHeader))
+		|| progress.offset > progress.till
+		|| progress.compactSize < int64(sizeof(BasicHeader))) {
+		return std::nullopt;
+	}
+	return progress;
+}
+
+bool CompactorObject::writeProgress() {
+	auto progress = Progress();
+	progress.till = _info.till;
+	progress.offset = _wrapper.offset();
+	progress.compactSize = _compact.size();
+
+	File file;
+	const auto result = file.open(progressPath(), File::Mode::Write, _key);
+	if (result != File::Result::Success
+		|| !file.write(bytes::object_as_span(&progress))) {
+		return false;
+	}
+	file.flush();
+	return true;
+}
+
 bool CompactorObject::openBinlog() {
 	const auto path = binlogPath();
 	const auto result = _binlog.open(path, File::Mode::Read, _key);
@@ -152,6 +245,62 @@ bool CompactorObject::readHeader() {
 	return true;
 }
 
+bool CompactorObject::resumeCompact() {
+	Expects(_progress.has_value());
+
+	const auto path = compactPath();
+	const auto result = _compact.open(path, File::Mode::ReadAppend, _key);
+	if (result != File::Result::Success
+		|| _compact.size() != _progress->compactSize) {
+		_compact.close();
+		return false;
+	} else if (!readCompactKeys()
+		|| !_compact.seek(_compact.size())
+		|| !_binlog.seek(_progress->offset)) {
+		_compact.close();
+		return false;
+	}
+	return true;
+}
+
+bool CompactorObject::readCompactKeys() {
+	const auto read = BinlogWrapper::ReadHeader(_compact, _settings);
+	if (!read || read->systemTime != _header.systemTime) {
+		return false;
+	}
+	const auto push = [&](const Store &store) {
+		_written.emplace(store.key);
+		return true;
+	};
+	const auto pushMulti = [&](const auto &element) {
+		while (const auto record = element()) {
+			push(*record);
+		}
+		return true;
+	};
+	BinlogWrapper wrapper(_compact, _settings);
+	const auto readAll = [&](auto &reader, auto &&...handlers) {
+		while (!reader.readTillEnd(handlers...)) {
+		}
+	};
+	if (_settings.trackEstimatedTime) {
+		BinlogReader<StoreWithTime, MultiStoreWithTime> reader(wrapper);
+		readAll(reader, [&](const StoreWithTime &record) {
+			return push(record);
+		}, [&](const MultiStoreWithTime &header, const auto &element) {
+			return pushMulti(element);
+		});
+	} else {
+		BinlogReader<Store, MultiStore> reader(wrapper);
+		readAll(reader, [&](const Store &record) {
+			return push(record);
+		}, [&](const MultiStore &header, const auto &element) {
+			return pushMulti(element);
+		});
+	}
+	return !wrapper.failed() && (_compact.offset() == _compact.size());
+}
+
 bool CompactorObject::openCompact() {
 	const auto path = compactPath();
 	const auto result = _compact.open(path, File::Mode::Write, _key);
@@ -166,6 +315,7 @@ bool CompactorObject::openCompact() {
 void CompactorObject::fail() {
 	_compact.close();
 	QFile(compactPath()).remove();
+	QFile(progressPath()).remove();
 	_database.with([](DatabaseObject &database) {
 		database.compactorFail();
 	});
@@ -191,6 +341,7 @@ void CompactorObject::finish() {
 void CompactorObject::finalize() {
 	_binlog.close();
 	_compact.close();
+	QFile(progressPath()).remove();
 
 	auto lastCatchUp = 0;
 	auto from = _info.till;
@@ -327,7 +478,39 @@ void CompactorObject::processValues(
 			return;
 		}
 	}
-	parseChunk();
+
+	// Everything read so far is flushed before the checkpoint.
+	if (!writeList() || !writeProgress()) {
+		fail();
+		return;
+	}
+	reportProgress();
+	parseChunkThrottled();
+}
+
+void CompactorObject::parseChunkThrottled() {
+	const auto limit = _settings.compactBytesPerSecond;
+	if (!limit) {
+		parseChunk();
+		return;
+	}
+	const auto processed = _wrapper.offset() - _startedFrom;
+	const auto planned = _startedAt + (processed * 1000) / limit;
+	const auto now = crl::now();
+	if (planned > now) {
+		_nextChunkTimer.callOnce(planned - now);
+	} else {
+		parseChunk();
+	}
+}
+
+void CompactorObject::reportProgress() {
+	_database.with([
+		processed = _wrapper.offset(),
+		total = _info.till
+	](DatabaseObject &database) {
+		database.compactorProgress(processed, total);
+	});
 }
 
 auto CompactorObject::fillList(RawSpan values) -> RawSpan {
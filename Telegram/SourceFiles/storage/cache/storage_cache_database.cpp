@@ -7,48 +7,257 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "storage/cache/storage_cache_database.h"
 
 #include "storage/cache/storage_cache_database_object.h"
+#include <crl/crl_async.h>
+#include <rpl/combine.h>
+#include <rpl/map.h>
+#include <QtCore/QMutex>
 
 namespace Storage {
 namespace Cache {
+namespace {
+
+// Calls done once, when all the shards have finished, with the first error.
+Fn<void(Error)> JoinErrors(int count, FnMut<void(Error)> &&done) {
+	if (!done) {
+		return nullptr;
+	}
+	struct State {
+		QMutex mutex;
+		int left = 0;
+		Error error;
+		FnMut<void(Error)> done;
+	};
+	const auto state = std::make_shared<State>();
+	state->left = count;
+	state->done = std::move(done);
+	return [=](Error error) {
+		auto callback = FnMut<void(Error)>();
+		{
+			QMutexLocker lock(&state->mutex);
+			if (state->error.type == Error::Type::None) {
+				state->error = error;
+			}
+			if (--state->left) {
+				return;
+			}
+			callback = std::move(state->done);
+		}
+		callback(state->error);
+	};
+}
+
+Fn<void()> JoinDone(int count, FnMut<void()> &&done) {
+	if (!done) {
+		return nullptr;
+	}
+	const auto joined = JoinErrors(count, [
+		done = std::move(done)
+	](Error) mutable {
+		done();
+	});
+	return [=] {
+		joined(Error::NoError());
+	};
+}
+
+// Before the split the whole cache lived in the folder of shard zero.
+// After every open its entries that belong to other shards are moved
+// there, a few at a time, so the old cache is kept without one long
+// blocking pass. Keys not moved yet are just misses for a while.
+constexpr auto kMigrateChunkSize = 16;
+
+struct Migration {
+	using Weak = crl::weak_on_queue<details::DatabaseObject>;
+
+	std::vector<Weak> shards;
+	std::vector<std::shared_ptr<details::KeyFilter>> filters;
+	std::vector<Key> keys;
+	std::size_t offset = 0;
+};
+
+void MigrateChunk(
+		details::DatabaseObject &first,
+		const std::shared_ptr<Migration> &migration) {
+	const auto count = int(migration->shards.size());
+	const auto left = migration->keys.size() - migration->offset;
+	if (!left) {
+		return;
+	}
+	const auto from = begin(migration->keys) + migration->offset;
+	const auto size = std::min(left, std::size_t(kMigrateChunkSize));
+	const auto chunk = std::vector<Key>(from, from + size);
+	migration->offset += size;
+
+	first.getMany(chunk, [&](std::vector<details::TaggedValue> &&values) {
+		Assert(values.size() == chunk.size());
+
+		using Values = std::vector<std::pair<Key, details::TaggedValue>>;
+		auto byShard = std::vector<Values>(count);
+		for (auto i = 0, till = int(chunk.size()); i != till; ++i) {
+			if (!values[i].bytes.isEmpty()) {
+				const auto index = details::ShardIndex(chunk[i], count);
+				byShard[index].emplace_back(chunk[i], std::move(values[i]));
+			}
+		}
+		auto next = [=](Error) {
+			migration->shards.front().with([=](
+					details::DatabaseObject &first) {
+				for (const auto &key : chunk) {
+					first.remove(key, nullptr);
+				}
+				MigrateChunk(first, migration);
+			});
+		};
+		const auto used = int(ranges::count_if(byShard, [](const auto &list) {
+			return !list.empty();
+		}));
+		if (!used) {
+			next(Error::NoError());
+			return;
+		}
+		const auto joined = JoinErrors(used, std::move(next));
+		for (auto i = 1; i != count; ++i) {
+			if (byShard[i].empty()) {
+				continue;
+			}
+			migration->shards[i].with([
+				values = std::move(byShard[i]),
+				writing = details::KeyFilter::Writing(migration->filters[i]),
+				done = joined
+			](details::DatabaseObject &unwrapped) mutable {
+				// Values put there since the start are newer, keep them.
+				for (auto &[key, value] : values) {
+					unwrapped.putIfEmpty(key, std::move(value), nullptr);
+				}
+				done(Error::NoError());
+			});
+		}
+	});
+}
+
+void StartMigration(const std::shared_ptr<Migration> &migration) {
+	const auto count = int(migration->shards.size());
+	migration->shards.front().with([=](details::DatabaseObject &first) {
+		auto keys = first.keys();
+		keys.erase(ranges::remove_if(keys, [&](const Key &key) {
+			return !details::ShardIndex(key, count);
+		}), end(keys));
+		if (keys.empty()) {
+			return;
+		}
+		migration->keys = std::move(keys);
+		MigrateChunk(first, migration);
+	});
+}
+
+} // namespace
 
 Database::Database(const QString &path, const Settings &settings)
-: _wrapped(path, settings) {
+: _settings(settings)
+, _hot(std::make_shared<details::HotTier>(
+	settings.hotSizeLimit,
+	settings.hotValueSizeLimit)) {
+	Expects(settings.shardsCount > 0);
+
+	const auto shardSettings = details::ShardSettings(settings);
+	_shards.reserve(settings.shardsCount);
+	_filters.reserve(settings.shardsCount);
+	for (auto i = 0; i != settings.shardsCount; ++i) {
+		_filters.push_back(std::make_shared<details::KeyFilter>(
+			settings.keyFilterSize));
+		_shards.push_back(std::make_unique<Shard>(
+			details::ShardPath(path, i),
+			shardSettings,
+			_filters.back()));
+	}
+}
+
+auto Database::shard(const Key &key) -> Shard& {
+	return *_shards[details::ShardIndex(key, int(_shards.size()))];
+}
+
+auto Database::writing(const Key &key) const -> details::KeyFilter::Writing {
+	const auto index = details::ShardIndex(key, int(_shards.size()));
+	return details::KeyFilter::Writing(_filters[index]);
+}
+
+bool Database::mayContain(const Key &key) const {
+	const auto index = details::ShardIndex(key, int(_filters.size()));
+	return _filters[index]->mayContain(key);
+}
+
+template <typename Method>
+void Database::withAll(Method &&method) {
+	for (const auto &shard : _shards) {
+		shard->with(method);
+	}
 }
 
 void Database::reconfigure(const Settings &settings) {
-	_wrapped.with([settings](Implementation &unwrapped) mutable {
-		unwrapped.reconfigure(settings);
+	Expects(settings.shardsCount == int(_shards.size()));
+
+	_settings = settings;
+	_hot->reconfigure(settings.hotSizeLimit, settings.hotValueSizeLimit);
+	const auto shardSettings = details::ShardSettings(settings);
+	withAll([shardSettings](Implementation &unwrapped) {
+		unwrapped.reconfigure(shardSettings);
 	});
 }
 
 void Database::updateSettings(const SettingsUpdate &update) {
-	_wrapped.with([update](Implementation &unwrapped) mutable {
-		unwrapped.updateSettings(update);
+	_settings.totalSizeLimit = update.totalSizeLimit;
+	_settings.totalTimeLimit = update.totalTimeLimit;
+	const auto shardSettings = details::ShardSettings(_settings);
+	auto shardUpdate = SettingsUpdate();
+	shardUpdate.totalSizeLimit = shardSettings.totalSizeLimit;
+	shardUpdate.totalTimeLimit = shardSettings.totalTimeLimit;
+	withAll([shardUpdate](Implementation &unwrapped) {
+		unwrapped.updateSettings(shardUpdate);
 	});
 }
 
 void Database::open(EncryptionKey &&key, FnMut<void(Error)> &&done) {
-	_wrapped.with([
-		key = std::move(key),
+	auto migration = std::shared_ptr<Migration>();
+	if (_shards.size() > 1) {
+		migration = std::make_shared<Migration>();
+		for (const auto &shard : _shards) {
+			migration->shards.push_back(shard->weak());
+		}
+		migration->filters = _filters;
+	}
+	auto opened = [
+		migration,
 		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.open(std::move(key), std::move(done));
+	](Error error) mutable {
+		if (migration && error.type == Error::Type::None) {
+			StartMigration(migration);
+		}
+		if (done) {
+			done(error);
+		}
+	};
+	withAll([
+		key = std::move(key),
+		done = JoinErrors(int(_shards.size()), std::move(opened))
+	](Implementation &unwrapped) {
+		unwrapped.open(base::duplicate(key), done);
 	});
 }
 
 void Database::close(FnMut<void()> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.close(std::move(done));
+	_hot->clear();
+	withAll([
+		done = JoinDone(int(_shards.size()), std::move(done))
+	](Implementation &unwrapped) {
+		unwrapped.close(done);
 	});
 }
 
 void Database::waitForCleaner(FnMut<void()> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.waitForCleaner(std::move(done));
+	withAll([
+		done = JoinDone(int(_shards.size()), std::move(done))
+	](Implementation &unwrapped) {
+		unwrapped.waitForCleaner(done);
 	});
 }
 
@@ -71,7 +280,8 @@ void Database::get(const Key &key, FnMut<void(QByteArray&&)> &&done) {
 }
 
 void Database::remove(const Key &key, FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->remove(key);
+	shard(key).with([
 		key,
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
@@ -93,12 +303,43 @@ void Database::copyIfEmpty(
 		const Key &from,
 		const Key &to,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->remove(to);
+	auto &source = shard(from);
+	auto &destination = shard(to);
+	if (&source == &destination) {
+		source.with([
+			from,
+			to,
+			writing = writing(to),
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.copyIfEmpty(from, to, std::move(done));
+		});
+		return;
+	}
+	source.with([
 		from,
 		to,
+		weak = destination.weak(),
+		writing = writing(to),
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
-		unwrapped.copyIfEmpty(from, to, std::move(done));
+		unwrapped.get(from, [&](TaggedValue &&value) {
+			if (value.bytes.isEmpty()) {
+				if (done) {
+					done(Error::NoError());
+				}
+				return;
+			}
+			weak.with([
+				to,
+				value = std::move(value),
+				writing = std::move(writing),
+				done = std::move(done)
+			](Implementation &unwrapped) mutable {
+				unwrapped.putIfEmpty(to, std::move(value), std::move(done));
+			});
+		});
 	});
 }
 
@@ -106,22 +347,54 @@ void Database::moveIfEmpty(
 		const Key &from,
 		const Key &to,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->remove(from);
+	_hot->remove(to);
+	auto &source = shard(from);
+	auto &destination = shard(to);
+	if (&source == &destination) {
+		source.with([
+			from,
+			to,
+			writing = writing(to),
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.moveIfEmpty(from, to, std::move(done));
+		});
+		return;
+	}
+
+	// Across the shards the value is copied and then removed from the
+	// source, even if the destination already had a value.
+	auto remove = [
 		from,
-		to,
+		weak = source.weak(),
 		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.moveIfEmpty(from, to, std::move(done));
-	});
+	](Error error) mutable {
+		if (error.type != Error::Type::None) {
+			if (done) {
+				done(error);
+			}
+			return;
+		}
+		weak.with([
+			from,
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.remove(from, std::move(done));
+		});
+	};
+	copyIfEmpty(from, to, std::move(remove));
 }
 
 void Database::put(
 		const Key &key,
 		TaggedValue &&value,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->put(key, value);
+	shard(key).with([
 		key,
 		value = std::move(value),
+		writing = writing(key),
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
 		unwrapped.put(key, std::move(value), std::move(done));
@@ -132,9 +405,11 @@ void Database::putIfEmpty(
 		const Key &key,
 		TaggedValue &&value,
 		FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->remove(key);
+	shard(key).with([
 		key,
 		value = std::move(value),
+		writing = writing(key),
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
 		unwrapped.putIfEmpty(key, std::move(value), std::move(done));
@@ -144,43 +419,199 @@ void Database::putIfEmpty(
 void Database::getWithTag(
 		const Key &key,
 		FnMut<void(TaggedValue&&)> &&done) {
-	_wrapped.with([
+	if (auto value = _hot->get(key)) {
+		// Still let the shard know, so the disk limits see the access.
+		shard(key).with([key](Implementation &unwrapped) {
+			unwrapped.access(key);
+		});
+		if (done) {
+			crl::async([
+				value = std::move(*value),
+				done = std::move(done)
+			]() mutable {
+				done(std::move(value));
+			});
+		}
+		return;
+	}
+	shard(key).with([
 		key,
+		hot = _hot,
+		generation = _hot->generation(),
 		done = std::move(done)
 	](Implementation &unwrapped) mutable {
-		unwrapped.get(key, std::move(done));
+		unwrapped.get(key, [&](TaggedValue &&value) {
+			hot->fill(key, value, generation);
+			if (done) {
+				done(std::move(value));
+			}
+		});
 	});
 }
 
+void Database::putMany(
+		std::vector<std::pair<Key, TaggedValue>> &&values,
+		FnMut<void(Error)> &&done) {
+	const auto count = int(_shards.size());
+	auto byShard = std::vector<std::vector<std::pair<Key, TaggedValue>>>(
+		count);
+	for (auto &value : values) {
+		_hot->put(value.first, value.second);
+		const auto index = details::ShardIndex(value.first, count);
+		byShard[index].push_back(std::move(value));
+	}
+	const auto used = int(ranges::count_if(byShard, [](const auto &list) {
+		return !list.empty();
+	}));
+	if (!used) {
+		if (done) {
+			done(Error::NoError());
+		}
+		return;
+	}
+	const auto joined = JoinErrors(used, std::move(done));
+	for (auto i = 0; i != count; ++i) {
+		if (byShard[i].empty()) {
+			continue;
+		}
+		_shards[i]->with([
+			values = std::move(byShard[i]),
+			writing = details::KeyFilter::Writing(_filters[i]),
+			done = joined
+		](Implementation &unwrapped) mutable {
+			unwrapped.putMany(std::move(values), done);
+		});
+	}
+}
+
+void Database::getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done) {
+	if (_shards.size() == 1) {
+		_shards.front()->with([
+			keys,
+			done = std::move(done)
+		](Implementation &unwrapped) mutable {
+			unwrapped.getMany(keys, std::move(done));
+		});
+		return;
+	}
+	const auto count = int(_shards.size());
+	auto keysByShard = std::vector<std::vector<Key>>(count);
+	auto indicesByShard = std::vector<std::vector<int>>(count);
+	for (auto i = 0, till = int(keys.size()); i != till; ++i) {
+		const auto index = details::ShardIndex(keys[i], count);
+		keysByShard[index].push_back(keys[i]);
+		indicesByShard[index].push_back(i);
+	}
+	struct State {
+		QMutex mutex;
+		std::vector<TaggedValue> result;
+		int left = 0;
+		FnMut<void(std::vector<TaggedValue>&&)> done;
+	};
+	const auto state = std::make_shared<State>();
+	state->result.resize(keys.size());
+	state->left = count;
+	state->done = std::move(done);
+	for (auto i = 0; i != count; ++i) {
+		_shards[i]->with([
+			state,
+			keys = std::move(keysByShard[i]),
+			indices = std::move(indicesByShard[i])
+		](Implementation &unwrapped) {
+			unwrapped.getMany(keys, [&](std::vector<TaggedValue> &&values) {
+				Assert(values.size() == indices.size());
+
+				auto callback = FnMut<void(std::vector<TaggedValue>&&)>();
+				{
+					QMutexLocker lock(&state->mutex);
+					for (auto j = 0, till = int(values.size()); j != till; ++j) {
+						state->result[indices[j]] = std::move(values[j]);
+					}
+					if (--state->left) {
+						return;
+					}
+					callback = std::move(state->done);
+				}
+				if (callback) {
+					callback(std::move(state->result));
+				}
+			});
+		});
+	}
+}
+
 auto Database::statsOnMain() const -> rpl::producer<Stats> {
-	return _wrapped.producer_on_main([](const Implementation &unwrapped) {
-		return unwrapped.stats();
-	});
+	const auto producer = [](const std::unique_ptr<Shard> &shard) {
+		return shard->producer_on_main([](const Implementation &unwrapped) {
+			return unwrapped.stats();
+		});
+	};
+	const auto withHot = [hot = _hot](Stats stats) {
+		stats.hot = hot->stats();
+		return stats;
+	};
+	if (_shards.size() == 1) {
+		return producer(_shards.front()) | rpl::map(withHot);
+	}
+	auto producers = std::vector<rpl::producer<Stats>>();
+	producers.reserve(_shards.size());
+	for (const auto &shard : _shards) {
+		producers.push_back(producer(shard));
+	}
+	return rpl::combine(
+		std::move(producers)
+	) | rpl::map([](const std::vector<Stats> &list) {
+		auto result = Stats();
+		for (const auto &stats : list) {
+			result.full.count += stats.full.count;
+			result.full.totalSize += stats.full.totalSize;
+			for (const auto &[tag, summary] : stats.tagged) {
+				auto &sum = result.tagged[tag];
+				sum.count += summary.count;
+				sum.totalSize += summary.totalSize;
+			}
+			result.clearing = result.clearing || stats.clearing;
+			result.clearingLeft += stats.clearingLeft;
+			result.compactProcessed += stats.compactProcessed;
+			result.compactTotal += stats.compactTotal;
+			accumulate_max(
+				result.indexReadDuration,
+				stats.indexReadDuration);
+			result.indexReplayedSize += stats.indexReplayedSize;
+		}
+		return result;
+	}) | rpl::map(withHot);
 }
 
 void Database::clear(FnMut<void(Error)> &&done) {
-	_wrapped.with([
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.clear(std::move(done));
+	_hot->clear();
+	withAll([
+		done = JoinErrors(int(_shards.size()), std::move(done))
+	](Implementation &unwrapped) {
+		unwrapped.clear(done);
 	});
 }
 
 void Database::clearByTag(uint8 tag, FnMut<void(Error)> &&done) {
-	_wrapped.with([
+	_hot->clearByTag(tag);
+	withAll([
 		tag,
-		done = std::move(done)
-	](Implementation &unwrapped) mutable {
-		unwrapped.clearByTag(tag, std::move(done));
+		done = JoinErrors(int(_shards.size()), std::move(done))
+	](Implementation &unwrapped) {
+		unwrapped.clearByTag(tag, done);
 	});
 }
 
 void Database::sync() {
 	auto semaphore = crl::semaphore();
-	_wrapped.with([&](Implementation &) {
+	withAll([&](Implementation &) {
 		semaphore.release();
 	});
-	semaphore.acquire();
+	for (auto i = 0, count = int(_shards.size()); i != count; ++i) {
+		semaphore.acquire();
+	}
 }
 
 Database::~Database() = default;
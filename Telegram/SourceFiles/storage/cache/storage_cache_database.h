@@ -7,11 +7,15 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "storage/cache/storage_cache_types.h"
+#include "storage/cache/storage_cache_hot_tier.h"
+#include "storage/cache/storage_cache_key_filter.h"
 #include "base/basic_types.h"
 #include <crl/crl_object_on_queue.h>
 #include <crl/crl_time.h>
 #include <rpl/producer.h>
 #include <QtCore/QString>
+#include <memory>
+#include <vector>
 
 namespace Storage {
 class EncryptionKey;
@@ -63,8 +67,22 @@ public:
 		FnMut<void(Error)> &&done = nullptr);
 	void getWithTag(const Key &key, FnMut<void(TaggedValue&&)> &&done);
 
+	// False only if the key surely is not in the database, it can be
+	// called from any thread and answers without a queue hop.
+	bool mayContain(const Key &key) const;
+
+	// One binlog record for all the values and one callback for all the
+	// results, which come in the order of the requested keys.
+	void putMany(
+		std::vector<std::pair<Key, TaggedValue>> &&values,
+		FnMut<void(Error)> &&done = nullptr);
+	void getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done);
+
 	using Stats = details::Stats;
 	using TaggedSummary = details::TaggedSummary;
+	using HotStats = details::HotStats;
 	rpl::producer<Stats> statsOnMain() const;
 
 	void clear(FnMut<void(Error)> &&done = nullptr);
@@ -77,7 +95,20 @@ public:
 
 private:
 	using Implementation = details::DatabaseObject;
-	crl::object_on_queue<Implementation> _wrapped;
+	using Shard = crl::object_on_queue<Implementation>;
+
+	Shard &shard(const Key &key);
+	details::KeyFilter::Writing writing(const Key &key) const;
+
+	template <typename Method>
+	void withAll(Method &&method);
+
+	Settings _settings;
+	std::vector<std::unique_ptr<Shard>> _shards;
+	std::vector<std::shared_ptr<details::KeyFilter>> _filters;
+
+	// Shared with the callbacks running on the shard queues.
+	std::shared_ptr<details::HotTier> _hot;
 
 };
 
@@ -0,0 +1,243 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "catch.hpp"
+
+#include "storage/cache/storage_cache_database.h"
+#include "storage/storage_encryption.h"
+#include "base/benchmark.h"
+#include <crl/crl.h>
+#include <QtCore/QFile>
+#include <random>
+#include <thread>
+
+using namespace Storage::Cache;
+
+namespace {
+
+constexpr auto kMegabyte = int64(1024 * 1024);
+constexpr auto kGetsCount = 20000;
+constexpr auto kCompactRemovedPart = 10; // Percent of the entries.
+constexpr auto kCompactTimeout = 600 * crl::time(1000);
+
+const auto key = Storage::EncryptionKey(bytes::make_vector(
+	bytes::make_span("\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+abcdefgh01234567abcdefgh01234567abcdefgh01234567abcdefgh01234567\
+").subspan(0, Storage::EncryptionKey::kSize)));
+
+const auto name = QString("benchmark.db");
+
+// Thumbnails, stickers and streaming slices, roughly as in the app.
+struct ValueKind {
+	int minSize = 0;
+	int maxSize = 0;
+	int weight = 0;
+	uint8 tag = 0;
+};
+const auto kValueKinds = {
+	ValueKind{ 2 * 1024, 24 * 1024, 12, 1 },
+	ValueKind{ 16 * 1024, 64 * 1024, 6, 2 },
+	ValueKind{ 128 * 1024, 512 * 1024, 1, 3 },
+};
+
+struct Entry {
+	Key key;
+	int size = 0;
+};
+
+template <typename Method>
+double Measure(Method &&method) {
+	const auto start = std::chrono::steady_clock::now();
+	method();
+	return base::benchmark::Nanoseconds(
+		std::chrono::steady_clock::now() - start);
+}
+
+std::string Megabytes(int64 bytes) {
+	return std::to_string(bytes / kMegabyte) + " MB";
+}
+
+crl::semaphore Semaphore;
+
+Error Open(Database &db) {
+	auto result = Error();
+	db.open(base::duplicate(key), [&](Error error) {
+		result = error;
+		Semaphore.release();
+	});
+	Semaphore.acquire();
+	return result;
+}
+
+void Close(Database &db) {
+	db.close([&] { Semaphore.release(); });
+	Semaphore.acquire();
+}
+
+Error Clear(Database &db) {
+	auto result = Error();
+	db.clear([&](Error error) {
+		result = error;
+		Semaphore.release();
+	});
+	Semaphore.acquire();
+	return result;
+}
+
+QString BinlogPath() {
+	QFile versionFile(name + "/version");
+	if (!versionFile.open(QIODevice::ReadOnly)) {
+		return QString();
+	}
+	const auto bytes = versionFile.readAll();
+	if (bytes.size() != 4) {
+		return QString();
+	}
+	const auto version = *reinterpret_cast<const int32*>(bytes.data());
+	return name + '/' + QString::number(version) + "/binlog";
+}
+
+std::vector<Entry> GenerateEntries(int64 totalSize, std::mt19937 &engine) {
+	auto weights = std::vector<int>();
+	for (const auto &kind : kValueKinds) {
+		weights.push_back(kind.weight);
+	}
+	auto pick = std::discrete_distribution<int>(
+		weights.begin(),
+		weights.end());
+	auto result = std::vector<Entry>();
+	auto size = int64(0);
+	while (size < totalSize) {
+		const auto &kind = *(kValueKinds.begin() + pick(engine));
+		auto value = std::uniform_int_distribution<int>(
+			kind.minSize,
+			kind.maxSize);
+		const auto index = uint64(result.size());
+		result.push_back({ Key{ index, kind.tag }, value(engine) });
+		size += result.back().size;
+	}
+	return result;
+}
+
+void RunBenchmark(int64 totalSize) {
+	using namespace base::benchmark;
+
+	auto engine = std::mt19937(0x5EED);
+	const auto entries = GenerateEntries(totalSize, engine);
+	const auto prefix = "cache db " + Megabytes(totalSize) + " ";
+
+	auto settings = Database::Settings();
+	settings.writeBundleDelay = crl::time(100);
+	settings.compactAfterExcess = 0;
+	Database db(name, settings);
+	REQUIRE(Clear(db).type == Error::Type::None);
+	REQUIRE(Open(db).type == Error::Type::None);
+
+	auto putLatencies = std::vector<double>();
+	putLatencies.reserve(entries.size());
+	for (const auto &entry : entries) {
+		auto value = Database::TaggedValue(
+			QByteArray(entry.size, char(entry.key.high)),
+			uint8(entry.key.low));
+		auto result = Error();
+		putLatencies.push_back(Measure([&] {
+			db.put(entry.key, std::move(value), [&](Error error) {
+				result = error;
+				Semaphore.release();
+			});
+			Semaphore.acquire();
+		}));
+		REQUIRE(result.type == Error::Type::None);
+	}
+	WARN(Format(Record(
+		prefix + "put",
+		std::move(putLatencies),
+		totalSize / int64(entries.size()))));
+
+	auto getLatencies = std::vector<double>();
+	getLatencies.reserve(kGetsCount);
+	auto gotSize = int64(0);
+	auto index = std::uniform_int_distribution<size_t>(
+		0,
+		entries.size() - 1);
+	for (auto i = 0; i != kGetsCount; ++i) {
+		const auto &entry = entries[index(engine)];
+		auto result = QByteArray();
+		getLatencies.push_back(Measure([&] {
+			db.get(entry.key, [&](QByteArray &&value) {
+				result = std::move(value);
+				Semaphore.release();
+			});
+			Semaphore.acquire();
+		}));
+		REQUIRE(result.size() == entry.size);
+		gotSize += result.size();
+	}
+	WARN(Format(Record(
+		prefix + "random get",
+		std::move(getLatencies),
+		gotSize / kGetsCount)));
+	Close(db);
+
+	// Full binlog replay, then the same index from a snapshot.
+	const auto replayTime = Measure([&] {
+		REQUIRE(Open(db).type == Error::Type::None);
+	});
+	Close(db);
+	WARN(Format(Record(prefix + "open with binlog replay", { replayTime })));
+	settings.snapshotAfterSize = 1;
+	db.reconfigure(settings);
+	REQUIRE(Open(db).type == Error::Type::None);
+	Close(db); // Writes the snapshot.
+	const auto snapshotTime = Measure([&] {
+		REQUIRE(Open(db).type == Error::Type::None);
+	});
+	Close(db);
+	WARN(Format(Record(prefix + "open with snapshot", { snapshotTime })));
+
+	// Compaction after a part of the entries was removed, including
+	// the write bundle delay.
+	settings.compactAfterExcess = 1;
+	db.reconfigure(settings);
+	REQUIRE(Open(db).type == Error::Type::None);
+	const auto path = BinlogPath();
+	const auto size = QFile(path).size();
+	const auto compactTime = Measure([&] {
+		const auto removed = int64(entries.size()) * kCompactRemovedPart
+			/ 100;
+		for (auto i = 0; i != removed; ++i) {
+			db.remove(entries[i].key, nullptr);
+		}
+		db.sync();
+		const auto started = crl::now();
+		while (QFile(path).size() >= size) {
+			REQUIRE(crl::now() - started < kCompactTimeout);
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	});
+	WARN(Format(Record(prefix + "compaction", { compactTime }, size)));
+
+	REQUIRE(Clear(db).type == Error::Type::None);
+	Close(db);
+}
+
+} // namespace
+
+TEST_CASE("cache db benchmark", "[.benchmark]") {
+	RunBenchmark(100 * kMegabyte);
+}
+
+TEST_CASE("large cache db benchmark", "[.benchmark][large]") {
+	SECTION("1 GB") {
+		RunBenchmark(1024 * kMegabyte);
+	}
+	SECTION("10 GB") {
+		RunBenchmark(10 * 1024 * kMegabyte);
+	}
+}
@@ -25,6 +25,20 @@ namespace details {
 namespace {
 
 constexpr auto kMaxDelayAfterFailure = 24 * 60 * 60 * crl::time(1000);
+constexpr auto kMappedPlacesLimit = 16;
+constexpr auto kFilterRebuildErased = 1024;
+constexpr auto kUseAgingMinimum = 1024;
+constexpr auto kUseAgingFactor = 8;
+
+// The map as it was when the binlog had binlogOffset bytes, followed by
+// MultiStore or MultiStoreWithTime records of all the entries.
+struct SnapshotHeader {
+	int64 binlogOffset = 0;
+	int64 excessLength = 0;
+	EstimatedTimePoint time;
+	uint32 count = 0;
+};
+static_assert(GoodForEncryption<SnapshotHeader>);
 
 uint32 CountChecksum(bytes::const_span data) {
 	const auto seed = uint32(0);
@@ -75,12 +89,15 @@ DatabaseObject::Entry::Entry(
 DatabaseObject::DatabaseObject(
 	crl::weak_on_queue<DatabaseObject> weak,
 	const QString &path,
-	const Settings &settings)
+	const Settings &settings,
+	std::shared_ptr<KeyFilter> filter)
 : _weak(std::move(weak))
 , _base(ComputeBasePath(path))
 , _settings(settings)
+, _filter(std::move(filter))
 , _writeBundlesTimer(_weak, [=] { writeBundles(); checkCompactor(); })
-, _pruneTimer(_weak, [=] { prune(); }) {
+, _pruneTimer(_weak, [=] { prune(); })
+, _staleTimer(_weak, [=] { clearStaleChunk(); }) {
 	checkSettings();
 }
 
@@ -101,6 +118,13 @@ void DatabaseObject::updateSettings(const SettingsUpdate &update) {
 
 void DatabaseObject::checkSettings() {
 	Expects(_settings.staleRemoveChunk > 0);
+	Expects(_settings.staleRemoveParallel > 0);
+	Expects(_settings.staleRemovePerSecond >= 0);
+	Expects(_settings.frequentUseCount >= 0
+		&& _settings.frequentUseCount <= std::numeric_limits<uint8>::max());
+	Expects(ranges::all_of(_settings.tagSizeQuotas, [](const auto &quota) {
+		return (quota.second > 0) && (quota.second <= 100);
+	}));
 	Expects(_settings.maxDataSize > 0
 		&& _settings.maxDataSize < kDataSizeLimit);
 	Expects(_settings.maxBundledRecords > 0
@@ -174,6 +198,10 @@ QString DatabaseObject::CompactReadyFilename() {
 	return QStringLiteral("binlog-ready");
 }
 
+QString DatabaseObject::SnapshotFilename() {
+	return QStringLiteral("snapshot");
+}
+
 QString DatabaseObject::binlogPath(Version version) const {
 	return computePath(version) + BinlogFilename();
 }
@@ -190,6 +218,10 @@ QString DatabaseObject::compactReadyPath() const {
 	return _path + CompactReadyFilename();
 }
 
+QString DatabaseObject::snapshotPath() const {
+	return _path + SnapshotFilename();
+}
+
 File::Result DatabaseObject::openBinlog(
 		Version version,
 		File::Mode mode,
@@ -213,6 +245,7 @@ File::Result DatabaseObject::openBinlog(
 	_key = std::move(key);
 	createCleaner();
 	readBinlog();
+	_filter->setReady();
 	return File::Result::Success;
 }
 
@@ -248,6 +281,8 @@ void DatabaseObject::readBinlogHelper(
 }
 
 void DatabaseObject::readBinlog() {
+	const auto started = crl::now();
+	const auto from = readSnapshot() ? _snapshotOffset : _binlog.offset();
 	BinlogWrapper wrapper(_binlog, _settings);
 	if (_settings.trackEstimatedTime) {
 		BinlogReader<
@@ -279,10 +314,142 @@ void DatabaseObject::readBinlog() {
 			return processRecordMultiRemove(header, element);
 		});
 	}
+	_indexReadDuration = crl::now() - started;
+	_indexReplayedSize = _binlog.size() - from;
 	adjustRelativeTime();
 	optimize();
 }
 
+bool DatabaseObject::readSnapshot() {
+	File snapshot;
+	const auto result = snapshot.open(snapshotPath(), File::Mode::Read, _key);
+	if (result != File::Result::Success) {
+		return false;
+	}
+	auto info = SnapshotHeader();
+	const auto read = snapshot.read(bytes::object_as_span(&info));
+	if (read != sizeof(info)
+		|| info.binlogOffset < _binlog.offset()
+		|| info.binlogOffset > _binlog.size()) {
+		return false;
+	}
+	const auto time = _time;
+	BinlogWrapper wrapper(snapshot, _settings);
+	if (_settings.trackEstimatedTime) {
+		BinlogReader<MultiStoreWithTime> reader(wrapper);
+		readBinlogHelper(reader, [&](
+				const MultiStoreWithTime &header,
+				const auto &element) {
+			return processRecordMultiStore(header, element);
+		});
+	} else {
+		BinlogReader<MultiStore> reader(wrapper);
+		readBinlogHelper(reader, [&](
+				const MultiStore &header,
+				const auto &element) {
+			return processRecordMultiStore(header, element);
+		});
+	}
+	if (wrapper.failed()
+		|| snapshot.offset() != snapshot.size()
+		|| _map.size() != info.count
+		|| !_binlog.seek(info.binlogOffset)) {
+		clearIndex();
+		_time = time;
+		return false;
+	}
+	applyTimePoint(info.time);
+	_binlogExcessLength = info.excessLength;
+	_snapshotOffset = info.binlogOffset;
+	return true;
+}
+
+void DatabaseObject::writeSnapshotLazy() {
+	const auto limit = _settings.snapshotAfterSize;
+	if (!limit
+		|| !_binlog.isOpen()
+		|| _binlog.size() - _snapshotOffset < limit) {
+		return;
+	}
+	writeSnapshot();
+}
+
+bool DatabaseObject::writeSnapshot() {
+	const auto path = snapshotPath();
+	const auto temp = path + QStringLiteral("-temp");
+	File snapshot;
+	const auto result = snapshot.open(temp, File::Mode::Write, _key);
+	if (result != File::Result::Success) {
+		return false;
+	}
+	auto header = SnapshotHeader();
+	header.binlogOffset = _binlog.size();
+	header.excessLength = _binlogExcessLength;
+	header.time = _time;
+	header.count = uint32(_map.size());
+	const auto written = snapshot.write(bytes::object_as_span(&header))
+		&& (_settings.trackEstimatedTime
+			? writeSnapshotRecords<MultiStoreWithTime>(snapshot)
+			: writeSnapshotRecords<MultiStore>(snapshot));
+	if (written) {
+		snapshot.flush();
+	}
+	snapshot.close();
+	if (!written || !File::Move(temp, path)) {
+		QFile(temp).remove();
+		return false;
+	}
+	_snapshotOffset = header.binlogOffset;
+	return true;
+}
+
+template <typename MultiRecord>
+bool DatabaseObject::writeSnapshotRecords(File &snapshot) const {
+	using Part = typename MultiRecord::Part;
+	auto list = std::vector<Part>();
+	list.reserve(std::min(
+		size_type(_map.size()),
+		_settings.maxBundledRecords));
+	const auto flush = [&] {
+		if (list.empty()) {
+			return true;
+		}
+		auto header = MultiRecord(list.size());
+		const auto result = snapshot.write(bytes::object_as_span(&header))
+			&& snapshot.write(bytes::make_span(list));
+		list.clear();
+		return result;
+	};
+	for (const auto &[key, entry] : _map) {
+		auto record = Part();
+		record.key = key;
+		record.setSize(entry.size);
+		record.checksum = entry.checksum;
+		record.tag = entry.tag;
+		record.place = entry.place;
+		if constexpr (std::is_same_v<Part, StoreWithTime>) {
+			record.time.setRelative(entry.useTime);
+			record.time.system = _time.system;
+		}
+		list.push_back(record);
+		if (size_type(list.size()) == _settings.maxBundledRecords
+			&& !flush()) {
+			return false;
+		}
+	}
+	return flush();
+}
+
+void DatabaseObject::clearIndex() {
+	_map = {};
+	_binlogExcessLength = 0;
+	_totalSize = 0;
+	_minimalEntryTime = 0;
+	_entriesWithMinimalTimeCount = 0;
+	_usesSinceAging = 0;
+	_taggedStats = {};
+}
+
 uint64 DatabaseObject::countRelativeTime() const {
 	const auto now = GetUnixtime();
 	const auto delta = std::max(int64(now) - int64(_time.system), 0LL);
@@ -311,6 +478,8 @@ bool DatabaseObject::startDelayedPruning() {
 		if (_settings.totalSizeLimit > 0
 			&& _totalSize > _settings.totalSizeLimit) {
 			return true;
+		} else if (tagSizeQuotaExceeded()) {
+			return true;
 		} else if ((!_minimalEntryTime && !_map.empty())
 			|| _minimalEntryTime <= before) {
 			return true;
@@ -352,6 +521,11 @@ void DatabaseObject::prune() {
 }
 
 void DatabaseObject::startStaleClear() {
+	if (!_staleChunksRemoving && !_staleTimer.isActive()) {
+		_staleStartedAt = crl::now();
+		_staleRemovedCount = 0;
+	}
+
 	// Report "Clearing..." status.
 	pushStats();
 	clearStaleChunk();
@@ -388,24 +562,70 @@ void DatabaseObject::clearStaleChunkDelayed() {
 }
 
 void DatabaseObject::clearStaleChunk() {
-	if (_stale.empty()) {
+	if (_stale.empty()
+		|| _staleChunksRemoving >= _settings.staleRemoveParallel) {
+		return;
+	} else if (const auto delay = staleRemoveDelay()) {
+		if (!_staleTimer.isActive()) {
+			_staleTimer.callOnce(delay);
+		}
 		return;
 	}
 	const auto stale = gsl::make_span(_stale);
 	const auto count = size_type(stale.size());
 	const auto clear = std::min(count, _settings.staleRemoveChunk);
+	auto paths = std::vector<QString>();
+	paths.reserve(clear);
 	for (const auto &key : stale.subspan(count - clear)) {
-		remove(key, nullptr);
+		const auto i = _map.find(key);
+		if (i != _map.end()) {
+			paths.push_back(removeFromIndex(i));
+		}
 	}
 	_stale.resize(count - clear);
+	_staleRemovedCount += clear;
+
+	// The index already forgot those entries, only the unlinks are left.
+	// Places stay occupied until the files are gone, see isFreePlace().
+	++_staleChunksRemoving;
+	crl::async([weak = _weak, paths = std::move(paths)] {
+		for (const auto &path : paths) {
+			QFile(path).remove();
+		}
+		weak.with([](DatabaseObject &that) {
+			that.staleChunkRemoved();
+		});
+	});
 	if (_stale.empty()) {
 		base::take(_stale);
-		optimize();
 	} else {
 		clearStaleChunkDelayed();
 	}
 }
 
+crl::time DatabaseObject::staleRemoveDelay() const {
+	const auto perSecond = _settings.staleRemovePerSecond;
+	if (!perSecond) {
+		return 0;
+	}
+	const auto allowedAt = _staleStartedAt
+		+ crl::time(_staleRemovedCount) * crl::time(1000) / perSecond;
+	return std::max(allowedAt - crl::now(), crl::time(0));
+}
+
+void DatabaseObject::staleChunkRemoved() {
+	Expects(_staleChunksRemoving > 0);
+
+	--_staleChunksRemoving;
+	if (!_stale.empty()) {
+		clearStaleChunk();
+	} else if (!_staleChunksRemoving) {
+		optimize();
+		checkWaitingForCleaner();
+	}
+	pushStatsDelayed();
+}
+
 void DatabaseObject::collectTimeStale(
 		base::flat_set<Key> &stale,
 		int64 &staleTotalSize) {
@@ -435,13 +655,81 @@ void DatabaseObject::collectTimeStale(
 void DatabaseObject::collectSizeStale(
 		base::flat_set<Key> &stale,
 		int64 &staleTotalSize) {
-	const auto removeSize = (_settings.totalSizeLimit > 0)
+	collectTagSizeStale(stale, staleTotalSize);
+
+	auto removeSize = (_settings.totalSizeLimit > 0)
 		? (_totalSize - staleTotalSize - _settings.totalSizeLimit)
 		: 0;
 	if (removeSize <= 0) {
 		return;
 	}
+	if (const auto frequent = _settings.frequentUseCount) {
+		const auto removed = collectOldestStale(
+			stale,
+			removeSize,
+			[&](const Entry &entry) { return entry.useCount < frequent; });
+		staleTotalSize += removed;
+		removeSize -= removed;
+		if (removeSize <= 0) {
+			return;
+		}
+	}
+	staleTotalSize += collectOldestStale(
+		stale,
+		removeSize,
+		[](const Entry &) { return true; });
+}
+
+int64 DatabaseObject::tagSizeLimit(uint8 tag) const {
+	const auto i = _settings.tagSizeQuotas.find(tag);
+	return (i != end(_settings.tagSizeQuotas)
+		&& _settings.totalSizeLimit > 0)
+		? (_settings.totalSizeLimit * i->second / 100)
+		: 0;
+}
+
+bool DatabaseObject::tagSizeQuotaExceeded() const {
+	for (const auto &[tag, summary] : _taggedStats) {
+		const auto limit = tagSizeLimit(tag);
+		if (limit > 0 && summary.totalSize > limit) {
+			return true;
+		}
+	}
+	return false;
+}
 
+void DatabaseObject::collectTagSizeStale(
+		base::flat_set<Key> &stale,
+		int64 &staleTotalSize) {
+	for (const auto &[tag, summary] : _taggedStats) {
+		const auto limit = tagSizeLimit(tag);
+		if (limit <= 0 || summary.totalSize <= limit) {
+			continue;
+		}
+		auto removeSize = summary.totalSize - limit;
+		for (const auto &key : stale) {
+			const auto i = _map.find(key);
+			if (i != end(_map) && i->second.tag == tag) {
+				removeSize -= i->second.size;
+			}
+		}
+		if (removeSize <= 0) {
+			continue;
+		}
+		staleTotalSize += collectOldestStale(
+			stale,
+			removeSize,
+			[&](const Entry &entry) { return entry.tag == tag; });
+	}
+}
+
+// Adds to stale as few of the least recently used entries accepted by
+// the filter as needed to free removeSize bytes, returns their size.
+template <typename Filter>
+int64 DatabaseObject::collectOldestStale(
+		base::flat_set<Key> &stale,
+		int64 removeSize,
+		Filter &&filter) const {
 	using Bucket = std::pair<const Key, Entry>;
 	auto oldest = base::flat_multi_map<
 		int64,
@@ -458,7 +746,7 @@ void DatabaseObject::collectSizeStale(
 
 	for (const auto &bucket : _map) {
 		const auto &entry = bucket.second;
-		if (stale.contains(bucket.first)) {
+		if (stale.contains(bucket.first) || !filter(entry)) {
 			continue;
 		}
 		const auto add = (oldestTotalSize < removeSize)
@@ -478,7 +766,7 @@ void DatabaseObject::collectSizeStale(
 	for (const auto &pair : oldest) {
 		stale.emplace(pair.second->first);
 	}
-	staleTotalSize += oldestTotalSize;
+	return oldestTotalSize;
 }
 
 void DatabaseObject::adjustRelativeTime() {
@@ -574,12 +862,14 @@ bool DatabaseObject::processRecordMultiAccess(
 		_binlogExcessLength += sizeof(*entry);
 		if (const auto i = _map.find(*entry); i != end(_map)) {
 			i->second.useTime = relative;
+			countEntryUse(i->second);
 		}
 	}
 	return true;
 }
 
 void DatabaseObject::setMapEntry(const Key &key, Entry &&entry) {
+	_filter->add(key);
 	auto &already = _map[key];
 	updateStats(already, entry);
 	if (already.size != 0) {
@@ -657,6 +947,15 @@ void DatabaseObject::eraseMapEntry(const Map::const_iterator &i) {
 			}
 		}
 		_map.erase(i);
+
+		// Erased keys can't be taken out of a Bloom filter.
+		const auto limit = std::max(
+			size_type(_map.size()),
+			size_type(kFilterRebuildErased));
+		if (++_filterErased > limit) {
+			_filter->rebuild(_map);
+			_filterErased = 0;
+		}
 	}
 }
 
@@ -695,12 +994,15 @@ void DatabaseObject::compactorDone(
 			return;
 		}
 	}
+	QFile(snapshotPath()).remove();
+	_snapshotOffset = 0;
 	if (!File::Move(path, ready)) {
 		compactorFail();
 		return;
 	}
 	const auto guard = gsl::finally([&] {
 		_compactor = CompactorWrap();
+		pushStatsDelayed();
 	});
 	_binlog.close();
 	if (!File::Move(ready, binlog)) {
@@ -728,6 +1030,16 @@ void DatabaseObject::compactorFail() {
 		delay * 2,
 		kMaxDelayAfterFailure);
 	QFile(compactReadyPath()).remove();
+	pushStatsDelayed();
+}
+
+void DatabaseObject::compactorProgress(int64 processed, int64 total) {
+	if (!_compactor.object) {
+		return;
+	}
+	_compactor.processed = processed;
+	_compactor.total = total;
+	pushStatsDelayed();
 }
 
 void DatabaseObject::close(FnMut<void()> &&done) {
@@ -742,16 +1054,17 @@ void DatabaseObject::close(FnMut<void()> &&done) {
 void DatabaseObject::clearState() {
 	_path = QString();
 	_key = {};
-	_map = {};
+	clearIndex();
 	_removing = {};
 	_accessed = {};
 	_stale = {};
 	_time = {};
-	_binlogExcessLength = 0;
-	_totalSize = 0;
-	_minimalEntryTime = 0;
-	_entriesWithMinimalTimeCount = 0;
-	_taggedStats = {};
+	_mappedPlaces = {};
+	_filter->reset();
+	_filterErased = 0;
+	_snapshotOffset = 0;
+	_indexReadDuration = 0;
+	_indexReplayedSize = 0;
 	_pushingStats = false;
 	_writeBundlesTimer.cancel();
 	_pruneTimer.cancel();
@@ -780,19 +1093,31 @@ void DatabaseObject::put(
 		recordEntryAccess(key);
 		return;
 	}
-	const auto path = *maybepath;
+	const auto error = writeValueData(key, *maybepath, value);
+	invokeCallback(done, error);
+	if (error.type == Error::Type::None) {
+		optimize();
+	}
+}
+
+Error DatabaseObject::writeValueData(
+		const Key &key,
+		const QString &path,
+		TaggedValue &value) {
+	if (const auto i = _map.find(key); i != end(_map)) {
+		// The place file could be mapped by an earlier read.
+		forgetMappedPlace(i->second.place);
+	}
 	File data;
 	const auto result = data.open(path, File::Mode::Write, _key);
 	switch (result) {
 	case File::Result::Failed:
 		remove(key, nullptr);
-		invokeCallback(done, ioError(path));
-		break;
+		return ioError(path);
 
 	case File::Result::LockFailed:
 		remove(key, nullptr);
-		invokeCallback(done, Error{ Error::Type::LockFailed, path });
-		break;
+		return Error{ Error::Type::LockFailed, path };
 
 	case File::Result::Success: {
 		const auto success = data.writeWithPadding(
@@ -800,16 +1125,154 @@ void DatabaseObject::put(
 		if (!success) {
 			data.close();
 			remove(key, nullptr);
-			invokeCallback(done, ioError(path));
-		} else {
-			data.flush();
-			invokeCallback(done, Error::NoError());
-			optimize();
+			return ioError(path);
 		}
+		data.flush();
+		return Error::NoError();
 	} break;
+	}
+	Unexpected("Result in DatabaseObject::writeValueData.");
+}
+
+void DatabaseObject::putMany(
+		std::vector<std::pair<Key, TaggedValue>> &&values,
+		FnMut<void(Error)> &&done) {
+	// Only the last value for each key matters, empty ones are removals.
+	auto seen = base::flat_set<Key>();
+	auto writing = std::vector<std::pair<Key, TaggedValue>>();
+	writing.reserve(values.size());
+	for (auto i = values.rbegin(); i != values.rend(); ++i) {
+		auto &[key, value] = *i;
+		if (!seen.emplace(key).second) {
+			continue;
+		} else if (value.bytes.isEmpty()) {
+			remove(key, nullptr);
+			continue;
+		}
+		_removing.erase(key);
+		_stale.erase(ranges::remove(_stale, key), end(_stale));
+		writing.emplace_back(key, std::move(value));
+	}
+	if (writing.empty()) {
+		invokeCallback(done, Error::NoError());
+		return;
+	}
+
+	const auto paths = writeKeyPlaces(writing);
+	if (!paths) {
+		invokeCallback(done, ioError(binlogPath()));
+		return;
+	}
+	auto error = Error::NoError();
+	for (auto i = 0, count = int(writing.size()); i != count; ++i) {
+		auto &[key, value] = writing[i];
+		const auto &path = (*paths)[i];
+		if (path.isEmpty()) {
+			// Nothing changed.
+			recordEntryAccess(key);
+			continue;
+		}
+		const auto result = writeValueData(key, path, value);
+		if (error.type == Error::Type::None) {
+			error = result;
+		}
+	}
+	invokeCallback(done, error);
+	optimize();
+}
 
-	default: Unexpected("Result in DatabaseObject::put.");
+template <typename MultiRecord>
+std::optional<std::vector<QString>> DatabaseObject::writeKeyPlacesGeneric(
+		const std::vector<std::pair<Key, TaggedValue>> &values) {
+	using Part = typename MultiRecord::Part;
+
+	auto time = EstimatedTimePoint();
+	if constexpr (std::is_same_v<Part, StoreWithTime>) {
+		time = countWriteTimePoint();
+	}
+	auto result = std::vector<QString>(values.size());
+	auto records = std::vector<Part>();
+	records.reserve(values.size());
+	auto places = base::flat_set<PlaceId>();
+	for (auto i = 0, count = int(values.size()); i != count; ++i) {
+		const auto &[key, value] = values[i];
+		Expects(value.bytes.size() <= _settings.maxDataSize);
+
+		const auto size = size_type(value.bytes.size());
+		const auto checksum = CountChecksum(bytes::make_span(value.bytes));
+		auto record = Part();
+		record.tag = value.tag;
+		record.key = key;
+		record.setSize(size);
+		record.checksum = checksum;
+		if constexpr (std::is_same_v<Part, StoreWithTime>) {
+			record.time = time;
+		}
+		if (const auto j = _map.find(key); j != end(_map)) {
+			const auto &already = j->second;
+			if (already.tag == record.tag
+				&& already.size == size
+				&& already.checksum == checksum
+				&& readValueData(already.place, size) == value.bytes) {
+				continue;
+			}
+			record.place = already.place;
+		} else {
+			// New files are written only after the binlog record,
+			// so the places chosen in this batch don't exist yet.
+			do {
+				bytes::set_random(bytes::object_as_span(&record.place));
+			} while (places.contains(record.place)
+				|| !isFreePlace(record.place));
+		}
+		places.emplace(record.place);
+		result[i] = placePath(record.place);
+		records.push_back(record);
+	}
+
+	const auto limit = _settings.maxBundledRecords;
+	const auto all = gsl::make_span(records);
+	for (auto from = size_type(0); from < all.size(); from += limit) {
+		const auto chunk = all.subspan(
+			from,
+			std::min(limit, size_type(all.size()) - from));
+		auto header = MultiRecord(chunk.size());
+		auto writeable = std::vector<Part>(chunk.begin(), chunk.end());
+		if (!_binlog.write(bytes::object_as_span(&header))
+			|| !_binlog.write(bytes::make_span(writeable))) {
+			_binlog.close();
+			return std::nullopt;
+		}
+		for (const auto &record : chunk) {
+			const auto applied = processRecordStore(
+				&record,
+				std::is_class<Part>{});
+			Assert(applied);
+		}
 	}
+	_binlog.flush();
+	return result;
+}
+
+std::optional<std::vector<QString>> DatabaseObject::writeKeyPlaces(
+		const std::vector<std::pair<Key, TaggedValue>> &values) {
+	return _settings.trackEstimatedTime
+		? writeKeyPlacesGeneric<MultiStoreWithTime>(values)
+		: writeKeyPlacesGeneric<MultiStore>(values);
+}
+
+EstimatedTimePoint DatabaseObject::countWriteTimePoint() const {
+	const auto result = countTimePoint();
+	const auto writing = result.getRelative();
+	const auto current = _time.getRelative();
+	Assert(writing >= current);
+	if ((writing - current) * crl::time(1000)
+		< _settings.writeBundleDelay) {
+		// We don't want to produce a lot of unique _time.relative values.
+		// So if change in it is not large we stick to the old value.
+		return _time;
+	}
+	return result;
 }
 
 template <typename StoreRecord>
@@ -863,16 +1326,7 @@ std::optional<QString> DatabaseObject::writeKeyPlace(
 		return writeKeyPlaceGeneric(Store(), key, data, checksum);
 	}
 	auto record = StoreWithTime();
-	record.time = countTimePoint();
-	const auto writing = record.time.getRelative();
-	const auto current = _time.getRelative();
-	Assert(writing >= current);
-	if ((writing - current) * crl::time(1000)
-		< _settings.writeBundleDelay) {
-		// We don't want to produce a lot of unique _time.relative values.
-		// So if change in it is not large we stick to the old value.
-		record.time = _time;
-	}
+	record.time = countWriteTimePoint();
 	return writeKeyPlaceGeneric(std::move(record), key, data, checksum);
 }
 
@@ -918,16 +1372,7 @@ Error DatabaseObject::writeExistingPlace(
 		return writeExistingPlaceGeneric(Store(), key, entry);
 	}
 	auto record = StoreWithTime();
-	record.time = countTimePoint();
-	const auto writing = record.time.getRelative();
-	const auto current = _time.getRelative();
-	Assert(writing >= current);
-	if ((writing - current) * crl::time(1000)
-		< _settings.writeBundleDelay) {
-		// We don't want to produce a lot of unique _time.relative values.
-		// So if change in it is not large we stick to the old value.
-		record.time = _time;
-	}
+	record.time = countWriteTimePoint();
 	return writeExistingPlaceGeneric(std::move(record), key, entry);
 }
 
@@ -954,24 +1399,86 @@ void DatabaseObject::get(
 	}
 }
 
+void DatabaseObject::access(const Key &key) {
+	if (_map.find(key) != _map.end()) {
+		recordEntryAccess(key);
+	}
+}
+
+void DatabaseObject::getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done) {
+	auto result = std::vector<TaggedValue>();
+	result.reserve(keys.size());
+	for (const auto &key : keys) {
+		get(key, [&](TaggedValue &&value) {
+			result.push_back(std::move(value));
+		});
+	}
+	invokeCallback(done, std::move(result));
+}
+
 QByteArray DatabaseObject::readValueData(PlaceId place, size_type size) const {
-	const auto path = placePath(place);
-	File data;
-	const auto result = data.open(path, File::Mode::Read, _key);
+	const auto data = mappedPlace(place);
+	if (!data || !data->seek(0)) {
+		return QByteArray();
+	}
+	auto result = QByteArray(size, Qt::Uninitialized);
+	const auto bytes = bytes::make_detached_span(result);
+	const auto read = data->readWithPadding(bytes);
+	if (read != size) {
+		return QByteArray();
+	}
+	return result;
+}
+
+File *DatabaseObject::mappedPlace(PlaceId place) const {
+	const auto i = ranges::find(_mappedPlaces, place, &MappedPlace::place);
+	if (i != end(_mappedPlaces)) {
+		std::rotate(i, i + 1, end(_mappedPlaces));
+		return _mappedPlaces.back().file.get();
+	}
+	auto data = std::make_unique<File>();
+	const auto result = data->open(
+		placePath(place),
+		File::Mode::ReadMapped,
+		_key);
 	switch (result) {
 	case File::Result::Failed:
-	case File::Result::WrongKey: return QByteArray();
+	case File::Result::WrongKey: return nullptr;
 	case File::Result::Success: {
-		auto result = QByteArray(size, Qt::Uninitialized);
-		const auto bytes = bytes::make_detached_span(result);
-		const auto read = data.readWithPadding(bytes);
-		if (read != size) {
-			return QByteArray();
+		if (int(_mappedPlaces.size()) >= kMappedPlacesLimit) {
+			_mappedPlaces.erase(begin(_mappedPlaces));
 		}
-		return result;
+		_mappedPlaces.push_back({ place, std::move(data) });
+		return _mappedPlaces.back().file.get();
 	} break;
 	}
-	Unexpected("Result in DatabaseObject::get.");
+	Unexpected("Result in DatabaseObject::mappedPlace.");
+}
+
+void DatabaseObject::forgetMappedPlace(PlaceId place) {
+	_mappedPlaces.erase(
+		ranges::remove(_mappedPlaces, place, &MappedPlace::place),
+		end(_mappedPlaces));
+}
+
+void DatabaseObject::countEntryUse(Entry &entry) {
+	if (entry.useCount < std::numeric_limits<uint8>::max()) {
+		++entry.useCount;
+	}
+
+	// Halve all the counters now and then, so that entries used a lot
+	// long ago don't stay protected forever.
+	const auto agingAfter = std::max(
+		size_type(_map.size()),
+		size_type(kUseAgingMinimum)) * kUseAgingFactor;
+	if (++_usesSinceAging >= agingAfter) {
+		_usesSinceAging = 0;
+		for (auto &[key, already] : _map) {
+			already.useCount /= 2;
+		}
+	}
 }
 
 void DatabaseObject::recordEntryAccess(const Key &key) {
@@ -983,14 +1490,20 @@ void DatabaseObject::recordEntryAccess(const Key &key) {
 	optimize();
 }
 
+QString DatabaseObject::removeFromIndex(const Map::const_iterator &i) {
+	_removing.emplace(i->first);
+	writeMultiRemoveLazy();
+
+	const auto result = placePath(i->second.place);
+	forgetMappedPlace(i->second.place);
+	eraseMapEntry(i);
+	return result;
+}
+
 void DatabaseObject::remove(const Key &key, FnMut<void(Error)> &&done) {
 	const auto i = _map.find(key);
 	if (i != _map.end()) {
-		_removing.emplace(key);
-		writeMultiRemoveLazy();
-
-		const auto path = placePath(i->second.place);
-		eraseMapEntry(i);
+		const auto path = removeFromIndex(i);
 		if (QFile(path).remove() || !QFile(path).exists()) {
 			invokeCallback(done, Error::NoError());
 		} else {
@@ -1062,7 +1575,16 @@ Stats DatabaseObject::collectStats() const {
 	result.tagged = _taggedStats;
 	result.full.count = _map.size();
 	result.full.totalSize = _totalSize;
-	result.clearing = (_cleaner.object != nullptr) || !_stale.empty();
+	result.clearing = (_cleaner.object != nullptr)
+		|| !_stale.empty()
+		|| (_staleChunksRemoving > 0);
+	result.clearingLeft = size_type(_stale.size());
+	result.indexReadDuration = _indexReadDuration;
+	result.indexReplayedSize = _indexReplayedSize;
+	if (_compactor.object) {
+		result.compactProcessed = _compactor.processed;
+		result.compactTotal = _compactor.total;
+	}
 	return result;
 }
 
@@ -1137,6 +1659,7 @@ Error DatabaseObject::writeMultiAccessBlock() {
 	for (const auto &entry : list) {
 		if (const auto i = _map.find(entry); i != end(_map)) {
 			i->second.useTime = _time.getRelative();
+			countEntryUse(i->second);
 		}
 	}
 
@@ -1156,6 +1679,7 @@ void DatabaseObject::writeBundles() {
 	if (_settings.trackEstimatedTime) {
 		writeMultiAccess();
 	}
+	writeSnapshotLazy();
 }
 
 void DatabaseObject::createCleaner() {
@@ -1174,8 +1698,8 @@ void DatabaseObject::createCleaner() {
 }
 
 void DatabaseObject::cleanerDone(Error error) {
-	invokeCallback(_cleaner.done);
 	_cleaner = CleanerWrap();
+	checkWaitingForCleaner();
 	pushStatsDelayed();
 }
 
@@ -1239,14 +1763,23 @@ void DatabaseObject::clearByTag(uint8 tag, FnMut<void(Error)> &&done) {
 }
 
 void DatabaseObject::waitForCleaner(FnMut<void()> &&done) {
-	while (!_stale.empty()) {
-		clearStaleChunk();
+	// Whoever waits wants the files gone now, ignore the budget.
+	_staleTimer.cancel();
+	for (const auto &key : base::take(_stale)) {
+		remove(key, nullptr);
 	}
-	if (_cleaner.object) {
-		_cleaner.done = std::move(done);
-	} else {
-		invokeCallback(done);
+	_waitingForCleaner = std::move(done);
+	checkWaitingForCleaner();
+}
+
+void DatabaseObject::checkWaitingForCleaner() {
+	if (!_waitingForCleaner
+		|| _cleaner.object
+		|| _staleChunksRemoving > 0
+		|| !_stale.empty()) {
+		return;
 	}
+	invokeCallback(base::take(_waitingForCleaner));
 }
 
 auto DatabaseObject::getManyRaw(const std::vector<Key> &keys) const
@@ -1261,6 +1794,15 @@ auto DatabaseObject::getManyRaw(const std::vector<Key> &keys) const
 	return result;
 }
 
+std::vector<Key> DatabaseObject::keys() const {
+	auto result = std::vector<Key>();
+	result.reserve(_map.size());
+	for (const auto &[key, entry] : _map) {
+		result.push_back(key);
+	}
+	return result;
+}
+
 DatabaseObject::~DatabaseObject() {
 	close(nullptr);
 }
@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #pragma once
 
 #include "storage/cache/storage_cache_database.h"
+#include "storage/cache/storage_cache_key_filter.h"
 #include "storage/storage_encrypted_file.h"
 #include "base/binary_guard.h"
 #include "base/concurrent_timer.h"
@@ -28,7 +29,8 @@ public:
 	DatabaseObject(
 		crl::weak_on_queue<DatabaseObject> weak,
 		const QString &path,
-		const Settings &settings);
+		const Settings &settings,
+		std::shared_ptr<KeyFilter> filter);
 	void reconfigure(const Settings &settings);
 	void updateSettings(const SettingsUpdate &update);
 
@@ -40,8 +42,16 @@ public:
 		TaggedValue &&value,
 		FnMut<void(Error)> &&done);
 	void get(const Key &key, FnMut<void(TaggedValue&&)> &&done);
+	void access(const Key &key);
 	void remove(const Key &key, FnMut<void(Error)> &&done);
 
+	void putMany(
+		std::vector<std::pair<Key, TaggedValue>> &&values,
+		FnMut<void(Error)> &&done);
+	void getMany(
+		const std::vector<Key> &keys,
+		FnMut<void(std::vector<TaggedValue>&&)> &&done);
+
 	void putIfEmpty(
 		const Key &key,
 		TaggedValue &&value,
@@ -63,9 +73,11 @@ public:
 
 	static QString BinlogFilename();
 	static QString CompactReadyFilename();
+	static QString SnapshotFilename();
 
 	void compactorDone(const QString &path, int64 originalReadTill);
 	void compactorFail();
+	void compactorProgress(int64 processed, int64 total);
 
 	struct Entry {
 		Entry() = default;
@@ -81,9 +93,13 @@ public:
 		uint32 checksum = 0;
 		PlaceId place = { { 0 } };
 		uint8 tag = 0;
+
+		// Approximate, halved from time to time, not stored in binlog.
+		uint8 useCount = 0;
 	};
 	using Raw = std::pair<Key, Entry>;
 	std::vector<Raw> getManyRaw(const std::vector<Key> &keys) const;
+	std::vector<Key> keys() const;
 
 	~DatabaseObject();
 
@@ -91,11 +107,12 @@ private:
 	struct CleanerWrap {
 		std::unique_ptr<Cleaner> object;
 		base::binary_guard guard;
-		FnMut<void()> done;
 	};
 	struct CompactorWrap {
 		std::unique_ptr<Compactor> object;
 		int64 excessLength = 0;
+		int64 processed = 0;
+		int64 total = 0;
 		crl::time nextAttempt = 0;
 		crl::time delayAfterFailure = 10 * crl::time(1000);
 		base::binary_guard guard;
@@ -113,6 +130,7 @@ private:
 	QString binlogPath() const;
 	QString compactReadyPath(Version version) const;
 	QString compactReadyPath() const;
+	QString snapshotPath() const;
 	Error openSomeBinlog(EncryptionKey &&key);
 	Error openNewBinlog(EncryptionKey &key);
 	File::Result openBinlog(
@@ -125,6 +143,12 @@ private:
 	void readBinlog();
 	template <typename Reader, typename ...Handlers>
 	void readBinlogHelper(Reader &reader, Handlers &&...handlers);
+	bool readSnapshot();
+	void writeSnapshotLazy();
+	bool writeSnapshot();
+	template <typename MultiRecord>
+	bool writeSnapshotRecords(File &snapshot) const;
+	void clearIndex();
 	template <typename Record, typename Postprocess>
 	bool processRecordStoreGeneric(
 		const Record *record,
@@ -162,10 +186,24 @@ private:
 	void collectSizeStale(
 		base::flat_set<Key> &stale,
 		int64 &staleTotalSize);
+	void collectTagSizeStale(
+		base::flat_set<Key> &stale,
+		int64 &staleTotalSize);
+	template <typename Filter>
+	int64 collectOldestStale(
+		base::flat_set<Key> &stale,
+		int64 removeSize,
+		Filter &&filter) const;
+	int64 tagSizeLimit(uint8 tag) const;
+	bool tagSizeQuotaExceeded() const;
 	void startStaleClear();
 	void clearStaleNow(const base::flat_set<Key> &stale);
 	void clearStaleChunkDelayed();
 	void clearStaleChunk();
+	void staleChunkRemoved();
+	crl::time staleRemoveDelay() const;
+	void checkWaitingForCleaner();
+	QString removeFromIndex(const Map::const_iterator &i);
 
 	void updateStats(const Entry &was, const Entry &now);
 	Stats collectStats() const;
@@ -175,7 +213,10 @@ private:
 	void setMapEntry(const Key &key, Entry &&entry);
 	void eraseMapEntry(const Map::const_iterator &i);
 	void recordEntryAccess(const Key &key);
+	void countEntryUse(Entry &entry);
 	QByteArray readValueData(PlaceId place, size_type size) const;
+	File *mappedPlace(PlaceId place) const;
+	void forgetMappedPlace(PlaceId place);
 
 	Version findAvailableVersion() const;
 	QString versionPath() const;
@@ -195,6 +236,16 @@ private:
 		const Key &key,
 		const TaggedValue &value,
 		uint32 checksum);
+	template <typename MultiRecord>
+	std::optional<std::vector<QString>> writeKeyPlacesGeneric(
+		const std::vector<std::pair<Key, TaggedValue>> &values);
+	std::optional<std::vector<QString>> writeKeyPlaces(
+		const std::vector<std::pair<Key, TaggedValue>> &values);
+	Error writeValueData(
+		const Key &key,
+		const QString &path,
+		TaggedValue &value);
+	EstimatedTimePoint countWriteTimePoint() const;
 	template <typename StoreRecord>
 	Error writeExistingPlaceGeneric(
 		StoreRecord &&record,
@@ -225,20 +276,44 @@ private:
 	std::set<Key> _accessed;
 	std::vector<Key> _stale;
 
+	// Recently read place files, kept opened and mapped, most recent last.
+	struct MappedPlace {
+		PlaceId place = PlaceId();
+		std::unique_ptr<File> file;
+	};
+	mutable std::vector<MappedPlace> _mappedPlaces;
+
+	// Keeps every key of _map, erased keys stay until the next rebuild.
+	std::shared_ptr<KeyFilter> _filter;
+	size_type _filterErased = 0;
+
+	// Binlog size covered by the snapshot file, if there is one.
+	int64 _snapshotOffset = 0;
+	crl::time _indexReadDuration = 0;
+	int64 _indexReplayedSize = 0;
+
 	EstimatedTimePoint _time;
 
 	int64 _binlogExcessLength = 0;
 	int64 _totalSize = 0;
 	uint64 _minimalEntryTime = 0;
 	size_type _entriesWithMinimalTimeCount = 0;
+	size_type _usesSinceAging = 0;
 
 	base::flat_map<uint8, TaggedSummary> _taggedStats;
 	rpl::event_stream<Stats> _stats;
 	bool _pushingStats = false;
 	bool _clearingStale = false;
 
+	// Chunks of stale files being unlinked and the budget of this run.
+	int _staleChunksRemoving = 0;
+	crl::time _staleStartedAt = 0;
+	size_type _staleRemovedCount = 0;
+	FnMut<void()> _waitingForCleaner;
+
 	base::ConcurrentTimer _writeBundlesTimer;
 	base::ConcurrentTimer _pruneTimer;
+	base::ConcurrentTimer _staleTimer;
 
 	CleanerWrap _cleaner;
 	CompactorWrap _compactor;
@@ -301,6 +301,39 @@ TEST_CASE("compacting db", "[storage_cache_database]") {
 		fullcheck();
 		Close(db);
 	}
+	SECTION("throttled compact") {
+		auto settings = Settings;
+		settings.writeBundleDelay = crl::time(100);
+		settings.readBlockSize = 512;
+		settings.maxBundledRecords = 5;
+		settings.compactAfterExcess = 3 * (16 * 5 + 16) + 15 * 32;
+		settings.compactChunkSize = 4;
+		settings.compactBytesPerSecond = 1024;
+		Database db(name, settings);
+
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		put(db, 0, 30);
+		remove(db, 0, 15);
+		reput(db, 15, 29);
+		AdvanceTime(1);
+		const auto path = GetBinlogPath();
+		const auto size = QFile(path).size();
+		reput(db, 29, 30); // starts compactor
+		AdvanceTime(4);
+		REQUIRE(QFile(path).size() < size);
+
+		const auto fullcheck = [&] {
+			check(db, 0, 15, {});
+			check(db, 15, 30, Test2());
+		};
+		fullcheck();
+		Close(db);
+
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		fullcheck();
+		Close(db);
+	}
 	SECTION("double compact") {
 		auto settings = Settings;
 		settings.writeBundleDelay = crl::time(100);
@@ -671,6 +704,57 @@ TEST_CASE("cache db limits", "[storage_cache_database]") {
 		REQUIRE((Get(db, Key{ 2, 2 }) == Test2()));
 		Close(db);
 	}
+	SECTION("db size limit keeps frequent") {
+		auto settings = Settings;
+		settings.trackEstimatedTime = true;
+		settings.totalSizeLimit = 17 * 3 + 1;
+		settings.frequentUseCount = 2;
+		Database db(name, settings);
+
+		db.clear(nullptr);
+		db.open(base::duplicate(key), nullptr);
+		db.put(Key{ 0, 1 }, Test1(), nullptr);
+		db.get(Key{ 0, 1 }, nullptr);
+		AdvanceTime(2);
+		db.get(Key{ 0, 1 }, nullptr);
+		AdvanceTime(2);
+		db.put(Key{ 1, 0 }, Test2(), nullptr);
+		AdvanceTime(1);
+		db.put(Key{ 1, 1 }, Test1(), nullptr);
+		db.put(Key{ 2, 0 }, Test2(), nullptr);
+		AdvanceTime(2);
+
+		// { 1, 0 } is removed instead of the older, but used { 0, 1 }.
+		REQUIRE((Get(db, Key{ 0, 1 }) == Test1()));
+		REQUIRE(Get(db, Key{ 1, 0 }).isEmpty());
+		REQUIRE((Get(db, Key{ 1, 1 }) == Test1()));
+		REQUIRE((Get(db, Key{ 2, 0 }) == Test2()));
+		Close(db);
+	}
+	SECTION("db size limit by tag") {
+		auto settings = Settings;
+		settings.trackEstimatedTime = true;
+		settings.totalSizeLimit = 17 * 4;
+		settings.tagSizeQuotas = { { uint8(2), 50 } };
+		Database db(name, settings);
+
+		db.clear(nullptr);
+		db.open(base::duplicate(key), nullptr);
+		db.put(Key{ 0, 1 }, Test1(), nullptr);
+		AdvanceTime(1);
+		db.put(Key{ 1, 0 }, Database::TaggedValue(Test2(), 2), nullptr);
+		AdvanceTime(1);
+		db.put(Key{ 1, 1 }, Database::TaggedValue(Test2(), 2), nullptr);
+		db.put(Key{ 2, 0 }, Database::TaggedValue(Test2(), 2), nullptr);
+		AdvanceTime(2);
+
+		// Only the tag over its quota is pruned, the total fits.
+		REQUIRE((Get(db, Key{ 0, 1 }) == Test1()));
+		REQUIRE(Get(db, Key{ 1, 0 }).isEmpty());
+		REQUIRE((Get(db, Key{ 1, 1 }) == Test2()));
+		REQUIRE((Get(db, Key{ 2, 0 }) == Test2()));
+		Close(db);
+	}
 	SECTION("db time limit") {
 		auto settings = Settings;
 		settings.trackEstimatedTime = true;
@@ -737,3 +821,324 @@ TEST_CASE("large db", "[storage_cache_database]") {
 		Close(db);
 	}
 }
+
+TEST_CASE("sharded db", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.shardsCount = 4;
+
+	const auto make = [](uint32 index) {
+		return Key{ index, index + 1 };
+	};
+	const auto count = uint32(64);
+	{
+		Database db(name, settings);
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		for (auto i = uint32(); i != count; ++i) {
+			REQUIRE(Put(db, make(i), Test1()).type == Error::Type::None);
+		}
+		for (auto i = uint32(); i != count / 2; ++i) {
+			Remove(db, make(i));
+		}
+
+		// Some of those cross the shards.
+		for (auto i = count / 2; i != count; ++i) {
+			REQUIRE(CopyIfEmpty(db, make(i), make(i + count)).type
+				== Error::Type::None);
+		}
+		for (auto i = count / 2; i != count; ++i) {
+			REQUIRE(MoveIfEmpty(db, make(i + count), make(i + 2 * count)).type
+				== Error::Type::None);
+		}
+		Close(db);
+	}
+	Database db(name, settings);
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	for (auto i = uint32(); i != count / 2; ++i) {
+		REQUIRE(Get(db, make(i)).isEmpty());
+	}
+	for (auto i = count / 2; i != count; ++i) {
+		REQUIRE((Get(db, make(i)) == Test1()));
+		REQUIRE(Get(db, make(i + count)).isEmpty());
+		REQUIRE((Get(db, make(i + 2 * count)) == Test1()));
+	}
+	REQUIRE(Clear(db).type == Error::Type::None);
+	Close(db);
+}
+
+TEST_CASE("sharded db migration", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.shardsCount = 4;
+
+	const auto make = [](uint32 index) {
+		return Key{ index, index + 1 };
+	};
+	const auto count = uint32(64);
+	{
+		Database db(name, settings);
+		REQUIRE(Clear(db).type == Error::Type::None);
+	}
+	{
+		Database db(name, Settings);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		for (auto i = uint32(); i != count; ++i) {
+			REQUIRE(Put(db, make(i), Test1()).type == Error::Type::None);
+		}
+		Close(db);
+	}
+
+	// The single folder entries are moved to their shards after open.
+	Database db(name, settings);
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	auto found = uint32();
+	for (auto attempt = 0; attempt != 100 && found != count; ++attempt) {
+		SmallSleep();
+		found = 0;
+		for (auto i = uint32(); i != count; ++i) {
+			if (Get(db, make(i)) == Test1()) {
+				++found;
+			}
+		}
+	}
+	REQUIRE(found == count);
+	Close(db);
+
+	Database reopened(name, settings);
+	REQUIRE(Open(reopened, key).type == Error::Type::None);
+	for (auto i = uint32(); i != count; ++i) {
+		REQUIRE((Get(reopened, make(i)) == Test1()));
+	}
+	REQUIRE(Clear(reopened).type == Error::Type::None);
+	Close(reopened);
+}
+
+TEST_CASE("many values db", "[storage_cache_database]") {
+	const auto make = [](uint32 index) {
+		return Key{ index, index + 1 };
+	};
+	const auto values = [&](uint32 from, uint32 till, QByteArray bytes) {
+		auto result = std::vector<std::pair<Key, Database::TaggedValue>>();
+		for (auto i = from; i != till; ++i) {
+			result.emplace_back(
+				make(i),
+				Database::TaggedValue(base::duplicate(bytes), uint8(i % 3)));
+		}
+		return result;
+	};
+	const auto keys = [&](uint32 from, uint32 till) {
+		auto result = std::vector<Key>();
+		for (auto i = from; i != till; ++i) {
+			result.push_back(make(i));
+		}
+		return result;
+	};
+	static auto Values = std::vector<Database::TaggedValue>();
+	const auto putMany = [](Database &db, auto &&values) {
+		db.putMany(std::move(values), GetResult);
+		Semaphore.acquire();
+		return Result;
+	};
+	const auto getMany = [](Database &db, const std::vector<Key> &keys) {
+		db.getMany(keys, [](std::vector<Database::TaggedValue> &&values) {
+			Values = std::move(values);
+			Semaphore.release();
+		});
+		Semaphore.acquire();
+		return base::take(Values);
+	};
+
+	for (const auto shards : { 1, 3 }) {
+		auto settings = Settings;
+		settings.shardsCount = shards;
+		settings.maxBundledRecords = 5;
+		{
+			Database db(name, settings);
+			REQUIRE(Clear(db).type == Error::Type::None);
+			REQUIRE(Open(db, key).type == Error::Type::None);
+			REQUIRE(putMany(db, values(0, 20, Test1())).type
+				== Error::Type::None);
+			REQUIRE(putMany(db, values(10, 15, QByteArray())).type
+				== Error::Type::None);
+			REQUIRE(putMany(db, values(15, 20, Test2())).type
+				== Error::Type::None);
+			Close(db);
+		}
+		Database db(name, settings);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		const auto result = getMany(db, keys(0, 25));
+		REQUIRE(result.size() == 25);
+		for (auto i = 0; i != 25; ++i) {
+			const auto expected = (i < 10)
+				? Test1()
+				: (i >= 15 && i < 20)
+				? Test2()
+				: QByteArray();
+			REQUIRE((result[i].bytes == expected));
+			if (!expected.isEmpty()) {
+				REQUIRE(result[i].tag == uint8(i % 3));
+			}
+		}
+		REQUIRE(Clear(db).type == Error::Type::None);
+		Close(db);
+	}
+}
+
+TEST_CASE("hot tier db", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.hotSizeLimit = 1024;
+	settings.hotValueSizeLimit = 64;
+	Database db(name, settings);
+
+	REQUIRE(Clear(db).type == Error::Type::None);
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	const auto key1 = Key{ 1, 2 };
+	const auto key2 = Key{ 3, 4 };
+	const auto large = QByteArray(128, 'x');
+	REQUIRE(Put(db, key1, Test1()).type == Error::Type::None);
+	REQUIRE(Put(db, key2, base::duplicate(large)).type == Error::Type::None);
+	REQUIRE((Get(db, key1) == Test1()));
+	REQUIRE((Get(db, key2) == large));
+
+	SECTION("values are replaced and removed") {
+		REQUIRE(Put(db, key1, Test2()).type == Error::Type::None);
+		REQUIRE((Get(db, key1) == Test2()));
+		Remove(db, key1);
+		REQUIRE((Get(db, key1).isEmpty()));
+	}
+	SECTION("moved values leave the source") {
+		const auto key3 = Key{ 5, 6 };
+		REQUIRE(MoveIfEmpty(db, key1, key3).type == Error::Type::None);
+		REQUIRE((Get(db, key1).isEmpty()));
+		REQUIRE((Get(db, key3) == Test1()));
+	}
+	SECTION("clear by tag is honored") {
+		const auto key3 = Key{ 5, 6 };
+		REQUIRE(Put(db, key3, Database::TaggedValue(Test2(), 7)).type
+			== Error::Type::None);
+		REQUIRE((GetWithTag(db, key3).bytes == Test2()));
+		db.clearByTag(7, GetResult);
+		Semaphore.acquire();
+		REQUIRE((GetWithTag(db, key3).bytes.isEmpty()));
+		REQUIRE((Get(db, key1) == Test1()));
+	}
+	SECTION("values survive reopen through the disk") {
+		Close(db);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE((Get(db, key1) == Test1()));
+		REQUIRE((Get(db, key1) == Test1()));
+	}
+	Close(db);
+}
+
+TEST_CASE("key filter db", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.keyFilterSize = 1024;
+	settings.shardsCount = 2;
+	const auto present = Key{ 1, 2 };
+	const auto missing = Key{ 3, 4 };
+	{
+		Database db(name, settings);
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE(Put(db, present, Test1()).type == Error::Type::None);
+		Close(db);
+	}
+	Database db(name, settings);
+
+	// Nothing is known about the keys until the binlog is read.
+	REQUIRE(db.mayContain(missing));
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	REQUIRE((Get(db, missing).isEmpty()));
+	REQUIRE(db.mayContain(present));
+	REQUIRE(!db.mayContain(missing));
+
+	REQUIRE(Put(db, missing, Test2()).type == Error::Type::None);
+	REQUIRE(db.mayContain(missing));
+	REQUIRE((Get(db, missing) == Test2()));
+
+	REQUIRE(Clear(db).type == Error::Type::None);
+	REQUIRE((Get(db, present).isEmpty()));
+	REQUIRE(!db.mayContain(present));
+	Close(db);
+}
+
+TEST_CASE("snapshot db", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.snapshotAfterSize = 1;
+	const auto make = [](uint32 index) {
+		return Key{ index, index + 1 };
+	};
+	{
+		Database db(name, settings);
+		REQUIRE(Clear(db).type == Error::Type::None);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		for (auto i = 0; i != 20; ++i) {
+			REQUIRE(Put(db, make(i), Test1()).type == Error::Type::None);
+		}
+		Remove(db, make(3));
+		Close(db);
+	}
+	const auto snapshot = GetBinlogPath().replace("/binlog", "/snapshot");
+	REQUIRE(QFile(snapshot).exists());
+
+	// The tail after the snapshot is replayed from the binlog.
+	settings.snapshotAfterSize = 0;
+	{
+		Database db(name, settings);
+		REQUIRE(Open(db, key).type == Error::Type::None);
+		REQUIRE(Put(db, make(3), Test2()).type == Error::Type::None);
+		Remove(db, make(4));
+		Close(db);
+	}
+	Database db(name, settings);
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	for (auto i = 0; i != 20; ++i) {
+		const auto expected = (i == 3)
+			? Test2()
+			: (i == 4)
+			? QByteArray()
+			: Test1();
+		REQUIRE((Get(db, make(i)) == expected));
+	}
+	REQUIRE(Clear(db).type == Error::Type::None);
+	Close(db);
+}
+
+TEST_CASE("budgeted stale clear db", "[storage_cache_database]") {
+	auto settings = Settings;
+	settings.staleRemoveChunk = 2;
+	settings.staleRemoveParallel = 2;
+	settings.staleRemovePerSecond = 4;
+	const auto make = [](int i, uint8 tag) {
+		return Key{ uint64(i), uint64(tag) };
+	};
+	Database db(name, settings);
+	REQUIRE(Clear(db).type == Error::Type::None);
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	for (auto i = 0; i != 16; ++i) {
+		const auto tag = uint8((i % 2) ? 5 : 6);
+		auto value = Database::TaggedValue(Test1(), tag);
+		REQUIRE(Put(db, make(i, tag), std::move(value)).type
+			== Error::Type::None);
+	}
+	REQUIRE(ClearByTag(db, 5).type == Error::Type::None);
+
+	// Entries leave the index at once, the files follow in the budget.
+	for (auto i = 0; i != 16; ++i) {
+		const auto tag = uint8((i % 2) ? 5 : 6);
+		const auto expected = (tag == 5) ? QByteArray() : Test1();
+		REQUIRE((Get(db, make(i, tag)) == expected));
+	}
+	db.waitForCleaner([&] { Semaphore.release(); });
+	Semaphore.acquire();
+	Close(db);
+
+	REQUIRE(Open(db, key).type == Error::Type::None);
+	for (auto i = 0; i != 16; ++i) {
+		const auto tag = uint8((i % 2) ? 5 : 6);
+		const auto expected = (tag == 5) ? QByteArray() : Test1();
+		REQUIRE((Get(db, make(i, tag)) == expected));
+	}
+	REQUIRE(Clear(db).type == Error::Type::None);
+	Close(db);
+}
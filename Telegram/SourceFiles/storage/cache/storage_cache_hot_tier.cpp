@@ -0,0 +1,150 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "storage/cache/storage_cache_hot_tier.h"
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+HotTier::HotTier(int64 sizeLimit, size_type valueSizeLimit)
+: _sizeLimit(sizeLimit)
+, _valueSizeLimit(valueSizeLimit) {
+}
+
+void HotTier::reconfigure(int64 sizeLimit, size_type valueSizeLimit) {
+	QMutexLocker lock(&_mutex);
+	_sizeLimit = sizeLimit;
+	_valueSizeLimit = valueSizeLimit;
+	for (auto i = begin(_list); i != end(_list);) {
+		if (acceptable(i->value)) {
+			++i;
+		} else {
+			erase(i++);
+		}
+	}
+	shrink();
+}
+
+bool HotTier::enabled() const {
+	return (_sizeLimit > 0);
+}
+
+bool HotTier::acceptable(const TaggedValue &value) const {
+	const auto size = int64(value.bytes.size());
+	return enabled()
+		&& (size > 0)
+		&& (size <= _valueSizeLimit)
+		&& (size <= _sizeLimit);
+}
+
+std::optional<TaggedValue> HotTier::get(const Key &key) {
+	QMutexLocker lock(&_mutex);
+	if (!enabled()) {
+		return std::nullopt;
+	}
+	const auto i = _map.find(key);
+	if (i == end(_map)) {
+		++_misses;
+		return std::nullopt;
+	}
+	++_hits;
+	_list.splice(begin(_list), _list, i->second);
+	return i->second->value;
+}
+
+uint64 HotTier::generation() const {
+	QMutexLocker lock(&_mutex);
+	return _generation;
+}
+
+void HotTier::fill(
+		const Key &key,
+		const TaggedValue &value,
+		uint64 generation) {
+	QMutexLocker lock(&_mutex);
+	if (_generation == generation && acceptable(value)) {
+		insert(key, value);
+	}
+}
+
+void HotTier::put(const Key &key, const TaggedValue &value) {
+	QMutexLocker lock(&_mutex);
+	++_generation;
+	if (acceptable(value)) {
+		insert(key, value);
+	} else if (const auto i = _map.find(key); i != end(_map)) {
+		erase(i->second);
+	}
+}
+
+void HotTier::remove(const Key &key) {
+	QMutexLocker lock(&_mutex);
+	++_generation;
+	if (const auto i = _map.find(key); i != end(_map)) {
+		erase(i->second);
+	}
+}
+
+void HotTier::clear() {
+	QMutexLocker lock(&_mutex);
+	++_generation;
+	_list.clear();
+	_map.clear();
+	_size = 0;
+}
+
+void HotTier::clearByTag(uint8 tag) {
+	QMutexLocker lock(&_mutex);
+	++_generation;
+	for (auto i = begin(_list); i != end(_list);) {
+		if (i->value.tag == tag) {
+			erase(i++);
+		} else {
+			++i;
+		}
+	}
+}
+
+HotStats HotTier::stats() const {
+	QMutexLocker lock(&_mutex);
+	auto result = HotStats();
+	result.count = size_type(_map.size());
+	result.totalSize = _size;
+	result.hits = _hits;
+	result.misses = _misses;
+	return result;
+}
+
+void HotTier::insert(const Key &key, const TaggedValue &value) {
+	const auto i = _map.find(key);
+	if (i != end(_map)) {
+		_size -= i->second->value.bytes.size();
+		i->second->value = value;
+		_list.splice(begin(_list), _list, i->second);
+	} else {
+		_list.push_front({ key, value });
+		_map.emplace(key, begin(_list));
+	}
+	_size += value.bytes.size();
+	shrink();
+}
+
+void HotTier::erase(List::iterator i) {
+	_size -= i->value.bytes.size();
+	_map.erase(i->key);
+	_list.erase(i);
+}
+
+void HotTier::shrink() {
+	while (_size > _sizeLimit && !_list.empty()) {
+		erase(std::prev(end(_list)));
+	}
+}
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
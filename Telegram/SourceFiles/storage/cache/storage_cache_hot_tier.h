@@ -0,0 +1,70 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_types.h"
+#include <QtCore/QMutex>
+#include <list>
+#include <unordered_map>
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+// Byte budgeted LRU of decrypted values in front of the shard queues.
+// Can be used from any thread.
+//
+// Every change of the underlying database bumps the generation, values
+// read from disk are accepted only with the generation they were
+// requested at, so a slow read can't bring back an overwritten value.
+class HotTier {
+public:
+	HotTier(int64 sizeLimit, size_type valueSizeLimit);
+
+	void reconfigure(int64 sizeLimit, size_type valueSizeLimit);
+
+	std::optional<TaggedValue> get(const Key &key);
+	uint64 generation() const;
+	void fill(const Key &key, const TaggedValue &value, uint64 generation);
+
+	void put(const Key &key, const TaggedValue &value);
+	void remove(const Key &key);
+	void clear();
+	void clearByTag(uint8 tag);
+
+	HotStats stats() const;
+
+private:
+	struct Entry {
+		Key key;
+		TaggedValue value;
+	};
+	using List = std::list<Entry>;
+
+	bool enabled() const;
+	bool acceptable(const TaggedValue &value) const;
+	void insert(const Key &key, const TaggedValue &value);
+	void erase(List::iterator i);
+	void shrink();
+
+	mutable QMutex _mutex;
+	int64 _sizeLimit = 0;
+	size_type _valueSizeLimit = 0;
+	uint64 _generation = 0;
+
+	// Most recently used first.
+	List _list;
+	std::unordered_map<Key, List::iterator> _map;
+	int64 _size = 0;
+	int64 _hits = 0;
+	int64 _misses = 0;
+
+};
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
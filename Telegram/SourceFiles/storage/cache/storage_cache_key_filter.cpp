@@ -0,0 +1,82 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#include "storage/cache/storage_cache_key_filter.h"
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+KeyFilter::KeyFilter(size_type size)
+: _wordsCount(std::max(size, size_type(0)) / size_type(sizeof(uint64))) {
+	if (_wordsCount > 0) {
+		_words = std::make_unique<std::atomic<uint64>[]>(_wordsCount);
+		for (auto i = size_type(0); i != _wordsCount; ++i) {
+			_words[i].store(0, std::memory_order_relaxed);
+		}
+		_bitsCount = uint64(_wordsCount) * 64;
+	}
+}
+
+bool KeyFilter::mayContain(const Key &key) const {
+	if (!_wordsCount
+		|| !_ready.load(std::memory_order_acquire)
+		|| _writing.load(std::memory_order_acquire) > 0) {
+		return true;
+	}
+	auto result = true;
+	enumerate(key, [&](size_type index, uint64 mask) {
+		if (!(_words[index].load(std::memory_order_relaxed) & mask)) {
+			result = false;
+		}
+	});
+	return result;
+}
+
+KeyFilter::Writing::Writing(std::shared_ptr<KeyFilter> filter)
+: _filter(std::move(filter)) {
+	_filter->_writing.fetch_add(1, std::memory_order_acq_rel);
+}
+
+KeyFilter::Writing::~Writing() {
+	if (_filter) {
+		_filter->_writing.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void KeyFilter::add(const Key &key) {
+	if (!_wordsCount) {
+		return;
+	}
+	enumerate(key, [&](size_type index, uint64 mask) {
+		_words[index].fetch_or(mask, std::memory_order_relaxed);
+	});
+}
+
+void KeyFilter::reset() {
+	_ready.store(false, std::memory_order_release);
+	for (auto i = size_type(0); i != _wordsCount; ++i) {
+		_words[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void KeyFilter::setReady() {
+	_ready.store(true, std::memory_order_release);
+}
+
+void KeyFilter::store(const std::vector<uint64> &words) {
+	Expects(size_type(words.size()) == _wordsCount);
+
+	// Keys present both before and after keep all their bits set
+	// during the whole store, so readers never miss them.
+	for (auto i = size_type(0); i != _wordsCount; ++i) {
+		_words[i].store(words[i], std::memory_order_relaxed);
+	}
+}
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
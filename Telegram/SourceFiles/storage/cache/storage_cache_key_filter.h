@@ -0,0 +1,97 @@
+/*
+This file is part of Bettergram.
+
+For license and copyright information please follow this link:
+https://github.com/bettergram/bettergram/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/cache/storage_cache_types.h"
+#include <atomic>
+#include <memory>
+
+namespace Storage {
+namespace Cache {
+namespace details {
+
+// Bloom filter of the keys in one shard. Changed only on the shard
+// queue, mayContain() can be called from any thread without a hop.
+//
+// It answers "maybe" until the binlog is read and while any write to
+// the shard is still queued, so a key is never reported missing while
+// it is present or about to become present.
+class KeyFilter {
+public:
+	explicit KeyFilter(size_type size);
+
+	bool mayContain(const Key &key) const;
+
+	class Writing {
+	public:
+		explicit Writing(std::shared_ptr<KeyFilter> filter);
+		Writing(Writing &&other) = default;
+		Writing &operator=(Writing &&other) = delete;
+		~Writing();
+
+	private:
+		std::shared_ptr<KeyFilter> _filter;
+
+	};
+
+	void add(const Key &key);
+	void reset();
+	void setReady();
+
+	template <typename Map>
+	void rebuild(const Map &map);
+
+private:
+	static constexpr auto kHashesCount = 6;
+
+	template <typename Method>
+	void enumerate(const Key &key, Method &&method) const;
+	void store(const std::vector<uint64> &words);
+
+	std::unique_ptr<std::atomic<uint64>[]> _words;
+	uint64 _bitsCount = 0;
+	size_type _wordsCount = 0;
+	std::atomic<bool> _ready = { false };
+	std::atomic<int> _writing = { 0 };
+
+};
+
+template <typename Method>
+void KeyFilter::enumerate(const Key &key, Method &&method) const {
+	// Double hashing over a mix different from the shard index one.
+	auto first = key.low ^ (key.high * 0xC2B2AE3D27D4EB4FULL);
+	first ^= (first >> 33);
+	first *= 0xFF51AFD7ED558CCDULL;
+	first ^= (first >> 33);
+	auto second = key.high ^ (key.low * 0x165667B19E3779F9ULL);
+	second ^= (second >> 29);
+	second *= 0xC4CEB9FE1A85EC53ULL;
+	second ^= (second >> 32);
+	second |= 1;
+	for (auto i = 0; i != kHashesCount; ++i) {
+		const auto bit = (first + i * second) % _bitsCount;
+		method(size_type(bit / 64), uint64(1) << (bit % 64));
+	}
+}
+
+template <typename Map>
+void KeyFilter::rebuild(const Map &map) {
+	if (!_wordsCount) {
+		return;
+	}
+	auto words = std::vector<uint64>(_wordsCount, 0);
+	for (const auto &[key, entry] : map) {
+		enumerate(key, [&](size_type index, uint64 mask) {
+			words[index] |= mask;
+		});
+	}
+	store(words);
+}
+
+} // namespace details
+} // namespace Cache
+} // namespace Storage
@@ -52,6 +52,47 @@ QString ComputeBasePath(const QString &original) {
 	return result.endsWith('/') ? result : (result + '/');
 }
 
+QString ShardPath(const QString &original, int index) {
+	Expects(index >= 0);
+
+	if (!index) {
+		return original;
+	}
+	// Not inside the original folder, the cleaner removes everything
+	// there except the current version folder.
+	auto result = QDir(original).absolutePath();
+	while (result.endsWith('/')) {
+		result.chop(1);
+	}
+	return result + QStringLiteral("_shard") + QString::number(index);
+}
+
+int ShardIndex(const Key &key, int shardsCount) {
+	Expects(shardsCount > 0);
+
+	if (shardsCount == 1) {
+		return 0;
+	}
+	// Keys often differ only in a few low bits of one of the halves.
+	auto mixed = key.high ^ (key.low * 0x9E3779B97F4A7C15ULL);
+	mixed ^= (mixed >> 31);
+	mixed *= 0xBF58476D1CE4E5B9ULL;
+	mixed ^= (mixed >> 29);
+	return int(mixed % uint64(shardsCount));
+}
+
+Settings ShardSettings(const Settings &settings) {
+	Expects(settings.shardsCount > 0);
+
+	auto result = settings;
+	if (result.shardsCount > 1 && result.totalSizeLimit > 0) {
+		result.totalSizeLimit = std::max(
+			result.totalSizeLimit / result.shardsCount,
+			int64(result.maxDataSize) + 1);
+	}
+	return result;
+}
+
 QString VersionFilePath(const QString &base) {
 	Expects(base.endsWith('/'));
 
@@ -70,17 +70,52 @@ struct Settings {
 	crl::time writeBundleDelay = 15 * 60 * crl::time(1000);
 	size_type staleRemoveChunk = 256;
 
+	// Stale files are unlinked off the shard queue in chunks, at most
+	// that many chunks at once and that many files per second, zero
+	// means remove as fast as possible.
+	int staleRemoveParallel = 1;
+	size_type staleRemovePerSecond = 0;
+
 	int64 compactAfterExcess = 8 * 1024 * 1024;
 	int64 compactAfterFullSize = 0;
 	size_type compactChunkSize = 16 * 1024;
 
+	// Chunks are spread in time to read at most that many binlog bytes
+	// per second, zero means compact as fast as possible.
+	int64 compactBytesPerSecond = 0;
+
 	bool trackEstimatedTime = true;
 	int64 totalSizeLimit = 1024 * 1024 * 1024;
 	size_type totalTimeLimit = 31 * 24 * 60 * 60; // One month in seconds.
 	crl::time pruneTimeout = 5 * crl::time(1000);
 	crl::time maxPruneCheckTimeout = 3600 * crl::time(1000);
 
+	// Entries used at least that many times are pruned by size only
+	// after all the others, zero prunes just the least recently used.
+	int frequentUseCount = 0;
+
+	// Percent of totalSizeLimit a tag may take, so large one-off media
+	// is pruned inside its own quota before touching the other tags.
+	base::flat_map<uint8, int> tagSizeQuotas;
+
 	bool clearOnWrongKey = false;
+
+	// Independent binlogs, each with its own queue and compactor.
+	// The size limit is split between them, keys are spread by hash.
+	int shardsCount = 1;
+
+	// Decrypted values kept in memory in front of the shards, zero
+	// disables it. Larger values are always read from disk.
+	int64 hotSizeLimit = 0;
+	size_type hotValueSizeLimit = 512 * 1024;
+
+	// Bytes of the Bloom filter answering mayContain() in each shard,
+	// zero disables it. Ten bits per key give about one percent misses.
+	size_type keyFilterSize = 0;
+
+	// Write a snapshot of the index once the binlog grows by that much,
+	// so open replays only the tail. Zero disables writing snapshots.
+	int64 snapshotAfterSize = 0;
 };
 
 struct SettingsUpdate {
@@ -100,15 +135,38 @@ struct TaggedSummary {
 	size_type count = 0;
 	size_type totalSize = 0;
 };
+struct HotStats {
+	size_type count = 0;
+	int64 totalSize = 0;
+	int64 hits = 0;
+	int64 misses = 0;
+};
 struct Stats {
 	TaggedSummary full;
 	base::flat_map<uint8, TaggedSummary> tagged;
 	bool clearing = false;
+
+	// Stale entries still waiting for their files to be removed.
+	size_type clearingLeft = 0;
+
+	// Binlog bytes already walked by the running compaction, if any.
+	int64 compactProcessed = 0;
+	int64 compactTotal = 0;
+
+	// How long the last open took to build the index and how many
+	// binlog bytes it replayed after the snapshot.
+	crl::time indexReadDuration = 0;
+	int64 indexReplayedSize = 0;
+
+	HotStats hot;
 };
 
 using Version = int32;
 
 QString ComputeBasePath(const QString &original);
+QString ShardPath(const QString &original, int index);
+int ShardIndex(const Key &key, int shardsCount);
+Settings ShardSettings(const Settings &settings);
 QString VersionFilePath(const QString &base);
 std::optional<Version> ReadVersionValue(const QString &base);
 bool WriteVersionValue(const QString &base, Version value);
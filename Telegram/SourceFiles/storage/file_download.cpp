@@ -20,12 +20,28 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "base/bytes.h"
 #include "base/openssl_help.h"
 
+#include <numeric>
+
 namespace Storage {
 namespace {
 
 // How much time without download causes additional session kill.
 constexpr auto kKillSessionTimeout = crl::time(5000);
 
+// Part sizes are powers of two from the cdn part size up to the protocol
+// limit, so an aligned part never crosses a megabyte boundary.
+constexpr auto kMinPartSize = 128 * 1024;
+constexpr auto kMaxPartSize = 512 * 1024;
+constexpr auto kPartsInWindow = 16;
+constexpr auto kMinRequestsLimit = 4;
+constexpr auto kMaxRequestsLimit = 2 * kPartsInWindow;
+constexpr auto kStartInFlight = int64(kPartsInWindow * kMinPartSize);
+constexpr auto kMinInFlight = int64(kMinRequestsLimit * kMinPartSize);
+constexpr auto kMaxInFlight = int64(kMaxRequestsLimit * kMaxPartSize);
+constexpr auto kLoadMeasureInterval = crl::time(1000);
+constexpr auto kLoadIdleTimeout = 5 * kLoadMeasureInterval;
+constexpr auto kQueueingRttFactor = 2;
+
 } // namespace
 
 Downloader::Downloader()
@@ -49,6 +65,135 @@ void Downloader::requestedAmountIncrement(MTP::DcId dcId, int index, int amount)
 	} else {
 		killDownloadSessionsStart(dcId);
 	}
+	if (amount > 0) {
+		auto &load = dcLoad(dcId);
+		const auto requested = std::accumulate(
+			begin(it->second),
+			end(it->second),
+			int64(0));
+		if (requested + partSize(dcId) > load.inFlightLimit) {
+			load.windowSaturated = true;
+		}
+	}
+}
+
+void Downloader::partLoaded(MTP::DcId dcId, int size, crl::time sentAt) {
+	const auto now = crl::now();
+	const auto rtt = std::max(now - sentAt, crl::time(1));
+	auto &load = dcLoad(dcId);
+	load.rtt = load.rtt ? ((load.rtt * 7 + rtt) / 8) : rtt;
+	load.windowMinRtt = load.windowMinRtt
+		? std::min(load.windowMinRtt, rtt)
+		: rtt;
+	if (!load.windowStart || now - load.windowStart > kLoadIdleTimeout) {
+		load.windowStart = sentAt;
+		load.windowBytes = 0;
+	}
+	load.windowBytes += size;
+	if (now - load.windowStart >= kLoadMeasureInterval) {
+		updateDcLoad(dcId, load, now);
+	}
+}
+
+void Downloader::updateDcLoad(MTP::DcId dcId, DcLoad &load, crl::time now) {
+	const auto speed = load.windowBytes * 1000 / (now - load.windowStart);
+	load.minRtt = load.minRtt
+		? std::min(load.windowMinRtt, load.minRtt + load.minRtt / 8)
+		: load.windowMinRtt;
+
+	// Bytes that should be in flight to keep the current speed.
+	const auto needed = speed * load.minRtt / 1000;
+	const auto was = load.inFlightLimit;
+	if (load.rtt > kQueueingRttFactor * load.minRtt) {
+		// Requests wait in some queue on the way, don't add more of them.
+		load.inFlightLimit = std::max({
+			load.inFlightLimit * 3 / 4,
+			needed,
+			kMinInFlight });
+	} else if (load.windowSaturated && speed * 10 >= load.bytesPerSecond * 11) {
+		// The window was full and the speed still grows with it.
+		load.inFlightLimit = std::min(load.inFlightLimit * 5 / 4, kMaxInFlight);
+	}
+	load.inFlightLimit = std::min(load.inFlightLimit, kMaxInFlight);
+	if (load.inFlightLimit != was) {
+		DEBUG_LOG(("Download Info: dc %1 in flight limit %2 -> %3, "
+			"rtt %4 (min %5), speed %6"
+			).arg(dcId
+			).arg(was
+			).arg(load.inFlightLimit
+			).arg(load.rtt
+			).arg(load.minRtt
+			).arg(speed));
+	}
+
+	load.bytesPerSecond = speed;
+	load.windowStart = now;
+	load.windowBytes = 0;
+	load.windowMinRtt = 0;
+	load.windowSaturated = false;
+}
+
+auto Downloader::dcLoad(MTP::DcId dcId) -> DcLoad& {
+	auto i = _dcLoads.find(dcId);
+	if (i == end(_dcLoads)) {
+		auto load = DcLoad();
+		load.inFlightLimit = kStartInFlight;
+		i = _dcLoads.emplace(dcId, load).first;
+	}
+	return i->second;
+}
+
+auto Downloader::findDcLoad(MTP::DcId dcId) const -> const DcLoad* {
+	const auto i = _dcLoads.find(dcId);
+	return (i != end(_dcLoads)) ? &i->second : nullptr;
+}
+
+int Downloader::partSize(MTP::DcId dcId) const {
+	const auto load = findDcLoad(dcId);
+	const auto limit = load ? load->inFlightLimit : kStartInFlight;
+	auto result = kMinPartSize;
+	while (result < kMaxPartSize
+		&& int64(2 * result) * kPartsInWindow <= limit) {
+		result *= 2;
+	}
+	return result;
+}
+
+int Downloader::requestsLimit(MTP::DcId dcId) const {
+	return snap(
+		int(inFlightLimit(dcId) / partSize(dcId)),
+		kMinRequestsLimit,
+		kMaxRequestsLimit);
+}
+
+int64 Downloader::inFlightLimit(MTP::DcId dcId) const {
+	const auto load = findDcLoad(dcId);
+	return load ? load->inFlightLimit : kStartInFlight;
+}
+
+void Downloader::documentPartLoaded(
+		uint64 documentId,
+		int offset,
+		bytes::const_span bytes) {
+	_documentPartsLoaded.fire({ documentId, offset, bytes });
+}
+
+auto Downloader::documentPartsLoaded() const
+-> rpl::producer<DocumentPartLoaded> {
+	return _documentPartsLoaded.events();
+}
+
+auto Downloader::stats() const -> base::flat_map<MTP::DcId, DcStats> {
+	auto result = base::flat_map<MTP::DcId, DcStats>();
+	for (const auto &[dcId, load] : _dcLoads) {
+		auto &stats = result[dcId];
+		stats.rtt = load.rtt;
+		stats.bytesPerSecond = load.bytesPerSecond;
+		stats.inFlightLimit = load.inFlightLimit;
+		stats.partSize = partSize(dcId);
+		stats.requestsLimit = requestsLimit(dcId);
+	}
+	return result;
 }
 
 void Downloader::killDownloadSessionsStart(MTP::DcId dcId) {
@@ -118,17 +263,97 @@ constexpr auto kMaxFileQueries = 16; // max 16 file parts downloaded at the same
 constexpr auto kMaxWebFileQueries = 8; // max 8 http[s] files downloaded at the same time
 constexpr auto kDownloadCdnPartSize = 128 * 1024; // 128kb for cdn requests
 
+// Documents from this size are loaded with a saved progress.
+constexpr auto kResumableFromSize = Storage::kMaxFileInMemory;
+constexpr auto kResumeSaveInterval = crl::time(1000);
+constexpr auto kResumeStateVersion = 1;
+
+// Share of the requests limit a class can take while other classes have
+// something to load, in percent.
+constexpr auto kDownloadClassShares = std::array<int, Storage::kDownloadClassCount>{ {
+	100, // Visible
+	75, // Stream
+	50, // Prefetch
+	25, // Background
+} };
+
+// Requests only images in the viewport can take, so that scrolling never
+// waits until some large document parts are loaded.
+constexpr auto kVisibleReservedQueries = 2;
+
+// Automatic downloads that didn't start and weren't painted since the
+// user switched to other content that many times wait until painted.
+constexpr auto kPrefetchPriorityLifetime = 2;
+
+QString ResumePartPath(const QString &filename) {
+	return filename + qsl(".part");
+}
+
+QString ResumeStatePath(const QString &filename) {
+	return filename + qsl(".part.info");
+}
+
+// Decrypts a cdn part in place and computes its hash, off the main thread.
+bytes::vector DecryptCdnPart(
+		int offset,
+		const QByteArray &encryptionKey,
+		const QByteArray &encryptionIV,
+		QByteArray &decryptInPlace) {
+	auto key = bytes::make_span(encryptionKey);
+	auto iv = bytes::make_span(encryptionIV);
+	Expects(key.size() == MTP::CTRState::KeySize);
+	Expects(iv.size() == MTP::CTRState::IvecSize);
+
+	auto state = MTP::CTRState();
+	auto ivec = bytes::make_span(state.ivec);
+	std::copy(iv.begin(), iv.end(), ivec.begin());
+
+	auto counterOffset = static_cast<uint32>(offset) >> 4;
+	state.ivec[15] = static_cast<uchar>(counterOffset & 0xFF);
+	state.ivec[14] = static_cast<uchar>((counterOffset >> 8) & 0xFF);
+	state.ivec[13] = static_cast<uchar>((counterOffset >> 16) & 0xFF);
+	state.ivec[12] = static_cast<uchar>((counterOffset >> 24) & 0xFF);
+
+	auto buffer = bytes::make_detached_span(decryptInPlace);
+	MTP::aesCtrEncrypt(buffer, key.data(), &state);
+	return openssl::Sha256(buffer);
+}
+
 } // namespace
 
 struct FileLoaderQueue {
+	using Classes = std::array<bool, Storage::kDownloadClassCount>;
+
 	FileLoaderQueue(int queriesLimit) : queriesLimit(queriesLimit) {
 	}
+	bool allows(Storage::DownloadClass type, const Classes &waiting) const;
+
 	int queriesCount = 0;
 	int queriesLimit = 0;
+	std::array<int, Storage::kDownloadClassCount> classQueries = { { 0 } };
 	FileLoader *start = nullptr;
 	FileLoader *end = nullptr;
 };
 
+bool FileLoaderQueue::allows(
+		Storage::DownloadClass type,
+		const Classes &waiting) const {
+	const auto index = static_cast<int>(type);
+	const auto limit = (type == Storage::DownloadClass::Visible)
+		? queriesLimit
+		: (queriesLimit - kVisibleReservedQueries);
+	if (queriesCount >= limit) {
+		return false;
+	}
+	for (auto other = 0; other != Storage::kDownloadClassCount; ++other) {
+		if (other != index && waiting[other]) {
+			const auto share = queriesLimit * kDownloadClassShares[index] / 100;
+			return (classQueries[index] < std::max(share, 1));
+		}
+	}
+	return true;
+}
+
 namespace {
 
 using LoaderQueues = QMap<int32, FileLoaderQueue>;
@@ -254,15 +479,52 @@ void FileLoader::LoadNextFromQueue(not_null<FileLoaderQueue*> queue) {
 	if (queue->queriesCount >= queue->queriesLimit) {
 		return;
 	}
-	for (auto i = queue->start; i;) {
-		if (i->loadPart()) {
-			if (queue->queriesCount >= queue->queriesLimit) {
-				return;
+	// A class holds its share of the window only while it has a part to
+	// send, loaders with every part already in flight don't count.
+	auto waiting = FileLoaderQueue::Classes{ { false } };
+	for (auto i = queue->start; i; i = i->_next) {
+		if (!i->stalePrefetch() && i->canLoadPart()) {
+			waiting[static_cast<int>(i->_downloadClass)] = true;
+		}
+	}
+
+	// The list is ordered by the paint priority inside each class.
+	for (auto index = 0; index != Storage::kDownloadClassCount; ++index) {
+		const auto type = static_cast<Storage::DownloadClass>(index);
+		for (auto i = queue->start; i;) {
+			if (!queue->allows(type, waiting)) {
+				break;
+			} else if (i->_downloadClass != type
+				|| i->stalePrefetch()
+				|| !i->loadPart()) {
+				i = i->_next;
 			}
-		} else {
-			i = i->_next;
 		}
+		if (queue->queriesCount >= queue->queriesLimit) {
+			return;
+		}
+	}
+}
+
+bool FileLoader::stalePrefetch() const {
+	return (_downloadClass == Storage::DownloadClass::Prefetch)
+		&& _autoLoading
+		&& (_priority + kPrefetchPriorityLifetime
+			< _downloader->currentPriority())
+		&& !currentOffset(true);
+}
+
+Storage::DownloadClass FileLoader::computeDownloadClass(bool prior) const {
+	using Class = Storage::DownloadClass;
+	if (_autoLoading) {
+		return Class::Prefetch;
+	} else if (_locationType == UnknownFileLocation) {
+		return prior ? Class::Visible : Class::Prefetch;
+	} else if (_locationType == AudioFileLocation
+		|| _locationType == VideoFileLocation) {
+		return Class::Stream;
 	}
+	return Class::Background;
 }
 
 void FileLoader::removeFromQueue() {
@@ -322,12 +584,14 @@ void FileLoader::start(bool loadFirst, bool prior) {
 	}
 
 	if (!_filename.isEmpty() && _toCache == LoadToFileOnly && !_fileIsOpen) {
-		_fileIsOpen = _file.open(QIODevice::WriteOnly);
+		_fileIsOpen = openFile();
 		if (!_fileIsOpen) {
 			return cancel(true);
 		}
 	}
 
+	_downloadClass = computeDownloadClass(prior);
+
 	auto currentPriority = _downloader->currentPriority();
 	FileLoader *before = 0, *after = 0;
 	if (prior) {
@@ -470,7 +734,8 @@ bool FileLoader::tryLoadLocal() {
 	}
 
 	const auto weak = make_weak(this);
-	if (const auto key = cacheKey()) {
+	const auto key = cacheKey();
+	if (key && Auth().data().cache().mayContain(*key)) {
 		loadLocal(*key);
 		emit progress(this);
 	}
@@ -486,6 +751,10 @@ bool FileLoader::tryLoadLocal() {
 	return false;
 }
 
+bool FileLoader::openFile() {
+	return _file.open(QIODevice::WriteOnly);
+}
+
 void FileLoader::cancel() {
 	cancel(false);
 }
@@ -499,6 +768,7 @@ void FileLoader::cancel(bool fail) {
 		_file.close();
 		_fileIsOpen = false;
 		_file.remove();
+		removeResumeState();
 	}
 	_data = QByteArray();
 	removeFromQueue();
@@ -518,10 +788,16 @@ void FileLoader::cancel(bool fail) {
 }
 
 void FileLoader::startLoading(bool loadFirst, bool prior) {
-	if ((_queue->queriesCount >= _queue->queriesLimit && (!loadFirst || !prior)) || _finished) {
+	if (_finished) {
+		return;
+	} else if (loadFirst
+		&& prior
+		&& _downloadClass == Storage::DownloadClass::Visible) {
+		// Goes even over the requests limit, like it always did.
+		loadPart();
 		return;
 	}
-	loadPart();
+	LoadNextFromQueue(_queue);
 }
 
 mtpFileLoader::mtpFileLoader(
@@ -664,53 +940,82 @@ void mtpFileLoader::refreshFileReferenceFrom(
 	} else {
 		_fileReference = updated;
 	}
-	const auto offset = finishSentRequestGetOffset(requestId);
-	makeRequest(offset);
+	const auto request = finishSentRequest(requestId);
+	makeRequest(request.offset, request.limit);
 }
 
-bool mtpFileLoader::loadPart() {
+bool mtpFileLoader::canLoadPart() const {
 	if (_finished || _lastComplete || (!_sentRequests.empty() && !_size)) {
 		return false;
 	} else if (_size && _nextRequestOffset >= _size) {
 		return false;
 	}
+	return true;
+}
+
+bool mtpFileLoader::loadPart() {
+	if (!canLoadPart()) {
+		return false;
+	}
+	_queue->queriesLimit = _downloader->requestsLimit(
+		_cdnDcId ? _cdnDcId : _dcId);
 
-	makeRequest(_nextRequestOffset);
-	_nextRequestOffset += partSize();
+	const auto limit = partSize();
+	makeRequest(_nextRequestOffset, limit);
+	_nextRequestOffset += limit;
 	return true;
 }
 
 int mtpFileLoader::partSize() const {
-	return kDownloadCdnPartSize;
-
-	// Different part sizes are not supported for now :(
-	// Because we start downloading with some part size
-	// and then we get a cdn-redirect where we support only
-	// fixed part size download for hash checking.
-	//
-	//if (_cdnDcId) {
-	//	return kDownloadCdnPartSize;
-	//} else if (_locationType == UnknownFileLocation) {
-	//	return kDownloadPhotoPartSize;
-	//}
-	//return kDownloadDocumentPartSize;
-}
-
-mtpFileLoader::RequestData mtpFileLoader::prepareRequest(int offset) const {
+	// Cdn parts are checked by hashes of fixed size parts and web files
+	// don't support other part sizes. Parts that were requested before
+	// a cdn-redirect are split to cdn parts in makeRequest().
+	if (_cdnDcId || _urlLocation || _geoLocation || !_size) {
+		return kDownloadCdnPartSize;
+	}
+	auto result = _downloader->partSize(_dcId);
+	while (_nextRequestOffset % result) {
+		result /= 2;
+	}
+	return result;
+}
+
+mtpFileLoader::RequestData mtpFileLoader::prepareRequest(
+		int offset,
+		int limit) const {
 	auto result = RequestData();
 	result.dcId = _cdnDcId ? _cdnDcId : _dcId;
 	result.dcIndex = _size ? _downloader->chooseDcIndexForRequest(result.dcId) : 0;
 	result.offset = offset;
+	result.limit = limit;
 	return result;
 }
 
-void mtpFileLoader::makeRequest(int offset) {
+void mtpFileLoader::makeRequest(int offset, int limit) {
+	Expects(!_finished);
+
+	if (!_cdnDcId) {
+		sendRequest(offset, limit);
+		return;
+	}
+	for (const auto till = offset + limit; offset < till;) {
+		sendRequest(offset, kDownloadCdnPartSize);
+
+		// Ask for the hashes together with the part, not after it arrives.
+		if (_cdnFileHashes.find(offset) == end(_cdnFileHashes)) {
+			requestCdnFileHashes(offset);
+		}
+		offset += kDownloadCdnPartSize;
+	}
+}
+
+void mtpFileLoader::sendRequest(int offset, int limit) {
 	Expects(!_finished);
 
-	auto requestData = prepareRequest(offset);
+	auto requestData = prepareRequest(offset, limit);
 	auto send = [this, &requestData] {
 		auto offset = requestData.offset;
-		auto limit = partSize();
+		auto limit = requestData.limit;
 		auto shiftedDcId = MTP::downloadDcId(requestData.dcId, requestData.dcIndex);
 		if (_cdnDcId) {
 			Assert(requestData.dcId == _cdnDcId);
@@ -792,15 +1097,22 @@ MTPInputFileLocation mtpFileLoader::computeLocation() const {
 void mtpFileLoader::requestMoreCdnFileHashes() {
 	Expects(!_finished);
 
-	if (_cdnHashesRequestId || _cdnUncheckedParts.empty()) {
-		return;
+	if (!_cdnUncheckedParts.empty()) {
+		requestCdnFileHashes(_cdnUncheckedParts.cbegin()->first);
 	}
+}
+
+void mtpFileLoader::requestCdnFileHashes(int offset) {
+	Expects(!_finished);
 
-	auto offset = _cdnUncheckedParts.cbegin()->first;
+	if (_cdnHashesRequestId) {
+		return;
+	}
 	auto requestData = RequestData();
 	requestData.dcId = _dcId;
 	requestData.dcIndex = 0;
 	requestData.offset = offset;
+	requestData.limit = kDownloadCdnPartSize;
 	auto shiftedDcId = MTP::downloadDcId(requestData.dcId, requestData.dcIndex);
 	auto requestId = _cdnHashesRequestId = MTP::send(
 		MTPupload_GetCdnFileHashes(
@@ -818,12 +1130,13 @@ void mtpFileLoader::normalPartLoaded(
 	Expects(!_finished);
 	Expects(result.type() == mtpc_upload_fileCdnRedirect || result.type() == mtpc_upload_file);
 
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto request = finishSentRequest(requestId);
 	if (result.type() == mtpc_upload_fileCdnRedirect) {
-		return switchToCDN(offset, result.c_upload_fileCdnRedirect());
+		return switchToCDN(request, result.c_upload_fileCdnRedirect());
 	}
 	auto buffer = bytes::make_span(result.c_upload_file().vbytes.v);
-	return partLoaded(offset, buffer);
+	_downloader->partLoaded(request.dcId, buffer.size(), request.sent);
+	return partLoaded(request.offset, buffer);
 }
 
 void mtpFileLoader::webPartLoaded(
@@ -831,7 +1144,7 @@ void mtpFileLoader::webPartLoaded(
 		mtpRequestId requestId) {
 	Expects(result.type() == mtpc_upload_webFile);
 
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto request = finishSentRequest(requestId);
 	auto &webFile = result.c_upload_webFile();
 	if (!_size) {
 		_size = webFile.vsize.v;
@@ -840,18 +1153,21 @@ void mtpFileLoader::webPartLoaded(
 		return cancel(true);
 	}
 	auto buffer = bytes::make_span(webFile.vbytes.v);
-	return partLoaded(offset, buffer);
+	_downloader->partLoaded(request.dcId, buffer.size(), request.sent);
+	return partLoaded(request.offset, buffer);
 }
 
 void mtpFileLoader::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId requestId) {
 	Expects(!_finished);
 
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto request = finishSentRequest(requestId);
+	const auto offset = request.offset;
 	if (result.type() == mtpc_upload_cdnFileReuploadNeeded) {
 		auto requestData = RequestData();
 		requestData.dcId = _dcId;
 		requestData.dcIndex = 0;
 		requestData.offset = offset;
+		requestData.limit = request.limit;
 		auto shiftedDcId = MTP::downloadDcId(requestData.dcId, requestData.dcIndex);
 		auto requestId = MTP::send(MTPupload_ReuploadCdnFile(MTP_bytes(_cdnToken), result.c_upload_cdnFileReuploadNeeded().vrequest_token), rpcDone(&mtpFileLoader::reuploadDone), rpcFail(&mtpFileLoader::cdnPartFailed), shiftedDcId);
 		placeSentRequest(requestId, requestData);
@@ -859,28 +1175,38 @@ void mtpFileLoader::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId
 	}
 	Expects(result.type() == mtpc_upload_cdnFile);
 
-	auto key = bytes::make_span(_cdnEncryptionKey);
-	auto iv = bytes::make_span(_cdnEncryptionIV);
-	Expects(key.size() == MTP::CTRState::KeySize);
-	Expects(iv.size() == MTP::CTRState::IvecSize);
-
-	auto state = MTP::CTRState();
-	auto ivec = bytes::make_span(state.ivec);
-	std::copy(iv.begin(), iv.end(), ivec.begin());
-
-	auto counterOffset = static_cast<uint32>(offset) >> 4;
-	state.ivec[15] = static_cast<uchar>(counterOffset & 0xFF);
-	state.ivec[14] = static_cast<uchar>((counterOffset >> 8) & 0xFF);
-	state.ivec[13] = static_cast<uchar>((counterOffset >> 16) & 0xFF);
-	state.ivec[12] = static_cast<uchar>((counterOffset >> 24) & 0xFF);
+	auto encrypted = result.c_upload_cdnFile().vbytes.v;
+	_downloader->partLoaded(request.dcId, encrypted.size(), request.sent);
+
+	// The requests for the next parts go on while this one is decrypted.
+	++_cdnPartsDecrypting;
+	crl::async([
+		=,
+		weak = QPointer<mtpFileLoader>(this),
+		key = _cdnEncryptionKey,
+		iv = _cdnEncryptionIV,
+		decryptInPlace = std::move(encrypted)
+	]() mutable {
+		auto hash = DecryptCdnPart(offset, key, iv, decryptInPlace);
+		crl::on_main(weak, [
+			=,
+			part = CdnPart{ std::move(decryptInPlace), std::move(hash) }
+		]() mutable {
+			weak->cdnPartDecrypted(offset, std::move(part));
+		});
+	});
+}
 
-	auto decryptInPlace = result.c_upload_cdnFile().vbytes.v;
-	auto buffer = bytes::make_detached_span(decryptInPlace);
-	MTP::aesCtrEncrypt(buffer, key.data(), &state);
+void mtpFileLoader::cdnPartDecrypted(int offset, CdnPart &&part) {
+	Expects(_cdnPartsDecrypting > 0);
 
-	switch (checkCdnFileHash(offset, buffer)) {
+	--_cdnPartsDecrypting;
+	if (_finished) {
+		return;
+	}
+	switch (checkCdnFileHash(offset, part)) {
 	case CheckCdnHashResult::NoHash: {
-		_cdnUncheckedParts.emplace(offset, decryptInPlace);
+		_cdnUncheckedParts.emplace(offset, std::move(part));
 		requestMoreCdnFileHashes();
 	} return;
 
@@ -889,27 +1215,31 @@ void mtpFileLoader::cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId
 		cancel(true);
 	} return;
 
-	case CheckCdnHashResult::Good: return partLoaded(offset, buffer);
+	case CheckCdnHashResult::Good: {
+		return partLoaded(offset, bytes::make_span(part.bytes));
+	}
 	}
 	Unexpected("Result of checkCdnFileHash()");
 }
 
-mtpFileLoader::CheckCdnHashResult mtpFileLoader::checkCdnFileHash(int offset, bytes::const_span buffer) {
+mtpFileLoader::CheckCdnHashResult mtpFileLoader::checkCdnFileHash(
+		int offset,
+		const CdnPart &part) const {
 	auto cdnFileHashIt = _cdnFileHashes.find(offset);
 	if (cdnFileHashIt == _cdnFileHashes.cend()) {
 		return CheckCdnHashResult::NoHash;
 	}
-	auto realHash = openssl::Sha256(buffer);
-	if (bytes::compare(realHash, bytes::make_span(cdnFileHashIt->second.hash))) {
+	const auto &hash = cdnFileHashIt->second.hash;
+	if (bytes::compare(part.hash, bytes::make_span(hash))) {
 		return CheckCdnHashResult::Invalid;
 	}
 	return CheckCdnHashResult::Good;
 }
 
 void mtpFileLoader::reuploadDone(const MTPVector<MTPFileHash> &result, mtpRequestId requestId) {
-	auto offset = finishSentRequestGetOffset(requestId);
+	const auto request = finishSentRequest(requestId);
 	addCdnHashes(result.v);
-	makeRequest(offset);
+	makeRequest(request.offset, request.limit);
 }
 
 void mtpFileLoader::getCdnFileHashesDone(const MTPVector<MTPFileHash> &result, mtpRequestId requestId) {
@@ -918,78 +1248,88 @@ void mtpFileLoader::getCdnFileHashesDone(const MTPVector<MTPFileHash> &result, m
 
 	_cdnHashesRequestId = 0;
 
-	const auto offset = finishSentRequestGetOffset(requestId);
+	const auto offset = finishSentRequest(requestId).offset;
 	addCdnHashes(result.v);
-	auto someMoreChecked = false;
-	for (auto i = _cdnUncheckedParts.begin(); i != _cdnUncheckedParts.cend();) {
-		const auto uncheckedOffset = i->first;
-		const auto uncheckedBytes = bytes::make_span(i->second);
+	if (_cdnFileHashes.find(offset) == end(_cdnFileHashes)) {
+		LOG(("API Error: Could not find cdnFileHash for offset %1 after getCdnFileHashes request.").arg(offset));
+		cancel(true);
+		return;
+	}
+	if (!feedCheckedCdnParts()) {
+		return;
+	}
+	const auto weak = make_weak(this);
+	notifyAboutProgress();
+	if (weak && !_finished) {
+		requestMoreCdnFileHashes();
+	}
+}
 
-		switch (checkCdnFileHash(uncheckedOffset, uncheckedBytes)) {
+bool mtpFileLoader::feedCheckedCdnParts() {
+	for (auto i = _cdnUncheckedParts.begin(); i != _cdnUncheckedParts.cend();) {
+		switch (checkCdnFileHash(i->first, i->second)) {
 		case CheckCdnHashResult::NoHash: {
 			++i;
 		} break;
 
 		case CheckCdnHashResult::Invalid: {
-			LOG(("API Error: Wrong cdnFileHash for offset %1.").arg(offset));
+			LOG(("API Error: Wrong cdnFileHash for offset %1.").arg(i->first));
 			cancel(true);
-			return;
+			return false;
 		} break;
 
 		case CheckCdnHashResult::Good: {
-			someMoreChecked = true;
-			const auto goodOffset = uncheckedOffset;
-			const auto goodBytes = std::move(i->second);
+			const auto goodOffset = i->first;
+			const auto goodBytes = std::move(i->second.bytes);
 			const auto weak = QPointer<mtpFileLoader>(this);
 			i = _cdnUncheckedParts.erase(i);
 			if (!feedPart(goodOffset, bytes::make_span(goodBytes))
 				|| !weak) {
-				return;
+				return false;
 			} else if (_finished) {
 				notifyAboutProgress();
-				return;
+				return false;
 			}
 		} break;
 
 		default: Unexpected("Result of checkCdnFileHash()");
 		}
 	}
-	if (someMoreChecked) {
-		const auto weak = make_weak(this);
-		notifyAboutProgress();
-		if (weak) {
-			requestMoreCdnFileHashes();
-		}
-		return;
-	}
-	LOG(("API Error: Could not find cdnFileHash for offset %1 after getCdnFileHashes request.").arg(offset));
-	cancel(true);
+	return true;
 }
 
 void mtpFileLoader::placeSentRequest(mtpRequestId requestId, const RequestData &requestData) {
 	Expects(!_finished);
 
-	_downloader->requestedAmountIncrement(requestData.dcId, requestData.dcIndex, partSize());
+	_downloader->requestedAmountIncrement(requestData.dcId, requestData.dcIndex, requestData.limit);
 	++_queue->queriesCount;
-	_sentRequests.emplace(requestId, requestData);
+	++_queue->classQueries[static_cast<int>(_downloadClass)];
+	const auto i = _sentRequests.emplace(requestId, requestData).first;
+	i->second.sent = crl::now();
+	i->second.downloadClass = _downloadClass;
 }
 
-int mtpFileLoader::finishSentRequestGetOffset(mtpRequestId requestId) {
+auto mtpFileLoader::finishSentRequest(mtpRequestId requestId)
+-> RequestData {
 	auto it = _sentRequests.find(requestId);
 	Assert(it != _sentRequests.cend());
 
 	auto requestData = it->second;
-	_downloader->requestedAmountIncrement(requestData.dcId, requestData.dcIndex, -partSize());
+	_downloader->requestedAmountIncrement(requestData.dcId, requestData.dcIndex, -requestData.limit);
 
 	--_queue->queriesCount;
+	--_queue->classQueries[static_cast<int>(requestData.downloadClass)];
 	_sentRequests.erase(it);
 
-	return requestData.offset;
+	return requestData;
 }
 
 bool mtpFileLoader::feedPart(int offset, bytes::const_span buffer) {
 	Expects(!_finished);
 
+	if (!buffer.empty() && _id && !_urlLocation && !_geoLocation) {
+		_downloader->documentPartLoaded(_id, offset, buffer);
+	}
 	if (!buffer.empty()) {
 		if (_fileIsOpen) {
 			auto fsize = _file.size();
@@ -1003,6 +1343,9 @@ bool mtpFileLoader::feedPart(int offset, bytes::const_span buffer) {
 				cancel(true);
 				return false;
 			}
+			if (_resumable) {
+				trackResumePart(offset, buffer.size());
+			}
 		} else {
 			_data.reserve(offset + buffer.size());
 			if (offset > _data.size()) {
@@ -1028,6 +1371,7 @@ bool mtpFileLoader::feedPart(int offset, bytes::const_span buffer) {
 	}
 	if (_sentRequests.empty()
 		&& _cdnUncheckedParts.empty()
+		&& !_cdnPartsDecrypting
 		&& (_lastComplete || (_size && _nextRequestOffset >= _size))) {
 		if (!_filename.isEmpty() && (_toCache == LoadToCacheAsWell)) {
 			if (!_fileIsOpen) {
@@ -1042,6 +1386,10 @@ bool mtpFileLoader::feedPart(int offset, bytes::const_span buffer) {
 		if (_fileIsOpen) {
 			_file.close();
 			_fileIsOpen = false;
+			if (_resumable && !finishResumableFile()) {
+				cancel(true);
+				return false;
+			}
 			Platform::File::PostprocessDownloaded(QFileInfo(_file).absoluteFilePath());
 		}
 		removeFromQueue();
@@ -1111,9 +1459,9 @@ bool mtpFileLoader::cdnPartFailed(
 	}
 	if (error.type() == qstr("FILE_TOKEN_INVALID")
 		|| error.type() == qstr("REQUEST_TOKEN_INVALID")) {
-		auto offset = finishSentRequestGetOffset(requestId);
+		const auto request = finishSentRequest(requestId);
 		changeCDNParams(
-			offset,
+			request,
 			0,
 			QByteArray(),
 			QByteArray(),
@@ -1128,15 +1476,16 @@ void mtpFileLoader::cancelRequests() {
 	while (!_sentRequests.empty()) {
 		auto requestId = _sentRequests.begin()->first;
 		MTP::cancel(requestId);
-		finishSentRequestGetOffset(requestId);
+		finishSentRequest(requestId);
 	}
+	_cdnHashesRequestId = 0;
 }
 
 void mtpFileLoader::switchToCDN(
-		int offset,
+		const RequestData &request,
 		const MTPDupload_fileCdnRedirect &redirect) {
 	changeCDNParams(
-		offset,
+		request,
 		redirect.vdc_id.v,
 		redirect.vfile_token.v,
 		redirect.vencryption_key.v,
@@ -1155,7 +1504,7 @@ void mtpFileLoader::addCdnHashes(const QVector<MTPFileHash> &hashes) {
 }
 
 void mtpFileLoader::changeCDNParams(
-		int offset,
+		const RequestData &request,
 		MTP::DcId dcId,
 		const QByteArray &token,
 		const QByteArray &encryptionKey,
@@ -1180,19 +1529,23 @@ void mtpFileLoader::changeCDNParams(
 	addCdnHashes(hashes);
 
 	if (resendAllRequests && !_sentRequests.empty()) {
-		auto resendOffsets = std::vector<int>();
-		resendOffsets.reserve(_sentRequests.size());
+		auto resendRequests = std::vector<RequestData>();
+		resendRequests.reserve(_sentRequests.size());
 		while (!_sentRequests.empty()) {
 			auto requestId = _sentRequests.begin()->first;
 			MTP::cancel(requestId);
-			auto resendOffset = finishSentRequestGetOffset(requestId);
-			resendOffsets.push_back(resendOffset);
+			const auto request = finishSentRequest(requestId);
+			if (requestId == _cdnHashesRequestId) {
+				_cdnHashesRequestId = 0;
+			} else {
+				resendRequests.push_back(request);
+			}
 		}
-		for (auto resendOffset : resendOffsets) {
-			makeRequest(resendOffset);
+		for (const auto &resend : resendRequests) {
+			makeRequest(resend.offset, resend.limit);
 		}
 	}
-	makeRequest(offset);
+	makeRequest(request.offset, request.limit);
 }
 
 std::optional<Storage::Cache::Key> mtpFileLoader::cacheKey() const {
@@ -1208,7 +1561,113 @@ std::optional<Storage::Cache::Key> mtpFileLoader::cacheKey() const {
 	return std::nullopt;
 }
 
+bool mtpFileLoader::openFile() {
+	_resumable = _id
+		&& !_urlLocation
+		&& !_geoLocation
+		&& (_toCache == LoadToFileOnly)
+		&& (_size >= kResumableFromSize);
+	if (!_resumable) {
+		return FileLoader::openFile();
+	}
+	_file.setFileName(ResumePartPath(_filename));
+	const auto till = readResumeState();
+	const auto mode = till ? QIODevice::ReadWrite : QIODevice::WriteOnly;
+	if (!_file.open(mode)) {
+		return false;
+	} else if (till && _file.size() >= till && _file.resize(till)) {
+		DEBUG_LOG(("Download Info: Resuming %1 from offset %2."
+			).arg(_id
+			).arg(till));
+		_resumedTill = _nextRequestOffset = till;
+	} else if (_file.size() > 0 && !_file.resize(0)) {
+		_file.close();
+		return false;
+	}
+	_resumeSavedAt = crl::now();
+	return true;
+}
+
+int32 mtpFileLoader::readResumeState() const {
+	QFile info(ResumeStatePath(_filename));
+	if (!info.open(QIODevice::ReadOnly)) {
+		return 0;
+	}
+	QDataStream stream(&info);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto version = qint32();
+	auto id = quint64();
+	auto size = qint32();
+	auto till = qint32();
+	stream >> version >> id >> size >> till;
+	if (stream.status() != QDataStream::Ok
+		|| version != kResumeStateVersion
+		|| id != _id
+		|| size != _size
+		|| till <= 0) {
+		return 0;
+	}
+
+	// Leave at least one part to be loaded, it finishes the download.
+	till = std::min(till, _size - 1);
+	return till - (till % kDownloadCdnPartSize);
+}
+
+void mtpFileLoader::saveResumeState() {
+	_resumeSavedAt = crl::now();
+	if (!_fileIsOpen || !_file.flush()) {
+		return;
+	}
+	QFile info(ResumeStatePath(_filename));
+	if (!info.open(QIODevice::WriteOnly)) {
+		return;
+	}
+	QDataStream stream(&info);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream
+		<< qint32(kResumeStateVersion)
+		<< quint64(_id)
+		<< qint32(_size)
+		<< qint32(_resumedTill);
+}
+
+void mtpFileLoader::trackResumePart(int offset, int size) {
+	if (offset > _resumedTill) {
+		_resumeParts.emplace(offset, size);
+	} else {
+		_resumedTill = std::max(_resumedTill, offset + size);
+	}
+	auto i = _resumeParts.begin();
+	while (i != _resumeParts.end() && i->first <= _resumedTill) {
+		_resumedTill = std::max(_resumedTill, i->first + i->second);
+		i = _resumeParts.erase(i);
+	}
+	if (crl::now() - _resumeSavedAt >= kResumeSaveInterval) {
+		saveResumeState();
+	}
+}
+
+bool mtpFileLoader::finishResumableFile() {
+	QFile::remove(ResumeStatePath(_filename));
+	QFile::remove(_filename);
+	if (!_file.rename(_filename)) {
+		_file.remove();
+		return false;
+	}
+	return true;
+}
+
+void mtpFileLoader::removeResumeState() {
+	if (_resumable) {
+		QFile::remove(ResumeStatePath(_filename));
+	}
+}
+
 mtpFileLoader::~mtpFileLoader() {
+	if (_resumable && _fileIsOpen && !_finished) {
+		saveResumeState();
+	}
 	cancelRequests();
 }
 
@@ -1232,8 +1691,14 @@ webFileLoader::webFileLoader(
 	_queue = &_webQueue;
 }
 
+bool webFileLoader::canLoadPart() const {
+	return !_finished
+		&& !_requestSent
+		&& (_webLoadManager != FinishedWebLoadManager);
+}
+
 bool webFileLoader::loadPart() {
-	if (_finished || _requestSent || _webLoadManager == FinishedWebLoadManager) return false;
+	if (!canLoadPart()) return false;
 	if (!_webLoadManager) {
 		_webLoadMainManager = new WebLoadMainManager();
 
@@ -1320,6 +1785,7 @@ class webFileLoaderPrivate {
 public:
 	webFileLoaderPrivate(webFileLoader *loader, const QString &url)
 		: _interface(loader)
+		, _key(url)
 		, _url(url)
 		, _redirectsLeft(kMaxHttpRedirects) {
 	}
@@ -1334,6 +1800,9 @@ public:
 		QNetworkRequest req(_url);
 		QByteArray rangeHeaderValue = "bytes=" + QByteArray::number(_already) + "-";
 		req.setRawHeader("Range", rangeHeaderValue);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+		req.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif // Qt >= 5.8.0
 		_reply = manager.get(req);
 		return _reply;
 	}
@@ -1371,6 +1840,7 @@ private:
 	static constexpr auto kMaxHttpRedirects = 5;
 
 	webFileLoader *_interface = nullptr;
+	QString _key;
 	QUrl _url;
 	qint64 _already = 0;
 	qint64 _size = 0;
@@ -1378,6 +1848,13 @@ private:
 	int32 _redirectsLeft = kMaxHttpRedirects;
 	QByteArray _data;
 
+	// Loaders of the same url wait for the reply of the first one.
+	webFileLoaderPrivate *_leader = nullptr;
+	std::vector<webFileLoaderPrivate*> _followers;
+
+	// Host which request slot this loader holds, if any.
+	QString _host;
+
 	friend class WebLoadManager;
 };
 
@@ -1431,34 +1908,43 @@ bool WebLoadManager::carries(webFileLoader *loader) const {
 	return _loaderPointers.contains(loader);
 }
 
+bool WebLoadManager::alive(webFileLoaderPrivate *loader) const {
+	const auto it = _loaderPointers.constFind(loader->_interface);
+
+	// It could be a new loader which was realloced in the same address.
+	return (it != _loaderPointers.cend()) && (it.key()->_private == loader);
+}
+
 bool WebLoadManager::handleReplyResult(webFileLoaderPrivate *loader, WebReplyProcessResult result) {
 	QMutexLocker lock(&_loaderPointersMutex);
-	LoaderPointers::iterator it = _loaderPointers.find(loader->_interface);
-	if (it != _loaderPointers.cend() && it.key()->_private != loader) {
-		it = _loaderPointers.end(); // it is a new loader which was realloced in the same address
-	}
-	if (it == _loaderPointers.cend()) {
-		return false;
-	}
-
 	if (result == WebReplyProcessProgress) {
 		if (loader->size() > Storage::kMaxFileInMemory) {
 			LOG(("API Error: too large file is loaded to cache: %1").arg(loader->size()));
 			result = WebReplyProcessError;
 		}
 	}
-	if (result == WebReplyProcessError) {
-		if (it != _loaderPointers.cend()) {
-			emit error(it.key());
+	const auto done = (result == WebReplyProcessError)
+		|| (loader->already() >= loader->size() && loader->size() > 0);
+	auto someAlive = false;
+	const auto notify = [&](webFileLoaderPrivate *target) {
+		if (!alive(target)) {
+			return;
 		}
-		return false;
-	}
-	if (loader->already() < loader->size() || !loader->size()) {
-		emit progress(it.key(), loader->already(), loader->size());
-		return true;
+		someAlive = true;
+		const auto interface = target->_interface;
+		if (result == WebReplyProcessError) {
+			emit error(interface);
+		} else if (!done) {
+			emit progress(interface, loader->already(), loader->size());
+		} else {
+			emit finished(interface, loader->data());
+		}
+	};
+	notify(loader);
+	for (const auto follower : loader->_followers) {
+		notify(follower);
 	}
-	emit finished(it.key(), loader->data());
-	return false;
+	return someAlive && !done;
 }
 
 void WebLoadManager::onFailed(QNetworkReply::NetworkError error) {
@@ -1479,8 +1965,7 @@ void WebLoadManager::onFailed(QNetworkReply *reply) {
 	LOG(("Network Error: Failed to request '%1', error %2 (%3)").arg(QString::fromLatin1(loader->_url.toEncoded())).arg(int(reply->error())).arg(reply->errorString()));
 
 	if (!handleReplyResult(loader, WebReplyProcessError)) {
-		_loaders.remove(loader);
-		delete loader;
+		removeLoader(loader);
 	}
 }
 
@@ -1525,12 +2010,7 @@ void WebLoadManager::onProgress(qint64 already, qint64 size) {
 		}
 	}
 	if (!handleReplyResult(loader, result)) {
-		_replies.erase(j);
-		_loaders.remove(loader);
-		delete loader;
-
-		reply->abort();
-		reply->deleteLater();
+		removeLoader(loader);
 	}
 }
 
@@ -1551,12 +2031,8 @@ void WebLoadManager::onMeta() {
 			if (m.hasMatch()) {
 				loader->setProgress(qMax(qint64(loader->data().size()), loader->already()), m.captured(1).toLongLong());
 				if (!handleReplyResult(loader, WebReplyProcessProgress)) {
-					_replies.erase(j);
-					_loaders.remove(loader);
-					delete loader;
-
-					reply->abort();
-					reply->deleteLater();
+					removeLoader(loader);
+					return;
 				}
 			}
 		}
@@ -1565,6 +2041,7 @@ void WebLoadManager::onMeta() {
 
 void WebLoadManager::process() {
 	Loaders newLoaders;
+	auto dead = std::vector<webFileLoaderPrivate*>();
 	{
 		QMutexLocker lock(&_loaderPointersMutex);
 		for (LoaderPointers::iterator i = _loaderPointers.begin(), e = _loaderPointers.end(); i != e; ++i) {
@@ -1577,31 +2054,140 @@ void WebLoadManager::process() {
 				i.value() = 0;
 			}
 		}
-		for (auto i = _loaders.begin(), e = _loaders.end(); i != e;) {
-			LoaderPointers::iterator it = _loaderPointers.find((*i)->_interface);
-			if (it != _loaderPointers.cend() && it.key()->_private != (*i)) {
-				it = _loaderPointers.end();
-			}
-			if (it == _loaderPointers.cend()) {
-				if (QNetworkReply *reply = (*i)->reply()) {
-					_replies.remove(reply);
-					reply->abort();
-					reply->deleteLater();
-				}
-				delete (*i);
-				i = _loaders.erase(i);
-			} else {
-				++i;
+		for (const auto loader : _loaders) {
+			if (!alive(loader)) {
+				dead.push_back(loader);
 			}
 		}
 	}
+	for (const auto loader : dead) {
+		cancelLoader(loader);
+	}
 	for_const (webFileLoaderPrivate *loader, newLoaders) {
 		if (_loaders.contains(loader)) {
-			sendRequest(loader);
+			startLoader(loader);
+		}
+	}
+	sendWaiting();
+}
+
+void WebLoadManager::startLoader(webFileLoaderPrivate *loader) {
+	const auto i = _leaders.constFind(loader->_key);
+	if (i != _leaders.cend()) {
+		// The same url is already requested, use that reply.
+		const auto leader = i.value();
+		loader->_leader = leader;
+		leader->_followers.push_back(loader);
+		return;
+	}
+	_leaders.insert(loader->_key, loader);
+	_waiting.push_back(loader);
+}
+
+void WebLoadManager::sendWaiting() {
+	for (auto i = _waiting.begin(); i != _waiting.end();) {
+		if (_requestsCount >= kMaxWebRequests) {
+			return;
 		}
+		const auto loader = *i;
+		const auto host = loader->_url.host();
+		auto &hostRequests = _hostRequests[host];
+		if (hostRequests >= kMaxWebRequestsPerHost) {
+			++i;
+			continue;
+		}
+		++hostRequests;
+		++_requestsCount;
+		loader->_host = host;
+		i = _waiting.erase(i);
+		sendRequest(loader);
 	}
 }
 
+void WebLoadManager::releaseRequestSlot(webFileLoaderPrivate *loader) {
+	if (loader->_host.isNull()) {
+		return;
+	}
+	const auto i = _hostRequests.find(base::take(loader->_host));
+	if (i != _hostRequests.end() && !--i.value()) {
+		_hostRequests.erase(i);
+	}
+	--_requestsCount;
+}
+
+void WebLoadManager::abortReply(webFileLoaderPrivate *loader) {
+	if (const auto reply = base::take(loader->_reply)) {
+		_replies.remove(reply);
+		reply->abort();
+		reply->deleteLater();
+	}
+}
+
+void WebLoadManager::cancelLoader(webFileLoaderPrivate *loader) {
+	if (const auto leader = loader->_leader) {
+		auto &followers = leader->_followers;
+		followers.erase(
+			ranges::remove(followers, loader),
+			end(followers));
+		_loaders.remove(loader);
+		delete loader;
+		return;
+	} else if (loader->_followers.empty()) {
+		removeLoader(loader);
+		return;
+	}
+
+	// Some loaders still wait for this url, give them the reply.
+	const auto next = loader->_followers.front();
+	next->_followers = std::vector<webFileLoaderPrivate*>(
+		loader->_followers.begin() + 1,
+		loader->_followers.end());
+	for (const auto follower : next->_followers) {
+		follower->_leader = next;
+	}
+	next->_leader = nullptr;
+	next->_url = loader->_url;
+	next->_already = loader->_already;
+	next->_size = loader->_size;
+	next->_data = base::take(loader->_data);
+	next->_redirectsLeft = loader->_redirectsLeft;
+	next->_host = base::take(loader->_host);
+	if ((next->_reply = base::take(loader->_reply))) {
+		_replies[next->_reply] = next;
+	}
+	_leaders[next->_key] = next;
+	for (auto &waiting : _waiting) {
+		if (waiting == loader) {
+			waiting = next;
+		}
+	}
+	loader->_followers.clear();
+	_loaders.remove(loader);
+	delete loader;
+}
+
+void WebLoadManager::removeLoader(webFileLoaderPrivate *loader) {
+	Expects(!loader->_leader);
+
+	for (const auto follower : base::take(loader->_followers)) {
+		_loaders.remove(follower);
+		delete follower;
+	}
+	abortReply(loader);
+	releaseRequestSlot(loader);
+	const auto i = _leaders.find(loader->_key);
+	if (i != _leaders.end() && i.value() == loader) {
+		_leaders.erase(i);
+	}
+	_waiting.erase(
+		ranges::remove(_waiting, loader),
+		end(_waiting));
+	_loaders.remove(loader);
+	delete loader;
+
+	emit processDelayed();
+}
+
 void WebLoadManager::sendRequest(webFileLoaderPrivate *loader, const QString &redirect) {
 	Replies::iterator j = _replies.find(loader->reply());
 	if (j != _replies.cend()) {
@@ -1639,6 +2225,10 @@ void WebLoadManager::clear() {
 		delete loader;
 	}
 	_loaders.clear();
+	_leaders.clear();
+	_waiting.clear();
+	_hostRequests.clear();
+	_requestsCount = 0;
 
 	for (Replies::iterator i = _replies.begin(), e = _replies.end(); i != e; ++i) {
 		delete i.key();
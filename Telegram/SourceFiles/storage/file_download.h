@@ -11,6 +11,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "base/binary_guard.h"
 #include "data/data_file_origin.h"
 
+#include <deque>
+
 namespace Storage {
 namespace Cache {
 struct Key;
@@ -23,6 +25,23 @@ constexpr auto kMaxWallPaperInMemory = kMaxFileInMemory;
 constexpr auto kMaxAnimationInMemory = kMaxFileInMemory; // 10 MB gif and mp4 animations held in memory while playing
 constexpr auto kMaxWallPaperDimension = 4096; // 4096x4096 is max area.
 
+// Downloads of a dc compete for its requests in these classes, the more
+// urgent ones go first and the less urgent ones are limited to a share.
+enum class DownloadClass {
+	Visible, // Images painted right now.
+	Stream, // Audio and video the user opened.
+	Prefetch, // Automatic downloads and images out of the viewport.
+	Background, // Other documents.
+};
+constexpr auto kDownloadClassCount = 4;
+
+// Parts of documents loaded by any loader, valid only while fired.
+struct DocumentPartLoaded {
+	uint64 documentId = 0;
+	int offset = 0;
+	bytes::const_span bytes;
+};
+
 class Downloader final {
 public:
 	Downloader();
@@ -39,18 +58,58 @@ public:
 	void requestedAmountIncrement(MTP::DcId dcId, int index, int amount);
 	int chooseDcIndexForRequest(MTP::DcId dcId) const;
 
+	// The in-flight window of each dc adapts to the measured round trip
+	// time and throughput, the part size and requests count follow it.
+	void partLoaded(MTP::DcId dcId, int size, crl::time sentAt);
+	int partSize(MTP::DcId dcId) const;
+	int requestsLimit(MTP::DcId dcId) const;
+	int64 inFlightLimit(MTP::DcId dcId) const;
+
+	// Lets a streaming loader use the parts of a full download.
+	void documentPartLoaded(
+		uint64 documentId,
+		int offset,
+		bytes::const_span bytes);
+	rpl::producer<DocumentPartLoaded> documentPartsLoaded() const;
+
+	struct DcStats {
+		crl::time rtt = 0;
+		int64 bytesPerSecond = 0;
+		int64 inFlightLimit = 0;
+		int partSize = 0;
+		int requestsLimit = 0;
+	};
+	base::flat_map<MTP::DcId, DcStats> stats() const;
+
 	~Downloader();
 
 private:
+	struct DcLoad {
+		int64 inFlightLimit = 0;
+		crl::time rtt = 0;
+		crl::time minRtt = 0;
+		crl::time windowStart = 0;
+		crl::time windowMinRtt = 0;
+		int64 windowBytes = 0;
+		bool windowSaturated = false;
+		int64 bytesPerSecond = 0;
+	};
+
 	void killDownloadSessionsStart(MTP::DcId dcId);
 	void killDownloadSessionsStop(MTP::DcId dcId);
 	void killDownloadSessions();
 
+	DcLoad &dcLoad(MTP::DcId dcId);
+	const DcLoad *findDcLoad(MTP::DcId dcId) const;
+	void updateDcLoad(MTP::DcId dcId, DcLoad &load, crl::time now);
+
 	base::Observable<void> _taskFinishedObservable;
+	rpl::event_stream<DocumentPartLoaded> _documentPartsLoaded;
 	int _priority = 1;
 
 	using RequestedInDc = std::array<int64, MTP::kDownloadSessionsCount>;
 	std::map<MTP::DcId, RequestedInDc> _requestedBytesAmount;
+	base::flat_map<MTP::DcId, DcLoad> _dcLoads;
 
 	base::flat_map<MTP::DcId, crl::time> _killDownloadSessionTimes;
 	base::Timer _killDownloadSessionsTimer;
@@ -130,6 +189,9 @@ public:
 	bool autoLoading() const {
 		return _autoLoading;
 	}
+	Storage::DownloadClass downloadClass() const {
+		return _downloadClass;
+	}
 
 	virtual void stop() {
 	}
@@ -159,13 +221,21 @@ protected:
 	virtual std::optional<Storage::Cache::Key> cacheKey() const = 0;
 	virtual void cancelRequests() = 0;
 
+	// Resumable loaders write to a partial file and keep their progress.
+	virtual bool openFile();
+	virtual void removeResumeState() {
+	}
+
 	void startLoading(bool loadFirst, bool prior);
 	void removeFromQueue();
 	void cancel(bool failed);
 
 	void notifyAboutProgress();
 	static void LoadNextFromQueue(not_null<FileLoaderQueue*> queue);
+	virtual bool canLoadPart() const = 0;
 	virtual bool loadPart() = 0;
+	Storage::DownloadClass computeDownloadClass(bool prior) const;
+	bool stalePrefetch() const;
 
 	not_null<Storage::Downloader*> _downloader;
 	FileLoader *_prev = nullptr;
@@ -175,6 +245,7 @@ protected:
 
 	bool _paused = false;
 	bool _autoLoading = false;
+	Storage::DownloadClass _downloadClass = Storage::DownloadClass::Background;
 	uint8 _cacheTag = 0;
 	bool _inQueue = false;
 	bool _finished = false;
@@ -258,6 +329,9 @@ private:
 		MTP::DcId dcId = 0;
 		int dcIndex = 0;
 		int offset = 0;
+		int limit = 0;
+		crl::time sent = 0;
+		Storage::DownloadClass downloadClass = Storage::DownloadClass();
 	};
 	struct CdnFileHash {
 		CdnFileHash(int limit, QByteArray hash) : limit(limit), hash(hash) {
@@ -265,20 +339,35 @@ private:
 		int limit = 0;
 		QByteArray hash;
 	};
+	struct CdnPart {
+		QByteArray bytes;
+		bytes::vector hash;
+	};
 	std::optional<Storage::Cache::Key> cacheKey() const override;
 	void cancelRequests() override;
+	bool openFile() override;
+	void removeResumeState() override;
+
+	int32 readResumeState() const;
+	void saveResumeState();
+	void trackResumePart(int offset, int size);
+	bool finishResumableFile();
 
 	int partSize() const;
-	RequestData prepareRequest(int offset) const;
-	void makeRequest(int offset);
+	RequestData prepareRequest(int offset, int limit) const;
+	void makeRequest(int offset, int limit);
+	void sendRequest(int offset, int limit);
 
 	MTPInputFileLocation computeLocation() const;
+	bool canLoadPart() const override;
 	bool loadPart() override;
 	void normalPartLoaded(const MTPupload_File &result, mtpRequestId requestId);
 	void webPartLoaded(const MTPupload_WebFile &result, mtpRequestId requestId);
 	void cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId requestId);
 	void reuploadDone(const MTPVector<MTPFileHash> &result, mtpRequestId requestId);
+	void cdnPartDecrypted(int offset, CdnPart &&part);
 	void requestMoreCdnFileHashes();
+	void requestCdnFileHashes(int offset);
 	void getCdnFileHashesDone(const MTPVector<MTPFileHash> &result, mtpRequestId requestId);
 
 	bool feedPart(int offset, bytes::const_span buffer);
@@ -288,17 +377,18 @@ private:
 	bool cdnPartFailed(const RPCError &error, mtpRequestId requestId);
 
 	void placeSentRequest(mtpRequestId requestId, const RequestData &requestData);
-	int finishSentRequestGetOffset(mtpRequestId requestId);
-	void switchToCDN(int offset, const MTPDupload_fileCdnRedirect &redirect);
+	RequestData finishSentRequest(mtpRequestId requestId);
+	void switchToCDN(const RequestData &request, const MTPDupload_fileCdnRedirect &redirect);
 	void addCdnHashes(const QVector<MTPFileHash> &hashes);
-	void changeCDNParams(int offset, MTP::DcId dcId, const QByteArray &token, const QByteArray &encryptionKey, const QByteArray &encryptionIV, const QVector<MTPFileHash> &hashes);
+	void changeCDNParams(const RequestData &request, MTP::DcId dcId, const QByteArray &token, const QByteArray &encryptionKey, const QByteArray &encryptionIV, const QVector<MTPFileHash> &hashes);
 
 	enum class CheckCdnHashResult {
 		NoHash,
 		Invalid,
 		Good,
 	};
-	CheckCdnHashResult checkCdnFileHash(int offset, bytes::const_span buffer);
+	CheckCdnHashResult checkCdnFileHash(int offset, const CdnPart &part) const;
+	bool feedCheckedCdnParts();
 
 	std::map<mtpRequestId, RequestData> _sentRequests;
 
@@ -323,8 +413,16 @@ private:
 	QByteArray _cdnEncryptionKey;
 	QByteArray _cdnEncryptionIV;
 	std::map<int, CdnFileHash> _cdnFileHashes;
-	std::map<int, QByteArray> _cdnUncheckedParts;
+	std::map<int, CdnPart> _cdnUncheckedParts;
 	mtpRequestId _cdnHashesRequestId = 0;
+	int _cdnPartsDecrypting = 0;
+
+	// Large documents are loaded to a partial file, the parts till
+	// _resumedTill are saved in it and are not requested after restart.
+	bool _resumable = false;
+	int32 _resumedTill = 0;
+	base::flat_map<int, int> _resumeParts;
+	crl::time _resumeSavedAt = 0;
 
 };
 
@@ -354,6 +452,7 @@ public:
 protected:
 	void cancelRequests() override;
 	std::optional<Storage::Cache::Key> cacheKey() const override;
+	bool canLoadPart() const override;
 	bool loadPart() override;
 
 	QString _url;
@@ -401,9 +500,21 @@ public slots:
 	void finish();
 
 private:
+	// Requests of all hosts and for one host at the same time.
+	static constexpr auto kMaxWebRequests = 16;
+	static constexpr auto kMaxWebRequestsPerHost = 4;
+
 	void clear();
 	void sendRequest(webFileLoaderPrivate *loader, const QString &redirect = QString());
 	bool handleReplyResult(webFileLoaderPrivate *loader, WebReplyProcessResult result);
+	bool alive(webFileLoaderPrivate *loader) const;
+
+	void startLoader(webFileLoaderPrivate *loader);
+	void sendWaiting();
+	void releaseRequestSlot(webFileLoaderPrivate *loader);
+	void abortReply(webFileLoaderPrivate *loader);
+	void cancelLoader(webFileLoaderPrivate *loader);
+	void removeLoader(webFileLoaderPrivate *loader);
 
 	QNetworkAccessManager _manager;
 	typedef QMap<webFileLoader*, webFileLoaderPrivate*> LoaderPointers;
@@ -416,6 +527,11 @@ private:
 	typedef QMap<QNetworkReply*, webFileLoaderPrivate*> Replies;
 	Replies _replies;
 
+	QMap<QString, webFileLoaderPrivate*> _leaders;
+	std::deque<webFileLoaderPrivate*> _waiting;
+	QMap<QString, int> _hostRequests;
+	int _requestsCount = 0;
+
 };
 
 class WebLoadMainManager : public QObject {
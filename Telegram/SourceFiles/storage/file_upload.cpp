@@ -14,11 +14,22 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "data/data_session.h"
 #include "auth_session.h"
 
+#include <QtCore/QMutex>
+
 namespace Storage {
 namespace {
 
-// max 512kb uploaded at the same time in each session
-constexpr auto kMaxUploadFileParallelSize = MTP::kUploadSessionsCount * 512 * 1024;
+// Bytes uploaded at the same time in all sessions, the window starts
+// with 512kb in each session and adapts to the acknowledgements.
+constexpr auto kStartUploadInFlight = int64(MTP::kUploadSessionsCount * 512 * 1024);
+constexpr auto kMinUploadInFlight = int64(256 * 1024);
+constexpr auto kMaxUploadInFlight = int64(MTP::kUploadSessionsCount * 4 * 1024 * 1024);
+constexpr auto kUploadMeasureInterval = crl::time(1000);
+constexpr auto kUploadIdleTimeout = 5 * kUploadMeasureInterval;
+constexpr auto kUploadQueueingRttFactor = 2;
+
+// Parts of a file on disk are read this much ahead of the window.
+constexpr auto kUploadReadAheadParts = 4;
 
 constexpr auto kDocumentMaxPartsCount = 3000;
 
@@ -37,12 +48,128 @@ constexpr auto kDocumentUploadPartSize3 = 256 * 1024;
 // 512kb for large document ( <= 1500mb )
 constexpr auto kDocumentUploadPartSize4 = 512 * 1024;
 
-// One part each half second, if not uploaded faster.
+// Check the queue each half second, if not uploaded faster.
 constexpr auto kUploadRequestInterval = crl::time(500);
 
 // How much time without upload causes additional session kill.
 constexpr auto kKillSessionTimeout = crl::time(5000);
 
+// Reads the parts of a file on disk in the background ahead of sending
+// and feeds them to the md5 hash in order, off the main thread.
+class PartsReader final {
+public:
+	PartsReader(
+		const QString &path,
+		int partSize,
+		int partsCount,
+		bool hash,
+		Fn<void()> ready);
+
+	void readAhead(int till);
+	[[nodiscard]] std::optional<QByteArray> take(int index);
+	[[nodiscard]] bool failed() const;
+
+	// Valid after all the parts were taken.
+	[[nodiscard]] QByteArray md5Hex() const;
+
+private:
+	struct Shared {
+		QMutex mutex;
+		QFile file;
+		std::map<int, QByteArray> parts;
+		HashMd5 md5;
+		int hashed = 0;
+		bool failed = false;
+	};
+
+	const std::shared_ptr<Shared> _shared;
+	const int _partSize = 0;
+	const int _partsCount = 0;
+	const bool _hash = false;
+	const Fn<void()> _ready;
+	int _requested = 0;
+
+};
+
+PartsReader::PartsReader(
+	const QString &path,
+	int partSize,
+	int partsCount,
+	bool hash,
+	Fn<void()> ready)
+: _shared(std::make_shared<Shared>())
+, _partSize(partSize)
+, _partsCount(partsCount)
+, _hash(hash)
+, _ready(std::move(ready)) {
+	_shared->file.setFileName(path);
+	if (!_shared->file.open(QIODevice::ReadOnly)) {
+		_shared->failed = true;
+	}
+}
+
+void PartsReader::readAhead(int till) {
+	till = std::min(till, _partsCount);
+	for (; _requested < till; ++_requested) {
+		crl::async([
+			shared = _shared,
+			index = _requested,
+			partSize = _partSize,
+			hash = _hash,
+			ready = _ready
+		] {
+			QMutexLocker lock(&shared->mutex);
+			if (shared->failed) {
+				return;
+			}
+			auto &file = shared->file;
+			auto bytes = file.seek(int64(index) * partSize)
+				? file.read(partSize)
+				: QByteArray();
+			if (bytes.isEmpty()) {
+				shared->failed = true;
+			} else {
+				shared->parts.emplace(index, std::move(bytes));
+				if (hash) {
+					// Parts may be read out of order, hash them in order.
+					auto i = shared->parts.find(shared->hashed);
+					while (i != end(shared->parts)
+						&& i->first == shared->hashed) {
+						shared->md5.feed(i->second.constData(), i->second.size());
+						++shared->hashed;
+						++i;
+					}
+				}
+			}
+			lock.unlock();
+			ready();
+		});
+	}
+}
+
+std::optional<QByteArray> PartsReader::take(int index) {
+	QMutexLocker lock(&_shared->mutex);
+	const auto i = _shared->parts.find(index);
+	if (i == end(_shared->parts) || (_hash && index >= _shared->hashed)) {
+		return std::nullopt;
+	}
+	auto result = std::move(i->second);
+	_shared->parts.erase(i);
+	return result;
+}
+
+bool PartsReader::failed() const {
+	QMutexLocker lock(&_shared->mutex);
+	return _shared->failed;
+}
+
+QByteArray PartsReader::md5Hex() const {
+	QMutexLocker lock(&_shared->mutex);
+	auto result = QByteArray(32, Qt::Uninitialized);
+	hashMd5Hex(_shared->md5.result(), result.data());
+	return result;
+}
+
 } // namespace
 
 struct Uploader::File {
@@ -64,7 +191,7 @@ struct Uploader::File {
 
 	HashMd5 md5Hash;
 
-	std::unique_ptr<QFile> docFile;
+	std::unique_ptr<PartsReader> docReader;
 	int32 docSentParts = 0;
 	int32 docSize = 0;
 	int32 docPartSize = 0;
@@ -140,6 +267,7 @@ const QString &Uploader::File::filename() const {
 }
 
 Uploader::Uploader() {
+	_window.limit = kStartUploadInFlight;
 	nextTimer.setSingleShot(true);
 	connect(&nextTimer, SIGNAL(timeout()), this, SLOT(sendNext()));
 	stopSessionsTimer.setSingleShot(true);
@@ -249,6 +377,7 @@ void Uploader::currentFailed() {
 	requestsSent.clear();
 	docRequestsSent.clear();
 	dcMap.clear();
+	_sentTimes.clear();
 	uploadingId = FullMsgId();
 	sentSize = 0;
 	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
@@ -265,7 +394,17 @@ void Uploader::stopSessions() {
 }
 
 void Uploader::sendNext() {
-	if (sentSize >= kMaxUploadFileParallelSize || _pausedId.msg) return;
+	while (sendPart()) {
+	}
+}
+
+bool Uploader::sendPart() {
+	if (_pausedId.msg) {
+		return false;
+	} else if (int64(sentSize) >= _window.limit) {
+		_window.saturated = true;
+		return false;
+	}
 
 	bool stopping = stopSessionsTimer.isActive();
 	if (queue.empty()) {
@@ -273,7 +412,7 @@ void Uploader::sendNext() {
 			stopSessionsTimer.start(
 				MTP::kAckSendWaiting + kKillSessionTimeout);
 		}
-		return;
+		return false;
 	}
 
 	if (stopping) {
@@ -333,7 +472,11 @@ void Uploader::sendNext() {
 					|| uploadingData.type() == SendMediaType::WallPaper
 					|| uploadingData.type() == SendMediaType::Audio) {
 					QByteArray docMd5(32, Qt::Uninitialized);
-					hashMd5Hex(uploadingData.md5Hash.result(), docMd5.data());
+					if (uploadingData.docReader) {
+						docMd5 = uploadingData.docReader->md5Hex();
+					} else {
+						hashMd5Hex(uploadingData.md5Hash.result(), docMd5.data());
+					}
 
 					const auto file = (uploadingData.docSize > kUseBigFilesFrom)
 						? MTP_inputFileBig(
@@ -373,9 +516,9 @@ void Uploader::sendNext() {
 				}
 				queue.erase(uploadingId);
 				uploadingId = FullMsgId();
-				sendNext();
+				return true;
 			}
-			return;
+			return false;
 		}
 
 		auto &content = uploadingData.file
@@ -383,20 +526,32 @@ void Uploader::sendNext() {
 			: uploadingData.media.data;
 		QByteArray toSend;
 		if (content.isEmpty()) {
-			if (!uploadingData.docFile) {
+			if (!uploadingData.docReader) {
 				const auto filepath = uploadingData.file
 					? uploadingData.file->filepath
 					: uploadingData.media.file;
-				uploadingData.docFile = std::make_unique<QFile>(filepath);
-				if (!uploadingData.docFile->open(QIODevice::ReadOnly)) {
-					currentFailed();
-					return;
-				}
+				uploadingData.docReader = std::make_unique<PartsReader>(
+					filepath,
+					uploadingData.docPartSize,
+					uploadingData.docPartsCount,
+					(uploadingData.docSize <= kUseBigFilesFrom),
+					[=] { crl::on_main(this, [=] { sendNext(); }); });
 			}
-			toSend = uploadingData.docFile->read(uploadingData.docPartSize);
-			if (uploadingData.docSize <= kUseBigFilesFrom) {
-				uploadingData.md5Hash.feed(toSend.constData(), toSend.size());
+			const auto reader = uploadingData.docReader.get();
+			const auto window = int(_window.limit / uploadingData.docPartSize);
+			reader->readAhead(uploadingData.docSentParts
+				+ window
+				+ kUploadReadAheadParts);
+			if (reader->failed()) {
+				currentFailed();
+				return false;
 			}
+			auto part = reader->take(uploadingData.docSentParts);
+			if (!part) {
+				// Will be called again when the part is read.
+				return false;
+			}
+			toSend = std::move(*part);
 		} else {
 			const auto offset = uploadingData.docSentParts
 				* uploadingData.docPartSize;
@@ -412,7 +567,7 @@ void Uploader::sendNext() {
 			|| ((toSend.size() < uploadingData.docPartSize
 				&& uploadingData.docSentParts + 1 != uploadingData.docPartsCount))) {
 			currentFailed();
-			return;
+			return false;
 		}
 		mtpRequestId requestId;
 		if (uploadingData.docSize > kUseBigFilesFrom) {
@@ -437,6 +592,7 @@ void Uploader::sendNext() {
 		}
 		docRequestsSent.emplace(requestId, uploadingData.docSentParts);
 		dcMap.emplace(requestId, todc);
+		_sentTimes.emplace(requestId, crl::now());
 		sentSize += uploadingData.docPartSize;
 		sentSizes[todc] += uploadingData.docPartSize;
 
@@ -454,12 +610,53 @@ void Uploader::sendNext() {
 			MTP::uploadDcId(todc));
 		requestsSent.emplace(requestId, part.value());
 		dcMap.emplace(requestId, todc);
+		_sentTimes.emplace(requestId, crl::now());
 		sentSize += part.value().size();
 		sentSizes[todc] += part.value().size();
 
 		parts.erase(part);
 	}
 	nextTimer.start(kUploadRequestInterval);
+	return true;
+}
+
+void Uploader::partAcknowledged(int size, crl::time sentAt) {
+	const auto now = crl::now();
+	const auto rtt = std::max(now - sentAt, crl::time(1));
+	auto &window = _window;
+	window.rtt = window.rtt ? ((window.rtt * 7 + rtt) / 8) : rtt;
+	window.periodMinRtt = window.periodMinRtt
+		? std::min(window.periodMinRtt, rtt)
+		: rtt;
+	if (!window.periodStart || now - window.periodStart > kUploadIdleTimeout) {
+		window.periodStart = sentAt;
+		window.periodBytes = 0;
+	}
+	window.periodBytes += size;
+	if (now - window.periodStart < kUploadMeasureInterval) {
+		return;
+	}
+
+	const auto speed = window.periodBytes * 1000 / (now - window.periodStart);
+	window.minRtt = window.minRtt
+		? std::min(window.periodMinRtt, window.minRtt + window.minRtt / 8)
+		: window.periodMinRtt;
+	const auto needed = speed * window.minRtt / 1000;
+	if (window.rtt > kUploadQueueingRttFactor * window.minRtt) {
+		// The parts wait in some queue on the way, send less of them.
+		window.limit = std::min(window.limit, std::max({
+			window.limit * 3 / 4,
+			needed,
+			kMinUploadInFlight }));
+	} else if (window.saturated && speed * 10 >= window.bytesPerSecond * 11) {
+		// The window was full and the acknowledgements still come faster.
+		window.limit = std::min(window.limit * 5 / 4, kMaxUploadInFlight);
+	}
+	window.bytesPerSecond = speed;
+	window.periodStart = now;
+	window.periodBytes = 0;
+	window.periodMinRtt = 0;
+	window.saturated = false;
 }
 
 void Uploader::cancel(const FullMsgId &msgId) {
@@ -495,6 +692,7 @@ void Uploader::clear() {
 	}
 	docRequestsSent.clear();
 	dcMap.clear();
+	_sentTimes.clear();
 	sentSize = 0;
 	for (int i = 0; i < MTP::kUploadSessionsCount; ++i) {
 		MTP::stopSession(MTP::uploadDcId(i));
@@ -535,6 +733,9 @@ void Uploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
 			}
 			sentSize -= sentPartSize;
 			sentSizes[dc] -= sentPartSize;
+			if (const auto sent = _sentTimes.take(requestId)) {
+				partAcknowledged(sentPartSize, *sent);
+			}
 			if (file.type() == SendMediaType::Photo) {
 				file.fileSentSize += sentPartSize;
 				const auto photo = Auth().data().photo(file.id());
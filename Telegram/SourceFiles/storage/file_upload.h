@@ -105,14 +105,30 @@ public slots:
 private:
 	struct File;
 
+	// Bytes allowed in flight, adapted to the acknowledgements.
+	struct InFlightWindow {
+		int64 limit = 0;
+		int64 bytesPerSecond = 0;
+		crl::time rtt = 0;
+		crl::time minRtt = 0;
+		crl::time periodStart = 0;
+		crl::time periodMinRtt = 0;
+		int64 periodBytes = 0;
+		bool saturated = false;
+	};
+
+	bool sendPart();
 	void partLoaded(const MTPBool &result, mtpRequestId requestId);
 	bool partFailed(const RPCError &err, mtpRequestId requestId);
+	void partAcknowledged(int size, crl::time sentAt);
 
 	void currentFailed();
 
 	base::flat_map<mtpRequestId, QByteArray> requestsSent;
 	base::flat_map<mtpRequestId, int32> docRequestsSent;
 	base::flat_map<mtpRequestId, int32> dcMap;
+	base::flat_map<mtpRequestId, crl::time> _sentTimes;
+	InFlightWindow _window;
 	uint32 sentSize = 0;
 	uint32 sentSizes[MTP::kUploadSessionsCount] = { 0 };
 
@@ -20,11 +20,14 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "mainwidget.h"
 #include "mainwindow.h"
 
+#include <openssl/sha.h>
+
 namespace {
 
 constexpr auto kThumbnailQuality = 87;
 constexpr auto kThumbnailSize = 320;
 constexpr auto kPhotoUploadPartSize = 32 * 1024;
+constexpr auto kContentHashPartSize = 1024 * 1024;
 
 using Storage::ValidateThumbDimensions;
 
@@ -36,6 +39,40 @@ struct PreparedFileThumbnail {
 	MTPPhotoSize mtpSize = MTP_photoSizeEmpty(MTP_string(""));
 };
 
+// SHA-256 of the file bytes followed by their size,
+// empty if the file could not be read.
+QByteArray ComputeContentHash(
+		const QString &filepath,
+		const QByteArray &content) {
+	auto context = SHA256_CTX();
+	SHA256_Init(&context);
+	auto size = quint64(0);
+	if (!content.isEmpty()) {
+		SHA256_Update(&context, content.constData(), content.size());
+		size = content.size();
+	} else {
+		auto file = QFile(filepath);
+		if (!file.open(QIODevice::ReadOnly)) {
+			return QByteArray();
+		}
+		auto buffer = QByteArray(kContentHashPartSize, Qt::Uninitialized);
+		while (true) {
+			const auto read = file.read(buffer.data(), buffer.size());
+			if (read < 0) {
+				return QByteArray();
+			} else if (!read) {
+				break;
+			}
+			SHA256_Update(&context, buffer.constData(), read);
+			size += read;
+		}
+	}
+	auto result = QByteArray(SHA256_DIGEST_LENGTH, Qt::Uninitialized);
+	SHA256_Final(reinterpret_cast<uchar*>(result.data()), &context);
+	result.append(reinterpret_cast<const char*>(&size), sizeof(size));
+	return result;
+}
+
 PreparedFileThumbnail PrepareFileThumbnail(QImage &&original) {
 	const auto width = original.width();
 	const auto height = original.height();
@@ -298,7 +335,8 @@ SendMediaReady PrepareWallPaper(const QImage &image) {
 		0);
 }
 
-TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
+TaskQueue::TaskQueue(crl::time stopTimeoutMs, int threads)
+: _threadsCount(std::max(threads, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -307,40 +345,46 @@ TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
 	}
 }
 
-TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
-	const auto result = task->id();
+void TaskQueue::pushTask(std::unique_ptr<Task> &&task) {
 	{
-		QMutexLocker lock(&_tasksToProcessMutex);
-		_tasksToProcess.push_back(std::move(task));
+		QMutexLocker lock(&_tasksToFinishMutex);
+		_tasksOrder.push_back(task->id());
 	}
+	QMutexLocker lock(&_tasksToProcessMutex);
+	_tasksToProcess.push_back(std::move(task));
+}
+
+TaskId TaskQueue::addTask(std::unique_ptr<Task> &&task) {
+	const auto result = task->id();
+	pushTask(std::move(task));
 
-	wakeThread();
+	wakeThreads();
 
 	return result;
 }
 
 void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
-	{
-		QMutexLocker lock(&_tasksToProcessMutex);
-		for (auto &task : tasks) {
-			_tasksToProcess.push_back(std::move(task));
-		}
+	for (auto &task : tasks) {
+		pushTask(std::move(task));
 	}
 
-	wakeThread();
+	wakeThreads();
 }
 
-void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+void TaskQueue::wakeThreads() {
+	if (_threads.empty()) {
+		for (auto i = 0; i != _threadsCount; ++i) {
+			const auto thread = new QThread();
+			const auto worker = new TaskQueueWorker(this);
+			worker->moveToThread(thread);
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			connect(this, SIGNAL(taskAdded()), worker, SLOT(onTaskAdded()));
+			connect(worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
-
-		_thread->start();
+			thread->start();
+			_threads.push_back(thread);
+			_workers.push_back(worker);
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	emit taskAdded();
@@ -359,12 +403,28 @@ void TaskQueue::cancelTask(TaskId id) {
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
 		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
-		}
+		_tasksInProcess.erase(
+			ranges::remove(_tasksInProcess, id),
+			end(_tasksInProcess));
 	}
 	QMutexLocker lock(&_tasksToFinishMutex);
 	removeFrom(_tasksToFinish);
+	const auto wasFirst = !_tasksOrder.empty() && (_tasksOrder.front() == id);
+	_tasksOrder.erase(ranges::remove(_tasksOrder, id), end(_tasksOrder));
+	if (wasFirst && !_tasksToFinish.empty()) {
+		// The next tasks could be processed already and wait for this one.
+		crl::on_main(this, [=] { onTaskProcessed(); });
+	}
+}
+
+bool TaskQueue::processedTaskReady(std::unique_ptr<Task> &&task) {
+	QMutexLocker lock(&_tasksToFinishMutex);
+	const auto first = !_tasksOrder.empty()
+		&& (_tasksOrder.front() == task->id());
+	_tasksToFinish.push_back(std::move(task));
+
+	// Later tasks wait for the first one and are finished together.
+	return first;
 }
 
 void TaskQueue::onTaskProcessed() {
@@ -372,33 +432,48 @@ void TaskQueue::onTaskProcessed() {
 		auto task = std::unique_ptr<Task>();
 		{
 			QMutexLocker lock(&_tasksToFinishMutex);
-			if (_tasksToFinish.empty()) break;
-			task = std::move(_tasksToFinish.front());
-			_tasksToFinish.pop_front();
+			if (_tasksOrder.empty()) break;
+			const auto i = ranges::find(
+				_tasksToFinish,
+				_tasksOrder.front(),
+				[](const std::unique_ptr<Task> &task) { return task->id(); });
+			if (i == _tasksToFinish.end()) break;
+			task = std::move(*i);
+			_tasksToFinish.erase(i);
+			_tasksOrder.pop_front();
 		}
 		task->finish();
 	} while (true);
 
 	if (_stopTimer) {
 		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+		if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
+	for (const auto thread : _threads) {
+		thread->requestInterruption();
+		thread->quit();
+	}
+	if (!_threads.empty()) {
 		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete base::take(_worker);
-		delete base::take(_thread);
+	}
+	for (const auto thread : _threads) {
+		thread->wait();
+	}
+	for (const auto worker : base::take(_workers)) {
+		delete worker;
+	}
+	for (const auto thread : base::take(_threads)) {
+		delete thread;
 	}
 	_tasksToProcess.clear();
+	_tasksInProcess.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
+	_tasksOrder.clear();
 }
 
 TaskQueue::~TaskQueue() {
@@ -418,22 +493,23 @@ void TaskQueueWorker::onTaskAdded() {
 			if (!_queue->_tasksToProcess.empty()) {
 				task = std::move(_queue->_tasksToProcess.front());
 				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
+				_queue->_tasksInProcess.push_back(task->id());
 			}
 		}
 
+		someTasksLeft = false;
 		if (task) {
 			task->process();
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
+				auto &inProcess = _queue->_tasksInProcess;
+				const auto i = ranges::find(inProcess, task->id());
+				if (i != end(inProcess)) {
+					inProcess.erase(i);
 					someTasksLeft = !_queue->_tasksToProcess.empty();
-
-					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
-					emitTaskProcessed = _queue->_tasksToFinish.empty();
-					_queue->_tasksToFinish.push_back(std::move(task));
+					emitTaskProcessed = _queue->processedTaskReady(
+						std::move(task));
 				}
 			}
 			if (emitTaskProcessed) {
@@ -948,6 +1024,9 @@ void FileLoadTask::process() {
 	_result->type = _type;
 	_result->filepath = _filepath;
 	_result->content = _content;
+	if (_type == SendMediaType::File && !_album) {
+		_result->contentHash = ComputeContentHash(_filepath, _content);
+	}
 
 	_result->filename = filename;
 	_result->filemime = filemime;
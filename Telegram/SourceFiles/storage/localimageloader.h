@@ -104,7 +104,11 @@ class TaskQueue : public QObject {
 	Q_OBJECT
 
 public:
-	explicit TaskQueue(crl::time stopTimeoutMs = 0); // <= 0 - never stop worker
+	// stopTimeoutMs <= 0 - never stop workers.
+	//
+	// With several threads tasks are processed in parallel, but finish()
+	// is still called in the order the tasks were added.
+	explicit TaskQueue(crl::time stopTimeoutMs = 0, int threads = 1);
 
 	TaskId addTask(std::unique_ptr<Task> &&task);
 	void addTasks(std::vector<std::unique_ptr<Task>> &&tasks);
@@ -122,14 +126,18 @@ public slots:
 private:
 	friend class TaskQueueWorker;
 
-	void wakeThread();
+	void wakeThreads();
+	void pushTask(std::unique_ptr<Task> &&task);
+	bool processedTaskReady(std::unique_ptr<Task> &&task);
 
+	const int _threadsCount = 1;
 	std::deque<std::unique_ptr<Task>> _tasksToProcess;
+	std::vector<TaskId> _tasksInProcess;
 	std::deque<std::unique_ptr<Task>> _tasksToFinish;
-	TaskId _taskInProcessId = TaskId();
+	std::deque<TaskId> _tasksOrder;
 	QMutex _tasksToProcessMutex, _tasksToFinishMutex;
-	QThread *_thread = nullptr;
-	TaskQueueWorker *_worker = nullptr;
+	std::vector<QThread*> _threads;
+	std::vector<TaskQueueWorker*> _workers;
 	QTimer *_stopTimer = nullptr;
 
 };
@@ -212,6 +220,10 @@ struct FileLoadResult {
 	QByteArray filemd5;
 	int32 partssize;
 
+	// Identifies the file content to send the same document again
+	// without uploading it, filled only for not grouped documents.
+	QByteArray contentHash;
+
 	uint64 thumbId = 0; // id is always file-id of media, thumbId is file-id of thumb ( == id for photos)
 	QString thumbname;
 	UploadFileParts thumbparts;
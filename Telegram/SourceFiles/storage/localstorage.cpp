@@ -20,6 +20,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "export/export_settings.h"
 #include "core/crash_reports.h"
 #include "core/update_checker.h"
+#include "core/startup_trace.h"
 #include "observer_peer.h"
 #include "mainwidget.h"
 #include "mainwindow.h"
@@ -34,6 +35,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "base/flags.h"
 #include "data/data_session.h"
 #include "history/history.h"
+#include "storage/storage_shared_media.h"
 
 #ifndef BETTERGRAM_UPDATES
 #define BETTERGRAM_UPDATES (1)
@@ -48,9 +50,22 @@ namespace {
 
 constexpr auto kThemeFileSizeLimit = 5 * 1024 * 1024;
 constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
+constexpr auto kFileLoaderMaxThreads = 2;
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 constexpr auto kProxyTypeShift = 1024;
 constexpr auto kWriteMapTimeout = crl::time(1000);
+constexpr auto kMapJournalCheckpointSize = 256 * 1024;
+constexpr auto kSharedMediaCountsLimit = std::size_t(16384);
+constexpr auto kCacheShardsCount = 4;
+constexpr auto kCacheCompactBytesPerSecond = 4 * 1024 * 1024;
+constexpr auto kCacheHotSizeLimit = 32 * 1024 * 1024;
+constexpr auto kCacheBigFileHotSizeLimit = 16 * 1024 * 1024;
+constexpr auto kCacheKeyFilterSize = 64 * 1024;
+constexpr auto kCacheSnapshotAfterSize = 512 * 1024;
+constexpr auto kCacheStaleRemoveParallel = 4;
+constexpr auto kCacheStaleRemovePerSecond = 1000;
+constexpr auto kCacheFrequentUseCount = 2;
+constexpr auto kCacheLargeMediaQuota = 40; // Percent of the size limit.
 constexpr auto kSavedBackgroundFormat = QImage::Format_ARGB32_Premultiplied;
 
 constexpr auto kWallPaperLegacySerializeTagId = int32(-111);
@@ -64,7 +79,8 @@ constexpr auto kSinglePeerTypeSelf = qint32(4);
 constexpr auto kSinglePeerTypeEmpty = qint32(0);
 
 constexpr auto kStickersVersionTag = quint32(-1);
-constexpr auto kStickersSerializeVersion = 1;
+constexpr auto kStickersSerializeVersion = 2;
+constexpr auto kStickersSerializeFlatVersion = 2;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
 
 using Database = Storage::Cache::Database;
@@ -101,11 +117,184 @@ bool _userWorking() {
 enum class FileOption {
 	User = (1 << 0),
 	Safe = (1 << 1),
+	Sync = (1 << 2), // Write on the calling thread, bypassing WriteBehind.
 };
 using FileOptions = base::flags<FileOption>;
 inline constexpr auto is_flag_type(FileOption) { return true; };
 
+// Writes and removes files on a background queue. The latest contents of
+// every file is kept until it is on disk, so reads see it and repeated
+// writes of one file before the queue gets to it are merged into one.
+class WriteBehind {
+public:
+	// Base is the full path without the '0' / '1' suffix.
+	void write(const QString &base, QByteArray &&content, bool safe);
+	void writeNow(const QString &base, QByteArray &&content, bool safe);
+	void remove(const QString &base, bool safe);
+
+	// Empty content is returned for a pending removal.
+	bool find(const QString &base, QByteArray &content) const;
+	bool pending(const QString &base) const;
+
+	// Blocks until everything written before is on disk.
+	void flush();
+
+private:
+	struct Entry {
+		QByteArray content;
+		bool safe = false;
+		uint64 version = 0;
+	};
+
+	void enqueue(const QString &base, Entry &&entry);
+	void process();
+	static void Perform(const QString &base, const Entry &entry);
+
+	mutable QMutex _mutex;
+	std::map<QString, Entry> _entries;
+	uint64 _version = 0;
+	bool _processing = false;
+	crl::queue _queue;
+
+};
+
+WriteBehind &Writer() {
+	static auto result = WriteBehind();
+	return result;
+}
+
+void WriteBehind::write(const QString &base, QByteArray &&content, bool safe) {
+	Expects(!content.isEmpty());
+
+	auto entry = Entry();
+	entry.content = std::move(content);
+	entry.safe = safe;
+	enqueue(base, std::move(entry));
+}
+
+void WriteBehind::writeNow(
+		const QString &base,
+		QByteArray &&content,
+		bool safe) {
+	Expects(!content.isEmpty());
+
+	if (pending(base)) {
+		flush();
+	}
+	auto entry = Entry();
+	entry.content = std::move(content);
+	entry.safe = safe;
+	Perform(base, entry);
+}
+
+void WriteBehind::remove(const QString &base, bool safe) {
+	auto entry = Entry();
+	entry.safe = safe;
+	enqueue(base, std::move(entry));
+}
+
+bool WriteBehind::find(const QString &base, QByteArray &content) const {
+	QMutexLocker lock(&_mutex);
+	const auto i = _entries.find(base);
+	if (i == end(_entries)) {
+		return false;
+	}
+	content = i->second.content;
+	return true;
+}
+
+bool WriteBehind::pending(const QString &base) const {
+	QMutexLocker lock(&_mutex);
+	return _entries.find(base) != end(_entries);
+}
+
+void WriteBehind::flush() {
+	auto semaphore = crl::semaphore();
+	_queue.async([&] {
+		process();
+		semaphore.release();
+	});
+	semaphore.acquire();
+}
+
+void WriteBehind::enqueue(const QString &base, Entry &&entry) {
+	QMutexLocker lock(&_mutex);
+	entry.version = ++_version;
+	_entries[base] = std::move(entry);
+	if (!_processing) {
+		_processing = true;
+		_queue.async([=] { process(); });
+	}
+}
+
+void WriteBehind::process() {
+	while (true) {
+		auto base = QString();
+		auto entry = Entry();
+		{
+			QMutexLocker lock(&_mutex);
+			if (_entries.empty()) {
+				_processing = false;
+				return;
+			}
+			const auto i = begin(_entries);
+			base = i->first;
+			entry = i->second;
+		}
+		Perform(base, entry);
+		{
+			QMutexLocker lock(&_mutex);
+			const auto i = _entries.find(base);
+			if (i != end(_entries) && i->second.version == entry.version) {
+				_entries.erase(i);
+			}
+		}
+	}
+}
+
+void WriteBehind::Perform(const QString &base, const Entry &entry) {
+	QString toTry[2] = { base + '0', base + '1' };
+	if (entry.content.isEmpty()) {
+		QFile::remove(toTry[0]);
+		if (entry.safe) {
+			QFile::remove(toTry[1]);
+		}
+		return;
+	}
+
+	// Write over the older of the two files, remove the newer one after.
+	auto toDelete = QString();
+	if (entry.safe) {
+		QFileInfo toTry0(toTry[0]);
+		QFileInfo toTry1(toTry[1]);
+		if (toTry0.exists()) {
+			if (toTry1.exists()) {
+				QDateTime mod0 = toTry0.lastModified(), mod1 = toTry1.lastModified();
+				if (mod0 > mod1) {
+					qSwap(toTry[0], toTry[1]);
+				}
+			} else {
+				qSwap(toTry[0], toTry[1]);
+			}
+			toDelete = toTry[1];
+		} else if (toTry1.exists()) {
+			toDelete = toTry[1];
+		}
+	}
+
+	QFile file(toTry[0]);
+	if (file.open(QIODevice::WriteOnly)) {
+		file.write(entry.content);
+		file.close();
+
+		if (!toDelete.isEmpty()) {
+			QFile::remove(toDelete);
+		}
+	}
+}
+
 bool keyAlreadyUsed(QString &name, FileOptions options = FileOption::User | FileOption::Safe) {
+	if (Writer().pending(name)) return true;
 	name += '0';
 	if (QFileInfo(name).exists()) return true;
 	if (options & (FileOption::Safe)) {
@@ -142,14 +331,8 @@ void clearKey(const FileKey &key, FileOptions options = FileOption::User | FileO
 		if (!_working()) return;
 	}
 
-	QString base = (options & FileOption::User) ? _userBasePath : _basePath, name;
-	name.reserve(base.size() + 0x11);
-	name.append(base).append(toFilePart(key)).append('0');
-	QFile::remove(name);
-	if (options & FileOption::Safe) {
-		name[name.size() - 1] = '1';
-		QFile::remove(name);
-	}
+	const auto base = (options & FileOption::User) ? _userBasePath : _basePath;
+	Writer().remove(base + toFilePart(key), (options & FileOption::Safe));
 }
 
 bool _checkStreamStatus(QDataStream &stream) {
@@ -169,9 +352,27 @@ auto SettingsKey = MTP::AuthKeyPtr();
 auto PassKey = MTP::AuthKeyPtr();
 auto LocalKey = MTP::AuthKeyPtr();
 
-void createLocalKey(const QByteArray &pass, QByteArray *salt, MTP::AuthKeyPtr *result) {
+// Salt read from the map file, known even if the passcode was not entered yet.
+QByteArray _mapPassKeySalt;
+
+struct PreparedLocalKey {
+	QByteArray pass;
+	QByteArray salt;
+	MTP::AuthKeyPtr key;
+};
+PreparedLocalKey _preparedPassKey;
+
+// Can be called from any thread.
+MTP::AuthKeyPtr deriveLocalKey(const QByteArray &pass, const QByteArray &salt) {
 	auto key = MTP::AuthKey::Data { { gsl::byte{} } };
 	auto iterCount = pass.size() ? LocalEncryptIterCount : LocalEncryptNoPwdIterCount; // dont slow down for no password
+
+	PKCS5_PBKDF2_HMAC_SHA1(pass.constData(), pass.size(), (uchar*)salt.data(), salt.size(), iterCount, key.size(), (uchar*)key.data());
+
+	return std::make_shared<MTP::AuthKey>(key);
+}
+
+void createLocalKey(const QByteArray &pass, QByteArray *salt, MTP::AuthKeyPtr *result) {
 	auto newSalt = QByteArray();
 	if (!salt) {
 		newSalt.resize(LocalEncryptSaltSize);
@@ -181,9 +382,13 @@ void createLocalKey(const QByteArray &pass, QByteArray *salt, MTP::AuthKeyPtr *r
 		cSetLocalSalt(newSalt);
 	}
 
-	PKCS5_PBKDF2_HMAC_SHA1(pass.constData(), pass.size(), (uchar*)salt->data(), salt->size(), iterCount, key.size(), (uchar*)key.data());
-
-	*result = std::make_shared<MTP::AuthKey>(key);
+	if (_preparedPassKey.key
+		&& _preparedPassKey.pass == pass
+		&& _preparedPassKey.salt == *salt) {
+		*result = base::take(_preparedPassKey).key;
+		return;
+	}
+	*result = deriveLocalKey(pass, *salt);
 }
 
 struct FileReadDescriptor {
@@ -242,40 +447,22 @@ struct FileWriteDescriptor {
 			if (!_working()) return;
 		}
 
-		// detect order of read attempts and file version
-		QString toTry[2];
-		toTry[0] = ((options & FileOption::User) ? _userBasePath : _basePath) + name + '0';
-		if (options & FileOption::Safe) {
-			toTry[1] = ((options & FileOption::User) ? _userBasePath : _basePath) + name + '1';
-			QFileInfo toTry0(toTry[0]);
-			QFileInfo toTry1(toTry[1]);
-			if (toTry0.exists()) {
-				if (toTry1.exists()) {
-					QDateTime mod0 = toTry0.lastModified(), mod1 = toTry1.lastModified();
-					if (mod0 > mod1) {
-						qSwap(toTry[0], toTry[1]);
-					}
-				} else {
-					qSwap(toTry[0], toTry[1]);
-				}
-				toDelete = toTry[1];
-			} else if (toTry1.exists()) {
-				toDelete = toTry[1];
-			}
-		}
+		// The file itself is chosen and written by WriteBehind.
+		base = ((options & FileOption::User) ? _userBasePath : _basePath) + name;
+		safe = (options & FileOption::Safe);
+		sync = (options & FileOption::Sync);
 
-		file.setFileName(toTry[0]);
-		if (file.open(QIODevice::WriteOnly)) {
-			file.write(tdfMagic, tdfMagicLen);
-			qint32 version = AppVersion;
-			file.write((const char*)&version, sizeof(version));
+		buffer.setBuffer(&content);
+		buffer.open(QIODevice::WriteOnly);
+		buffer.write(tdfMagic, tdfMagicLen);
+		qint32 version = AppVersion;
+		buffer.write((const char*)&version, sizeof(version));
 
-			stream.setDevice(&file);
-			stream.setVersion(QDataStream::Qt_5_1);
-		}
+		stream.setDevice(&buffer);
+		stream.setVersion(QDataStream::Qt_5_1);
 	}
 	bool writeData(const QByteArray &data) {
-		if (!file.isOpen()) return false;
+		if (!buffer.isOpen()) return false;
 
 		stream << data;
 		quint32 len = data.isNull() ? 0xffffffff : data.size();
@@ -310,7 +497,7 @@ struct FileWriteDescriptor {
 		return writeData(prepareEncrypted(data, key));
 	}
 	void finish() {
-		if (!file.isOpen()) return;
+		if (!buffer.isOpen()) return;
 
 		stream.setDevice(nullptr);
 
@@ -318,17 +505,23 @@ struct FileWriteDescriptor {
 		qint32 version = AppVersion;
 		md5.feed(&version, sizeof(version));
 		md5.feed(tdfMagic, tdfMagicLen);
-		file.write((const char*)md5.result(), 0x10);
-		file.close();
+		buffer.write((const char*)md5.result(), 0x10);
+		buffer.close();
+		buffer.setBuffer(nullptr);
 
-		if (!toDelete.isEmpty()) {
-			QFile::remove(toDelete);
+		if (sync) {
+			Writer().writeNow(base, std::move(content), safe);
+		} else {
+			Writer().write(base, std::move(content), safe);
 		}
 	}
-	QFile file;
+	QByteArray content;
+	QBuffer buffer;
 	QDataStream stream;
 
-	QString toDelete;
+	QString base;
+	bool safe = false;
+	bool sync = false;
 
 	HashMd5 md5;
 	int32 dataSize = 0;
@@ -338,6 +531,61 @@ struct FileWriteDescriptor {
 	}
 };
 
+bool readFileContent(FileReadDescriptor &result, QByteArray &&content, const QString &name) {
+	// check magic
+	const auto header = tdfMagicLen + int(sizeof(qint32));
+	if (content.size() < tdfMagicLen) {
+		DEBUG_LOG(("App Info: failed to read magic from '%1'").arg(name));
+		return false;
+	}
+	const auto magic = content.constData();
+	if (memcmp(magic, tdfMagic, tdfMagicLen)) {
+		DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(Logs::mb(magic, tdfMagicLen).str()).arg(name));
+		return false;
+	}
+
+	// read app version
+	qint32 version;
+	if (content.size() < header) {
+		DEBUG_LOG(("App Info: failed to read version from '%1'").arg(name));
+		return false;
+	}
+	memcpy(&version, content.constData() + tdfMagicLen, sizeof(version));
+	if (version > AppVersion) {
+		DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3").arg(version).arg(name).arg(AppVersion));
+		return false;
+	}
+
+	// read data
+	int32 dataSize = content.size() - header - 16;
+	if (dataSize < 0) {
+		DEBUG_LOG(("App Info: bad file '%1', could not read sign part").arg(name));
+		return false;
+	}
+	const auto bytes = content.constData() + header;
+
+	// check signature
+	HashMd5 md5;
+	md5.feed(bytes, dataSize);
+	md5.feed(&dataSize, sizeof(dataSize));
+	md5.feed(&version, sizeof(version));
+	md5.feed(magic, tdfMagicLen);
+	if (memcmp(md5.result(), bytes + dataSize, 16)) {
+		DEBUG_LOG(("App Info: bad file '%1', signature did not match").arg(name));
+		return false;
+	}
+
+	result.data = content.mid(header, dataSize);
+	content = QByteArray();
+
+	result.version = version;
+	result.buffer.setBuffer(&result.data);
+	result.buffer.open(QIODevice::ReadOnly);
+	result.stream.setDevice(&result.buffer);
+	result.stream.setVersion(QDataStream::Qt_5_1);
+	return true;
+}
+
 bool readFile(FileReadDescriptor &result, const QString &name, FileOptions options = FileOption::User | FileOption::Safe) {
 	if (options & FileOption::User) {
 		if (!_userWorking()) return false;
@@ -345,6 +593,14 @@ bool readFile(FileReadDescriptor &result, const QString &name, FileOptions optio
 		if (!_working()) return false;
 	}
 
+	// not yet written content is the latest one
+	auto pending = QByteArray();
+	const auto base = ((options & FileOption::User) ? _userBasePath : _basePath) + name;
+	if (Writer().find(base, pending)) {
+		return !pending.isEmpty()
+			&& readFileContent(result, std::move(pending), name);
+	}
+
 	// detect order of read attempts
 	QString toTry[2];
 	toTry[0] = ((options & FileOption::User) ? _userBasePath : _basePath) + name + '0';
@@ -374,58 +630,10 @@ bool readFile(FileReadDescriptor &result, const QString &name, FileOptions optio
 			DEBUG_LOG(("App Info: failed to open '%1' for reading").arg(name));
 			continue;
 		}
-
-		// check magic
-		char magic[tdfMagicLen];
-		if (f.read(magic, tdfMagicLen) != tdfMagicLen) {
-			DEBUG_LOG(("App Info: failed to read magic from '%1'").arg(name));
-			continue;
-		}
-		if (memcmp(magic, tdfMagic, tdfMagicLen)) {
-			DEBUG_LOG(("App Info: bad magic %1 in '%2'").arg(Logs::mb(magic, tdfMagicLen).str()).arg(name));
-			continue;
-		}
-
-		// read app version
-		qint32 version;
-		if (f.read((char*)&version, sizeof(version)) != sizeof(version)) {
-			DEBUG_LOG(("App Info: failed to read version from '%1'").arg(name));
-			continue;
-		}
-		if (version > AppVersion) {
-			DEBUG_LOG(("App Info: version too big %1 for '%2', my version %3").arg(version).arg(name).arg(AppVersion));
-			continue;
-		}
-
-		// read data
-		QByteArray bytes = f.read(f.size());
-		int32 dataSize = bytes.size() - 16;
-		if (dataSize < 0) {
-			DEBUG_LOG(("App Info: bad file '%1', could not read sign part").arg(name));
-			continue;
-		}
-
-		// check signature
-		HashMd5 md5;
-		md5.feed(bytes.constData(), dataSize);
-		md5.feed(&dataSize, sizeof(dataSize));
-		md5.feed(&version, sizeof(version));
-		md5.feed(magic, tdfMagicLen);
-		if (memcmp(md5.result(), bytes.constData() + dataSize, 16)) {
-			DEBUG_LOG(("App Info: bad file '%1', signature did not match").arg(name));
+		if (!readFileContent(result, f.readAll(), name)) {
 			continue;
 		}
 
-		bytes.resize(dataSize);
-		result.data = bytes;
-		bytes = QByteArray();
-
-		result.version = version;
-		result.buffer.setBuffer(&result.data);
-		result.buffer.open(QIODevice::ReadOnly);
-		result.stream.setDevice(&result.buffer);
-		result.stream.setVersion(QDataStream::Qt_5_1);
-
 		if ((i == 0 && !toTry[1].isEmpty()) || i == 1) {
 			QFile::remove(toTry[1 - i]);
 		}
@@ -530,7 +738,22 @@ enum { // Local Storage Keys
 	lskExportSettings = 0x13, // no data
 	lskBackground = 0x14, // no data
 	lskSelfSerialized = 0x15, // serialized self
+	lskMapJournal = 0x16, // data: quint64 generation
+	lskSharedMediaCounts = 0x17, // no data
+};
+
+// Draft and draft cursor keys come and go much more often than anything
+// else in the map, so these changes are appended to the map journal and
+// the whole map is rewritten only once the journal grows large enough.
+// Records are accepted only with the generation stored in the map.
+struct MapJournalRecord {
+	quint64 generation = 0;
+	quint64 peer = 0;
+	quint64 key = 0; // Zero if the entry was removed.
+	quint32 type = 0; // lskDraft or lskDraftPosition.
+	quint32 checksum = 0;
 };
+static_assert(sizeof(MapJournalRecord) % Storage::CtrState::kBlockSize == 0);
 
 enum {
 	dbiKey = 0x00,
@@ -638,6 +861,25 @@ typedef QMap<PeerId, FileKey> DraftsMap;
 DraftsMap _draftsMap, _draftCursorsMap;
 typedef QMap<PeerId, bool> DraftsNotReadMap;
 DraftsNotReadMap _draftsNotReadMap;
+typedef QMap<PeerId, std::array<char, 16>> DraftsHashesMap;
+DraftsHashesMap _draftsHashes, _draftCursorsHashes;
+
+// Returns false if exactly the same data was written for this peer before.
+bool _draftDataChanged(
+		DraftsHashesMap &hashes,
+		const PeerId &peer,
+		const EncryptedDescriptor &data) {
+	const auto skip = int(sizeof(uint32));
+	const auto hash = hashMd5(
+		data.data.constData() + skip,
+		data.data.size() - skip);
+	const auto i = hashes.find(peer);
+	if (i != hashes.end() && i.value() == hash) {
+		return false;
+	}
+	hashes.insert(peer, hash);
+	return true;
+}
 
 typedef QPair<FileKey, qint32> FileDesc; // file, size
 
@@ -650,6 +892,10 @@ typedef QMap<MediaKey, MediaKey> FileLocationAliases;
 FileLocationAliases _fileLocationAliases;
 FileKey _locationsKey = 0, _reportSpamStatusesKey = 0, _trustedBotsKey = 0;
 
+// Both are read on the first use instead of the map reading time.
+bool _locationsRead = false;
+bool _reportSpamStatusesRead = false;
+
 using TrustedBots = OrderedSet<uint64>;
 TrustedBots _trustedBots;
 bool _trustedBotsRead = false;
@@ -689,11 +935,21 @@ bool NoTimeLimit(qint32 storedLimitValue) {
 
 FileKey _exportSettingsKey = 0;
 
+FileKey _sharedMediaCountsKey = 0;
+bool _sharedMediaCountsRead = false;
+base::flat_map<std::pair<PeerId, int32>, int32> _sharedMediaCounts;
+
 FileKey _savedPeersKey = 0;
 FileKey _langPackKey = 0;
 FileKey _languagesKey = 0;
 
 bool _mapChanged = false;
+Storage::File _mapJournal;
+quint64 _mapJournalGeneration = 0;
+
+// Older versions fail to read a map with lskMapJournal, so on a clean
+// shutdown the journal is collapsed into a map written without it.
+bool _mapJournalStopped = false;
 int32 _oldMapVersion = 0, _oldSettingsVersion = 0;
 
 enum class WriteMapWhen {
@@ -711,6 +967,43 @@ AuthSessionSettings &GetStoredAuthSessionCache() {
 }
 
 void _writeMap(WriteMapWhen when = WriteMapWhen::Soon);
+void _ensureLocationsRead();
+void _ensureSharedMediaCountsRead();
+
+void _writeSharedMediaCounts(WriteMapWhen when = WriteMapWhen::Soon) {
+	if (when != WriteMapWhen::Now) {
+		_manager->writeSharedMediaCounts(when == WriteMapWhen::Fast);
+		return;
+	}
+	if (!_working()) return;
+
+	_ensureSharedMediaCountsRead();
+
+	_manager->writingSharedMediaCounts();
+	if (_sharedMediaCounts.empty()) {
+		if (_sharedMediaCountsKey) {
+			clearKey(_sharedMediaCountsKey);
+			_sharedMediaCountsKey = 0;
+			_mapChanged = true;
+			_writeMap();
+		}
+		return;
+	}
+	if (!_sharedMediaCountsKey) {
+		_sharedMediaCountsKey = genKey();
+		_mapChanged = true;
+		_writeMap(WriteMapWhen::Fast);
+	}
+	auto size = sizeof(quint32)
+		+ _sharedMediaCounts.size() * (sizeof(quint64) + sizeof(qint32) * 2);
+	EncryptedDescriptor data(size);
+	data.stream << quint32(_sharedMediaCounts.size());
+	for (const auto &[key, count] : _sharedMediaCounts) {
+		data.stream << quint64(key.first) << qint32(key.second) << qint32(count);
+	}
+	FileWriteDescriptor file(_sharedMediaCountsKey);
+	file.writeEncrypted(data);
+}
 
 void _writeLocations(WriteMapWhen when = WriteMapWhen::Soon) {
 	if (when != WriteMapWhen::Now) {
@@ -719,6 +1012,8 @@ void _writeLocations(WriteMapWhen when = WriteMapWhen::Soon) {
 	}
 	if (!_working()) return;
 
+	_ensureLocationsRead();
+
 	_manager->writingLocations();
 	if (_fileLocations.isEmpty()) {
 		if (_locationsKey) {
@@ -840,9 +1135,53 @@ void _readLocations() {
 	}
 }
 
+void _ensureLocationsRead() {
+	if (_locationsRead || !_working()) {
+		return;
+	}
+	_locationsRead = true;
+	if (_locationsKey) {
+		const auto ms = crl::now();
+		_readLocations();
+		LOG(("Locations read time: %1").arg(crl::now() - ms));
+	}
+}
+
+void _ensureSharedMediaCountsRead() {
+	if (_sharedMediaCountsRead || !_working()) {
+		return;
+	}
+	_sharedMediaCountsRead = true;
+	if (!_sharedMediaCountsKey) {
+		return;
+	}
+
+	FileReadDescriptor file;
+	if (!readEncryptedFile(file, _sharedMediaCountsKey)) {
+		clearKey(_sharedMediaCountsKey);
+		_sharedMediaCountsKey = 0;
+		_writeMap();
+		return;
+	}
+	quint32 count = 0;
+	file.stream >> count;
+	for (auto i = quint32(0); i != count; ++i) {
+		quint64 peer = 0;
+		qint32 type = 0, value = 0;
+		file.stream >> peer >> type >> value;
+		if (!_checkStreamStatus(file.stream)) {
+			_sharedMediaCounts.clear();
+			return;
+		}
+		_sharedMediaCounts.emplace(std::make_pair(PeerId(peer), type), value);
+	}
+}
+
 void _writeReportSpamStatuses() {
 	if (!_working()) return;
 
+	readReportSpamStatuses();
+
 	if (cReportSpamStatuses().isEmpty()) {
 		if (_reportSpamStatusesKey) {
 			clearKey(_reportSpamStatusesKey);
@@ -884,8 +1223,8 @@ void _readReportSpamStatuses() {
 		return;
 	}
 
+	// Statuses set before the lazy read are newer than the stored ones.
 	ReportSpamStatuses &map(cRefReportSpamStatuses());
-	map.clear();
 
 	qint32 size = 0;
 	statuses.stream >> size;
@@ -893,7 +1232,9 @@ void _readReportSpamStatuses() {
 		quint64 peer = 0;
 		qint32 status = 0;
 		statuses.stream >> peer >> status;
-		map.insert(peer, DBIPeerReportSpamStatus(status));
+		if (!map.contains(peer)) {
+			map.insert(peer, DBIPeerReportSpamStatus(status));
+		}
 	}
 }
 
@@ -2247,6 +2588,98 @@ void _readMtpData() {
 	applyReadContext(std::move(context));
 }
 
+QString _mapJournalPath() {
+	return _userBasePath + qsl("map_journal");
+}
+
+Storage::EncryptionKey _mapJournalKey() {
+	return Storage::EncryptionKey(bytes::make_vector(LocalKey->data()));
+}
+
+quint32 _mapJournalChecksum(const MapJournalRecord &record) {
+	return quint32(hashCrc32(&record, offsetof(MapJournalRecord, checksum)));
+}
+
+void _createMapJournal() {
+	_mapJournal.close();
+	const auto result = _mapJournal.open(
+		_mapJournalPath(),
+		Storage::File::Mode::Write,
+		_mapJournalKey());
+	if (result != Storage::File::Result::Success) {
+		LOG(("App Error: could not create map journal."));
+		_mapJournal.close();
+	}
+}
+
+bool _appendMapJournal(quint32 type, PeerId peer, FileKey key) {
+	if (!_mapJournal.isOpen()
+		|| _mapJournal.size() >= kMapJournalCheckpointSize) {
+		return false;
+	}
+	auto record = MapJournalRecord();
+	record.generation = _mapJournalGeneration;
+	record.peer = quint64(peer);
+	record.key = quint64(key);
+	record.type = type;
+	record.checksum = _mapJournalChecksum(record);
+	if (!_mapJournal.write(bytes::object_as_span(&record))
+		|| !_mapJournal.flush()) {
+		_mapJournal.close();
+		return false;
+	}
+	return true;
+}
+
+// Returns false if the journal can't be continued and the map should be
+// rewritten to start a new one.
+bool _readMapJournal(
+		quint64 generation,
+		DraftsMap &draftsMap,
+		DraftsMap &draftCursorsMap,
+		DraftsNotReadMap &draftsNotReadMap) {
+	_mapJournal.close();
+	_mapJournalGeneration = generation;
+	if (!generation) {
+		// Collapsed on shutdown, the first change will rewrite the map.
+		return true;
+	}
+	const auto result = _mapJournal.open(
+		_mapJournalPath(),
+		Storage::File::Mode::ReadAppend,
+		_mapJournalKey());
+	if (result != Storage::File::Result::Success) {
+		_mapJournal.close();
+		return false;
+	}
+	auto record = MapJournalRecord();
+	while (const auto read = _mapJournal.read(
+			bytes::object_as_span(&record))) {
+		if (read != size_type(sizeof(record))
+			|| record.checksum != _mapJournalChecksum(record)
+			|| record.generation != generation
+			|| (record.type != lskDraft && record.type != lskDraftPosition)) {
+			LOG(("App Info: map journal ends with a bad record."));
+			_mapJournal.close();
+			return false;
+		}
+		const auto peer = PeerId(record.peer);
+		auto &map = (record.type == lskDraft) ? draftsMap : draftCursorsMap;
+		if (record.key) {
+			map.insert(peer, FileKey(record.key));
+			if (record.type == lskDraft) {
+				draftsNotReadMap.insert(peer, true);
+			}
+		} else {
+			map.remove(peer);
+			if (record.type == lskDraft) {
+				draftsNotReadMap.remove(peer);
+			}
+		}
+	}
+	return true;
+}
+
 ReadMapState _readMap(const QByteArray &pass) {
 	auto ms = crl::now();
 	QByteArray dataNameUtf8 = (cDataFile() + (cTestMode() ? qsl(":/test/") : QString())).toUtf8();
@@ -2275,6 +2708,7 @@ ReadMapState _readMap(const QByteArray &pass) {
 		LOG(("App Error: bad salt in map file, size: %1").arg(salt.size()));
 		return ReadMapFailed;
 	}
+	_mapPassKeySalt = salt;
 	createLocalKey(pass, &salt, &PassKey);
 
 	EncryptedDescriptor keyData, map;
@@ -2307,6 +2741,8 @@ ReadMapState _readMap(const QByteArray &pass) {
 	quint64 savedGifsKey = 0;
 	quint64 backgroundKeyDay = 0, backgroundKeyNight = 0;
 	quint64 userSettingsKey = 0, recentHashtagsAndBotsKey = 0, savedPeersKey = 0, exportSettingsKey = 0;
+	quint64 sharedMediaCountsKey = 0;
+	quint64 mapJournalGeneration = 0;
 	while (!map.stream.atEnd()) {
 		quint32 keyType;
 		map.stream >> keyType;
@@ -2396,6 +2832,12 @@ ReadMapState _readMap(const QByteArray &pass) {
 		case lskExportSettings: {
 			map.stream >> exportSettingsKey;
 		} break;
+		case lskSharedMediaCounts: {
+			map.stream >> sharedMediaCountsKey;
+		} break;
+		case lskMapJournal: {
+			map.stream >> mapJournalGeneration;
+		} break;
 		default:
 		LOG(("App Error: unknown key type in encrypted map: %1").arg(keyType));
 		return ReadMapFailed;
@@ -2405,12 +2847,20 @@ ReadMapState _readMap(const QByteArray &pass) {
 		}
 	}
 
+	const auto journalRead = _readMapJournal(
+		mapJournalGeneration,
+		draftsMap,
+		draftCursorsMap,
+		draftsNotReadMap);
+
 	_draftsMap = draftsMap;
 	_draftCursorsMap = draftCursorsMap;
 	_draftsNotReadMap = draftsNotReadMap;
 
 	_locationsKey = locationsKey;
+	_locationsRead = false;
 	_reportSpamStatusesKey = reportSpamStatusesKey;
+	_reportSpamStatusesRead = false;
 	_trustedBotsKey = trustedBotsKey;
 	_recentStickersKeyOld = recentStickersKeyOld;
 	_installedStickersKey = installedStickersKey;
@@ -2425,21 +2875,16 @@ ReadMapState _readMap(const QByteArray &pass) {
 	_userSettingsKey = userSettingsKey;
 	_recentHashtagsAndBotsKey = recentHashtagsAndBotsKey;
 	_exportSettingsKey = exportSettingsKey;
+	_sharedMediaCountsKey = sharedMediaCountsKey;
+	_sharedMediaCountsRead = false;
 	_oldMapVersion = mapData.version;
-	if (_oldMapVersion < AppVersion) {
+	if (_oldMapVersion < AppVersion || !journalRead) {
 		_mapChanged = true;
 		_writeMap();
 	} else {
 		_mapChanged = false;
 	}
 
-	if (_locationsKey) {
-		_readLocations();
-	}
-	if (_reportSpamStatusesKey) {
-		_readReportSpamStatuses();
-	}
-
 	_readUserSettings();
 	_readMtpData();
 
@@ -2470,7 +2915,8 @@ void _writeMap(WriteMapWhen when) {
 
 	if (!QDir().exists(_userBasePath)) QDir().mkpath(_userBasePath);
 
-	FileWriteDescriptor map(qsl("map"));
+	// Synchronously, the journal must never be newer than the map.
+	FileWriteDescriptor map(qsl("map"), FileOption::User | FileOption::Safe | FileOption::Sync);
 	if (_passKeySalt.isEmpty() || _passKeyEncrypted.isEmpty()) {
 		QByteArray pass(kLocalKeySize, Qt::Uninitialized), salt(LocalEncryptSaltSize, Qt::Uninitialized);
 		memset_rand(pass.data(), pass.size());
@@ -2528,6 +2974,14 @@ void _writeMap(WriteMapWhen when) {
 	if (_userSettingsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_recentHashtagsAndBotsKey) mapSize += sizeof(quint32) + sizeof(quint64);
 	if (_exportSettingsKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (_sharedMediaCountsKey) mapSize += sizeof(quint32) + sizeof(quint64);
+	if (!_mapJournalStopped) mapSize += sizeof(quint32) + sizeof(quint64);
+
+	_mapJournal.close();
+	_mapJournalGeneration = 0;
+	while (!_mapJournalStopped && !_mapJournalGeneration) {
+		_mapJournalGeneration = rand_value<quint64>();
+	}
 
 	EncryptedDescriptor mapData(mapSize);
 	if (!self.isEmpty()) {
@@ -2585,31 +3039,207 @@ void _writeMap(WriteMapWhen when) {
 	if (_exportSettingsKey) {
 		mapData.stream << quint32(lskExportSettings) << quint64(_exportSettingsKey);
 	}
+	if (_sharedMediaCountsKey) {
+		mapData.stream << quint32(lskSharedMediaCounts) << quint64(_sharedMediaCountsKey);
+	}
+	if (_mapJournalGeneration) {
+		mapData.stream << quint32(lskMapJournal) << quint64(_mapJournalGeneration);
+	}
 	map.writeEncrypted(mapData);
+	map.finish();
 
 	_mapChanged = false;
+	if (_mapJournalGeneration) {
+		_createMapJournal();
+	}
 }
 
-} // namespace
-
-void finish() {
-	if (_manager) {
-		_writeMap(WriteMapWhen::Now);
-		_manager->finish();
-		_manager->deleteLater();
-		_manager = 0;
-		delete base::take(_localLoader);
+void _writeMapChange(quint32 type, PeerId peer, FileKey key) {
+	if (_mapChanged || !_appendMapJournal(type, peer, key)) {
+		_mapChanged = true;
+		_writeMap(key ? WriteMapWhen::Fast : WriteMapWhen::Soon);
 	}
 }
 
-void loadTheme();
+struct BackgroundRead {
+	bool read = false;
+	int32 version = 0;
+	std::optional<Data::WallPaper> paper;
+	bool isOldEmptyImage = false;
+	bool imageDataEmpty = false;
+	QImage image;
+};
+
+// Reading and decoding the wallpaper doesn't touch any main thread state,
+// so it is started on a background thread right after the map is read
+// and joined when the chat background asks for it.
+struct BackgroundPrefetch {
+	FileKey key = 0;
+	crl::semaphore done;
+	BackgroundRead result;
+};
+std::shared_ptr<BackgroundPrefetch> _backgroundPrefetch;
+
+QImage ReadBackgroundImage(qint32 legacyId, const QByteArray &imageData) {
+	auto image = QImage();
+	if (legacyId == kWallPaperSerializeTagId) {
+		const auto perpixel = 4;
+		auto src = bytes::make_span(imageData);
+		auto width = qint32();
+		auto height = qint32();
+		if (src.size() > 2 * sizeof(qint32)) {
+			bytes::copy(
+				bytes::object_as_span(&width),
+				src.subspan(0, sizeof(qint32)));
+			src = src.subspan(sizeof(qint32));
+			bytes::copy(
+				bytes::object_as_span(&height),
+				src.subspan(0, sizeof(qint32)));
+			src = src.subspan(sizeof(qint32));
+			if (width + height <= kWallPaperSidesLimit
+				&& src.size() == width * height * perpixel) {
+				image = QImage(
+					width,
+					height,
+					QImage::Format_ARGB32_Premultiplied);
+				if (!image.isNull()) {
+					const auto srcperline = width * perpixel;
+					const auto srcsize = srcperline * height;
+					const auto dstperline = image.bytesPerLine();
+					const auto dstsize = dstperline * height;
+					Assert(srcsize == dstsize);
+					bytes::copy(
+						bytes::make_span(image.bits(), dstsize),
+						src);
+				}
+			}
+		}
+	} else {
+		auto buffer = QBuffer(const_cast<QByteArray*>(&imageData));
+		auto reader = QImageReader(&buffer);
+#ifndef OS_MAC_OLD
+		reader.setAutoTransform(true);
+#endif // OS_MAC_OLD
+		if (!reader.read(&image)) {
+			image = QImage();
+		}
+	}
+	return image;
+}
+
+// Thread: Any.
+BackgroundRead ReadBackground(FileKey key, const MTP::AuthKeyPtr &localKey) {
+	auto result = BackgroundRead();
+	FileReadDescriptor bg;
+	if (!readEncryptedFile(bg, key, FileOption::User | FileOption::Safe, localKey)) {
+		return result;
+	}
+	result.read = true;
+	result.version = bg.version;
+
+	qint32 legacyId = 0;
+	bg.stream >> legacyId;
+	result.paper = [&] {
+		if (legacyId == kWallPaperLegacySerializeTagId) {
+			quint64 id = 0;
+			quint64 accessHash = 0;
+			quint32 flags = 0;
+			QString slug;
+			bg.stream
+				>> id
+				>> accessHash
+				>> flags
+				>> slug;
+			return Data::WallPaper::FromLegacySerialized(
+				id,
+				accessHash,
+				flags,
+				slug);
+		} else if (legacyId == kWallPaperSerializeTagId) {
+			QByteArray serialized;
+			bg.stream >> serialized;
+			return Data::WallPaper::FromSerialized(serialized);
+		} else {
+			return Data::WallPaper::FromLegacyId(legacyId);
+		}
+	}();
+	if (bg.stream.status() != QDataStream::Ok || !result.paper) {
+		result.paper = std::nullopt;
+		return result;
+	}
+
+	QByteArray imageData;
+	bg.stream >> imageData;
+	result.isOldEmptyImage = (bg.stream.status() != QDataStream::Ok);
+	result.imageDataEmpty = imageData.isEmpty();
+	const auto &paper = *result.paper;
+	if (result.isOldEmptyImage
+		|| Data::IsLegacy1DefaultWallPaper(paper)
+		|| Data::IsDefaultWallPaper(paper)
+		|| (Data::IsThemeWallPaper(paper) && result.imageDataEmpty)) {
+		return result;
+	}
+	result.image = ReadBackgroundImage(legacyId, imageData);
+	return result;
+}
+
+void StartBackgroundPrefetch() {
+	const auto key = Window::Theme::IsNightMode()
+		? _backgroundKeyNight
+		: _backgroundKeyDay;
+	if (!key) {
+		_backgroundPrefetch = nullptr;
+		return;
+	}
+	const auto prefetch = std::make_shared<BackgroundPrefetch>();
+	prefetch->key = key;
+	_backgroundPrefetch = prefetch;
+	crl::async([=, localKey = LocalKey] {
+		const auto trace = Core::StartupTrace::Scope(
+			"Local::prefetchBackground");
+		prefetch->result = ReadBackground(prefetch->key, localKey);
+		prefetch->done.release();
+	});
+}
+
+BackgroundRead TakeBackground(FileKey key) {
+	if (const auto prefetch = base::take(_backgroundPrefetch)) {
+		prefetch->done.acquire();
+		if (prefetch->key == key) {
+			return std::move(prefetch->result);
+		}
+	}
+	return ReadBackground(key, LocalKey);
+}
+
+} // namespace
+
+void finish() {
+	if (_manager) {
+		if (_mapJournalGeneration) {
+			_mapChanged = true;
+		}
+		_mapJournalStopped = true;
+		_writeMap(WriteMapWhen::Now);
+		_manager->finish();
+		Writer().flush();
+		_manager->deleteLater();
+		_manager = 0;
+		delete base::take(_localLoader);
+	}
+}
+
+void loadTheme();
 void readLangPack();
 
 void start() {
 	Expects(!_manager);
 
 	_manager = new internal::Manager();
-	_localLoader = new TaskQueue(kFileLoaderQueueStopTimeout);
+	_mapJournalStopped = false;
+	_localLoader = new TaskQueue(
+		kFileLoaderQueueStopTimeout,
+		std::clamp(QThread::idealThreadCount() / 2, 1, kFileLoaderMaxThreads));
 
 	_basePath = cWorkingDir() + qsl("tdata/");
 	if (!QDir().exists(_basePath)) QDir().mkpath(_basePath);
@@ -2839,19 +3469,30 @@ void reset() {
 	}
 
 	_passKeySalt.clear(); // reset passcode, local key
+	_mapPassKeySalt.clear();
+	_preparedPassKey = PreparedLocalKey();
+	_mapJournal.close();
+	_mapJournalGeneration = 0;
 	_draftsMap.clear();
 	_draftCursorsMap.clear();
+	_draftsHashes.clear();
+	_draftCursorsHashes.clear();
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
 	_draftsNotReadMap.clear();
 	_locationsKey = _reportSpamStatusesKey = _trustedBotsKey = 0;
+	_locationsRead = _reportSpamStatusesRead = false;
 	_recentStickersKeyOld = 0;
 	_installedStickersKey = _featuredStickersKey = _recentStickersKey = _favedStickersKey = _archivedStickersKey = 0;
 	_savedGifsKey = 0;
 	_backgroundKeyDay = _backgroundKeyNight = 0;
+	_backgroundPrefetch = nullptr;
 	Window::Theme::Background()->reset();
 	_userSettingsKey = _recentHashtagsAndBotsKey = _savedPeersKey = _exportSettingsKey = 0;
+	_sharedMediaCountsKey = 0;
+	_sharedMediaCountsRead = false;
+	_sharedMediaCounts.clear();
 	_oldMapVersion = _oldSettingsVersion = 0;
 	_cacheTotalSizeLimit = Database::Settings().totalSizeLimit;
 	_cacheTotalTimeLimit = Database::Settings().totalTimeLimit;
@@ -2864,6 +3505,25 @@ void reset() {
 	_writeMtpData();
 }
 
+void preparePasscodeKey(const QByteArray &passcode, Fn<void()> ready) {
+	Expects(ready != nullptr);
+
+	const auto salt = _passKeySalt.isEmpty()
+		? _mapPassKeySalt
+		: _passKeySalt;
+	if (passcode.isEmpty() || salt.isEmpty()) {
+		ready();
+		return;
+	}
+	crl::async([=] {
+		auto key = deriveLocalKey(passcode, salt);
+		crl::on_main([=, key = std::move(key)]() mutable {
+			_preparedPassKey = { passcode, salt, std::move(key) };
+			ready();
+		});
+	});
+}
+
 bool checkPasscode(const QByteArray &passcode) {
 	auto checkKey = MTP::AuthKeyPtr();
 	createLocalKey(passcode, &_passKeySalt, &checkKey);
@@ -2900,10 +3560,11 @@ base::flat_set<QString> CollectGoodNames() {
 		_backgroundKeyDay,
 		_recentHashtagsAndBotsKey,
 		_exportSettingsKey,
+		_sharedMediaCountsKey,
 		_savedPeersKey,
 		_trustedBotsKey
 	};
-	auto result = base::flat_set<QString>{ "map0", "map1" };
+	auto result = base::flat_set<QString>{ "map0", "map1", "map_journal" };
 	const auto push = [&](FileKey key) {
 		if (!key) {
 			return;
@@ -2933,6 +3594,9 @@ void FilterLegacyFiles(FnMut<void(base::flat_set<QString>&&)> then) {
 
 ReadMapState readMap(const QByteArray &pass) {
 	ReadMapState result = _readMap(pass);
+	if (result == ReadMapDone) {
+		StartBackgroundPrefetch();
+	}
 	if (result == ReadMapFailed) {
 		_mapChanged = true;
 		_writeMap(WriteMapWhen::Now);
@@ -2959,17 +3623,17 @@ void writeDrafts(const PeerId &peer, const MessageDraft &localDraft, const Messa
 		if (i != _draftsMap.cend()) {
 			clearKey(i.value());
 			_draftsMap.erase(i);
-			_mapChanged = true;
-			_writeMap();
+			_writeMapChange(lskDraft, peer, 0);
 		}
+		_draftsHashes.remove(peer);
 
 		_draftsNotReadMap.remove(peer);
 	} else {
 		auto i = _draftsMap.constFind(peer);
 		if (i == _draftsMap.cend()) {
 			i = _draftsMap.insert(peer, genKey());
-			_mapChanged = true;
-			_writeMap(WriteMapWhen::Fast);
+			_writeMapChange(lskDraft, peer, i.value());
+			_draftsHashes.remove(peer);
 		}
 
 		auto msgTags = TextUtilities::SerializeTags(
@@ -2988,8 +3652,10 @@ void writeDrafts(const PeerId &peer, const MessageDraft &localDraft, const Messa
 		data.stream << editDraft.textWithTags.text << editTags;
 		data.stream << qint32(editDraft.msgId) << qint32(editDraft.previewCancelled ? 1 : 0);
 
-		FileWriteDescriptor file(i.value());
-		file.writeEncrypted(data);
+		if (_draftDataChanged(_draftsHashes, peer, data)) {
+			FileWriteDescriptor file(i.value());
+			file.writeEncrypted(data);
+		}
 
 		_draftsNotReadMap.remove(peer);
 	}
@@ -3000,9 +3666,9 @@ void clearDraftCursors(const PeerId &peer) {
 	if (i != _draftCursorsMap.cend()) {
 		clearKey(i.value());
 		_draftCursorsMap.erase(i);
-		_mapChanged = true;
-		_writeMap();
+		_writeMapChange(lskDraftPosition, peer, 0);
 	}
+	_draftCursorsHashes.remove(peer);
 }
 
 void _readDraftCursors(const PeerId &peer, MessageCursor &localCursor, MessageCursor &editCursor) {
@@ -3122,16 +3788,18 @@ void writeDraftCursors(const PeerId &peer, const MessageCursor &msgCursor, const
 		DraftsMap::const_iterator i = _draftCursorsMap.constFind(peer);
 		if (i == _draftCursorsMap.cend()) {
 			i = _draftCursorsMap.insert(peer, genKey());
-			_mapChanged = true;
-			_writeMap(WriteMapWhen::Fast);
+			_writeMapChange(lskDraftPosition, peer, i.value());
+			_draftCursorsHashes.remove(peer);
 		}
 
 		EncryptedDescriptor data(sizeof(quint64) + sizeof(qint32) * 3);
 		data.stream << quint64(peer) << qint32(msgCursor.position) << qint32(msgCursor.anchor) << qint32(msgCursor.scroll);
 		data.stream << qint32(editCursor.position) << qint32(editCursor.anchor) << qint32(editCursor.scroll);
 
-		FileWriteDescriptor file(i.value());
-		file.writeEncrypted(data);
+		if (_draftDataChanged(_draftCursorsHashes, peer, data)) {
+			FileWriteDescriptor file(i.value());
+			file.writeEncrypted(data);
+		}
 	}
 }
 
@@ -3146,6 +3814,8 @@ bool hasDraft(const PeerId &peer) {
 void writeFileLocation(MediaKey location, const FileLocation &local) {
 	if (local.fname.isEmpty()) return;
 
+	_ensureLocationsRead();
+
 	FileLocationAliases::const_iterator aliasIt = _fileLocationAliases.constFind(location);
 	if (aliasIt != _fileLocationAliases.cend()) {
 		location = aliasIt.value();
@@ -3176,6 +3846,8 @@ void writeFileLocation(MediaKey location, const FileLocation &local) {
 }
 
 FileLocation readFileLocation(MediaKey location, bool check) {
+	_ensureLocationsRead();
+
 	FileLocationAliases::const_iterator aliasIt = _fileLocationAliases.constFind(location);
 	if (aliasIt != _fileLocationAliases.cend()) {
 		location = aliasIt.value();
@@ -3242,6 +3914,18 @@ Storage::Cache::Database::Settings cacheSettings() {
 	result.totalSizeLimit = _cacheTotalSizeLimit;
 	result.totalTimeLimit = _cacheTotalTimeLimit;
 	result.maxDataSize = Storage::kMaxFileInMemory;
+	result.shardsCount = kCacheShardsCount;
+	result.compactBytesPerSecond = kCacheCompactBytesPerSecond;
+	result.hotSizeLimit = kCacheHotSizeLimit;
+	result.keyFilterSize = kCacheKeyFilterSize;
+	result.snapshotAfterSize = kCacheSnapshotAfterSize;
+	result.staleRemoveParallel = kCacheStaleRemoveParallel;
+	result.staleRemovePerSecond = kCacheStaleRemovePerSecond;
+	result.frequentUseCount = kCacheFrequentUseCount;
+	result.tagSizeQuotas = {
+		{ Data::kVideoMessageCacheTag, kCacheLargeMediaQuota },
+		{ Data::kAnimationCacheTag, kCacheLargeMediaQuota },
+	};
 	return result;
 }
 
@@ -3278,6 +3962,13 @@ Storage::Cache::Database::Settings cacheBigFileSettings() {
 	result.totalSizeLimit = _cacheBigFileTotalSizeLimit;
 	result.totalTimeLimit = _cacheBigFileTotalTimeLimit;
 	result.maxDataSize = Storage::kMaxFileInMemory;
+	result.compactBytesPerSecond = kCacheCompactBytesPerSecond;
+	result.hotSizeLimit = kCacheBigFileHotSizeLimit;
+	result.keyFilterSize = kCacheKeyFilterSize;
+	result.snapshotAfterSize = kCacheSnapshotAfterSize;
+	result.staleRemoveParallel = kCacheStaleRemoveParallel;
+	result.staleRemovePerSecond = kCacheStaleRemovePerSecond;
+	result.frequentUseCount = kCacheFrequentUseCount;
 	return result;
 }
 
@@ -3392,6 +4083,16 @@ void _writeStickerSet(QDataStream &stream, const Stickers::Set &set) {
 	}
 }
 
+QByteArray _serializeStickerSet(const Stickers::Set &set) {
+	auto result = QByteArray();
+	QBuffer buffer(&result);
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream stream(&buffer);
+	stream.setVersion(QDataStream::Qt_5_1);
+	_writeStickerSet(stream, set);
+	return result;
+}
+
 // In generic method _writeStickerSets() we look through all the sets and call a
 // callback on each set to see, if we write it, skip it or abort the whole write.
 enum class StickerSetCheckResult {
@@ -3400,6 +4101,11 @@ enum class StickerSetCheckResult {
 	Abort,
 };
 
+// The file has a table of (id, offset, size) for all the sets after the
+// header and the order, so that the sets can be decoded one by one right
+// from the decrypted data and the ones already read from another file
+// can be skipped without parsing their documents.
+//
 // CheckSet is a functor on Stickers::Set, which returns a StickerSetCheckResult.
 template <typename CheckSet>
 void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::Order &order) {
@@ -3416,10 +4122,7 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 		return;
 	}
 
-	// versionTag + version + count
-	quint32 size = sizeof(quint32) + sizeof(qint32) + sizeof(qint32);
-
-	int32 setsCount = 0;
+	auto serialized = std::vector<std::pair<uint64, QByteArray>>();
 	for (const auto &set : sets) {
 		auto result = checkSet(set);
 		if (result == StickerSetCheckResult::Abort) {
@@ -3427,38 +4130,17 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 		} else if (result == StickerSetCheckResult::Skip) {
 			continue;
 		}
-
-		// id + access + title + shortName + stickersCount + hash + flags + installDate
-		size += sizeof(quint64) * 2
-			+ Serialize::stringSize(set.title)
-			+ Serialize::stringSize(set.shortName)
-			+ sizeof(qint32) * 4
-			+ Serialize::storageImageLocationSize(set.thumbnail
-				? set.thumbnail->location()
-				: StorageImageLocation());
-		if (set.flags & MTPDstickerSet_ClientFlag::f_not_loaded) {
-			continue;
-		}
-
-		for (const auto sticker : set.stickers) {
-			sticker->refreshStickerThumbFileReference();
-			size += Serialize::Document::sizeInStream(sticker);
-		}
-
-		size += sizeof(qint32); // datesCount
-		if (!set.dates.empty()) {
-			Assert(set.stickers.size() == set.dates.size());
-			size += set.dates.size() * sizeof(qint32);
+		if (!(set.flags & MTPDstickerSet_ClientFlag::f_not_loaded)) {
+			for (const auto sticker : set.stickers) {
+				sticker->refreshStickerThumbFileReference();
+			}
 		}
-
-		size += sizeof(qint32); // emojiCount
-		for (auto j = set.emoji.cbegin(), e = set.emoji.cend(); j != e; ++j) {
-			size += Serialize::stringSize(j.key()->id()) + sizeof(qint32) + (j->size() * sizeof(quint64));
+		auto bytes = _serializeStickerSet(set);
+		if (!bytes.isEmpty()) {
+			serialized.emplace_back(set.id, std::move(bytes));
 		}
-
-		++setsCount;
 	}
-	if (!setsCount && order.isEmpty()) {
+	if (serialized.empty() && order.isEmpty()) {
 		if (stickersKey) {
 			clearKey(stickersKey);
 			stickersKey = 0;
@@ -3467,7 +4149,16 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 		_writeMap();
 		return;
 	}
+
+	// versionTag + version + count
+	quint32 size = sizeof(quint32) + sizeof(qint32) + sizeof(qint32);
+
+	// id + offset + size
+	size += serialized.size() * (sizeof(quint64) + sizeof(qint32) * 2);
 	size += sizeof(qint32) + (order.size() * sizeof(quint64));
+	for (const auto &[id, bytes] : serialized) {
+		size += bytes.size();
+	}
 
 	if (!stickersKey) {
 		stickersKey = genKey();
@@ -3478,34 +4169,193 @@ void _writeStickerSets(FileKey &stickersKey, CheckSet checkSet, const Stickers::
 	data.stream
 		<< quint32(kStickersVersionTag)
 		<< qint32(kStickersSerializeVersion)
-		<< qint32(setsCount);
-	for (const auto &set : sets) {
-		auto result = checkSet(set);
-		if (result == StickerSetCheckResult::Abort) {
-			return;
-		} else if (result == StickerSetCheckResult::Skip) {
-			continue;
-		}
-		_writeStickerSet(data.stream, set);
+		<< qint32(serialized.size());
+	auto offset = 0;
+	for (const auto &[id, bytes] : serialized) {
+		data.stream << quint64(id) << qint32(offset) << qint32(bytes.size());
+		offset += bytes.size();
 	}
 	data.stream << order;
+	for (const auto &[id, bytes] : serialized) {
+		data.stream.writeRawData(bytes.constData(), bytes.size());
+	}
 
 	FileWriteDescriptor file(stickersKey);
 	file.writeEncrypted(data);
 }
 
-void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr, MTPDstickerSet::Flags readingFlags = 0) {
+bool _readStickerSet(
+		QDataStream &stream,
+		int32 streamVersion,
+		Stickers::Sets &sets) {
+	quint64 setId = 0, setAccess = 0;
+	QString setTitle, setShortName;
+	qint32 scnt = 0;
+	qint32 setInstallDate = 0;
+	qint32 setHash = 0;
+	MTPDstickerSet::Flags setFlags = 0;
+	qint32 setFlagsValue = 0;
+	StorageImageLocation setThumbnail;
+
+	stream
+		>> setId
+		>> setAccess
+		>> setTitle
+		>> setShortName
+		>> scnt
+		>> setHash
+		>> setFlagsValue
+		>> setInstallDate;
+	setThumbnail = Serialize::readStorageImageLocation(
+		streamVersion,
+		stream);
+	if (!_checkStreamStatus(stream)) {
+		return false;
+	}
+
+	setFlags = MTPDstickerSet::Flags::from_raw(setFlagsValue);
+	if (setId == Stickers::DefaultSetId) {
+		setTitle = lang(lng_stickers_default_set);
+		setFlags |= MTPDstickerSet::Flag::f_official | MTPDstickerSet_ClientFlag::f_special;
+	} else if (setId == Stickers::CustomSetId) {
+		setTitle = qsl("Custom stickers");
+		setFlags |= MTPDstickerSet_ClientFlag::f_special;
+	} else if (setId == Stickers::CloudRecentSetId) {
+		setTitle = lang(lng_recent_stickers);
+		setFlags |= MTPDstickerSet_ClientFlag::f_special;
+	} else if (setId == Stickers::FavedSetId) {
+		setTitle = Lang::Hard::FavedSetTitle();
+		setFlags |= MTPDstickerSet_ClientFlag::f_special;
+	} else if (!setId) {
+		return true;
+	}
+
+	auto it = sets.find(setId);
+	if (it == sets.cend()) {
+		// We will set this flags from order lists when reading those stickers.
+		setFlags &= ~(MTPDstickerSet::Flag::f_installed_date | MTPDstickerSet_ClientFlag::f_featured);
+		it = sets.insert(setId, Stickers::Set(
+			setId,
+			setAccess,
+			setTitle,
+			setShortName,
+			0,
+			setHash,
+			MTPDstickerSet::Flags(setFlags),
+			setInstallDate,
+			setThumbnail.isNull() ? ImagePtr() : Images::Create(setThumbnail)));
+	}
+	auto &set = it.value();
+	auto inputSet = MTP_inputStickerSetID(MTP_long(set.id), MTP_long(set.access));
+	const auto fillStickers = set.stickers.isEmpty();
+
+	if (scnt < 0) { // disabled not loaded set
+		if (!set.count || fillStickers) {
+			set.count = -scnt;
+		}
+		return true;
+	}
+
+	if (fillStickers) {
+		set.stickers.reserve(scnt);
+		set.count = 0;
+	}
+
+	Serialize::Document::StickerSetInfo info(setId, setAccess, setShortName);
+	base::flat_set<DocumentId> read;
+	for (int32 j = 0; j < scnt; ++j) {
+		auto document = Serialize::Document::readStickerFromStream(streamVersion, stream, info);
+		if (!_checkStreamStatus(stream)) {
+			return false;
+		} else if (!document
+			|| !document->sticker()
+			|| read.contains(document->id)) {
+			continue;
+		}
+		read.emplace(document->id);
+		if (fillStickers) {
+			set.stickers.push_back(document);
+			if (!(set.flags & MTPDstickerSet_ClientFlag::f_special)) {
+				if (document->sticker()->set.type() != mtpc_inputStickerSetID) {
+					document->sticker()->set = inputSet;
+				}
+			}
+			++set.count;
+		}
+	}
+
+	qint32 datesCount = 0;
+	stream >> datesCount;
+	if (datesCount > 0) {
+		if (datesCount != scnt) {
+			return false;
+		}
+		const auto fillDates = (set.id == Stickers::CloudRecentSetId)
+			&& (set.stickers.size() == datesCount);
+		if (fillDates) {
+			set.dates.clear();
+			set.dates.reserve(datesCount);
+		}
+		for (auto i = 0; i != datesCount; ++i) {
+			qint32 date = 0;
+			stream >> date;
+			if (fillDates) {
+				set.dates.push_back(TimeId(date));
+			}
+		}
+	}
+
+	qint32 emojiCount = 0;
+	stream >> emojiCount;
+	if (!_checkStreamStatus(stream) || emojiCount < 0) {
+		return false;
+	}
+	for (int32 j = 0; j < emojiCount; ++j) {
+		QString emojiString;
+		qint32 stickersCount;
+		stream >> emojiString >> stickersCount;
+		Stickers::Pack pack;
+		pack.reserve(stickersCount);
+		for (int32 k = 0; k < stickersCount; ++k) {
+			quint64 id;
+			stream >> id;
+			const auto doc = Auth().data().document(id);
+			if (!doc->sticker()) continue;
+
+			pack.push_back(doc);
+		}
+		if (fillStickers) {
+			if (auto emoji = Ui::Emoji::Find(emojiString)) {
+				emoji = emoji->original();
+				set.emoji.insert(emoji, pack);
+			}
+		}
+	}
+	return _checkStreamStatus(stream);
+}
+
+bool _stickerSetAlreadyRead(const Stickers::Sets &sets, uint64 setId) {
+	// Recent stickers dates are read even for a filled set.
+	const auto i = sets.constFind(setId);
+	return (i != sets.cend())
+		&& !i->stickers.isEmpty()
+		&& (setId != Stickers::CloudRecentSetId);
+}
+
+// Returns true if the file was in an old format and should be rewritten.
+bool _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr, MTPDstickerSet::Flags readingFlags = 0) {
 	FileReadDescriptor stickers;
 	if (!readEncryptedFile(stickers, stickersKey)) {
 		clearKey(stickersKey);
 		stickersKey = 0;
 		_writeMap();
-		return;
+		return false;
 	}
 
 	const auto failed = [&] {
 		clearKey(stickersKey);
 		stickersKey = 0;
+		return false;
 	};
 
 	auto &sets = Auth().data().stickerSetsRef();
@@ -3527,159 +4377,58 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 		|| (count > kMaxSavedStickerSetsCount)) {
 		return failed();
 	}
-	for (auto i = 0; i != count; ++i) {
-		quint64 setId = 0, setAccess = 0;
-		QString setTitle, setShortName;
-		qint32 scnt = 0;
-		qint32 setInstallDate = 0;
-		qint32 setHash = 0;
-		MTPDstickerSet::Flags setFlags = 0;
-		qint32 setFlagsValue = 0;
-		StorageImageLocation setThumbnail;
-
-		stickers.stream
-			>> setId
-			>> setAccess
-			>> setTitle
-			>> setShortName
-			>> scnt
-			>> setHash
-			>> setFlagsValue
-			>> setInstallDate;
-		setThumbnail = Serialize::readStorageImageLocation(
-			stickers.version,
-			stickers.stream);
-		if (!_checkStreamStatus(stickers.stream)) {
-			return failed();
-		}
-
-		setFlags = MTPDstickerSet::Flags::from_raw(setFlagsValue);
-		if (setId == Stickers::DefaultSetId) {
-			setTitle = lang(lng_stickers_default_set);
-			setFlags |= MTPDstickerSet::Flag::f_official | MTPDstickerSet_ClientFlag::f_special;
-		} else if (setId == Stickers::CustomSetId) {
-			setTitle = qsl("Custom stickers");
-			setFlags |= MTPDstickerSet_ClientFlag::f_special;
-		} else if (setId == Stickers::CloudRecentSetId) {
-			setTitle = lang(lng_recent_stickers);
-			setFlags |= MTPDstickerSet_ClientFlag::f_special;
-		} else if (setId == Stickers::FavedSetId) {
-			setTitle = Lang::Hard::FavedSetTitle();
-			setFlags |= MTPDstickerSet_ClientFlag::f_special;
-		} else if (!setId) {
-			continue;
-		}
-
-		auto it = sets.find(setId);
-		if (it == sets.cend()) {
-			// We will set this flags from order lists when reading those stickers.
-			setFlags &= ~(MTPDstickerSet::Flag::f_installed_date | MTPDstickerSet_ClientFlag::f_featured);
-			it = sets.insert(setId, Stickers::Set(
-				setId,
-				setAccess,
-				setTitle,
-				setShortName,
-				0,
-				setHash,
-				MTPDstickerSet::Flags(setFlags),
-				setInstallDate,
-				setThumbnail.isNull() ? ImagePtr() : Images::Create(setThumbnail)));
-		}
-		auto &set = it.value();
-		auto inputSet = MTP_inputStickerSetID(MTP_long(set.id), MTP_long(set.access));
-		const auto fillStickers = set.stickers.isEmpty();
-
-		if (scnt < 0) { // disabled not loaded set
-			if (!set.count || fillStickers) {
-				set.count = -scnt;
-			}
-			continue;
-		}
-
-		if (fillStickers) {
-			set.stickers.reserve(scnt);
-			set.count = 0;
-		}
-
-		Serialize::Document::StickerSetInfo info(setId, setAccess, setShortName);
-		base::flat_set<DocumentId> read;
-		for (int32 j = 0; j < scnt; ++j) {
-			auto document = Serialize::Document::readStickerFromStream(stickers.version, stickers.stream, info);
-			if (!_checkStreamStatus(stickers.stream)) {
+	auto order = Stickers::Order();
+	if (version < kStickersSerializeFlatVersion) {
+		for (auto i = 0; i != count; ++i) {
+			if (!_readStickerSet(stickers.stream, stickers.version, sets)) {
 				return failed();
-			} else if (!document
-				|| !document->sticker()
-				|| read.contains(document->id)) {
-				continue;
-			}
-			read.emplace(document->id);
-			if (fillStickers) {
-				set.stickers.push_back(document);
-				if (!(set.flags & MTPDstickerSet_ClientFlag::f_special)) {
-					if (document->sticker()->set.type() != mtpc_inputStickerSetID) {
-						document->sticker()->set = inputSet;
-					}
-				}
-				++set.count;
 			}
 		}
-
-		qint32 datesCount = 0;
-		stickers.stream >> datesCount;
-		if (datesCount > 0) {
-			if (datesCount != scnt) {
-				return failed();
-			}
-			const auto fillDates = (set.id == Stickers::CloudRecentSetId)
-				&& (set.stickers.size() == datesCount);
-			if (fillDates) {
-				set.dates.clear();
-				set.dates.reserve(datesCount);
-			}
-			for (auto i = 0; i != datesCount; ++i) {
-				qint32 date = 0;
-				stickers.stream >> date;
-				if (fillDates) {
-					set.dates.push_back(TimeId(date));
-				}
-			}
+		stickers.stream >> order;
+	} else {
+		struct Entry {
+			quint64 id = 0;
+			qint32 offset = 0;
+			qint32 size = 0;
+		};
+		auto entries = std::vector<Entry>(count);
+		for (auto &entry : entries) {
+			stickers.stream >> entry.id >> entry.offset >> entry.size;
 		}
-
-		qint32 emojiCount = 0;
-		stickers.stream >> emojiCount;
-		if (!_checkStreamStatus(stickers.stream) || emojiCount < 0) {
+		stickers.stream >> order;
+		if (!_checkStreamStatus(stickers.stream)) {
 			return failed();
 		}
-		for (int32 j = 0; j < emojiCount; ++j) {
-			QString emojiString;
-			qint32 stickersCount;
-			stickers.stream >> emojiString >> stickersCount;
-			Stickers::Pack pack;
-			pack.reserve(stickersCount);
-			for (int32 k = 0; k < stickersCount; ++k) {
-				quint64 id;
-				stickers.stream >> id;
-				const auto doc = Auth().data().document(id);
-				if (!doc->sticker()) continue;
-
-				pack.push_back(doc);
+		const auto start = stickers.buffer.pos();
+		const auto available = stickers.data.size() - start;
+		for (const auto &entry : entries) {
+			if (entry.offset < 0
+				|| entry.size < 0
+				|| entry.offset + int64(entry.size) > available) {
+				return failed();
+			} else if (_stickerSetAlreadyRead(sets, entry.id)) {
+				continue;
 			}
-			if (fillStickers) {
-				if (auto emoji = Ui::Emoji::Find(emojiString)) {
-					emoji = emoji->original();
-					set.emoji.insert(emoji, pack);
-				}
+			auto bytes = QByteArray::fromRawData(
+				stickers.data.constData() + start + entry.offset,
+				entry.size);
+			QBuffer buffer(&bytes);
+			buffer.open(QIODevice::ReadOnly);
+			QDataStream stream(&buffer);
+			stream.setVersion(QDataStream::Qt_5_1);
+			if (!_readStickerSet(stream, stickers.version, sets)) {
+				return failed();
 			}
 		}
 	}
 
 	// Read orders of installed and featured stickers.
-	if (outOrder) {
-		stickers.stream >> *outOrder;
-	}
 	if (!_checkStreamStatus(stickers.stream)) {
 		return failed();
 	}
+	if (outOrder) {
+		*outOrder = std::move(order);
+	}
 
 	// Set flags that we dropped above from the order.
 	if (readingFlags && outOrder) {
@@ -3694,6 +4443,7 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 			}
 		}
 	}
+	return (version < kStickersSerializeVersion);
 }
 
 void writeInstalledStickers() {
@@ -3883,17 +4633,23 @@ void readInstalledStickers() {
 	}
 
 	Auth().data().stickerSetsRef().clear();
-	_readStickerSets(
+	const auto migrate = _readStickerSets(
 		_installedStickersKey,
 		&Auth().data().stickerSetsOrderRef(),
 		MTPDstickerSet::Flag::f_installed_date);
+	if (migrate) {
+		writeInstalledStickers();
+	}
 }
 
 void readFeaturedStickers() {
-	_readStickerSets(
+	const auto migrate = _readStickerSets(
 		_featuredStickersKey,
 		&Auth().data().featuredStickerSetsOrderRef(),
 		MTPDstickerSet::Flags() | MTPDstickerSet_ClientFlag::f_featured);
+	if (migrate) {
+		writeFeaturedStickers();
+	}
 
 	auto &sets = Auth().data().stickerSets();
 	int unreadCount = 0;
@@ -3907,18 +4663,27 @@ void readFeaturedStickers() {
 }
 
 void readRecentStickers() {
-	_readStickerSets(_recentStickersKey);
+	if (_readStickerSets(_recentStickersKey)) {
+		writeRecentStickers();
+	}
 }
 
 void readFavedStickers() {
-	_readStickerSets(_favedStickersKey);
+	if (_readStickerSets(_favedStickersKey)) {
+		writeFavedStickers();
+	}
 }
 
 void readArchivedStickers() {
 	static bool archivedStickersRead = false;
 	if (!archivedStickersRead) {
-		_readStickerSets(_archivedStickersKey, &Auth().data().archivedStickerSetsOrderRef());
+		const auto migrate = _readStickerSets(
+			_archivedStickersKey,
+			&Auth().data().archivedStickerSetsOrderRef());
 		archivedStickersRead = true;
+		if (migrate) {
+			writeArchivedStickers();
+		}
 	}
 }
 
@@ -4111,11 +4876,11 @@ void writeBackground(const Data::WallPaper &paper, const QImage &image) {
 }
 
 bool readBackground() {
-	FileReadDescriptor bg;
 	auto &backgroundKey = Window::Theme::IsNightMode()
 		? _backgroundKeyNight
 		: _backgroundKeyDay;
-	if (!readEncryptedFile(bg, backgroundKey)) {
+	auto read = TakeBackground(backgroundKey);
+	if (!read.read) {
 		if (backgroundKey) {
 			clearKey(backgroundKey);
 			backgroundKey = 0;
@@ -4123,105 +4888,31 @@ bool readBackground() {
 			_writeMap();
 		}
 		return false;
-	}
-
-	qint32 legacyId = 0;
-	bg.stream >> legacyId;
-	const auto paper = [&] {
-		if (legacyId == kWallPaperLegacySerializeTagId) {
-			quint64 id = 0;
-			quint64 accessHash = 0;
-			quint32 flags = 0;
-			QString slug;
-			bg.stream
-				>> id
-				>> accessHash
-				>> flags
-				>> slug;
-			return Data::WallPaper::FromLegacySerialized(
-				id,
-				accessHash,
-				flags,
-				slug);
-		} else if (legacyId == kWallPaperSerializeTagId) {
-			QByteArray serialized;
-			bg.stream >> serialized;
-			return Data::WallPaper::FromSerialized(serialized);
-		} else {
-			return Data::WallPaper::FromLegacyId(legacyId);
-		}
-	}();
-	if (bg.stream.status() != QDataStream::Ok || !paper) {
+	} else if (!read.paper) {
 		return false;
 	}
-
-	QByteArray imageData;
-	bg.stream >> imageData;
-	const auto isOldEmptyImage = (bg.stream.status() != QDataStream::Ok);
-	if (isOldEmptyImage
-		|| Data::IsLegacy1DefaultWallPaper(*paper)
-		|| Data::IsDefaultWallPaper(*paper)) {
+	const auto &paper = *read.paper;
+	if (read.isOldEmptyImage
+		|| Data::IsLegacy1DefaultWallPaper(paper)
+		|| Data::IsDefaultWallPaper(paper)) {
 		_backgroundCanWrite = false;
-		if (isOldEmptyImage || bg.version < 8005) {
+		if (read.isOldEmptyImage || read.version < 8005) {
 			Window::Theme::Background()->set(Data::DefaultWallPaper());
 			Window::Theme::Background()->setTile(false);
 		} else {
-			Window::Theme::Background()->set(*paper);
+			Window::Theme::Background()->set(paper);
 		}
 		_backgroundCanWrite = true;
 		return true;
-	} else if (Data::IsThemeWallPaper(*paper) && imageData.isEmpty()) {
+	} else if (Data::IsThemeWallPaper(paper) && read.imageDataEmpty) {
 		_backgroundCanWrite = false;
-		Window::Theme::Background()->set(*paper);
+		Window::Theme::Background()->set(paper);
 		_backgroundCanWrite = true;
 		return true;
 	}
-	auto image = QImage();
-	if (legacyId == kWallPaperSerializeTagId) {
-		const auto perpixel = 4;
-		auto src = bytes::make_span(imageData);
-		auto width = qint32();
-		auto height = qint32();
-		if (src.size() > 2 * sizeof(qint32)) {
-			bytes::copy(
-				bytes::object_as_span(&width),
-				src.subspan(0, sizeof(qint32)));
-			src = src.subspan(sizeof(qint32));
-			bytes::copy(
-				bytes::object_as_span(&height),
-				src.subspan(0, sizeof(qint32)));
-			src = src.subspan(sizeof(qint32));
-			if (width + height <= kWallPaperSidesLimit
-				&& src.size() == width * height * perpixel) {
-				image = QImage(
-					width,
-					height,
-					QImage::Format_ARGB32_Premultiplied);
-				if (!image.isNull()) {
-					const auto srcperline = width * perpixel;
-					const auto srcsize = srcperline * height;
-					const auto dstperline = image.bytesPerLine();
-					const auto dstsize = dstperline * height;
-					Assert(srcsize == dstsize);
-					bytes::copy(
-						bytes::make_span(image.bits(), dstsize),
-						src);
-				}
-			}
-		}
-	} else {
-		auto buffer = QBuffer(&imageData);
-		auto reader = QImageReader(&buffer);
-#ifndef OS_MAC_OLD
-		reader.setAutoTransform(true);
-#endif // OS_MAC_OLD
-		if (!reader.read(&image)) {
-			image = QImage();
-		}
-	}
-	if (!image.isNull() || paper->backgroundColor()) {
+	if (!read.image.isNull() || paper.backgroundColor()) {
 		_backgroundCanWrite = false;
-		Window::Theme::Background()->set(*paper, std::move(image));
+		Window::Theme::Background()->set(paper, std::move(read.image));
 		_backgroundCanWrite = true;
 		return true;
 	}
@@ -4355,6 +5046,8 @@ Window::Theme::Saved readThemeAfterSwitch() {
 }
 
 void readLangPack() {
+	const auto trace = Core::StartupTrace::Scope("Local::readLangPack");
+
 	FileReadDescriptor langpack;
 	if (!_langPackKey || !readEncryptedFile(langpack, _langPackKey, FileOption::Safe, SettingsKey)) {
 		return;
@@ -4831,6 +5524,35 @@ Export::Settings ReadExportSettings() {
 		: Export::Settings();
 }
 
+std::optional<int> ReadSharedMediaCount(
+		PeerId peer,
+		Storage::SharedMediaType type) {
+	_ensureSharedMediaCountsRead();
+	const auto i = _sharedMediaCounts.find({ peer, int32(type) });
+	return (i != _sharedMediaCounts.end())
+		? std::make_optional(int(i->second))
+		: std::nullopt;
+}
+
+void WriteSharedMediaCount(
+		PeerId peer,
+		Storage::SharedMediaType type,
+		int count) {
+	_ensureSharedMediaCountsRead();
+	const auto key = std::make_pair(peer, int32(type));
+	const auto i = _sharedMediaCounts.find(key);
+	if (i != _sharedMediaCounts.end() && i->second == count) {
+		return;
+	}
+	if (i == _sharedMediaCounts.end()
+		&& _sharedMediaCounts.size() >= kSharedMediaCountsLimit) {
+		// There is no order of use, just start from scratch.
+		_sharedMediaCounts.clear();
+	}
+	_sharedMediaCounts[key] = count;
+	_writeSharedMediaCounts();
+}
+
 void writeSavedPeers() {
 	if (!_working()) return;
 
@@ -4929,6 +5651,16 @@ void removeSavedPeer(PeerData *peer) {
 	}
 }
 
+void readReportSpamStatuses() {
+	if (_reportSpamStatusesRead || !_working()) {
+		return;
+	}
+	_reportSpamStatusesRead = true;
+	if (_reportSpamStatusesKey) {
+		_readReportSpamStatuses();
+	}
+}
+
 void writeReportSpamStatuses() {
 	_writeReportSpamStatuses();
 }
@@ -5055,6 +5787,7 @@ bool ClearManager::addTask(int task) {
 	if (!data->tasks.isEmpty() && (data->tasks.at(0) == ClearManagerAll)) return true;
 	if (task == ClearManagerAll) {
 		data->tasks.clear();
+		_mapJournal.close();
 		if (!_draftsMap.isEmpty()) {
 			_draftsMap.clear();
 			_mapChanged = true;
@@ -5091,6 +5824,10 @@ bool ClearManager::addTask(int task) {
 			_savedPeersKey = 0;
 			_mapChanged = true;
 		}
+		if (_sharedMediaCountsKey) {
+			_sharedMediaCountsKey = 0;
+			_mapChanged = true;
+		}
 		_writeMap();
 	} else {
 		for (int32 i = 0, l = data->tasks.size(); i < l; ++i) {
@@ -5134,6 +5871,7 @@ ClearManager::~ClearManager() {
 }
 
 void ClearManager::onStart() {
+	Writer().flush();
 	while (true) {
 		int task = 0;
 		bool result = false;
@@ -5156,7 +5894,9 @@ void ClearManager::onStart() {
 					if (!QDir(di.filePath()).removeRecursively()) result = false;
 				} else {
 					QString path = di.filePath();
-					if (!path.endsWith(qstr("map0")) && !path.endsWith(qstr("map1"))) {
+					if (!path.endsWith(qstr("map0"))
+						&& !path.endsWith(qstr("map1"))
+						&& !path.endsWith(qstr("map_journal"))) {
 						if (!QFile::remove(di.filePath())) result = false;
 					}
 				}
@@ -5194,6 +5934,8 @@ Manager::Manager() {
 	connect(&_mapWriteTimer, SIGNAL(timeout()), this, SLOT(mapWriteTimeout()));
 	_locationsWriteTimer.setSingleShot(true);
 	connect(&_locationsWriteTimer, SIGNAL(timeout()), this, SLOT(locationsWriteTimeout()));
+	_sharedMediaCountsWriteTimer.setSingleShot(true);
+	connect(&_sharedMediaCountsWriteTimer, SIGNAL(timeout()), this, SLOT(sharedMediaCountsWriteTimeout()));
 }
 
 void Manager::writeMap(bool fast) {
@@ -5220,6 +5962,18 @@ void Manager::writingLocations() {
 	_locationsWriteTimer.stop();
 }
 
+void Manager::writeSharedMediaCounts(bool fast) {
+	if (!_sharedMediaCountsWriteTimer.isActive() || fast) {
+		_sharedMediaCountsWriteTimer.start(fast ? 1 : kWriteMapTimeout);
+	} else if (_sharedMediaCountsWriteTimer.remainingTime() <= 0) {
+		sharedMediaCountsWriteTimeout();
+	}
+}
+
+void Manager::writingSharedMediaCounts() {
+	_sharedMediaCountsWriteTimer.stop();
+}
+
 void Manager::mapWriteTimeout() {
 	_writeMap(WriteMapWhen::Now);
 }
@@ -5228,6 +5982,10 @@ void Manager::locationsWriteTimeout() {
 	_writeLocations(WriteMapWhen::Now);
 }
 
+void Manager::sharedMediaCountsWriteTimeout() {
+	_writeSharedMediaCounts(WriteMapWhen::Now);
+}
+
 void Manager::finish() {
 	if (_mapWriteTimer.isActive()) {
 		mapWriteTimeout();
@@ -5235,6 +5993,9 @@ void Manager::finish() {
 	if (_locationsWriteTimer.isActive()) {
 		locationsWriteTimeout();
 	}
+	if (_sharedMediaCountsWriteTimer.isActive()) {
+		sharedMediaCountsWriteTimeout();
+	}
 }
 
 } // namespace internal
@@ -21,6 +21,7 @@ struct Language;
 
 namespace Storage {
 class EncryptionKey;
+enum class SharedMediaType : signed char;
 } // namespace Storage
 
 namespace Window {
@@ -48,6 +49,9 @@ QString readAutoupdatePrefix();
 
 void reset();
 
+// Derives the passcode key in the background, so that the following
+// checkPasscode() or readMap() with the same passcode don't block.
+void preparePasscodeKey(const QByteArray &passcode, Fn<void()> ready);
 bool checkPasscode(const QByteArray &passcode);
 void setPasscode(const QByteArray &passcode);
 
@@ -167,10 +171,20 @@ void saveRecentSearchHashtags(const QString &text);
 void WriteExportSettings(const Export::Settings &settings);
 Export::Settings ReadExportSettings();
 
+// Last known shared media counts, shown until the server answers.
+std::optional<int> ReadSharedMediaCount(
+	PeerId peer,
+	Storage::SharedMediaType type);
+void WriteSharedMediaCount(
+	PeerId peer,
+	Storage::SharedMediaType type,
+	int count);
+
 void addSavedPeer(PeerData *peer, const QDateTime &position);
 void removeSavedPeer(PeerData *peer);
 void readSavedPeers();
 
+void readReportSpamStatuses();
 void writeReportSpamStatuses();
 
 void writeSelf();
@@ -194,15 +208,19 @@ public:
 	void writingMap();
 	void writeLocations(bool fast);
 	void writingLocations();
+	void writeSharedMediaCounts(bool fast);
+	void writingSharedMediaCounts();
 	void finish();
 
 public slots:
 	void mapWriteTimeout();
 	void locationsWriteTimeout();
+	void sharedMediaCountsWriteTimeout();
 
 private:
 	QTimer _mapWriteTimer;
 	QTimer _locationsWriteTimer;
+	QTimer _sharedMediaCountsWriteTimer;
 
 };
 
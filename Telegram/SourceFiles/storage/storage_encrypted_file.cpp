@@ -74,6 +74,7 @@ File::Result File::open(
 File::Result File::attemptOpen(Mode mode, const EncryptionKey &key) {
 	switch (mode) {
 	case Mode::Read: return attemptOpenForRead(key);
+	case Mode::ReadMapped: return attemptOpenForReadMapped(key);
 	case Mode::ReadAppend: return attemptOpenForReadAppend(key);
 	case Mode::Write: return attemptOpenForWrite(key);
 	}
@@ -87,6 +88,21 @@ File::Result File::attemptOpenForRead(const EncryptionKey &key) {
 	return readHeader(key);
 }
 
+File::Result File::attemptOpenForReadMapped(const EncryptionKey &key) {
+	if (!_data.open(QIODevice::ReadOnly)) {
+		return Result::Failed;
+	}
+
+	// If the mapping fails we fall back to the buffered reads.
+	const auto size = _data.size();
+	if (const auto mapped = size ? _data.map(0, size) : nullptr) {
+		_mapped = bytes::make_span(
+			reinterpret_cast<const bytes::type*>(mapped),
+			size);
+	}
+	return readHeader(key);
+}
+
 File::Result File::attemptOpenForReadAppend(const EncryptionKey &key) {
 	if (!_lock.lock(_data, QIODevice::ReadWrite)) {
 		return Result::LockFailed;
@@ -139,7 +155,7 @@ File::Result File::readHeader(const EncryptionKey &key) {
 	Expects(!_state.has_value());
 	Expects(_data.pos() == 0);
 
-	if (!_data.seek(FileLock::kSkipBytes)) {
+	if (!seekPlain(FileLock::kSkipBytes)) {
 		return Result::Failed;
 	}
 	auto header = BasicHeader();
@@ -170,9 +186,50 @@ File::Result File::readHeader(const EncryptionKey &key) {
 }
 
 size_type File::readPlain(bytes::span bytes) {
+	if (!_mapped.empty()) {
+		const auto available = std::max(
+			int64(_mapped.size()) - _mappedPosition,
+			int64(0));
+		const auto count = std::min(int64(bytes.size()), available);
+		bytes::copy(bytes, _mapped.subspan(_mappedPosition, count));
+		_mappedPosition += count;
+		return count;
+	}
 	return _data.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
 }
 
+size_type File::readMapped(bytes::span bytes) {
+	Expects(!_mapped.empty());
+	Expects(_state.has_value());
+
+	const auto available = std::max(
+		int64(_mapped.size()) - _mappedPosition,
+		int64(0));
+	const auto count = std::min(
+		int64(bytes.size()),
+		available - (available % kBlockSize));
+	if (count > 0) {
+		_state->decrypt(
+			_mapped.subspan(_mappedPosition, count),
+			bytes,
+			_encryptionOffset);
+		_encryptionOffset += count;
+		_mappedPosition += count;
+	}
+	return count;
+}
+
+bool File::seekPlain(int64 position) {
+	if (!_mapped.empty()) {
+		if (position < 0 || position > _mapped.size()) {
+			return false;
+		}
+		_mappedPosition = position;
+		return true;
+	}
+	return _data.seek(position);
+}
+
 size_type File::writePlain(bytes::const_span bytes) {
 	return _data.write(
 		reinterpret_cast<const char*>(bytes.data()),
@@ -196,6 +253,9 @@ void File::encrypt(bytes::span bytes) {
 size_type File::read(bytes::span bytes) {
 	Expects(bytes.size() % kBlockSize == 0);
 
+	if (!_mapped.empty()) {
+		return readMapped(bytes);
+	}
 	auto count = readPlain(bytes);
 	if (const auto back = -(count % kBlockSize)) {
 		if (!_data.seek(_data.pos() + back)) {
@@ -291,6 +351,8 @@ bool File::flush() {
 
 void File::close() {
 	_lock.unlock();
+	_mapped = bytes::const_span();
+	_mappedPosition = 0;
 	_data.close();
 	_data.setFileName(QString());
 	_dataSize = _encryptionOffset = 0;
@@ -315,7 +377,7 @@ bool File::seek(int64 offset) {
 	const auto realOffset = sizeof(BasicHeader) + offset;
 	if (offset < 0 || offset > _dataSize) {
 		return false;
-	} else if (!_data.seek(FileLock::kSkipBytes + realOffset)) {
+	} else if (!seekPlain(FileLock::kSkipBytes + realOffset)) {
 		return false;
 	}
 	_encryptionOffset = realOffset - kSaltSize;
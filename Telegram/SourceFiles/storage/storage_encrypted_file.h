@@ -17,6 +17,7 @@ class File {
 public:
 	enum class Mode {
 		Read,
+		ReadMapped, // Decrypts straight from a read-only mapping.
 		ReadAppend,
 		Write,
 	};
@@ -48,6 +49,7 @@ public:
 private:
 	Result attemptOpen(Mode mode, const EncryptionKey &key);
 	Result attemptOpenForRead(const EncryptionKey &key);
+	Result attemptOpenForReadMapped(const EncryptionKey &key);
 	Result attemptOpenForReadAppend(const EncryptionKey &key);
 	Result attemptOpenForWrite(const EncryptionKey &key);
 
@@ -55,12 +57,16 @@ private:
 	Result readHeader(const EncryptionKey &key);
 
 	size_type readPlain(bytes::span bytes);
+	size_type readMapped(bytes::span bytes);
 	size_type writePlain(bytes::const_span bytes);
+	bool seekPlain(int64 position);
 	void decrypt(bytes::span bytes);
 	void encrypt(bytes::span bytes);
 	void decryptBack(bytes::span bytes);
 
 	QFile _data;
+	bytes::const_span _mapped;
+	int64 _mappedPosition = 0;
 	FileLock _lock;
 	int64 _encryptionOffset = 0;
 	int64 _dataSize = 0;
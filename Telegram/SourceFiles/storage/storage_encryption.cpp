@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "storage/storage_encryption.h"
 
 #include "base/openssl_help.h"
+#include "base/openssl_aes.h"
 
 namespace Storage {
 
@@ -18,31 +19,27 @@ CtrState::CtrState(bytes::const_span key, bytes::const_span iv) {
 	bytes::copy(_iv, iv);
 }
 
-template <typename Method>
-void CtrState::process(bytes::span data, int64 offset, Method method) {
-	Expects((data.size() % kBlockSize) == 0);
+void CtrState::process(
+		bytes::const_span from,
+		bytes::span to,
+		int64 offset) {
+	Expects((from.size() % kBlockSize) == 0);
+	Expects(to.size() >= from.size());
 	Expects((offset % kBlockSize) == 0);
 
-	AES_KEY aes;
-	AES_set_encrypt_key(
-		reinterpret_cast<const uchar*>(_key.data()),
-		_key.size() * CHAR_BIT,
-		&aes);
-
-	unsigned char ecountBuf[kBlockSize] = { 0 };
-	unsigned int offsetInBlock = 0;
+	uchar ecountBuf[kBlockSize] = { 0 };
+	uint32 offsetInBlock = 0;
 	const auto blockIndex = offset / kBlockSize;
 	auto iv = incrementedIv(blockIndex);
 
-	CRYPTO_ctr128_encrypt(
-		reinterpret_cast<const uchar*>(data.data()),
-		reinterpret_cast<uchar*>(data.data()),
-		data.size(),
-		&aes,
-		reinterpret_cast<unsigned char*>(iv.data()),
+	openssl::AesCtrEncrypt(
+		from.data(),
+		to.data(),
+		from.size(),
+		_key.data(),
+		reinterpret_cast<uchar*>(iv.data()),
 		ecountBuf,
-		&offsetInBlock,
-		(block128_f)method);
+		&offsetInBlock);
 }
 
 auto CtrState::incrementedIv(int64 blockIndex)
@@ -65,11 +62,18 @@ auto CtrState::incrementedIv(int64 blockIndex)
 }
 
 void CtrState::encrypt(bytes::span data, int64 offset) {
-	return process(data, offset, AES_encrypt);
+	return process(data, data, offset);
 }
 
 void CtrState::decrypt(bytes::span data, int64 offset) {
-	return process(data, offset, AES_encrypt);
+	return process(data, data, offset);
+}
+
+void CtrState::decrypt(
+		bytes::const_span from,
+		bytes::span to,
+		int64 offset) {
+	return process(from, to, offset);
 }
 
 EncryptionKey::EncryptionKey(bytes::vector &&data)
@@ -22,15 +22,13 @@ public:
 
 	void encrypt(bytes::span data, int64 offset);
 	void decrypt(bytes::span data, int64 offset);
+	void decrypt(bytes::const_span from, bytes::span to, int64 offset);
 
 private:
-	template <typename Method>
-	void process(bytes::span data, int64 offset, Method method);
+	void process(bytes::const_span from, bytes::span to, int64 offset);
 
 	bytes::array<kIvSize> incrementedIv(int64 blockIndex);
 
-	static constexpr auto EcountSize = kBlockSize;
-
 	bytes::array<kKeySize> _key;
 	bytes::array<kIvSize> _iv;
 
@@ -41,6 +41,16 @@ bool ValidVideoForAlbum(const FileMediaInformation::Video &video) {
 	return ValidateThumbDimensions(width, height);
 }
 
+// Checks the dimensions in the image header without decoding the pixels.
+bool ValidImageHeaderForAlbum(const QString &path, const QString &mime) {
+	if (!mime.startsWith(qstr("image/"))) {
+		return true;
+	}
+	const auto size = QImageReader(path).size();
+	return !size.isValid()
+		|| ValidateThumbDimensions(size.width(), size.height());
+}
+
 QSize PrepareShownDimensions(const QImage &preview) {
 	constexpr auto kMaxWidth = 1280;
 	constexpr auto kMaxHeight = 1280;
@@ -60,6 +70,10 @@ bool PrepareAlbumMediaIsWaiting(
 		const auto guard = gsl::finally([&] { semaphore.release(); });
 		if (!file.path.isEmpty()) {
 			file.mime = Core::MimeTypeForFile(QFileInfo(file.path)).name();
+			if (!ValidImageHeaderForAlbum(file.path, file.mime)) {
+				// Not decoded here, FileLoadTask reads it when sending.
+				return;
+			}
 			file.information = FileLoadTask::ReadMediaInformation(
 				file.path,
 				QByteArray(),
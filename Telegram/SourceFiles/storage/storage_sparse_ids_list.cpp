@@ -212,8 +212,9 @@ SparseIdsListResult SparseIdsList::queryFromSlice(
 	auto haveEqualOrAfter = int(slice.messages.end() - position);
 	auto before = qMin(haveBefore, query.limitBefore);
 	auto equalOrAfter = qMin(haveEqualOrAfter, query.limitAfter + 1);
-	auto ids = std::vector<MsgId>(position - before, position + equalOrAfter);
-	result.messageIds.merge(ids.begin(), ids.end());
+	result.messageIds = base::flat_set<MsgId>(
+		position - before,
+		position + equalOrAfter);
 	if (slice.range.from == 0) {
 		result.skippedBefore = haveBefore - before;
 	}
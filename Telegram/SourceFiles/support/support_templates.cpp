@@ -271,6 +271,7 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 	using Id = TemplatesIndex::Id;
 	using Term = TemplatesIndex::Term;
 
+	auto result = TemplatesIndex();
 	auto uniqueFirst = std::map<QChar, base::flat_set<Id>>();
 	auto uniqueFull = std::map<Id, base::flat_set<Term>>();
 	const auto pushString = [&](
@@ -288,13 +289,13 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 			const auto id = std::make_pair(path, normalized);
 			for (const auto &key : question.normalizedKeys) {
 				pushString(id, key, kWeightStep * kWeightStep);
+				result.keys.emplace(key, id);
 			}
 			pushString(id, question.question, kWeightStep);
 			pushString(id, question.value, 1);
 		}
 	}
 
-	auto result = TemplatesIndex();
 	for (const auto &[ch, unique] : uniqueFirst) {
 		result.first.emplace(ch, unique | ranges::to_vector);
 	}
@@ -318,6 +319,16 @@ void ReplaceFileIndex(
 	for (auto &[id, list] : source.full) {
 		result.full.emplace(id, std::move(list));
 	}
+	for (auto i = begin(result.keys); i != end(result.keys);) {
+		if (i->second.first == path) {
+			i = result.keys.erase(i);
+		} else {
+			++i;
+		}
+	}
+	for (auto &[key, id] : source.keys) {
+		result.keys.emplace(key, std::move(id));
+	}
 
 	using Id = TemplatesIndex::Id;
 	for (auto &[ch, list] : result.first) {
@@ -339,6 +350,17 @@ void ReplaceFileIndex(
 	}
 }
 
+const TemplatesQuestion *FindQuestion(
+		const TemplatesData &data,
+		const TemplatesIndex::Id &id) {
+	const auto file = data.files.find(id.first);
+	if (file == end(data.files)) {
+		return nullptr;
+	}
+	const auto i = file->second.questions.find(id.second);
+	return (i != end(file->second.questions)) ? &i->second : nullptr;
+}
+
 void MoveKeys(TemplatesFile &to, const TemplatesFile &from) {
 	const auto &existing = from.questions;
 	for (auto &[normalized, question] : to.questions) {
@@ -619,18 +641,15 @@ auto Templates::matchExact(QString query) const
 		return {};
 	}
 
-	query = NormalizeKey(query);
-
-	for (const auto &[path, file] : _data.files) {
-		for (const auto &[normalized, question] : file.questions) {
-			for (const auto &key : question.normalizedKeys) {
-				if (key == query) {
-					return QuestionByKey{ question, key };
-				}
-			}
-		}
+	const auto i = _index.keys.find(NormalizeKey(query));
+	if (i == end(_index.keys)) {
+		return {};
 	}
-	return {};
+	const auto question = FindQuestion(_data, i->second);
+	if (!question) {
+		return {};
+	}
+	return QuestionByKey{ *question, i->first };
 }
 
 auto Templates::matchFromEnd(QString query) const
@@ -639,26 +658,18 @@ auto Templates::matchFromEnd(QString query) const
 		query = query.mid(query.size() - _maxKeyLength);
 	}
 
+	// Check suffixes from the longest one, so the longest key wins.
 	const auto size = query.size();
-	auto queries = std::vector<QString>();
-	queries.reserve(size);
-	for (auto i = 0; i != size; ++i) {
-		queries.push_back(NormalizeKey(query.mid(size - i - 1)));
-	}
-
-	auto result = std::optional<QuestionByKey>();
-	for (const auto &[path, file] : _data.files) {
-		for (const auto &[normalized, question] : file.questions) {
-			for (const auto &key : question.normalizedKeys) {
-				if (key.size() <= queries.size()
-					&& queries[key.size() - 1] == key
-					&& (!result || result->key.size() <= key.size())) {
-					result = QuestionByKey{ question, key };
-				}
-			}
+	for (auto length = size; length > 0; --length) {
+		const auto i = _index.keys.find(
+			NormalizeKey(query.mid(size - length)));
+		if (i == end(_index.keys)) {
+			continue;
+		} else if (const auto question = FindQuestion(_data, i->second)) {
+			return QuestionByKey{ *question, i->first };
 		}
 	}
-	return result;
+	return {};
 }
 
 Templates::~Templates() = default;
@@ -35,6 +35,7 @@ struct TemplatesIndex {
 
 	std::map<QChar, std::vector<Id>> first;
 	std::map<Id, std::vector<Term>> full;
+	std::map<QString, Id> keys; // normalized key
 };
 
 } // namespace details
@@ -7,6 +7,7 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "animation.h"
 
 #include "media/clip/media_clip_reader.h"
+#include "ui/effects/animations.h"
 
 namespace Media {
 namespace Clip {
@@ -154,11 +155,12 @@ void BasicAnimation::stop() {
 	_manager->stop(this);
 }
 
-AnimationManager::AnimationManager() : _timer(this) {
-	_timer.setSingleShot(false);
-	connect(&_timer, &QTimer::timeout, this, &AnimationManager::step);
+AnimationManager::AnimationManager()
+: _frame(std::make_unique<Ui::Animations::Basic>([=] { step(); })) {
 }
 
+AnimationManager::~AnimationManager() = default;
+
 void AnimationManager::start(BasicAnimation *obj) {
 	if (_iterating) {
 		_starting.insert(obj);
@@ -167,7 +169,7 @@ void AnimationManager::start(BasicAnimation *obj) {
 		}
 	} else {
 		if (_objects.empty()) {
-			_timer.start(AnimationTimerDelta);
+			_frame->start();
 		}
 		_objects.insert(obj);
 	}
@@ -184,7 +186,7 @@ void AnimationManager::stop(BasicAnimation *obj) {
 		if (i != _objects.cend()) {
 			_objects.erase(i);
 			if (_objects.empty()) {
-				_timer.stop();
+				_frame->stop();
 			}
 		}
 	}
@@ -221,7 +223,7 @@ void AnimationManager::step() {
 		_stopping.clear();
 	}
 	if (_objects.empty()) {
-		_timer.stop();
+		_frame->stop();
 	}
 }
 
@@ -11,6 +11,12 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "base/binary_guard.h"
 #include "base/flat_set.h"
 
+namespace Ui {
+namespace Animations {
+class Basic;
+} // namespace Animations
+} // namespace Ui
+
 namespace Media {
 namespace Clip {
 
@@ -703,6 +709,7 @@ private:
 class AnimationManager : public QObject {
 public:
 	AnimationManager();
+	~AnimationManager();
 
 	void start(BasicAnimation *obj);
 	void stop(BasicAnimation *obj);
@@ -717,7 +724,9 @@ private:
 		qint32 notification);
 
 	base::flat_set<BasicAnimation*> _objects, _starting, _stopping;
-	QTimer _timer;
+
+	// Legacy animations are stepped in the frames of Ui::Animations.
+	std::unique_ptr<Ui::Animations::Basic> _frame;
 	bool _iterating = false;
 
 };
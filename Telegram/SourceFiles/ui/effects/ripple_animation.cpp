@@ -7,6 +7,43 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 #include "ui/effects/ripple_animation.h"
 
 namespace Ui {
+namespace {
+
+// Lists and buttons prepare the same masks each time a ripple starts.
+constexpr auto kMaxCachedMasks = 64;
+
+enum class MaskType {
+	Rect,
+	RoundRect,
+	Ellipse,
+};
+
+template <typename Generator>
+QImage CachedMask(
+		MaskType type,
+		QSize size,
+		int radius,
+		Generator &&generator) {
+	using Key = std::tuple<int, int, int, int, int>;
+	static auto Cache = base::flat_map<Key, QImage>();
+
+	const auto key = Key(
+		int(type),
+		size.width(),
+		size.height(),
+		radius,
+		cIntRetinaFactor());
+	const auto i = Cache.find(key);
+	if (i != Cache.end()) {
+		return i->second;
+	}
+	if (Cache.size() >= kMaxCachedMasks) {
+		Cache.clear();
+	}
+	return Cache.emplace(key, generator()).first->second;
+}
+
+} // namespace
 
 class RippleAnimation::Ripple {
 public:
@@ -210,18 +247,24 @@ QImage RippleAnimation::maskByDrawer(QSize size, bool filled, Fn<void(QPainter &
 }
 
 QImage RippleAnimation::rectMask(QSize size) {
-	return maskByDrawer(size, true, Fn<void(QPainter&)>());
+	return CachedMask(MaskType::Rect, size, 0, [&] {
+		return maskByDrawer(size, true, Fn<void(QPainter&)>());
+	});
 }
 
 QImage RippleAnimation::roundRectMask(QSize size, int radius) {
-	return maskByDrawer(size, false, [size, radius](QPainter &p) {
-		p.drawRoundedRect(0, 0, size.width(), size.height(), radius, radius);
+	return CachedMask(MaskType::RoundRect, size, radius, [&] {
+		return maskByDrawer(size, false, [size, radius](QPainter &p) {
+			p.drawRoundedRect(0, 0, size.width(), size.height(), radius, radius);
+		});
 	});
 }
 
 QImage RippleAnimation::ellipseMask(QSize size) {
-	return maskByDrawer(size, false, [size](QPainter &p) {
-		p.drawEllipse(0, 0, size.width(), size.height());
+	return CachedMask(MaskType::Ellipse, size, 0, [&] {
+		return maskByDrawer(size, false, [size](QPainter &p) {
+			p.drawEllipse(0, 0, size.width(), size.height());
+		});
 	});
 }
 
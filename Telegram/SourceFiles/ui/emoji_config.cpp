@@ -50,9 +50,12 @@ private:
 	void generateCache();
 	void checkUniversalImages();
 	void pushSprite(QImage &&data);
+	bool ensureSpriteLoaded(int index);
 
 	int _id = 0;
 	int _size = 0;
+
+	// Sprites found in the disk cache stay null until they are drawn.
 	std::vector<QPixmap> _sprites;
 	base::binary_guard _generating;
 
@@ -221,17 +224,37 @@ void SaveToFile(int id, const QImage &image, int size, int index) {
 	}
 }
 
-QImage LoadFromFile(int id, int size, int index) {
+// Opens the cache file and checks its header, leaving the position
+// at the beginning of the sprite pixels.
+bool OpenCacheFile(QFile &f, int id, int size, int index) {
 	const auto rows = RowsCount(index);
 	const auto width = kImagesPerRow * size;
 	const auto height = rows * size;
 	const auto fileSize = 4 * sizeof(uint32)
 		+ (width * height * 4)
 		+ openssl::kSha256Size;
-	QFile f(CacheFilePath(size, index));
+	f.setFileName(CacheFilePath(size, index));
 	if (!f.exists()
 		|| f.size() != fileSize
 		|| !f.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	uint32 header[4] = { 0 };
+	const auto data = bytes::make_span(header);
+	return (f.read(reinterpret_cast<char*>(data.data()), data.size())
+			== data.size())
+		&& (header[0] == ComputeVersion(id))
+		&& (header[1] == size)
+		&& (header[2] == width)
+		&& (header[3] == height);
+}
+
+QImage LoadFromFile(int id, int size, int index) {
+	const auto rows = RowsCount(index);
+	const auto width = kImagesPerRow * size;
+	const auto height = rows * size;
+	QFile f;
+	if (!OpenCacheFile(f, id, size, index)) {
 		return QImage();
 	}
 	const auto read = [&](bytes::span data) {
@@ -240,14 +263,12 @@ QImage LoadFromFile(int id, int size, int index) {
 			data.size()
 		) == data.size();
 	};
-	uint32 header[4] = { 0 };
-	if (!read(bytes::make_span(header))
-		|| header[0] != ComputeVersion(id)
-		|| header[1] != size
-		|| header[2] != width
-		|| header[3] != height) {
-		return QImage();
-	}
+	const uint32 header[4] = {
+		ComputeVersion(id),
+		uint32(size),
+		uint32(width),
+		uint32(height),
+	};
 	auto result = QImage(
 		width,
 		height,
@@ -900,7 +921,7 @@ void Instance::draw(QPainter &p, EmojiPtr emoji, int x, int y) {
 		generateCache();
 	}
 	const auto sprite = emoji->sprite();
-	if (sprite >= _sprites.size()) {
+	if (sprite >= _sprites.size() || !ensureSpriteLoaded(sprite)) {
 		Assert(Universal != nullptr);
 		Universal->draw(p, emoji, _size, x, y);
 		return;
@@ -913,14 +934,32 @@ void Instance::draw(QPainter &p, EmojiPtr emoji, int x, int y) {
 
 void Instance::readCache() {
 	for (auto i = 0; i != SpritesCount; ++i) {
-		auto image = LoadFromFile(_id, _size, i);
-		if (image.isNull()) {
+		QFile f;
+		if (!OpenCacheFile(f, _id, _size, i)) {
 			return;
 		}
-		pushSprite(std::move(image));
+		_sprites.emplace_back();
 	}
 }
 
+bool Instance::ensureSpriteLoaded(int index) {
+	Expects(index < _sprites.size());
+
+	if (!_sprites[index].isNull()) {
+		return true;
+	}
+	auto image = LoadFromFile(_id, _size, index);
+	if (image.isNull()) {
+		// The cache file went bad after readCache(), generate it again.
+		_sprites.resize(index);
+		generateCache();
+		return false;
+	}
+	_sprites[index] = App::pixmapFromImageInPlace(std::move(image));
+	_sprites[index].setDevicePixelRatio(cRetinaFactor());
+	return true;
+}
+
 void Instance::checkUniversalImages() {
 	Expects(Universal != nullptr);
 
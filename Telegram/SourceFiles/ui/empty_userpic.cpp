@@ -8,9 +8,28 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 
 #include "data/data_peer.h"
 #include "ui/emoji_config.h"
+#include "data/data_abstract_structure.h"
 #include "styles/style_history.h"
 
 namespace Ui {
+namespace {
+
+// Lists paint the same few userpic sizes, so this is enough for
+// several screens of contacts or members without photos.
+constexpr auto kCachedUserpicsLimit = 512;
+
+// Colors are part of the key, so a palette change just stops hitting
+// the old frames until they're cleared together with the whole cache.
+using CachedUserpicKey = std::tuple<QString, QRgb, QRgb, int, int>;
+
+class CachedUserpicsData : public Data::AbstractStructure {
+public:
+	base::flat_map<CachedUserpicKey, QPixmap> frames;
+
+};
+Data::GlobalStructurePointer<CachedUserpicsData> CachedUserpics;
+
+} // namespace
 
 EmptyUserpic::EmptyUserpic(const style::color &color, const QString &name)
 : _color(color) {
@@ -42,27 +61,82 @@ void EmptyUserpic::paint(
 	p.drawText(QRect(x, y, size, size), _string, QTextOption(style::al_center));
 }
 
+void EmptyUserpic::paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const {
+	CachedUserpics.createIfNull();
+	auto &frames = CachedUserpics->frames;
+	const auto key = CachedUserpicKey(
+		_string,
+		_color->c.rgba(),
+		st::historyPeerUserpicFg->c.rgba(),
+		size,
+		int(shape));
+	auto i = frames.find(key);
+	if (i == end(frames)) {
+		if (frames.size() >= kCachedUserpicsLimit) {
+			frames.clear();
+		}
+		i = frames.emplace(key, prepareCached(size, shape)).first;
+	}
+	x = rtl() ? (outerWidth - x - size) : x;
+	p.drawPixmap(x, y, i->second);
+}
+
+QPixmap EmptyUserpic::prepareCached(int size, Shape shape) const {
+	auto result = QImage(
+		QSize(size, size) * cIntRetinaFactor(),
+		QImage::Format_ARGB32_Premultiplied);
+	result.setDevicePixelRatio(cRetinaFactor());
+	result.fill(Qt::transparent);
+	{
+		Painter p(&result);
+		switch (shape) {
+		case Shape::Circle:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.drawEllipse(0, 0, size, size);
+			});
+			break;
+		case Shape::Rounded:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.drawRoundedRect(
+					0,
+					0,
+					size,
+					size,
+					st::buttonRadius,
+					st::buttonRadius);
+			});
+			break;
+		case Shape::Square:
+			paint(p, 0, 0, size, size, [&p, size] {
+				p.fillRect(0, 0, size, size, p.brush());
+			});
+			break;
+		}
+	}
+	return App::pixmapFromImageInPlace(std::move(result));
+}
+
 void EmptyUserpic::paint(
 		Painter &p,
 		int x,
 		int y,
 		int outerWidth,
 		int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawEllipse(x, y, size, size);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Circle);
 }
 
 void EmptyUserpic::paintRounded(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.drawRoundedRect(x, y, size, size, st::buttonRadius, st::buttonRadius);
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Rounded);
 }
 
 void EmptyUserpic::paintSquare(Painter &p, int x, int y, int outerWidth, int size) const {
-	paint(p, x, y, outerWidth, size, [&p, x, y, size] {
-		p.fillRect(x, y, size, size, p.brush());
-	});
+	paintCached(p, x, y, outerWidth, size, Shape::Square);
 }
 
 void EmptyUserpic::PaintSavedMessages(
@@ -172,7 +246,9 @@ QPixmap EmptyUserpic::generate(int size) {
 	result.fill(Qt::transparent);
 	{
 		Painter p(&result);
-		paint(p, 0, 0, size, size);
+		paint(p, 0, 0, size, size, [&p, size] {
+			p.drawEllipse(0, 0, size, size);
+		});
 	}
 	return App::pixmapFromImageInPlace(std::move(result));
 }
@@ -51,6 +51,12 @@ public:
 	~EmptyUserpic();
 
 private:
+	enum class Shape {
+		Circle,
+		Rounded,
+		Square,
+	};
+
 	template <typename Callback>
 	void paint(
 		Painter &p,
@@ -59,6 +65,14 @@ private:
 		int outerWidth,
 		int size,
 		Callback paintBackground) const;
+	void paintCached(
+		Painter &p,
+		int x,
+		int y,
+		int outerWidth,
+		int size,
+		Shape shape) const;
+	QPixmap prepareCached(int size, Shape shape) const;
 
 	void fillString(const QString &name);
 
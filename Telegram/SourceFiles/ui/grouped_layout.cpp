@@ -9,6 +9,8 @@ https://github.com/bettergram/bettergram/blob/master/LEGAL
 namespace Ui {
 namespace {
 
+constexpr auto kLayoutCacheLimit = 256;
+
 int Round(float64 value) {
 	return int(std::round(value));
 }
@@ -571,7 +573,31 @@ std::vector<GroupMediaLayout> LayoutMediaGroup(
 		int maxWidth,
 		int minWidth,
 		int spacing) {
-	return Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	// Layouts are requested again each time a history view is recreated,
+	// so remember results for recently seen albums on the main thread.
+	static auto Cache = std::map<
+		std::vector<int>,
+		std::vector<GroupMediaLayout>>();
+
+	auto key = std::vector<int>();
+	key.reserve(3 + sizes.size() * 2);
+	key.push_back(maxWidth);
+	key.push_back(minWidth);
+	key.push_back(spacing);
+	for (const auto &size : sizes) {
+		key.push_back(size.width());
+		key.push_back(size.height());
+	}
+	const auto i = Cache.find(key);
+	if (i != end(Cache)) {
+		return i->second;
+	}
+	auto result = Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	if (Cache.size() >= kLayoutCacheLimit) {
+		Cache.clear();
+	}
+	Cache.emplace(std::move(key), result);
+	return result;
 }
 
 RectParts GetCornersFromSides(RectParts sides) {
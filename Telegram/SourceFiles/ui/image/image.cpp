@@ -21,6 +21,107 @@ namespace {
 // After 128 MB of unpacked images we try to clear some memory.
 constexpr auto kMemoryForCache = 128 * 1024 * 1024;
 
+// Prepared pixmaps of all the images are limited separately.
+constexpr auto kMemoryForSizesCache = 96 * 1024 * 1024;
+
+struct SizeKey {
+	const Image *image = nullptr;
+	uint64 key = 0;
+};
+
+inline bool operator==(const SizeKey &a, const SizeKey &b) {
+	return (a.image == b.image) && (a.key == b.key);
+}
+
+} // namespace
+} // namespace Images
+
+namespace std {
+
+template <>
+struct hash<Images::SizeKey> {
+	size_t operator()(const Images::SizeKey &value) const {
+		return hash<const Image*>()(value.image)
+			^ (hash<uint64>()(value.key) << 1);
+	}
+};
+
+} // namespace std
+
+namespace Images {
+
+class SizesCache final {
+public:
+	explicit SizesCache(int64 limit);
+
+	void hit(const Image *image, uint64 key);
+	void added(const Image *image, uint64 key, int64 usage);
+	void removed(const Image *image, uint64 key, int64 usage);
+
+	[[nodiscard]] SizesCacheStats stats() const;
+
+private:
+	void check();
+
+	base::last_used_cache<SizeKey> _cache;
+	SingleQueuedInvokation _check;
+	int64 _limit = 0;
+	SizesCacheStats _stats;
+
+};
+
+SizesCache::SizesCache(int64 limit)
+: _check([=] { check(); })
+, _limit(limit) {
+}
+
+void SizesCache::hit(const Image *image, uint64 key) {
+	++_stats.hits;
+	_cache.up({ image, key });
+}
+
+void SizesCache::added(const Image *image, uint64 key, int64 usage) {
+	++_stats.misses;
+	_stats.usage += usage;
+	_cache.up({ image, key });
+	if (_stats.usage > _limit) {
+		// Pixmaps are returned by reference, so we don't drop them
+		// while the current paint may still be using them.
+		_check.call();
+	}
+}
+
+void SizesCache::removed(const Image *image, uint64 key, int64 usage) {
+	_stats.usage -= usage;
+	_cache.remove({ image, key });
+}
+
+SizesCacheStats SizesCache::stats() const {
+	return _stats;
+}
+
+void SizesCache::check() {
+	auto dropped = 0;
+	while (_stats.usage > _limit) {
+		const auto entry = _cache.take_lowest();
+		if (!entry.image) {
+			break;
+		}
+		entry.image->forgetSize(entry.key);
+		++dropped;
+	}
+	if (dropped) {
+		const auto total = std::max(_stats.hits + _stats.misses, int64(1));
+		DEBUG_LOG(("Images Info: dropped %1 prepared pixmaps, "
+			"%2 KB used, hit rate %3%."
+			).arg(dropped
+			).arg(_stats.usage / 1024
+			).arg(_stats.hits * 100 / total));
+	}
+}
+
+namespace {
+
 QMap<QString, Image*> LocalFileImages;
 QMap<QString, Image*> WebUrlImages;
 QMap<StorageKey, Image*> StorageImages;
@@ -46,6 +147,11 @@ int64 ComputeUsage(const QImage &image) {
 	return Instance;
 }
 
+[[nodiscard]] SizesCache &PreparedCache() {
+	static auto Instance = SizesCache(kMemoryForSizesCache);
+	return Instance;
+}
+
 uint64 PixKey(int width, int height, Options options) {
 	return static_cast<uint64>(width)
 		| (static_cast<uint64>(height) << 24)
@@ -58,6 +164,10 @@ uint64 SinglePixKey(Options options) {
 
 } // namespace
 
+SizesCacheStats CurrentSizesCacheStats() {
+	return PreparedCache().stats();
+}
+
 void ClearRemote() {
 	for (auto image : base::take(StorageImages)) {
 		delete image;
@@ -387,14 +497,12 @@ const QPixmap &Image::pix(
     }
 	auto options = Option::Smooth | Option::None;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-        p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixRounded(
@@ -426,14 +534,12 @@ const QPixmap &Image::pixRounded(
 		options |= Option::Circled | cornerOptions(corners);
 	}
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixCircled(
@@ -450,14 +556,12 @@ const QPixmap &Image::pixCircled(
 	}
 	auto options = Option::Smooth | Option::Circled;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredCircled(
@@ -474,14 +578,12 @@ const QPixmap &Image::pixBlurredCircled(
 	}
 	auto options = Option::Smooth | Option::Circled | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurred(
@@ -498,14 +600,12 @@ const QPixmap &Image::pixBlurred(
 	}
 	auto options = Option::Smooth | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixNoCache(origin, w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixColored(
@@ -523,14 +623,12 @@ const QPixmap &Image::pixColored(
 	}
 	auto options = Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixColoredNoCache(origin, add, w, h, true);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixColoredNoCache(origin, add, w, h, true);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredColored(
@@ -548,14 +646,12 @@ const QPixmap &Image::pixBlurredColored(
 	}
 	auto options = Option::Blurred | Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend()) {
-		auto p = pixBlurredColoredNoCache(origin, add, w, h);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	if (const auto cached = lookupSize(k)) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixBlurredColoredNoCache(origin, add, w, h);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 const QPixmap &Image::pixSingle(
@@ -595,17 +691,99 @@ const QPixmap &Image::pixSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend() || i->width() != (outerw * cIntRetinaFactor()) || i->height() != (outerh * cIntRetinaFactor())) {
-		if (i != _sizesCache.cend()) {
-			ActiveCache().decrement(ComputeUsage(*i));
+	const auto cached = lookupSize(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
+	}
+	auto p = pixNoCache(origin, w, h, options, outerw, outerh, colored);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
+}
+
+const QPixmap &Image::pixSingleAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h,
+		int32 outerw,
+		int32 outerh,
+		ImageRoundRadius radius,
+		RectParts corners) const {
+	checkSource();
+
+	// Circle masks and placeholders are painted with the main thread
+	// only resources, so they're prepared right away.
+	if (radius == ImageRoundRadius::Ellipse || _data.isNull() || isNull()) {
+		return pixSingle(origin, w, h, outerw, outerh, radius, corners);
+	}
+
+	if (w <= 0 || !width() || !height()) {
+		w = width() * cIntRetinaFactor();
+	} else {
+		w *= cIntRetinaFactor();
+		h *= cIntRetinaFactor();
+	}
+
+	auto options = Option::Smooth | Option::None;
+	auto cornerOptions = [](RectParts corners) {
+		return (corners & RectPart::TopLeft ? Option::RoundedTopLeft : Option::None)
+			| (corners & RectPart::TopRight ? Option::RoundedTopRight : Option::None)
+			| (corners & RectPart::BottomLeft ? Option::RoundedBottomLeft : Option::None)
+			| (corners & RectPart::BottomRight ? Option::RoundedBottomRight : Option::None);
+	};
+	if (radius == ImageRoundRadius::Large) {
+		options |= Option::RoundedLarge | cornerOptions(corners);
+	} else if (radius == ImageRoundRadius::Small) {
+		options |= Option::RoundedSmall | cornerOptions(corners);
+	}
+
+	auto k = SinglePixKey(options);
+	const auto cached = lookupSize(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
+	}
+	if (!_sizesPreparing.contains(k)) {
+		_sizesPreparing.emplace(k);
+		crl::async([
+			=,
+			data = _data,
+			weak = base::make_weak(this),
+			generation = _sizesGeneration
+		] {
+			auto image = prepare(data, w, h, options, outerw, outerh);
+			crl::on_main(weak, [=, image = std::move(image)]() mutable {
+				sizePrepared(origin, generation, k, std::move(image));
+			});
+		});
+	}
+	static const auto Placeholder = QPixmap();
+	return cached ? *cached : Placeholder;
+}
+
+void Image::sizePrepared(
+		Data::FileOrigin origin,
+		int generation,
+		uint64 key,
+		QImage &&image) const {
+	if (generation != _sizesGeneration) {
+		return;
+	}
+	_sizesPreparing.remove(key);
+	auto p = App::pixmapFromImageInPlace(std::move(image));
+	p.setDevicePixelRatio(cRetinaFactor());
+	storeSize(key, std::move(p));
+
+	if (!AuthSession::Exists()) {
+		return;
+	} else if (const auto id = base::get_if<FullMsgId>(&origin.data)) {
+		if (const auto item = App::histItemById(*id)) {
+			Auth().data().requestItemRepaint(item);
 		}
-		auto p = pixNoCache(origin, w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
 	}
-	return i.value();
+	Auth().downloaderTaskFinished().notify();
 }
 
 const QPixmap &Image::pixBlurredSingle(
@@ -641,17 +819,15 @@ const QPixmap &Image::pixBlurredSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _sizesCache.constFind(k);
-	if (i == _sizesCache.cend() || i->width() != (outerw * cIntRetinaFactor()) || i->height() != (outerh * cIntRetinaFactor())) {
-		if (i != _sizesCache.cend()) {
-			ActiveCache().decrement(ComputeUsage(*i));
-		}
-		auto p = pixNoCache(origin, w, h, options, outerw, outerh);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _sizesCache.insert(k, p);
-		ActiveCache().increment(ComputeUsage(*i));
+	const auto cached = lookupSize(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
 	}
-	return i.value();
+	auto p = pixNoCache(origin, w, h, options, outerw, outerh);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeSize(k, std::move(p));
 }
 
 QPixmap Image::pixNoCache(
@@ -836,11 +1012,37 @@ void Image::setImageBytes(const QByteArray &bytes) {
 }
 
 void Image::invalidateSizeCache() const {
-	auto &cache = ActiveCache();
-	for (const auto &image : std::as_const(_sizesCache)) {
-		cache.decrement(ComputeUsage(image));
+	auto &cache = PreparedCache();
+	for (auto i = _sizesCache.cbegin(); i != _sizesCache.cend(); ++i) {
+		cache.removed(this, i.key(), ComputeUsage(i.value()));
 	}
 	_sizesCache.clear();
+	_sizesPreparing.clear();
+	++_sizesGeneration;
+}
+
+const QPixmap *Image::lookupSize(uint64 key) const {
+	const auto i = _sizesCache.constFind(key);
+	if (i == _sizesCache.cend()) {
+		return nullptr;
+	}
+	PreparedCache().hit(this, key);
+	return &i.value();
+}
+
+const QPixmap &Image::storeSize(uint64 key, QPixmap &&pixmap) const {
+	forgetSize(key);
+	const auto i = _sizesCache.insert(key, std::move(pixmap));
+	PreparedCache().added(this, key, ComputeUsage(i.value()));
+	return i.value();
+}
+
+void Image::forgetSize(uint64 key) const {
+	const auto i = _sizesCache.find(key);
+	if (i != _sizesCache.end()) {
+		PreparedCache().removed(this, key, ComputeUsage(i.value()));
+		_sizesCache.erase(i);
+	}
 }
 
 Image::~Image() {
@@ -12,9 +12,20 @@ class HistoryItem;
 
 namespace Images {
 
+class SizesCache;
+
 void ClearRemote();
 void ClearAll();
 
+// Scaled, rounded and blurred pixmaps of all images share one byte
+// budget, least recently used ones are dropped when it is exceeded.
+struct SizesCacheStats {
+	int64 usage = 0;
+	int64 hits = 0;
+	int64 misses = 0;
+};
+[[nodiscard]] SizesCacheStats CurrentSizesCacheStats();
+
 ImagePtr Create(const QString &file, QByteArray format);
 ImagePtr Create(const QString &url, QSize box);
 ImagePtr Create(const QString &url, int width, int height);
@@ -93,7 +104,7 @@ public:
 
 } // namespace Images
 
-class Image final {
+class Image final : public base::has_weak_ptr {
 public:
 	explicit Image(std::unique_ptr<Images::Source> &&source);
 
@@ -145,6 +156,19 @@ public:
 		int32 outerh,
 		ImageRoundRadius radius,
 		RectParts corners = RectPart::AllCorners) const;
+
+	// Same as pixSingle(), but the scaling and rounding are done on a
+	// worker thread. Until they are finished the previously prepared
+	// size (or a null pixmap) is returned and the origin item is
+	// repainted when the result is ready.
+	const QPixmap &pixSingleAsync(
+		Data::FileOrigin origin,
+		int32 w,
+		int32 h,
+		int32 outerw,
+		int32 outerh,
+		ImageRoundRadius radius,
+		RectParts corners = RectPart::AllCorners) const;
 	const QPixmap &pixCircled(
 		Data::FileOrigin origin,
 		int32 w = 0,
@@ -240,11 +264,23 @@ public:
 	~Image();
 
 private:
+	friend class Images::SizesCache;
+
 	void checkSource() const;
 	void invalidateSizeCache() const;
+	const QPixmap *lookupSize(uint64 key) const;
+	const QPixmap &storeSize(uint64 key, QPixmap &&pixmap) const;
+	void forgetSize(uint64 key) const;
+	void sizePrepared(
+		Data::FileOrigin origin,
+		int generation,
+		uint64 key,
+		QImage &&image) const;
 
 	std::unique_ptr<Images::Source> _source;
 	mutable QMap<uint64, QPixmap> _sizesCache;
+	mutable base::flat_set<uint64> _sizesPreparing;
+	mutable int _sizesGeneration = 0;
 	mutable QImage _data;
 
 };
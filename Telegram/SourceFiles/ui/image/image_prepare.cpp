@@ -13,6 +13,290 @@ TG_FORCE_INLINE uint64 blurGetColors(const uchar *p) {
 	return (uint64)p[0] + ((uint64)p[1] << 16) + ((uint64)p[2] << 32) + ((uint64)p[3] << 48);
 }
 
+// Exact division of the stack sums by a multiplication, the sums are
+// always less than 256 * divisor and the divisor is less than 2^16.
+constexpr auto kBlurLargeMaxRadius = 254;
+constexpr auto kBlurLargeDivisionShift = 40;
+
+// Largest JPEG scale denominator supported by libjpeg DCT scaling.
+constexpr auto kMaxDecodeScale = 8;
+
+// Large images are blurred by bands of rows and then of columns.
+constexpr auto kBlurLargeParallelArea = int64(512 * 512);
+constexpr auto kBlurLargeMaxThreads = 4;
+constexpr auto kBlurLargeMinBand = 64;
+
+class LargeBlur final {
+public:
+	LargeBlur(uchar *pixels, int *rgb, int width, int height, int radius);
+
+	void rows(int from, int till) const;
+	void columns(int from, int till) const;
+
+private:
+	[[nodiscard]] int divide(int sum) const;
+
+	uchar * const _pixels = nullptr;
+	int * const _rgb = nullptr;
+	const int _width = 0;
+	const int _height = 0;
+	const int _radius = 0;
+	const int _div = 0;
+	const uint64 _multiplier = 0;
+
+};
+
+LargeBlur::LargeBlur(
+	uchar *pixels,
+	int *rgb,
+	int width,
+	int height,
+	int radius)
+: _pixels(pixels)
+, _rgb(rgb)
+, _width(width)
+, _height(height)
+, _radius(radius)
+, _div(2 * radius + 1)
+, _multiplier((uint64(1) << kBlurLargeDivisionShift)
+	/ uint64((radius + 1) * (radius + 1)) + 1) {
+}
+
+int LargeBlur::divide(int sum) const {
+	return int((uint64(sum) * _multiplier) >> kBlurLargeDivisionShift);
+}
+
+void LargeBlur::rows(int from, int till) const {
+	const auto pixels = _pixels;
+	const auto rgb = _rgb;
+	const auto width = _width;
+	const auto radius = _radius;
+	const auto div = _div;
+	const auto width_m1 = width - 1;
+	const auto radius_p1 = radius + 1;
+
+	auto stack = std::vector<int>(div * 3);
+	auto &&ints = ranges::view::ints;
+	for (const auto y : ints(from, till)) {
+		auto rinsum = 0;
+		auto ginsum = 0;
+		auto binsum = 0;
+		auto routsum = 0;
+		auto goutsum = 0;
+		auto boutsum = 0;
+		auto rsum = 0;
+		auto gsum = 0;
+		auto bsum = 0;
+
+		const auto y_width = y * width;
+		for (const auto i : ints(-radius, radius + 1)) {
+			const auto sir = &stack[(i + radius) * 3];
+			const auto x = std::clamp(i, 0, width_m1);
+			const auto offset = (y_width + x) * 4;
+			sir[0] = pixels[offset];
+			sir[1] = pixels[offset + 1];
+			sir[2] = pixels[offset + 2];
+
+			const auto rbs = radius_p1 - std::abs(i);
+			rsum += sir[0] * rbs;
+			gsum += sir[1] * rbs;
+			bsum += sir[2] * rbs;
+
+			if (i > 0) {
+				rinsum += sir[0];
+				ginsum += sir[1];
+				binsum += sir[2];
+			} else {
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+			}
+		}
+		auto stackpointer = radius;
+
+		for (const auto x : ints(0, width)) {
+			const auto position = (y_width + x) * 3;
+			rgb[position] = divide(rsum);
+			rgb[position + 1] = divide(gsum);
+			rgb[position + 2] = divide(bsum);
+
+			rsum -= routsum;
+			gsum -= goutsum;
+			bsum -= boutsum;
+
+			const auto stackstart = (stackpointer < radius)
+				? (stackpointer - radius + div)
+				: (stackpointer - radius);
+			const auto sir = &stack[stackstart * 3];
+
+			routsum -= sir[0];
+			goutsum -= sir[1];
+			boutsum -= sir[2];
+
+			const auto offset = (y_width + std::min(x + radius_p1, width_m1)) * 4;
+			sir[0] = pixels[offset];
+			sir[1] = pixels[offset + 1];
+			sir[2] = pixels[offset + 2];
+			rinsum += sir[0];
+			ginsum += sir[1];
+			binsum += sir[2];
+
+			rsum += rinsum;
+			gsum += ginsum;
+			bsum += binsum;
+			{
+				stackpointer = (stackpointer + 1 == div) ? 0 : (stackpointer + 1);
+				const auto sir = &stack[stackpointer * 3];
+
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+
+				rinsum -= sir[0];
+				ginsum -= sir[1];
+				binsum -= sir[2];
+			}
+		}
+	}
+}
+
+void LargeBlur::columns(int from, int till) const {
+	const auto pixels = _pixels;
+	const auto rgb = _rgb;
+	const auto width = _width;
+	const auto height = _height;
+	const auto radius = _radius;
+	const auto div = _div;
+	const auto height_m1 = height - 1;
+	const auto radius_p1 = radius + 1;
+
+	auto stack = std::vector<int>(div * 3);
+	auto &&ints = ranges::view::ints;
+	for (const auto x : ints(from, till)) {
+		auto rinsum = 0;
+		auto ginsum = 0;
+		auto binsum = 0;
+		auto routsum = 0;
+		auto goutsum = 0;
+		auto boutsum = 0;
+		auto rsum = 0;
+		auto gsum = 0;
+		auto bsum = 0;
+		for (const auto i : ints(-radius, radius + 1)) {
+			const auto y = std::clamp(i, 0, height_m1);
+			const auto position = (y * width + x) * 3;
+			const auto sir = &stack[(i + radius) * 3];
+
+			sir[0] = rgb[position];
+			sir[1] = rgb[position + 1];
+			sir[2] = rgb[position + 2];
+
+			const auto rbs = radius_p1 - std::abs(i);
+			rsum += sir[0] * rbs;
+			gsum += sir[1] * rbs;
+			bsum += sir[2] * rbs;
+			if (i > 0) {
+				rinsum += sir[0];
+				ginsum += sir[1];
+				binsum += sir[2];
+			} else {
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+			}
+		}
+		auto stackpointer = radius;
+		for (const auto y : ints(0, height)) {
+			const auto offset = (y * width + x) * 4;
+			pixels[offset] = divide(rsum);
+			pixels[offset + 1] = divide(gsum);
+			pixels[offset + 2] = divide(bsum);
+			rsum -= routsum;
+			gsum -= goutsum;
+			bsum -= boutsum;
+
+			const auto stackstart = (stackpointer < radius)
+				? (stackpointer - radius + div)
+				: (stackpointer - radius);
+			const auto sir = &stack[stackstart * 3];
+
+			routsum -= sir[0];
+			goutsum -= sir[1];
+			boutsum -= sir[2];
+
+			const auto position = (std::min(y + radius_p1, height_m1) * width + x) * 3;
+			sir[0] = rgb[position];
+			sir[1] = rgb[position + 1];
+			sir[2] = rgb[position + 2];
+
+			rinsum += sir[0];
+			ginsum += sir[1];
+			binsum += sir[2];
+
+			rsum += rinsum;
+			gsum += ginsum;
+			bsum += binsum;
+			{
+				stackpointer = (stackpointer + 1 == div) ? 0 : (stackpointer + 1);
+				const auto sir = &stack[stackpointer * 3];
+
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+
+				rinsum -= sir[0];
+				ginsum -= sir[1];
+				binsum -= sir[2];
+			}
+		}
+	}
+}
+
+// The calling thread takes bands as well, so it never waits for a band
+// that no thread has started, even if all the crl threads are busy.
+template <typename Method>
+void ForEachBand(int size, int threads, Method &&method) {
+	const auto bands = std::min(threads, std::max(size / kBlurLargeMinBand, 1));
+	if (bands < 2) {
+		method(0, size);
+		return;
+	}
+	struct State {
+		std::atomic<int> next = { 0 };
+		crl::semaphore finished;
+	};
+	const auto state = std::make_shared<State>();
+	const auto band = [&](int index) {
+		method(size * index / bands, size * (index + 1) / bands);
+	};
+	// A late helper finds no bands left and doesn't touch band().
+	const auto helper = [=, &band] {
+		while (true) {
+			const auto index = state->next.fetch_add(1);
+			if (index >= bands) {
+				return;
+			}
+			band(index);
+			state->finished.release();
+		}
+	};
+	for (auto i = 1; i != bands; ++i) {
+		crl::async(helper);
+	}
+	auto own = 0;
+	while (true) {
+		const auto index = state->next.fetch_add(1);
+		if (index >= bands) {
+			break;
+		}
+		band(index);
+		++own;
+	}
+	for (auto i = own; i != bands; ++i) {
+		state->finished.acquire();
+	}
+}
+
 const QPixmap &circleMask(int width, int height) {
 	Assert(Global::started());
 
@@ -47,6 +331,34 @@ QPixmap PixmapFast(QImage &&image) {
 	return QPixmap::fromImage(std::move(image), Qt::NoFormatConversion);
 }
 
+void ScaleOnDecode(QImageReader &reader, QSize box) {
+	const auto format = reader.format().toLower();
+	if (box.isEmpty() || (format != "jpeg" && format != "jpg")) {
+		return;
+	}
+	const auto size = reader.size();
+	if (size.isEmpty()) {
+		return;
+	}
+
+	// The box could be applied after the EXIF orientation is fixed.
+	const auto scaled = size.scaled(box, Qt::KeepAspectRatio);
+	const auto transposed = size.scaled(box.transposed(), Qt::KeepAspectRatio);
+	const auto needed = QSize(
+		std::max(scaled.width(), transposed.width()),
+		std::max(scaled.height(), transposed.height()));
+	for (auto factor = kMaxDecodeScale; factor > 1; factor /= 2) {
+		const auto result = QSize(
+			size.width() / factor,
+			size.height() / factor);
+		if (result.width() >= needed.width()
+			&& result.height() >= needed.height()) {
+			reader.setScaledSize(result);
+			return;
+		}
+	}
+}
+
 QImage prepareBlur(QImage img) {
 	if (img.isNull()) {
 		return img;
@@ -174,6 +486,7 @@ QImage BlurLargeImage(QImage image, int radius) {
 	if (width <= radius || height <= radius || radius < 1) {
 		return image;
 	}
+	Expects(radius <= kBlurLargeMaxRadius);
 
 	if (image.format() != QImage::Format_RGB32
 		&& image.format() != QImage::Format_ARGB32_Premultiplied) {
@@ -181,205 +494,19 @@ QImage BlurLargeImage(QImage image, int radius) {
 			QImage::Format_ARGB32_Premultiplied);
 	}
 	const auto pixels = image.bits();
-
-	const auto width_m1 = width - 1;
-	const auto height_m1 = height - 1;
-	const auto widthxheight = width * height;
-	const auto div = 2 * radius + 1;
-	const auto radius_p1 = radius + 1;
-	const auto divsum = radius_p1 * radius_p1;
-
-	const auto dvcount = 256 * divsum;
-	const auto buffers = (div * 3) // stack
-		+ std::max(width, height) // vmin
-		+ widthxheight * 3 // rgb
-		+ dvcount; // dv
-	auto storage = std::vector<int>(buffers);
-	auto taken = 0;
-	const auto take = [&](int size) {
-		const auto result = gsl::make_span(storage).subspan(taken, size);
-		taken += size;
-		return result;
-	};
-
-	// Small buffers
-	const auto stack = take(div * 3).data();
-	const auto vmin = take(std::max(width, height)).data();
-
-	// Large buffers
-	const auto rgb = take(widthxheight * 3).data();
-	const auto dvs = take(dvcount);
-
-	auto &&ints = ranges::view::ints;
-	for (auto &&[value, index] : ranges::view::zip(dvs, ints(0))) {
-		value = (index / divsum);
-	}
-	const auto dv = dvs.data();
-
-	// Variables
-	auto stackpointer = 0;
-	for (const auto x : ints(0, width)) {
-		vmin[x] = std::min(x + radius_p1, width_m1);
-	}
-	for (const auto y : ints(0, height)) {
-		auto rinsum = 0;
-		auto ginsum = 0;
-		auto binsum = 0;
-		auto routsum = 0;
-		auto goutsum = 0;
-		auto boutsum = 0;
-		auto rsum = 0;
-		auto gsum = 0;
-		auto bsum = 0;
-
-		const auto y_width = y * width;
-		for (const auto i : ints(-radius, radius + 1)) {
-			const auto sir = &stack[(i + radius) * 3];
-			const auto x = std::clamp(i, 0, width_m1);
-			const auto offset = (y_width + x) * 4;
-			sir[0] = pixels[offset];
-			sir[1] = pixels[offset + 1];
-			sir[2] = pixels[offset + 2];
-
-			const auto rbs = radius_p1 - std::abs(i);
-			rsum += sir[0] * rbs;
-			gsum += sir[1] * rbs;
-			bsum += sir[2] * rbs;
-
-			if (i > 0) {
-				rinsum += sir[0];
-				ginsum += sir[1];
-				binsum += sir[2];
-			} else {
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-			}
-		}
-		stackpointer = radius;
-
-		for (const auto x : ints(0, width)) {
-			const auto position = (y_width + x) * 3;
-			rgb[position] = dv[rsum];
-			rgb[position + 1] = dv[gsum];
-			rgb[position + 2] = dv[bsum];
-
-			rsum -= routsum;
-			gsum -= goutsum;
-			bsum -= boutsum;
-
-			const auto stackstart = (stackpointer - radius + div) % div;
-			const auto sir = &stack[stackstart * 3];
-
-			routsum -= sir[0];
-			goutsum -= sir[1];
-			boutsum -= sir[2];
-
-			const auto offset = (y_width + vmin[x]) * 4;
-			sir[0] = pixels[offset];
-			sir[1] = pixels[offset + 1];
-			sir[2] = pixels[offset + 2];
-			rinsum += sir[0];
-			ginsum += sir[1];
-			binsum += sir[2];
-
-			rsum += rinsum;
-			gsum += ginsum;
-			bsum += binsum;
-			{
-				stackpointer = (stackpointer + 1) % div;
-				const auto sir = &stack[stackpointer * 3];
-
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-
-				rinsum -= sir[0];
-				ginsum -= sir[1];
-				binsum -= sir[2];
-			}
-		}
-	}
-
-	for (const auto y : ints(0, height)) {
-		vmin[y] = std::min(y + radius_p1, height_m1) * width;
-	}
-	for (const auto x : ints(0, width)) {
-		auto rinsum = 0;
-		auto ginsum = 0;
-		auto binsum = 0;
-		auto routsum = 0;
-		auto goutsum = 0;
-		auto boutsum = 0;
-		auto rsum = 0;
-		auto gsum = 0;
-		auto bsum = 0;
-		for (const auto i : ints(-radius, radius + 1)) {
-			const auto y = std::clamp(i, 0, height_m1);
-			const auto position = (y * width + x) * 3;
-			const auto sir = &stack[(i + radius) * 3];
-
-			sir[0] = rgb[position];
-			sir[1] = rgb[position + 1];
-			sir[2] = rgb[position + 2];
-
-			const auto rbs = radius_p1 - std::abs(i);
-			rsum += sir[0] * rbs;
-			gsum += sir[1] * rbs;
-			bsum += sir[2] * rbs;
-			if (i > 0) {
-				rinsum += sir[0];
-				ginsum += sir[1];
-				binsum += sir[2];
-			} else {
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-			}
-		}
-		stackpointer = radius;
-		for (const auto y : ints(0, height)) {
-			const auto offset = (y * width + x) * 4;
-			pixels[offset] = dv[rsum];
-			pixels[offset + 1] = dv[gsum];
-			pixels[offset + 2] = dv[bsum];
-			rsum -= routsum;
-			gsum -= goutsum;
-			bsum -= boutsum;
-
-			const auto stackstart = (stackpointer - radius + div) % div;
-			const auto sir = &stack[stackstart * 3];
-
-			routsum -= sir[0];
-			goutsum -= sir[1];
-			boutsum -= sir[2];
-
-			const auto position = (vmin[y] + x) * 3;
-			sir[0] = rgb[position];
-			sir[1] = rgb[position + 1];
-			sir[2] = rgb[position + 2];
-
-			rinsum += sir[0];
-			ginsum += sir[1];
-			binsum += sir[2];
-
-			rsum += rinsum;
-			gsum += ginsum;
-			bsum += binsum;
-			{
-				stackpointer = (stackpointer + 1) % div;
-				const auto sir = &stack[stackpointer * 3];
-
-				routsum += sir[0];
-				goutsum += sir[1];
-				boutsum += sir[2];
-
-				rinsum -= sir[0];
-				ginsum -= sir[1];
-				binsum -= sir[2];
-			}
-		}
-	}
+	auto rgb = std::vector<int>(width * height * 3);
+
+	const auto area = int64(width) * height;
+	const auto threads = (area < kBlurLargeParallelArea)
+		? 1
+		: std::clamp(QThread::idealThreadCount(), 1, kBlurLargeMaxThreads);
+	const auto blur = LargeBlur(pixels, rgb.data(), width, height, radius);
+	ForEachBand(height, threads, [&](int from, int till) {
+		blur.rows(from, till);
+	});
+	ForEachBand(width, threads, [&](int from, int till) {
+		blur.columns(from, till);
+	});
 	return image;
 }
 
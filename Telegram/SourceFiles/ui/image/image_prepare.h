@@ -27,6 +27,10 @@ QPixmap PixmapFast(QImage &&image);
 
 QImage BlurLargeImage(QImage image, int radius);
 
+// Lets JPEG images be decoded right in the DCT at 1/2, 1/4 or 1/8 scale
+// if the result still covers the box, to be downscaled from there.
+void ScaleOnDecode(QImageReader &reader, QSize box);
+
 QImage prepareBlur(QImage image);
 void prepareRound(
 	QImage &image,
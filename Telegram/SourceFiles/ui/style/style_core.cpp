@@ -52,6 +52,7 @@ void startManager() {
 
 	internal::registerFontFamily(qsl("Open Sans"));
 	internal::startModules();
+	internal::prepareIcons();
 }
 
 void stopManager() {
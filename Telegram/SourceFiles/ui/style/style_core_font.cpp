@@ -10,6 +10,9 @@ namespace style {
 namespace internal {
 namespace {
 
+constexpr auto kCachedStringMaxLength = 64;
+constexpr auto kCachedStringsLimit = 2048;
+
 typedef QMap<QString, int> FontFamilyMap;
 FontFamilyMap fontFamilyMap;
 
@@ -73,6 +76,46 @@ FontData::FontData(int size, uint32 flags, int family, Font *other)
 	elidew = width(qsl("..."));
 }
 
+int32 FontData::width(const QString &str) const {
+	if (str.size() > kCachedStringMaxLength) {
+		return m.width(str);
+	}
+	const auto i = _widths.constFind(str);
+	if (i != _widths.cend()) {
+		return i.value();
+	}
+	if (_widths.size() >= kCachedStringsLimit) {
+		_widths.clear();
+	}
+	const auto result = m.width(str);
+	_widths.insert(str, result);
+	return result;
+}
+
+QString FontData::elided(
+		const QString &str,
+		int32 width,
+		Qt::TextElideMode mode) const {
+	if (str.size() > kCachedStringMaxLength) {
+		return m.elidedText(str, mode, width);
+	}
+	auto i = _elided.find(str);
+	if (i != _elided.end()) {
+		if (i->width != width || i->mode != mode) {
+			i->width = width;
+			i->mode = mode;
+			i->result = m.elidedText(str, mode, width);
+		}
+		return i->result;
+	}
+	if (_elided.size() >= kCachedStringsLimit) {
+		_elided.clear();
+	}
+	auto result = m.elidedText(str, mode, width);
+	_elided.insert(str, { width, mode, result });
+	return result;
+}
+
 Font FontData::bold(bool set) const {
 	return otherFlagsFont(FontBold, set);
 }
@@ -62,18 +62,14 @@ enum FontFlags {
 class FontData {
 public:
 
-	int32 width(const QString &str) const {
-		return m.width(str);
-	}
+	int32 width(const QString &str) const;
 	int32 width(const QString &str, int32 from, int32 to) const {
 		return width(str.mid(from, to));
 	}
 	int32 width(QChar ch) const {
 		return m.width(ch);
 	}
-	QString elided(const QString &str, int32 width, Qt::TextElideMode mode = Qt::ElideRight) const {
-		return m.elidedText(str, mode, width);
-	}
+	QString elided(const QString &str, int32 width, Qt::TextElideMode mode = Qt::ElideRight) const;
 
 	Font bold(bool set = true) const;
 	Font italic(bool set = true) const;
@@ -98,6 +94,15 @@ private:
 	uint32 _flags;
 	int _family;
 
+	// Names, dates and other short strings are measured on each paint.
+	struct Elided {
+		int32 width = 0;
+		Qt::TextElideMode mode = Qt::ElideRight;
+		QString result;
+	};
+	mutable QHash<QString, int32> _widths;
+	mutable QHash<QString, Elided> _elided;
+
 };
 
 inline bool operator==(const Font &a, const Font &b) {
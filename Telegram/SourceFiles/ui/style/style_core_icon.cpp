@@ -21,15 +21,18 @@ NeverFreedPointer<IconMasks> iconMasks;
 NeverFreedPointer<IconPixmaps> iconPixmaps;
 NeverFreedPointer<IconDatas> iconData;
 
-QImage createIconMask(const IconMask *mask, int scale) {
+QImage createIconMask(
+		const IconMask *mask,
+		int scale,
+		int factor,
+		float64 ratio) {
 	auto maskImage = QImage::fromData(mask->data(), mask->size(), "PNG");
-	maskImage.setDevicePixelRatio(cRetinaFactor());
+	maskImage.setDevicePixelRatio(ratio);
 	Assert(!maskImage.isNull());
 
 	// images are layouted like this:
 	// 100x 200x
 	// 300x
-	const auto factor = cIntRetinaFactor();
 	const auto realscale = scale * factor;
 	const auto width = maskImage.width() / 3;
 	const auto height = maskImage.height() / 5;
@@ -52,6 +55,10 @@ QImage createIconMask(const IconMask *mask, int scale) {
 		Qt::SmoothTransformation);
 }
 
+QImage createIconMask(const IconMask *mask, int scale) {
+	return createIconMask(mask, scale, cIntRetinaFactor(), cRetinaFactor());
+}
+
 QSize readGeneratedSize(const IconMask *mask, int scale) {
 	auto data = mask->data();
 	auto size = mask->size();
@@ -82,6 +89,15 @@ QSize readGeneratedSize(const IconMask *mask, int scale) {
 	return QSize();
 }
 
+const QImage &cachedIconMask(const IconMask *mask) {
+	iconMasks.createIfNull();
+	auto i = iconMasks->constFind(mask);
+	if (i == iconMasks->cend()) {
+		i = iconMasks->insert(mask, createIconMask(mask, cScale()));
+	}
+	return i.value();
+}
+
 } // namespace
 
 MonoIcon::MonoIcon(const IconMask *mask, Color color, QPoint offset)
@@ -170,7 +186,7 @@ void MonoIcon::paint(
 	auto size = readGeneratedSize(_mask, cScale());
 	auto maskImage = QImage();
 	if (size.isEmpty()) {
-		maskImage = createIconMask(_mask, cScale());
+		maskImage = cachedIconMask(_mask);
 		size = maskImage.size() / cIntRetinaFactor();
 	}
 
@@ -198,7 +214,7 @@ void MonoIcon::fill(
 	auto size = readGeneratedSize(_mask, cScale());
 	auto maskImage = QImage();
 	if (size.isEmpty()) {
-		maskImage = createIconMask(_mask, cScale());
+		maskImage = cachedIconMask(_mask);
 		size = maskImage.size() / cIntRetinaFactor();
 	}
 	if (!maskImage.isNull()) {
@@ -249,12 +265,7 @@ void MonoIcon::ensureLoaded() const {
 
 	_size = readGeneratedSize(_mask, cScale());
 	if (_size.isEmpty()) {
-		iconMasks.createIfNull();
-		auto i = iconMasks->constFind(_mask);
-		if (i == iconMasks->cend()) {
-			i = iconMasks->insert(_mask, createIconMask(_mask, cScale()));
-		}
-		_maskImage = i.value();
+		_maskImage = cachedIconMask(_mask);
 
 		createCachedPixmap();
 	}
@@ -340,6 +351,47 @@ void resetIcons() {
 	}
 }
 
+void prepareIcons() {
+	if (!iconData) {
+		return;
+	}
+	iconMasks.createIfNull();
+	auto masks = std::vector<const IconMask*>();
+	for (const auto data : *iconData) {
+		data->collectMasks(masks);
+	}
+	masks.erase(ranges::remove_if(masks, [](const IconMask *mask) {
+		return !mask || iconMasks->contains(mask);
+	}), end(masks));
+	std::sort(begin(masks), end(masks));
+	masks.erase(std::unique(begin(masks), end(masks)), end(masks));
+
+	const auto scale = cScale();
+	const auto factor = cIntRetinaFactor();
+	const auto ratio = cRetinaFactor();
+	crl::async([=, masks = std::move(masks)] {
+		auto images = std::vector<std::pair<const IconMask*, QImage>>();
+		images.reserve(masks.size());
+		for (const auto mask : masks) {
+			if (readGeneratedSize(mask, scale).isEmpty()) {
+				images.emplace_back(
+					mask,
+					createIconMask(mask, scale, factor, ratio));
+			}
+		}
+		crl::on_main([=, images = std::move(images)] {
+			if (!iconMasks || scale != cScale()) {
+				return;
+			}
+			for (const auto &[mask, image] : images) {
+				if (!iconMasks->contains(mask)) {
+					iconMasks->insert(mask, image);
+				}
+			}
+		});
+	});
+}
+
 void destroyIcons() {
 	iconData.clear();
 	iconPixmaps.clear();
@@ -47,6 +47,9 @@ public:
 	QSize size() const;
 
 	QPoint offset() const;
+	const IconMask *mask() const {
+		return _mask;
+	}
 
 	void paint(QPainter &p, const QPoint &pos, int outerw) const;
 	void fill(QPainter &p, const QRect &rect) const;
@@ -93,6 +96,11 @@ public:
 	bool empty() const {
 		return _parts.empty();
 	}
+	void collectMasks(std::vector<const IconMask*> &masks) const {
+		for_const (auto &part, _parts) {
+			masks.push_back(part.mask());
+		}
+	}
 
 	void paint(QPainter &p, const QPoint &pos, int outerw) const {
 		for_const (auto &part, _parts) {
@@ -273,5 +281,9 @@ private:
 void resetIcons();
 void destroyIcons();
 
+// Decode icon masks in the background, so that the first paint of
+// each panel doesn't have to decode PNG images of all its icons.
+void prepareIcons();
+
 } // namespace internal
 } // namespace style
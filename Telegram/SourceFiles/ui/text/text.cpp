@@ -2506,6 +2506,7 @@ Text::Text(Text &&other)
 }
 
 Text &Text::operator=(const Text &other) {
+	_layoutCache = other._layoutCache;
 	_minResizeWidth = other._minResizeWidth;
 	_maxWidth = other._maxWidth;
 	_minHeight = other._minHeight;
@@ -2521,6 +2522,7 @@ Text &Text::operator=(const Text &other) {
 }
 
 Text &Text::operator=(Text &&other) {
+	_layoutCache = other._layoutCache;
 	_minResizeWidth = other._minResizeWidth;
 	_maxWidth = other._maxWidth;
 	_minHeight = other._minHeight;
@@ -2543,6 +2545,7 @@ void Text::setText(const style::TextStyle &st, const QString &text, const TextPa
 }
 
 void Text::recountNaturalSize(bool initial, Qt::LayoutDirection optionsDir) {
+	_layoutCache = LayoutCache();
 	NewlineBlock *lastNewline = 0;
 
 	_maxWidth = _minHeight = 0;
@@ -2777,23 +2780,34 @@ int Text::countWidth(int width) const {
 		return _maxWidth.ceil().toInt();
 	}
 
+	if (_layoutCache.widthForWidth == width) {
+		return _layoutCache.width;
+	}
+
 	QFixed maxLineWidth = 0;
 	enumerateLines(width, [&maxLineWidth](QFixed lineWidth, int lineHeight) {
 		if (lineWidth > maxLineWidth) {
 			maxLineWidth = lineWidth;
 		}
 	});
-	return maxLineWidth.ceil().toInt();
+	_layoutCache.widthForWidth = width;
+	_layoutCache.width = maxLineWidth.ceil().toInt();
+	return _layoutCache.width;
 }
 
 int Text::countHeight(int width) const {
 	if (QFixed(width) >= _maxWidth) {
 		return _minHeight;
 	}
+	if (_layoutCache.heightForWidth == width) {
+		return _layoutCache.height;
+	}
 	int result = 0;
 	enumerateLines(width, [&result](QFixed lineWidth, int lineHeight) {
 		result += lineHeight;
 	});
+	_layoutCache.heightForWidth = width;
+	_layoutCache.height = result;
 	return result;
 }
 
@@ -3126,6 +3140,7 @@ void Text::clear() {
 }
 
 void Text::clearFields() {
+	_layoutCache = LayoutCache();
 	_blocks.clear();
 	_links.clear();
 	_maxWidth = _minHeight = 0;
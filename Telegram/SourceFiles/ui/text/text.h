@@ -183,6 +183,7 @@ public:
 		for (int32 j = from + dots; j < to; ++j) {
 			_text[j] = QChar(' ');
 		}
+		_layoutCache = LayoutCache();
 		return true;
 	}
 
@@ -212,6 +213,15 @@ private:
 
 	void recountNaturalSize(bool initial, Qt::LayoutDirection optionsDir = Qt::LayoutDirectionAuto);
 
+	// Line breaking results for the last asked widths, layouts ask for
+	// the same width again and again on each resize and paint.
+	struct LayoutCache {
+		int heightForWidth = -1;
+		int height = 0;
+		int widthForWidth = -1;
+		int width = 0;
+	};
+
 	// clear() deletes all blocks and calls this method
 	// it is also called from move constructor / assignment operator
 	void clearFields();
@@ -228,6 +238,8 @@ private:
 
 	Qt::LayoutDirection _startDir = Qt::LayoutDirectionAuto;
 
+	mutable LayoutCache _layoutCache;
+
 	friend class TextParser;
 	friend class TextPainter;
 
@@ -140,6 +140,44 @@ static inline void addNextCluster(int &pos, int end, ScriptLine &line, int &glyp
 	++glyphCount;
 }
 
+constexpr auto kShapedRunMaxLength = 32;
+constexpr auto kShapedRunsLimit = 4096;
+
+// Short runs like names, dates and common words are shaped once per
+// font, word offsets are kept relative to the run start.
+struct ShapedRunKey {
+	style::internal::FontData *font = nullptr;
+	QString text;
+	int minResizeWidth = 0;
+	bool link = false;
+};
+
+inline bool operator==(const ShapedRunKey &a, const ShapedRunKey &b) {
+	return (a.font == b.font)
+		&& (a.minResizeWidth == b.minResizeWidth)
+		&& (a.link == b.link)
+		&& (a.text == b.text);
+}
+
+inline uint qHash(const ShapedRunKey &key, uint seed = 0) {
+	return qHash(key.text, seed)
+		^ qHash(quintptr(key.font))
+		^ qHash(key.minResizeWidth)
+		^ uint(key.link);
+}
+
+struct ShapedRun {
+	QVector<TextWord> words;
+	QFixed width;
+	QFixed rpadding;
+};
+
+// Text blocks are created on the main thread only.
+QHash<ShapedRunKey, ShapedRun> &ShapedRuns() {
+	static auto result = QHash<ShapedRunKey, ShapedRun>();
+	return result;
+}
+
 } // anonymous namespace
 
 class BlockParser {
@@ -325,6 +363,31 @@ TextBlock::TextBlock(const style::font &font, const QString &str, QFixed minResi
 		}
 
 		const auto part = str.mid(_from, length);
+		const auto cache = (length <= kShapedRunMaxLength);
+		const auto key = cache
+			? ShapedRunKey{
+				blockFont.v(),
+				part,
+				minResizeWidth.value(),
+				(lnkIndex > 0) }
+			: ShapedRunKey();
+		if (cache) {
+			auto &runs = ShapedRuns();
+			const auto i = runs.constFind(key);
+			if (i != runs.cend()) {
+				_words.reserve(i->words.size());
+				for (const auto &word : i->words) {
+					_words.push_back(TextWord(
+						word.from() + _from,
+						word.f_width(),
+						word.f_rbearing(),
+						word.f_rpadding()));
+				}
+				_width = i->width;
+				_rpadding = i->rpadding;
+				return;
+			}
+		}
 
 		// Attempt to catch a crash in text processing
 		CrashReports::SetAnnotationRef("CrashString", &part);
@@ -333,6 +396,23 @@ TextBlock::TextBlock(const style::font &font, const QString &str, QFixed minResi
 		BlockParser parser(&engine, this, minResizeWidth, _from, part);
 
 		CrashReports::ClearAnnotationRef("CrashString");
+
+		if (cache) {
+			auto &runs = ShapedRuns();
+			if (runs.size() >= kShapedRunsLimit) {
+				runs.clear();
+			}
+			auto run = ShapedRun{ QVector<TextWord>(), _width, _rpadding };
+			run.words.reserve(_words.size());
+			for (const auto &word : _words) {
+				run.words.push_back(TextWord(
+					word.from() - _from,
+					word.f_width(),
+					word.f_rbearing(),
+					word.f_rpadding()));
+			}
+			runs.insert(key, std::move(run));
+		}
 	}
 }
 
@@ -1129,6 +1129,68 @@ const QRegularExpression &RegExpWordSplit() {
 	return result;
 }
 
+// Each of the entity expressions needs one literal ASCII character,
+// a single pass over the text tells which of them can match at all.
+constexpr auto kTriggerDot = 0x01;
+constexpr auto kTriggerColon = 0x02;
+constexpr auto kTriggerHash = 0x04;
+constexpr auto kTriggerAt = 0x08;
+constexpr auto kTriggerSlash = 0x10;
+constexpr auto kTriggersAll = 0x1F;
+
+int ScanEntityTriggers(const QString &text) {
+	static const auto kTable = [] {
+		auto result = std::array<uchar, 128>{ { 0 } };
+		result['.'] = kTriggerDot;
+		result[':'] = kTriggerColon;
+		result['#'] = kTriggerHash;
+		result['@'] = kTriggerAt;
+		result['/'] = kTriggerSlash;
+		return result;
+	}();
+	auto result = 0;
+	for (auto ch = text.constData(), e = ch + text.size(); ch != e; ++ch) {
+		const auto code = ch->unicode();
+		if (code < 128 && kTable[code]) {
+			result |= kTable[code];
+			if (result == kTriggersAll) {
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+// Remembers the last match of an expression. A match found from some
+// offset stays the first one for any later offset up to its start, so
+// it is reused until the scan passes it.
+class CachedMatch {
+public:
+	CachedMatch(const QRegularExpression &expression, bool enabled)
+	: _expression(expression)
+	, _enabled(enabled) {
+	}
+
+	QRegularExpressionMatch find(const QString &text, int from) {
+		if (!_enabled) {
+			return QRegularExpressionMatch();
+		} else if (_from < 0
+			|| from < _from
+			|| (_match.hasMatch() && _match.capturedStart() < from)) {
+			_match = _expression.match(text, from);
+			_from = from;
+		}
+		return _match;
+	}
+
+private:
+	const QRegularExpression &_expression;
+	QRegularExpressionMatch _match;
+	int _from = -1;
+	bool _enabled = false;
+
+};
+
 } // namespace
 
 const QRegularExpression &RegExpMailNameAtEnd() {
@@ -1577,6 +1639,22 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 	int32 len = result.text.size(), commandOffset = rich ? 0 : len;
 	bool inLink = false, commandIsLink = false;
 	const QChar *start = result.text.constData(), *end = start + result.text.size();
+	const auto triggers = ScanEntityTriggers(result.text);
+	auto domains = CachedMatch(
+		qthelp::RegExpDomain(),
+		(triggers & kTriggerDot) != 0);
+	auto explicitDomains = CachedMatch(
+		qthelp::RegExpDomainExplicit(),
+		(triggers & kTriggerColon) && (triggers & kTriggerSlash));
+	auto hashtags = CachedMatch(
+		RegExpHashtag(),
+		withHashtags && (triggers & kTriggerHash));
+	auto mentions = CachedMatch(
+		RegExpMention(),
+		withMentions && (triggers & kTriggerAt));
+	auto botCommands = CachedMatch(
+		RegExpBotCommand(),
+		withBotCommands && (triggers & kTriggerSlash));
 	for (int32 offset = 0, matchOffset = offset, mentionSkip = 0; offset < len;) {
 		if (commandOffset <= offset) {
 			for (commandOffset = offset; commandOffset < len; ++commandOffset) {
@@ -1587,11 +1665,11 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 				}
 			}
 		}
-		auto mDomain = qthelp::RegExpDomain().match(result.text, matchOffset);
-		auto mExplicitDomain = qthelp::RegExpDomainExplicit().match(result.text, matchOffset);
-		auto mHashtag = withHashtags ? RegExpHashtag().match(result.text, matchOffset) : QRegularExpressionMatch();
-		auto mMention = withMentions ? RegExpMention().match(result.text, qMax(mentionSkip, matchOffset)) : QRegularExpressionMatch();
-		auto mBotCommand = withBotCommands ? RegExpBotCommand().match(result.text, matchOffset) : QRegularExpressionMatch();
+		auto mDomain = domains.find(result.text, matchOffset);
+		auto mExplicitDomain = explicitDomains.find(result.text, matchOffset);
+		auto mHashtag = hashtags.find(result.text, matchOffset);
+		auto mMention = mentions.find(result.text, qMax(mentionSkip, matchOffset));
+		auto mBotCommand = botCommands.find(result.text, matchOffset);
 
 		EntityInTextType lnkType = EntityInTextUrl;
 		int32 lnkStart = 0, lnkLength = 0;
@@ -1631,7 +1709,7 @@ void ParseEntities(TextWithEntities &result, int32 flags, bool rich) {
 			}
 			if (!(start + mentionStart + 1)->isLetter() || !(start + mentionEnd - 1)->isLetterOrNumber()) {
 				mentionSkip = mentionEnd;
-				mMention = RegExpMention().match(result.text, qMax(mentionSkip, matchOffset));
+				mMention = mentions.find(result.text, qMax(mentionSkip, matchOffset));
 				if (mMention.hasMatch()) {
 					mentionStart = mMention.capturedStart();
 					mentionEnd = mMention.capturedEnd();
@@ -1914,6 +1914,9 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 		_insertedTags,
 		insertedTagsProcessor);
 	using ActionType = FormattingAction::Type;
+
+	// Everything before insertPosition was already checked, so after
+	// each applied action we continue from the place it was applied at.
 	while (true) {
 		FormattingAction action;
 
@@ -2071,6 +2074,9 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 					document,
 					action.intervalStart,
 					action.intervalEnd);
+				insertPosition = std::max(
+					insertPosition,
+					action.intervalStart);
 			} else if (action.type == ActionType::TildeFont) {
 				auto format = QTextCharFormat();
 				format.setFont(action.isTilde
@@ -2082,6 +2088,9 @@ void InputField::processFormatting(int insertPosition, int insertEnd) {
 				auto format = _defaultCharFormat;
 				ApplyTagFormat(format, cursor.charFormat());
 				cursor.setCharFormat(format);
+				insertPosition = std::max(
+					insertPosition,
+					action.intervalStart);
 			} else if (action.type == ActionType::RemoveNewline) {
 				cursor.removeSelectedText();
 				insertPosition = action.intervalStart;
@@ -30,6 +30,11 @@ namespace {
 // not more than one sound in 500ms from one peer - grouping
 constexpr auto kMinimalAlertDelay = crl::time(500);
 constexpr auto kWaitingForAllGroupedDelay = crl::time(1000);
+constexpr auto kNativeMinimalDelay = crl::time(100);
+constexpr auto kNativeMaximalDelay = crl::time(2000);
+
+// Wait this much longer than the last native call took.
+constexpr auto kNativeDelayMultiplier = 4;
 
 } // namespace
 
@@ -511,6 +516,11 @@ void Manager::notificationReplied(
 	Auth().api().sendMessage(std::move(message));
 }
 
+NativeManager::NativeManager(System *system)
+: Manager(system)
+, _queuedTimer([=] { showNextQueued(); }) {
+}
+
 void NativeManager::doShowNotification(HistoryItem *item, int forwardedCount) {
 	const auto options = getNotificationOptions(item);
 
@@ -522,14 +532,77 @@ void NativeManager::doShowNotification(HistoryItem *item, int forwardedCount) {
 			? (item->groupId() ? lang(lng_in_dlg_album) : item->notificationText())
 			: lng_forward_messages(lt_count, forwardedCount));
 
-	doShowNativeNotification(
-		item->history()->peer,
+	auto queued = Queued{
+		item->history(),
 		item->id,
 		title,
 		subtitle,
 		text,
 		options.hideNameAndPhoto,
-		options.hideReplyButton);
+		options.hideReplyButton
+	};
+	const auto i = ranges::find(_queued, queued.history, &Queued::history);
+	if (i != end(_queued)) {
+		*i = std::move(queued);
+	} else {
+		_queued.push_back(std::move(queued));
+	}
+	showNextQueued();
+}
+
+void NativeManager::showNextQueued() {
+	if (_queued.empty()) {
+		return;
+	}
+	const auto now = crl::now();
+	const auto wait = _lastShown + _delay - now;
+	if (_lastShown && wait > 0) {
+		if (!_queuedTimer.isActive()) {
+			_queuedTimer.callOnce(wait);
+		}
+		return;
+	}
+	const auto queued = std::move(_queued.front());
+	_queued.pop_front();
+
+	doShowNativeNotification(
+		queued.history->peer,
+		queued.msgId,
+		queued.title,
+		queued.subtitle,
+		queued.msg,
+		queued.hideNameAndPhoto,
+		queued.hideReplyButton);
+
+	// Slow daemons get the notifications less often.
+	_lastShown = crl::now();
+	_delay = snap(
+		(_lastShown - now) * kNativeDelayMultiplier,
+		kNativeMinimalDelay,
+		kNativeMaximalDelay);
+	if (!_queued.empty()) {
+		_queuedTimer.callOnce(_delay);
+	}
+}
+
+void NativeManager::doClearAllFast() {
+	_queued.clear();
+	_queuedTimer.cancel();
+	doClearAllNative();
+}
+
+void NativeManager::doClearFromItem(HistoryItem *item) {
+	_queued.erase(ranges::remove_if(_queued, [&](const Queued &queued) {
+		return (queued.history == item->history())
+			&& (queued.msgId == item->id);
+	}), end(_queued));
+}
+
+void NativeManager::doClearFromHistory(History *history) {
+	_queued.erase(
+		ranges::remove(_queued, history, &Queued::history),
+		end(_queued));
+	doClearFromHistoryNative(history);
 }
 
 System::~System() = default;
@@ -178,9 +178,12 @@ private:
 
 };
 
+// Native notifications are delivered from a queue, so a slow
+// notification daemon blocking the calls can't freeze the interface
+// with a burst of them. Queued ones are merged per chat.
 class NativeManager : public Manager {
 protected:
-	using Manager::Manager;
+	NativeManager(System *system);
 
 	void doUpdateAll() override {
 		doClearAllFast();
@@ -188,11 +191,32 @@ protected:
 	void doClearAll() override {
 		doClearAllFast();
 	}
-	void doClearFromItem(HistoryItem *item) override {
-	}
+	void doClearAllFast() override final;
+	void doClearFromItem(HistoryItem *item) override final;
+	void doClearFromHistory(History *history) override final;
 	void doShowNotification(HistoryItem *item, int forwardedCount) override;
 
 	virtual void doShowNativeNotification(PeerData *peer, MsgId msgId, const QString &title, const QString &subtitle, const QString &msg, bool hideNameAndPhoto, bool hideReplyButton) = 0;
+	virtual void doClearAllNative() = 0;
+	virtual void doClearFromHistoryNative(History *history) = 0;
+
+private:
+	struct Queued {
+		not_null<History*> history;
+		MsgId msgId = 0;
+		QString title;
+		QString subtitle;
+		QString msg;
+		bool hideNameAndPhoto = false;
+		bool hideReplyButton = false;
+	};
+
+	void showNextQueued();
+
+	std::deque<Queued> _queued;
+	base::Timer _queuedTimer;
+	crl::time _lastShown = 0;
+	crl::time _delay = 0;
 
 };
 
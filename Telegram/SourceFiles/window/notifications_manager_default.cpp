@@ -27,6 +27,11 @@ namespace Notifications {
 namespace Default {
 namespace {
 
+// New notifications wait a bit to be merged with the others from the
+// same chat, so a burst after reconnecting doesn't open a widget for
+// every message.
+constexpr auto kMergeQueuedTimeout = crl::time(100);
+
 int notificationMaxHeight() {
 	return st::notifyMinHeight + st::notifyReplyArea.heightMax + st::notifyBorderWidth;
 }
@@ -53,7 +58,8 @@ std::unique_ptr<Manager> Create(System *system) {
 
 Manager::Manager(System *system)
 : Notifications::Manager(system)
-, _inputCheckTimer([=] { checkLastInput(); }) {
+, _inputCheckTimer([=] { checkLastInput(); })
+, _showQueuedTimer([=] { showNextFromQueue(); }) {
 	subscribe(system->authSession()->downloader().taskFinished(), [this] {
 		for_const (auto &notification, _notifications) {
 			notification->updatePeerPhoto();
@@ -288,8 +294,21 @@ void Manager::removeWidget(internal::Widget *remove) {
 }
 
 void Manager::doShowNotification(HistoryItem *item, int forwardedCount) {
-	_queuedNotifications.push_back(QueuedNotification(item, forwardedCount));
-	showNextFromQueue();
+	auto queued = QueuedNotification(item, forwardedCount);
+
+	// Only the latest message of a chat is worth a separate widget.
+	const auto i = ranges::find(
+		_queuedNotifications,
+		queued.history,
+		&QueuedNotification::history);
+	if (i != end(_queuedNotifications)) {
+		*i = std::move(queued);
+	} else {
+		_queuedNotifications.push_back(std::move(queued));
+	}
+	if (!_showQueuedTimer.isActive()) {
+		_showQueuedTimer.callOnce(kMergeQueuedTimeout);
+	}
 }
 
 void Manager::doClearAll() {
@@ -301,6 +320,7 @@ void Manager::doClearAll() {
 }
 
 void Manager::doClearAllFast() {
+	_showQueuedTimer.cancel();
 	_queuedNotifications.clear();
 	base::take(_notifications);
 	base::take(_hideAll);
@@ -676,7 +696,6 @@ void Notification::updateNotifyDisplay() {
 		}
 
 		if (!options.hideMessageText) {
-			const HistoryItem *textCachedFor = 0;
 			Text itemTextCache(itemWidth);
 			QRect r(st::notifyPhotoPos.x() + st::notifyPhotoSize + st::notifyTextLeft, st::notifyItemTop + st::msgNameFont->height, itemWidth, 2 * st::dialogsTextFont->height);
 			if (_item) {
@@ -686,9 +705,7 @@ void Notification::updateNotifyDisplay() {
 					r,
 					active,
 					selected,
-					HistoryItem::DrawInDialog::Normal,
-					textCachedFor,
-					itemTextCache);
+					HistoryItem::DrawInDialog::Normal);
 			} else if (_forwardedCount > 1) {
 				p.setFont(st::dialogsTextFont);
 				if (_author) {
@@ -79,6 +79,7 @@ private:
 
 	bool _positionsOutdated = false;
 	base::Timer _inputCheckTimer;
+	base::Timer _showQueuedTimer;
 
 	struct QueuedNotification {
 		QueuedNotification(not_null<HistoryItem*> item, int forwardedCount);
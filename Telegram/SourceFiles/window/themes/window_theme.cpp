@@ -198,7 +198,10 @@ void applyBackground(QImage &&background, bool tiled, Instance *out) {
 	}
 }
 
-bool loadThemeFromCache(const QByteArray &content, const Cached &cache) {
+bool loadThemeFromCache(
+		const QByteArray &content,
+		const Cached &cache,
+		Instance *out = nullptr) {
 	if (cache.paletteChecksum != style::palette::Checksum()) {
 		return false;
 	}
@@ -218,12 +221,17 @@ bool loadThemeFromCache(const QByteArray &content, const Cached &cache) {
 		}
 	}
 
-	if (!style::main_palette::load(cache.colors)) {
+	if (out) {
+		if (!out->palette.load(cache.colors)) {
+			return false;
+		}
+		out->cached = cache;
+	} else if (!style::main_palette::load(cache.colors)) {
 		return false;
 	}
 	Background()->saveAdjustableColors();
 	if (!background.isNull()) {
-		applyBackground(std::move(background), cache.tiled, nullptr);
+		applyBackground(std::move(background), cache.tiled, out);
 	}
 
 	return true;
@@ -894,10 +902,18 @@ void ChatBackground::toggleNightMode(std::optional<QString> themePath) {
 		preview->pathRelative = std::move(read.pathRelative);
 		preview->content = std::move(read.content);
 		preview->instance.cached = std::move(read.cache);
-		const auto loaded = loadTheme(
+
+		// The saved cache has the parsed palette and the decoded
+		// background, so the theme archive is unpacked only if the
+		// cache is outdated.
+		const auto loaded = loadThemeFromCache(
 			preview->content,
 			preview->instance.cached,
-			&preview->instance);
+			&preview->instance)
+			|| loadTheme(
+				preview->content,
+				preview->instance.cached,
+				&preview->instance);
 		if (!loaded) {
 			return false;
 		}
@@ -120,7 +120,9 @@ void PasscodeLockWidget::paintContent(Painter &p) {
 }
 
 void PasscodeLockWidget::submit() {
-	if (_passcode->text().isEmpty()) {
+	if (_checking) {
+		return;
+	} else if (_passcode->text().isEmpty()) {
 		_passcode->showError();
 		return;
 	}
@@ -131,7 +133,16 @@ void PasscodeLockWidget::submit() {
 		return;
 	}
 
+	// The key derivation is slow on purpose, keep the window responsive.
 	const auto passcode = _passcode->text().toUtf8();
+	_checking = true;
+	Local::preparePasscodeKey(passcode, crl::guard(this, [=] {
+		_checking = false;
+		check(passcode);
+	}));
+}
+
+void PasscodeLockWidget::check(const QByteArray &passcode) {
 	const auto correct = App::main()
 		? Local::checkPasscode(passcode)
 		: (Local::readMap(passcode) != Local::ReadMapPassNeeded);
@@ -53,12 +53,14 @@
       '<(src_loc)/base/binary_guard.h',
       '<(src_loc)/base/build_config.h',
       '<(src_loc)/base/bytes.h',
+      '<(src_loc)/base/chunked_flat_map.h',
       '<(src_loc)/base/concurrent_timer.cpp',
       '<(src_loc)/base/concurrent_timer.h',
       '<(src_loc)/base/flags.h',
       '<(src_loc)/base/enum_mask.h',
       '<(src_loc)/base/flat_map.h',
       '<(src_loc)/base/flat_set.h',
+      '<(src_loc)/base/flat_search.h',
       '<(src_loc)/base/functors.h',
       '<(src_loc)/base/index_based_iterator.h',
 	  '<(src_loc)/base/last_used_cache.h',
@@ -66,6 +68,8 @@
       '<(src_loc)/base/observer.cpp',
       '<(src_loc)/base/observer.h',
       '<(src_loc)/base/ordered_set.h',
+      '<(src_loc)/base/openssl_aes.cpp',
+      '<(src_loc)/base/openssl_aes.h',
       '<(src_loc)/base/openssl_help.h',
       '<(src_loc)/base/optional.h',
       '<(src_loc)/base/overload.h',
@@ -76,6 +80,8 @@
       '<(src_loc)/base/qthelp_url.h',
       '<(src_loc)/base/runtime_composer.cpp',
       '<(src_loc)/base/runtime_composer.h',
+      '<(src_loc)/base/slab_allocator.cpp',
+      '<(src_loc)/base/slab_allocator.h',
       '<(src_loc)/base/timer.cpp',
       '<(src_loc)/base/timer.h',
       '<(src_loc)/base/type_traits.h',
@@ -87,6 +93,7 @@
       '<(src_loc)/base/virtual_method.h',
       '<(src_loc)/base/weak_ptr.h',
       '<(src_loc)/base/zlib_help.h',
+      '<(src_loc)/base/zlib_inflate.h',
     ],
     'conditions': [[ 'build_macold', {
       'xcode_settings': {
@@ -75,6 +75,10 @@
       '<(src_loc)/storage/cache/storage_cache_database.h',
       '<(src_loc)/storage/cache/storage_cache_database_object.cpp',
       '<(src_loc)/storage/cache/storage_cache_database_object.h',
+      '<(src_loc)/storage/cache/storage_cache_hot_tier.cpp',
+      '<(src_loc)/storage/cache/storage_cache_hot_tier.h',
+      '<(src_loc)/storage/cache/storage_cache_key_filter.cpp',
+      '<(src_loc)/storage/cache/storage_cache_key_filter.h',
       '<(src_loc)/storage/cache/storage_cache_types.cpp',
       '<(src_loc)/storage/cache/storage_cache_types.h',
     ],
@@ -56,6 +56,15 @@
       '<(src_loc)/base/algorithm.h',
       '<(src_loc)/base/algorithm_tests.cpp',
     ],
+  }, {
+    'target_name': 'tests_chunked_flat_map',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/chunked_flat_map.h',
+      '<(src_loc)/base/chunked_flat_map_tests.cpp',
+    ],
   }, {
     'target_name': 'tests_flags',
     'includes': [
@@ -73,6 +82,7 @@
     'sources': [
       '<(src_loc)/base/flat_map.h',
       '<(src_loc)/base/flat_map_tests.cpp',
+      '<(src_loc)/base/flat_search.h',
     ],
   }, {
     'target_name': 'tests_flat_set',
@@ -82,6 +92,29 @@
     'sources': [
       '<(src_loc)/base/flat_set.h',
       '<(src_loc)/base/flat_set_tests.cpp',
+      '<(src_loc)/base/flat_search.h',
+    ],
+  }, {
+    'target_name': 'tests_openssl_aes',
+    'includes': [
+      'common_test.gypi',
+      '../openssl.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/base/openssl_aes.cpp',
+      '<(src_loc)/base/openssl_aes.h',
+      '<(src_loc)/base/openssl_aes_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_request_buffers_pool',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/mtproto/request_buffers_pool.cpp',
+      '<(src_loc)/mtproto/request_buffers_pool.h',
+      '<(src_loc)/mtproto/request_buffers_pool_tests.cpp',
     ],
   }, {
     'target_name': 'tests_rpl',
@@ -121,6 +154,26 @@
       '<(src_loc)/rpl/variable.h',
       '<(src_loc)/rpl/variable_tests.cpp',
     ],
+  }, {
+    'target_name': 'tests_session_msg_ids',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/mtproto/session_msg_ids.h',
+      '<(src_loc)/mtproto/session_msg_ids_tests.cpp',
+    ],
+  }, {
+    'target_name': 'tests_slab_allocator',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/slab_allocator.cpp',
+      '<(src_loc)/base/slab_allocator.h',
+      '<(src_loc)/base/slab_allocator_tests.cpp',
+    ],
   }, {
     'target_name': 'tests_storage',
     'includes': [
@@ -142,5 +195,50 @@
         '<(src_loc)/platform/win/windows_dlls.h',
       ],
     }]],
+  }, {
+    'target_name': 'tests_weak_ptr',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/base/weak_ptr.h',
+      '<(src_loc)/base/weak_ptr_tests.cpp',
+    ],
+  }, {
+    # Not in tests_list.txt, run it with "[.benchmark]" by hand,
+    # "--json <path>" writes the results for comparing them between builds.
+    'target_name': 'benchmarks',
+    'includes': [
+      'common_test.gypi',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/base/flat_map_benchmarks.cpp',
+      '<(src_loc)/rpl/rpl_benchmarks.cpp',
+    ],
+  }, {
+    # Not in tests_list.txt, run it with "[.benchmark]~[large]" by hand,
+    # the "[large]" cases need up to 10 GB of free disk space.
+    'target_name': 'benchmarks_storage',
+    'includes': [
+      'common_test.gypi',
+      '../openssl.gypi',
+    ],
+    'dependencies': [
+      '../lib_storage.gyp:lib_storage',
+    ],
+    'sources': [
+      '<(src_loc)/base/benchmark.h',
+      '<(src_loc)/storage/cache/storage_cache_database_benchmarks.cpp',
+      '<(src_loc)/platform/win/windows_dlls.cpp',
+      '<(src_loc)/platform/win/windows_dlls.h',
+    ],
+    'conditions': [[ 'not build_win', {
+      'sources!': [
+        '<(src_loc)/platform/win/windows_dlls.cpp',
+        '<(src_loc)/platform/win/windows_dlls.h',
+      ],
+    }]],
   }],
 }